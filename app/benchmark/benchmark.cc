@@ -0,0 +1,212 @@
+// EPOS Kernel Latency Benchmark Program
+// All times are in TSC ticks (see TSC::frequency()) and are reported as min/avg/p99 over SAMPLES runs
+
+#include <architecture/tsc.h>
+#include <machine.h>
+#include <time.h>
+#include <synchronizer.h>
+#include <process.h>
+
+using namespace EPOS;
+
+typedef TSC::Time_Stamp Time_Stamp;
+
+const int SAMPLES = 256;
+const int CONTENDERS = 4;
+const int HEAP_BLOCK = 64;
+const int ALARM_PERIOD = 5000; // us
+
+OStream cout;
+
+Time_Stamp samples[SAMPLES];
+volatile bool done;
+
+Semaphore ping(0);
+Semaphore pong(0);
+Mutex mutex;
+Semaphore tick(0);
+
+
+void report(const char * name)
+{
+    // Insertion sort is fine for SAMPLES values and needs no extra memory
+    for(int i = 1; i < SAMPLES; i++) {
+        Time_Stamp s = samples[i];
+        int j;
+        for(j = i; (j > 0) && (samples[j - 1] > s); j--)
+            samples[j] = samples[j - 1];
+        samples[j] = s;
+    }
+
+    Time_Stamp sum = 0;
+    for(int i = 0; i < SAMPLES; i++)
+        sum += samples[i];
+
+    cout << name << ": min=" << samples[0] << ", avg=" << sum / SAMPLES << ", p99=" << samples[SAMPLES * 99 / 100] << endl;
+}
+
+
+// Thread::yield() round trip: two switches, to the other thread and back
+int yielder()
+{
+    while(!done)
+        Thread::yield();
+    return 0;
+}
+
+void bench_yield()
+{
+    done = false;
+    Thread * other = new Thread(&yielder);
+    for(int i = 0; i < SAMPLES; i++) {
+        Time_Stamp t0 = TSC::time_stamp();
+        Thread::yield();
+        samples[i] = TSC::time_stamp() - t0;
+    }
+    done = true;
+    other->join();
+    delete other;
+    report("Thread::yield (round trip)");
+}
+
+
+// Thread::pass() round trip: explicit handoff to a given thread and back
+Thread * passer_peer;
+
+int passer()
+{
+    while(!done)
+        passer_peer->pass();
+    return 0;
+}
+
+void bench_pass()
+{
+    done = false;
+    passer_peer = Thread::self();
+    Thread * other = new Thread(&passer);
+    for(int i = 0; i < SAMPLES; i++) {
+        Time_Stamp t0 = TSC::time_stamp();
+        other->pass();
+        samples[i] = TSC::time_stamp() - t0;
+    }
+    done = true;
+    other->pass();
+    other->join();
+    delete other;
+    report("Thread::pass (round trip)");
+}
+
+
+// Semaphore ping-pong: v() on one semaphore and p() on the other, so each sample is two blocking handoffs
+int ponger()
+{
+    for(int i = 0; i < SAMPLES; i++) {
+        ping.p();
+        pong.v();
+    }
+    return 0;
+}
+
+void bench_semaphore()
+{
+    Thread * other = new Thread(&ponger);
+    for(int i = 0; i < SAMPLES; i++) {
+        Time_Stamp t0 = TSC::time_stamp();
+        ping.v();
+        pong.p();
+        samples[i] = TSC::time_stamp() - t0;
+    }
+    other->join();
+    delete other;
+    report("Semaphore ping-pong");
+}
+
+
+// Mutex: uncontended lock/unlock pairs, then lock latency with CONTENDERS threads sharing the lock
+void bench_mutex_uncontended()
+{
+    for(int i = 0; i < SAMPLES; i++) {
+        Time_Stamp t0 = TSC::time_stamp();
+        mutex.lock();
+        mutex.unlock();
+        samples[i] = TSC::time_stamp() - t0;
+    }
+    report("Mutex lock/unlock (uncontended)");
+}
+
+int contender(int id)
+{
+    for(int i = id; i < SAMPLES; i += CONTENDERS) {
+        Time_Stamp t0 = TSC::time_stamp();
+        mutex.lock();
+        samples[i] = TSC::time_stamp() - t0;
+        Thread::yield(); // hold the lock across a switch, so the others contend
+        mutex.unlock();
+    }
+    return 0;
+}
+
+void bench_mutex_contended()
+{
+    Thread * threads[CONTENDERS];
+    for(int i = 0; i < CONTENDERS; i++)
+        threads[i] = new Thread(&contender, i);
+    for(int i = 0; i < CONTENDERS; i++) {
+        threads[i]->join();
+        delete threads[i];
+    }
+    report("Mutex lock (contended)");
+}
+
+
+// Alarm jitter: distance between consecutive releases of a periodic alarm and its nominal period
+void bench_alarm()
+{
+    Semaphore_Handler handler(&tick);
+    Alarm alarm(ALARM_PERIOD, &handler, SAMPLES + 1);
+    Time_Stamp period = Time_Stamp(ALARM_PERIOD) * TSC::frequency() / 1000000;
+
+    tick.p();
+    Time_Stamp last = TSC::time_stamp();
+    for(int i = 0; i < SAMPLES; i++) {
+        tick.p();
+        Time_Stamp now = TSC::time_stamp();
+        Time_Stamp delta = now - last;
+        samples[i] = (delta > period) ? delta - period : period - delta;
+        last = now;
+    }
+    report("Alarm jitter");
+}
+
+
+// Heap: one alloc/free pair of HEAP_BLOCK bytes
+void bench_heap()
+{
+    for(int i = 0; i < SAMPLES; i++) {
+        Time_Stamp t0 = TSC::time_stamp();
+        char * p = new char[HEAP_BLOCK];
+        delete p;
+        samples[i] = TSC::time_stamp() - t0;
+    }
+    report("Heap alloc/free");
+}
+
+
+int main()
+{
+    cout << "EPOS Kernel Latency Benchmark" << endl;
+    cout << "TSC frequency = " << TSC::frequency() << " Hz, " << SAMPLES << " samples per test" << endl;
+
+    bench_yield();
+    bench_pass();
+    bench_semaphore();
+    bench_mutex_uncontended();
+    bench_mutex_contended();
+    bench_alarm();
+    bench_heap();
+
+    cout << "The end!" << endl;
+
+    return 0;
+}
@@ -0,0 +1,292 @@
+#ifndef __traits_h
+#define __traits_h
+
+#include <system/config.h>
+
+__BEGIN_SYS
+
+// Build
+template<> struct Traits<Build>: public Traits_Tokens
+{
+    // Basic configuration
+    static const unsigned int MODE = LIBRARY;
+    static const unsigned int ARCHITECTURE = RV64;
+    static const unsigned int MACHINE = RISCV;
+    static const unsigned int MODEL = SiFive_U;
+    static const unsigned int CPUS = 1;
+    static const unsigned int NODES = 1; // (> 1 => NETWORKING)
+    static const unsigned int EXPECTED_SIMULATION_TIME = 60; // s (0 => not simulated)
+
+    // Default flags
+    static const bool enabled = true;
+    static const bool monitored = true;
+    static const bool debugged = true;
+    static const bool hysterically_debugged = false;
+    static const bool call_traced = false; // compile with -finstrument-functions when Traits<Call_Tracer>::enabled (see utility/call_tracer.h)
+    static const unsigned int STATIC_OBJECTS = 0; // objects of Thread and Slab_Allocated components taken from a static pool before any heap
+
+    // Default aspects
+    typedef ALIST<> ASPECTS;
+};
+
+
+// Utilities
+template<> struct Traits<Debug>: public Traits<Build>
+{
+    static const bool error   = true;
+    static const bool warning = true;
+    static const bool info    = false;
+    static const bool trace   = false;
+};
+
+template<> struct Traits<Log>: public Traits<Build>
+{
+    static const bool enabled = false;              // keep Log::log() records in per-CPU binary rings (decoded by tools/eposlog)
+    static const unsigned int RECORDS = 512;
+};
+
+template<> struct Traits<Call_Tracer>: public Traits<Build>
+{
+    static const bool enabled = false;              // time-stamp the entries and exits of the functions of components with call_traced
+    static const unsigned int RECORDS = 1024;       // per CPU
+    static const unsigned int FUNCTIONS = 128;      // summarized by dump()
+};
+
+template<> struct Traits<PCAP>: public Traits<Build>
+{
+    static const bool enabled = false;              // copy the frames NICs send and receive into an in-memory capture ring
+    static const unsigned int FRAMES = 64;
+    static const unsigned int SNAPLEN = 128;        // bytes kept of each frame
+    static const unsigned int LINK_TYPE = 1;        // PCAP::ETHERNET
+};
+
+template<> struct Traits<Lists>: public Traits<Build>
+{
+    static const bool debugged = hysterically_debugged;
+};
+
+template<> struct Traits<Spin>: public Traits<Build>
+{
+    static const bool debugged = hysterically_debugged;
+};
+
+template<> struct Traits<Heaps>: public Traits<Build>
+{
+    static const bool debugged = hysterically_debugged;
+};
+
+template<> struct Traits<Observers>: public Traits<Build>
+{
+    // Some observed objects are created before initializing the Display
+    // Enabling debug may cause trouble in some Machines
+    static const bool debugged = false;
+};
+
+
+// System Parts (mostly to fine control debugging)
+template<> struct Traits<Boot>: public Traits<Build>
+{
+};
+
+template<> struct Traits<Setup>: public Traits<Build>
+{
+};
+
+template<> struct Traits<Init>: public Traits<Build>
+{
+    static const bool profiled = false; // time-stamp each boot phase and print them at Init_End (see System_Info::Boot_Profile)
+};
+
+template<> struct Traits<Framework>: public Traits<Build>
+{
+};
+
+template<> struct Traits<Aspect>: public Traits<Build>
+{
+    static const bool debugged = hysterically_debugged;
+};
+
+
+__END_SYS
+
+// Mediators
+#include __ARCHITECTURE_TRAITS_H
+#include __MACHINE_TRAITS_H
+
+__BEGIN_SYS
+
+
+// API Components
+template<> struct Traits<Application>: public Traits<Build>
+{
+    static const unsigned int STACK_SIZE = Traits<Machine>::STACK_SIZE;
+    static const unsigned int HEAP_SIZE = Traits<Machine>::HEAP_SIZE;
+    static const unsigned int MAX_THREADS = Traits<Machine>::MAX_THREADS;
+    static const unsigned int STACK_POOL = 0; // stacks of STACK_SIZE pre-allocated for Thread (see Traits<Thread>::pooled)
+};
+
+template<> struct Traits<System>: public Traits<Build>
+{
+    static const unsigned int mode = Traits<Build>::MODE;
+    static const bool multitask = (mode == Traits<Build>::KERNEL); // Tasks of their own Address_Space (see Task)
+    static const bool multithread = (Traits<Application>::MAX_THREADS > 1);
+    static const bool multicore = (Traits<Build>::CPUS > 1) && multithread;
+    static const bool multiheap = Traits<Scratchpad>::enabled;
+    static const bool tlsf = false; // O(1) two-level segregated fit heap allocator instead of a first-fit free list
+    static const bool magazines = false; // per-CPU caches of small blocks in front of each heap
+    static const unsigned int MAGAZINE_SIZE = 16;
+    static const bool slabs = false; // allocate Thread, Alarm, Semaphore, Mutex and Segment objects from per-type slabs (see utility/slab.h)
+    static const bool heap_statistics = false; // keep allocation counters and a size histogram in each Heap (see Heap::statistics())
+    static const bool heap_traced = false; // record the size, address and time stamp of each Heap alloc() and free() (see Heap_Trace)
+    static const unsigned int HEAP_TRACE_EVENTS = 1024;
+    static const bool heap_profiled = false; // tag the blocks of malloc() and new with their allocation sites (see Heap_Profiler)
+    static const unsigned int HEAP_SITES = 64;
+    static const unsigned int HEAP_SHRINKERS = 0; // callbacks that release cached memory when a Heap runs short (see Heap::shrinker())
+    static const unsigned long HEAP_LOW_WATERMARK = 0; // free bytes below which alloc() also calls them (0 = only on failure)
+    static const bool task_heaps = false; // malloc() and new in the threads of a Task with a heap of its own take from it (see Task::heap(), needs multiheap)
+
+    static const unsigned long LIFE_SPAN = 1 * YEAR; // s
+    static const unsigned int DUTY_CYCLE = 1000000; // ppm
+
+    static const bool reboot = true;
+
+    static const unsigned int STACK_SIZE = Traits<Machine>::STACK_SIZE;
+    static const unsigned int HEAP_SIZE = (Traits<Application>::MAX_THREADS + 1) * Traits<Application>::STACK_SIZE;
+};
+
+template<> struct Traits<Thread>: public Traits<Build>
+{
+    static const bool enabled = Traits<System>::multithread;
+    static const bool trace_idle = hysterically_debugged;
+    static const bool smp = Traits<System>::multicore;
+    static const bool simulate_capacity = false;
+    static const bool collecting = false;           // charge TSC time to threads at each dispatch (see Thread::statistics())
+    static const unsigned int QUANTUM = 10000; // us
+    static const bool adaptive_quantum = false;     // RR quanta grow for threads that use them up and shrink for threads that block (see RR::adapt())
+    static const bool banded_queue = false;         // O(1) bitmap-indexed ready queue (Priority and RR only)
+    static const bool heap_queues = false;          // wait queues (Semaphore, Mutex, ...) in pairing heaps, O(1) insertions and O(log n) amortized removals (see Heap_Queue)
+    static const unsigned int PRIORITY_BANDS = 32;  // MAIN, HIGH ... NORMAL, LOW and IDLE
+    static const bool pooled = false;               // recycle stacks and Thread objects instead of returning them to the heap
+    static const bool traced = false;               // record scheduling, alarm, interrupt and lock events on a per-CPU binary timeline (see utility/trace.h)
+    static const bool rcu = false;                  // report quiescent states for read-copy-update (see utility/rcu.h)
+    static const bool virtual_pmu = false;          // count the first PMU_CHANNELS PMU channels per thread at each dispatch (see Thread::statistics())
+    static const unsigned int PMU_CHANNELS = 4;
+    static const unsigned int TRACE_EVENTS = 256;
+    static const bool tls = false;                  // per-thread copies of thread_local variables (RISC-V and ARMv8, see CPU::tls())
+    static const bool profiled = false;             // sample the PC and thread interrupted by each alarm tick (see utility/profiler.h)
+    static const unsigned int PROFILE_BINS = 512;
+    static const bool sampled = false;              // record the PC and thread interrupted by PMU overflows (see PMU::sample() and utility/sampler.h)
+    static const unsigned int SAMPLES = 256;
+    static const bool measured = false;             // timer-IRQ and wakeup-to-run latency histograms (see utility/latency.h)
+    static const unsigned int LATENCY_BUCKETS = 32;
+    static const bool stack_watermark = false;      // paint stacks to measure how deep each thread gets (see Thread::stack_peak())
+    static const bool batching = false;             // Batch calls get a single reschedule at submit() (see ipc.h)
+    static const bool balanced = false;             // CPU_Affinity: periodically move threads from the busiest to the idlest CPU by decayed load
+    static const unsigned int BALANCE_PERIOD = 100000; // us, also the half-life of thread loads
+    static const unsigned int MIGRATION_COST = 500; // us, charged against moving a thread that ran up to that long ago (cache-hot)
+    static const bool wake_affine = false;          // CPU_Affinity: wake threads up on the waker's CPU if theirs is busy and both share a cache
+
+    typedef RR Criterion;
+    typedef Spin Kernel_Lock; // SMP kernel lock: Spin, or the FIFO Ticket_Spin or MCS_Spin for many cores (see utility/spin.h)
+};
+
+template<> struct Traits<Thread_Pool>: public Traits<Build>
+{
+    static const unsigned int WORKERS = Traits<Build>::CPUS;
+    static const unsigned int JOBS = 16; // bounded job queue, submit() blocks when it is full
+};
+
+template<> struct Traits<Monitor>: public Traits<Build>
+{
+    static const bool enabled = false;              // capture system metrics and PMU events on every CPU at FREQUENCY (see monitor.h)
+    static const unsigned int FREQUENCY = 10;       // Hz
+    static const unsigned int SAMPLES = 256;        // captures kept per CPU
+    static const bool temperature = false;          // capture the CPU temperature (where there is a sensor, see Machine::temperature())
+    static const unsigned int PMU_CHANNELS = 2;     // up to 4, counting the events below
+    static const unsigned int PMU_EVENT0 = L1_DATA_CACHE_MISSES;
+    static const unsigned int PMU_EVENT1 = BRANCH_MISPREDICTIONS;
+    static const unsigned int PMU_EVENT2 = LAST_LEVEL_CACHE_MISSES;
+    static const unsigned int PMU_EVENT3 = INSTRUCTIONS_RETIRED;
+};
+
+template<> struct Traits<Governor>: public Traits<Build>
+{
+    static const bool enabled = false;              // scale CPU::clock() with the load of the busiest CPU (see governor.h)
+    static const unsigned int PERIOD = 100000;      // us between decisions
+    static const unsigned int UP = 80;              // % of utilization above which the clock goes straight to CPU::max_clock()
+    static const unsigned int TARGET = 60;          // % of utilization the clock is scaled for below UP
+};
+
+template<> struct Traits<Energy_Meter>: public Traits<Build>
+{
+    static const bool enabled = false;              // charge each thread and idle sleep state the energy of a power model (see energy.h)
+    static const unsigned int STATIC = 0;           // uW drawn by each running CPU at any clock
+    static const unsigned int DYNAMIC = 0;          // uW added by each running CPU at CPU::max_clock(), scaled with the clock
+    static const unsigned int PERIPHERALS = 0;
+    static constexpr unsigned int sleep(unsigned int state) { return 0; }      // uW drawn by a CPU sleeping in "state"
+    static constexpr unsigned int peripheral(unsigned int p) { return 0; }     // uW drawn by peripheral "p" while on
+};
+
+template<> struct Traits<Scheduler<Thread>>: public Traits<Build>
+{
+    static const bool debugged = Traits<Thread>::trace_idle || hysterically_debugged;
+};
+
+template<> struct Traits<Synchronizer>: public Traits<Build>
+{
+    static const bool enabled = Traits<System>::multithread;
+    static const bool handoff = false; // switch to the thread a lock is handed to only if it has higher priority
+    static const bool adaptive = false; // on SMP, Mutexes spin while their owner runs on another CPU, before sleeping
+    static const unsigned int SPINS = 1000; // bound on the spinning of adaptive Mutexes (see Mutex::spin())
+    static const bool profiled = false; // per-lock contention statistics, with a registry of the hottest locks (see utility/contention.h)
+    static const unsigned int HOT_SPOTS = 8;
+};
+
+template<> struct Traits<Alarm>: public Traits<Build>
+{
+    static const bool visible = hysterically_debugged;
+    static const bool tickless = false; // program the timer to the next alarm deadline while idle instead of ticking periodically
+    static const bool wheel = false; // keep alarms in a hashed timing wheel (O(1) arm and cancel) instead of a relative queue
+    static const unsigned int WHEEL_SLOTS = 64;
+    static const bool one_shot = false; // interrupt at the exact deadline of the next alarm instead of rounding alarms to ticks (where the timer supports it, excludes wheel and tickless)
+    static const bool per_cpu = false; // on multicore, a queue of alarms for each CPU, armed on the one that creates them and served by its own ticks (excludes one_shot)
+};
+
+template<> struct Traits<Task>: public Traits<Build> {};
+
+template<> struct Traits<Address_Space>: public Traits<Build> {};
+
+template<> struct Traits<Segment>: public Traits<Build> {};
+
+template<> struct Traits<Network>: public Traits<Build>
+{
+    static const bool enabled = (Traits<Build>::NODES > 1);
+};
+
+template<> struct Traits<IP>: public Traits<Network>
+{
+    static const unsigned int CONFIG = STATIC; // the only strategy implemented so far
+    static const unsigned long ADDRESS = 0x0a00020f; // 10.0.2.15 (QEMU user networking)
+    static const unsigned long NETMASK = 0xffffff00; // 255.255.255.0
+    static const unsigned long GATEWAY = 0x0a000202; // 10.0.2.2
+    static const unsigned int TTL = 64;
+
+    static const unsigned int ARP_ENTRIES = 8;
+    static const unsigned int ARP_RETRIES = 3;
+    static const unsigned int ARP_TIMEOUT = 100000; // us
+};
+
+template<> struct Traits<UDP>: public Traits<Network>
+{
+    static const unsigned int QUEUE_SIZE = 16; // datagrams each socket holds until they are received (a power of two)
+    static const bool checksummed = true; // compute and check checksums, unless the NIC offloads them
+};
+
+template<> struct Traits<SmartData>: public Traits<Build>
+{
+    static const unsigned char PREDICTOR = NONE; // model that suppresses transmissions while it predicts the samples (NONE or LVP)
+};
+
+__END_SYS
+
+#endif
@@ -0,0 +1,67 @@
+// EPOS Inheritance_Mutex Test Program
+
+#include <time.h>
+#include <synchronizer.h>
+#include <process.h>
+
+using namespace EPOS;
+
+OStream cout;
+
+Inheritance_Mutex mutex;
+
+bool failed = false;
+
+// Whatever was lent to the running thread while it held the mutex must be gone once it unlocks it
+void check(const char * name, int base)
+{
+    int priority = int(Thread::self()->priority());
+    cout << name << ": priority after unlock() = " << priority << " (created with " << base << ")" << endl;
+    if(priority != base)
+        failed = true;
+}
+
+int holder()
+{
+    mutex.lock();
+    Delay queueing(100000); // the contenders queue up behind us meanwhile
+
+    // The mutex goes to the first contender, which doesn't run before we lock it again and lend it our priority
+    mutex.unlock();
+    mutex.lock();
+    mutex.unlock();
+    check("high", Thread::HIGH);
+
+    return 0;
+}
+
+int contender(const char * name, int base)
+{
+    mutex.lock();
+    mutex.unlock();
+    check(name, base);
+
+    return 0;
+}
+
+int main()
+{
+    cout << "Inheritance_Mutex Test" << endl;
+
+    // MAIN outranks them all, so they only start once it joins
+    Thread * high = new Thread(Thread::Configuration(Thread::READY, Thread::HIGH), &holder);
+    Thread * normal = new Thread(Thread::Configuration(Thread::READY, Thread::NORMAL), &contender, "normal", int(Thread::NORMAL));
+    Thread * low = new Thread(Thread::Configuration(Thread::READY, Thread::LOW), &contender, "low", int(Thread::LOW));
+
+    high->join();
+    normal->join();
+    low->join();
+
+    delete high;
+    delete normal;
+    delete low;
+
+    cout << (failed ? "Failed!" : "Passed!") << endl;
+
+    return 0;
+}
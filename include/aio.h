@@ -0,0 +1,161 @@
+// EPOS Asynchronous I/O Declarations
+
+#ifndef __aio_h
+#define __aio_h
+
+#include <utility/list.h>
+#include <utility/observer.h>
+#include <process.h>
+#include <synchronizer.h>
+
+__BEGIN_SYS
+
+class AIO_Device;
+class AIO_Queue;
+
+// Completion-based asynchronous I/O shared by drivers
+// A thread fills in AIO_Requests and submit()s them to AIO_Devices, each with the AIO_Queue its completion is to be
+// posted to, and goes on with other work while they are in flight. Devices run their requests one at a time, in
+// submission order: start() begins a transfer (e.g. arms a DMA channel or enables the device's interrupts) and the
+// driver calls complete() when it is over, usually from its interrupt handler, which posts the request to its queue
+// and starts the next one. Queues count completions with a Semaphore, so threads can wait() for them (or poll()) in
+// batches, and they are Observed, so Observers learn of each completion as it happens (in the context of complete()).
+// Drivers that only have blocking calls can be put behind an AIO_Worker.
+class AIO_Request
+{
+    friend class AIO_Device;
+    friend class AIO_Queue;
+
+public:
+    enum Status {
+        IDLE,
+        QUEUED,
+        RUNNING,
+        DONE,
+        FAILED,
+        CANCELED
+    };
+
+    typedef Simple_List<AIO_Request> List;
+    typedef List::Element Element;
+
+public:
+    // What "operation" means (e.g. read or write) is up to the device; "cookie" is for the submitter
+    AIO_Request(int operation = 0, void * buffer = 0, unsigned int size = 0, void * cookie = 0)
+    : _operation(operation), _buffer(buffer), _size(size), _cookie(cookie), _status(IDLE), _result(0), _device(0),
+      _queue(0), _link(this) {}
+
+    int operation() const { return _operation; }
+    void * buffer() const { return _buffer; }
+    unsigned int size() const { return _size; }
+    void * cookie() const { return _cookie; }
+
+    // A request must not be touched (nor submitted again) while it is in flight
+    Status status() const { return _status; }
+    bool done() const { return _status > RUNNING; }
+
+    // Given by the driver on completion (usually the number of bytes transferred, negative on errors)
+    int result() const { return _result; }
+
+private:
+    int _operation;
+    void * _buffer;
+    unsigned int _size;
+    void * _cookie;
+    volatile Status _status;
+    int _result;
+    AIO_Device * _device;
+    AIO_Queue * _queue;
+    Element _link;
+};
+
+
+class AIO_Queue: public Observed
+{
+    friend class AIO_Device;
+
+public:
+    AIO_Queue(): _completions(0), _in_flight(0) {}
+    ~AIO_Queue() {}
+
+    // Up to "max" completed requests, waiting for at least "min" of them, each for up to "timeout" (0 is forever)
+    unsigned int wait(AIO_Request ** requests, unsigned int max, unsigned int min = 1, const Microsecond & timeout = 0);
+
+    // The completed requests there already, up to "max", with no waiting
+    unsigned int poll(AIO_Request ** requests, unsigned int max);
+
+    // Submitted to devices with this queue and not completed yet
+    unsigned int in_flight() const { return _in_flight; }
+
+private:
+    void submitted() { _in_flight++; }
+    void post(AIO_Request * r);
+    AIO_Request * reap();
+
+private:
+    AIO_Request::List _completed;
+    Semaphore _completions;
+    volatile unsigned int _in_flight;
+};
+
+
+// Drivers derive from it and implement start(), and abort() if their transfers can be stopped midway
+class AIO_Device
+{
+public:
+    AIO_Device(): _current(0) {}
+    virtual ~AIO_Device() {}
+
+    void submit(AIO_Request * r, AIO_Queue * q);
+
+    // Queued requests are always canceled (and posted as CANCELED), the running one only if abort() says so
+    bool cancel(AIO_Request * r);
+
+    bool busy() const { return _current; }
+
+protected:
+    // Called with interrupts disabled, so they must not block
+    virtual void start(AIO_Request * r) = 0;
+    virtual bool abort(AIO_Request * r) { return false; }
+
+    // For the running request, from the driver's interrupt handler or from a thread
+    void complete(AIO_Request * r, int result);
+
+    AIO_Request * current() const { return _current; }
+
+private:
+    void finish(AIO_Request * r, const AIO_Request::Status & status, int result);
+    void next();
+
+private:
+    AIO_Request::List _queued;
+    AIO_Request * volatile _current;
+};
+
+
+// An AIO_Device whose requests are serviced by a thread of its own, which can block in service() (e.g. in calls of a
+// driver with no interrupt-driven interface), so the thread that submits them does not
+class AIO_Worker: public AIO_Device
+{
+public:
+    AIO_Worker(int priority = Thread::HIGH, unsigned int stack_size = Traits<Application>::STACK_SIZE);
+    ~AIO_Worker();
+
+protected:
+    // Carries out the request and returns its result
+    virtual int service(AIO_Request * r) = 0;
+
+private:
+    void start(AIO_Request * r) { _pending.v(); }
+
+    static int loop(AIO_Worker * w);
+
+private:
+    volatile bool _finish;
+    Semaphore _pending;
+    Thread * _thread;
+};
+
+__END_SYS
+
+#endif
@@ -21,6 +21,15 @@ public:
     using CPU_Common::Reg;
     using CPU_Common::Log_Addr;
     using CPU_Common::Phy_Addr;
+    using CPU_Common::FPU_Context;
+    using CPU_Common::fpu_switch;
+    using CPU_Common::fpu_trap;
+    using CPU_Common::TLS_TCB;
+    using CPU_Common::tls;
+    using CPU_Common::int_pc;
+    using CPU_Common::cache_clean;
+    using CPU_Common::cache_invalidate;
+    using CPU_Common::cache_flush;
 
     class Context
     {
@@ -69,12 +78,23 @@ public:
     static Log_Addr sp() { Reg r; ASM("mov %0, sp" : "=r"(r) :); return r; }
     static void sp(Log_Addr sp) { ASM("mov sp, %0" : : "r"(Reg(sp))); ASM("isb"); }
 
+    // Calls "f(a)" with "sp" as the stack and comes back to the current one (e.g. per-CPU interrupt stacks)
+    static void stack_call(Reg sp, void (* f)(unsigned int), unsigned int a) {
+        ASM("   mov     r4, sp      \n"    // r4 is preserved by "f"
+            "   mov     sp, %0      \n"
+            "   mov     r0, %2      \n"
+            "   blx     %1          \n"
+            "   mov     sp, r4      \n" : : "r"(sp), "r"(f), "r"(a) : "r0", "r1", "r2", "r3", "r4", "r12", "lr", "memory", "cc");
+    }
+
     static Reg fr() { Reg r; ASM("mov %0, r0" : "=r"(r)); return r; }
     static void fr(Reg r) {  ASM("mov r0, %0" : : "r"(r) : "r0"); }
 
     static Log_Addr ra() { Reg r; ASM("mov %0, lr" : "=r"(r) :); return r; } // due to RISC pipelining, PC is read with a +8 (4 for thumb) offset
 
     static void halt() { ASM("wfi"); }
+    static void pause() { ASM("yield"); } // spin-wait hint, so the core can yield to its siblings
+    static void fence() { ASM("dmb" : : : "memory"); } // no memory access crosses it, on any core
 
     template<typename T>
     static T tsl(volatile T & lock) {
@@ -277,6 +297,7 @@ public:
 
     static unsigned int id() { return 0; }
     static unsigned int cores() { return 1; }
+    static void smp_barrier(unsigned int n = cores()) { CPU_Common::smp_barrier<&finc<int>>(n, id()); }
 
     static void fpu_save() {}           // no FPU in M3, implement for M4
     static void fpu_restore() {}        // no FPU in M3, implement for M4
@@ -393,6 +414,7 @@ public:
     // ACTLR bits
     enum {
         FW              = 1 << 0, // Cache and TLB maintenance brodcast enable
+        L2_PREFETCH     = 1 << 1, // Prefetch hints to the L2 cache controller enable (Cortex-A9)
         DCACHE_PREFETCH = 1 << 2, // D-Cache prefetch enable
         SMP             = 1 << 6, // Core is taking part in the SMP coherence protocol
         PARITY          = 1 << 9  // Parity checking enable (if implemented)
@@ -454,9 +476,17 @@ public:
     static bool int_disabled() { return psr() & (FLAG_F | FLAG_I); }
 
     using ARMv7::halt;
-
-    static unsigned int id() { return 0; }
-    static unsigned int cores() { return 1; }
+    using ARMv7::pause;
+
+    static unsigned int id() {
+        if(Traits<Build>::CPUS == 1)
+            return 0;
+        Reg r;
+        ASM("mrc p15, 0, %0, c0, c0, 5" : "=r"(r)); // MPIDR, whose Aff0 is the core number within the cluster
+        return r & 0x3;
+    }
+    static unsigned int cores() { return Traits<Build>::CPUS; }
+    static void smp_barrier(unsigned int n = cores()) { CPU_Common::smp_barrier<&finc<int>>(n, id()); }
 
     static void fpu_enable() {
         // This code assumes a compilation with mfloat-abi=hard and does not care for context switches
@@ -533,6 +563,44 @@ public:
     static void flush_branch_predictors() { ASM("mcr p15, 0, %0, c7, c5, 6" : : "r" (0)); }
 
     static void flush_caches();
+
+    // Range operations run by MVA to the Point of Coherency, one cache line at a time. Lines only partially covered by an
+    // invalidation are flushed instead, so whatever shares them with the range isn't lost.
+    static void cache_clean(Log_Addr addr, unsigned int bytes) {
+        for(Reg a = Reg(addr) & ~(LINE - 1); a < Reg(addr) + bytes; a += LINE)
+            dccmvac(a);
+        dsb();
+    }
+
+    static void cache_invalidate(Log_Addr addr, unsigned int bytes) {
+        Reg begin = Reg(addr);
+        Reg end = begin + bytes;
+        if(begin & (LINE - 1)) {
+            begin &= ~(LINE - 1);
+            dccimvac(begin);
+            begin += LINE;
+        }
+        if(end & (LINE - 1)) {
+            end &= ~(LINE - 1);
+            dccimvac(end);
+        }
+        for(Reg a = begin; a < end; a += LINE)
+            dcimvac(a);
+        dsb();
+    }
+
+    static void cache_flush(Log_Addr addr, unsigned int bytes) {
+        for(Reg a = Reg(addr) & ~(LINE - 1); a < Reg(addr) + bytes; a += LINE)
+            dccimvac(a);
+        dsb();
+    }
+
+protected:
+    static const unsigned int LINE = Traits<CPU>::CACHE_LINE_SIZE;
+
+    static void dccmvac(Reg a) { ASM("mcr p15, 0, %0, c7, c10, 1" : : "r"(a) : "memory"); }  // clean
+    static void dcimvac(Reg a) { ASM("mcr p15, 0, %0, c7, c6, 1" : : "r"(a) : "memory"); }   // invalidate
+    static void dccimvac(Reg a) { ASM("mcr p15, 0, %0, c7, c14, 1" : : "r"(a) : "memory"); } // clean and invalidate
 };
 
 inline void ARMv7_A::Context::push(bool interrupt, bool stay_in_svc)
@@ -648,6 +716,7 @@ public:
     using Base::int_disabled;
 
     using Base::halt;
+    using Base::pause;
 
     using Base::fpu_save;
     using Base::fpu_restore;
@@ -149,6 +149,10 @@ public:
         db<PMU>(TRC) << "PMU::config(c=" << channel << ",e=" << event << ",f=" << flags << ")" << endl;
         pmselr(channel);
         pmxevtyper(_events[event]);
+        if(flags & INT)
+            pmintenset(1 << channel);
+        else
+            pmintenclr(1 << channel);
         start(channel);
     }
 
@@ -179,9 +183,16 @@ public:
         write(channel, 0);
     }
 
+    static void sample(Channel channel, Event event, Count period);
+
+    static bool overflow(Channel channel) { return pmovsr() & (1 << channel); }
+    static void clear_overflow(Channel channel) { pmovsr(1 << channel); } // write one to clear
+
     static void init();
 
 private:
+    static void int_handler(unsigned int i);
+
     static void pmcr(Reg32 reg) { ASM("mcr p15, 0, %0, c9, c12, 0\n\t" : : "r"(reg)); }
     static Reg32 pmcr() { Reg32 reg; ASM("mrc p15, 0, %0, c9, c12, 0\n\t" : "=r"(reg) : ); return reg; }
 
@@ -194,6 +205,11 @@ private:
     static void pmovsr(Reg32 reg) { ASM("mcr p15, 0, %0, c9, c12, 3\n\t" : : "r"(reg)); }
     static Reg32 pmovsr() { Reg32 reg; ASM("mrc p15, 0, %0, c9, c12, 3\n\t" : "=r"(reg) : ); return reg; }
 
+    static void pmintenset(Reg32 reg) { ASM("mcr p15, 0, %0, c9, c14, 1\n\t" : : "r"(reg)); }
+    static Reg32 pmintenset() { Reg32 reg; ASM("mrc p15, 0, %0, c9, c14, 1\n\t" : "=r"(reg) : ); return reg; }
+
+    static void pmintenclr(Reg32 reg) { ASM("mcr p15, 0, %0, c9, c14, 2\n\t" : : "r"(reg)); }
+
     static void pmselr(Reg32 reg) { ASM("mcr p15, 0, %0, c9, c12, 5\n\t" : : "r"(reg)); }
     static Reg32 pmselr() { Reg32 reg; ASM("mrc p15, 0, %0, c9, c12, 5\n\t" : "=r"(reg) : ); return reg; }
 
@@ -205,6 +221,7 @@ private:
 
 private:
     static const Event _events[EVENTS];
+    static Count _periods[CHANNELS];
 };
 
 
@@ -233,6 +250,9 @@ public:
     using Engine::start;
     using Engine::stop;
     using Engine::reset;
+    using Engine::sample;
+    using Engine::overflow;
+    using Engine::clear_overflow;
 
 private:
     static void init() { Engine::init(); }
@@ -17,6 +17,9 @@ class TSC: private TSC_Common
 {
     friend class CPU;
     friend class IC;
+#ifdef __emote3__
+    friend class eMote3;        // for warm boots
+#endif
 
 private:
     static const Hertz CLOCK = Traits<Build>::MODEL == Traits<Build>::Raspberry_Pi3 ? 1000000 
@@ -267,6 +267,16 @@ public:
 
     using ARMv7_A::sp;
 
+    // Calls "f(a)" with "sp" as the stack and comes back to the current one (e.g. per-CPU interrupt stacks)
+    static void stack_call(Reg sp, void (* f)(unsigned int), unsigned int a) {
+        ASM("   mov     x19, sp     \n"    // x19 is preserved by "f"
+            "   mov     sp, %0      \n"
+            "   mov     w0, %w2     \n"
+            "   blr     %1          \n"
+            "   mov     sp, x19     \n" : : "r"(sp), "r"(f), "r"(a) : "x0", "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9",
+                                           "x10", "x11", "x12", "x13", "x14", "x15", "x16", "x17", "x19", "x30", "memory", "cc");
+    }
+
     static Reg fp() { Reg r; ASM("mov %0, x29" : "=r"(r)); return r; }
     static void fp(Reg r) {  ASM("mov x29, %0" : : "r"(r) : "r0"); }
 
@@ -287,13 +297,25 @@ public:
     static bool int_disabled() { return cpsr() & (FLAG_F | FLAG_I); }
 
     using ARMv7_A::halt;
-
-    static unsigned int id() { return 0; }
-    static unsigned int cores() { return 1; }
+    using ARMv7_A::pause;
+    static void fence() { ASM("dmb ish" : : : "memory"); } // A64 barriers need a shareability domain
+
+    static unsigned int id() {
+        if(Traits<Build>::CPUS == 1)
+            return 0;
+        Reg r;
+        ASM("mrs %0, mpidr_el1" : "=r"(r)); // Aff0 is the core number within the cluster
+        return r & 0x3;
+    }
+    static unsigned int cores() { return Traits<Build>::CPUS; }
 
     static void fpu_save();
     static void fpu_restore();
 
+    // AArch64 TLS blocks start after a 16-byte TCB pointed to by TPIDR_EL0
+    static const unsigned int TLS_TCB = 16;
+    static void tls(Log_Addr block) { ASM("msr tpidr_el0, %0" : : "r"(Reg(block))); }
+
     // ARMv8 specifics
     static Reg  r0() { Reg r; ASM("mov %0, x0" :  "=r"(r) : : ); return r; }
     static void r0(Reg r) {   ASM("mov x0, %0" : : "r"(r): ); }
@@ -413,6 +435,36 @@ public:
     static void flush_branch_predictors();
 
     static void flush_caches();
+
+    // Same as ARMv7-A's, with the AArch64 DC instructions
+    static void cache_clean(Log_Addr addr, unsigned int bytes) {
+        for(Reg a = Reg(addr) & ~Reg(LINE - 1); a < Reg(addr) + bytes; a += LINE)
+            ASM("dc cvac, %0" : : "r"(a) : "memory");
+        ASM("dsb sy");
+    }
+
+    static void cache_invalidate(Log_Addr addr, unsigned int bytes) {
+        Reg begin = Reg(addr);
+        Reg end = begin + bytes;
+        if(begin & (LINE - 1)) {
+            begin &= ~Reg(LINE - 1);
+            ASM("dc civac, %0" : : "r"(begin) : "memory");
+            begin += LINE;
+        }
+        if(end & (LINE - 1)) {
+            end &= ~Reg(LINE - 1);
+            ASM("dc civac, %0" : : "r"(end) : "memory");
+        }
+        for(Reg a = begin; a < end; a += LINE)
+            ASM("dc ivac, %0" : : "r"(a) : "memory");
+        ASM("dsb sy");
+    }
+
+    static void cache_flush(Log_Addr addr, unsigned int bytes) {
+        for(Reg a = Reg(addr) & ~Reg(LINE - 1); a < Reg(addr) + bytes; a += LINE)
+            ASM("dc civac, %0" : : "r"(a) : "memory");
+        ASM("dsb sy");
+    }
 };
 
 
@@ -533,6 +585,7 @@ public:
     using Base::int_disabled;
 
     using Base::halt;
+    using Base::pause;
 
     using Base::fpu_save;
     using Base::fpu_restore;
@@ -540,45 +593,90 @@ public:
     using Base::id;
     using Base::cores;
 
+    // With a single core, disabling interrupts suffices to make these atomic. Otherwise, they use the exclusive
+    // monitor (load-acquire and store-release exclusive), which also orders the surrounding memory accesses.
     template<typename T>
     static T tsl(volatile T & lock) {
-        bool ie = int_enabled();
-        int_disable();
-        T old = CPU_Common::tsl(lock);
-        if(ie)
-            int_enable();
+        register T old;
+        if(Traits<Build>::CPUS == 1) {
+            bool ie = int_enabled();
+            int_disable();
+            old = CPU_Common::tsl(lock);
+            if(ie)
+                int_enable();
+        } else {
+            register Reg32 one = 1;
+            register Reg32 fail;
+            if(sizeof(T) == sizeof(Reg8))
+                ASM("1: ldaxrb  %w0, [%2]           \n"
+                    "   stlxrb  %w1, %w3, [%2]      \n"
+                    "   cbnz    %w1, 1b             \n" : "=&r"(old), "=&r"(fail) : "r"(&lock), "r"(one) : "memory");
+            else if(sizeof(T) == sizeof(Reg16))
+                ASM("1: ldaxrh  %w0, [%2]           \n"
+                    "   stlxrh  %w1, %w3, [%2]      \n"
+                    "   cbnz    %w1, 1b             \n" : "=&r"(old), "=&r"(fail) : "r"(&lock), "r"(one) : "memory");
+            else if(sizeof(T) == sizeof(Reg32))
+                ASM("1: ldaxr   %w0, [%2]           \n"
+                    "   stlxr   %w1, %w3, [%2]      \n"
+                    "   cbnz    %w1, 1b             \n" : "=&r"(old), "=&r"(fail) : "r"(&lock), "r"(one) : "memory");
+            else
+                ASM("1: ldaxr   %x0, [%2]           \n"
+                    "   stlxr   %w1, %x3, [%2]      \n"
+                    "   cbnz    %w1, 1b             \n" : "=&r"(old), "=&r"(fail) : "r"(&lock), "r"(Reg64(one)) : "memory");
+        }
         return old;
     }
 
     template<typename T>
-    static T finc(volatile T & value) {
-        bool ie = int_enabled();
-        int_disable();
-        T old = CPU_Common::finc(value);
-        if(ie)
-            int_enable();
-        return old;
-    }
+    static T finc(volatile T & value) { return fadd(value, 1); }
 
     template<typename T>
-    static T fdec(volatile T & value) {
-        bool ie = int_enabled();
-        int_disable();
-        T old = CPU_Common::fdec(value);
-        if(ie)
-            int_enable();
-        return old;
-    }
+    static T fdec(volatile T & value) { return fadd(value, -1); }
 
     template <typename T>
     static T cas(volatile T & value, T compare, T replacement) {
-        bool ie = int_enabled();
-        int_disable();
-        T old = CPU_Common::cas(value, compare, replacement);
-        if(ie)
-            int_enable();
+        register T old;
+        if(Traits<Build>::CPUS == 1) {
+            bool ie = int_enabled();
+            int_disable();
+            old = CPU_Common::cas(value, compare, replacement);
+            if(ie)
+                int_enable();
+        } else {
+            register Reg32 fail;
+            if(sizeof(T) == sizeof(Reg8))
+                ASM("1: ldaxrb  %w0, [%2]           \n"
+                    "   cmp     %w0, %w3, uxtb      \n"
+                    "   b.ne    2f                  \n"
+                    "   stlxrb  %w1, %w4, [%2]      \n"
+                    "   cbnz    %w1, 1b             \n"
+                    "2:                             \n" : "=&r"(old), "=&r"(fail) : "r"(&value), "r"(compare), "r"(replacement) : "cc", "memory");
+            else if(sizeof(T) == sizeof(Reg16))
+                ASM("1: ldaxrh  %w0, [%2]           \n"
+                    "   cmp     %w0, %w3, uxth      \n"
+                    "   b.ne    2f                  \n"
+                    "   stlxrh  %w1, %w4, [%2]      \n"
+                    "   cbnz    %w1, 1b             \n"
+                    "2:                             \n" : "=&r"(old), "=&r"(fail) : "r"(&value), "r"(compare), "r"(replacement) : "cc", "memory");
+            else if(sizeof(T) == sizeof(Reg32))
+                ASM("1: ldaxr   %w0, [%2]           \n"
+                    "   cmp     %w0, %w3            \n"
+                    "   b.ne    2f                  \n"
+                    "   stlxr   %w1, %w4, [%2]      \n"
+                    "   cbnz    %w1, 1b             \n"
+                    "2:                             \n" : "=&r"(old), "=&r"(fail) : "r"(&value), "r"(compare), "r"(replacement) : "cc", "memory");
+            else
+                ASM("1: ldaxr   %x0, [%2]           \n"
+                    "   cmp     %x0, %x3            \n"
+                    "   b.ne    2f                  \n"
+                    "   stlxr   %w1, %x4, [%2]      \n"
+                    "   cbnz    %w1, 1b             \n"
+                    "2:                             \n" : "=&r"(old), "=&r"(fail) : "r"(&value), "r"(compare), "r"(replacement) : "cc", "memory");
+        }
         return old;
     }
+
+    static void smp_barrier(unsigned int n = cores()) { CPU_Common::smp_barrier<&finc<int>>(n, id()); }
  
     static void switch_context(Context ** o, Context * n);
 
@@ -617,6 +715,43 @@ private:
     }
     static void init_stack_helper(Log_Addr sp) {}
 
+    template<typename T>
+    static T fadd(volatile T & value, int delta) {
+        register T old;
+        if(Traits<Build>::CPUS == 1) {
+            bool ie = int_enabled();
+            int_disable();
+            old = value;
+            value = old + delta;
+            if(ie)
+                int_enable();
+        } else {
+            register Reg64 tmp;
+            register Reg32 fail;
+            if(sizeof(T) == sizeof(Reg8))
+                ASM("1: ldaxrb  %w0, [%3]           \n"
+                    "   add     %w1, %w0, %w4       \n"
+                    "   stlxrb  %w2, %w1, [%3]      \n"
+                    "   cbnz    %w2, 1b             \n" : "=&r"(old), "=&r"(tmp), "=&r"(fail) : "r"(&value), "r"(delta) : "memory");
+            else if(sizeof(T) == sizeof(Reg16))
+                ASM("1: ldaxrh  %w0, [%3]           \n"
+                    "   add     %w1, %w0, %w4       \n"
+                    "   stlxrh  %w2, %w1, [%3]      \n"
+                    "   cbnz    %w2, 1b             \n" : "=&r"(old), "=&r"(tmp), "=&r"(fail) : "r"(&value), "r"(delta) : "memory");
+            else if(sizeof(T) == sizeof(Reg32))
+                ASM("1: ldaxr   %w0, [%3]           \n"
+                    "   add     %w1, %w0, %w4       \n"
+                    "   stlxr   %w2, %w1, [%3]      \n"
+                    "   cbnz    %w2, 1b             \n" : "=&r"(old), "=&r"(tmp), "=&r"(fail) : "r"(&value), "r"(delta) : "memory");
+            else
+                ASM("1: ldaxr   %x0, [%3]           \n"
+                    "   add     %x1, %x0, %x4       \n"
+                    "   stlxr   %w2, %x1, [%3]      \n"
+                    "   cbnz    %w2, 1b             \n" : "=&r"(old), "=&r"(tmp), "=&r"(fail) : "r"(&value), "r"(long(delta)) : "memory");
+        }
+        return old;
+    }
+
     static void context_load_helper();
 
     static void init();
@@ -12,13 +12,19 @@ __BEGIN_SYS
 
 class ARMv8_A_PMU;
 
-class PMU
+// No ARMv8 PMU mediator yet, so all channels read zero
+class PMU: public PMU_Common
 {
     friend class CPU;
 
 private:
     typedef ARMv8_A_PMU Engine;
 
+public:
+    using PMU_Common::CHANNELS;
+    using PMU_Common::FIXED;
+    using PMU_Common::EVENTS;
+
 public:
     PMU() {}
 
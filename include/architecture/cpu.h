@@ -101,6 +101,7 @@ public:
     static bool int_disabled();
 
     static void halt() { for(;;); }
+    static void pause() {} // hint for spin-wait loops
 
     static void switch_context(Context * volatile * o, Context * volatile n);
 
@@ -160,9 +161,29 @@ public:
     static void fpu_save();
     static void fpu_restore();
 
+    // Per-thread FPU state for architectures that switch it lazily (see rv64); empty and no-op otherwise
+    class FPU_Context {};
+    static void fpu_switch(FPU_Context * prev, FPU_Context * next) {}
+    static bool fpu_trap() { return false; }
+
+    // Thread-local storage: tls() points the ABI thread pointer at a thread's TLS block, whose variables
+    // start TLS_TCB bytes into it (see Traits<Thread>::tls); architectures without a thread pointer ignore it
+    static const unsigned int TLS_TCB = 0;
+    static void tls(Log_Addr block) {}
+
+    // The PC the current interrupt was taken at, from within its handler (see utility/profiler.h); 0 where it isn't kept at hand
+    static Log_Addr int_pc() { return 0; }
+
     static void flush_tlb();
     static void flush_tlb(Log_Addr addr);
 
+    // Data cache maintenance by address range, for DMA on machines whose devices don't snoop the caches (see
+    // MMU::DMA_Buffer): clean writes the dirty lines covering the range back to memory (before a device reads it),
+    // invalidate discards them (before the CPU reads what a device wrote) and flush does both. No-ops where DMA is coherent.
+    static void cache_clean(Log_Addr addr, unsigned int bytes) {}
+    static void cache_invalidate(Log_Addr addr, unsigned int bytes) {}
+    static void cache_flush(Log_Addr addr, unsigned int bytes) {}
+
     static Reg64 htole64(Reg64 v) { return (BIG_ENDIAN) ? swap64(v) : v; }
     static Reg32 htole32(Reg32 v) { return (BIG_ENDIAN) ? swap32(v) : v; }
     static Reg16 htole16(Reg16 v) { return (BIG_ENDIAN) ? swap16(v) : v; }
@@ -94,7 +94,9 @@ public:
 
     // CR4 Flags
     enum {
-        CR4_PSE     = 1 << 8    // CR4 Performance Counter Enable
+        CR4_PSE     = 1 << 4,   // Page Size Extensions (4 MB pages)
+        CR4_PGE     = 1 << 7,   // Page Global Enable (GLB entries survive CR3 reloads)
+        CR4_PCE     = 1 << 8    // Performance Counter Enable
     };
 
     // Segment Flags
@@ -154,6 +156,8 @@ public:
     // Useful MSRs
     enum {
         MSR_TSC                 = 0x0010,
+        IA32_TSC_DEADLINE       = 0x06e0,
+        IA32_PAT                = 0x0277,
         CLOCK_MODULATION        = 0x019a,
         THERM_STATUS            = 0x019c,
         TEMPERATURE_TARGET      = 0x01a2
@@ -340,11 +344,22 @@ public:
     static Log_Addr sp() { return esp(); }
     static void sp(Log_Addr sp) { esp(sp); }
 
+    // Calls "f(a)" with "sp" as the stack and comes back to the current one (e.g. per-CPU interrupt stacks)
+    static void stack_call(Reg sp, void (* f)(unsigned int), unsigned int a) {
+        ASM("       movl    %%esp, %%esi            \n"    // ESI is preserved by "f"
+            "       movl    %0, %%esp               \n"
+            "       subl    $12, %%esp              \n"    // keep the 16-byte alignment at the call
+            "       pushl   %2                      \n"
+            "       call    *%1                     \n"
+            "       movl    %%esi, %%esp            \n" : "+a"(sp), "+c"(f), "+d"(a) : : "esi", "memory", "cc");
+    }
+
     static Reg fr() { return eax(); }
     static void fr(Reg r) { eax(r); }
 
     static volatile unsigned int id() { return 0; }
     static unsigned int cores() { return 1; }
+    static void smp_barrier(unsigned int n = cores()) { CPU_Common::smp_barrier<&finc<int>>(n, id()); }
 
     static Hertz clock() { return _cpu_current_clock; }
     static void clock(Hertz frequency) {
@@ -375,9 +390,20 @@ public:
     static bool int_disabled() { return !int_enabled(); }
 
     static void halt() { ASM("hlt"); }
+    static void pause() { ASM("pause"); } // spin-wait hint, which also avoids the memory order violation on loop exit
+    static void fence() { ASM("lock; addl $0, (%%esp)" : : : "memory", "cc"); } // no memory access crosses it, on any core (mfence needs SSE2)
 
     static void fpu_save() {} // TODO
     static void fpu_restore() {} // TODO
+    using CPU_Common::FPU_Context;
+    using CPU_Common::fpu_switch;
+    using CPU_Common::fpu_trap;
+    using CPU_Common::TLS_TCB;
+    using CPU_Common::tls;
+    using CPU_Common::int_pc;
+    using CPU_Common::cache_clean;      // DMA is coherent
+    using CPU_Common::cache_invalidate;
+    using CPU_Common::cache_flush;
 
     static void switch_context(Context * volatile * o, Context * volatile n);
 
@@ -415,6 +441,15 @@ public:
     static void flush_tlb() { ASM("movl %cr3, %eax"); ASM("movl %eax, %cr3"); }
     static void flush_tlb(Reg32 r) { ASM("invlpg %0" : : "m"(r)); }
 
+    // Memory types of PAT0-7 (WB, WT, WC, UC, WB, WT, UC-, UC): the power-on ones, but for PAT2 (PCD without PAT nor PWT),
+    // which is WC instead of UC- (see MMU::Page_Flags::WC)
+    static const Reg64 PAT_TYPES = 0x0007040600010406ULL;
+    static bool pat() {
+        Reg32 a = 1, b, c = 0, d;
+        cpuid(1, &a, &b, &c, &d);
+        return d & (1 << 16);
+    }
+
     static Reg64 htole64(Reg64 v) { return v; }
     static Reg32 htole32(Reg32 v) { return v; }
     static Reg16 htole16(Reg16 v) { return v; }
@@ -5,6 +5,7 @@
 
 #include <architecture/mmu.h>
 #include <system/memory_map.h>
+#include <utility/buddy.h>
 
 __BEGIN_SYS
 
@@ -18,13 +19,30 @@ private:
 
     static const bool colorful = Traits<MMU>::colorful;
     static const unsigned int COLORS = Traits<MMU>::COLORS;
+    static const bool buddy = Traits<MMU>::buddy;
+    static const bool large_pages = Traits<MMU>::large_pages;
+    static const bool global_pages = Traits<MMU>::global_pages;
+    static const bool cow = Traits<MMU>::cow;
+    static const unsigned int ZEROED = Traits<MMU>::ZEROED_FRAMES;
+    static const bool multicore = Traits<System>::multicore;
     static const unsigned int RAM_BASE  = Memory_Map::RAM_BASE;
+    static const unsigned int RAM_TOP   = Memory_Map::RAM_TOP;
     static const unsigned int APP_LOW   = Memory_Map::APP_LOW;
     static const unsigned int APP_HIGH  = Memory_Map::APP_HIGH;
     static const unsigned int PHY_MEM   = Memory_Map::PHY_MEM;
     static const unsigned int SYS       = Memory_Map::SYS;
     static const unsigned int SYS_HIGH  = Memory_Map::SYS_HIGH;
 
+    static const unsigned int LARGE_PAGE = PT_ENTRIES * sizeof(Page); // 4 MB, mapped by a single PDE with PS set
+
+    static const unsigned int FRAMES = ((RAM_TOP - RAM_BASE) >> PAGE_SHIFT) + 1;
+
+    typedef Buddy<buddy ? FRAMES : 1, PAGE_SIZE, colorful * COLORS + 1> Frame_Allocator; // frames are numbered from RAM_BASE
+
+    // Copy-on-write sharing (see Chunk(const Chunk &)): how many other mappings each frame has and whether it was writable
+    static const unsigned char SHARERS = 0x7f;
+    static const unsigned char WRITABLE = 0x80;
+
 public:
     // Page Flags
     class Page_Flags
@@ -43,27 +61,31 @@ public:
             EX   = 1 <<  9, // User Def. (0=non-executable, 1=executable)
             CT   = 1 << 10, // User Def. (0=non-contiguous, 1=contiguous)
             IO   = 1 << 11, // User Def. (0=memory, 1=I/O)
+            // Memory types, as CPU::init() sets the PAT (PCD alone selects PAT2, which is UC- without a PAT)
+            UC   = (PCD | PWT), // Uncached
+            WC   = PCD,         // Write-combining
             APP  = (PRE | RW  | ACC | USR),
             APPC = (PRE | EX  | ACC | USR),
             APPD = (PRE | RW  | ACC | USR),
             SYS  = (PRE | RW  | ACC),
-            PCI  = (SYS | PCD | IO),
-            APIC = (SYS | PCD),
-            VGA  = (SYS | PCD),
-            DMA  = (SYS | PCD | CT),
+            PCI  = (SYS | UC | IO),
+            APIC = (SYS | UC),
+            VGA  = (SYS | UC),
+            DMA  = (SYS | UC | CT),
             MASK = (1 << 12) - 1
         };
 
     public:
         Page_Flags() {}
         Page_Flags(unsigned long f) : _flags(f) {}
-        Page_Flags(Flags f) : _flags(PRE | ACC |
+        // Lazy chunks get their flags without PRE (see Page_Table::reserve())
+        // WC prevails over the other memory types, so I/O regions (e.g. NIC descriptor rings) can be write-combining too
+        Page_Flags(Flags f) : _flags((((f & Flags::LZ) && !(f & Flags::CT)) ? 0 : PRE) | ACC |
                                     ((f & Flags::RW)  ? RW  : 0) |
                                     ((f & Flags::USR) ? USR : 0) |
-                                    ((f & Flags::CWT) ? PWT : 0) |
-                                    ((f & Flags::CD)  ? PCD : 0) |
+                                    ((f & Flags::WC)  ? WC  : ((f & Flags::CD) ? UC : (f & Flags::CWT) ? PWT : 0)) |
                                     ((f & Flags::CT)  ? CT  : 0) |
-                                    ((f & Flags::IO)  ? PCI : 0) ) {}
+                                    ((f & Flags::IO)  ? (SYS | IO | ((f & Flags::WC) ? WC : UC)) : 0) ) {}
 
         operator unsigned long() const { return _flags; }
 
@@ -106,6 +128,14 @@ public:
             }
         }
 
+        // Lazy pages hold only their flags, without PRE, until MMU::fault() gives them a frame
+        void reserve(int from, int to, Page_Flags flags) {
+            for( ; from < to; from++) {
+                Log_Addr * pte = phy2log(&_entry[from]);
+                *pte = flags & ~Page_Flags::PRE;
+            }
+        }
+
         void unmap(int from, int to) {
             for( ; from < to; from++) {
                 free(_entry[from]);
@@ -131,34 +161,91 @@ public:
     typedef Page_Table Page_Directory;
 
     // Chunk (for Segment)
+    // Contiguous chunks whose size is a multiple of LARGE_PAGE (and, for I/O, whose address is aligned to it) are mapped
+    // with large pages if Traits<MMU>::large_pages is set. They have no page tables: _flags has PS set, _pt holds the
+    // address of the first frame and _pts counts the PDEs that map them.
     class Chunk
     {
     public:
         Chunk() {}
 
         Chunk(unsigned int bytes, Flags flags, Color color = WHITE)
-        : _from(0), _to(pages(bytes)), _pts(page_tables(_to - _from)), _flags(Page_Flags(flags)), _pt(calloc(_pts, WHITE)) {
+        : _from(0), _to(pages(bytes)), _pts(page_tables(_to - _from)), _flags(Page_Flags(flags)), _pt(0) {
+            if(large(bytes, _flags) && (_pt = alloc_aligned(_to, PT_ENTRIES, color))) {
+                _flags = _flags | Page_Flags::PS;
+                return;
+            }
+            _pt = calloc(_pts, WHITE);
             if(_flags & Page_Flags::CT)
                 _pt->map_contiguous(_from, _to, _flags, color);
+            else if(lazy())
+                _pt->reserve(_from, _to, _flags);
             else
                 _pt->map(_from, _to, _flags, color);
         }
 
         Chunk(Phy_Addr phy_addr, unsigned int bytes, Flags flags)
-        : _from(0), _to(pages(bytes)), _pts(page_tables(_to - _from)), _flags(Page_Flags(flags)), _pt(calloc(_pts, WHITE)) {
+        : _from(0), _to(pages(bytes)), _pts(page_tables(_to - _from)), _flags(Page_Flags(flags)), _pt(0) {
+            if(large(bytes, _flags | Page_Flags::CT) && !(phy_addr % LARGE_PAGE)) {
+                _flags = _flags | Page_Flags::PS;
+                _pt = phy_addr;
+                return;
+            }
+            _pt = calloc(_pts, WHITE);
             _pt->remap(phy_addr, _from, _to, flags);
         }
 
         Chunk(Phy_Addr pt, unsigned int from, unsigned int to, Flags flags)
         : _from(from), _to(to), _pts(page_tables(_to - _from)), _flags(flags), _pt(pt) {}
 
+        // Clones a chunk. With Traits<MMU>::cow, present pages of non-contiguous chunks are shared read-only by both and
+        // MMU::fault() copies them on the first write. Other pages are copied right away, except for I/O, which is
+        // mapped again, and lazy pages, which each chunk fills on its own.
+        Chunk(const Chunk & chunk)
+        : _from(chunk._from), _to(chunk._to), _pts(chunk._pts), _flags(chunk._flags), _pt(0) {
+            if(_flags & Page_Flags::PS) {
+                if(_flags & Page_Flags::IO)
+                    _pt = chunk._pt;
+                else {
+                    _pt = alloc_aligned(_to - _from, PT_ENTRIES);
+                    memcpy(phy2log(_pt), phy2log(chunk._pt), size());
+                }
+                return;
+            }
+
+            _pt = calloc(_pts, WHITE);
+            Page_Table & src = chunk._pt->log();
+            Page_Table & dst = _pt->log();
+            Phy_Addr base = ((_flags & Page_Flags::CT) && !(_flags & Page_Flags::IO)) ? alloc(_to - _from) : Phy_Addr(false);
+            bool shared = false;
+            for(unsigned int i = _from; i < _to; i++) {
+                if(!(src[i] & Page_Flags::PRE) || (_flags & Page_Flags::IO))
+                    dst[i] = src[i];
+                else if(cow && !(_flags & Page_Flags::CT) && share(src[i])) {
+                    dst[i] = src[i];
+                    shared = true;
+                } else {
+                    Phy_Addr frame = base ? Phy_Addr(base + (i - _from) * sizeof(Page)) : alloc(1);
+                    memcpy(phy2log(frame), phy2log(pte2phy(src[i])), sizeof(Page));
+                    dst[i] = phy2pte(frame, pte2flg(src[i]));
+                }
+            }
+            if(shared)
+                shootdown(); // the original might be attached to the current address space, here or on another CPU
+        }
+
         ~Chunk() {
+            if(_flags & Page_Flags::PS) {
+                if(!(_flags & Page_Flags::IO))
+                    free(_pt, _to - _from);
+                return;
+            }
             if(!(_flags & Page_Flags::IO)) {
                 if(_flags & Page_Flags::CT)
                     free((*_pt)[_from], _to - _from);
                 else
                     for( ; _from < _to; _from++)
-                        free((*_pt)[_from]);
+                        release((*_pt)[_from]);
             }
             free(_pt, _pts);
         }
@@ -169,13 +256,32 @@ public:
         unsigned int size() const { return (_to - _from) * sizeof(Page); }
 
         Phy_Addr phy_address() const {
+            if(_flags & Page_Flags::PS)
+                return _pt;
             return (_flags & Page_Flags::CT) ? Phy_Addr(indexes((*_pt)[_from])) : Phy_Addr(false);
         }
 
-        int resize(unsigned int amount) {
-            if(_flags & Page_Flags::CT)
+        // Grows by mapping (or reserving, if lazy) pages after the last one and shrinks by releasing the last ones, which
+        // are flushed from the TLBs. Growing beyond what the page table maps moves it, so the chunk must not be attached.
+        int resize(int amount) {
+            if(_flags & (Page_Flags::CT | Page_Flags::PS))
                 return 0;
 
+            if(amount < 0) {
+                unsigned int pgs = (-amount) / sizeof(Page);
+                if(!pgs || (pgs >= _to - _from))
+                    return 0;
+                Page_Table & pt = _pt->log();
+                for(unsigned int i = _to - pgs; i < _to; i++) {
+                    if(!(_flags & Page_Flags::IO))
+                        release(pt[i]);
+                    pt[i] = 0;
+                }
+                _to -= pgs;
+                shootdown();
+                return -static_cast<int>(pgs * sizeof(Page));
+            }
+
             unsigned int pgs = pages(amount);
 
             Color color = colorful ? phy2color(_pt) : WHITE;
@@ -190,12 +296,20 @@ public:
                 _pts = pts;
             }
 
-            _pt->map(_to, _to + pgs, _flags, color);
+            if(lazy())
+                _pt->reserve(_to, _to + pgs, _flags);
+            else
+                _pt->map(_to, _to + pgs, _flags, color);
             _to += pgs;
 
             return pgs * sizeof(Page);
         }
 
+    private:
+        bool lazy() const { return !(_flags & Page_Flags::PRE); }
+
+        static bool large(unsigned int bytes, Page_Flags flags) { return large_pages && (flags & Page_Flags::CT) && bytes && !(bytes % LARGE_PAGE); }
+
     private:
         unsigned int _from;
         unsigned int _to;
@@ -264,6 +378,8 @@ public:
 
         Phy_Addr physical(Log_Addr addr) {
             PD_Entry pde = (*_pd)[directory(addr)];
+            if(pde & Page_Flags::PS)
+                return pde2phy(pde) | (addr & (LARGE_PAGE - 1));
             Page_Table * pt = static_cast<Page_Table *>(pde2phy(pde));
             PT_Entry pte = pt->log()[page(addr)];
             return pte | offset(addr);
@@ -274,16 +390,21 @@ public:
             for(unsigned int i = from; i < from + n; i++)
                 if(_pd->log()[i])
                     return false;
-            for(unsigned int i = from; i < from + n; i++, pt++)
-                _pd->log()[i] = phy2pde(Phy_Addr(pt), flags);
+            Phy_Addr addr = pt; // large pages are LARGE_PAGE apart, while page tables are consecutive frames
+            for(unsigned int i = from; i < from + n; i++, addr += (flags & Page_Flags::PS) ? LARGE_PAGE : sizeof(Page_Table))
+                _pd->log()[i] = phy2pde(addr, flags | Page_Flags::PRE); // lazy chunks have present page tables
             return true;
         }
 
+        // On multicores, the other CPUs flush their TLBs once, after all entries are gone
         void detach(unsigned int from, const Page_Table * pt, unsigned int n) {
             for(unsigned int i = from; i < from + n; i++) {
                 _pd->log()[i] = 0;
-                flush_tlb(i << DIRECTORY_SHIFT);
+                if(!multicore)
+                    flush_tlb(i << DIRECTORY_SHIFT);
             }
+            if(multicore)
+                shootdown();
         }
 
     private:
@@ -310,6 +431,15 @@ public:
 
         Log_Addr log_address() const { return _log_addr; }
 
+        // Cache maintenance around zero-copy transfers, of the whole buffer or of the part a transfer used (see
+        // CPU::cache_clean()): clean() before the device reads it, invalidate() before the CPU reads what it wrote
+        void clean() const { CPU::cache_clean(log_address(), size()); }
+        void clean(Log_Addr addr, unsigned int bytes) const { CPU::cache_clean(addr, bytes); }
+        void invalidate() const { CPU::cache_invalidate(log_address(), size()); }
+        void invalidate(Log_Addr addr, unsigned int bytes) const { CPU::cache_invalidate(addr, bytes); }
+        void flush() const { CPU::cache_flush(log_address(), size()); }
+        void flush(Log_Addr addr, unsigned int bytes) const { CPU::cache_flush(addr, bytes); }
+
         friend OStream & operator<<(OStream & os, const DMA_Buffer & b) {
             os << "{phy=" << b.phy_address() << ",log=" << b.log_address() << ",size=" << b.size() << ",flags=" << b.flags() << "}";
             return os;
@@ -328,6 +458,10 @@ public:
         friend OStream & operator<<(OStream & os, const Translation & t) {
             Page_Directory * pd = t._pd ? t._pd : current();
             PD_Entry pde = pd->log()[directory(t._addr)];
+            if(pde & Page_Flags::PS) {
+                os << "{addr=" << static_cast<void *>(t._addr) << ",pd=" << pd << ",pd[" << directory(t._addr) << "]=" << pde << ",f=" << physical(t._addr) << ",*addr=" << hex << *static_cast<unsigned int *>(t._addr) << "}";
+                return os;
+            }
             Page_Table * pt = static_cast<Page_Table *>(pde2phy(pde));
             PT_Entry pte = pt->log()[page(t._addr)];
 
@@ -351,11 +485,27 @@ public:
         Phy_Addr phy(false);
 
         if(frames) {
-            List::Element * e = _free[color].search_decrementing(frames);
-            if(e) {
-                phy = e->object() + e->size();
+            bool found = false;
+            if(buddy) {
+                Frame_Allocator::Frame f = _frames.alloc(frames, color);
+                if(f != Frame_Allocator::NONE) {
+                    phy = frame2phy(f);
+                    found = true;
+                }
+            } else {
+                List::Element * e = _free[color].search_decrementing(frames);
+                if(e) {
+                    phy = e->object() + e->size();
+                    found = true;
+                }
+            }
+            if(!found && ZEROED && (frames == 1) && (color == WHITE)) { // the pool is the last resort
+                phy = zeroed();
+                found = phy;
+            }
+            if(found)
                 db<MMU>(TRC) << "MMU::alloc(frames=" << frames << ",color=" << color << ") => " << phy << endl;
-            } else
+            else
                 if(colorful)
                     db<MMU>(INF) << "MMU::alloc(frames=" << frames << ",color=" << color << ") => failed!" << endl;
                 else
@@ -365,12 +515,39 @@ public:
         return phy;
     }
 
+    // Allocates frames starting at a multiple of align frames (a power of two), giving back the slack around them
+    static Phy_Addr alloc_aligned(unsigned int frames, unsigned int align, Color color = WHITE) {
+        Phy_Addr phy = alloc(frames + align - 1, color);
+        if(!phy)
+            return phy;
+
+        Phy_Addr aligned = (CPU::Reg(phy) + align * sizeof(Frame) - 1) & ~(align * sizeof(Frame) - 1);
+        unsigned int head = (aligned - phy) / sizeof(Frame);
+        if(head)
+            free(phy, head);
+        if(align - 1 - head)
+            free(aligned + frames * sizeof(Frame), align - 1 - head);
+
+        return aligned;
+    }
+
+    // Single WHITE frames come from the pool of frames zeroed by prezero(), if it isn't empty
     static Phy_Addr calloc(unsigned int frames = 1, Color color = WHITE) {
-        Phy_Addr phy = alloc(frames, color);
-        memset(phy2log(phy), 0, sizeof(Frame) * frames);
+        Phy_Addr phy(false);
+        if(ZEROED && (frames == 1) && (color == WHITE))
+            phy = zeroed();
+        if(!phy) {
+            phy = alloc(frames, color);
+            if(phy)
+                memset(phy2log(phy), 0, sizeof(Frame) * frames);
+        }
         return phy;
     }
 
+    // Called by the idle thread (of CPU 0) to add a frame to the pool while it isn't full. Returns false when it is full
+    // or there is no free frame left.
+    static bool prezero();
+
     static void free(Phy_Addr frame, int n = 1) {
         // Clean up MMU flags in frame address
         frame = indexes(frame);
@@ -379,12 +556,17 @@ public:
         db<MMU>(TRC) << "MMU::free(frame=" << frame << ",color=" << color << ",n=" << n << ")" << endl;
 
         if(frame && n) {
-            List::Element * e = new (phy2log(frame)) List::Element(frame, n);
-            List::Element * m1, * m2;
-            _free[color].insert_merging(e, &m1, &m2);
+            if(buddy)
+                _frames.free(phy2frame(frame), n, color);
+            else {
+                List::Element * e = new (phy2log(frame)) List::Element(frame, n);
+                List::Element * m1, * m2;
+                _free[color].insert_merging(e, &m1, &m2);
+            }
         }
     }
 
+    // Used by init() to give away whole regions. The buddy allocator only touches them as they are allocated (from the top)
     static void white_free(Phy_Addr frame, int n) {
         // Clean up MMU flags in frame address
         frame = indexes(frame);
@@ -392,18 +574,76 @@ public:
         db<MMU>(TRC) << "MMU::free(frame=" << frame << ",color=" << WHITE << ",n=" << n << ")" << endl;
 
         if(frame && n) {
-            List::Element * e = new (phy2log(frame)) List::Element(frame, n);
-            List::Element * m1, * m2;
-            _free[WHITE].insert_merging(e, &m1, &m2);
+            if(buddy)
+                _frames.free_region(phy2frame(frame), n, WHITE);
+            else {
+                List::Element * e = new (phy2log(frame)) List::Element(frame, n);
+                List::Element * m1, * m2;
+                _free[WHITE].insert_merging(e, &m1, &m2);
+            }
+        }
+    }
+
+    static unsigned int allocable(Color color = WHITE) {
+        if(buddy)
+            return _frames.allocable(color);
+        else
+            return _free[color].head() ? _free[color].head()->size() : 0;
+    }
+
+    // Serves a page fault on a lazy page (see Chunk) by giving it a zeroed frame, or a write fault on a copy-on-write one
+    // by giving it a copy of its frame (or the frame itself, if no one else maps it), so the faulting instruction can be restarted
+    static bool fault(Log_Addr addr) {
+        PD_Entry pde = current()->log()[directory(addr)];
+        if(!(pde & Page_Flags::PRE) || (pde & Page_Flags::PS))
+            return false;
+
+        Page_Table * pt = static_cast<Page_Table *>(pde2phy(pde));
+        PT_Entry & pte = pt->log()[page(addr)];
+        if(!pte)
+            return false;
+
+        Phy_Addr frame;
+        if(pte & Page_Flags::PRE) {
+            if(!cow || (pte & Page_Flags::RW))
+                return false;
+            unsigned char & shares = _shares[phy2frame(pte2phy(pte))];
+            if(!(shares & WRITABLE))
+                return false;
+
+            if(shares & SHARERS) {
+                frame = alloc(1, WHITE);
+                if(!frame)
+                    return false;
+                memcpy(phy2log(frame), phy2log(pte2phy(pte)), sizeof(Frame));
+                shares--;
+            } else {
+                frame = pte2phy(pte);
+                shares = 0;
+            }
+            pte = phy2pte(frame, pte2flg(pte) | Page_Flags::RW);
+            flush_tlb(addr);
+        } else {
+            frame = calloc(1, WHITE);
+            if(!frame)
+                return false;
+            pte = phy2pte(frame, pte2flg(pte) | Page_Flags::PRE);
         }
+
+        db<MMU>(TRC) << "MMU::fault(addr=" << addr << ") => " << frame << endl;
+
+        return true;
     }
 
-    static unsigned int allocable(Color color = WHITE) { return _free[color].head() ? _free[color].head()->size() : 0; }
+    static unsigned int grouped_size(Color color = WHITE) { return buddy ? _frames.grouped_size(color) : _free[color].grouped_size(); }
 
     static Page_Directory * volatile current() { return static_cast<Page_Directory * volatile>(pd()); }
 
     static Phy_Addr physical(Log_Addr addr) {
         Page_Directory * pd = current();
+        PD_Entry pde = pd->log()[directory(addr)];
+        if(pde & Page_Flags::PS)
+            return pde2phy(pde) | (addr & (LARGE_PAGE - 1));
         Page_Table * pt = pd->log()[directory(addr)];
         return pt->log()[page(addr)] | offset(addr);
     }
@@ -431,16 +671,64 @@ public:
     }
 
 private:
+    static Frame_Allocator::Frame phy2frame(Phy_Addr phy) { return (CPU::Reg(phy) - RAM_BASE) >> PAGE_SHIFT; }
+    static Phy_Addr frame2phy(Frame_Allocator::Frame frame) { return RAM_BASE + (frame << PAGE_SHIFT); }
+
+    // Adds a mapping to the frame of a present PTE, making it read-only, unless it already has as many as it can take
+    static bool share(PT_Entry & pte) {
+        unsigned char & shares = _shares[phy2frame(pte2phy(pte))];
+        if((shares & SHARERS) == SHARERS)
+            return false;
+        if(pte & Page_Flags::RW) {
+            pte &= ~Page_Flags::RW;
+            shares |= WRITABLE;
+        }
+        shares++;
+        return true;
+    }
+
+    // Frees the frame of a PTE, unless other copy-on-write mappings still use it
+    static void release(PT_Entry pte) {
+        if(cow && (pte & Page_Flags::PRE)) {
+            unsigned char & shares = _shares[phy2frame(pte2phy(pte))];
+            if(shares & SHARERS) {
+                shares--;
+                return;
+            }
+            shares = 0;
+        }
+        free(pte);
+    }
+
+    // Takes a frame from the pool, with interrupts disabled since prezero() fills it from the idle thread
+    static Phy_Addr zeroed() {
+        Phy_Addr phy(false);
+        bool ie = CPU::int_enabled();
+        CPU::int_disable();
+        if(_zeroed_count)
+            phy = _zeroed[--_zeroed_count];
+        if(ie)
+            CPU::int_enable();
+        return phy;
+    }
+
     static Phy_Addr pd() { return CPU::pd(); }
     static void pd(Phy_Addr pd) { CPU::pd(pd); }
 
     static void flush_tlb() { CPU::flush_tlb(); }
     static void flush_tlb(Log_Addr addr) { CPU::flush_tlb(addr); }
 
+    // Flushes the TLBs of all CPUs on multicores (see IPI::shootdown()), or just that of this one
+    static void shootdown();
+
     static void init();
 
 private:
     static List _free[colorful * COLORS + 1]; // +1 for WHITE
+    static Frame_Allocator _frames;
+    static unsigned char _shares[cow ? FRAMES : 1];
+    static Phy_Addr _zeroed[ZEROED ? ZEROED : 1];
+    static volatile unsigned int _zeroed_count;
     static Page_Directory * _master;
 };
 
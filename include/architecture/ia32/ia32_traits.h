@@ -13,6 +13,7 @@ template<> struct Traits<CPU>: public Traits<Build>
     static const unsigned int WORD_SIZE         = 32;
     static const unsigned int CLOCK             = 2000000000;
     static const bool unaligned_memory_access   = true;
+    static const unsigned int CACHE_LINE_SIZE   = 64;
 };
 
 template<> struct Traits<TSC>: public Traits<Build>
@@ -23,6 +24,11 @@ template<> struct Traits<MMU>: public Traits<Build>
 {
     static const bool colorful = false;
     static const unsigned int COLORS = 1;
+    static const bool buddy = false; // allocate frames with a buddy system (see utility/buddy.h) instead of a first-fit list
+    static const bool large_pages = false; // map contiguous Segments whose size is a multiple of 4 MB with PSE large pages
+    static const bool cow = false; // clone Segments copy-on-write (costs a byte per frame of RAM)
+    static const bool global_pages = false; // keep the SYSTEM mappings in the TLB across CR3 reloads (IA32 has no PCIDs outside IA-32e mode)
+    static const unsigned int ZEROED_FRAMES = 0; // single frames the idle thread keeps zeroed for calloc() (0 = zero on demand)
 };
 
 template<> struct Traits<FPU>: public Traits<Build>
@@ -16,7 +16,8 @@ public:
 public:
     TSC() {}
 
-    static Hertz frequency() { return CPU::clock(); }
+    // The TSC keeps counting at the nominal clock while CPU::clock() modulates the duty cycle
+    static Hertz frequency() { return CPU::max_clock(); }
     static PPB accuracy() { return 50; }
 
     static Time_Stamp time_stamp() {
@@ -48,6 +48,8 @@ public:
             CWT  = 1 << 6, // Cache mode (0=write-back, 1=write-through)
             CT   = 1 << 7, // Contiguous (0=non-contiguous, 1=contiguous)
             IO   = 1 << 8, // Memory Mapped I/O (0=memory, 1=I/O)
+            LZ   = 1 << 9, // Lazy (frames are allocated and zeroed on the first access; ignored if CT)
+            WC   = 1 << 10, // Write-combining (uncached, but writes are buffered and merged, e.g. for framebuffers)
             SYS  = (PRE | RD | RW | EX),
             APP  = (PRE | RD | RW | EX | USR),
             APPC = (PRE | RD | EX | USR),
@@ -86,6 +88,9 @@ public:
     constexpr static Log_Addr align_directory(const Log_Addr & addr) { return (addr + PT_ENTRIES * sizeof(Page) - 1) &  ~(PT_ENTRIES * sizeof(Page) - 1); }
 
     constexpr static Log_Addr directory_bits(const Log_Addr & addr) { return (addr & ~((1 << DIRECTORY_BITS) - 1)); }
+
+    // Frames zeroed ahead of calloc() by the idle thread, for MMUs that keep such a pool (see Traits<MMU>::ZEROED_FRAMES)
+    static bool prezero() { return false; }
 };
 
 class No_MMU: public MMU_Common<0, 0, 0>
@@ -94,7 +99,7 @@ class No_MMU: public MMU_Common<0, 0, 0>
     friend class Setup;
 
 private:
-    typedef Grouping_List<unsigned int> List;
+    typedef Grouping_List<char> List; // extents are measured in bytes
 
 public:
     // Page Flags
@@ -116,6 +121,7 @@ public:
         Chunk(unsigned int bytes, Flags flags, Color color = WHITE): _phy_addr(alloc(bytes)), _bytes(bytes), _flags(flags) {}
         Chunk(Phy_Addr phy_addr, unsigned int bytes, Flags flags): _phy_addr(phy_addr), _bytes(bytes), _flags(flags) {}
         Chunk(Phy_Addr pt, unsigned int from, unsigned int to, Flags flags): _phy_addr(0), _bytes(0), _flags(flags) {}
+        Chunk(const Chunk & chunk): _phy_addr(alloc(chunk._bytes)), _bytes(chunk._bytes), _flags(chunk._flags) { memcpy(_phy_addr, chunk._phy_addr, _bytes); } // without an MMU, nothing can be shared
 
         ~Chunk() { free(_phy_addr, _bytes); }
 
@@ -124,7 +130,26 @@ public:
         Page_Table * pt() const { return 0; }
         unsigned int size() const { return _bytes; }
         Phy_Addr phy_address() const { return _phy_addr; } // always CT
-        int resize(unsigned int amount) { return 0; } // no resize in CT
+
+        // Grows in place if the extent right after the chunk is free and shrinks by giving back the tail
+        int resize(int amount) {
+            static const unsigned int WORD = Traits<CPU>::WORD_SIZE / 8;
+
+            if(amount > 0) {
+                unsigned int bytes = (amount + WORD - 1) & ~(WORD - 1);
+                if(!take(_phy_addr + _bytes, bytes))
+                    return 0;
+                _bytes += bytes;
+                return bytes;
+            } else {
+                unsigned int bytes = (-amount) & ~(WORD - 1);
+                if((bytes >= _bytes) || (bytes <= sizeof(List::Element))) // the tail must hold a free list element
+                    return 0;
+                _bytes -= bytes;
+                free(_phy_addr + _bytes, bytes);
+                return -static_cast<int>(bytes);
+            }
+        }
 
     private:
         Phy_Addr _phy_addr;
@@ -162,6 +187,15 @@ public:
 
         Log_Addr log_address() const { return phy_address(); }
 
+        // Cache maintenance around zero-copy transfers, of the whole buffer or of the part a transfer used (see
+        // CPU::cache_clean()): clean() before the device reads it, invalidate() before the CPU reads what it wrote
+        void clean() const { CPU::cache_clean(log_address(), size()); }
+        void clean(Log_Addr addr, unsigned int bytes) const { CPU::cache_clean(addr, bytes); }
+        void invalidate() const { CPU::cache_invalidate(log_address(), size()); }
+        void invalidate(Log_Addr addr, unsigned int bytes) const { CPU::cache_invalidate(addr, bytes); }
+        void flush() const { CPU::cache_flush(log_address(), size()); }
+        void flush(Log_Addr addr, unsigned int bytes) const { CPU::cache_flush(addr, bytes); }
+
         friend Debug & operator<<(Debug & db, const DMA_Buffer & b) {
             db << "{phy=" << b.phy_address() << ",log=" << b.log_address() << ",size=" << b.size() << ",flags=" << b.flags() << "}";
             return db;
@@ -224,6 +258,25 @@ public:
 
     static unsigned int allocable(Color color = WHITE) { return _free.head() ? _free.head()->size() : 0; }
 
+    // Takes bytes from the beginning of the free extent at addr, if there is one large enough (see Chunk::resize())
+    static bool take(Phy_Addr addr, unsigned int bytes) {
+        List::Element * e = _free.search(addr);
+        if(!e || (e->size() < bytes))
+            return false;
+
+        unsigned int rest = e->size() - bytes;
+        if(rest && (rest <= sizeof(List::Element))) // what is left must still hold its element
+            return false;
+
+        db<MMU>(TRC) << "MMU::take(addr=" << addr << ",bytes=" << bytes << ")" << endl;
+
+        _free.decrement(e, e->size());
+        if(rest)
+            free(addr + bytes, rest);
+
+        return true;
+    }
+
     static Page_Directory * volatile current() { return 0; }
 
     static Phy_Addr physical(Log_Addr addr) { return addr; }
@@ -35,10 +35,22 @@ public:
     static void start(Channel channel) {}
     static void stop(Channel channel) {}
     static void reset(Channel channel) {}
+
+    // Event-based sampling: "channel" counts "event" and overflows every "period" of them, each overflow recording the
+    // interrupted PC and thread in the Sampler (see utility/sampler.h); only where the overflow interrupt is wired to IC
+    static void sample(Channel channel, Event event, Count period) {}
+    static bool overflow(Channel channel) { return false; }
+    static void clear_overflow(Channel channel) {}
 };
 
 #ifndef __PMU_H
-class PMU: public PMU_Common {};
+class PMU: public PMU_Common
+{
+public:
+    using PMU_Common::CHANNELS;
+    using PMU_Common::FIXED;
+    using PMU_Common::EVENTS;
+};
 #endif
 
 __END_SYS
@@ -63,7 +63,8 @@ public:
         STI             = 1 << 5,       // Supervisor Timer Interrupt
         MTI             = 1 << 7,       // Machine Timer Interrupt
         SEI             = 1 << 9,       // Supervisor External Interrupt
-        MEI             = 1 << 11       // Machine External Interrupt
+        MEI             = 1 << 11,      // Machine External Interrupt
+        LCOFI           = 1 << 13       // Local Counter Overflow Interrupt (Sscofpmf)
     };
 
     // Exceptions ([m|s]cause with interrupt = 0)
@@ -99,6 +100,8 @@ public:
         // Contexts are loaded with [m|s]ret, which gets pc from [m|s]epc and updates some bits of [m|s]status, that's why _st is initialized with [M|S]PIE and [M|S]PP
         // Kernel threads are created with usp = 0 and have SPP_S set
         // Dummy contexts for the first execution of each thread (both kernel and user) are created with exit = 0 and SPIE cleared (no interrupts until the second context is popped)
+        // Interrupts push and pop the whole frame, while switch_context() (always a function call) only saves pc, st, ra and s0-s11 in it,
+        // leaving the caller-saved slots stale. Since a0-a7 are still popped, the arguments placed there by init_stack() reach new threads
         Context(Log_Addr entry, Log_Addr exit): _pc(entry), _st((exit ? MPIE : 0) | MPP_M), _x1(exit) {
             if(Traits<Build>::hysterically_debugged || Traits<Thread>::trace_idle) {
                                                                         _x5 =  5;  _x6 =  6;  _x7 =  7;  _x8 =  8;  _x9 =  9;
@@ -203,6 +206,16 @@ public:
     static Reg sp() { Reg r; ASM("mv %0, sp" :  "=r"(r) :); return r; }
     static void sp(Reg r) {  ASM("mv sp, %0" : : "r"(r) :); }
 
+    // Calls "f(a)" with "sp" as the stack and comes back to the current one (e.g. per-CPU interrupt stacks)
+    static void stack_call(Reg sp, void (* f)(unsigned int), unsigned int a) {
+        ASM("       mv      s1, sp                  \n"    // s1 is preserved by "f"
+            "       mv      sp, %0                  \n"
+            "       mv      a0, %2                  \n"
+            "       jalr    %1                      \n"
+            "       mv      sp, s1                  \n" : : "r"(sp), "r"(f), "r"(a) : "ra", "t0", "t1", "t2", "t3", "t4", "t5", "t6",
+                                                           "a0", "a1", "a2", "a3", "a4", "a5", "a6", "a7", "s1", "memory");
+    }
+
     static Reg fp() { Reg r; ASM("mv %0, fp" :  "=r"(r) :); return r; }
     static void fp(Reg r) {  ASM("mv fp, %0" : : "r"(r) :); }
 
@@ -214,6 +227,7 @@ public:
 
     static unsigned int id() { return 0; }
     static unsigned int cores() { return 1; }
+    static void smp_barrier(unsigned int n = cores()) { CPU_Common::smp_barrier<&finc<int>>(n, id()); }
 
     using CPU_Common::clock;
     using CPU_Common::min_clock;
@@ -226,9 +240,15 @@ public:
     static bool int_disabled() { return !int_enabled(); }
 
     static void halt() { ASM("wfi"); }
+    static void pause() { ASM(".word 0x0100000f"); } // Zihintpause PAUSE (a FENCE hint, so a NOP where it is not implemented)
+    static void fence() { ASM("fence rw, rw" : : : "memory"); } // no memory access crosses it, on any core
 
     static void fpu_save();
     static void fpu_restore();
+    using CPU_Common::FPU_Context;
+    using CPU_Common::fpu_switch;
+    using CPU_Common::fpu_trap;
+    using CPU_Common::TLS_TCB;
 
     static void switch_context(Context ** o, Context * n) __attribute__ ((naked));
 
@@ -311,6 +331,12 @@ public:
     static Reg tp() { Reg r; ASM("mv %0, x4" : "=r"(r) :); return r; }
     static void tp(Reg r) {  ASM("mv x4, %0" : : "r"(r) :); }
 
+    static void tls(Log_Addr block) { tp(block); } // RISC-V TLS blocks start right at tp
+    static Log_Addr int_pc() { return mepc(); }
+    using CPU_Common::cache_clean;      // DMA is coherent
+    using CPU_Common::cache_invalidate;
+    using CPU_Common::cache_flush;
+
     static Reg a0() { Reg r; ASM("mv %0, a0" :  "=r"(r)); return r; }
     static void a0(Reg r) {  ASM("mv a0, %0" : : "r"(r) :); }
 
@@ -417,8 +443,10 @@ if(interrupt) {
     ASM("       csrr     x3,  mstatus           \n");
 
     ASM("       sw       x3,    4(sp)           \n"     // push ST
-        "       sw       x1,    8(sp)           \n"     // push RA
-        "       sw       x5,   12(sp)           \n"     // push x5-x31
+        "       sw       x1,    8(sp)           \n");   // push RA
+
+if(interrupt) {
+    ASM("       sw       x5,   12(sp)           \n"     // push x5-x31
         "       sw       x6,   16(sp)           \n"
         "       sw       x7,   20(sp)           \n"
         "       sw       x8,   24(sp)           \n"
@@ -445,6 +473,20 @@ if(interrupt) {
         "       sw      x29,  108(sp)           \n"
         "       sw      x30,  112(sp)           \n"
         "       sw      x31,  116(sp)           \n");
+} else {
+    ASM("       sw       x8,   24(sp)           \n"     // push s0-s11, the ABI callee-saved registers (the others are dead across a call to switch_context())
+        "       sw       x9,   28(sp)           \n"
+        "       sw      x18,   64(sp)           \n"
+        "       sw      x19,   68(sp)           \n"
+        "       sw      x20,   72(sp)           \n"
+        "       sw      x21,   76(sp)           \n"
+        "       sw      x22,   80(sp)           \n"
+        "       sw      x23,   84(sp)           \n"
+        "       sw      x24,   88(sp)           \n"
+        "       sw      x25,   92(sp)           \n"
+        "       sw      x26,   96(sp)           \n"
+        "       sw      x27,  100(sp)           \n");
+}
 }
 
 inline void CPU::Context::pop(bool interrupt)
@@ -461,8 +503,10 @@ if(!interrupt) {
         "       or       x3, x3, a0             \n");   // mstatus.MPP is automatically cleared on mret, so we reset it to MPP_M here
 }
 
-    ASM("       lw       x1,    8(sp)           \n"     // pop RA
-        "       lw       x5,   12(sp)           \n"     // pop x5-x31
+    ASM("       lw       x1,    8(sp)           \n");   // pop RA
+
+if(interrupt) {
+    ASM("       lw       x5,   12(sp)           \n"     // pop x5-x31
         "       lw       x6,   16(sp)           \n"
         "       lw       x7,   20(sp)           \n"
         "       lw       x8,   24(sp)           \n"
@@ -488,8 +532,31 @@ if(!interrupt) {
         "       lw      x28,  104(sp)           \n"
         "       lw      x29,  108(sp)           \n"
         "       lw      x30,  112(sp)           \n"
-        "       lw      x31,  116(sp)           \n"
-        "       addi    sp, sp, %0              \n" : : "i"(sizeof(Context))); // complete the pops above by adjusting SP
+        "       lw      x31,  116(sp)           \n");
+} else {
+    ASM("       lw       x8,   24(sp)           \n"     // pop s0-s11 and a0-a7 (arguments for the first execution of a thread)
+        "       lw       x9,   28(sp)           \n"
+        "       lw      x10,   32(sp)           \n"
+        "       lw      x11,   36(sp)           \n"
+        "       lw      x12,   40(sp)           \n"
+        "       lw      x13,   44(sp)           \n"
+        "       lw      x14,   48(sp)           \n"
+        "       lw      x15,   52(sp)           \n"
+        "       lw      x16,   56(sp)           \n"
+        "       lw      x17,   60(sp)           \n"
+        "       lw      x18,   64(sp)           \n"
+        "       lw      x19,   68(sp)           \n"
+        "       lw      x20,   72(sp)           \n"
+        "       lw      x21,   76(sp)           \n"
+        "       lw      x22,   80(sp)           \n"
+        "       lw      x23,   84(sp)           \n"
+        "       lw      x24,   88(sp)           \n"
+        "       lw      x25,   92(sp)           \n"
+        "       lw      x26,   96(sp)           \n"
+        "       lw      x27,  100(sp)           \n");
+}
+
+    ASM("       addi    sp, sp, %0              \n" : : "i"(sizeof(Context))); // complete the pops above by adjusting SP
 
     ASM("       csrw    mstatus, x3             \n");   // MSTATUS = ST
 }
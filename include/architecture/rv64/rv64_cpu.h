@@ -11,6 +11,9 @@ class CPU: protected CPU_Common
 {
     friend class Init_System; // for CPU::init()
 
+private:
+    static const bool lazy_fpu = Traits<FPU>::enabled && !Traits<FPU>::user_save;
+
  public:
     // CPU Native Data Types
     using CPU_Common::Reg8;
@@ -63,7 +66,8 @@ class CPU: protected CPU_Common
         STI             = 1 << 5,       // Supervisor Timer Interrupt
         MTI             = 1 << 7,       // Machine Timer Interrupt
         SEI             = 1 << 9,       // Supervisor External Interrupt
-        MEI             = 1 << 11       // Machine External Interrupt
+        MEI             = 1 << 11,      // Machine External Interrupt
+        LCOFI           = 1 << 13       // Local Counter Overflow Interrupt (Sscofpmf)
     };
 
     // Exceptions ([m|s]cause with interrupt = 0)
@@ -99,6 +103,8 @@ class CPU: protected CPU_Common
         // Contexts are loaded with [m|s]ret, which gets pc from [m|s]epc and updates some bits of [m|s]status, that's why _st is initialized with [M|S]PIE and [M|S]PP
         // Kernel threads are created with usp = 0 and have SPP_S set
         // Dummy contexts for the first execution of each thread (both kernel and user) are created with exit = 0 and SPIE cleared (no interrupts until the second context is popped)
+        // Interrupts push and pop the whole frame, while switch_context() (always a function call) only saves pc, st, ra and s0-s11 in it,
+        // leaving the caller-saved slots stale. Since a0-a7 are still popped, the arguments placed there by init_stack() reach new threads
         Context(Log_Addr entry, Log_Addr exit): _pc(entry), _st((exit ? MPIE : 0) | MPP_M), _x1(exit) {
             if(Traits<Build>::hysterically_debugged || Traits<Thread>::trace_idle) {
                                                                         _x5 =  5;  _x6 =  6;  _x7 =  7;  _x8 =  8;  _x9 =  9;
@@ -189,6 +195,19 @@ class CPU: protected CPU_Common
         Reg _x31;     // t6
     };
 
+    // FPU Context
+    // FPU registers are switched lazily: fpu_switch() saves them only if the outgoing thread
+    // left mstatus.FS DIRTY and then turns the FPU off, so the first FP instruction of the
+    // incoming thread traps (illegal instruction) and fpu_trap() restores its registers.
+    class FPU_Context
+    {
+        friend class CPU;
+
+    private:
+        double _f[32];
+        Reg _fcsr;
+    };
+
     // Interrupt Service Routines
     typedef void (ISR)();
 
@@ -203,6 +222,16 @@ public:
     static Reg sp() { Reg r; ASM("mv %0, sp" :  "=r"(r) :); return r; }
     static void sp(Reg r) {  ASM("mv sp, %0" : : "r"(r) :); }
 
+    // Calls "f(a)" with "sp" as the stack and comes back to the current one (e.g. per-CPU interrupt stacks)
+    static void stack_call(Reg sp, void (* f)(unsigned int), unsigned int a) {
+        ASM("       mv      s1, sp                  \n"    // s1 is preserved by "f"
+            "       mv      sp, %0                  \n"
+            "       mv      a0, %2                  \n"
+            "       jalr    %1                      \n"
+            "       mv      sp, s1                  \n" : : "r"(sp), "r"(f), "r"(a) : "ra", "t0", "t1", "t2", "t3", "t4", "t5", "t6",
+                                                           "a0", "a1", "a2", "a3", "a4", "a5", "a6", "a7", "s1", "memory");
+    }
+
     static Reg fp() { Reg r; ASM("mv %0, fp" :  "=r"(r) :); return r; }
     static void fp(Reg r) {  ASM("mv fp, %0" : : "r"(r) :); }
 
@@ -212,8 +241,11 @@ public:
     static Reg fr() { Reg r; ASM("mv %0, a0" :  "=r"(r)); return r; }
     static void fr(Reg r) {  ASM("mv a0, %0" : : "r"(r) :); }
 
-    static unsigned int id() { return 0; }
-    static unsigned int cores() { return 1; }
+    // EPOS runs in machine mode, so each CPU is the hart of the same id (SETUP only lets Traits<Build>::CPUS of them in)
+    static unsigned int id() { return (Traits<Build>::CPUS > 1) ? mhartid() : 0; }
+    static unsigned int cores() { return Traits<Build>::CPUS; }
+
+    static void smp_barrier(unsigned int n = cores()) { CPU_Common::smp_barrier<&finc<int>>(n, id()); }
 
     using CPU_Common::clock;
     using CPU_Common::min_clock;
@@ -226,9 +258,29 @@ public:
     static bool int_disabled() { return !int_enabled(); }
 
     static void halt() { ASM("wfi"); }
+    static void pause() { ASM(".word 0x0100000f"); } // Zihintpause PAUSE (a FENCE hint, so a NOP where it is not implemented)
+    static void fence() { ASM("fence rw, rw" : : : "memory"); } // no memory access crosses it, on any core
+
+    static void fpu_save(FPU_Context * fpu);
+    static void fpu_restore(const FPU_Context * fpu);
+
+    static void fpu_switch(FPU_Context * prev, FPU_Context * next) {
+        if(lazy_fpu) {
+            if((mstatus() & FS) == FS_DIRTY)
+                fpu_save(prev);
+            mstatusc(FS);       // FS_OFF
+            _fpu_current[id()] = next;
+        }
+    }
+
+    static bool fpu_trap();
 
-    static void fpu_save();
-    static void fpu_restore();
+    using CPU_Common::TLS_TCB;
+    static void tls(Log_Addr block) { tp(block); } // RISC-V TLS blocks start right at tp
+    static Log_Addr int_pc() { return mepc(); }
+    using CPU_Common::cache_clean;      // DMA is coherent
+    using CPU_Common::cache_invalidate;
+    using CPU_Common::cache_flush;
 
     static void switch_context(Context ** o, Context * n) __attribute__ ((naked));
 
@@ -299,6 +351,7 @@ public:
 
     static void flush_tlb() {         ASM("sfence.vma"    : :           : "memory"); }
     static void flush_tlb(Reg addr) { ASM("sfence.vma %0" : : "r"(addr) : "memory"); }
+    static void flush_tlb_asid(Reg asid) { ASM("sfence.vma zero, %0" : : "r"(asid) : "memory"); }
 
     using CPU_Common::htole64;
     using CPU_Common::htole32;
@@ -348,7 +401,7 @@ public:
     static void mint_enable()  { ASM("csrsi mstatus, %0" : : "i"(MIE) : "cc"); }
     static void mint_disable() { ASM("csrci mstatus, %0" : : "i"(MIE) : "cc"); }
 
-    static Reg mhartid() { Reg r; ASM("csrr %0, mhartid" : "=r"(r) : : "memory", "cc"); return r & 0x3; }
+    static Reg mhartid() { Reg r; ASM("csrr %0, mhartid" : "=r"(r) : : "memory", "cc"); return r; }
 
     static void mscratch(Reg r)   { ASM("csrw mscratch, %0" : : "r"(r) : "cc"); }
     static Reg  mscratch() { Reg r; ASM("csrr %0, mscratch" :  "=r"(r) : : ); return r; }
@@ -425,6 +478,7 @@ private:
 private:
     static unsigned int _cpu_clock;
     static unsigned int _bus_clock;
+    static FPU_Context * _fpu_current[Traits<Build>::CPUS];
 };
 
 inline void CPU::Context::push(bool interrupt)
@@ -435,14 +489,16 @@ if(interrupt) {
     ASM("       csrr     x3,    mepc            \n"
         "       sd       x3,    0(sp)           \n");   // push MEPC as PC on interrupts
 } else {
-    ASM("       sw       x1,    0(sp)           \n");   // push RA as PC on context switches
+    ASM("       sd       x1,    0(sp)           \n");   // push RA as PC on context switches
 }
 
     ASM("       csrr     x3,  mstatus           \n");
 
     ASM("       sd       x3,    8(sp)           \n"     // push ST
-        "       sd       x1,   16(sp)           \n"     // push RA
-        "       sd       x5,   24(sp)           \n"     // push x5-x31
+        "       sd       x1,   16(sp)           \n");   // push RA
+
+if(interrupt) {
+    ASM("       sd       x5,   24(sp)           \n"     // push x5-x31
         "       sd       x6,   32(sp)           \n"
         "       sd       x7,   40(sp)           \n"
         "       sd       x8,   48(sp)           \n"
@@ -469,6 +525,20 @@ if(interrupt) {
         "       sd      x29,  216(sp)           \n"
         "       sd      x30,  224(sp)           \n"
         "       sd      x31,  232(sp)           \n");
+} else {
+    ASM("       sd       x8,   48(sp)           \n"     // push s0-s11, the ABI callee-saved registers (the others are dead across a call to switch_context())
+        "       sd       x9,   56(sp)           \n"
+        "       sd      x18,  128(sp)           \n"
+        "       sd      x19,  136(sp)           \n"
+        "       sd      x20,  144(sp)           \n"
+        "       sd      x21,  152(sp)           \n"
+        "       sd      x22,  160(sp)           \n"
+        "       sd      x23,  168(sp)           \n"
+        "       sd      x24,  176(sp)           \n"
+        "       sd      x25,  184(sp)           \n"
+        "       sd      x26,  192(sp)           \n"
+        "       sd      x27,  200(sp)           \n");
+}
 }
 
 inline void CPU::Context::pop(bool interrupt)
@@ -483,10 +553,19 @@ if(interrupt) {
 if(!interrupt) {
     ASM("       li       a0, 3 << 11            \n"     // use a0 as a second TMP, since it will be restored later
         "       or       x3, x3, a0             \n");   // mstatus.MPP is automatically cleared on mret, so we reset it to MPP_M here
+} else if(lazy_fpu) {
+    ASM("       csrr     a0, mstatus            \n"     // use a0 and a1 as TMPs, since they will be restored later
+        "       li       a1, 3 << 13            \n"
+        "       and      a0, a0, a1             \n"
+        "       not      a1, a1                 \n"
+        "       and      x3, x3, a1             \n"
+        "       or       x3, x3, a0             \n");   // keep the current mstatus.FS, which either fpu_trap() or a context switch might have changed
 }
 
-    ASM("       ld       x1,   16(sp)           \n"     // pop RA
-        "       ld       x5,   24(sp)           \n"     // pop x5-x31
+    ASM("       ld       x1,   16(sp)           \n");   // pop RA
+
+if(interrupt) {
+    ASM("       ld       x5,   24(sp)           \n"     // pop x5-x31
         "       ld       x6,   32(sp)           \n"
         "       ld       x7,   40(sp)           \n"
         "       ld       x8,   48(sp)           \n"
@@ -512,8 +591,31 @@ if(!interrupt) {
         "       ld      x28,  208(sp)           \n"
         "       ld      x29,  216(sp)           \n"
         "       ld      x30,  224(sp)           \n"
-        "       ld      x31,  232(sp)           \n"
-        "       addi    sp, sp, %0              \n" : : "i"(sizeof(Context))); // complete the pops above by adjusting SP
+        "       ld      x31,  232(sp)           \n");
+} else {
+    ASM("       ld       x8,   48(sp)           \n"     // pop s0-s11 and a0-a7 (arguments for the first execution of a thread)
+        "       ld       x9,   56(sp)           \n"
+        "       ld      x10,   64(sp)           \n"
+        "       ld      x11,   72(sp)           \n"
+        "       ld      x12,   80(sp)           \n"
+        "       ld      x13,   88(sp)           \n"
+        "       ld      x14,   96(sp)           \n"
+        "       ld      x15,  104(sp)           \n"
+        "       ld      x16,  112(sp)           \n"
+        "       ld      x17,  120(sp)           \n"
+        "       ld      x18,  128(sp)           \n"
+        "       ld      x19,  136(sp)           \n"
+        "       ld      x20,  144(sp)           \n"
+        "       ld      x21,  152(sp)           \n"
+        "       ld      x22,  160(sp)           \n"
+        "       ld      x23,  168(sp)           \n"
+        "       ld      x24,  176(sp)           \n"
+        "       ld      x25,  184(sp)           \n"
+        "       ld      x26,  192(sp)           \n"
+        "       ld      x27,  200(sp)           \n");
+}
+
+    ASM("       addi    sp, sp, %0              \n" : : "i"(sizeof(Context))); // complete the pops above by adjusting SP
 
     ASM("       csrw    mstatus, x3             \n");   // MSTATUS = ST
 }
@@ -7,10 +7,612 @@
 #include <architecture/mmu.h>
 #undef __mmu_common_only__
 #include <system/memory_map.h>
+#include <utility/bitmap.h>
 
 __BEGIN_SYS
 
-class MMU: public No_MMU {};
+// Sv39 paging (Traits<MMU>::paged): three levels of 512-entry tables translate 39-bit logical addresses in 4 KB pages.
+// Chunks are mapped by last-level Page_Tables, which Directory::attach() links into the 2 MB slots of an address
+// space, allocating the middle-level tables as needed. RAM and I/O are identity-mapped by global 1 GB leaves of the
+// master root, shared by all address spaces, so phy2log() is the identity. Machine mode is never translated, so the
+// kernel reaches tables and frames by their physical addresses and translation applies to supervisor and user code.
+class Sv39_MMU: public MMU_Common<9, 9, 12>
+{
+    friend class CPU;
+    friend class Setup;
+
+private:
+    typedef Grouping_List<Frame> List;
+
+    static const unsigned long RAM_BASE = Memory_Map::RAM_BASE;
+    static const unsigned long RAM_TOP  = Memory_Map::RAM_TOP;
+    static const unsigned long MIO_BASE = Memory_Map::MIO_BASE;
+    static const unsigned long MIO_TOP  = Memory_Map::MIO_TOP;
+    static const unsigned long APP_LOW  = Memory_Map::APP_LOW;
+    static const unsigned long APP_HIGH = Memory_Map::APP_HIGH;
+
+    static const unsigned long PPN_SHIFT = 10;                      // PTEs hold physical page numbers from bit 10 on
+    static const unsigned long PPN_MASK = (1UL << 44) - 1;
+    static const unsigned long SATP_SV39 = 8UL << 60;
+    static const unsigned long ASID_SHIFT = 44;
+    static const unsigned long ASID_MASK = 0xffff;
+
+    // ASID 0 belongs to the master and to Directories that could not get one of their own, so activating them flushes
+    static const bool asids = Traits<MMU>::asids;
+    static const unsigned int ASIDS = 256;
+
+    static const bool large_pages = Traits<MMU>::large_pages;
+    static const bool multicore = Traits<System>::multicore;
+    static const unsigned long LARGE_PAGE = PT_ENTRIES * sizeof(Page); // 2 MB megapage, a leaf in a middle-level table
+
+public:
+    static const unsigned long ROOT_SHIFT = DIRECTORY_SHIFT + 9; // 1 GB per root entry
+
+    // Page Flags
+    class Page_Flags
+    {
+    public:
+        enum : unsigned long {
+            V    = 1 << 0, // Valid
+            R    = 1 << 1, // Readable
+            W    = 1 << 2, // Writable
+            X    = 1 << 3, // Executable
+            U    = 1 << 4, // User accessible
+            G    = 1 << 5, // Global (mapped in all address spaces)
+            A    = 1 << 6, // Accessed
+            D    = 1 << 7, // Dirty
+            CT   = 1 << 8, // Reserved for software (0=non-contiguous, 1=contiguous)
+            IO   = 1 << 9, // Reserved for software (0=memory, 1=I/O, whose frames are never released)
+            APP  = (V | R | W | X | U | A | D),
+            APPC = (V | R | X | U | A | D),
+            APPD = (V | R | W | U | A | D),
+            SYS  = (V | R | W | X | A | D),
+            DMA  = (SYS | CT),
+            MASK = (1 << PPN_SHIFT) - 1
+        };
+
+    public:
+        Page_Flags() {}
+        Page_Flags(unsigned long f) : _flags(f) {}
+        // A and D are always set, since implementations may trap instead of setting them on the first access
+        Page_Flags(Flags f) : _flags(V | R | A | D |
+                                    ((f & Flags::RW)  ? W  : 0) |
+                                    ((f & Flags::EX)  ? X  : 0) |
+                                    ((f & Flags::USR) ? U  : 0) |
+                                    ((f & Flags::CT)  ? CT : 0) |
+                                    ((f & Flags::IO)  ? IO : 0) ) {}
+
+        operator unsigned long() const { return _flags; }
+
+        friend OStream & operator<<(OStream & os, const Page_Flags & f) { os << hex << f._flags; return os; }
+
+    private:
+        unsigned long _flags;
+    };
+
+    // Page Table (for all levels)
+    class Page_Table
+    {
+    public:
+        Page_Table() {}
+
+        PT_Entry & operator[](unsigned int i) { return _entry[i]; }
+        Page_Table & log() { return *static_cast<Page_Table *>(phy2log(this)); }
+
+        void map(int from, int to, Page_Flags flags) {
+            Phy_Addr addr = alloc(to - from);
+            if(addr)
+                remap(addr, from, to, flags);
+            else
+                for( ; from < to; from++)
+                    _entry[from] = phy2pte(alloc(1), flags);
+        }
+
+        void map_contiguous(int from, int to, Page_Flags flags) {
+            remap(alloc(to - from), from, to, flags);
+        }
+
+        void remap(Phy_Addr addr, int from, int to, Page_Flags flags) {
+            addr = align_page(addr);
+            for( ; from < to; from++) {
+                _entry[from] = phy2pte(addr, flags);
+                addr += sizeof(Page);
+            }
+        }
+
+        void unmap(int from, int to) {
+            for( ; from < to; from++) {
+                free(pte2phy(_entry[from]));
+                _entry[from] = 0;
+            }
+        }
+
+        friend OStream & operator<<(OStream & os, Page_Table & pt) {
+            os << "{\n";
+            for(unsigned int i = 0; i < PT_ENTRIES; i++)
+                if(pt[i])
+                    os << "[" << i << "] \t" << pte2phy(pt[i]) << "\n";
+            os << "}";
+            return os;
+        }
+
+    private:
+        PT_Entry _entry[PT_ENTRIES]; // the Phy_Addr in each entry passed through phy2pte()
+    };
+
+    // Page Directory (root)
+    typedef Page_Table Page_Directory;
+
+    // Chunk (for Segment)
+    // Contiguous chunks whose size is a multiple of LARGE_PAGE (and, for I/O, whose address is aligned to it) are mapped
+    // with megapages if Traits<MMU>::large_pages is set. They have no page tables: _pt holds the address of the first
+    // frame and _pts counts the megapages, which are attached as leaves in the slots that would hold page tables.
+    class Chunk
+    {
+    public:
+        Chunk() {}
+
+        Chunk(unsigned int bytes, Flags flags, Color color = WHITE)
+        : _from(0), _to(pages(bytes)), _pts(page_tables(_to - _from)), _flags(Page_Flags(flags)), _pt(0), _large(false) {
+            if(large(bytes, _flags) && (_pt = alloc_aligned(_to, PT_ENTRIES))) {
+                _large = true;
+                return;
+            }
+            _pt = calloc(_pts);
+            if(_flags & Page_Flags::CT)
+                _pt->map_contiguous(_from, _to, _flags);
+            else
+                _pt->map(_from, _to, _flags);
+        }
+
+        Chunk(Phy_Addr phy_addr, unsigned int bytes, Flags flags)
+        : _from(0), _to(pages(bytes)), _pts(page_tables(_to - _from)), _flags(Page_Flags(flags)), _pt(0), _large(false) {
+            if(large(bytes, _flags | Page_Flags::CT) && !(phy_addr % LARGE_PAGE)) {
+                _pt = phy_addr;
+                _large = true;
+                return;
+            }
+            _pt = calloc(_pts);
+            _pt->remap(phy_addr, _from, _to, _flags);
+        }
+
+        Chunk(Phy_Addr pt, unsigned int from, unsigned int to, Flags flags)
+        : _from(from), _to(to), _pts(page_tables(_to - _from)), _flags(flags), _pt(pt), _large(false) {}
+
+        // Clones a chunk by copying its frames (machine mode writes are never translated, so they can't be caught for
+        // copy-on-write), except for I/O, which is mapped again
+        Chunk(const Chunk & chunk)
+        : _from(chunk._from), _to(chunk._to), _pts(chunk._pts), _flags(chunk._flags), _pt(0), _large(chunk._large) {
+            if(_large) {
+                if(_flags & Page_Flags::IO)
+                    _pt = chunk._pt;
+                else {
+                    _pt = alloc_aligned(_to - _from, PT_ENTRIES);
+                    memcpy(phy2log(_pt), phy2log(chunk._pt), size());
+                }
+                return;
+            }
+
+            _pt = calloc(_pts);
+            Phy_Addr base = ((_flags & Page_Flags::CT) && !(_flags & Page_Flags::IO)) ? alloc(_to - _from) : Phy_Addr(false);
+            for(unsigned int i = _from; i < _to; i++) {
+                PT_Entry pte = (*chunk._pt)[i];
+                if(!pte || (_flags & Page_Flags::IO))
+                    (*_pt)[i] = pte;
+                else {
+                    Phy_Addr frame = base ? Phy_Addr(base + (i - _from) * sizeof(Page)) : alloc(1);
+                    memcpy(phy2log(frame), phy2log(pte2phy(pte)), sizeof(Page));
+                    (*_pt)[i] = phy2pte(frame, pte2flg(pte));
+                }
+            }
+        }
+
+        ~Chunk() {
+            if(_large) {
+                if(!(_flags & Page_Flags::IO))
+                    free(_pt, _to - _from);
+                return;
+            }
+            if(!(_flags & Page_Flags::IO)) {
+                if(_flags & Page_Flags::CT)
+                    free(pte2phy((*_pt)[_from]), _to - _from);
+                else
+                    for( ; _from < _to; _from++)
+                        free(pte2phy((*_pt)[_from]));
+            }
+            free(_pt, _pts);
+        }
+
+        unsigned int pts() const { return _pts; }
+        Page_Flags flags() const { return _flags; }
+        Page_Table * pt() const { return _pt; }
+        bool large() const { return _large; }
+        unsigned int size() const { return (_to - _from) * sizeof(Page); }
+
+        Phy_Addr phy_address() const {
+            if(_large)
+                return _pt;
+            return (_flags & Page_Flags::CT) ? pte2phy((*_pt)[_from]) : Phy_Addr(false);
+        }
+
+        // Grows by mapping pages after the last one and shrinks by freeing the last ones, which are flushed from the TLBs.
+        // Growing beyond what the page table maps moves it, so the chunk must not be attached.
+        int resize(int amount) {
+            if((_flags & Page_Flags::CT) || _large)
+                return 0;
+
+            if(amount < 0) {
+                unsigned int pgs = (-amount) / sizeof(Page);
+                if(!pgs || (pgs >= _to - _from))
+                    return 0;
+                for(unsigned int i = _to - pgs; i < _to; i++) {
+                    if(!(_flags & Page_Flags::IO))
+                        free(pte2phy((*_pt)[i]));
+                    (*_pt)[i] = 0;
+                }
+                _to -= pgs;
+                shootdown();
+                return -static_cast<int>(pgs * sizeof(Page));
+            }
+
+            unsigned int pgs = pages(amount);
+
+            unsigned int free_pgs = _pts * PT_ENTRIES - _to;
+            if(free_pgs < pgs) { // resize _pt
+                unsigned int pts = _pts + page_tables(pgs - free_pgs);
+                Page_Table * pt = calloc(pts);
+                memcpy(phy2log(pt), phy2log(_pt), _pts * sizeof(Page));
+                free(_pt, _pts);
+                _pt = pt;
+                _pts = pts;
+            }
+
+            _pt->map(_to, _to + pgs, _flags);
+            _to += pgs;
+
+            return pgs * sizeof(Page);
+        }
+
+    private:
+        static bool large(unsigned int bytes, Page_Flags flags) { return large_pages && (flags & Page_Flags::CT) && bytes && !(bytes % LARGE_PAGE); }
+
+    private:
+        unsigned int _from;
+        unsigned int _to;
+        unsigned int _pts;
+        Page_Flags _flags;
+        Page_Table * _pt; // this is a physical address
+        bool _large;
+    };
+
+    // Directory (for Address_Space)
+    // Slots are the 2 MB regions mapped by each Page_Table, numbered by directory()
+    class Directory
+    {
+    public:
+        Directory() : _pd(calloc(1)), _asid(asid_alloc()), _free(true) {
+            for(unsigned int i = 0; i < PT_ENTRIES; i++)
+                if(leaf((*_master)[i]))
+                    (*_pd)[i] = (*_master)[i];
+        }
+
+        Directory(Page_Directory * pd) : _pd(pd), _asid(0), _free(false) {}
+
+        ~Directory() {
+            if(_free) {
+                for(unsigned int i = 0; i < PT_ENTRIES; i++)
+                    if((*_pd)[i] && !leaf((*_pd)[i]))
+                        free(pde2phy((*_pd)[i]));
+                free(_pd);
+                asid_free(_asid);
+            }
+        }
+
+        Phy_Addr pd() const { return _pd; }
+        unsigned int asid() const { return _asid; }
+
+        void activate() const { Sv39_MMU::pd(_pd, _asid); }
+
+        Log_Addr attach(const Chunk & chunk, unsigned int from = directory(APP_LOW)) {
+            for(unsigned int i = from; (i + chunk.pts()) <= directory(APP_HIGH); i++)
+                if(attach(i, chunk))
+                    return Log_Addr(static_cast<unsigned long>(i) << DIRECTORY_SHIFT);
+            return Log_Addr(false);
+        }
+
+        Log_Addr attach(const Chunk & chunk, Log_Addr addr) {
+            unsigned int from = directory(addr);
+            if(attach(from, chunk))
+                return Log_Addr(static_cast<unsigned long>(from) << DIRECTORY_SHIFT);
+            return Log_Addr(false);
+        }
+
+        void detach(const Chunk & chunk) {
+            for(unsigned int i = 0; i < PT_ENTRIES; i++)
+                if((*_pd)[i] && !leaf((*_pd)[i])) {
+                    Page_Table * pt = pde2phy((*_pd)[i]);
+                    for(unsigned int j = 0; j < PT_ENTRIES; j++)
+                        if((*pt)[j] && (pde2phy((*pt)[j]) == chunk.pt())) {
+                            detach(i * PT_ENTRIES + j, chunk.pts());
+                            return;
+                        }
+                }
+            db<MMU>(WRN) << "MMU::Directory::detach(pt=" << chunk.pt() << ") failed!" << endl;
+        }
+
+        void detach(const Chunk & chunk, Log_Addr addr) {
+            unsigned int from = directory(addr);
+            PD_Entry * pde = slot(from, false);
+            if(!pde || (pde2phy(*pde) != chunk.pt())) {
+                db<MMU>(WRN) << "MMU::Directory::detach(pt=" << chunk.pt() << ",addr=" << addr << ") failed!" << endl;
+                return;
+            }
+            detach(from, chunk.pts());
+        }
+
+        Phy_Addr physical(Log_Addr addr) { return translate(_pd, addr); }
+
+    private:
+        // The entry of the middle-level table for slot i, which is allocated if create is set. A slot mapped by a 1 GB leaf has none
+        PD_Entry * slot(unsigned int i, bool create) {
+            PD_Entry & root = (*_pd)[i / PT_ENTRIES];
+            if(leaf(root))
+                return 0;
+            if(!root) {
+                if(!create)
+                    return 0;
+                Phy_Addr pt = calloc(1);
+                if(!pt)
+                    return 0;
+                root = phy2pde(pt);
+            }
+            return &(*static_cast<Page_Table *>(pde2phy(root)))[i % PT_ENTRIES];
+        }
+
+        bool used(unsigned int i) {
+            PD_Entry root = (*_pd)[i / PT_ENTRIES];
+            return leaf(root) || (root && (*static_cast<Page_Table *>(pde2phy(root)))[i % PT_ENTRIES]);
+        }
+
+        // Page tables are consecutive frames, while megapages are LARGE_PAGE apart and are leaves themselves
+        bool attach(unsigned int from, const Chunk & chunk) {
+            unsigned int n = chunk.pts();
+            for(unsigned int i = from; i < from + n; i++)
+                if(used(i))
+                    return false;
+            Phy_Addr addr = chunk.pt();
+            for(unsigned int i = from; i < from + n; i++) {
+                PD_Entry * pde = slot(i, true);
+                if(!pde)
+                    return false;
+                if(chunk.large()) {
+                    *pde = phy2pte(addr, chunk.flags());
+                    addr += LARGE_PAGE;
+                } else {
+                    *pde = phy2pde(addr);
+                    addr += sizeof(Page_Table);
+                }
+            }
+            return true;
+        }
+
+        // A single sfence.vma with an address only flushes the page containing it
+        // On multicores, the other harts running threads of this address space flush theirs as well
+        void detach(unsigned int from, unsigned int n) {
+            for(unsigned int i = from; i < from + n; i++)
+                *slot(i, false) = 0;
+            if(multicore)
+                shootdown();
+            else if(_asid)
+                CPU::flush_tlb_asid(_asid);
+            else
+                flush_tlb();
+        }
+
+    private:
+        Page_Directory * _pd;  // this is a physical address, which is also the logical one
+        unsigned int _asid;
+        bool _free;
+    };
+
+    // DMA_Buffer
+    // DMA buffers are contiguous, so they are reached through the identity mapping of RAM
+    class DMA_Buffer: public Chunk
+    {
+    public:
+        DMA_Buffer(unsigned int s) : Chunk(s, Flags::SYS | Flags::CT) {
+            db<MMU>(TRC) << "MMU::DMA_Buffer() => " << *this << endl;
+        }
+
+        DMA_Buffer(unsigned int s, Log_Addr d): Chunk(s, Flags::SYS | Flags::CT) {
+            memcpy(log_address(), d, s);
+            db<MMU>(TRC) << "MMU::DMA_Buffer(phy=" << *this << " <= " << d << endl;
+        }
+
+        Log_Addr log_address() const { return phy2log(phy_address()); }
+
+        // Cache maintenance around zero-copy transfers, of the whole buffer or of the part a transfer used (see
+        // CPU::cache_clean()): clean() before the device reads it, invalidate() before the CPU reads what it wrote
+        void clean() const { CPU::cache_clean(log_address(), size()); }
+        void clean(Log_Addr addr, unsigned int bytes) const { CPU::cache_clean(addr, bytes); }
+        void invalidate() const { CPU::cache_invalidate(log_address(), size()); }
+        void invalidate(Log_Addr addr, unsigned int bytes) const { CPU::cache_invalidate(addr, bytes); }
+        void flush() const { CPU::cache_flush(log_address(), size()); }
+        void flush(Log_Addr addr, unsigned int bytes) const { CPU::cache_flush(addr, bytes); }
+
+        friend OStream & operator<<(OStream & os, const DMA_Buffer & b) {
+            os << "{phy=" << b.phy_address() << ",log=" << b.log_address() << ",size=" << b.size() << ",flags=" << b.flags() << "}";
+            return os;
+        }
+    };
+
+    // Class Translation performs manual logical to physical address translations for debugging purposes only
+    class Translation
+    {
+    public:
+        Translation(Log_Addr addr, bool pt = false, Page_Directory * pd = 0): _addr(addr), _show_pt(pt), _pd(pd) {}
+
+        friend OStream & operator<<(OStream & os, const Translation & t) {
+            Page_Directory * pd = t._pd ? t._pd : current();
+            PD_Entry root = (*pd)[t._addr >> ROOT_SHIFT];
+            os << "{addr=" << static_cast<void *>(t._addr) << ",pd=" << pd << ",pd[" << (t._addr >> ROOT_SHIFT) << "]=" << root;
+            if(root && !leaf(root)) {
+                Page_Table * mid = pde2phy(root);
+                PD_Entry pde = (*mid)[directory(t._addr) % PT_ENTRIES];
+                os << ",mid[" << directory(t._addr) % PT_ENTRIES << "]=" << pde;
+                if(pde && !leaf(pde)) {
+                    Page_Table * pt = pde2phy(pde);
+                    if(t._show_pt)
+                        os << "=>" << pt->log();
+                    os << ",pt[" << page(t._addr) << "]=" << (*pt)[page(t._addr)];
+                }
+            }
+            os << ",f=" << translate(pd, t._addr) << "}";
+            return os;
+        }
+
+    private:
+        Log_Addr _addr;
+        bool _show_pt;
+        Page_Directory * _pd;
+    };
+
+public:
+    Sv39_MMU() {}
+
+    static Phy_Addr alloc(unsigned int frames = 1, Color color = WHITE) {
+        Phy_Addr phy(false);
+
+        if(frames) {
+            List::Element * e = _free.search_decrementing(frames);
+            if(e) {
+                phy = e->object() + e->size();
+                db<MMU>(TRC) << "MMU::alloc(frames=" << frames << ") => " << phy << endl;
+            } else
+                db<MMU>(WRN) << "MMU::alloc(frames=" << frames << ") => failed!" << endl;
+        }
+
+        return phy;
+    }
+
+    // Allocates frames starting at a multiple of align frames (a power of two), giving back the slack around them
+    static Phy_Addr alloc_aligned(unsigned int frames, unsigned int align, Color color = WHITE) {
+        Phy_Addr phy = alloc(frames + align - 1);
+        if(!phy)
+            return phy;
+
+        Phy_Addr aligned = (CPU::Reg(phy) + align * sizeof(Frame) - 1) & ~(align * sizeof(Frame) - 1);
+        unsigned int head = (aligned - phy) / sizeof(Frame);
+        if(head)
+            free(phy, head);
+        if(align - 1 - head)
+            free(aligned + frames * sizeof(Frame), align - 1 - head);
+
+        return aligned;
+    }
+
+    static Phy_Addr calloc(unsigned int frames = 1, Color color = WHITE) {
+        Phy_Addr phy = alloc(frames);
+        if(phy)
+            memset(phy2log(phy), 0, sizeof(Frame) * frames);
+        return phy;
+    }
+
+    static void free(Phy_Addr frame, int n = 1) {
+        frame = indexes(frame);
+
+        db<MMU>(TRC) << "MMU::free(frame=" << frame << ",n=" << n << ")" << endl;
+
+        if(frame && n) {
+            List::Element * e = new (phy2log(frame)) List::Element(frame, n);
+            List::Element * m1, * m2;
+            _free.insert_merging(e, &m1, &m2);
+        }
+    }
+
+    static unsigned int allocable(Color color = WHITE) { return _free.head() ? _free.head()->size() : 0; }
+
+    static Page_Directory * volatile current() { return static_cast<Page_Directory * volatile>(pd()); }
+
+    static Phy_Addr physical(Log_Addr addr) { return translate(current(), addr); }
+
+    static PT_Entry phy2pte(Phy_Addr frame, Page_Flags flags) { return ((CPU::Reg(frame) >> PAGE_SHIFT) << PPN_SHIFT) | flags; }
+    static Phy_Addr pte2phy(PT_Entry entry) { return ((CPU::Reg(entry) >> PPN_SHIFT) & PPN_MASK) << PAGE_SHIFT; }
+    static Page_Flags pte2flg(PT_Entry entry) { return (entry & Page_Flags::MASK); }
+    static PD_Entry phy2pde(Phy_Addr frame) { return ((CPU::Reg(frame) >> PAGE_SHIFT) << PPN_SHIFT) | Page_Flags::V; } // no R, W or X: points to the next level
+    static Phy_Addr pde2phy(PD_Entry entry) { return pte2phy(entry); }
+
+    static Log_Addr phy2log(Phy_Addr phy) { return Log_Addr(CPU::Reg(phy)); }
+    static Phy_Addr log2phy(Log_Addr log) { return Phy_Addr(CPU::Reg(log)); }
+
+    static Color phy2color(Phy_Addr phy) { return WHITE; }
+    static Color log2color(Log_Addr log) { return WHITE; }
+
+    static bool leaf(PT_Entry entry) { return entry & (Page_Flags::R | Page_Flags::W | Page_Flags::X); }
+
+    // Walks the three levels, stopping at 1 GB and 2 MB leaves
+    static Phy_Addr translate(Page_Directory * pd, Log_Addr addr) {
+        PT_Entry e = (*pd)[(addr >> ROOT_SHIFT) % PT_ENTRIES];
+        if(!e)
+            return Phy_Addr(false);
+        if(leaf(e))
+            return pte2phy(e) + (addr & ((1UL << ROOT_SHIFT) - 1));
+        e = (*static_cast<Page_Table *>(pde2phy(e)))[directory(addr) % PT_ENTRIES];
+        if(!e)
+            return Phy_Addr(false);
+        if(leaf(e))
+            return pte2phy(e) + (addr & ((1UL << DIRECTORY_SHIFT) - 1));
+        e = (*static_cast<Page_Table *>(pde2phy(e)))[page(addr)];
+        return e ? pte2phy(e) + offset(addr) : Phy_Addr(false);
+    }
+
+private:
+    static Phy_Addr pd() { return ((CPU::satp() & PPN_MASK) << PAGE_SHIFT); }
+    // Entries tagged with other ASIDs stay in the TLB, while those of ASID 0 might belong to any Directory
+    static void pd(Phy_Addr pd, unsigned int asid = 0) {
+        CPU::satp(SATP_SV39 | (CPU::Reg(asid) << ASID_SHIFT) | (CPU::Reg(pd) >> PAGE_SHIFT));
+        if(!asid)
+            flush_tlb();
+    }
+
+    static unsigned int asid_alloc() {
+        if(asids) {
+            int i = _asids.find_first_clear(1);
+            if((i > 0) && (static_cast<unsigned int>(i) <= _asid_max)) {
+                _asids.set(i);
+                return i;
+            }
+        }
+        return 0;
+    }
+
+    // The TLB entries of a released ASID must go before it is reused, on every hart
+    static void asid_free(unsigned int asid) {
+        if(asid) {
+            if(multicore)
+                shootdown();
+            else
+                CPU::flush_tlb_asid(asid);
+            _asids.reset(asid);
+        }
+    }
+
+    static void flush_tlb() { CPU::flush_tlb(); }
+    static void flush_tlb(Log_Addr addr) { CPU::flush_tlb(addr); }
+
+    // Flushes the TLBs of all harts on multicores (see IPI::shootdown()), or just that of this one
+    static void shootdown();
+
+    static void init();
+
+private:
+    static List _free;
+    static Page_Directory * _master;
+    static Bitmap<ASIDS> _asids;
+    static unsigned int _asid_max; // the largest ASID the hardware implements (found by init())
+};
+
+class MMU: public IF<Traits<MMU>::paged, Sv39_MMU, No_MMU>::Result {};
 
 __END_SYS
 
@@ -18,6 +18,9 @@ class RV64_PMU: public RV32_PMU
 private:
     typedef CPU::Reg Reg;
 
+    // Sscofpmf bits in mhpmevent
+    static const Reg OF = 1UL << 63;    // overflowed (raises LCOFI when it goes up, so it must be cleared to rearm)
+
 public:
     RV64_PMU() {}
 
@@ -32,7 +35,7 @@ public:
         }
 
         if((channel >= FIXED) && (_events[event] != UNSUPORTED_EVENT)) {
-            mhpmevent(_events[event], channel);
+            mhpmevent(_events[event] | ((flags & INT) ? 0 : OF), channel); // OF up keeps overflows from interrupting
             start(channel);
         }
     }
@@ -64,9 +67,19 @@ public:
         write(channel, 0);
     }
 
+    // Only the programmable channels (from FIXED on) can interrupt on overflows, and only on harts with Sscofpmf
+    static void sample(Channel channel, Event event, Count period);
+
+    static bool overflow(Channel channel) { return (channel >= FIXED) && (mhpmevent(channel) & OF); }
+    static void clear_overflow(Channel channel) { if(channel >= FIXED) mhpmevent(mhpmevent(channel) & ~OF, channel); }
+
     static void init() {}
 
 private:
+    static void int_handler(unsigned int i);
+
+    static Count _periods[CHANNELS];
+
     static Reg mcounteren(){ Reg reg; ASM("csrr %0, mcounteren" : "=r"(reg) :); return reg;}
     static void mcounteren(Reg reg){    ASM("csrw mcounteren, %0" : : "r"(reg));}
 
@@ -75,91 +88,91 @@ private:
         switch(channel)
         {
         case 3:
-            ASM("csrr %0, mhpmevent3" : : "r"(reg));
+            ASM("csrr %0, mhpmevent3" : "=r"(reg) :);
             break;
         case 4:
-            ASM("csrr %0, mhpmevent4" : : "r"(reg));
+            ASM("csrr %0, mhpmevent4" : "=r"(reg) :);
             break;
         case 5:
-            ASM("csrr %0, mhpmevent5" : : "r"(reg));
+            ASM("csrr %0, mhpmevent5" : "=r"(reg) :);
             break;
         case 6:
-            ASM("csrr %0, mhpmevent6" : : "r"(reg));
+            ASM("csrr %0, mhpmevent6" : "=r"(reg) :);
             break;
         case 7:
-            ASM("csrr %0, mhpmevent7" : : "r"(reg));
+            ASM("csrr %0, mhpmevent7" : "=r"(reg) :);
             break;
         case 8:
-            ASM("csrr %0, mhpmevent8" : : "r"(reg));
+            ASM("csrr %0, mhpmevent8" : "=r"(reg) :);
             break;
         case 9:
-            ASM("csrr %0, mhpmevent9" : : "r"(reg));
+            ASM("csrr %0, mhpmevent9" : "=r"(reg) :);
             break;
         case 10:
-            ASM("csrr %0, mhpmevent10" : : "r"(reg));
+            ASM("csrr %0, mhpmevent10" : "=r"(reg) :);
             break;
         case 11:
-            ASM("csrr %0, mhpmevent11" : : "r"(reg));
+            ASM("csrr %0, mhpmevent11" : "=r"(reg) :);
             break;
         case 12:
-            ASM("csrr %0, mhpmevent12" : : "r"(reg));
+            ASM("csrr %0, mhpmevent12" : "=r"(reg) :);
             break;
         case 13:
-            ASM("csrr %0, mhpmevent13" : : "r"(reg));
+            ASM("csrr %0, mhpmevent13" : "=r"(reg) :);
             break;
         case 14:
-            ASM("csrr %0, mhpmevent14" : : "r"(reg));
+            ASM("csrr %0, mhpmevent14" : "=r"(reg) :);
             break;
         case 15:
-            ASM("csrr %0, mhpmevent15" : : "r"(reg));
+            ASM("csrr %0, mhpmevent15" : "=r"(reg) :);
             break;
         case 16:
-            ASM("csrr %0, mhpmevent16" : : "r"(reg));
+            ASM("csrr %0, mhpmevent16" : "=r"(reg) :);
             break;
         case 17:
-            ASM("csrr %0, mhpmevent17" : : "r"(reg));
+            ASM("csrr %0, mhpmevent17" : "=r"(reg) :);
             break;
         case 18:
-            ASM("csrr %0, mhpmevent18" : : "r"(reg));
+            ASM("csrr %0, mhpmevent18" : "=r"(reg) :);
             break;
         case 19:
-            ASM("csrr %0, mhpmevent19" : : "r"(reg));
+            ASM("csrr %0, mhpmevent19" : "=r"(reg) :);
             break;
         case 20:
-            ASM("csrr %0, mhpmevent20" : : "r"(reg));
+            ASM("csrr %0, mhpmevent20" : "=r"(reg) :);
             break;
         case 21:
-            ASM("csrr %0, mhpmevent21" : : "r"(reg));
+            ASM("csrr %0, mhpmevent21" : "=r"(reg) :);
             break;
         case 22:
-            ASM("csrr %0, mhpmevent22" : : "r"(reg));
+            ASM("csrr %0, mhpmevent22" : "=r"(reg) :);
             break;
         case 23:
-            ASM("csrr %0, mhpmevent23" : : "r"(reg));
+            ASM("csrr %0, mhpmevent23" : "=r"(reg) :);
             break;
         case 24:
-            ASM("csrr %0, mhpmevent24" : : "r"(reg));
+            ASM("csrr %0, mhpmevent24" : "=r"(reg) :);
             break;
         case 25:
-            ASM("csrr %0, mhpmevent25" : : "r"(reg));
+            ASM("csrr %0, mhpmevent25" : "=r"(reg) :);
             break;
         case 26:
-            ASM("csrr %0, mhpmevent26" : : "r"(reg));
+            ASM("csrr %0, mhpmevent26" : "=r"(reg) :);
             break;
         case 27:
-            ASM("csrr %0, mhpmevent27" : : "r"(reg));
+            ASM("csrr %0, mhpmevent27" : "=r"(reg) :);
             break;
         case 28:
-            ASM("csrr %0, mhpmevent28" : : "r"(reg));
+            ASM("csrr %0, mhpmevent28" : "=r"(reg) :);
             break;
         case 29:
-            ASM("csrr %0, mhpmevent29" : : "r"(reg));
+            ASM("csrr %0, mhpmevent29" : "=r"(reg) :);
             break;
         case 30:
-            ASM("csrr %0, mhpmevent30" : : "r"(reg));
+            ASM("csrr %0, mhpmevent30" : "=r"(reg) :);
             break;
         case 31:
-            ASM("csrr %0, mhpmevent31" : : "r"(reg));
+            ASM("csrr %0, mhpmevent31" : "=r"(reg) :);
             break;
         }
 
@@ -492,6 +505,9 @@ public:
     using Engine::start;
     using Engine::stop;
     using Engine::reset;
+    using Engine::sample;
+    using Engine::overflow;
+    using Engine::clear_overflow;
 
 private:
     static void init() { Engine::init(); }
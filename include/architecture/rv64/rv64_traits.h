@@ -14,18 +14,22 @@ template<> struct Traits<CPU>: public Traits<Build>
     static const unsigned int WORD_SIZE         = 64;
     static const unsigned int CLOCK             = 50000000;
     static const bool unaligned_memory_access   = false;
+    static const unsigned int CACHE_LINE_SIZE   = 64;
 };
 
 template<> struct Traits<MMU>: public Traits<Build>
 {
     static const bool colorful = false;
     static const unsigned int COLORS = 1;
+    static const bool paged = false;        // Sv39 paging (see Sv39_MMU) instead of flat physical memory
+    static const bool large_pages = false;  // map contiguous Segments whose size is a multiple of 2 MB with megapages
+    static const bool asids = false;        // tag TLB entries with an ASID per Directory, so switching needs no flush
 };
 
 template<> struct Traits<FPU>: public Traits<Build>
 {
-    static const bool enabled = false;
-    static const bool user_save = true;
+    static const bool enabled = true;
+    static const bool user_save = false;    // false => switched lazily by the kernel (see CPU::fpu_switch())
 };
 
 template<> struct Traits<TSC>: public Traits<Build>
@@ -35,7 +35,7 @@ public:
     static Hertz frequency() { return CLOCK; }
     static PPB accuracy() { return ACCURACY; }
 
-    static Time_Stamp time_stamp() { return reg(MTIME); }
+    static Time_Stamp time_stamp() { return *reinterpret_cast<volatile CPU::Reg64 *>(Memory_Map::CLINT_BASE + MTIME); } // a single 64-bit load reads MTIME atomically
 
 private:
     static void init() {}
@@ -0,0 +1,89 @@
+// EPOS Energy Meter Declarations
+
+#ifndef __energy_h
+#define __energy_h
+
+#include <architecture.h>
+
+__BEGIN_SYS
+
+// Energy accounting from a linear power model (enabled by Traits<Energy_Meter>::enabled)
+// Each CPU draws STATIC uW plus DYNAMIC uW scaled by CPU::clock() / CPU::max_clock() while running threads, and
+// sleep(s) uW while its idle thread sleeps in state s (HALT, or TICKLESS with the tick stopped, see Alarm::sleep()).
+// Peripherals turned on with on(p) add peripheral(p) uW, charged on CPU 0 only so they are not counted once per CPU.
+// Thread::dispatch() charges the time since each CPU's last charge to the thread leaving it, and the idle thread
+// charges its sleeps to the sleep states instead, so every nJ is either some thread's or some state's.
+class Energy_Meter
+{
+    friend class System;                            // for init()
+    friend class Thread;                            // for dispatch(), sleep() and wake()
+
+public:
+    static const bool enabled = Traits<Energy_Meter>::enabled;
+
+    typedef unsigned long long Energy;              // nJ
+
+    enum State {
+        RUNNING,
+        HALT,
+        TICKLESS,
+        STATES
+    };
+
+private:
+    static const unsigned int CPUS = Traits<Build>::CPUS;
+    static const unsigned int PERIPHERALS = Traits<Energy_Meter>::PERIPHERALS;
+
+    typedef TSC::Time_Stamp Time_Stamp;
+
+public:
+    static void on(unsigned int peripheral) { turn(peripheral, true); }
+    static void off(unsigned int peripheral) { turn(peripheral, false); }
+
+    // Energy spent sleeping in "s" and by everything since the boot, over all CPUs and up to each one's last charge
+    static Energy slept(const State & s);
+    static Energy total();
+
+    // Power (uW) the model gives for "state" right now, without peripherals
+    static unsigned long power(const State & state);
+
+private:
+    // Called with interrupts disabled, so each CPU's accounting has a single writer
+    static void dispatch(Energy * prev) {
+        if(enabled)
+            charge(prev, RUNNING);
+    }
+
+    // Called by the idle thread around CPU::halt(), with its own account for the time it ran before
+    static void sleep(Energy * idle, const State & s) {
+        if(enabled) {
+            bool disabled = CPU::int_disabled();
+            if(!disabled)
+                CPU::int_disable();
+            charge(idle, s);
+            if(!disabled)
+                CPU::int_enable();
+        }
+    }
+
+    static void wake() { sleep(0, RUNNING); }
+
+    // Charges what was drawn since the CPU's last charge to "account" (or the state slept in) and enters "next"
+    static void charge(Energy * account, const State & next);
+
+    static void turn(unsigned int peripheral, bool on);
+
+    static void init();
+
+private:
+    static State _state[CPUS];
+    static Time_Stamp _since[CPUS];
+    static volatile Energy _slept[CPUS][STATES];
+    static volatile Energy _total[CPUS];
+    static volatile unsigned long _peripherals;     // uW
+    static bool _on[PERIPHERALS ? PERIPHERALS : 1];
+};
+
+__END_SYS
+
+#endif
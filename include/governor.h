@@ -0,0 +1,74 @@
+// EPOS DVFS Governor Declarations
+
+#ifndef __governor_h
+#define __governor_h
+
+#include <architecture.h>
+#include <process.h>
+#include <time.h>
+#include <energy.h>
+
+__BEGIN_SYS
+
+// Scales the CPU clock with the scheduler's load (enabled by Traits<Governor>::enabled)
+// Thread::dispatch() accounts for the time each CPU spends running its idle thread and an Alarm on CPU 0 turns it into
+// each CPU's utilization every PERIOD. CPU::clock() is shared by all CPUs of the supported machines, so it follows the
+// busiest one: above UP % it goes straight to CPU::max_clock(), otherwise it is scaled so the load would be TARGET %
+// (ondemand-like), within [CPU::min_clock(), CPU::max_clock()]. Time is measured with the TSC, which keeps its nominal
+// rate through the scaling on every supported machine, as do the timers, so Alarms are not disturbed.
+// With Traits<Energy_Meter>::enabled, the average power drawn over each PERIOD is taken along with the utilization.
+class Governor
+{
+    friend class System;                            // for init()
+    friend class Thread;                            // for dispatch()
+
+public:
+    static const bool enabled = Traits<Governor>::enabled;
+
+private:
+    static const unsigned int CPUS = Traits<Build>::CPUS;
+    static const unsigned int PERIOD = Traits<Governor>::PERIOD;
+    static const unsigned int UP = Traits<Governor>::UP;
+    static const unsigned int TARGET = Traits<Governor>::TARGET;
+
+    typedef TSC::Time_Stamp Time_Stamp;
+
+public:
+    // Utilization (%) of "cpu" over the last PERIOD
+    static unsigned int utilization(unsigned int cpu) { return _utilization[cpu]; }
+
+    // Average power (uW) drawn over the last PERIOD, according to the Energy_Meter (0 without it)
+    static unsigned long power() { return _power; }
+
+private:
+    // Called by Thread::dispatch() with interrupts disabled, so each CPU's accounting has a single writer
+    static void dispatch(bool idle) {
+        if(enabled) {
+            unsigned int cpu = (CPUS > 1) ? CPU::id() : 0;
+            Time_Stamp ts = TSC::time_stamp();
+            if(_idling[cpu])
+                _idle_time[cpu] += ts - _since[cpu];
+            _idling[cpu] = idle;
+            _since[cpu] = ts;
+        }
+    }
+
+    static void govern();
+
+    static void init();
+
+private:
+    static volatile bool _idling[CPUS];
+    static volatile Time_Stamp _since[CPUS];
+    static volatile Time_Stamp _idle_time[CPUS];
+    static Time_Stamp _last_idle_time[CPUS];
+    static Time_Stamp _last;
+    static unsigned int _utilization[CPUS];
+    static Energy_Meter::Energy _last_energy;
+    static unsigned long _power;
+    static Alarm * _alarm;
+};
+
+__END_SYS
+
+#endif
@@ -0,0 +1,46 @@
+// EPOS Interrupt Thread Declarations
+
+#ifndef __interrupt_thread_h
+#define __interrupt_thread_h
+
+#include <process.h>
+#include <synchronizer.h>
+
+__BEGIN_SYS
+
+// Deferred interrupt handling: the IRQ handler installed in IC only acknowledges the interrupt (through
+// the optional "ack" function, which must quiet level-triggered devices) and releases a high-priority
+// thread, which then runs the driver's "bottom half" Handler with interrupts enabled and on its own stack.
+// Interrupts are counted by a semaphore, so none are lost while the bottom half is busy.
+class Interrupt_Thread: public Thread
+{
+public:
+    typedef IC::Interrupt_Id Interrupt_Id;
+    typedef IC::Interrupt_Handler Interrupt_Handler;
+
+public:
+    Interrupt_Thread(const Interrupt_Id & id, Handler * bottom_half, Interrupt_Handler ack = 0, int priority = HIGH,
+                     unsigned int stack_size = STACK_SIZE);
+    ~Interrupt_Thread();
+
+    const Interrupt_Id & id() const { return _id; }
+
+private:
+    static int loop(Interrupt_Thread * t);
+
+    static void top_half(Interrupt_Id id);
+
+private:
+    Interrupt_Id _id;
+    Handler * _bottom_half;
+    Interrupt_Handler _ack;
+    Interrupt_Handler _previous;
+    volatile bool _finish;
+    Semaphore _pending;
+
+    static Interrupt_Thread * _threads[IC::INTS];
+};
+
+__END_SYS
+
+#endif
@@ -0,0 +1,269 @@
+// EPOS Inter-Process Communication Declarations
+
+#ifndef __ipc_h
+#define __ipc_h
+
+#include <architecture.h>
+#include <memory.h>
+#include <synchronizer.h>
+#include <process.h>
+#include <time.h>
+
+__BEGIN_SYS
+
+// Channel
+// A ring of SLOTS descriptors (T, copied by value) from one producer to one consumer, possibly in different address
+// spaces. The ring lives in segment(), which each side attaches to its own Address_Space (at any address) before
+// creating its endpoint with that address. The head is only written by the Producer and the tail only by the Consumer,
+// so the ring takes no locks. A side only blocks, on a Semaphore, when the ring is empty (Consumer) or full
+// (Producer), and the other side only calls v() if it finds the waiting flag set.
+template<typename T, unsigned int SLOTS = 64>
+class Channel
+{
+private:
+    struct Ring
+    {
+        volatile unsigned int head;     // free-running: the next slot is head % SLOTS
+        volatile unsigned int tail;
+        volatile int consumer_waiting;
+        volatile int producer_waiting;
+        T slot[SLOTS];
+    };
+
+    // Indexes wrap around without breaking % SLOTS only if SLOTS divides 2^32
+    static_assert(SLOTS && !(SLOTS & (SLOTS - 1)), "Channel SLOTS must be a power of two");
+
+    // Waits on a semaphore for the condition to change, after telling the other side through the flag.
+    // If the flag is taken back before the other side sees it, there is no v() to wait for.
+    template<typename Condition>
+    static void wait(volatile int & flag, Semaphore & semaphore, Condition condition) {
+        while(condition()) {
+            flag = 1;
+            CPU::fence();
+            if(!condition()) {
+                if(CPU::cas(flag, 1, 0) == 1)
+                    break;
+            }
+            semaphore.p();
+        }
+    }
+
+    static void signal(volatile int & flag, Semaphore & semaphore) {
+        CPU::fence();
+        if(flag && (CPU::cas(flag, 1, 0) == 1))
+            semaphore.v();
+    }
+
+public:
+    class Producer
+    {
+    public:
+        Producer(Channel * channel, void * ring): _channel(channel), _ring(reinterpret_cast<Ring *>(ring)) {}
+
+        void send(const T & message) {
+            db<IPC>(TRC) << "Channel::Producer::send(ring=" << _ring << ")" << endl;
+
+            Ring * ring = _ring;
+            wait(ring->producer_waiting, _channel->_space, [ring]() { return (ring->head - ring->tail) == SLOTS; });
+            put(message);
+        }
+
+        bool try_send(const T & message) {
+            if((_ring->head - _ring->tail) == SLOTS)
+                return false;
+            put(message);
+            return true;
+        }
+
+    private:
+        void put(const T & message) {
+            _ring->slot[_ring->head % SLOTS] = message;
+            CPU::fence(); // the message must be there before the consumer sees the new head
+            _ring->head = _ring->head + 1;
+            signal(_ring->consumer_waiting, _channel->_items);
+        }
+
+    private:
+        Channel * _channel;
+        Ring * _ring;
+    };
+
+    class Consumer
+    {
+    public:
+        Consumer(Channel * channel, void * ring): _channel(channel), _ring(reinterpret_cast<Ring *>(ring)) {}
+
+        T receive() {
+            db<IPC>(TRC) << "Channel::Consumer::receive(ring=" << _ring << ")" << endl;
+
+            Ring * ring = _ring;
+            wait(ring->consumer_waiting, _channel->_items, [ring]() { return ring->head == ring->tail; });
+            return get();
+        }
+
+        bool try_receive(T * message) {
+            if(_ring->head == _ring->tail)
+                return false;
+            *message = get();
+            return true;
+        }
+
+    private:
+        T get() {
+            CPU::fence(); // the message must be read only after the head that published it
+            T message = _ring->slot[_ring->tail % SLOTS];
+            CPU::fence(); // and before the producer can reuse its slot
+            _ring->tail = _ring->tail + 1;
+            signal(_ring->producer_waiting, _channel->_space);
+            return message;
+        }
+
+    private:
+        Channel * _channel;
+        Ring * _ring;
+    };
+
+public:
+    Channel(): _segment(sizeof(Ring)), _items(0), _space(0) {
+        db<IPC>(TRC) << "Channel(slots=" << SLOTS << ",segment=" << &_segment << ") => " << this << endl;
+
+        // The ring is initialized through the system's own mapping of the segment
+        Address_Space as(MMU::current());
+        Ring * ring = as.attach(&_segment);
+        ring->head = ring->tail = 0;
+        ring->consumer_waiting = ring->producer_waiting = 0;
+        as.detach(&_segment);
+    }
+
+    ~Channel() {
+        db<IPC>(TRC) << "~Channel(this=" << this << ")" << endl;
+    }
+
+    Segment * segment() { return &_segment; }
+
+private:
+    Segment _segment;
+    Semaphore _items;
+    Semaphore _space;
+};
+
+
+// Batch
+// A submission queue of up to SLOTS calls to the system, written by a Submitter into segment() (attached, like a
+// Channel's, wherever the caller wants it) and carried out all at once by submit(), in order, so the way into the
+// system is paid once per batch instead of once per call. Only calls that never block can be queued. Threads they wake up or whose priorities
+// they change are only considered when the batch is over (with Traits<Thread>::batching), so the batch is not
+// preempted itself halfway through by each of them.
+template<unsigned int SLOTS = 32>
+class Batch
+{
+public:
+    enum Operation {
+        SEMAPHORE_V,
+        ALARM_RESET,
+        THREAD_PRIORITY,
+        THREAD_RESUME
+    };
+
+    struct Call
+    {
+        unsigned int operation;
+        void * object;
+        int argument;
+    };
+
+private:
+    struct Queue
+    {
+        volatile unsigned int count;
+        Call call[SLOTS];
+    };
+
+public:
+    // Queues calls through the mapping of segment() at "queue" in the caller's Address_Space
+    class Submitter
+    {
+    public:
+        Submitter(Batch * batch, void * queue): _batch(batch), _queue(reinterpret_cast<Queue *>(queue)) {}
+
+        // Each returns false, queuing nothing, if the batch is full
+        bool v(Semaphore * s) { return put(SEMAPHORE_V, s); }
+        bool reset(Alarm * a) { return put(ALARM_RESET, a); }
+        bool priority(Thread * t, int p) { return put(THREAD_PRIORITY, t, p); }
+        bool resume(Thread * t) { return put(THREAD_RESUME, t); }
+
+        unsigned int pending() const { return _queue->count; }
+
+        unsigned int submit() { return _batch->submit(); }
+
+    private:
+        bool put(Operation operation, void * object, int argument = 0) {
+            unsigned int i = _queue->count;
+            if(i == SLOTS)
+                return false;
+            _queue->call[i].operation = operation;
+            _queue->call[i].object = object;
+            _queue->call[i].argument = argument;
+            _queue->count = i + 1;
+            return true;
+        }
+
+    private:
+        Batch * _batch;
+        Queue * _queue;
+    };
+
+public:
+    // The queue is read by submit() through the system's own mapping of the segment
+    Batch(): _segment(sizeof(Queue)) {
+        Address_Space as(MMU::current());
+        _queue = as.attach(&_segment);
+        _queue->count = 0;
+
+        db<IPC>(TRC) << "Batch(slots=" << SLOTS << ",segment=" << &_segment << ") => " << this << endl;
+    }
+
+    ~Batch() {
+        db<IPC>(TRC) << "~Batch(this=" << this << ")" << endl;
+
+        Address_Space as(MMU::current());
+        as.detach(&_segment);
+    }
+
+    Segment * segment() { return &_segment; }
+
+    unsigned int pending() const { return _queue->count; }
+
+    // Carries out the calls queued so far and empties the queue, returning how many there were
+    unsigned int submit() {
+        unsigned int n = _queue->count;
+        if(n > SLOTS) // the count comes from the caller's side
+            n = SLOTS;
+
+        db<IPC>(TRC) << "Batch::submit(this=" << this << ",n=" << n << ")" << endl;
+
+        Thread::batch_begin();
+        for(unsigned int i = 0; i < n; i++) {
+            Call & c = _queue->call[i];
+            switch(c.operation) {
+            case SEMAPHORE_V: reinterpret_cast<Semaphore *>(c.object)->v(); break;
+            case ALARM_RESET: reinterpret_cast<Alarm *>(c.object)->reset(); break;
+            case THREAD_PRIORITY: reinterpret_cast<Thread *>(c.object)->priority(Thread::Criterion(c.argument)); break;
+            case THREAD_RESUME: reinterpret_cast<Thread *>(c.object)->resume(); break;
+            default: db<IPC>(WRN) << "Batch::submit: invalid operation " << c.operation << " at " << i << "!" << endl;
+            }
+        }
+        _queue->count = 0;
+        Thread::batch_end();
+
+        return n;
+    }
+
+private:
+    Segment _segment;
+    Queue * _queue;
+};
+
+__END_SYS
+
+#endif
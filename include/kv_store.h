@@ -0,0 +1,351 @@
+// EPOS Log-Structured Key-Value Store Declarations
+
+#ifndef __kv_store_h
+#define __kv_store_h
+
+#include <utility/hash.h>
+#include <utility/crc.h>
+#include <utility/string.h>
+#include <process.h>
+#include <synchronizer.h>
+
+__BEGIN_SYS
+
+// KV_Store
+// Keeps small values by key in a log over "size" bytes of a non-volatile Storage (e.g. EEPROM) from "base", which only
+// has to offer read(address, data, bytes) and write(address, data, bytes). Values are never rewritten in place: each
+// put() or remove() appends a record (with a CRC) to the head sector of a ring of SECTORS sectors, so all of them get
+// written just as often (wear leveling). Compaction frees the oldest sector (the tail) by moving the records still
+// live in it to the head. An in-RAM index (an Open_Hash) tells where the last record of each key is. It is rebuilt
+// by replaying the log when the store is created, and a record whose CRC doesn't match (e.g. torn by a power failure)
+// ends the replay of its sector. With "background", a LOW priority thread compacts as soon as the ring is down to its
+// last two free sectors, so put() seldom has to compact by itself. One free sector is always kept for compaction.
+template<typename Storage, unsigned int SECTORS = 4, unsigned int KEYS = 32>
+class KV_Store
+{
+public:
+    typedef unsigned short Key;         // 0xffff is reserved
+    typedef unsigned long Address;
+
+private:
+    static const Key ERASED = 0xffff;
+    static const unsigned short MAGIC = 0x4b56;
+    static const unsigned int RESERVED = 1;
+    static const unsigned int VALUE = 256; // largest value
+
+    static_assert(SECTORS >= 2, "KV_Store needs at least two sectors");
+    static_assert(KEYS && !(KEYS & (KEYS - 1)), "KV_Store KEYS must be a power of two");
+
+    struct Sector {
+        unsigned int sequence;          // of the sector in the ring, to tell the tail from the head
+        unsigned short magic;
+        unsigned short crc;
+    } __attribute__((packed));
+
+    struct Record {
+        Key key;
+        unsigned short size;            // 0 for a removal
+        unsigned short crc;             // of the key, the size and the data
+    } __attribute__((packed));
+
+    struct Entry {
+        Address address;                // of the record
+        unsigned short size;
+        bool used;
+    };
+
+public:
+    KV_Store(Storage * storage, Address base, unsigned int size, bool background = true)
+    : _storage(storage), _base(base), _sector(size / SECTORS), _head(SECTORS - 1), _tail(0), _used(0), _sequence(0),
+      _erases(0), _exiting(false), _pending(0), _compactor(0) {
+        db<KV_Store>(TRC) << "KV_Store(base=" << base << ",size=" << size << ",sectors=" << SECTORS << ")" << endl;
+
+        for(unsigned int i = 0; i < KEYS; i++)
+            _entries[i].used = false;
+        mount();
+
+        if(background)
+            _compactor = new (SYSTEM) Thread(Thread::Configuration(Thread::READY, Thread::LOW), &compactor, this);
+    }
+
+    ~KV_Store() {
+        if(_compactor) {
+            _exiting = true;
+            _pending.v();
+            _compactor->join();
+            delete _compactor;
+        }
+    }
+
+    // Copies up to "size" bytes of the value and returns its whole size, or -1 if there is no such key
+    int get(Key key, void * data, unsigned int size) {
+        _lock.lock();
+        Entry * e = _index.search_key(key);
+        int bytes = -1;
+        if(e) {
+            _storage->read(e->address + sizeof(Record), data, (size < e->size) ? size : e->size);
+            bytes = e->size;
+        }
+        _lock.unlock();
+        return bytes;
+    }
+
+    bool put(Key key, const void * data, unsigned int size) {
+        db<KV_Store>(TRC) << "KV_Store::put(key=" << key << ",size=" << size << ")" << endl;
+
+        if((key == ERASED) || !size || (size > VALUE))
+            return false;
+
+        _lock.lock();
+        Entry * e = _index.search_key(key);
+        if(!e)
+            e = entry(key);
+        bool done = false;
+        if(e) {
+            Address a = append(key, data, size);
+            if(a) {
+                if(e->used)
+                    _live[sector(e->address)] -= sizeof(Record) + e->size;
+                e->address = a;
+                e->size = size;
+                e->used = true;
+                done = true;
+            } else if(!e->used)
+                _index.remove_key(key);
+        }
+        _lock.unlock();
+        return done;
+    }
+
+    bool remove(Key key) {
+        db<KV_Store>(TRC) << "KV_Store::remove(key=" << key << ")" << endl;
+
+        _lock.lock();
+        Entry * e = _index.search_key(key);
+        bool done = e && append(key, 0, 0);
+        if(done) {
+            _live[sector(e->address)] -= sizeof(Record) + e->size;
+            e->used = false;
+            _index.remove_key(key);
+        }
+        _lock.unlock();
+        return done;
+    }
+
+    unsigned int free_sectors() const { return SECTORS - _used; }
+    unsigned long erases() const { return _erases; }
+
+private:
+    unsigned int sector(Address a) const { return (a - _base) / _sector; }
+    Address address(unsigned int s) const { return _base + s * _sector; }
+
+    // A new entry for a key that is not in the index yet, already in it but still unused
+    Entry * entry(Key key) {
+        for(unsigned int i = 0; i < KEYS; i++)
+            if(!_entries[i].used)
+                return _index.insert(key, &_entries[i]) ? &_entries[i] : 0;
+        return 0;
+    }
+
+    static unsigned short crc(const Sector & s) { return CRC::crc16(&s, sizeof(Sector) - sizeof(s.crc)); }
+
+    // Erases the sector after the head, which must be free, and turns it into the head
+    void advance() {
+        unsigned int s = (_head + 1) % SECTORS;
+        erase(s);
+
+        Sector h;
+        h.sequence = ++_sequence;
+        h.magic = MAGIC;
+        h.crc = crc(h);
+        _storage->write(address(s), &h, sizeof(Sector));
+
+        if(!_used)
+            _tail = s;
+        _head = s;
+        _fill[s] = sizeof(Sector);
+        _live[s] = 0;
+        _used++;
+        _erases++;
+
+        if(_compactor && (free_sectors() <= RESERVED + 1))
+            _pending.v();
+    }
+
+    void erase(unsigned int s) {
+        unsigned char erased[16];
+        memset(erased, 0xff, sizeof(erased));
+        for(unsigned int i = 0; i < _sector; i += sizeof(erased))
+            _storage->write(address(s) + i, erased, ((_sector - i) < sizeof(erased)) ? _sector - i : sizeof(erased));
+    }
+
+    // Appends a record to the head, opening a new one if needed, and returns its address (0 if there is no room)
+    Address append(Key key, const void * data, unsigned int size, bool compacting = false) {
+        unsigned int bytes = sizeof(Record) + size;
+        if(bytes > _sector - sizeof(Sector))
+            return 0;
+
+        if(!_used || (_fill[_head] + bytes > _sector)) {
+            if(!compacting)
+                for(unsigned int i = 0; (i < SECTORS) && (free_sectors() <= RESERVED); i++)
+                    if(!compact())
+                        break;
+            if(!_used || (_fill[_head] + bytes > _sector)) { // compaction might have left room in the head
+                if(free_sectors() < (compacting ? 1 : RESERVED + 1))
+                    return 0;
+                advance();
+            }
+        }
+
+        Record r;
+        r.key = key;
+        r.size = size;
+        r.crc = CRC::crc16(data, size, CRC::crc16(&r, sizeof(Record) - sizeof(r.crc)));
+
+        Address a = address(_head) + _fill[_head];
+        _storage->write(a + sizeof(Record), data, size);
+        _storage->write(a, &r, sizeof(Record));
+        _fill[_head] += bytes;
+        if(size)
+            _live[_head] += bytes;
+
+        return a;
+    }
+
+    // Moves the records still live in the tail to the head and frees the tail, which can be the head itself
+    bool compact() {
+        if(!_used || ((_tail == _head) && !free_sectors()))
+            return false;
+
+        db<KV_Store>(TRC) << "KV_Store::compact(tail=" << _tail << ",live=" << _live[_tail] << ")" << endl;
+
+        unsigned int t = _tail;
+        if(t == _head)
+            advance();
+
+        unsigned char buffer[VALUE];
+        for(unsigned int i = 0; i < KEYS; i++) {
+            Entry & e = _entries[i];
+            if(!e.used || (sector(e.address) != t))
+                continue;
+
+            Record r;
+            _storage->read(e.address, &r, sizeof(Record));
+            _storage->read(e.address + sizeof(Record), buffer, e.size);
+            Address a = append(r.key, buffer, e.size, true);
+            if(!a)
+                return false; // the tail still has everything
+            e.address = a;
+        }
+
+        // The sector is no longer taken as used when the store is mounted
+        Sector h;
+        memset(&h, 0xff, sizeof(Sector));
+        _storage->write(address(t), &h, sizeof(Sector));
+        _tail = (t + 1) % SECTORS;
+        _used--;
+
+        return true;
+    }
+
+    void mount() {
+        // Sectors with a valid header are the ones in use, contiguous in the ring from the lowest sequence on
+        Sector h[SECTORS];
+        bool valid[SECTORS];
+        unsigned int first = SECTORS;
+        for(unsigned int s = 0; s < SECTORS; s++) {
+            _storage->read(address(s), &h[s], sizeof(Sector));
+            valid[s] = (h[s].magic == MAGIC) && (h[s].crc == crc(h[s]));
+            if(valid[s] && ((first == SECTORS) || (h[s].sequence < h[first].sequence)))
+                first = s;
+        }
+        if(first == SECTORS)
+            return;
+
+        unsigned char buffer[VALUE];
+        for(unsigned int n = 0, s = first; (n < SECTORS) && valid[s]; n++, s = (s + 1) % SECTORS) {
+            if(_used && (h[s].sequence != _sequence + 1))
+                break;
+            if(!_used)
+                _tail = s;
+            _head = s;
+            _sequence = h[s].sequence;
+            _used++;
+            _live[s] = 0;
+
+            Address o = sizeof(Sector);
+            for(Record r; o + sizeof(Record) <= _sector; o += sizeof(Record) + r.size) {
+                _storage->read(address(s) + o, &r, sizeof(Record));
+                if(r.key == ERASED)
+                    break;
+                if((o + sizeof(Record) + r.size > _sector) || (r.size > sizeof(buffer))) {
+                    o = _sector;
+                    break;
+                }
+                _storage->read(address(s) + o + sizeof(Record), buffer, r.size);
+                if(r.crc != CRC::crc16(buffer, r.size, CRC::crc16(&r, sizeof(Record) - sizeof(r.crc)))) {
+                    o = _sector; // nothing else is appended after a torn record
+                    break;
+                }
+
+                Entry * e = _index.search_key(r.key);
+                if(e && e->used)
+                    _live[sector(e->address)] -= sizeof(Record) + e->size;
+                if(!r.size) {
+                    if(e) {
+                        e->used = false;
+                        _index.remove_key(r.key);
+                    }
+                    continue;
+                }
+                if(!e && !(e = entry(r.key))) {
+                    db<KV_Store>(WRN) << "KV_Store::mount: more than " << KEYS << " keys!" << endl;
+                    continue;
+                }
+                e->address = address(s) + o;
+                e->size = r.size;
+                e->used = true;
+                _live[s] += sizeof(Record) + r.size;
+            }
+            _fill[s] = o;
+        }
+
+        db<KV_Store>(INF) << "KV_Store::mount: sectors=" << _tail << ".." << _head << ",keys=" << _index.size() << endl;
+    }
+
+    static int compactor(KV_Store * store) {
+        while(true) {
+            store->_pending.p();
+            if(store->_exiting)
+                break;
+            store->_lock.lock();
+            for(unsigned int i = 0; (i < SECTORS) && (store->free_sectors() <= RESERVED + 1); i++)
+                if(!store->compact())
+                    break;
+            store->_lock.unlock();
+        }
+        return 0;
+    }
+
+private:
+    Storage * _storage;
+    Address _base;
+    unsigned int _sector;
+    unsigned int _head;
+    unsigned int _tail;
+    unsigned int _used;
+    unsigned int _sequence;
+    unsigned long _erases;
+    unsigned int _fill[SECTORS];        // bytes written to each sector
+    unsigned int _live[SECTORS];        // bytes of each sector in records still in the index
+    Entry _entries[KEYS];
+    Open_Hash<Entry, KEYS * 2, Key> _index;
+    volatile bool _exiting;
+    Mutex _lock;
+    Semaphore _pending;
+    Thread * _compactor;
+};
+
+__END_SYS
+
+#endif
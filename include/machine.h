@@ -7,6 +7,7 @@
 #include <machine/machine.h>
 #include <machine/ic.h>
 #include <machine/timer.h>
+#include <machine/ipi.h>
 
 // This components have software equivalents in case the machine does not provide them
 #include <machine/aes.h>
@@ -40,8 +41,14 @@
 #ifdef __ADC_H
 #include <machine/adc.h>
 #endif
+#ifdef __TRNG_H
+#include <machine/trng.h>
+#endif
 #ifdef __KEYBOARD_H
 #include <machine/keyboard.h>
 #endif
+#ifdef __NIC_H
+#include <machine/nic.h>
+#endif
 
 #endif
@@ -4,6 +4,7 @@
 #define __adc_h
 
 #include <system/config.h>
+#include <utility/handler.h>
 
 __BEGIN_SYS
 
@@ -25,6 +26,11 @@ protected:
 public:
     unsigned int read();
     unsigned int convert(unsigned short reading, unsigned int reference);
+
+    void start(const Hertz & frequency, unsigned char * buffer, unsigned int samples, Handler * handler);
+    void stop();
+    unsigned char * filled() const;
+    unsigned int halves() const;
 };
 
 __END_SYS
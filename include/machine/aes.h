@@ -13,6 +13,7 @@ public:
     enum Mode {
         ECB,
         CBC,
+        CTR,
     };
 
 protected:
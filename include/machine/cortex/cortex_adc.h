@@ -28,6 +28,11 @@ public:
     using Engine::read;
     using Engine::convert;
 
+    using Engine::start;
+    using Engine::stop;
+    using Engine::filled;
+    using Engine::halves;
+
 private:
     using Engine::init;
 };
@@ -0,0 +1,131 @@
+// EPOS ARM Cortex FPGA Mediator Declarations
+
+#ifndef __cortex_fpga_h
+#define __cortex_fpga_h
+
+#include <architecture/cpu.h>
+#include <architecture/mmu.h>
+#include <machine/ic.h>
+#include <machine/fpga.h>
+#include <machine/cortex/engine/cortex_a9/axi_dma.h>
+
+__BEGIN_SYS
+
+class Semaphore;
+
+// Zynq PL streaming through an AXI DMA (S2MM, scatter-gather)
+// The PL design streams into a ring of blocks cut from a single DMA_Buffer, one SG descriptor per block, so data gets
+// to memory without CPU copies. Each completed block wakes a consumer blocked on receive(), which gets the Block in
+// place and gives it back with free(). Blocks go back to the DMA in ring order (one free()d early waits for those
+// before it), by moving the tail descriptor. While all blocks are held, the DMA idles and the stream is throttled by
+// AXI backpressure (see Statistics::stalls). Descriptors take cache lines of their own and blocks take whole lines,
+// which are invalidated before the host reads what the DMA wrote.
+class FPGA: private FPGA_Common
+{
+    friend class Machine;
+
+private:
+    // Type Imports
+    typedef CPU::Reg32 Reg32;
+    typedef CPU::Log_Addr Log_Addr;
+    typedef CPU::Phy_Addr Phy_Addr;
+    typedef MMU::DMA_Buffer DMA_Buffer;
+    typedef AXI_DMA::SG_Desc SG_Desc;
+
+    // Traits
+    static const unsigned int BLOCKS = Traits<FPGA>::BLOCKS;
+    static const unsigned int BLOCK_SIZE = Traits<FPGA>::BLOCK_SIZE;
+    static const unsigned int IRQ_THRESHOLD = Traits<FPGA>::IRQ_THRESHOLD;
+    static const unsigned int IRQ_DELAY = Traits<FPGA>::IRQ_DELAY;
+    static const unsigned int PL_IRQ = Traits<FPGA>::PL_IRQ;
+
+    static const unsigned int LINE = Traits<CPU>::CACHE_LINE_SIZE;
+
+    static_assert(BLOCKS >= 2, "AXI DMA rings must have at least two blocks");
+    static_assert(BLOCK_SIZE && !(BLOCK_SIZE % LINE), "AXI DMA blocks must take whole cache lines");
+    static_assert(BLOCK_SIZE < (1U << Traits<FPGA>::LENGTH_WIDTH), "AXI DMA blocks must fit the IP's buffer length register");
+    static_assert(PL_IRQ < 16, "Zynq has 16 PL to PS interrupts");
+
+    static const unsigned int RING_SIZE = BLOCKS * sizeof(SG_Desc);
+    static const unsigned int DMA_BUFFER_SIZE = RING_SIZE + BLOCKS * BLOCK_SIZE;
+
+    // State of each descriptor and its Block
+    enum {
+        CHIP,   // given to the DMA, which may be filling it
+        FULL,   // completed by the DMA, waiting for receive()
+        HOST,   // received, the Block is in use
+        DONE    // free()d, waiting for the Blocks before it to be given back to the DMA
+    };
+
+public:
+    typedef AXI_DMA Engine;
+
+    class Block
+    {
+        friend class FPGA;
+
+    public:
+        const void * data() const { return _data; }
+        void * data() { return _data; }
+        unsigned int size() const { return _size; }
+        bool last() const { return _last; } // ends a packet (TLAST) of the stream
+
+        friend Debug & operator<<(Debug & db, const Block & b) {
+            db << "{data=" << b._data << ",size=" << b._size << ",last=" << b._last << "}";
+            return db;
+        }
+
+    private:
+        Log_Addr _data;
+        unsigned int _size;
+        bool _last;
+    };
+
+    struct Statistics {
+        unsigned int blocks;
+        unsigned long long bytes;
+        unsigned int errors;
+        unsigned int stalls;     // blocks given back to an idle DMA, i.e. the ring was full and the stream was held
+    };
+
+public:
+    FPGA() {}
+
+    // Restarts the DMA on an empty ring. Blocks not yet received are dropped, so no Block may be held across it.
+    static void reset();
+
+    static Block * receive();
+    static void free(Block * b);
+
+    static const Statistics & statistics() { return _statistics; }
+
+    static void int_handler(IC::Interrupt_Id interrupt);
+
+private:
+    static void handle_int();
+
+    static bool lock();
+    static void unlock(bool ie);
+
+    static Phy_Addr phy(const void * log) { return _dma_buf->phy_address() + (Log_Addr(log) - _dma_buf->log_address()); }
+
+    static void init();
+
+private:
+    static AXI_DMA * _dma;
+    static IC::Interrupt_Id _interrupt;
+    static DMA_Buffer * _dma_buf;
+    static SG_Desc * _ring;
+    static Block _blocks[BLOCKS];
+    static unsigned char _state[BLOCKS];
+    static unsigned int _head;  // next descriptor the DMA will complete
+    static unsigned int _next;  // next Block receive() will return
+    static unsigned int _tail;  // last descriptor given to the DMA
+    static Semaphore * _ready;  // Blocks completed and not yet received
+    static Statistics _statistics;
+    static volatile int _lock;
+};
+
+__END_SYS
+
+#endif
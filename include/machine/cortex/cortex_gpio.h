@@ -4,29 +4,56 @@
 #define __cortex_gpio_h
 
 #include <architecture/cpu.h>
+#include <architecture/tsc.h>
 #include <machine/gpio.h>
 #include <machine/ic.h>
 #include __HEADER_MMOD(gpio)
 #include <utility/observer.h>
+#include <utility/buffer.h>
 
 __BEGIN_SYS
 
+class Thread;
+class Semaphore;
+
+// GPIO
+// Pins with an interrupt edge notify their observers from the ISR, once per edge. With Traits<GPIO>::queued, the ISR
+// only records each edge (TSC time stamp and the level read right after it) into the pin's lock-free ring, and a thread
+// notifies the observers of the pins with pending edges in batches: once BATCH edges are pending or LATENCY after the
+// first one. Observers take the batch with event() from update(). Edges they don't take stay queued, and edges that
+// find the ring full are dropped and counted by lost().
 class GPIO: public GPIO_Engine, public Observed
 {
     friend class Machine; // for init()
     friend class IC; // for eoi()
+    friend class PWM; // for _port and _pin
 
 private:
     typedef GPIO_Engine Engine;
 
+    static const bool queued = Traits<GPIO>::queued;
+    static const unsigned int EVENTS = Traits<GPIO>::EVENTS;
+    static const unsigned int BATCH = Traits<GPIO>::BATCH;
+    static const unsigned int LATENCY = Traits<GPIO>::LATENCY;
+
 public:
     typedef _UTIL::Observed Observed;
     typedef _UTIL::Observer Observer;
 
+    struct Event {
+        TSC::Time_Stamp time;
+        bool level;
+    };
+
+private:
+    typedef SPSC_Circular_Buffer<Event, queued ? EVENTS : 1> Ring;
+
 public:
     GPIO(Port port, Pin pin, Direction dir, Pull pull = UP, Edge int_edge = NONE)
-    : Engine(port, pin, dir, pull, int_edge), _port(port), _pin(pin) {
+    : Engine(port, pin, dir, pull, int_edge), _port(port), _pin(pin), _lost(0) {
         if(int_edge != NONE) {
+            if(queued)
+                start();
             _gpios[_port][_pin] = this;
             IC::Interrupt_Id i = IC::INT_GPIOA + _port;
             IC::disable(i);
@@ -53,17 +80,31 @@ public:
     using Engine::int_enable;
     using Engine::int_disable;
 
+    // Queued mode only, from the observers' update()
+    bool event(Event * e) { return _events.remove(e); }
+    unsigned int lost() const { return _lost; }
+
 private:
     using Engine::init;
 
+    void record();
+
+    static void start();
+    static int deliver();
+
     static void int_handler(IC::Interrupt_Id i);
     static void eoi(IC::Interrupt_Id i);
 
 private:
     Port _port;
     Pin _pin;
+    Ring _events;
+    volatile unsigned int _lost;
 
     static GPIO * _gpios[PORTS][8];
+    static Thread * _deliverer;
+    static Semaphore * _pending;
+    static volatile unsigned int _batch; // edges recorded since the last batch was delivered
 };
 
 __END_SYS
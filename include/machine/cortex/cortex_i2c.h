@@ -18,6 +18,7 @@ private:
 public:
     using I2C_Common::MASTER;
     using I2C_Common::SLAVE;
+    using I2C_Common::Transaction;
 
 public:
     I2C(unsigned int unit = 0, const Role & role = MASTER): I2C_Engine(unit, role) {}
@@ -28,6 +29,9 @@ public:
     using Engine::read;
     using Engine::write;
 
+    using Engine::submit;
+    using Engine::transfer;
+
     using Engine::flush;
     using Engine::ready_to_get;
     using Engine::ready_to_put;
@@ -12,11 +12,25 @@ __BEGIN_SYS
 class IC: private IC_Engine
 {
     friend class Machine;
+    friend class Thread;
 
 private:
     typedef IC_Engine Engine;
     typedef CPU::Reg32 Reg32;
 
+    static const unsigned int CPUS = Traits<Machine>::CPUS;
+    static const unsigned int STACK_SIZE = Traits<IC>::STACK_SIZE;
+    static_assert(!(STACK_SIZE % 16), "interrupt stacks must keep SP 16-byte aligned");
+    static const bool deferring = STACK_SIZE || Traits<IC>::deferred; // handlers' reschedules wait for stacked()
+
+    // With static vectors, the handlers are bound at compile time (see bound()) and the tables are in .rodata (i.e.
+    // flash), so they take no RAM nor initialization. int_vector() then only checks the bindings.
+#ifdef __cortex_m__
+    static const bool static_vectors = Traits<IC>::static_vectors;
+#else
+    static const bool static_vectors = false;
+#endif
+
 public:
     using Engine::INTS;
     using Engine::EXCS;
@@ -40,26 +54,35 @@ public:
     using Engine::INT_NIC0_TX;
     using Engine::INT_NIC0_ERR;
     using Engine::INT_NIC0_TIMER;
+    using Engine::INT_PMU;
+    using Engine::INT_RESCHEDULER;
 
 public:
     IC() {}
 
     static Interrupt_Handler int_vector(Interrupt_Id i) {
         assert(i < INTS);
-        return _int_vector[i];
+        return handler(i);
     }
 
     static void int_vector(Interrupt_Id i, const Interrupt_Handler & h) {
         db<IC>(TRC) << "IC::int_vector(int=" << i << ",h=" << reinterpret_cast<void *>(h) <<")" << endl;
         assert(i < INTS);
-        _int_vector[i] = h;
+        if(static_vectors)
+            check(i, h, eoi(i));
+        else
+            _int_vector[i] = h;
     }
 
     static void int_vector(Interrupt_Id i, const Interrupt_Handler & ih, const Interrupt_Handler & eh) {
         db<IC>(TRC) << "IC::int_vector(int=" << i << ",ih=" << reinterpret_cast<void *>(ih) << ",ih=" << reinterpret_cast<void *>(eh) << ")" << endl;
         assert(i < INTS);
-        _int_vector[i] = ih;
-        _eoi_vector[i] = eh;
+        if(static_vectors)
+            check(i, ih, eh);
+        else {
+            _int_vector[i] = ih;
+            _eoi_vector[i] = eh;
+        }
     }
 
     static void enable() {
@@ -82,6 +105,27 @@ public:
         Engine::disable(i);
     }
 
+    // Priorities go from 1 to PRIORITIES (higher is more urgent) and only interrupts of priority above the current level
+    // are taken. With Traits<IC>::nested, dispatch() raises the level to the priority of the interrupt being handled.
+    using Engine::PRIORITIES;
+
+    static void priority(Interrupt_Id i, unsigned int p) {
+        db<IC>(TRC) << "IC::priority(int=" << i << ",p=" << p << ")" << endl;
+        assert((i < INTS) && (p <= PRIORITIES));
+        Engine::priority(i, p);
+    }
+    static unsigned int priority(Interrupt_Id i) { return Engine::priority(i); }
+
+    // Steers an interrupt to the CPUs in "cpus" (bit n for CPU n), if the engine can route it
+    static bool affinity(Interrupt_Id i, unsigned long cpus) {
+        db<IC>(TRC) << "IC::affinity(int=" << i << ",cpus=" << cpus << ")" << endl;
+        assert(i < INTS);
+        return Engine::affinity(i, cpus & ((1UL << CPUS) - 1));
+    }
+
+    static void level(unsigned int l) { Engine::level(l); }
+    static unsigned int level() { return Engine::level(); }
+
     using Engine::int_id;
     using Engine::irq2int;
     using Engine::int2irq;
@@ -98,6 +142,18 @@ private:
 #else
     static void dispatch();
 #endif
+    static void serve(Interrupt_Id i);
+    static void stacked(Interrupt_Id i);
+
+    // Called by Thread::reschedule() to know if it must leave the context switch to stacked(), since a thread switched
+    // out from the interrupt stack would have its handler's frames overwritten by the next interrupt (and, with
+    // Traits<IC>::deferred, so a burst of wakeups in the outermost handler and those nested in it switches only once)
+    static bool defer_reschedule() {
+        if(!deferring || !_nesting[CPU::id()])
+            return false;
+        _rescheduling[CPU::id()] = true;
+        return true;
+    }
 
     // ARMv7 exception handlers are physical, ARMv8 are logical
 
@@ -123,11 +179,29 @@ private:
 
     static void kill();
 
+    static Interrupt_Handler handler(Interrupt_Id i) { return static_vectors ? _bound.handler[i] : _int_vector[i]; }
+    static Interrupt_Handler eoi(Interrupt_Id i) { return static_vectors ? _bound.eoi[i] : _eoi_vector[i]; }
+
+    // The compile-time bindings (with static_vectors) and the tables made of them
+    struct Vectors {
+        Interrupt_Handler handler[static_vectors ? INTS : 1];
+        Interrupt_Handler eoi[static_vectors ? INTS : 1];
+    };
+
+    static constexpr Interrupt_Handler bound(Interrupt_Id i);
+    static constexpr Interrupt_Handler bound_eoi(Interrupt_Id i);
+    static constexpr Vectors bind();
+    static void check(Interrupt_Id i, const Interrupt_Handler & ih, const Interrupt_Handler & eh);
+
     static void init();
 
 private:
-    static Interrupt_Handler _int_vector[INTS];
-    static Interrupt_Handler _eoi_vector[INTS];
+    static Interrupt_Handler _int_vector[static_vectors ? 1 : INTS];
+    static Interrupt_Handler _eoi_vector[static_vectors ? 1 : INTS];
+    static const Vectors _bound;
+    static unsigned int _nesting[CPUS];
+    static bool _rescheduling[CPUS];
+    static char _stack[CPUS][STACK_SIZE];
 };
 
 __END_SYS
@@ -26,6 +26,10 @@ public:
 
     using Engine::delay;
     using Engine::clear_bss;
+    using Engine::temperature;
+#ifdef __emote3__
+    using Engine::hibernate;
+#endif
 
     static void panic();
 
@@ -0,0 +1,159 @@
+// EPOS ARM Cortex NIC Mediators Declarations
+
+#ifndef __cortex_nic_h
+#define __cortex_nic_h
+
+#include <architecture/cpu.h>
+#include <architecture/mmu.h>
+#include <machine/ic.h>
+#include <machine/cortex/engine/cortex_a9/gem.h>
+#include <network/ethernet.h>
+#include <utility/handler.h>
+
+__BEGIN_SYS
+
+class Interrupt_Thread;
+
+// Zynq GEM Ethernet NIC
+// RX and TX rings and the buffers are cut from a single DMA_Buffer per unit. As with PCNet32, each RX descriptor is
+// bound to a Buffer for good, so frames are received in place and handed up (see NIC) without being copied, and TX
+// Buffers are taken from a pool by alloc() and bound to the next TX descriptor, in ring order, by send().
+// The rings are in cacheable memory, so the host never writes a cache line the chip may be writing: RX descriptors go
+// back to the chip a line (four descriptors) at a time, once all of their Buffers are free()d, and TX descriptors are
+// reclaimed by the chip's position in the ring instead of by their USED bits, which a later clean of their line may
+// take back (the chip never runs past the USED descriptor send() leaves after the last frame, so that is harmless).
+// Buffers take whole cache lines, which are cleaned before the chip reads them and invalidated before the host reads
+// what the chip wrote. TX completions don't interrupt: TX Buffers are reclaimed on demand. RX interrupts are coalesced
+// by Traits<Ethernet>::polled, as with PCNet32 (the r1p23 GEM has no interrupt moderation timer), and with
+// Traits<Ethernet_NIC>::offloaded the chip fills in and verifies IP, UDP and TCP checksums (see NIC::offloads()).
+class Ethernet_NIC: public NIC<Ethernet>
+{
+    friend class Machine_Common; // for init()
+
+private:
+    // Type Imports
+    typedef CPU::Reg32 Reg32;
+    typedef CPU::Log_Addr Log_Addr;
+    typedef CPU::Phy_Addr Phy_Addr;
+    typedef MMU::DMA_Buffer DMA_Buffer;
+    typedef GEM::Rx_Desc Rx_Desc;
+    typedef GEM::Tx_Desc Tx_Desc;
+
+    // Traits
+    static const unsigned int UNITS = Traits<Ethernet_NIC>::UNITS;
+    static const unsigned int TX_BUFS = Traits<Ethernet_NIC>::SEND_BUFFERS;
+    static const unsigned int RX_BUFS = Traits<Ethernet_NIC>::RECEIVE_BUFFERS;
+    static const bool promiscuous = Traits<Ethernet_NIC>::promiscuous;
+    static const bool offloaded = Traits<Ethernet_NIC>::offloaded;
+    static const bool polled = Traits<Ethernet>::polled;
+    static const unsigned int POLL_BUDGET = Traits<Ethernet>::POLL_BUDGET;
+
+    static const unsigned int LINE = Traits<CPU>::CACHE_LINE_SIZE;
+    static const unsigned int RX_PER_LINE = LINE / sizeof(Rx_Desc);
+    static const unsigned int TX_RING = TX_BUFS + 1; // one more than the frames that can be sent at once
+
+    static_assert(UNITS <= 2, "Zynq has two GEMs");
+    static_assert(RX_BUFS && !(RX_BUFS & (RX_BUFS - 1)) && (RX_BUFS >= RX_PER_LINE), "GEM RX rings must be powers of two of at least a cache line of descriptors");
+    static_assert(TX_BUFS >= 1, "GEM TX rings must have at least one buffer");
+
+    // The chip is told RX buffers take 1536 bytes, but it discards frames longer than 1518 bytes and doesn't copy their
+    // FCS, so the rest of the Buffer after the Frame (i.e. 1514 bytes, plus the word padding) is never written
+    static const unsigned int RX_BUFFER_SIZE = 1536;
+    static_assert(sizeof(Frame) >= ((HEADER_SIZE + MTU + 3) & ~3), "GEM would write past the end of the frame");
+
+    // Sizes of the pieces of the DMA_Buffer, each in whole cache lines
+    static const unsigned int RX_RING_SIZE = (RX_BUFS * sizeof(Rx_Desc) + LINE - 1) & ~(LINE - 1);
+    static const unsigned int TX_RING_SIZE = (TX_RING * sizeof(Tx_Desc) + LINE - 1) & ~(LINE - 1);
+    static const unsigned int BUFFER_SIZE = (sizeof(Buffer) + LINE - 1) & ~(LINE - 1);
+    static const unsigned int DMA_BUFFER_SIZE = RX_RING_SIZE + TX_RING_SIZE + (RX_BUFS + TX_BUFS) * BUFFER_SIZE;
+
+    // State of each RX descriptor and its Buffer
+    enum {
+        CHIP,   // given to the chip, which may be filling it
+        HOST,   // taken by the host, the Buffer is in use
+        DONE    // free()d, waiting for the rest of its cache line to be given back to the chip
+    };
+
+    // Interrupt dispatching binding
+    struct Device {
+        Ethernet_NIC * device;
+        IC::Interrupt_Id interrupt;
+    };
+
+protected:
+    Ethernet_NIC(unsigned int unit, GEM * gem, const IC::Interrupt_Id & irq, DMA_Buffer * dma);
+
+public:
+    ~Ethernet_NIC();
+
+    int send(const Address & dst, const Protocol & prot, const void * data, unsigned int size);
+    int receive(Address * src, Protocol * prot, void * data, unsigned int size);
+
+    Buffer * alloc(const Address & dst, const Protocol & prot, unsigned int payload);
+    int send(Buffer * buf);
+    void free(Buffer * buf);
+
+    const Address & address() { return _address; }
+    const Statistics & statistics() { return _statistics; }
+    unsigned int offloads() { return offloaded ? (TX_IP_CHECKSUM | TX_L4_CHECKSUM | RX_IP_CHECKSUM | RX_L4_CHECKSUM) : 0; }
+
+    void reset();
+
+    void attach(Observer * o, const Protocol & p);
+
+    static Ethernet_NIC * get(unsigned int unit = 0) { return (unit < UNITS) ? _devices[unit].device : 0; }
+
+private:
+    Reg32 link();
+
+    Buffer * take();
+    void reclaim();
+    void recycle(Buffer * buf);
+    Reg32 acknowledge();
+    unsigned int deliver(unsigned int budget);
+    void poll();
+    void handle_int();
+
+    bool lock();
+    void unlock(bool ie);
+
+    Phy_Addr phy(const void * log) const { return _dma_buf->phy_address() + (Log_Addr(log) - _dma_buf->log_address()); }
+
+    static void int_handler(IC::Interrupt_Id interrupt);
+    static void int_ack(IC::Interrupt_Id interrupt);
+    static void bottom_half(Ethernet_NIC * dev);
+
+    static void init(unsigned int unit);
+
+private:
+    unsigned int _unit;
+    GEM * _gem;
+    IC::Interrupt_Id _interrupt;
+    Address _address;
+    Statistics _statistics;
+    volatile int _lock;
+    int _phy;               // PHY address, -1 if none answers
+
+    DMA_Buffer * _dma_buf;
+    Rx_Desc * _rx_ring;
+    Tx_Desc * _tx_ring;
+
+    unsigned int _rx_cur;   // next RX descriptor the chip will fill
+    unsigned int _tx_cur;   // next TX descriptor to be given to the chip (USED, so the chip stops there)
+    unsigned int _tx_clean; // oldest TX descriptor not yet reclaimed
+    unsigned int _tx_pending;
+
+    Buffer * _rx_buffer[RX_BUFS];
+    unsigned char _rx_state[RX_BUFS];
+    Buffer * _tx_buffer[TX_BUFS];
+    Buffer * _tx_sent[TX_RING]; // the Buffer each TX descriptor is sending
+
+    Functor_Handler<Ethernet_NIC> _bottom_half;
+    Interrupt_Thread * _poller;
+
+    static Device _devices[UNITS];
+};
+
+__END_SYS
+
+#endif
@@ -3,26 +3,36 @@
 #ifndef __cortex_pwm_h
 #define __cortex_pwm_h
 
-#include <timer.h>
-#include <gpio.h>
-#include __MODEL_H
+#include <machine/timer.h>
+#include <machine/gpio.h>
+#include <machine/pwm.h>
+#include __HEADER_MMOD(pwm)
 
 __BEGIN_SYS
 
-class PWM: private PWM_Common, private Machine_Model
+class PWM: private PWM_Engine
 {
+private:
+    typedef PWM_Engine Engine;
+
+public:
+    using Engine::Count;
+    using Engine::DMA_Buffer;
+
 public:
     PWM(User_Timer * timer, GPIO * gpio, const Percent & duty_cycle)
-    : _gpio(gpio), _timer(timer) {
-        _timer->disable();
-        enable_pwm(_timer->_channel, _gpio->_port, _gpio->_pin);
-        _timer->pwm(duty_cycle);
-    }
-    ~PWM() { disable_pwm(_timer->_channel, _gpio->_port, _gpio->_pin); }
-
-    void duty_cycle(const Percent & d) { _timer->pwm(d); }
-    void enable() { _timer->enable(); }
-    void disable() { _timer->disable(); }
+    : Engine(timer->_channel, gpio->_port, gpio->_pin, duty_cycle), _gpio(gpio), _timer(timer) {}
+
+    using Engine::duty_cycle;
+    using Engine::enable;
+    using Engine::disable;
+
+    using Engine::count;
+    using Engine::play;
+    using Engine::stop;
+    using Engine::refill;
+    using Engine::halves;
+
     void power(const Power_Mode & mode) { _timer->power(mode); }
 
 private:
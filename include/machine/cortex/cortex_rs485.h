@@ -16,6 +16,8 @@ private:
     typedef RS485_Engine Transceiver;
     typedef UART Engine;
 
+    static const bool dma = Traits<RS485>::dma;
+
     static const unsigned int UNIT = Traits<UART>::DEF_UNIT;
     static const unsigned int BAUD_RATE = Traits<UART>::DEF_BAUD_RATE;
     static const unsigned int DATA_BITS = Traits<UART>::DEF_DATA_BITS;
@@ -24,13 +26,25 @@ private:
 
 public:
     RS485(unsigned int unit = UNIT, unsigned int baud_rate = BAUD_RATE, unsigned int data_bits = DATA_BITS, unsigned int parity = PARITY, unsigned int stop_bits = STOP_BITS)
-    : Engine(unit, baud_rate, data_bits, parity, stop_bits) {}
+    : Engine(unit, baud_rate, data_bits, parity, stop_bits), Transceiver(unit) {}
 
     void config(unsigned int baud_rate, unsigned int data_bits, unsigned int parity, unsigned int stop_bits) {
         Engine::config(baud_rate, data_bits, parity, stop_bits);
+        Transceiver::framing();
     }
 
+    // With Traits<RS485>::dma, read() takes the next complete frame, if any, and write() sends one
     int read(char * data, unsigned int size) {
+        if(dma) {
+            Frame * f = Transceiver::try_receive();
+            if(!f)
+                return 0;
+            unsigned int n = (f->length < size) ? f->length : size;
+            memcpy(data, f->data, n);
+            Transceiver::free(f);
+            return n;
+        }
+
         char * d = data;
         unsigned int s = 0;
 
@@ -44,6 +58,9 @@ public:
     }
 
     int write(const char * data, unsigned int size) {
+        if(dma)
+            return Transceiver::send(data, size);
+
         const char * d = data;
         unsigned int s = 0;
 
@@ -56,6 +73,14 @@ public:
         return s;
     }
 
+    // Frame-level operation (Traits<RS485>::dma): frames received are taken with receive() and given back with free()
+    using Transceiver::Frame;
+    using Transceiver::send;
+    using Transceiver::receive;
+    using Transceiver::try_receive;
+    using Transceiver::free;
+    using Transceiver::dropped;
+
     using Engine::flush;
     using Engine::ready_to_get;
     using Engine::ready_to_put;
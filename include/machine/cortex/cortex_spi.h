@@ -15,6 +15,9 @@ class SPI: private SPI_Engine
 private:
     typedef SPI_Engine Engine;
 
+public:
+    using Engine::Transaction;
+
 public:
     SPI(unsigned int unit, unsigned int clock, const Protocol & protocol, const Mode & mode, unsigned int bit_rate, unsigned int data_bits)
     : Engine(unit, clock, protocol, mode, bit_rate, data_bits) {}
@@ -33,6 +36,9 @@ public:
     using Engine::int_enable;
     using Engine::int_disable;
 
+    using Engine::submit;
+    using Engine::transfer;
+
     using Engine::power;
 
 private:
@@ -4,6 +4,7 @@
 #define __cortex_timer_h
 
 #include <architecture/cpu.h>
+#include <architecture/tsc.h>
 #include <machine/ic.h>
 #include <machine/timer.h>
 #include __HEADER_MMOD(timer)
@@ -66,10 +67,36 @@ public:
 
     void handler(const Handler & handler) { _handler = handler; }
 
+#ifdef __emote3__
+    // Tickless idle: SysTick stops while the CPU sleeps in the deepest power mode the time to the next alarm allows (see
+    // System_Timer_Engine::sleep()). The first interrupt afterwards (see IC::dispatch()), the sleep timer's at the latest,
+    // accounts for the periods that went by according to the sleep timer and reports them through skipped()
+    static void sleep(const Tick & ticks);
+    static bool sleeping() { return _sleeping; }
+    static Tick skipped() { return _skipped; }
+#else
+    // Tickless operation is not supported (yet) by this timer: ticks are never suppressed
+    static void sleep(const Tick & ticks) {}
+    static bool sleeping() { return false; }
+    static Tick skipped() { return 0; }
+#endif
+
+    // Neither is one-shot operation (see Alarm::hires)
+    static const bool ONE_SHOT = false;
+    static const bool LOCAL = false; // only core 0 serves the ALARM channel
+    static void one_shot(const TSC_Common::Time_Stamp & deadline, const Handler & handler) {}
+
 private:
     static void int_handler(Interrupt_Id i);
     static void eoi(Interrupt_Id i);
 
+#ifdef __emote3__
+    static Tick wakeup();
+    static void int_wakeup(Interrupt_Id i) {} // the sleep timer only wakes the CPU up, IC::dispatch() does the rest
+#else
+    static Tick wakeup() { return 1; }
+#endif
+
     static void init();
 
 protected:
@@ -80,6 +107,10 @@ protected:
     Handler _handler;
 
     static Timer * _channels[CHANNELS];
+#ifdef __emote3__
+    static volatile bool _sleeping;
+    static Tick _skipped;
+#endif
 };
 
 
@@ -88,13 +119,23 @@ class Scheduler_Timer: public Timer
 {
 public:
     Scheduler_Timer(Microsecond quantum, const Handler & handler): Timer(SCHEDULER, 1000000 / quantum, handler) {}
+
+    using Timer::restart;
+
+    // Starts a slice of "quantum" instead of the one given at construction (see Criterion::quantum())
+    int restart(const Microsecond & quantum) {
+        int percentage = restart();
+        Tick ticks = static_cast<unsigned long long>(quantum) * FREQUENCY / 1000000;
+        _current = ticks ? ticks : 1;
+        return percentage;
+    }
 };
 
 // Timer used by Alarm
 class Alarm_Timer: public Timer
 {
 public:
-    Alarm_Timer(const Handler & handler): Timer(ALARM, FREQUENCY, handler) {}
+    Alarm_Timer(const Handler & handler, bool local = false): Timer(ALARM, FREQUENCY, handler) {}
 };
 
 
@@ -0,0 +1,24 @@
+// EPOS ARM Cortex TRNG Mediator Declarations
+
+#ifndef __cortex_trng_h
+#define __cortex_trng_h
+
+#include <machine/trng.h>
+#include __HEADER_MMOD(trng)
+
+__BEGIN_SYS
+
+class TRNG: private TRNG_Engine
+{
+private:
+    typedef TRNG_Engine Engine;
+
+public:
+    TRNG() {}
+
+    using Engine::random;
+};
+
+__END_SYS
+
+#endif
@@ -8,9 +8,14 @@
 #include <machine/adc.h>
 #undef __adc_common_only__
 #include <machine/gpio.h>
+#include <machine/ic.h>
 #include <system/memory_map.h>
 #include <machine/cortex/engine/pl061.h>
+#include <machine/cortex/engine/cortex_m3/gptm.h>
+#include <utility/handler.h>
 #include "emote3_ioctrl.h"
+#include "emote3_sysctrl.h"
+#include "emote3_udma.h"
 
 __BEGIN_SYS
 
@@ -188,6 +193,15 @@ public:
         return ret;
     }
 
+    // Runs sequences of conversions of AIN0 to "last", either started by the GPTM trigger or by software (ST) and
+    // therefore stopped. Each conversion requests the uDMA channel of its input, which reads its 8 MSBs from msb().
+    void sequence(const Channel & last, const Reference & reference, const Resolution & resolution, bool timer) {
+        adc(ADCCON2) = (reference * ADCCON2_SREF) | (resolution * ADCCON2_SDIV) | (last * ADCCON2_SCH);
+        adc(ADCCON1) = (adc(ADCCON1) & ~(3 * ADCCON1_STSEL)) | ((timer ? 2 : 3) * ADCCON1_STSEL);
+    }
+
+    volatile Reg32 * msb() { return &adc(ADCH); }
+
     // returns the voltage corresponding to the reading, with three decimal places (e.g. 2534 means 2.534V)
     // reference uses the same voltage notation
     unsigned int convert(unsigned short reading, unsigned int reference, const Resolution & resolution) {
@@ -207,9 +221,15 @@ private:
 
 class ADC_Engine: public CC2538_ADC
 {
+private:
+    static const bool continuous = Traits<ADC>::continuous;
+    static const unsigned int TIMER_UNIT = Traits<ADC>::TIMER_UNIT;
+    static const unsigned int DMA_CHANNEL = Traits<ADC>::DMA_CHANNEL;
+
 public:
     ADC_Engine(unsigned int unit, const Reference & reference, unsigned int bits)
-    : _channel(static_cast<Channel>(unit)), _reference(reference), _resolution((bits <= 7) ? BITS_7 : (bits <= 9) ? BITS_9 : (bits <= 10) ? BITS_10 : BITS_12) {
+    : _channel(static_cast<Channel>(unit)), _reference(reference), _resolution((bits <= 7) ? BITS_7 : (bits <= 9) ? BITS_9 : (bits <= 10) ? BITS_10 : BITS_12),
+      _buffer(0), _samples(0), _handler(0), _filled(0), _halves(0), _timer(0) {
         _adc = new(reinterpret_cast<CC2538_ADC *>(Memory_Map::ADC_BASE)) CC2538_ADC;
         // Configure GPIO port A for ADC
         PL061 * pl061 = new(reinterpret_cast<PL061 *>(Memory_Map::GPIOA_BASE)) PL061;
@@ -222,14 +242,46 @@ public:
     unsigned short read() { return _adc->read(_channel, _reference, _resolution); }
     unsigned int convert(unsigned short reading, unsigned int reference) { return _adc->convert(reading, reference, _resolution); }
 
+    ~ADC_Engine() { stop(); }
+
+    // Continuous mode (Traits<ADC>::continuous): a GPTM triggers a conversion at "frequency" and the uDMA moves the
+    // samples (their 8 MSBs, so the resolution can be the fastest one) into "buffer", which holds two halves of
+    // "samples" (up to 1024) each. The halves are filled in turns, "handler" (e.g. a Semaphore_Handler) being called,
+    // in interrupt context, as each one is complete. filled() then points to it, in place, until the other half is
+    // complete too, which is all the time there is to process it. halves() counts them, so a late reader can tell how
+    // many it missed. Only one ADC can sample continuously at a time.
+    void start(const Hertz & frequency, unsigned char * buffer, unsigned int samples, Handler * handler);
+    void stop();
+
+    unsigned char * filled() const { return _filled; }
+    unsigned int halves() const { return _halves; }
+
     static void init() {}
 
+private:
+    void arm(bool alternate);
+    unsigned int dma_channel() const { return DMA_CHANNEL + _channel; }
+
+    static void int_handler(IC::Interrupt_Id i);
+
+    static SysCtrl * scr() { return reinterpret_cast<SysCtrl *>(Memory_Map::SCR_BASE); }
+    static GPTM * gptm(unsigned int unit) { return reinterpret_cast<GPTM *>(Memory_Map::TIMER0_BASE + 0x1000 * unit); }
+
 private:
     Channel _channel;
     Reference _reference;
     Resolution _resolution;
 
     CC2538_ADC * _adc;
+
+    unsigned char * _buffer;
+    unsigned int _samples;
+    Handler * _handler;
+    unsigned char * volatile _filled;
+    volatile unsigned int _halves;
+    GPTM * _timer;
+
+    static ADC_Engine * _engine; // the one sampling continuously
 };
 
 __END_SYS
@@ -6,6 +6,7 @@
 #define __emote3_i2c_h
 
 #include <architecture/cpu.h>
+#include <machine/ic.h>
 #include <machine/cortex/engine/pl061.h>
 #define __i2c_common_only__
 #include <machine/i2c.h>
@@ -212,6 +213,19 @@ public:
     bool ready_to_get() { return ready_to_put(); }
     bool ready_to_put() { return !(i2c(I2C_STAT) & I2C_STAT_BUSY); }
 
+    // Single master operations, for the Transactions of I2C_Engine
+    void address(unsigned char slave_address, bool read) { i2c(I2C_SA) = (slave_address << 1) | (read ? I2C_SA_RS : 0); }
+    void data(char data) { i2c(I2C_DR) = data; }
+    char data() { return i2c(I2C_DR); }
+    void command(Reg32 command) { i2c(I2C_CTRL) = command; }
+    Reg32 status() { return i2c(I2C_STAT); }
+
+    // The master interrupt flags the end of each operation, even when it is masked
+    bool finished() { return i2c(I2C_RIS) & I2C_RIS_BIT; }
+    void clear_int() { i2c(I2C_ICR) = I2C_ICR_IC; }
+    void master_int_enable() { i2c(I2C_IMR) = I2C_IMR_IM; }
+    void master_int_disable() { i2c(I2C_IMR) = 0; }
+
 private:
     bool put_byte(char data, int mode) {
         // assumes that slave address already written to I2CMSA
@@ -247,11 +261,14 @@ class I2C_Engine: public CC2538_I2C
     friend Machine;
 
 private:
+    static const bool asynchronous = Traits<I2C>::asynchronous;
+
     typedef GPIO_Common::Port Port;
     typedef GPIO_Common::Pin Pin;
+    typedef Transaction::List Queue;
 
 public:
-    I2C_Engine(unsigned int unit, const Role & role) {
+    I2C_Engine(unsigned int unit, const Role & role): _current(0) {
         Port sda_port, scl_port;
         Pin  sda_pin,  scl_pin;
 
@@ -278,6 +295,22 @@ public:
         ioc()->enable_i2c((sda_port - 'A'), sda_pin, (scl_port - 'A'), scl_pin);
 
         _i2c->config(role);
+
+        if(asynchronous && (role == MASTER)) {
+            _engine = this;
+            IC::int_vector(IC_Engine::INT_I2C, int_handler);
+            _i2c->clear_int();
+            _i2c->master_int_enable();
+            IC::enable(IC_Engine::INT_I2C);
+        }
+    }
+
+    ~I2C_Engine() {
+        if(_engine == this) {
+            IC::disable(IC_Engine::INT_I2C);
+            _i2c->master_int_disable();
+            _engine = 0;
+        }
     }
 
     bool get(char slave_address, char * data, bool stop = true) {
@@ -299,6 +332,14 @@ public:
     bool ready_to_get() { return _i2c->ready_to_get(); }
     bool ready_to_put() { return _i2c->ready_to_put(); }
 
+    // Queues "n" consecutive Transactions at once. When the engine is interrupt-driven (Traits<I2C>::asynchronous),
+    // each interrupt moves a byte and the next Transaction starts as soon as one finishes, so a thread can have many of
+    // them in flight. Otherwise, they run right away, by polling, before submit() returns.
+    void submit(Transaction * t, unsigned int n = 1);
+
+    // Runs a single Transaction, blocking the calling thread until it is done, and returns whether it succeeded
+    bool transfer(unsigned char slave_address, const char * tx, unsigned int tx_size, char * rx, unsigned int rx_size);
+
     // The following member functions are not yet implemented. Forwarding them to Base lands in Common and causes a linking
     // error indicating someone needs this functionality. If you see this, just open an issue in GitLab
     void flush() { return _i2c->flush(); }
@@ -312,11 +353,23 @@ public:
     static void init() {}
 
 private:
+    bool start(Transaction * t);
+    bool step(Transaction * t);
+    void issue(Transaction * t, bool first);
+    void next();
+    void finish(Transaction * t);
+
+    static void int_handler(IC::Interrupt_Id i);
+
     static SysCtrl * scr() { return reinterpret_cast<SysCtrl *>(Memory_Map::SCR_BASE); }
     static IOCtrl * ioc() { return reinterpret_cast<IOCtrl *>(Memory_Map::IOC_BASE); }
 
 private:
     CC2538_I2C * _i2c;
+    Queue _queue;
+    Transaction * _current;
+
+    static I2C_Engine * _engine; // the interrupt-driven master (there is only one in the SoC)
 };
 
 __END_SYS
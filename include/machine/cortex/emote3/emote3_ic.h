@@ -31,6 +31,12 @@ public:
         INT_GPIOB       = EXCS + NVIC::IRQ_GPIOB,
         INT_GPIOC       = EXCS + NVIC::IRQ_GPIOC,
         INT_GPIOD       = EXCS + NVIC::IRQ_GPIOD,
+        INT_UART0       = EXCS + NVIC::IRQ_UART0,
+        INT_UART1       = EXCS + NVIC::IRQ_UART1,
+        INT_SSI0        = EXCS + NVIC::IRQ_SSI0,
+        INT_I2C         = EXCS + NVIC::IRQ_I2C,
+        INT_ADC         = EXCS + NVIC::IRQ_ADC,
+        INT_SSI1        = EXCS + NVIC::IRQ_SSI1,
         INT_NIC0_RX     = EXCS + NVIC::IRQ_RFTXRX,
         INT_NIC0_TX     = EXCS + NVIC::IRQ_RFTXRX,
         INT_NIC0_ERR    = EXCS + NVIC::IRQ_RFERR,
@@ -50,6 +56,15 @@ public:
 
     static void ipi(unsigned int cpu, Interrupt_Id i) {} // Cortex-M3 is always single-core
 
+    // Interrupt priorities are not used (handlers already run in thread mode, see IC::entry())
+    static const unsigned int PRIORITIES = 0;
+    static void priority(Interrupt_Id i, unsigned int p) {}
+    static unsigned int priority(Interrupt_Id i) { return 0; }
+
+    static bool affinity(Interrupt_Id i, unsigned long cpus) { return false; }
+    static void level(unsigned int l) {}
+    static unsigned int level() { return 0; }
+
     static void init() { nvic()->init(); };
 
 private:
@@ -222,6 +222,13 @@ public:
         ioc(I2CMSSCL) = (port_scl << 3) + pin_scl;
     }
 
+    void enable_pwm(unsigned int timer, unsigned int port, unsigned int pin) {
+        ioc(PA0_SEL + 0x20 * port + 0x4 * pin) = GPT0CP1 + 2 * timer;
+        ioc(PA0_OVER + 0x20 * port + 0x4 * pin) = OE;
+
+        // calling function must invoke PL061::select_pin_function(1 << pin, FUN_ALTERNATE) on the port afterwards to connect the pin
+    }
+
     void gpio_pull_up(unsigned int port, unsigned int pin) { ioc(PA0_OVER + 0x20 * port + 0x4 * pin) = PUE; }
     void gpio_pull_down(unsigned int port, unsigned int pin) { ioc(PA0_OVER + 0x20 * port + 0x4 * pin) = PDE; }
     void gpio_floating(unsigned int port, unsigned int pin) { ioc(PA0_OVER + 0x20 * port + 0x4 * pin) = ANA; }
@@ -6,6 +6,7 @@
 #include <machine/machine.h>
 #include <machine/cortex/engine/cortex_m3/scb.h>
 #include <machine/cortex/engine/cortex_m3/systick.h>
+#include <machine/cortex/engine/cortex_m3/nvic.h>
 #include "emote3_sysctrl.h"
 #include "emote3_ioctrl.h"
 #include <system/memory_map.h>
@@ -45,11 +46,23 @@ private:
         IEEE_ADDR       = 0x00280028,
     };
 
+    // State left in RAM by hibernate() for warm boots
+    static const Reg32 MAGIC = 0x57524d42;
+    static const unsigned int IRQ_WORDS = (NVIC::IRQS + 31) / 32;
+
+    struct Snapshot {
+        Reg32 magic;
+        Reg32 context[10];              // r4-r11, sp and lr of hibernate()
+        Reg32 irqs[IRQ_WORDS];          // NVIC enables
+        Reg32 crc;
+    };
+
 public:
     eMote3() {}
 
     using Machine_Common::delay;
     using Machine_Common::clear_bss;
+    using Machine_Common::temperature;
 
     static void reboot() {
         // call ROM function to reboot
@@ -76,15 +89,25 @@ public:
             break;
         case SLEEP: // Deep Sleep Power Mode 0
             scb()->sleepdeep();
-            scr()->power_mode(SysCtrl::ACTIVE);
+            scr()->power_mode(SysCtrl::PM0);
             break;
         case OFF: // Deep Sleep Power Mode 3
             scb()->sleepdeep();
-            scr()->power_mode(SysCtrl::POWER_MODE_1);
+            scr()->power_mode(SysCtrl::PM3);
             break;
        }
     }
 
+    // Puts the node in "mode" until it either wakes up (returning false) or is reset. With Traits<Machine>::warm_boot,
+    // a reset with RAM retained (the upper 16 KB in PM2 and PM3) is a warm boot: _ram_init() finds the snapshot left
+    // in RAM, brings back only the clocks, the NVIC, SysTick and the TSC, and hibernate() returns true, with the heap
+    // and all threads as they were. Everything else (e.g. the USB console, GPIOs, the radio) must be reconfigured by
+    // the caller, and the time spent hibernating is not accounted for by the system timer.
+    static bool hibernate(const Power_Mode & mode = OFF);
+
+    // Called by _ram_init() before .data and .bss are touched; does not return if there is a snapshot to resume
+    static void warm_boot();
+
 private:
     static void pre_init();
     static void init();
@@ -93,10 +116,23 @@ private:
     static SCB * scb() { return reinterpret_cast<SCB *>(Memory_Map::SCB_BASE); }
     static SysCtrl * scr() { return reinterpret_cast<SysCtrl *>(Memory_Map::SCR_BASE); }
     static IOCtrl * ioc() { return reinterpret_cast<IOCtrl *>(Memory_Map::IOC_BASE); }
+    static volatile Reg32 * irq_enables() {
+        return reinterpret_cast<volatile Reg32 *>(Memory_Map::SCB_BASE + NVIC::IRQ_ENABLE0);
+    }
+
+    static Reg32 crc();
+
+private:
+    static Snapshot _snapshot;          // in .bss, which the warm boot doesn't clear
 };
 
 typedef eMote3 Machine_Model;
 
+// No frequency scaling: SYS_DIV also clocks the TSC, SysTick and the I/O
+inline void CPU::clock(const Hertz & frequency) {}
+inline Hertz CPU::max_clock() { return Traits<CPU>::CLOCK; }
+inline Hertz CPU::min_clock() { return Traits<CPU>::CLOCK; }
+
 __END_SYS
 
 #endif
@@ -28,15 +28,18 @@ struct Memory_Map: public Cortex_Memory_Map
         FLASH_BASE              = 0x400d3000,
         IOC_BASE                = 0x400d4000,
         WATCHDOG_BASE           = 0x400d5000,
+        SMT_BASE                = 0x400d5040, // Sleep Mode Timer (in the watchdog's SMWDTHROSC block)
         ADC_BASE                = 0x400d7000,
         GPIOA_BASE              = 0x400d9000, // PL061 GPIO Port A
         GPIOB_BASE              = 0x400da000, // PL061 GPIO Port B
         GPIOC_BASE              = 0x400db000, // PL061 GPIO Port C
         GPIOD_BASE              = 0x400dc000, // PL061 GPIO Port D
+        UDMA_BASE               = 0x400ff000, // PL230 uDMA
         CCTEST_BASE             = 0x44010000,
         SCB_BASE                = 0xe000e000, // System Control Block
         
         VECTOR_TABLE            = Traits<Machine>::APP_CODE,
+        DATA_IMAGE              = Traits<Machine>::XIP ? Traits<Machine>::DATA_IMAGE : NOT_USED, // .data's initial values
         BOOT_STACK              = RAM_TOP + 1 - Traits<Machine>::STACK_SIZE, // will be used as the stack's base, not the stack pointer; SIZE = Traits<Machine>::STACK_SIZE
         FREE_TOP                = BOOT_STACK,
 
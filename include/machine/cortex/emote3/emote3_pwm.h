@@ -1,70 +1,93 @@
-// EPOS ARM Cortex-M3 PWM Mediator Declarations
+// EPOS EPOSMoteIII (ARM Cortex-M3) PWM Mediator Declarations
 
 #ifndef __emote3_pwm_h
 #define __emote3_pwm_h
 
-#include <machine/timer.h>
-#include <machine/gpio.h>
-#include __MODEL_H
+#include <architecture/cpu.h>
+#include <architecture/mmu.h>
+#define __pwm_common_only__
+#include <machine/pwm.h>
+#undef __pwm_common_only__
+#include <machine/ic.h>
+#include <system/memory_map.h>
+#include <machine/cortex/engine/pl061.h>
+#include <machine/cortex/engine/cortex_m3/gptm.h>
+#include <utility/handler.h>
+#include "emote3_ioctrl.h"
+#include "emote3_udma.h"
 
 __BEGIN_SYS
 
-// PWM
-    static void enable_pwm(unsigned int timer, char gpio_port, unsigned int gpio_pin) {
-        unsigned int port = gpio_port - 'A';
-        unsigned int sel = PA0_SEL + 0x20 * port + 0x4 * gpio_pin;
-
-        switch(timer) {
-            case 0: ioc(sel) = GPT0CP1; break;
-            case 1: ioc(sel) = GPT1CP1; break;
-            case 2: ioc(sel) = GPT2CP1; break;
-            case 3: ioc(sel) = GPT3CP1; break;
-        }
-        ioc(sel + 0x80) = OE;
-
-        unsigned int pin_bit = 1 << gpio_pin;
-        switch(gpio_port)
-        {
-            case 'A': gpioa(AFSEL) |= pin_bit; break;
-            case 'B': gpiob(AFSEL) |= pin_bit; break;
-            case 'C': gpioc(AFSEL) |= pin_bit; break;
-            case 'D': gpiod(AFSEL) |= pin_bit; break;
-        }
-    }
+// PWM output of timer A of a GPTM (already configured with its period, e.g. by a User_Timer) on a GPIO pin
+class PWM_Engine: public PWM_Common
+{
+private:
+    static const bool waveform = Traits<PWM>::waveform;
+    static const unsigned int DMA_CHANNEL = Traits<PWM>::DMA_CHANNEL;
+    static const unsigned int DMA_ENCODING = Traits<PWM>::DMA_ENCODING;
 
-    static void disable_pwm(unsigned int timer, unsigned int gpio_port, unsigned int gpio_pin) {
-        unsigned int pin_bit = 1 << gpio_pin;
-        switch(gpio_port)
-        {
-            case 'A': gpioa(AFSEL) &= ~pin_bit; break;
-            case 'B': gpiob(AFSEL) &= ~pin_bit; break;
-            case 'C': gpioc(AFSEL) &= ~pin_bit; break;
-            case 'D': gpiod(AFSEL) &= ~pin_bit; break;
-        }
+public:
+    typedef GPTM::Count Count;
+    typedef MMU::DMA_Buffer DMA_Buffer;
+
+public:
+    PWM_Engine(unsigned int unit, unsigned int port, unsigned int pin, const Percent & duty_cycle)
+    : _unit(unit), _port(port), _pin(pin), _gptm(gptm(unit)), _table(0), _steps(0), _handler(0), _refill(0), _halves(0) {
+        _gptm->disable();
+        ioc()->enable_pwm(unit, port, pin);
+        gpio(port)->select_pin_function(1 << pin, PL061::FUN_ALTERNATE);
+        _gptm->pwm(duty_cycle);
+    }
+    ~PWM_Engine() {
+        stop();
+        gpio(_port)->select_pin_function(1 << _pin, PL061::FUN_GPIO);
     }
 
+    void duty_cycle(const Percent & d) { _gptm->pwm(d); }
+    void enable() { _gptm->enable(); }
+    void disable() { _gptm->disable(); }
 
+    // Match count of "d", as the steps of a waveform are given
+    Count count(const Percent & d) { return _gptm->pwm_count(d); }
 
-class PWM: private PWM_Common, private Machine_Model
-{
-public:
-    PWM(User_Timer * timer, GPIO * gpio, const Percent & duty_cycle)
-    : _gpio(gpio), _timer(timer) {
-        _timer->disable();
-        enable_pwm(_timer->_channel, _gpio->_port, _gpio->_pin);
-        _timer->pwm(duty_cycle);
+    // Waveform mode (Traits<PWM>::waveform): each period of the PWM ends with the uDMA writing the next step of a
+    // table in "buffer" to the match register, which holds two halves of "steps" (up to 1024) counts (see count()),
+    // so duty cycles change at kHz rates with no CPU writes. The halves are played in turns, "handler" (e.g. a
+    // Semaphore_Handler) being called, in interrupt context, as each one is done. refill() then points to it, in
+    // place, so it can be written with the steps that follow the other half, which is all the time there is to do so.
+    // halves() counts them, so a late writer can tell how many it missed. The 16 LSBs of the match are written, so
+    // periods must fit the 16-bit timer (without prescaler) and only one PWM can play a waveform at a time.
+    bool play(DMA_Buffer * buffer, unsigned int steps, Handler * handler);
+    void stop();
+
+    Count * refill() const { return _refill; }
+    unsigned int halves() const { return _halves; }
+
+private:
+    void arm(bool alternate);
+    IC::Interrupt_Id interrupt() const {
+        return (_unit == 0) ? IC::INT_TIMER0 : (_unit == 1) ? IC::INT_TIMER1 : (_unit == 2) ? IC::INT_TIMER2 : IC::INT_TIMER3;
     }
-    ~PWM() { disable_pwm(_timer->_channel, _gpio->_port, _gpio->_pin); }
 
-    void duty_cycle(const Percent & d) { _timer->pwm(d); }
-    void enable() { _timer->enable(); }
-    void disable() { _timer->disable(); }
+    static void int_handler(IC::Interrupt_Id i);
 
-    void power(const Power_Mode & mode) { _timer->power(mode); }
+    static IOCtrl * ioc() { return reinterpret_cast<IOCtrl *>(Memory_Map::IOC_BASE); }
+    static PL061 * gpio(unsigned int port) { return reinterpret_cast<PL061 *>(Memory_Map::GPIOA_BASE + 0x1000 * port); }
+    static GPTM * gptm(unsigned int unit) { return reinterpret_cast<GPTM *>(Memory_Map::TIMER0_BASE + 0x1000 * unit); }
 
 private:
-    GPIO * _gpio;
-    User_Timer * _timer;
+    unsigned int _unit;
+    unsigned int _port;
+    unsigned int _pin;
+    GPTM * _gptm;
+
+    Count * _table;
+    unsigned int _steps;
+    Handler * _handler;
+    Count * volatile _refill;
+    volatile unsigned int _halves;
+
+    static PWM_Engine * _engine; // the one playing a waveform
 };
 
 __END_SYS
@@ -4,26 +4,112 @@
 #define __emote3_rs485_h
 
 #include <machine/gpio.h>
+#include <machine/ic.h>
+#include <machine/cortex/engine/pl011.h>
+#include "emote3_udma.h"
+#include <system/memory_map.h>
 
 __BEGIN_SYS
 
+class Semaphore;
+template<typename T, unsigned int BUFFERS> class Mailbox;
+
+// Transceiver direction and, with Traits<RS485>::dma, frame-level operation of the UART underneath
+// send() has the uDMA feed the TX FIFO and sleeps until the EOT interrupt tells the last stop bit is out, when the
+// transceiver is turned back to receive with no polling loop in between. The RX channel moves bytes from the RX FIFO
+// into a Frame in bursts of 4, only while 8 or more are there, so (since the CPU doesn't take them) the last 1 to 7
+// bytes of a frame always stay in the FIFO and the UART raises its receive time-out once the line has been idle for 32
+// bit periods (about 3 characters, i.e. the Modbus RTU inter-frame gap). The ISR then appends those bytes and sends the
+// Frame to a Mailbox, from which threads receive() it and give it back with free(). Frames that overflow MAX_FRAME,
+// with line errors or that arrive while all FRAMES buffers are held by threads are dropped.
 class RS485_Engine: public RS485_Common
 {
 private:
+    static const bool dma = Traits<RS485>::dma;
+    static const unsigned int UNITS = Traits<UART>::UNITS;
+    static const unsigned int MAX_FRAME = Traits<RS485>::MAX_FRAME;
+    static const unsigned int FRAMES = Traits<RS485>::FRAMES;
+
     static const char RE_PORT = 'C';
     static const unsigned int RE_PIN  = 5;
     static const char DE_PORT = 'C';
     static const unsigned int DE_PIN  = 6;
 
+    typedef CPU::Reg32 Reg32;
+
+    // uDMA channels of the UARTs (with encoding 0 in CHMAP)
+    enum {
+        DMA_UART0_RX    = 8,
+        DMA_UART0_TX    = 9,
+        DMA_UART1_RX    = 22,
+        DMA_UART1_TX    = 23,
+        DMA_ARB         = 2     // 4 items per arbitration (RX burst requests come at half of the 16-byte FIFO)
+    };
+
 public:
-    RS485_Engine(): _re(GPIO(RE_PORT, RE_PIN, GPIO::OUT)), _de(GPIO(DE_PORT, DE_PIN, GPIO::OUT)) {}
+    struct Frame {
+        unsigned int length;
+        unsigned char data[MAX_FRAME];
+    };
+
+    typedef Mailbox<Frame, FRAMES> Frames;
+
+public:
+    RS485_Engine(unsigned int unit): _unit(unit), _re(GPIO(RE_PORT, RE_PIN, GPIO::OUT)),
+        _de(GPIO(DE_PORT, DE_PIN, GPIO::OUT)), _pl011(reinterpret_cast<PL011 *>(Memory_Map::UART0_BASE + 0x1000 * unit)) {
+        if(dma)
+            dma_init();
+    }
+
+    ~RS485_Engine() {
+        if(dma)
+            dma_finish();
+    }
 
     void out() { _re.set(true); _de.set(true); }
     void in() { _re.set(false); _de.set(false); }
 
+    // Sends "size" bytes (up to MAX_FRAME) as a frame, blocking the calling thread until it is on the line
+    int send(const void * data, unsigned int size);
+
+    // The next complete frame received, blocking the calling thread while there is none (try_receive() returns 0)
+    Frame * receive();
+    Frame * try_receive();
+    void free(Frame * frame);
+
+    unsigned long dropped() const { return _dropped; }
+
+    // The UART's interrupt sources and EOT, which UART::config() resets
+    void framing();
+
 private:
+    void dma_init();
+    void dma_finish();
+    void receive_next();
+    void received(bool error);
+    void sent();
+
+    unsigned int rx_channel() const { return (_unit == 0) ? DMA_UART0_RX : DMA_UART1_RX; }
+    unsigned int tx_channel() const { return (_unit == 0) ? DMA_UART0_TX : DMA_UART1_TX; }
+    IC::Interrupt_Id interrupt() const { return (_unit == 0) ? IC_Engine::INT_UART0 : IC_Engine::INT_UART1; }
+
+    static void int_handler(IC::Interrupt_Id i);
+
+    static PL230 * udma() { return uDMA::controller(); }
+
+private:
+    unsigned int _unit;
     GPIO _re;
     GPIO _de;
+    PL011 * _pl011;
+    Frames * _frames;
+    Frame * _rx;                // being filled by the uDMA (0 if all buffers are taken)
+    volatile bool _error;       // overrun or line error in the frame being received
+    volatile bool _sending;
+    Semaphore * _sent;
+    unsigned long _dropped;
+
+    static RS485_Engine * _engines[UNITS];
 };
 
 __END_SYS
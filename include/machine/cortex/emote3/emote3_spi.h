@@ -5,8 +5,10 @@
 
 #include <architecture/cpu.h>
 #include <machine/spi.h>
+#include <machine/ic.h>
 #include <machine/cortex/engine/pl022.h>
 #include <machine/cortex/engine/pl061.h>
+#include "emote3_udma.h"
 #include "emote3_sysctrl.h"
 #include "emote3_ioctrl.h"
 #include <system/memory_map.h>
@@ -17,17 +19,46 @@ class SPI_Engine: public SPI_Common
 {
 private:
     static const unsigned int UNITS = Traits<SPI>::UNITS;
+    static const bool dma = Traits<SPI>::dma;
 
     typedef CPU::Reg32 Reg32;
+    typedef Transaction::List Queue;
+
+    // uDMA channels of the SSIs (with encoding 0 in CHMAP)
+    enum {
+        DMA_SSI0_RX     = 10,
+        DMA_SSI0_TX     = 11,
+        DMA_SSI1_RX     = 24,
+        DMA_SSI1_TX     = 25,
+        DMA_ARB         = 2     // 4 items per arbitration (half of the 8-item FIFOs)
+    };
 
 public:
-    SPI_Engine(unsigned int unit, unsigned int clock, const Protocol & protocol, const Mode & mode, unsigned int bit_rate, unsigned int data_bits): _unit(unit) {
+    SPI_Engine(unsigned int unit, unsigned int clock, const Protocol & protocol, const Mode & mode, unsigned int bit_rate, unsigned int data_bits): _unit(unit), _current(0) {
         assert(unit < UNITS);
         _pl022 = new(reinterpret_cast<void *>(Memory_Map::SSI0_BASE + 0x1000 * unit)) PL022;
         config(clock, protocol, mode, bit_rate, data_bits);
+
+        if(dma) {
+            _engines[_unit] = this;
+            dma_init();
+            IC::Interrupt_Id i = (_unit == 0) ? IC_Engine::INT_SSI0 : IC_Engine::INT_SSI1;
+            IC::int_vector(i, int_handler);
+            IC::enable(i);
+        }
+    }
+
+    ~SPI_Engine() {
+        if(dma) {
+            IC::disable((_unit == 0) ? IC_Engine::INT_SSI0 : IC_Engine::INT_SSI1);
+            _pl022->dma_disable(PL022::RXDMAE | PL022::TXDMAE);
+            _engines[_unit] = 0;
+        }
     }
 
     void config(unsigned int clock, const Protocol & protocol, const Mode & mode, unsigned int bit_rate, unsigned int data_bits) {
+        _size = (data_bits > 8) ? PL230::SIZE_16 : PL230::SIZE_8;
+
         _pl022->disable();
 
         scr()->clock_spi(_unit);
@@ -79,15 +110,42 @@ public:
         }
     }
 
+    // Queues "n" consecutive Transactions at once, so the whole batch runs back to back with no thread in between.
+    // Without DMA (Traits<SPI>::dma), they run right away, through the FIFOs, before submit() returns.
+    void submit(Transaction * t, unsigned int n = 1);
+
+    // Runs a single transfer, blocking the calling thread (not the CPU, with DMA) until it is done
+    void transfer(const void * tx, void * rx, unsigned int size);
+
     static void init() {}
 
 private:
+    void start(Transaction * t);
+    void next();
+    void finish(Transaction * t);
+    void run(Transaction * t);
+    void dma_init();
+
+    unsigned int rx_channel() const { return (_unit == 0) ? DMA_SSI0_RX : DMA_SSI1_RX; }
+    unsigned int tx_channel() const { return (_unit == 0) ? DMA_SSI0_TX : DMA_SSI1_TX; }
+
+    static void int_handler(IC::Interrupt_Id i);
+
     static SysCtrl * scr() { return reinterpret_cast<SysCtrl *>(Memory_Map::SCR_BASE); }
     static IOCtrl * ioc() { return reinterpret_cast<IOCtrl *>(Memory_Map::IOC_BASE); }
+    static PL230 * udma() { return uDMA::controller(); }
 
 private:
     unsigned int _unit;
     PL022 * _pl022;
+    PL230::Size _size;
+    Queue _queue;
+    Transaction * _current;
+    unsigned int _chunk;        // items in the DMA cycle of _current
+
+    static SPI_Engine * _engines[UNITS];
+    static const Reg32 _dma_zero;   // source of the zeros shifted out when there is no "tx"
+    static Reg32 _dma_sink;         // sink of the data shifted in when there is no "rx"
 };
 
 __END_SYS
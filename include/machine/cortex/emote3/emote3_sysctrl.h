@@ -147,13 +147,14 @@ public:
         I_MAP_ALTMAP = 1 << 0,
     };
 
+    // Power modes entered by WFI with SCB's SLEEPDEEP set (PMCTL.PM), from PM0 (clocks gated by the DCGC registers) to PM3
+    // (no clocks at all). PM1 and PM2 stop the system clock, but keep the sleep timer running, and PM2 and PM3 only retain
+    // the lower 16 KB of RAM.
     enum Power_Mode {
-        ACTIVE,
-        PMSLEEP,
-        POWER_MODE_0,
-        POWER_MODE_1,
-        POWER_MODE_2,
-        POWER_MODE_3,
+        PM0,
+        PM1,
+        PM2,
+        PM3
     };
 
     enum Wakeup_Event {
@@ -272,6 +273,11 @@ public:
         scr(PMCTL) = mode;
     }
 
+    // PM1 to PM3 wake up on the 16-MHz RCOSC and the 32-MHz XOSC (see config_clock()) is only switched to once stable
+    void wait_clock() {
+        while(scr(CLOCK_STA) & STA_OSC);
+    }
+
     void wake_on(const Wakeup_Event & event) {
         scr(IWE) = event;
     }
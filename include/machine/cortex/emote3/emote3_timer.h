@@ -7,6 +7,7 @@
 #include <machine/ic.h>
 #undef __ic_common_only__
 #include <machine/cortex/engine/cortex_m3/systick.h>
+#include <machine/cortex/engine/cortex_m3/scb.h>
 #include <machine/cortex/engine/cortex_m3/gptm.h>
 #include "emote3_sysctrl.h"
 #include <system/memory_map.h>
@@ -14,16 +15,80 @@
 
 __BEGIN_SYS
 
+// Sleep Mode Timer, a 32-bit counter of the 32-kHz oscillator that keeps running (and can wake the CPU up) in PM1 and PM2
+class Sleep_Timer
+{
+    // This is a hardware object.
+    // Use with something like "new (Memory_Map::SMT_BASE) Sleep_Timer".
+
+private:
+    typedef CPU::Reg32 Reg32;
+
+public:
+    typedef Reg32 Count;
+
+    static const Hertz FREQUENCY = 32768;
+    static const Count MIN_COMPARE = 5; // compare values must be at least this far ahead of the count
+
+    // Registers' offsets from SMT_BASE
+    enum {                              // Description                                          Type    Value after reset
+        ST0             = 0x00,         // Count and compare value, bits 7:0 (latches 31:8)     rw      0x00000000
+        ST1             = 0x04,         // Bits 15:8                                            rw      0x00000000
+        ST2             = 0x08,         // Bits 23:16                                           rw      0x00000000
+        ST3             = 0x0c,         // Bits 31:24                                           rw      0x00000000
+        STLOAD          = 0x10,         // Compare load status                                  ro      0x00000001
+    };
+
+    // Useful Bits in STLOAD
+    enum {
+        LDRDY           = 1 << 0        // A new compare value can be written
+    };
+
+public:
+    // Reading ST0 latches the other bytes
+    Count read() {
+        Count c = st(ST0);
+        c |= st(ST1) << 8;
+        c |= st(ST2) << 16;
+        c |= st(ST3) << 24;
+        return c;
+    }
+
+    // Counts are only updated on the first 32-kHz edge after a wakeup from PM1 to PM3
+    void sync() {
+        Reg32 st0 = st(ST0);
+        while(st(ST0) == st0);
+    }
+
+    // Interrupts (IRQ_SMT) when the count reaches "c". Writing ST0 loads the compare value.
+    void compare(const Count & c) {
+        while(!(st(STLOAD) & LDRDY));
+        st(ST3) = (c >> 24) & 0xff;
+        st(ST2) = (c >> 16) & 0xff;
+        st(ST1) = (c >> 8) & 0xff;
+        st(ST0) = c & 0xff;
+    }
+
+private:
+    volatile Reg32 & st(unsigned int o) { return reinterpret_cast<volatile Reg32 *>(this)[o / sizeof(Reg32)]; }
+};
+
+
 class System_Timer_Engine: public Timer_Common
 {
 private:
     static const unsigned int FREQUENCY = Traits<Timer>::FREQUENCY;
+    static const unsigned int DEEPEST_SLEEP = (Traits<Timer>::DEEPEST_SLEEP < 2) ? Traits<Timer>::DEEPEST_SLEEP : 2;
 
+    typedef CPU::Reg32 Reg32;
     typedef IC_Common::Interrupt_Id Interrupt_Id;
 
 public:
     typedef SysTick::Count Count;
 
+    // Longest sleep (us), well within the sleep timer's wrap around
+    static const unsigned int MAX_SLEEP = 3600U * 1000000U;
+
 public:
     System_Timer_Engine() { new(systick()) SysTick; }
 
@@ -36,6 +101,17 @@ public:
 
     static Hertz clock() { return systick()->clock(); }
 
+    // Tickless idle (see Timer::sleep()): stops SysTick and sets the deepest power mode (up to Traits<Timer>::DEEPEST_SLEEP)
+    // worth entering for "time" (us) for the next WFI, with the sleep timer set to wake the CPU up early enough to make
+    // up for that mode's wakeup latency. Returns false if no mode is worth it, in which case SysTick goes on ticking.
+    static bool sleep(const Microsecond & time);
+
+    // Leaves the power mode entered by sleep(), restarts SysTick and returns the time slept (us), by the sleep timer
+    static Microsecond wakeup();
+
+    // Wakeup latencies (us) of PM1 and PM2: the datasheet's to the 16-MHz RCOSC plus the start-up of the 32-MHz XOSC
+    static Microsecond latency(unsigned int mode) { return (mode == 1) ? 4 + 250 : (mode == 2) ? 136 + 250 : 0; }
+
 protected:
     static void eoi(Interrupt_Id id) { systick()->eoi(id); };
 
@@ -47,6 +123,12 @@ protected:
 
 private:
     static SysTick * systick() { return reinterpret_cast<SysTick *>(Memory_Map::SCB_BASE); }
+    static Sleep_Timer * smt() { return reinterpret_cast<Sleep_Timer *>(Memory_Map::SMT_BASE); }
+    static SCB * scb() { return reinterpret_cast<SCB *>(Memory_Map::SCB_BASE); }
+    static SysCtrl * scr() { return reinterpret_cast<SysCtrl *>(Memory_Map::SCR_BASE); }
+
+private:
+    static Sleep_Timer::Count _sleep;
 };
 
 
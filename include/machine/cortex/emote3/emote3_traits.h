@@ -41,20 +41,38 @@ template<> struct Traits<Machine>: public Traits<Machine_Common>
     static const unsigned int APP_CODE          = BOOT_LOADER + BOOT_LOADER_SIZE;
     static const unsigned int APP_DATA          = APP_LOW;
 
+    // Execute in place: with XIP, .data's initial values are stored in flash at DATA_IMAGE and copied to APP_DATA at
+    // boot (see _ram_init()), so images can be flashed. Otherwise, they must be loaded into RAM (e.g. by a debugger).
+    static const bool XIP                       = false;
+    static const unsigned int DATA_IMAGE        = ROM_TOP + 1 - 2048 - (RAM_TOP + 1 - RAM_BASE); // below the CCA page
+
     static const unsigned int INIT              = NOT_USED;
     static const unsigned int PHY_MEM           = NOT_USED;
     static const unsigned int IO                = NOT_USED;
     static const unsigned int SYS               = NOT_USED;
 
+    // CPUs (with consecutive ids) sharing a cache beyond L1 (single core)
+    static const unsigned int CACHE_SHARING     = 1;
+
     // Default Sizes and Quantities
     static const unsigned int MAX_THREADS       = 8;
     static const unsigned int STACK_SIZE        = 2 * 1024;
     static const unsigned int HEAP_SIZE         = 2 * 1024;
+
+    // Warm boot: resets after Machine::hibernate() resume from the state it left in RAM instead of booting again
+    static const bool warm_boot                 = false;
 };
 
 template<> struct Traits<IC>: public Traits<Machine_Common>
 {
     static const bool debugged = hysterically_debugged;
+    static const bool nested = false; // handlers already run in thread mode, preemptable by any interrupt
+
+    // Per-CPU interrupt stack (0 keeps handlers on the interrupted thread's stack, which must then have room for them)
+    static const unsigned int STACK_SIZE = 0;
+    static const bool deferred = false; // without STACK_SIZE, still leave the reschedules of handlers to the outermost one's exit
+
+    static const bool static_vectors = false; // handlers bound at compile time (IC::bound()), so the vector tables are in flash
 };
 
 template<> struct Traits<Timer>: public Traits<Machine_Common>
@@ -67,6 +85,10 @@ template<> struct Traits<Timer>: public Traits<Machine_Common>
     // 10000 Hz. The choice must respect the scheduler time-slice, i. e.,
     // it must be higher than the scheduler invocation frequency.
     static const int FREQUENCY = 1000; // Hz
+
+    // Deepest power mode tickless idle (Traits<Alarm>::tickless) may enter while waiting for the next alarm: 0 (WFI only),
+    // 1 (PM1) or 2 (PM2, which only retains the lower 16 KB of RAM). The TSC and the USB stop in both.
+    static const unsigned int DEEPEST_SLEEP = 1;
 };
 
 template<> struct Traits<UART>: public Traits<Machine_Common>
@@ -88,6 +110,11 @@ template<> struct Traits<GPIO>: public Traits<Machine_Common>
 {
     static const unsigned int UNITS = 4;
     static const bool supports_power_up = true;
+
+    static const bool queued = false;           // edges time-stamped into a ring by the ISR and notified in batches by a thread
+    static const unsigned int EVENTS = 64;      // per pin, a power of two
+    static const unsigned int BATCH = 16;       // edges pending before observers are notified
+    static const unsigned int LATENCY = 10000;  // us an edge may wait for its batch to fill (0 = notify right away)
 };
 
 template<> struct Traits<I2C>: public Traits<Machine_Common>
@@ -97,6 +124,8 @@ template<> struct Traits<I2C>: public Traits<Machine_Common>
     static const unsigned int LSM330_UNIT = 0;
     static const unsigned int SI7020_UNIT = 0;
 
+    static const bool asynchronous = false; // run Transactions by interrupt, with a queue, instead of polling
+
     template<unsigned int UNIT>
     struct Config {};
 };
@@ -108,9 +137,31 @@ template<> struct Traits<I2C>::Config<0>
     static const unsigned char SCL_PIN = 0;
 };
 
+template<> struct Traits<ADC>: public Traits<Machine_Common>
+{
+    static const bool continuous = false;           // timer-triggered sampling into a uDMA double buffer (see ADC::start())
+    static const unsigned int TIMER_UNIT = 2;       // GPTM that triggers the conversions (0 is the User_Timer and 3 the TSC)
+    static const unsigned int DMA_CHANNEL = 21;     // uDMA channel of AIN0, the next ones serving AIN1 to AIN7
+};
+
+template<> struct Traits<PWM>: public Traits<Machine_Common>
+{
+    static const bool waveform = false;             // duty cycles streamed from a uDMA double buffer, one per period
+    static const unsigned int DMA_CHANNEL = 18;     // uDMA channel (with DMA_ENCODING in CHMAP) of the User_Timer's GPTM
+    static const unsigned int DMA_ENCODING = 0;
+};
+
 template<> struct Traits<SPI>: public Traits<Machine_Common>
 {
     static const unsigned int UNITS = 1;
+    static const bool dma = false; // move the data of Transactions with the uDMA and complete them by interrupt
+};
+
+template<> struct Traits<RS485>: public Traits<Machine_Common>
+{
+    static const bool dma = false;              // whole frames moved by the uDMA and delimited by the line going idle
+    static const unsigned int MAX_FRAME = 256;  // bytes (a Modbus RTU ADU), up to PL230::MAX_TRANSFER
+    static const unsigned int FRAMES = 4;       // received frames buffered for the threads
 };
 
 template<> struct Traits<USB>: public Traits<Machine_Common>
@@ -121,8 +172,12 @@ template<> struct Traits<USB>: public Traits<Machine_Common>
 
     static const bool wait_to_sync = true;
     static const unsigned int UNITS = 1;
-    static const bool blocking = false;
+    static const bool blocking = false; // read() and write() sleep until the host sends or takes packets
     static const bool enabled = true;
+
+    static const bool dma = false; // bulk packets moved between memory and the endpoint FIFOs by the uDMA
+    static const unsigned int DMA_OUT_CHANNEL = 30; // software-driven uDMA channels (peripheral requests are masked)
+    static const unsigned int DMA_IN_CHANNEL = 31;
 };
 
 template<> struct Traits<Watchdog>: public Traits<Machine_Common>
@@ -130,6 +185,11 @@ template<> struct Traits<Watchdog>: public Traits<Machine_Common>
     static const unsigned int PERIOD = 1000; // ms
 };
 
+template<> struct Traits<TRNG>: public Traits<Machine_Common>
+{
+    static const bool enabled = false; // seeds Random at initialization
+};
+
 template<> struct Traits<Serial_Display>: public Traits<Machine_Common>
 {
     static const bool enabled = true;
@@ -138,6 +198,7 @@ template<> struct Traits<Serial_Display>: public Traits<Machine_Common>
     static const unsigned int COLUMNS = 80;
     static const unsigned int LINES = 24;
     static const unsigned int TAB_SIZE = 8;
+    static const unsigned int BUFFER_SIZE = 0; // bytes waiting for the engine (0 = synchronous)
 };
 
 template<> struct Traits<Serial_Keyboard>: public Traits<Machine_Common>
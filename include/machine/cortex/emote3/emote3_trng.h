@@ -0,0 +1,50 @@
+// EPOS EPOSMoteIII (ARM Cortex-M3) TRNG Mediator Declarations
+
+#ifndef __emote3_trng_h
+#define __emote3_trng_h
+
+#include <architecture/cpu.h>
+#define __trng_common_only__
+#include <machine/trng.h>
+#undef __trng_common_only__
+#include <system/memory_map.h>
+
+__BEGIN_SYS
+
+// The CC2538 generator is the 16-bit LFSR of the ADC, which the boot code seeds with noise from the radio receiver,
+// so the numbers are only as random as that seed. Each 16 bits take one clock of the LFSR.
+class TRNG_Engine: public TRNG_Common
+{
+private:
+    typedef CPU::Reg32 Reg32;
+
+public:
+    // Registers offsets from ADC_BASE
+    enum {
+        ADCCON1         = 0x00,
+        RNDL            = 0x14,
+        RNDH            = 0x18
+    };
+
+    // Useful bits
+    enum {
+        ADCCON1_RCTRL   = 3 << 2,       // 01: clock the LFSR once (returns to 00 afterwards), 11: stopped
+        RCTRL_CLOCK     = 1 << 2
+    };
+
+public:
+    static unsigned int random() { return (half() << 16) | half(); }
+
+private:
+    static unsigned int half() {
+        reg(ADCCON1) = (reg(ADCCON1) & ~ADCCON1_RCTRL) | RCTRL_CLOCK;
+        while(reg(ADCCON1) & ADCCON1_RCTRL);
+        return (reg(RNDH) << 8) | reg(RNDL);
+    }
+
+    static volatile Reg32 & reg(unsigned int o) { return reinterpret_cast<volatile Reg32 *>(Memory_Map::ADC_BASE)[o / sizeof(Reg32)]; }
+};
+
+__END_SYS
+
+#endif
@@ -0,0 +1,34 @@
+// EPOS EPOSMoteIII (ARM Cortex-M3) uDMA Mediator Declarations
+
+#ifndef __emote3_udma_h
+#define __emote3_udma_h
+
+#include <machine/cortex/engine/pl230.h>
+#include <system/memory_map.h>
+
+__BEGIN_SYS
+
+// The single uDMA controller of the SoC, shared by the mediators that move data with it (e.g. SPI, ADC, PWM and RS485).
+// Its channel control table (1 KB, aligned to its size) is only allocated when one of them is configured to use it.
+class uDMA
+{
+public:
+    static const bool enabled = Traits<SPI>::dma || Traits<ADC>::continuous || Traits<USB>::dma || Traits<RS485>::dma
+                               || Traits<PWM>::waveform;
+
+public:
+    static PL230 * controller() { return reinterpret_cast<PL230 *>(Memory_Map::UDMA_BASE); }
+
+    // Can be called by every user of the controller
+    static void init() {
+        if(controller()->table() != _table)
+            controller()->config(_table);
+    }
+
+private:
+    static PL230::Control _table[enabled ? PL230::TABLE_SIZE : 1] __attribute__((aligned(enabled ? PL230::TABLE_ALIGNMENT : 4)));
+};
+
+__END_SYS
+
+#endif
@@ -10,6 +10,12 @@
 
 __BEGIN_SYS
 
+class Semaphore;
+
+// The bulk endpoints of the CDC data interface (3 IN and 4 OUT) are double-buffered and take full-speed packets of
+// _max_packet_bulk bytes. read() and write() move whole packets per FIFO access, with the uDMA if Traits<USB>::dma,
+// and, if Traits<USB>::blocking, sleep on a Semaphore signaled by the endpoint interrupts. get() and put() are still
+// one-byte transfers that busy wait, since the Display uses them before there are threads to sleep.
 class USB_Engine: public USB_2_0
 {
     // This is a hardware object.
@@ -19,6 +25,11 @@ private:
     typedef CPU::Reg8 Reg8;
     typedef CPU::Reg32 Reg32;
 
+    static const bool blocking = Traits<USB>::blocking;
+    static const bool dma = Traits<USB>::dma;
+    static const unsigned int DMA_OUT_CHANNEL = Traits<USB>::DMA_OUT_CHANNEL;
+    static const unsigned int DMA_IN_CHANNEL = Traits<USB>::DMA_IN_CHANNEL;
+
 public:
     // Maximum packet sizes for each end-point
     static const unsigned int _max_packet_ep0 = 32;
@@ -27,6 +38,7 @@ public:
     static const unsigned int _max_packet_ep3 = 128;
     static const unsigned int _max_packet_ep4 = 256;
     static const unsigned int _max_packet_ep5 = 512;
+    static const unsigned int _max_packet_bulk = 64; // full-speed bulk packets, twice in the FIFOs of endpoints 3 and 4
 
     // Registers offsets from BASE (i.e. this)
     enum {
@@ -162,6 +174,15 @@ public:
         INDBLBUF     = 1 << 0, // IN endpoint FIFO double-buffering enable.                              RW 0
     };
 
+    // Useful bits in CSOH
+    enum {
+      //Name           Offset     Description                                                          Type Reset
+        AUTOCLEAR    = 1 << 7, // If set by software, CSOL.OUTPKTRDY is automatically cleared when a     RW 0
+                               // packet of maximum size (specified by USBMAXO) has been unloaded.
+        OUTISO       = 1 << 6, // Selects OUT endpoint type: 0: Bulk/interrupt 1: Isochronous            RW 0
+        OUTDBLBUF    = 1 << 0, // OUT endpoint FIFO double-buffering enable.                             RW 0
+    };
+
     // Useful bits in CSIL
     enum {
       //Name              Offset     Description                                                         Type Reset
@@ -284,6 +305,15 @@ private:
 
     bool handle_ep0(const USB_2_0::Request::Device_Request & data);
 
+    unsigned int count() { return (usb(CNTH) << 8) | usb(CNT0_CNTL); }
+
+    bool wait_to_get();
+    bool wait_to_put();
+    void wake(Semaphore * s, volatile bool & waiting);
+
+    void fifo_read(volatile Reg32 & fifo, char * data, unsigned int size);
+    void fifo_write(volatile Reg32 & fifo, const char * data, unsigned int size);
+
 private:
     static volatile bool _ready_to_put; // TODO: isn't it the wrong semantics?
     static volatile bool _ready_to_put_next;
@@ -299,6 +329,11 @@ private:
     static Reg32 _oif;
     static const Descriptor::Device _device_descriptor;
 
+    static Semaphore * _in_ready;
+    static Semaphore * _out_ready;
+    static volatile bool _in_waiting;
+    static volatile bool _out_waiting;
+
     volatile Reg32 & usb(unsigned int o) { return reinterpret_cast<volatile Reg32 *>(Memory_Map::USB0_BASE)[o / sizeof(Reg32)]; }
 };
 
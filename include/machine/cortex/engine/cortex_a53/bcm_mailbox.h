@@ -221,28 +221,25 @@ public:
     };
 
 public:
-    void enable() {
-        mailbox(CORE0_MBOX_INT_CTRL) = ~1;
-        mailbox(CORE1_MBOX_INT_CTRL) = ~1;
-        mailbox(CORE2_MBOX_INT_CTRL) = ~1;
-        mailbox(CORE3_MBOX_INT_CTRL) = ~1;
-    }
+    // Each core has its own mailbox interrupt control, so the methods below act on the calling core only. The other
+    // local sources (i.e. the BCM timer, the GPU, the PMU and the AXI counter) are routed to a single core by their
+    // own registers and are not masked here.
+    void enable() { mailbox(CORE0_MBOX_INT_CTRL + 4 * CPU::id()) = 0xf; }
 
     void enable(int i) {
-        // FIXME: this is only acting on core 0; what about others?
-        mailbox(CORE0_MBOX_INT_CTRL + (i % 32)) |= 1 << i % 4;
+        if((i >= MAILBOX0_IRQ) && (i <= MAILBOX3_IRQ))
+            mailbox(CORE0_MBOX_INT_CTRL + 4 * CPU::id()) |= 1 << (i - MAILBOX0_IRQ);
+        else if(i == MAILBOX_PMU_IRQ) // each core's PMU is routed to its own IRQ
+            mailbox(PMU_INT_ROUTING_SET) = 1 << CPU::id();
     }
 
-    void disable() {
-        mailbox(CORE0_MBOX_INT_CTRL) = 0;
-        mailbox(CORE1_MBOX_INT_CTRL) = 0;
-        mailbox(CORE2_MBOX_INT_CTRL) = 0;
-        mailbox(CORE3_MBOX_INT_CTRL) = 0;
-    }
+    void disable() { mailbox(CORE0_MBOX_INT_CTRL + 4 * CPU::id()) = 0; }
 
     void disable(int i) {
-        // FIXME: this is only acting on core 0; what about others?
-        mailbox(CORE0_MBOX_INT_CTRL + (i % 32)) &= ~(1 << i % 4);
+        if((i >= MAILBOX0_IRQ) && (i <= MAILBOX3_IRQ))
+            mailbox(CORE0_MBOX_INT_CTRL + 4 * CPU::id()) &= ~(1 << (i - MAILBOX0_IRQ));
+        else if(i == MAILBOX_PMU_IRQ)
+            mailbox(PMU_INT_ROUTING_CLR) = 1 << CPU::id();
     }
 
     Interrupt_Id int_id() {
@@ -280,17 +277,19 @@ public:
         CPU::isb();
     }
 
+    // Releases "cpu" from the 32-bit firmware stub, which waits for an entry point in the core's mailbox 3
     void start(unsigned int cpu, Log_Addr addr) {
         mailbox(CORE0_MBOX3_SET + 16 * cpu) = addr;
         CPU::sev();
     }
 
+    // Called by each core: clears whatever the boot loader left in its mailboxes (e.g. the entry point given to
+    // start()) and masks them, so IPIs are only taken once enabled (e.g. for IC::INT_RESCHEDULER)
     void init() {
-        // Enable all IPIs
-        mailbox(CORE0_MBOX_INT_CTRL) = 0xf;
-        mailbox(CORE1_MBOX_INT_CTRL) = 0xf;
-        mailbox(CORE2_MBOX_INT_CTRL) = 0xf;
-        mailbox(CORE3_MBOX_INT_CTRL) = 0xf;
+        unsigned int cpu_base = CPU::id() * 16;
+        disable();
+        for(unsigned int i = 0; i < 16; i += 4)
+            mailbox(MBOX_WC + cpu_base + i) = ~0U;
     }
 
 private:
@@ -0,0 +1,130 @@
+// EPOS Xilinx AXI DMA (PG021) Mediator Declarations
+
+#ifndef __cortex_a9_axi_dma_h
+#define __cortex_a9_axi_dma_h
+
+#include <architecture/cpu.h>
+
+__BEGIN_SYS
+
+// AXI DMA soft IP in the Zynq PL, built with scatter-gather. Only the S2MM (stream to memory) channel is handled.
+class AXI_DMA
+{
+    // This is a hardware object.
+    // Use with something like "new (Memory_Map::AXI_DMA_BASE) AXI_DMA".
+
+private:
+    typedef CPU::Reg32 Reg32;
+    typedef CPU::Phy_Addr Phy_Addr;
+
+public:
+    // Registers' offsets from BASE
+    enum {                                      // Description              Type    Value after reset
+        MM2S_DMACR                  = 0x00,     // MM2S Control             r/w     0x00010002
+        MM2S_DMASR                  = 0x04,     // MM2S Status              r/w1c   0x00010001
+        MM2S_CURDESC                = 0x08,     // MM2S Current Descriptor  r/w     0x00000000
+        MM2S_TAILDESC               = 0x10,     // MM2S Tail Descriptor     r/w     0x00000000
+        SG_CTL                      = 0x2c,     // SG User and Cache        r/w     0x00000303
+        S2MM_DMACR                  = 0x30,     // S2MM Control             r/w     0x00010002
+        S2MM_DMASR                  = 0x34,     // S2MM Status              r/w1c   0x00010001
+        S2MM_CURDESC                = 0x38,     // S2MM Current Descriptor  r/w     0x00000000
+        S2MM_TAILDESC               = 0x40      // S2MM Tail Descriptor     r/w     0x00000000
+    };
+
+    // Useful bits in DMACR
+    enum {                                      // Description              Type    Value after reset
+        RS                          = 1 << 0,   // Run/Stop                 r/w     0
+        RESET                       = 1 << 2,   // Soft reset (both channels) r/w   0
+        CYCLIC                      = 1 << 4,   // Cyclic BD enable         r/w     0
+        IOC_IRQ_EN                  = 1 << 12,  // Interrupt on Complete    r/w     0
+        DLY_IRQ_EN                  = 1 << 13,  // Interrupt on Delay       r/w     0
+        ERR_IRQ_EN                  = 1 << 14,  // Interrupt on Error       r/w     0
+        IRQ_THRESHOLD               = 1 << 16,  // Completions per IRQ      r/w     1   (8 bits)
+        IRQ_DELAY                   = 1 << 24   // Delay timeout (x125 clk) r/w     0   (8 bits)
+    };
+
+    // Useful bits in DMASR
+    enum {                                      // Description              Type    Value after reset
+        HALTED                      = 1 << 0,   // Halted                   ro      1
+        IDLE                        = 1 << 1,   // Idle (SG reached tail)   ro      0
+        SG_INCLD                    = 1 << 3,   // SG engine included       ro      config
+        DMA_INT_ERR                 = 1 << 4,   // DMA internal error       ro      0
+        DMA_SLV_ERR                 = 1 << 5,   // DMA slave error          ro      0
+        DMA_DEC_ERR                 = 1 << 6,   // DMA decode error         ro      0
+        SG_INT_ERR                  = 1 << 8,   // SG internal error        ro      0
+        SG_SLV_ERR                  = 1 << 9,   // SG slave error           ro      0
+        SG_DEC_ERR                  = 1 << 10,  // SG decode error          ro      0
+        IOC_IRQ                     = 1 << 12,  // Complete interrupt       r/w1c   0
+        DLY_IRQ                     = 1 << 13,  // Delay interrupt          r/w1c   0
+        ERR_IRQ                     = 1 << 14,  // Error interrupt          r/w1c   0
+        ERRORS                      = DMA_INT_ERR | DMA_SLV_ERR | DMA_DEC_ERR | SG_INT_ERR | SG_SLV_ERR | SG_DEC_ERR,
+        IRQS                        = IOC_IRQ | DLY_IRQ | ERR_IRQ
+    };
+
+    // Scatter-gather descriptor (must be aligned on 16 words, so each one has cache lines of its own)
+    struct SG_Desc {
+        // Control bits
+        enum {
+            LENGTH      = (1 << 26) - 1,        // buffer length (as wide as the IP's "Width of Buffer Length Register")
+            TXEOF       = 1 << 26,              // end of frame (MM2S only)
+            TXSOF       = 1 << 27               // start of frame (MM2S only)
+        };
+
+        // Status bits (written back by the DMA)
+        enum {
+            TRANSFERRED = (1 << 26) - 1,        // bytes written to the buffer
+            RXEOF       = 1 << 26,              // the buffer holds the end of a stream packet (TLAST)
+            RXSOF       = 1 << 27,              // the buffer holds the start of a stream packet
+            INT_ERR     = 1 << 28,
+            SLV_ERR     = 1 << 29,
+            DEC_ERR     = 1 << 30,
+            CMPLT       = 1 << 31               // the DMA is done with this descriptor
+        };
+
+        volatile Reg32 next;
+        volatile Reg32 next_msb;
+        volatile Reg32 addr;
+        volatile Reg32 addr_msb;
+        volatile Reg32 reserved[2];
+        volatile Reg32 control;
+        volatile Reg32 status;
+        volatile Reg32 app[5];
+    } __attribute__((aligned(64)));
+
+public:
+    void reset() {
+        dma(S2MM_DMACR) = RESET;
+        while(dma(S2MM_DMACR) & RESET);
+    }
+
+    // Runs S2MM over the descriptor chain from "cur" to "tail" (CURDESC can only be written while the channel is halted),
+    // interrupting after every "threshold" completions or, with "delay", once the stream stops for that long
+    void start(Phy_Addr cur, Phy_Addr tail, unsigned int threshold = 1, unsigned int delay = 0) {
+        dma(S2MM_CURDESC) = cur;
+        dma(S2MM_DMACR) = RS | IOC_IRQ_EN | ERR_IRQ_EN | (delay ? DLY_IRQ_EN : 0)
+                        | (IRQ_THRESHOLD * (threshold & 0xff)) | (IRQ_DELAY * (delay & 0xff));
+        dma(S2MM_TAILDESC) = tail;
+    }
+
+    // Moves the tail, handing the DMA the descriptors up to it (an IDLE channel resumes after the previous tail)
+    void tail(Phy_Addr tail) { dma(S2MM_TAILDESC) = tail; }
+
+    void halt() {
+        dma(S2MM_DMACR) &= ~RS;
+        while(!(dma(S2MM_DMASR) & HALTED));
+    }
+
+    Reg32 status() { return dma(S2MM_DMASR); }
+
+    Reg32 acknowledge() {
+        Reg32 status = dma(S2MM_DMASR);
+        dma(S2MM_DMASR) = status & IRQS;
+        return status;
+    }
+
+    volatile Reg32 & dma(unsigned int o) { return reinterpret_cast<volatile Reg32 *>(this)[o / sizeof(Reg32)]; }
+};
+
+__END_SYS
+
+#endif
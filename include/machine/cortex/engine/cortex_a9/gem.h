@@ -7,18 +7,224 @@
 
 __BEGIN_SYS
 
+// Cadence Gigabit Ethernet MAC (GEM), as in the Zynq-7000 PS (r1p23), with 32-bit descriptors and AHB DMA
 class GEM
 {
     // This is a hardware object.
-    // Use with something like "new (Memory_Map::UARTx_BASE) PL011".
+    // Use with something like "new (Memory_Map::ETH0_BASE) GEM".
 
 private:
     typedef CPU::Reg32 Reg32;
 
 public:
+    // Registers' offsets from BASE
+    enum {                                      // Description              Type    Value after reset
+        NET_CTRL                    = 0x000,    // Network Control          r/w     0x00000000
+        NET_CFG                     = 0x004,    // Network Configuration    r/w     0x00080000
+        NET_STATUS                  = 0x008,    // Network Status           ro      -
+        DMA_CFG                     = 0x010,    // DMA Configuration        r/w     0x00020784
+        TX_STATUS                   = 0x014,    // Transmit Status          w1c     0x00000000
+        RX_QBAR                     = 0x018,    // RX Queue Base Address    r/w     0x00000000
+        TX_QBAR                     = 0x01c,    // TX Queue Base Address    r/w     0x00000000
+        RX_STATUS                   = 0x020,    // Receive Status           w1c     0x00000000
+        INTR_STATUS                 = 0x024,    // Interrupt Status         w1c     0x00000000
+        INTR_EN                     = 0x028,    // Interrupt Enable         wo      -
+        INTR_DIS                    = 0x02c,    // Interrupt Disable        wo      -
+        INTR_MASK                   = 0x030,    // Interrupt Mask           ro      0x07ffffff
+        PHY_MAINT                   = 0x034,    // PHY Maintenance (MDIO)   r/w     0x00000000
+        HASH_BOT                    = 0x080,    // Hash Filter [31:0]       r/w     0x00000000
+        HASH_TOP                    = 0x084,    // Hash Filter [63:32]      r/w     0x00000000
+        SPEC_ADDR1_BOT              = 0x088,    // Specific Address 1 [31:0] r/w    0x00000000
+        SPEC_ADDR1_TOP              = 0x08c,    // Specific Address 1 [47:32] r/w   0x00000000
+        MODULE_ID                   = 0x0fc,    // Module ID and Revision   ro      0x00020118
+        RX_OVERRUN_ERRORS           = 0x1a4     // Receive Overruns         ro      0x00000000
+    };
+
+    // Useful bits in NET_CTRL
+    enum {                                      // Description              Type    Value after reset
+        RX_EN                       = 1 << 2,   // Receive enable           r/w     0
+        TX_EN                       = 1 << 3,   // Transmit enable          r/w     0
+        MGMT_PORT_EN                = 1 << 4,   // MDIO enable              r/w     0
+        CLEAR_STATS                 = 1 << 5,   // Clear statistics         wo      0
+        START_TX                    = 1 << 9,   // Start transmission       wo      0
+        HALT_TX                     = 1 << 10   // Halt transmission        wo      0
+    };
+
+    // Useful bits in NET_CFG
+    enum {                                      // Description              Type    Value after reset
+        SPEED_100                   = 1 << 0,   // 100 Mbps (10 if 0)       r/w     0
+        FULL_DUPLEX                 = 1 << 1,   // Full duplex              r/w     0
+        COPY_ALL                    = 1 << 4,   // Promiscuous mode         r/w     0
+        GIGABIT                     = 1 << 10,  // 1000 Mbps                r/w     0
+        FCS_REMOVE                  = 1 << 17,  // Don't copy the FCS       r/w     0
+        MDC_CLK_DIV                 = 7 << 18,  // MDC divider (224 if 7)   r/w     2
+        MDC_CLK_DIV_224             = 7 << 18,
+        RX_CHKSUM_OFFLOAD           = 1 << 24   // Discard bad IP/TCP/UDP checksums r/w 0
+    };
+
+    // Useful bits in NET_STATUS
+    enum {                                      // Description              Type    Value after reset
+        MGMT_IDLE                   = 1 << 2    // PHY management idle      ro      1
+    };
+
+    // Useful bits in DMA_CFG
+    enum {                                      // Description              Type    Value after reset
+        AHB_BURST_INCR16            = 0x10,     // AHB fixed bursts of 16   r/w     0x04
+        AHB_BURST                   = 0x1f,
+        RX_PKTBUF_8KB               = 3 << 8,   // Full RX packet buffer    r/w     3
+        TX_PKTBUF_4KB               = 1 << 10,  // Full TX packet buffer    r/w     1
+        TX_CHKSUM_OFFLOAD           = 1 << 11,  // Generate IP/TCP/UDP checksums r/w 0
+        RX_BUF_SIZE                 = 0xff << 16, // RX buffer size (x 64 bytes) r/w 0x02
+        RX_BUF_SIZE_SHIFT           = 16,
+        DISC_WHEN_NO_AHB            = 1 << 24   // Discard frames without descriptors r/w 0
+    };
+
+    // Useful bits in TX_STATUS
+    enum {                                      // Description              Type    Value after reset
+        TX_USED_READ                = 1 << 0,   // Ring exhausted           w1c     0
+        TX_COLLISION                = 1 << 1,   // Collision                w1c     0
+        TX_RETRY_EXCEEDED           = 1 << 2,   // Retry limit exceeded     w1c     0
+        TX_GO                       = 1 << 3,   // Transmitting             ro      0
+        TX_CORRUPTED                = 1 << 4,   // AHB error (frame lost)   w1c     0
+        TX_COMPLETE                 = 1 << 5,   // Frame sent               w1c     0
+        TX_UNDERRUN                 = 1 << 6,   // Underrun                 w1c     0
+        TX_LATE_COLLISION           = 1 << 7,   // Late collision           w1c     0
+        TX_HRESP_NOT_OK             = 1 << 8,   // AHB response error       w1c     0
+        TX_STATUS_ALL               = 0x1f7
+    };
+
+    // Useful bits in RX_STATUS
+    enum {                                      // Description              Type    Value after reset
+        RX_BUFFER_NOT_AVAIL         = 1 << 0,   // Ring exhausted           w1c     0
+        RX_FRAME_RECD               = 1 << 1,   // Frame received           w1c     0
+        RX_OVERRUN                  = 1 << 2,   // Overrun                  w1c     0
+        RX_HRESP_NOT_OK             = 1 << 3,   // AHB response error       w1c     0
+        RX_STATUS_ALL               = 0xf
+    };
+
+    // Useful bits in INTR_* registers
+    enum {                                      // Description              Type    Value after reset
+        INT_MGMT_DONE               = 1 << 0,   // PHY management done      w1c     0
+        INT_RX_COMPLETE             = 1 << 1,   // Frame received           w1c     0
+        INT_RX_USED_READ            = 1 << 2,   // RX ring exhausted        w1c     0
+        INT_TX_USED_READ            = 1 << 3,   // TX ring exhausted        w1c     0
+        INT_TX_UNDERRUN             = 1 << 4,   // TX underrun              w1c     0
+        INT_RETRY_EXCEEDED          = 1 << 5,   // Retry limit or late collision w1c 0
+        INT_TX_CORRUPTED            = 1 << 6,   // TX AHB error             w1c     0
+        INT_TX_COMPLETE             = 1 << 7,   // Frame sent               w1c     0
+        INT_RX_OVERRUN              = 1 << 10,  // RX overrun               w1c     0
+        INT_HRESP_NOT_OK            = 1 << 11,  // AHB response error       w1c     0
+        INT_ALL                     = 0x07ffffff
+    };
+
+    // PHY_MAINT fields (Clause 22 frames)
+    enum {
+        PHY_CLAUSE22                = 1 << 30,
+        PHY_READ                    = 2 << 28,
+        PHY_WRITE                   = 1 << 28,
+        PHY_ADDR_SHIFT              = 23,
+        PHY_REG_SHIFT               = 18,
+        PHY_MUST_10                 = 2 << 16,
+        PHY_DATA                    = 0xffff
+    };
+
+    // Standard PHY registers (IEEE 802.3 Clause 22) and useful bits
+    enum {
+        MII_BMSR                    = 0x01,     // Basic Status
+        MII_PHYID1                  = 0x02,
+        MII_LPA                     = 0x05,     // Link Partner Ability
+        MII_STAT1000                = 0x0a      // 1000BASE-T Status
+    };
+    enum {
+        BMSR_LINK                   = 1 << 2,
+        BMSR_ANEG_COMPLETE          = 1 << 5,
+        LPA_10FULL                  = 1 << 6,
+        LPA_100HALF                 = 1 << 7,
+        LPA_100FULL                 = 1 << 8,
+        STAT1000_HALF               = 1 << 10,
+        STAT1000_FULL               = 1 << 11
+    };
+
+    // Descriptors, two words each, in rings marked by WRAP on the last descriptor
+    // Words are written with the caches in mind (see Ethernet_NIC): the chip writes RX words 0 and 1 and TX word 1
+    struct Rx_Desc {
+        enum {                                  // Word 0
+            OWN     = 1 << 0,   // Used (set by the chip once the buffer is filled, the host owns the descriptor)
+            WRAP    = 1 << 1,   // Last descriptor in the ring
+            ADDR    = ~0x3U     // Buffer address (word aligned)
+        };
+        enum {                                  // Word 1 (status)
+            LENGTH  = 0x1fff,   // Frame length (without the FCS if FCS_REMOVE)
+            SOF     = 1 << 14,  // Start of frame
+            EOF     = 1 << 15,  // End of frame
+            CHKSUM  = 3 << 22   // Checksums verified (with RX_CHKSUM_OFFLOAD): 1 = IP, 2 = IP and TCP, 3 = IP and UDP
+        };
+
+        volatile Reg32 addr;
+        volatile Reg32 status;
+    };
+
+    struct Tx_Desc {
+        enum {                                  // Word 1 (control and status)
+            LENGTH  = 0x3fff,   // Buffer length
+            LAST    = 1 << 15,  // Last buffer of the frame
+            NO_CRC  = 1 << 16,  // Don't append the FCS
+            CHKSUM_ERR = 7 << 20, // Checksum generation error (the frame is sent as is)
+            CORRUPT = 1 << 27,  // AHB error
+            LATE_COLLISION = 1 << 26,
+            RETRY   = 1 << 29,  // Retry limit exceeded
+            WRAP    = 1 << 30,  // Last descriptor in the ring
+            USED    = 1U << 31  // Set by the host for descriptors the chip must not send and by the chip once sent
+        };
+
+        volatile Reg32 addr;
+        volatile Reg32 ctrl;
+    };
+
+public:
+    void halt() {
+        gem(NET_CTRL) = 0;
+        gem(INTR_DIS) = INT_ALL;
+        gem(INTR_STATUS) = INT_ALL;
+        gem(TX_STATUS) = TX_STATUS_ALL;
+        gem(RX_STATUS) = RX_STATUS_ALL;
+        gem(RX_QBAR) = 0;
+        gem(TX_QBAR) = 0;
+        gem(NET_CTRL) = CLEAR_STATS;
+    }
+
+    // Specific address 1, with the first byte on the wire in the least significant byte
+    unsigned long long mac() { return (static_cast<unsigned long long>(gem(SPEC_ADDR1_TOP) & 0xffff) << 32) | gem(SPEC_ADDR1_BOT); }
+    void mac(unsigned long long a) {
+        gem(SPEC_ADDR1_BOT) = a;
+        gem(SPEC_ADDR1_TOP) = a >> 32; // writing the top half enables the filter
+    }
+
+    // Clause 22 management, returns 0xffff if no PHY answers
+    int phy(unsigned int addr, unsigned int reg) {
+        if(!mdio_wait())
+            return 0xffff;
+        gem(PHY_MAINT) = PHY_CLAUSE22 | PHY_READ | (addr << PHY_ADDR_SHIFT) | (reg << PHY_REG_SHIFT) | PHY_MUST_10;
+        if(!mdio_wait())
+            return 0xffff;
+        return gem(PHY_MAINT) & PHY_DATA;
+    }
+    void phy(unsigned int addr, unsigned int reg, unsigned int value) {
+        if(!mdio_wait())
+            return;
+        gem(PHY_MAINT) = PHY_CLAUSE22 | PHY_WRITE | (addr << PHY_ADDR_SHIFT) | (reg << PHY_REG_SHIFT) | PHY_MUST_10 | (value & PHY_DATA);
+        mdio_wait();
+    }
 
-private:
     volatile Reg32 & gem(unsigned int o) { return reinterpret_cast<volatile Reg32 *>(this)[o / sizeof(Reg32)]; }
+
+private:
+    bool mdio_wait() {
+        for(unsigned int i = 0; i < 100000; i++)
+            if(gem(NET_STATUS) & MGMT_IDLE)
+                return true;
+        return false;
+    }
 };
 
 __END_SYS
@@ -13,11 +13,16 @@ __BEGIN_SYS
 class GIC: public IC_Common
 {
 protected:
+    typedef CPU::Reg8 Reg8;
     typedef CPU::Reg32 Reg32;
 
     static const unsigned int INT_ID_MASK = 0x3ff;
 
 public:
+    // Priorities as seen by EPOS (higher is more urgent) are mapped onto the 16 levels every GIC implements (the upper
+    // nibble of each priority byte, where lower is more urgent): p -> (PRIORITIES - p) << 4, so 0 is never signaled
+    static const unsigned int PRIORITIES = 15;
+
     // IRQs
     static const unsigned int IRQS = 92;
     typedef Interrupt_Id IRQ;
@@ -137,6 +142,8 @@ public:
         ICDICER1                    = 0x184,    // Interrupt Clear-Enable       r/w     0x00000000
         ICDICER2                    = 0x188,    // Interrupt Clear-Enable       r/w     0x00000000
         ICDICERn                    = 0x19c,    // Interrupt Clear-Enable       r/w     0x00000000
+        ICDIPR0                     = 0x400,    // Interrupt Priority (1 byte)  r/w     0x00000000
+        ICDIPTR0                    = 0x800,    // Interrupt CPU Targets (1 byte) r/w   0x00000000
         ICDSGIR                     = 0xf00     // Software Generated Interrupt
     };
 
@@ -173,6 +180,23 @@ public:
         gic_dist(ICDICER0 + (i / 32) * 4) = 1 << (i % 32);
     }
 
+    void priority(Interrupt_Id i, unsigned int p) {
+        reinterpret_cast<volatile Reg8 *>(this)[ICDIPR0 + i] = (PRIORITIES - p) << 4;
+    }
+
+    unsigned int priority(Interrupt_Id i) {
+        return PRIORITIES - (reinterpret_cast<volatile Reg8 *>(this)[ICDIPR0 + i] >> 4);
+    }
+
+    // Shared peripheral interrupts (from 32 on) are signaled to the CPUs in "cpus"; the others' targets are read-only
+    void targets(Interrupt_Id i, unsigned int cpus) {
+        reinterpret_cast<volatile Reg8 *>(this)[ICDIPTR0 + i] = cpus & 0xff;
+    }
+
+    unsigned int targets(Interrupt_Id i) {
+        return reinterpret_cast<volatile Reg8 *>(this)[ICDIPTR0 + i];
+    }
+
     void send_sgi(unsigned int cpu, Interrupt_Id i) {
         Reg32 target_list = 1 << cpu;
         Reg32 filter_list = 0;
@@ -232,9 +256,13 @@ public:
         return icciar;
     }
 
+    // Only interrupts of priority above the level are signaled (the mask is the level's priority byte)
+    void level(unsigned int l) { gic_cpu(ICCPMR) = (PRIORITIES - l) << 4; }
+    unsigned int level() { return PRIORITIES - (gic_cpu(ICCPMR) >> 4); }
+
     void init() {
         // Mask no interrupts
-        gic_cpu(ICCPMR) = 0xf0;
+        level(0);
 
         // Enable interrupts signaling by the CPU interfaces to the connected processors
         gic_cpu(ICCICR) = ACK_CTL | ITF_EN_NS | ITF_EN_S;
@@ -0,0 +1,220 @@
+// EPOS Cortex-A9 PL310 (L2C-310) L2 Cache Controller Mediator Declarations
+
+#ifndef __cortex_a9_pl310_h
+#define __cortex_a9_pl310_h
+
+#include <architecture/cpu.h>
+
+__BEGIN_SYS
+
+class PL310
+{
+    // This is a hardware object.
+    // Use with something like "new (Memory_Map::L2_CACHE_BASE) PL310".
+
+private:
+    typedef CPU::Reg32 Reg32;
+    typedef CPU::Phy_Addr Phy_Addr;
+    typedef CPU::Log_Addr Log_Addr;
+
+public:
+    static const unsigned int LINE = 32;
+    static const unsigned int MASTERS = 8;      // lockdown by master registers (the A9 cores are masters 0 to 3)
+
+    // Registers' offsets from BASE
+    enum {                                      // Description              Type    Value after reset
+        CACHE_ID                    = 0x000,    // Cache ID                 ro      0x410000c8
+        CACHE_TYPE                  = 0x004,    // Cache Type               ro      config
+        CTRL                        = 0x100,    // Control                  r/w     0x00000000
+        AUX_CTRL                    = 0x104,    // Auxiliary Control        r/w     config
+        TAG_RAM_CTRL                = 0x108,    // Tag RAM Latency Control  r/w     0x00000777
+        DATA_RAM_CTRL               = 0x10c,    // Data RAM Latency Control r/w     0x00000777
+        INT_MASK                    = 0x214,    // Interrupt Mask           r/w     0x00000000
+        INT_CLEAR                   = 0x220,    // Interrupt Clear          wo      -
+        CACHE_SYNC                  = 0x730,    // Cache Sync               r/w     0x00000000
+        INV_PA                      = 0x770,    // Invalidate Line by PA    r/w     0x00000000
+        INV_WAY                     = 0x77c,    // Invalidate by Way        r/w     0x00000000
+        CLEAN_PA                    = 0x7b0,    // Clean Line by PA         r/w     0x00000000
+        CLEAN_WAY                   = 0x7bc,    // Clean by Way             r/w     0x00000000
+        CLEAN_INV_PA                = 0x7f0,    // Clean+Inv Line by PA     r/w     0x00000000
+        CLEAN_INV_WAY               = 0x7fc,    // Clean+Inv by Way         r/w     0x00000000
+        D_LOCKDOWN                  = 0x900,    // Data Lockdown (+ 8 * m)  r/w     0x00000000
+        I_LOCKDOWN                  = 0x904,    // Instr Lockdown (+ 8 * m) r/w     0x00000000
+        DEBUG_CTRL                  = 0xf40,    // Debug Control            r/w     0x00000000
+        PREFETCH_CTRL               = 0xf60,    // Prefetch Control         r/w     0x00000000
+        POWER_CTRL                  = 0xf80     // Power Control            r/w     0x00000000
+    };
+
+    // Useful bits in CTRL
+    enum {                                      // Description              Type    Value after reset
+        L2_ENABLE                   = 1 << 0    // L2 Cache enable          r/w     0
+    };
+
+    // Useful bits in AUX_CTRL
+    enum {                                      // Description              Type    Value after reset
+        ASSOCIATIVITY               = 1 << 16,  // 16-way (8-way if 0)      r/w     config
+        SHARED_OVERRIDE             = 1 << 22,  // Shared attribute override r/w    0
+        ROUND_ROBIN                 = 1 << 25,  // Round-robin replacement  r/w     0
+        DATA_PREFETCH               = 1 << 28,  // Data prefetch enable     r/w     0
+        INSTR_PREFETCH              = 1 << 29,  // Instr prefetch enable    r/w     0
+        EARLY_BRESP                 = 1 << 30   // Early BRESP enable       r/w     0
+    };
+
+    // Useful bits in PREFETCH_CTRL (the prefetch enables mirror those in AUX_CTRL)
+    enum {                                      // Description              Type    Value after reset
+        PREFETCH_OFFSET             = 0x1f << 0,// Prefetch offset          r/w     0
+        INCR_DOUBLE_LINEFILL        = 1 << 23,  // Incr double linefill     r/w     0
+        PREFETCH_DROP               = 1 << 24,  // Prefetch drop enable     r/w     0
+        DOUBLE_LINEFILL             = 1 << 30   // Double linefill enable   r/w     0
+    };
+
+    // Useful bits in POWER_CTRL
+    enum {                                      // Description              Type    Value after reset
+        STANDBY_MODE                = 1 << 0,   // Standby mode enable      r/w     0
+        DYNAMIC_CLK_GATING          = 1 << 1    // Dynamic clock gating     r/w     0
+    };
+
+public:
+    bool enabled() { return l2(CTRL) & L2_ENABLE; }
+
+    // The L2 must be invalidated before it is enabled and configured (AUX_CTRL, latencies and prefetching) while disabled
+    void enable() {
+        if(!enabled()) {
+            invalidate();
+            l2(INT_CLEAR) = ~0U;
+            l2(CTRL) = L2_ENABLE;
+            CPU::dsb();
+        }
+    }
+
+    void disable() {
+        if(enabled()) {
+            flush();
+            l2(CTRL) = 0;
+            CPU::dsb();
+        }
+    }
+
+    // RAM latencies, as required by the SoC, encoded as "(write - 1) << 8 | (read - 1) << 4 | (setup - 1)" cycles
+    // (left at the slowest, 8 cycles each, after reset)
+    void latencies(Reg32 tag, Reg32 data) {
+        l2(TAG_RAM_CTRL) = tag;
+        l2(DATA_RAM_CTRL) = data;
+    }
+
+    // Prefetching of the "offset"-th next line on misses, with double linefills (64 bytes in a single AXI burst)
+    // The Cortex-A9 cores must also send the L2 their prefetch hints, which is enabled through their ACTLR
+    void prefetch(bool on, unsigned int offset = 7) {
+        Reg32 aux = l2(AUX_CTRL) & ~(DATA_PREFETCH | INSTR_PREFETCH | EARLY_BRESP);
+        Reg32 ctrl = 0;
+        if(on) {
+            aux |= DATA_PREFETCH | INSTR_PREFETCH | EARLY_BRESP;
+            ctrl = DATA_PREFETCH | INSTR_PREFETCH | DOUBLE_LINEFILL | INCR_DOUBLE_LINEFILL | PREFETCH_DROP
+                 | (offset & PREFETCH_OFFSET);
+        }
+        l2(AUX_CTRL) = aux;
+        l2(PREFETCH_CTRL) = ctrl;
+    }
+
+    // Round-robin replacement makes way usage (and thus misses) more predictable than the default pseudo-random policy
+    void round_robin(bool on) {
+        if(on)
+            l2(AUX_CTRL) |= ROUND_ROBIN;
+        else
+            l2(AUX_CTRL) &= ~ROUND_ROBIN;
+    }
+
+    void power(bool standby, bool clock_gating) {
+        l2(POWER_CTRL) = (standby ? STANDBY_MODE : 0) | (clock_gating ? DYNAMIC_CLK_GATING : 0);
+    }
+
+    unsigned int ways() { return (l2(AUX_CTRL) & ASSOCIATIVITY) ? 16 : 8; }
+    Reg32 all_ways() { return (1 << ways()) - 1; }
+
+    // Whole cache maintenance, by way
+    void invalidate() { way_operation(INV_WAY, all_ways()); }
+    void clean() { way_operation(CLEAN_WAY, all_ways()); }
+    void flush() { way_operation(CLEAN_INV_WAY, all_ways()); }
+
+    // Range maintenance, by physical address, to run after the corresponding L1 operations (see CPU::cache_clean())
+    void invalidate(Phy_Addr addr, unsigned int bytes) { line_operation(INV_PA, addr, bytes); }
+    void clean(Phy_Addr addr, unsigned int bytes) { line_operation(CLEAN_PA, addr, bytes); }
+    void flush(Phy_Addr addr, unsigned int bytes) { line_operation(CLEAN_INV_PA, addr, bytes); }
+
+    void sync() {
+        l2(CACHE_SYNC) = 0;
+        while(l2(CACHE_SYNC) & 1);
+    }
+
+    // Partitioning: restricts the allocations of "master" (i.e. CPU) to "ways" (a bitmap), so the working sets of
+    // different cores cannot evict one another. Masters keep hitting on lines in every way. Locked ways stay locked.
+    void partition(unsigned int master, Reg32 ways) {
+        Reg32 lockdown = (~ways | locked_ways()) & all_ways();
+        l2(D_LOCKDOWN + 8 * master) = lockdown;
+        l2(I_LOCKDOWN + 8 * master) = lockdown;
+    }
+
+    // Way-locking: loads [addr, addr + bytes) into "ways", which are then locked for all masters, so real-time code and
+    // data stay in the L2 until unlock(). "ways" must hold the range and must not be busy with anything else the caller
+    // cares about. Called with interrupts disabled and the other cores kept out of the range, since the L1 copies are
+    // flushed and reloaded through the L2. "addr" is both logical and physical (flat memory model).
+    void lock(Log_Addr addr, unsigned int bytes, Reg32 ways) {
+        unsigned int master = CPU::id();
+        Reg32 d = l2(D_LOCKDOWN + 8 * master);
+        Reg32 i = l2(I_LOCKDOWN + 8 * master);
+
+        CPU::cache_flush(addr, bytes);
+        flush(Phy_Addr(addr), bytes);
+
+        // Allocate only into "ways" while the range is loaded, for data and instructions (the L2 is unified)
+        l2(D_LOCKDOWN + 8 * master) = ~ways & all_ways();
+        l2(I_LOCKDOWN + 8 * master) = ~ways & all_ways();
+        for(Reg32 a = Reg32(addr) & ~(LINE - 1); a < Reg32(addr) + bytes; a += LINE)
+            (void)*reinterpret_cast<volatile Reg32 *>(a);
+        CPU::dsb();
+
+        l2(D_LOCKDOWN + 8 * master) = d;
+        l2(I_LOCKDOWN + 8 * master) = i;
+        for(unsigned int m = 0; m < MASTERS; m++) {
+            l2(D_LOCKDOWN + 8 * m) |= ways;
+            l2(I_LOCKDOWN + 8 * m) |= ways;
+        }
+        CPU::dsb();
+    }
+
+    void unlock(Reg32 ways) {
+        for(unsigned int m = 0; m < MASTERS; m++) {
+            l2(D_LOCKDOWN + 8 * m) &= ~ways;
+            l2(I_LOCKDOWN + 8 * m) &= ~ways;
+        }
+        CPU::dsb();
+    }
+
+    // Ways locked for every master (by lock())
+    Reg32 locked_ways() {
+        Reg32 ways = all_ways();
+        for(unsigned int m = 0; m < MASTERS; m++)
+            ways &= l2(D_LOCKDOWN + 8 * m) & l2(I_LOCKDOWN + 8 * m);
+        return ways;
+    }
+
+private:
+    void way_operation(unsigned int o, Reg32 ways) {
+        l2(o) = ways;
+        while(l2(o) & ways);
+        sync();
+    }
+
+    void line_operation(unsigned int o, Phy_Addr addr, unsigned int bytes) {
+        for(Reg32 a = Reg32(addr) & ~(LINE - 1); a < Reg32(addr) + bytes; a += LINE)
+            l2(o) = a;
+        sync();
+    }
+
+protected:
+    volatile Reg32 & l2(unsigned int o) { return reinterpret_cast<volatile Reg32 *>(this)[o / sizeof(Reg32)]; }
+};
+
+__END_SYS
+
+#endif
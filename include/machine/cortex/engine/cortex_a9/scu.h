@@ -19,16 +19,34 @@ public:
     // Registers' offsets from BASE
     enum {                                      // Description              Type    Value after reset
         SCU_CTRL                    = 0x00,     // Control                  r/w     0x00000128
-        SCU_CONFIG                  = 0x04,     // Configuration            r/w     0x00000000
+        SCU_CONFIG                  = 0x04,     // Configuration            ro      config
         SCU_PSTAT                   = 0x08,     // Power Status             r/w     0x00000000
         SCU_IARSS                   = 0x0c      // Invalidate All Reg Secure State
     };
 
+    // Useful bits in SCU_CTRL
+    enum {                                      // Description              Type    Value after reset
+        SCU_ENABLE                  = 1 << 0,   // SCU enable               r/w     0
+        SPECULATIVE_LINEFILLS       = 1 << 3    // L2 speculative linefills r/w     0
+    };
+
 public:
+    bool enabled() { return scu(SCU_CTRL) & SCU_ENABLE; }
+
     void enable() {
-        scu(0) |= 0x1;
+        scu(SCU_CTRL) |= SCU_ENABLE;
     }
 
+    // Lets the SCU start L2 linefills in parallel with its tag lookups (for the PL310 L2 cache controller)
+    void speculative_linefills(bool on) {
+        if(on)
+            scu(SCU_CTRL) |= SPECULATIVE_LINEFILLS;
+        else
+            scu(SCU_CTRL) &= ~SPECULATIVE_LINEFILLS;
+    }
+
+    unsigned int cpus() { return (scu(SCU_CONFIG) & 0x3) + 1; }
+
     void secure_invalidate() {
         // This function invalidates the SCU copy of the TAG RAMs for the core.  Typically only done at start-up.
         // Possible flow:
@@ -40,8 +58,19 @@ public:
         scu(SCU_IARSS) = ways;
     }
 
+    void invalidate_all() {
+        scu(SCU_IARSS) = 0xffff;        // all four ways of all four cores
+    }
+
+    // Coherency among the cores' L1 data caches: the first core to get here (the BSP, before the others are released)
+    // invalidates the SCU's duplicate tags and enables it, then each core joins the SMP coherency domain and broadcasts
+    // its cache and TLB maintenance operations to the others
     void enable_cache_coherence() {
-        scu(SCU_CONFIG) |= 0xf0;
+        if(!enabled()) {
+            invalidate_all();
+            enable();
+        }
+        CPU::actlr(CPU::actlr() | CPU::SMP | CPU::FW);
     }
 
 protected:
@@ -112,6 +112,14 @@ public:
     void enable()  { gptm(GPTMCTL) |= TAEN; }
     void disable() { gptm(GPTMCTL) &= ~TAEN; }
 
+    // Trigger an ADC conversion at each time-out
+    void adc_trigger(bool on) {
+        if(on)
+            gptm(GPTMCTL) |= TAOTE;
+        else
+            gptm(GPTMCTL) &= ~TAOTE;
+    }
+
     void delay(const Count & offset) {
         gptm(GPTMTAILR) = offset;
         gptm(GPTMTAPR) = 0;
@@ -144,6 +152,23 @@ public:
         enable();
     }
 
+    // Counts per PWM period, the prescaler extending the 16-bit interval
+    Count pwm_period() { return gptm(GPTMTAILR) + (gptm(GPTMTAPR) << 16); }
+    Count pwm_count(const Percent & duty_cycle) { return Convert::percent2count(duty_cycle, pwm_period() & 0x00ffffff); }
+
+    // Match register (its 16 LSBs), as the destination of DMA transfers that set the duty cycle of each period
+    volatile Reg32 * pwm_match() { return &gptm(GPTMTAMATCHR); }
+
+    // A capture event (and the uDMA request of the timer) at a rising edge of each period, with the match register
+    // only taken at time-outs, so each value written holds for a whole period
+    void pwm_event(bool on) {
+        if(on) {
+            gptm(GPTMCTL) &= ~(3 * TAEVENT);
+            gptm(GPTMTAMR) |= TPWMIE | TMRSU;
+        } else
+            gptm(GPTMTAMR) &= ~(TPWMIE | TMRSU);
+    }
+
     Hertz clock() { return CLOCK; }
 
     void eoi(IC::Interrupt_Id id) { gptm(GPTMICR) = -1; }
@@ -10,6 +10,7 @@
 #include <machine/gpio.h>
 #include <machine/nic.h>
 #include <network/modem.h>
+#include <utility/at.h>
 
 __BEGIN_SYS
 
@@ -60,6 +61,9 @@ public:
 
     RSSI rssi();
 
+    // Non-blocking commands, pipelined by the AT_Engine from the UART interrupts (see utility/at.h)
+    void submit(AT_Engine::Command * c) { _at.submit(c); }
+
     static M95 * get(unsigned int unit = 0) { return get_by_unit(unit); }
 
     static void init(unsigned int unit);
@@ -86,6 +90,7 @@ private:
     GPIO * _pwrkey;
     GPIO * _status;
     UART * _uart;
+    AT_Engine _at;
     bool _http_data_mode;
     TSC::Time_Stamp _last_send;
     TSC::Time_Stamp _init_timeout;
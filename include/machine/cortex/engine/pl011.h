@@ -82,6 +82,7 @@ public:
     // Useful Bits in the Control Register
     enum {                              // Description                  Type    Value after reset
         UEN             = 1 <<  0,      // Enable                       r/w     0
+        EOT             = 1 <<  4,      // End of Transmission          r/w     0 (CC2538 and Stellaris only)
         LBE             = 1 <<  7,      // Loop Back Enable             r/w     0
         TXE             = 1 <<  8,      // Transmit Enable              r/w     1
         RXE             = 1 <<  9       // Receive Enable               r/w     1
@@ -99,6 +100,22 @@ public:
         UIMALL          = 0
     };
 
+    // Useful Bits in the DMA Control Register
+    enum {                              // Description                  Type    Value after reset
+        RXDMAE          = 1 <<  0,      // Receive DMA Enable           r/w     0
+        TXDMAE          = 1 <<  1,      // Transmit DMA Enable          r/w     0
+        DMAONERR        = 1 <<  2       // Stop RX DMA on Error         r/w     0
+    };
+
+    // FIFO levels (of 16) that raise interrupts and DMA burst requests (IFLS: RX in [5:3], TX in [2:0])
+    enum {
+        LEVEL_1_8       = 0,
+        LEVEL_1_4       = 1,
+        LEVEL_1_2       = 2,
+        LEVEL_3_4       = 3,
+        LEVEL_7_8       = 4
+    };
+
 public:
     void config(unsigned int baud_rate, unsigned int data_bits, unsigned int parity, unsigned int stop_bits) {
         Reg32 lcrh = data_bits == 8 ? WLEN8 : data_bits == 7 ? WLEN7 : data_bits = 6 ? WLEN6 : WLEN5; // config data bits
@@ -160,6 +177,32 @@ public:
             uart(UCR) &= ~LBE;
     }
 
+    // With EOT set, the TX interrupt is only raised once the last stop bit has left the serializer
+    void end_of_transmission(bool flag) {
+        if(flag)
+            uart(UCR) |= int(EOT);
+        else
+            uart(UCR) &= ~EOT;
+    }
+
+    void fifo_levels(unsigned int rx, unsigned int tx) { uart(IFLS) = (rx << 3) | tx; }
+
+    // Interrupt sources (UIM* bits) raised to the IC, as given (int_enable() is kept for polling operation)
+    void int_sources(Reg32 sources) { uart(UIM) = sources; }
+    Reg32 int_status() { return uart(MIS); }
+    void int_clear(Reg32 sources) { uart(ICR) = sources; }
+
+    // Framing, parity, break and overrun errors since the last clear_errors()
+    Reg32 errors() { return uart(RSR) & 0xf; }
+    void clear_errors() { uart(ECR) = 0; }
+
+    // Let the FIFOs request DMA transfers (flags are TXDMAE and RXDMAE)
+    void dma_enable(Reg32 flags) { uart(DMACR) |= flags; }
+    void dma_disable(Reg32 flags) { uart(DMACR) &= ~flags; }
+
+    // Data register, as the source or destination of DMA transfers
+    volatile Reg32 * data() { return &uart(DR); }
+
 private:
     volatile Reg32 & uart(unsigned int o) { return reinterpret_cast<volatile Reg32 *>(this)[o / sizeof(Reg32)]; }
 };
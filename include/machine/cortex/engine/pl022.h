@@ -163,7 +163,7 @@ public:
                                     // Gives the raw interrupt state (after masking) of SSIRORINTR
     };
 
-    // Useful bits in the SSI ICR register
+    // Useful bits in the SSI DMACTL register
     enum {                          // Description                              Type    Value after reset
         TXDMAE            = 1 << 1, // Transmit DMA enable                             RW        0x00
                                     // 0: uDMA for the transmit FIFO is disabled.
@@ -296,6 +296,18 @@ public:
         return ssi(CC);
     }
 
+    // Let the FIFOs request DMA transfers (flags are TXDMAE and RXDMAE)
+    void dma_enable(Reg32 flags) {
+        ssi(DMACTL) |= flags;
+    }
+
+    void dma_disable(Reg32 flags) {
+        ssi(DMACTL) &= ~flags;
+    }
+
+    // Data register, as the source or destination of DMA transfers
+    volatile Reg32 * data() { return &ssi(DR); }
+
 private:
     volatile Reg32 & ssi(unsigned int o) { return reinterpret_cast<volatile Reg32 *>(this)[o / sizeof(Reg32)]; }
 };
@@ -0,0 +1,154 @@
+// EPOS ARM PrimeCell PL230 Micro DMA Controller (uDMA) Mediator Declarations
+
+#ifndef __pl230_h
+#define __pl230_h
+
+#include <architecture/cpu.h>
+
+__BEGIN_SYS
+
+class PL230
+{
+    // This is a hardware object.
+    // Use with something like "new (Memory_Map::UDMA_BASE) PL230".
+
+private:
+    typedef CPU::Reg32 Reg32;
+
+public:
+    static const unsigned int CHANNELS = 32;
+    static const unsigned int MAX_TRANSFER = 1024; // items per cycle
+
+    // Registers offsets from BASE (i.e. this)
+    enum {                              // Description                          Type    Value after reset
+        STAT            = 0x000,        // Status                               ro      0x001f0000
+        CFG             = 0x004,        // Configuration                        wo      -
+        CTLBASE         = 0x008,        // Channel Control Base Pointer         rw      0x00000000
+        ALTBASE         = 0x00c,        // Alternate Channel Control Base       ro      0x00000200
+        WAITSTAT        = 0x010,        // Channel Wait-on-Request Status       ro      0x03c3cf00
+        SWREQ           = 0x014,        // Channel Software Request             wo      -
+        USEBURSTSET     = 0x018,        // Channel Useburst Set                 rw      0x00000000
+        USEBURSTCLR     = 0x01c,        // Channel Useburst Clear               wo      -
+        REQMASKSET      = 0x020,        // Channel Request Mask Set             rw      0x00000000
+        REQMASKCLR      = 0x024,        // Channel Request Mask Clear           wo      -
+        ENASET          = 0x028,        // Channel Enable Set                   rw      0x00000000
+        ENACLR          = 0x02c,        // Channel Enable Clear                 wo      -
+        ALTSET          = 0x030,        // Channel Primary Alternate Set        rw      0x00000000
+        ALTCLR          = 0x034,        // Channel Primary Alternate Clear      wo      -
+        PRIOSET         = 0x038,        // Channel Priority Set                 rw      0x00000000
+        PRIOCLR         = 0x03c,        // Channel Priority Clear               wo      -
+        ERRCLR          = 0x04c,        // Bus Error Clear                      rw      0x00000000
+        CHASGN          = 0x500,        // Channel Assignment                   rw      0x00000000
+        CHIS            = 0x504,        // Channel Interrupt Status             w1c     0x00000000
+        CHMAP0          = 0x510         // Channel Map Select 0 (to 3)          rw      0x00000000
+    };
+
+    // Useful bits in the CFG register
+    enum {                              // Description                          Type    Value after reset
+        MASTEN          = 1 << 0        // Controller Master Enable             wo      0
+    };
+
+    // Channel control word (the third word of a Control structure)
+    enum {                              // Description
+        DST_INC         = 30,           // Destination increment (shift)
+        DST_SIZE        = 28,           // Destination data size (shift)
+        SRC_INC         = 26,           // Source increment (shift)
+        SRC_SIZE        = 24,           // Source data size (shift)
+        ARB_SIZE        = 14,           // Arbitration size (shift), as a power of 2
+        XFER_SIZE       = 4,            // Transfer size minus 1 (shift, 10 bits)
+        NXT_USEBURST    = 1 << 3,       // Next useburst
+        MODE_STOP       = 0,            // Transfer mode
+        MODE_BASIC      = 1,
+        MODE_AUTO       = 2,
+        MODE_PINGPONG   = 3
+    };
+
+    // Data sizes and increments
+    enum Size {
+        SIZE_8          = 0,
+        SIZE_16         = 1,
+        SIZE_32         = 2,
+        INC_NONE        = 3
+    };
+
+    // Primary (or alternate) channel control structure, in the table pointed by CTLBASE
+    struct Control {
+        volatile Reg32 src_end;         // address of the last item read
+        volatile Reg32 dst_end;         // address of the last item written
+        volatile Reg32 control;
+        Reg32 unused;
+    };
+
+    // The table holds the primary structures followed by the alternate ones and must be aligned to its own size
+    static const unsigned int TABLE_SIZE = 2 * CHANNELS;
+    static const unsigned int TABLE_ALIGNMENT = TABLE_SIZE * sizeof(Control);
+
+public:
+    void config(Control * table) {
+        dma(CFG) = MASTEN;
+        dma(CTLBASE) = reinterpret_cast<Reg32>(table);
+    }
+
+    Control * table() { return reinterpret_cast<Control *>(dma(CTLBASE)); }
+
+    // Sets up "channel" for a cycle of "n" items of "size" bytes each, reading from "src" and writing to "dst", either
+    // of which might be a peripheral register ("inc" false). The channel only moves once it is enabled. In ping-pong
+    // mode, the primary and the alternate structures take turns, each one being set up again after it completes.
+    void setup(unsigned int channel, const volatile void * src, bool src_inc, volatile void * dst, bool dst_inc,
+               unsigned int n, const Size & size, unsigned int arb_log2, bool alternate = false, unsigned int mode = MODE_BASIC) {
+        Control * c = &table()[alternate ? CHANNELS + channel : channel];
+        Reg32 width = 1 << size;
+        c->src_end = reinterpret_cast<Reg32>(src) + (src_inc ? (n - 1) * width : 0);
+        c->dst_end = reinterpret_cast<Reg32>(dst) + (dst_inc ? (n - 1) * width : 0);
+        c->control = ((dst_inc ? size : INC_NONE) << DST_INC) | (size << DST_SIZE)
+                   | ((src_inc ? size : INC_NONE) << SRC_INC) | (size << SRC_SIZE)
+                   | (arb_log2 << ARB_SIZE) | ((n - 1) << XFER_SIZE) | mode;
+    }
+
+    // Peripheral source ("encoding") of "channel" (see the channel assignment table of the SoC)
+    void map(unsigned int channel, unsigned int encoding) {
+        volatile Reg32 & m = dma(CHMAP0 + (channel / 8) * sizeof(Reg32));
+        unsigned int shift = (channel % 8) * 4;
+        m = (m & ~(0xf << shift)) | ((encoding & 0xf) << shift);
+    }
+
+    // Items still to be moved by the cycle of "channel" (0 once it is complete), which the controller writes back to the
+    // table after each arbitration
+    unsigned int left(unsigned int channel, bool alternate = false) {
+        Reg32 control = table()[alternate ? CHANNELS + channel : channel].control;
+        return (control & MODE_PINGPONG) ? ((control >> XFER_SIZE) & 0x3ff) + 1 : 0;
+    }
+
+    // Whether the alternate structure of "channel" is the one in use
+    bool alternate(unsigned int channel) { return dma(ALTSET) & (1 << channel); }
+
+    void enable(unsigned int channel) { dma(ENASET) = 1 << channel; }
+    void disable(unsigned int channel) { dma(ENACLR) = 1 << channel; }
+    bool enabled(unsigned int channel) { return dma(ENASET) & (1 << channel); }
+
+    void attributes(unsigned int channel, bool burst_only, bool high_priority) {
+        dma(burst_only ? USEBURSTSET : USEBURSTCLR) = 1 << channel;
+        dma(high_priority ? PRIOSET : PRIOCLR) = 1 << channel;
+        dma(ALTCLR) = 1 << channel;
+        dma(REQMASKCLR) = 1 << channel;
+    }
+
+    // Software-driven channels (e.g. memory to a FIFO in MODE_AUTO) ignore the requests of the mapped peripheral and
+    // run a whole cycle per request()
+    void mask(unsigned int channel) { dma(REQMASKSET) = 1 << channel; }
+    void request(unsigned int channel) { dma(SWREQ) = 1 << channel; }
+
+    // Channels that completed a cycle since the last ack()
+    Reg32 done() { return dma(CHIS); }
+    void ack(Reg32 channels) { dma(CHIS) = channels; }
+
+    bool error() { return dma(ERRCLR); }
+    void clear_error() { dma(ERRCLR) = 1; }
+
+private:
+    volatile Reg32 & dma(unsigned int o) { return reinterpret_cast<volatile Reg32 *>(this)[o / sizeof(Reg32)]; }
+};
+
+__END_SYS
+
+#endif
@@ -50,6 +50,15 @@ public:
 
     static void ipi(unsigned int cpu, Interrupt_Id i) {} // Cortex-M3 is always single-core
 
+    // Interrupt priorities are not used (handlers already run in thread mode, see IC::entry())
+    static const unsigned int PRIORITIES = 0;
+    static void priority(Interrupt_Id i, unsigned int p) {}
+    static unsigned int priority(Interrupt_Id i) { return 0; }
+
+    static bool affinity(Interrupt_Id i, unsigned long cpus) { return false; }
+    static void level(unsigned int l) {}
+    static unsigned int level() { return 0; }
+
     static void init() { nvic()->init(); };
 
 private:
@@ -25,6 +25,7 @@ public:
 
     using Machine_Common::delay;
     using Machine_Common::clear_bss;
+    using Machine_Common::temperature;
 
     static void reboot() { scb()->reboot(); }
     static void poweroff() { reboot(); }
@@ -44,6 +45,11 @@ private:
 
 typedef LM3S811 Machine_Model;
 
+// No frequency scaling: the clock is fixed by the platform
+inline void CPU::clock(const Hertz & frequency) {}
+inline Hertz CPU::max_clock() { return Traits<CPU>::CLOCK; }
+inline Hertz CPU::min_clock() { return Traits<CPU>::CLOCK; }
+
 __END_SYS
 
 #endif
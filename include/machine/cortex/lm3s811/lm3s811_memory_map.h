@@ -34,6 +34,7 @@ struct Memory_Map: public Cortex_Memory_Map
         SCB_BASE                = 0xe000e000, // System Control Block
         
         VECTOR_TABLE            = Traits<Machine>::APP_CODE,
+        DATA_IMAGE              = Traits<Machine>::XIP ? Traits<Machine>::DATA_IMAGE : NOT_USED, // .data's initial values
         BOOT_STACK              = RAM_TOP + 1 - Traits<Machine>::STACK_SIZE, // will be used as the stack's base, not the stack pointer; SIZE = Traits<Machine>::STACK_SIZE
         FREE_TOP                = BOOT_STACK,
 
@@ -39,11 +39,19 @@ template<> struct Traits<Machine>: public Traits<Machine_Common>
     static const unsigned int APP_CODE          = ROM_BASE;
     static const unsigned int APP_DATA          = RAM_BASE;
 
+    // Execute in place: with XIP, .data's initial values are stored in flash at DATA_IMAGE and copied to APP_DATA at
+    // boot (see _ram_init()), so images can be flashed. Otherwise, they must be loaded into RAM (e.g. by a debugger).
+    static const bool XIP                       = false;
+    static const unsigned int DATA_IMAGE        = ROM_BASE + 64 * 1024 - (RAM_TOP + 1 - RAM_BASE); // the top of flash
+
     static const unsigned int INIT              = NOT_USED;
     static const unsigned int PHY_MEM           = NOT_USED;
     static const unsigned int IO                = NOT_USED;
     static const unsigned int SYS               = NOT_USED;
 
+    // CPUs (with consecutive ids) sharing a cache beyond L1 (single core)
+    static const unsigned int CACHE_SHARING     = 1;
+
     // Default Sizes and Quantities
     static const unsigned int MAX_THREADS       = 8;
     static const unsigned int STACK_SIZE        = 512;
@@ -53,6 +61,13 @@ template<> struct Traits<Machine>: public Traits<Machine_Common>
 template<> struct Traits<IC>: public Traits<Machine_Common>
 {
     static const bool debugged = hysterically_debugged;
+    static const bool nested = false; // handlers already run in thread mode, preemptable by any interrupt
+
+    // Per-CPU interrupt stack (0 keeps handlers on the interrupted thread's stack, which must then have room for them)
+    static const unsigned int STACK_SIZE = 0;
+    static const bool deferred = false; // without STACK_SIZE, still leave the reschedules of handlers to the outermost one's exit
+
+    static const bool static_vectors = false; // handlers bound at compile time (IC::bound()), so the vector tables are in flash
 };
 
 template<> struct Traits<Timer>: public Traits<Machine_Common>
@@ -84,6 +99,11 @@ template<> struct Traits<GPIO>: public Traits<Machine_Common>
 {
     static const unsigned int UNITS = 5;
     static const bool supports_power_up = false;
+
+    static const bool queued = false;           // edges time-stamped into a ring by the ISR and notified in batches by a thread
+    static const unsigned int EVENTS = 64;      // per pin, a power of two
+    static const unsigned int BATCH = 16;       // edges pending before observers are notified
+    static const unsigned int LATENCY = 10000;  // us an edge may wait for its batch to fill (0 = notify right away)
 };
 
 template<> struct Traits<Serial_Display>: public Traits<Machine_Common>
@@ -94,6 +114,7 @@ template<> struct Traits<Serial_Display>: public Traits<Machine_Common>
     static const int COLUMNS = 80;
     static const int LINES = 24;
     static const int TAB_SIZE = 8;
+    static const unsigned int BUFFER_SIZE = 0; // bytes waiting for the engine (0 = synchronous)
 };
 
 template<> struct Traits<Serial_Keyboard>: public Traits<Machine_Common>
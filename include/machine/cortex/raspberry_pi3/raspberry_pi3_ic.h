@@ -39,11 +39,13 @@ public:
         INT_SPI                 = EXCS + SPI_INT,
         INT_GPU                 = EXCS + MAILBOX_GPU_IRQ,
         INT_PMU                 = EXCS + MAILBOX_PMU_IRQ,
-        INT_AIX                 = EXCS + MAILBOX_AIX_IRQ
+        INT_AIX                 = EXCS + MAILBOX_AIX_IRQ,
+        INT_RESCHEDULER         = EXCS + MAILBOX0_IRQ // IPIs (see BCM_Mailbox::ipi())
     };
 
 public:
-    static void enable() { /* irq()->enable(); */ mbox()->enable(); } // FIXME
+    // Only the mailboxes are masked and unmasked on the calling core; GPU IRQs are shared, so they are only touched one by one
+    static void enable() { mbox()->enable(); }
 
     static void enable(Interrupt_Id i) {
         assert(i <= INTS);
@@ -54,7 +56,7 @@ public:
             mbox()->enable(j);
     }
 
-    static void disable() { /* irq()->disable(); mbox()->disable(); */ } // FIXME
+    static void disable() { mbox()->disable(); }
 
     static void disable(unsigned int i) {
         assert(i <= INTS);
@@ -76,10 +78,12 @@ public:
         }
 #endif
         id = mbox()->int_id(); // check mailbox
-        if(id == INT_UNKNOWN)  // if it wasn't the mailbox that triggered the interrupt, then check IRQ
+        if(id == MAILBOX0_IRQ) // IPIs are acknowledged right away, so another one sent while this is handled isn't lost
+            mbox()->eoi(id);
+        else if(id == INT_UNKNOWN)  // if it wasn't the mailbox that triggered the interrupt, then check IRQ
             id = irq()->int_id();
         return EXCS + id;
-}
+    }
 
     static Interrupt_Id irq2int(Interrupt_Id i) { return i + EXCS; }
     static Interrupt_Id int2irq(Interrupt_Id i) { return i - EXCS; }
@@ -88,6 +92,15 @@ public:
 
     static void mailbox_eoi(Interrupt_Id i) { mbox()->eoi(i); }
 
+    // The BCM2836 controller has no priorities
+    static const unsigned int PRIORITIES = 0;
+    static void priority(Interrupt_Id i, unsigned int p) {}
+    static unsigned int priority(Interrupt_Id i) { return 0; }
+
+    static bool affinity(Interrupt_Id i, unsigned long cpus) { return false; }
+    static void level(unsigned int l) {}
+    static unsigned int level() { return 0; }
+
     static void init() { irq()->init(); mbox()->init(); };
 
 private:
@@ -13,6 +13,7 @@ struct System_Info: public System_Info_Common
     Boot_Map bm;
     Physical_Memory_Map pmm;
     Kernel_Load_Map lm;
+    Boot_Profile bp;
 };
 
 __END_SYS
@@ -7,6 +7,7 @@
 #include <system/memory_map.h>
 #include <system.h>
 #include <machine/cortex/raspberry_pi3/raspberry_pi3_ioctrl.h>
+#include <machine/cortex/engine/cortex_a53/bcm_mailbox.h>
 
 __BEGIN_SYS
 
@@ -29,9 +30,21 @@ public:
 
     static const UUID & uuid() { return System::info()->bm.uuid; }
 
+    // Asked to the VideoCore firmware through the property mailbox, which answers in m°C
+    static int temperature() {
+        IOCtrl * ioc = new (reinterpret_cast<IOCtrl *>(Memory_Map::MBOX_BASE)) IOCtrl;
+        return ioc->temperature();
+    }
+
 private:
     static void pre_init() {}
-    static void init() {}
+
+    // The other cores skip IC::init() at Machine::pre_init(), so they only set up their own mailboxes, through which
+    // they get IPIs (see IC::INT_RESCHEDULER)
+    static void init() {
+        if(CPU::id() != 0)
+            reinterpret_cast<BCM_Mailbox *>(Memory_Map::MBOX_CTRL_BASE)->init();
+    }
 };
 
 typedef Raspberry_Pi3 Machine_Model;
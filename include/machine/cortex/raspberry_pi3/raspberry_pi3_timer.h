@@ -33,7 +33,11 @@ public:
 public:
     Count read() { return timer()->read(); }
 
+    // There is a single tick for all cores, which interrupts core 0 (see Timer::int_handler())
     static void reset() {
+        if(CPU::id() != 0)
+            return;
+
         disable();
         _count = timer()->clock() / FREQUENCY;
         timer()->config(UNIT, _count);
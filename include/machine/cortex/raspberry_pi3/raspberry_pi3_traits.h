@@ -46,6 +46,9 @@ public:
     static const unsigned int IO                = 0x70000000;   // 2 GB - 256 MB (max 247 MB)
     static const unsigned int SYS               = armv7 ? 0xff700000 : 0xf8000000;   // 4 GB - (armv7 ? 9 MB : 128 MB)
 
+    // CPUs (with consecutive ids) sharing a cache beyond L1 (the four A53s share the L2)
+    static const unsigned int CACHE_SHARING     = 4;
+
     // Default Sizes and Quantities
     static const unsigned int MAX_THREADS       = 16;
     static const unsigned int STACK_SIZE        = (armv7 ? 64 : 256) * 1024;
@@ -60,6 +63,11 @@ public:
 template<> struct Traits<IC>: public Traits<Machine_Common>
 {
     static const bool debugged = hysterically_debugged;
+    static const bool nested = false; // the BCM2836 IC has no priorities, so nesting changes nothing
+
+    // Per-CPU interrupt stack (0 keeps handlers on the interrupted thread's stack, which must then have room for them)
+    static const unsigned int STACK_SIZE = 0;
+    static const bool deferred = false; // without STACK_SIZE, still leave the reschedules of handlers to the outermost one's exit
 };
 
 template<> struct Traits<Timer>: public Traits<Machine_Common>
@@ -95,6 +103,11 @@ template<> struct Traits<GPIO>: public Traits<Machine_Common>
     static const bool supports_power_up = false;
 };
 
+template<> struct Traits<TRNG>: public Traits<Machine_Common>
+{
+    static const bool enabled = false; // seeds Random at initialization
+};
+
 template<> struct Traits<Serial_Display>: public Traits<Machine_Common>
 {
     static const bool enabled = true;
@@ -103,6 +116,7 @@ template<> struct Traits<Serial_Display>: public Traits<Machine_Common>
     static const int COLUMNS = 80;
     static const int LINES = 24;
     static const int TAB_SIZE = 8;
+    static const unsigned int BUFFER_SIZE = 0; // bytes waiting for the engine (0 = synchronous)
 };
 
 template<> struct Traits<Serial_Keyboard>: public Traits<Machine_Common>
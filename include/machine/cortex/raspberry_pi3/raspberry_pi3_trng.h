@@ -0,0 +1,53 @@
+// EPOS Raspberry Pi3 (BCM2837) TRNG Mediator Declarations
+
+#ifndef __raspberry_pi3_trng_h
+#define __raspberry_pi3_trng_h
+
+#include <architecture/cpu.h>
+#define __trng_common_only__
+#include <machine/trng.h>
+#undef __trng_common_only__
+#include <system/memory_map.h>
+
+__BEGIN_SYS
+
+class TRNG_Engine: public TRNG_Common
+{
+private:
+    typedef CPU::Reg32 Reg32;
+
+public:
+    // Registers offsets from RAND_BASE
+    enum {
+        RNG_CTRL        = 0x00,
+        RNG_STATUS      = 0x04, // bits 31-24: words in the FIFO; bits 19-0: warm-up count
+        RNG_DATA        = 0x08,
+        RNG_FF_THRES    = 0x0c,
+        RNG_INT_MASK    = 0x10
+    };
+
+    // Useful bits
+    enum {
+        RBGEN           = 1 << 0,       // RNG_CTRL: enable the generator
+        INT_OFF         = 1 << 0,       // RNG_INT_MASK
+        WARMUP_COUNT    = 0x40000       // RNG_STATUS: initial numbers to discard
+    };
+
+public:
+    static unsigned int random() {
+        if(!(reg(RNG_CTRL) & RBGEN)) {
+            reg(RNG_INT_MASK) |= INT_OFF;
+            reg(RNG_STATUS) = WARMUP_COUNT;
+            reg(RNG_CTRL) = RBGEN;
+        }
+        while(!(reg(RNG_STATUS) >> 24));
+        return reg(RNG_DATA);
+    }
+
+private:
+    static volatile Reg32 & reg(unsigned int o) { return reinterpret_cast<volatile Reg32 *>(Memory_Map::RAND_BASE)[o / sizeof(Reg32)]; }
+};
+
+__END_SYS
+
+#endif
@@ -32,7 +32,8 @@ public:
         INT_NIC0_RX     = EXCS + GIC::IRQ_ETHERNET0,
         INT_NIC0_TX     = EXCS + GIC::IRQ_ETHERNET0,
         INT_NIC0_ERR    = EXCS + GIC::IRQ_ETHERNET0,
-        INT_USB0        = EXCS + GIC::IRQ_USB0
+        INT_USB0        = EXCS + GIC::IRQ_USB0,
+        INT_RESCHEDULER = EXCS + GIC::IRQ_SOFTWARE1 // SGI 0 wakes up the other cores (see GIC::smp_init())
     };
 
 public:
@@ -47,9 +48,25 @@ public:
 
     static void ipi(unsigned int cpu, Interrupt_Id i) { gic_distributor()->send_sgi(cpu, int2irq(i)); }
 
+    static const unsigned int PRIORITIES = GIC::PRIORITIES;
+    static void priority(Interrupt_Id i, unsigned int p) { if((i >= EXCS) && (i <= INTS)) gic_distributor()->priority(int2irq(i), p); }
+    static unsigned int priority(Interrupt_Id i) { return ((i >= EXCS) && (i <= INTS)) ? gic_distributor()->priority(int2irq(i)) : PRIORITIES; }
+
+    // Only shared peripheral interrupts can be steered, the private ones (SGIs and PPIs) belong to each CPU
+    static bool affinity(Interrupt_Id i, unsigned long cpus) {
+        if((i < EXCS + 32) || (i >= INTS))
+            return false;
+        gic_distributor()->targets(int2irq(i), cpus);
+        return true;
+    }
+    static void level(unsigned int l) { gic_cpu()->level(l); }
+    static unsigned int level() { return gic_cpu()->level(); }
+
     static void init() {
         gic_distributor()->init();
         gic_cpu()->init();
+        for(unsigned int i = 0; i < IRQS; i++)
+            gic_distributor()->priority(i, Traits<IC>::priority(i));
     };
 
 private:
@@ -6,6 +6,7 @@
 #include <machine/machine.h>
 #include <machine/cortex/engine/cortex_a9/gic.h>
 #include <machine/cortex/engine/cortex_a9/scu.h>
+#include <machine/cortex/engine/cortex_a9/pl310.h>
 #include <system/memory_map.h>
 #include <system.h>
 
@@ -24,12 +25,16 @@ public:
 
     using Machine_Common::delay;
     using Machine_Common::clear_bss;
+    using Machine_Common::temperature;
 
     static void reboot();
     static void poweroff() { reboot(); }
 
     static const UUID & uuid() { return System::info()->bm.uuid; }
 
+    // For way-locking and partitioning (see PL310)
+    static PL310 * l2_cache() { return reinterpret_cast<PL310 *>(Memory_Map::L2_CACHE_BASE); }
+
 private:
     static void pre_init() {}
     static void init() {}
@@ -45,6 +50,11 @@ private:
 
 typedef Realview_PBX Machine_Model;
 
+// No frequency scaling: the clock is fixed by the platform
+inline void CPU::clock(const Hertz & frequency) {}
+inline Hertz CPU::max_clock() { return Traits<CPU>::CLOCK; }
+inline Hertz CPU::min_clock() { return Traits<CPU>::CLOCK; }
+
 __END_SYS
 
 #endif
@@ -38,6 +38,7 @@ struct Memory_Map: public Cortex_Memory_Map
         TSC_BASE                = GLOBAL_TIMER_BASE,
         PRIVATE_TIMER_BASE      = 0x1f000600,
         GIC_DIST_BASE           = 0x1f001000,
+        L2_CACHE_BASE           = 0x1f002000, // PL310 L2 Cache Controller
 
         VECTOR_TABLE            = RAM_BASE, // 8 x 4b instructions + 8 x 4b pointers
         FLAT_PAGE_TABLE 	= (RAM_TOP - 16 * 1024) & ~(0x3fff),  // used only with No_MMU in LIBRARY mode; 16KB, 4096 4B entries, each pointing to 1 MB regions, thus mapping up to 4 GB; 16K-aligned for TTBR;
@@ -45,6 +45,9 @@ template<> struct Traits<Machine>: public Traits<Machine_Common>
     static const unsigned int IO                = NOT_USED;
     static const unsigned int SYS               = NOT_USED;
 
+    // CPUs (with consecutive ids) sharing a cache beyond L1 (the A9 MPCore shares the PL310 L2)
+    static const unsigned int CACHE_SHARING     = 4;
+
     // Default Sizes and Quantities
     static const unsigned int MAX_THREADS       = 16;
     static const unsigned int STACK_SIZE        = 16 * 1024;
@@ -54,11 +57,26 @@ template<> struct Traits<Machine>: public Traits<Machine_Common>
     static const unsigned int ARM_PLL_CLOCK     = 1333333333;
     static const unsigned int IO_PLL_CLOCK      = 1000000000;
     static const unsigned int DDR_PLL_CLOCK     = 1066666666;
+
+    // L2 Cache Controller (PL310), set up by SETUP on the BSP (otherwise left as the boot loader left it)
+    static const bool L2_CACHE                  = false;
+    static const bool L2_PREFETCH               = true;     // L2 prefetching, double linefills and the cores' prefetch hints
+    static const unsigned int L2_PREFETCH_OFFSET = 7;       // lines ahead of the miss
+    static const unsigned int L2_TAG_LATENCY    = 0x000;    // TAG_RAM_CTRL (see PL310::latencies())
+    static const unsigned int L2_DATA_LATENCY   = 0x000;    // DATA_RAM_CTRL
 };
 
 template<> struct Traits<IC>: public Traits<Machine_Common>
 {
     static const bool debugged = hysterically_debugged;
+
+    // Handlers run with all interrupts enabled, unless nested, in which case only those of higher priority (1 to 15) get in
+    static const bool nested = false;
+    static constexpr unsigned int priority(unsigned int irq) { return (irq == 29) ? 15 : 1; } // IRQ 29 is the private timer
+
+    // Per-CPU interrupt stack (0 keeps handlers on the interrupted thread's stack, which must then have room for them)
+    static const unsigned int STACK_SIZE = 0;
+    static const bool deferred = false; // without STACK_SIZE, still leave the reschedules of handlers to the outermost one's exit
 };
 
 template<> struct Traits<Timer>: public Traits<Machine_Common>
@@ -96,6 +114,7 @@ template<> struct Traits<Serial_Display>: public Traits<Machine_Common>
     static const int COLUMNS = 80;
     static const int LINES = 24;
     static const int TAB_SIZE = 8;
+    static const unsigned int BUFFER_SIZE = 0; // bytes waiting for the engine (0 = synchronous)
 };
 
 template<> struct Traits<Serial_Keyboard>: public Traits<Machine_Common>
@@ -6,6 +6,7 @@
 #include <machine/machine.h>
 #include <machine/cortex/engine/cortex_a9/gic.h>
 #include <machine/cortex/engine/cortex_a9/scu.h>
+#include <machine/cortex/engine/cortex_a9/pl310.h>
 #include <system/memory_map.h>
 #include <system.h>
 
@@ -89,6 +90,10 @@ public:
     enum {                                      // Description
         SLCR_LOCK                   = 0x004,    // Lock the SLCR
         SLCR_UNLOCK                 = 0x008,    // Unlock the SLCR
+        GEM0_RCLK_CTRL              = 0x138,    // Ethernet 0 RX Clock Control
+        GEM1_RCLK_CTRL              = 0x13c,    // Ethernet 1 RX Clock Control
+        GEM0_CLK_CTRL               = 0x140,    // Ethernet 0 Ref Clock Control
+        GEM1_CLK_CTRL               = 0x144,    // Ethernet 1 Ref Clock Control
         UART_CLK_CTRL               = 0x154,    // UART Ref Clock Control
         FPGA0_CLK_CTRL              = 0x170,    // PL Clock 0 Output control
         PSS_RST_CTRL                = 0x200,    // PS Software Reset Control
@@ -175,6 +180,7 @@ protected:
 
     using Machine_Common::delay;
     using Machine_Common::clear_bss;
+    using Machine_Common::temperature;
 
     static void reboot();
     static void poweroff() { reboot(); }
@@ -289,6 +295,17 @@ public:
     static volatile Reg32 & global_timer(unsigned int o) { return reinterpret_cast<volatile Reg32 *>(GLOBAL_TIMER_BASE)[o / sizeof(Reg32)]; }
     static volatile Reg32 & private_timer(unsigned int o) { return reinterpret_cast<volatile Reg32 *>(PRIVATE_TIMER_BASE)[o / sizeof(Log_Addr)]; }
 
+    // GEM reference (TX) clock for a link of "mbps", from the IO PLL (the RX clock comes from the PHY, through the MIO)
+    static void gem_clock(unsigned int unit, unsigned int mbps) {
+        const unsigned int div0 = Traits<Machine>::IO_PLL_CLOCK / 125000000;
+        unsigned int div1 = (mbps == 1000) ? 1 : (mbps == 100) ? 5 : 50; // 125, 25 or 2.5 MHz
+        slcr(GEM0_RCLK_CTRL + 4 * unit) = 1; // CLKACT, from the MIO
+        slcr(GEM0_CLK_CTRL + 4 * unit) = (DIVISOR1 * div1) | (DIVISOR0 * div0) | 1; // IO PLL, CLKACT
+    }
+
+    // For way-locking and partitioning (see PL310)
+    static PL310 * l2_cache() { return reinterpret_cast<PL310 *>(Memory_Map::L2_CACHE_BASE); }
+
     static void pre_init() {}
     static void init();
 
@@ -298,6 +315,11 @@ private:
 
 typedef Zynq Machine_Model;
 
+// No frequency scaling: the clock is set up by the FSBL (ps7_init)
+inline void CPU::clock(const Hertz & frequency) {}
+inline Hertz CPU::max_clock() { return Traits<CPU>::CLOCK; }
+inline Hertz CPU::min_clock() { return Traits<CPU>::CLOCK; }
+
 __END_SYS
 
 #endif
@@ -34,6 +34,8 @@ struct Memory_Map: public Cortex_Memory_Map
         PRIVATE_TIMER_BASE      = 0xf8f00600,
         PRIVATE_TIMER_BASE1     = 0xf8f00620,
         GIC_DIST_BASE           = 0xf8f01000,
+        L2_CACHE_BASE           = 0xf8f02000, // PL310 L2 Cache Controller
+        AXI_DMA_BASE            = 0x40400000, // AXI DMA in the PL, on M_AXI_GP0 (where Vivado's address editor puts it)
         
         VECTOR_TABLE            = RAM_BASE, // 8 x 4b instructions + 8 x 4b pointers
         FLAT_PAGE_TABLE         = (RAM_TOP - 16 * 1024) & ~(0x3fff),  // used only with No_MMU in LIBRARY mode; 16KB, 4096 4B entries, each pointing to 1 MB regions, thus mapping up to 4 GB; 16K-aligned for TTBR;
@@ -43,6 +43,9 @@ template<> struct Traits<Machine>: public Traits<Machine_Common>
     static const unsigned int IO                = NOT_USED;
     static const unsigned int SYS               = NOT_USED;
 
+    // CPUs (with consecutive ids) sharing a cache beyond L1 (both A9s share the PL310 L2)
+    static const unsigned int CACHE_SHARING     = 2;
+
     // Default Sizes and Quantities
     static const unsigned int MAX_THREADS       = 16;
     static const unsigned int STACK_SIZE        = 16 * 1024;
@@ -52,11 +55,26 @@ template<> struct Traits<Machine>: public Traits<Machine_Common>
     static const unsigned int ARM_PLL_CLOCK     = 1333333333;
     static const unsigned int IO_PLL_CLOCK      = 1000000000;
     static const unsigned int DDR_PLL_CLOCK     = 1066666666;
+
+    // L2 Cache Controller (PL310), set up by SETUP on the BSP (otherwise left as the boot loader left it)
+    static const bool L2_CACHE                  = false;
+    static const bool L2_PREFETCH               = true;     // L2 prefetching, double linefills and the cores' prefetch hints
+    static const unsigned int L2_PREFETCH_OFFSET = 7;       // lines ahead of the miss
+    static const unsigned int L2_TAG_LATENCY    = 0x111;    // TAG_RAM_CTRL (see PL310::latencies())
+    static const unsigned int L2_DATA_LATENCY   = 0x121;    // DATA_RAM_CTRL
 };
 
 template<> struct Traits<IC>: public Traits<Machine_Common>
 {
     static const bool debugged = hysterically_debugged;
+
+    // Handlers run with all interrupts enabled, unless nested, in which case only those of higher priority (1 to 15) get in
+    static const bool nested = false;
+    static constexpr unsigned int priority(unsigned int irq) { return (irq == 29) ? 15 : 1; } // IRQ 29 is the private timer
+
+    // Per-CPU interrupt stack (0 keeps handlers on the interrupted thread's stack, which must then have room for them)
+    static const unsigned int STACK_SIZE = 0;
+    static const bool deferred = false; // without STACK_SIZE, still leave the reschedules of handlers to the outermost one's exit
 };
 
 template<> struct Traits<Timer>: public Traits<Machine_Common>
@@ -94,6 +112,7 @@ template<> struct Traits<Serial_Display>: public Traits<Machine_Common>
     static const int COLUMNS = 80;
     static const int LINES = 24;
     static const int TAB_SIZE = 8;
+    static const unsigned int BUFFER_SIZE = 0; // bytes waiting for the engine (0 = synchronous)
 };
 
 template<> struct Traits<Serial_Keyboard>: public Traits<Machine_Common>
@@ -114,6 +133,36 @@ template<> struct Traits<Ethernet>: public Traits<Machine_Common>
 
     static const bool enabled = (Traits<Build>::NODES > 1) && (UNITS > 0);
     static const bool promiscuous = false;
+
+    static const bool polled = false; // mask RX interrupts after the first frame and poll the rings from a thread
+    static const unsigned int POLL_BUDGET = 16; // frames handed up per batch
+};
+
+template<> struct Traits<Ethernet_NIC>: public Traits<Machine_Common>
+{
+    static const unsigned int UNITS = Traits<Ethernet>::DEVICES::Count<Ethernet_NIC>::Result;
+    static const bool enabled = Traits<Ethernet>::enabled && (UNITS > 0);
+
+    static const unsigned int SEND_BUFFERS = 16; // per unit
+    static const unsigned int RECEIVE_BUFFERS = 32; // per unit, a power of two of at least 4
+    static const bool promiscuous = Traits<Ethernet>::promiscuous;
+    static const bool offloaded = false; // IP, UDP and TCP checksums computed and verified by the GEM
+};
+
+template<> struct Traits<FPGA>: public Traits<Machine_Common>
+{
+    static const bool enabled = false;
+
+    // FCLK_CLK0, 0 to leave it as the boot loader set it (which also loads the bitstream and enables the level shifters)
+    static const unsigned int CLOCK = 100000000;
+
+    // AXI DMA (S2MM, scatter-gather) at Memory_Map::AXI_DMA_BASE, interrupting on IRQ_F2P[PL_IRQ]
+    static const unsigned int PL_IRQ = 0;
+    static const unsigned int LENGTH_WIDTH = 14; // the IP's "Width of Buffer Length Register"
+    static const unsigned int BLOCKS = 16;
+    static const unsigned int BLOCK_SIZE = 8 * 1024; // bytes, in whole cache lines
+    static const unsigned int IRQ_THRESHOLD = 1; // blocks per interrupt (consumers are still woken once per block)
+    static const unsigned int IRQ_DELAY = 0; // with IRQ_THRESHOLD > 1, interrupt anyway after the stream stops for IRQ_DELAY x 125 clocks
 };
 
 __END_SYS
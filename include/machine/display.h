@@ -43,6 +43,9 @@ private:
     static const int LINES = Traits<Serial_Display>::LINES;
     static const int COLUMNS = Traits<Serial_Display>::COLUMNS;
     static const int TAB_SIZE = Traits<Serial_Display>::TAB_SIZE;
+    static const unsigned int BUFFER_SIZE = Traits<Serial_Display>::BUFFER_SIZE;
+
+    static_assert(!(BUFFER_SIZE & (BUFFER_SIZE - 1)), "Serial_Display BUFFER_SIZE must be a power of two");
 
     // Special characters
     enum {
@@ -104,9 +107,57 @@ public:
         put('H');
     }
 
+    // With a BUFFER_SIZE, characters wait in a ring and are handed to the engine only as far as it takes them without
+    // waiting, both by put() and by drain(), which the engine's TX interrupt (or, lacking it, the periodic tick) calls.
+    // put() only waits for the engine when the ring is full. flush() empties the ring synchronously, leaving nothing
+    // behind before a panic, a reboot or a poweroff.
+    static void drain() {
+        if(BUFFER_SIZE) {
+            bool ie = lock();
+            move();
+            unlock(ie);
+        }
+    }
+
+    static void flush() {
+        if(BUFFER_SIZE) // no locking, since this might be a panic with the lock taken
+            while(_head != _tail)
+                _engine.put(_buffer[_head++ & (BUFFER_SIZE - 1)]);
+    }
+
 private:
     static void put(char c) {
-        _engine.put(c);
+        if(BUFFER_SIZE) {
+            bool ie = lock();
+            if(_tail - _head == BUFFER_SIZE)
+                _engine.put(_buffer[_head++ & (BUFFER_SIZE - 1)]);
+            _buffer[_tail++ & (BUFFER_SIZE - 1)] = c;
+            move();
+            unlock(ie);
+        } else
+            _engine.put(c);
+    }
+
+    static void move() {
+        while((_head != _tail) && _engine.ready_to_put())
+            _engine.put(_buffer[_head++ & (BUFFER_SIZE - 1)]);
+    }
+
+    static bool lock() {
+        bool ie = CPU::int_enabled();
+        CPU::int_disable();
+        if(Traits<Build>::CPUS > 1)
+            while(CPU::tsl(_lock));
+        return ie;
+    }
+
+    static void unlock(bool ie) {
+        if(Traits<Build>::CPUS > 1) {
+            CPU::fence();
+            _lock = 0;
+        }
+        if(ie)
+            CPU::int_enable();
     }
 
     static void escape() {
@@ -151,6 +202,10 @@ private:
     static Engine _engine;
     static int _line;
     static int _column;
+    static char _buffer[BUFFER_SIZE ? BUFFER_SIZE : 1];
+    static unsigned int _head;
+    static unsigned int _tail;
+    static volatile int _lock;
 };
 
 __END_SYS
@@ -20,6 +20,10 @@ public:
 
     unsigned char read(const Address & a);
     void write(const Address & a, unsigned char d);
+
+    // Blocks, e.g. for a Page_Writer (see utility/page_writer.h)
+    void read(const Address & a, void * data, unsigned int size);
+    void write(const Address & a, const void * data, unsigned int size);
 };
 
 __END_SYS
@@ -4,9 +4,13 @@
 #define __i2c_h
 
 #include <system/config.h>
+#include <utility/handler.h>
+#include <utility/list.h>
 
 __BEGIN_SYS
 
+class I2C_Engine;
+
 class I2C_Common
 {
 public:
@@ -15,6 +19,41 @@ public:
         SLAVE,
     };
 
+    // A master write of "tx_size" bytes followed, with a repeated start, by a read of "rx_size" bytes from the slave at
+    // "address" (e.g. a register number and then its value). Either part can be empty. Transactions are queued in the
+    // engine with submit() and run in order; "handler" (e.g. a Semaphore_Handler) is called as each of them finishes,
+    // in interrupt context when the engine is interrupt-driven. A Transaction must not be touched until it is done(),
+    // and ok() then tells whether the slave acknowledged everything.
+    class Transaction
+    {
+        friend class I2C_Engine;
+
+    public:
+        typedef Simple_List<Transaction> List;
+        typedef List::Element Element;
+
+    public:
+        Transaction(unsigned char address, const char * tx, unsigned int tx_size, char * rx, unsigned int rx_size, Handler * handler = 0)
+        : _address(address), _tx(tx), _tx_size(tx_size), _rx(rx), _rx_size(rx_size), _handler(handler),
+          _index(0), _reading(false), _done(false), _ok(false), _link(this) {}
+
+        bool done() const { return _done; }
+        bool ok() const { return _ok; }
+
+    private:
+        unsigned char _address;
+        const char * _tx;
+        unsigned int _tx_size;
+        char * _rx;
+        unsigned int _rx_size;
+        Handler * _handler;
+        unsigned int _index;            // next byte of the current part
+        bool _reading;
+        volatile bool _done;
+        bool _ok;
+        Element _link;
+    };
+
 protected:
     I2C_Common() {}
 
@@ -27,6 +66,9 @@ public:
     bool read(char slave_address, char * data, unsigned int size, bool stop = true);
     bool write(unsigned char slave_address, const char * data, unsigned int size, bool stop = true);
 
+    void submit(Transaction * t, unsigned int n = 1);
+    bool transfer(unsigned char slave_address, const char * tx, unsigned int tx_size, char * rx, unsigned int rx_size);
+
     void flush();
     bool ready_to_get();
     bool ready_to_put();
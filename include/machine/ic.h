@@ -45,7 +45,9 @@ public:
         INT_GPIOD       = UNSUPPORTED_INTERRUPT,
         INT_GPIOE       = UNSUPPORTED_INTERRUPT,
         INT_GPIOF       = UNSUPPORTED_INTERRUPT,
-        INT_ADC0        = UNSUPPORTED_INTERRUPT
+        INT_ADC0        = UNSUPPORTED_INTERRUPT,
+        INT_PMU         = UNSUPPORTED_INTERRUPT, // PMU counter overflows (see PMU::sample())
+        INT_RESCHEDULER = UNSUPPORTED_INTERRUPT  // IPI carrying the messages of IPI (e.g. Thread::reschedule(cpu)) on multicores
     };
 
 protected:
@@ -0,0 +1,66 @@
+// EPOS Inter-processor Messages Declarations
+
+#ifndef __ipi_h
+#define __ipi_h
+
+#include <architecture/cpu.h>
+#include <machine/ic.h>
+#include <utility/atomic.h>
+
+__BEGIN_SYS
+
+// Inter-processor messages, all multiplexed over the single IPI each machine offers (IC::INT_RESCHEDULER: CLINT's
+// MSIP on RISC-V, the APIC's INT_IPI on PCs, a GIC SGI or a BCM mailbox on Cortex-A). Messages are bits in a pending
+// mask per CPU, so those sent to a CPU that hasn't served the previous ones yet are coalesced into a single interrupt,
+// and dispatch() serves all of them at once. multicast() raises the interrupt of each CPU in a set once (batching).
+class IPI
+{
+private:
+    static const bool multicore = Traits<System>::multicore;
+    static const unsigned int CPUS = Traits<Build>::CPUS;
+
+public:
+    typedef unsigned int CPU_Set; // one bit per CPU
+    typedef IC::Interrupt_Handler Handler;
+
+    enum Message {
+        RESCHEDULE,     // see Thread::reschedule(cpu)
+        TLB_SHOOTDOWN,  // see shootdown()
+        MONITOR,        // see Monitor::capture()
+        MESSAGES
+    };
+
+public:
+    // Handlers run in interrupt context on the target CPU, with the id of the IPI
+    static void handler(const Message & m, const Handler & h) { _handlers[m] = h; }
+
+    static void send(unsigned int cpu, const Message & m);
+    static void multicast(CPU_Set cpus, const Message & m);
+    static void broadcast(const Message & m) { multicast(others(), m); }
+
+    // Flushes the TLB of this CPU and of all others that are online, only returning once they all did, so frames
+    // unmapped before it can be reused. Interrupts might be disabled, but the kernel must not be locked by the caller,
+    // or another CPU spinning for the lock would never answer.
+    static void shootdown();
+
+    static CPU_Set online() { return _online; }
+    static CPU_Set others() { return _online & ~(1U << CPU::id()); }
+
+    // Installs dispatch() (on the first call) and takes the calling CPU online
+    static void init();
+
+private:
+    static void dispatch(IC::Interrupt_Id i);
+    static void flush();
+
+private:
+    static Handler _handlers[MESSAGES];
+    static Atomic<unsigned int> _pending[CPUS];
+    static Atomic<CPU_Set> _online;
+    static Atomic<unsigned int> _shooting;
+    static Atomic<int> _acks;
+};
+
+__END_SYS
+
+#endif
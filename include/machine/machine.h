@@ -4,6 +4,7 @@
 #define __machine_machine_h
 
 #include <system/config.h>
+#include <architecture/cpu.h>
 #include <architecture/tsc.h>
 #include <utility/convert.h>
 
@@ -31,6 +32,32 @@ public:
         static void init() {};
     };
 
+    // Initialization on first use, for components configured with Traits<...>::lazy instead of being initialized by
+    // Machine::init(). The component's accessors call init(), which runs INIT once, while callers on other CPUs wait.
+    // Since INIT might take locks or enable interrupts, the first use must not be by an interrupt handler.
+    template<void (* INIT)()>
+    class Lazy
+    {
+    public:
+        static void init() {
+            if(_done)
+                return;
+
+            while(CPU::tsl(_busy));
+            if(!_done) {
+                INIT();
+                _done = true;
+            }
+            _busy = false;
+        }
+
+        static bool done() { return _done; }
+
+    private:
+        static volatile bool _done;
+        static volatile bool _busy;
+    };
+
 protected:
     Machine_Common() {}
 
@@ -47,9 +74,18 @@ public:
 
     static const UUID & uuid();
 
+    // CPU temperature in m°C, 0 where there is no sensor
+    static int temperature() { return 0; }
+
     static void clear_bss();
 };
 
+template<void (* INIT)()>
+volatile bool Machine_Common::Lazy<INIT>::_done;
+
+template<void (* INIT)()>
+volatile bool Machine_Common::Lazy<INIT>::_busy;
+
 __END_SYS
 
 #endif
@@ -0,0 +1,133 @@
+// EPOS Network Interface Card Mediator Common Package
+
+#ifndef __nic_h
+#define __nic_h
+
+#include <utility/string.h>
+#include <utility/observer.h>
+#include <utility/buffer.h>
+
+__BEGIN_SYS
+
+class NIC_Common
+{
+protected:
+    NIC_Common() {}
+
+public:
+    // NIC physical address (e.g. MAC)
+    template<unsigned int LENGTH>
+    class Address
+    {
+    public:
+        Address() {}
+        Address(unsigned char a) { for(unsigned int i = 0; i < LENGTH; i++) _address[i] = a; }
+        Address(const unsigned char * a) { memcpy(_address, a, LENGTH); }
+
+        static Address broadcast() { return Address(0xff); }
+
+        operator bool() const {
+            for(unsigned int i = 0; i < LENGTH; i++)
+                if(_address[i])
+                    return true;
+            return false;
+        }
+
+        bool operator==(const Address & a) const { return !memcmp(_address, a._address, LENGTH); }
+        bool operator!=(const Address & a) const { return !(*this == a); }
+
+        unsigned char & operator[](unsigned int i) { return _address[i]; }
+        const unsigned char & operator[](unsigned int i) const { return _address[i]; }
+
+        friend OStream & operator<<(OStream & os, const Address & a) {
+            static const char digits[] = "0123456789abcdef";
+            for(unsigned int i = 0; i < LENGTH; i++) {
+                os << digits[a._address[i] >> 4] << digits[a._address[i] & 0xf];
+                if(i < LENGTH - 1)
+                    os << ":";
+            }
+            return os;
+        }
+
+    private:
+        unsigned char _address[LENGTH];
+    } __attribute__((packed));
+
+    // NIC protocol id (e.g. Ethernet's EtherType), in host byte order
+    typedef unsigned short Protocol;
+
+    // Work the NIC can take from the protocols above. With TX checksums, they leave their checksums for the NIC to fill
+    // in. With RX checksums, the NIC drops frames with bad checksums, so they don't check them again.
+    enum Offload {
+        TX_IP_CHECKSUM  = 1 << 0,
+        TX_L4_CHECKSUM  = 1 << 1, // UDP and TCP
+        RX_IP_CHECKSUM  = 1 << 2,
+        RX_L4_CHECKSUM  = 1 << 3
+    };
+
+    // NIC statistics
+    struct Statistics
+    {
+        Statistics(): rx_packets(0), tx_packets(0), rx_bytes(0), tx_bytes(0), rx_errors(0), tx_errors(0), rx_overruns(0) {}
+
+        friend OStream & operator<<(OStream & os, const Statistics & s) {
+            os << "{rx=" << s.rx_packets << "/" << s.rx_bytes << ",tx=" << s.tx_packets << "/" << s.tx_bytes
+               << ",rxerr=" << s.rx_errors << ",txerr=" << s.tx_errors << ",ovr=" << s.rx_overruns << "}";
+            return os;
+        }
+
+        unsigned int rx_packets;
+        unsigned int tx_packets;
+        unsigned int rx_bytes;
+        unsigned int tx_bytes;
+        unsigned int rx_errors;
+        unsigned int tx_errors;
+        unsigned int rx_overruns;
+    };
+};
+
+// The interface all NICs of a Family (e.g. Ethernet) implement
+// Besides the copying send() and receive(), NICs move frames across the communication stack by reference, in Buffers
+// that live in the DMA rings of the device. Received frames are handed up to the protocols attached (as observers) to
+// the EtherType of the frame while still in the RX ring, and the one that takes a frame must give its buffer back with
+// free() once it is done with it, since the RX descriptor stays with the host until then. Frames nobody observes are
+// left in the ring for receive(). To send, a protocol alloc()ates a TX buffer, builds the frame in place and then
+// send()s it (or free()s it to give up).
+template<typename Family>
+class NIC: public Family, public Family::Observed
+{
+public:
+    typedef typename Family::Address Address;
+    typedef typename Family::Protocol Protocol;
+    typedef typename Family::Buffer Buffer;
+    typedef typename Family::Statistics Statistics;
+    typedef typename Family::Observer Observer;
+    typedef typename Family::Observed Observed;
+
+protected:
+    NIC() {}
+
+public:
+    virtual ~NIC() {}
+
+    virtual int send(const Address & dst, const Protocol & prot, const void * data, unsigned int size) = 0;
+    virtual int receive(Address * src, Protocol * prot, void * data, unsigned int size) = 0;
+
+    virtual Buffer * alloc(const Address & dst, const Protocol & prot, unsigned int payload) = 0;
+    virtual int send(Buffer * buf) = 0;
+    virtual void free(Buffer * buf) = 0;
+
+    virtual const Address & address() = 0;
+    virtual const Statistics & statistics() = 0;
+    virtual unsigned int offloads() { return 0; }
+
+    virtual void reset() = 0;
+};
+
+__END_SYS
+
+#endif
+
+#if defined(__NIC_H) && !defined(__nic_common_only__)
+#include __NIC_H
+#endif
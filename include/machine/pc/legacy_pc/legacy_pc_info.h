@@ -23,11 +23,22 @@ public:
         unsigned int bus_clock;
     };
 
+    // PCIe configuration space (ECAM) found by SETUP in the ACPI MCFG table (phy = 0 if none or if not used)
+    struct ECAM_Map
+    {
+        PAddr phy;              // configuration space of first_bus (1 MB per bus)
+        LAddr log;              // where SETUP mapped it, after the PCI I/O memory
+        unsigned int first_bus;
+        unsigned int last_bus;  // up to Traits<PCI>::MAX_BUS
+    };
+
 public:
     Boot_Map bm;
     Physical_Memory_Map pmm;
     Kernel_Load_Map lm;
     Time_Map tm;
+    Boot_Profile bp;
+    ECAM_Map ecam;
 };
 
 __END_SYS
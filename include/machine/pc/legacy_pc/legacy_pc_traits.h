@@ -39,6 +39,9 @@ template<> struct Traits<Machine>: public Traits<Machine_Common>
     static const unsigned int IO                = 0x70000000; 	// 2 GB - 256 MB  (max 244 MB)
     static const unsigned int SYS               = 0xff800000;   // 4 GB - 8 MB
 
+    // CPUs (with consecutive ids) sharing a cache beyond L1 (taken as a last-level cache shared by all cores)
+    static const unsigned int CACHE_SHARING     = Traits<Build>::CPUS;
+
     // Default Sizes and Quantities
     static const unsigned int MAX_THREADS       = 16;
     static const unsigned int STACK_SIZE        = 64 * 1024;
@@ -50,11 +53,24 @@ template<> struct Traits<PCI>: public Traits<Machine_Common>
     static const int MAX_BUS = 16;
     static const int MAX_DEV_FN = 0xff;
     static const unsigned int MAX_REGION_SIZE = 0x04000000; // 64 MB
+    static const bool lazy = false; // initialize on the first scan() instead of at boot
+    static const bool ecam = false; // access the configuration space through the ECAM found in the ACPI MCFG table
 };
 
 template<> struct Traits<IC>: public Traits<Machine_Common>
 {
     static const bool debugged = hysterically_debugged;
+
+    // Handlers run with interrupts disabled, unless nested, in which case IRQs of higher priority (1 to 15) get in
+    static const bool nested = false;
+    static constexpr unsigned int priority(unsigned int irq) { return (irq == 0) ? 15 : 1; } // IRQ 0 is the PIT
+
+    // Per-CPU interrupt stack (0 keeps handlers on the interrupted thread's stack, which must then have room for them)
+    static const unsigned int STACK_SIZE = 0;
+    static const bool deferred = false; // without STACK_SIZE, still leave the reschedules of handlers to the outermost one's exit
+
+    // Interrupts reserved for PCI MSI/MSI-X (up to 16), which need the local APIC
+    static const unsigned int MSI_VECTORS = 0;
 };
 
 template<> struct Traits<Timer>: public Traits<Machine_Common>
@@ -65,6 +81,10 @@ template<> struct Traits<Timer>: public Traits<Machine_Common>
     // 10000 Hz. The choice must respect the scheduler time-slice, i. e.,
     // it must be higher than the scheduler invocation frequency.
     static const int FREQUENCY = 1000; // Hz
+
+    // Alarms on their own TSC deadlines (see Traits<Alarm>::one_shot), through the local APIC timer in TSC-deadline
+    // mode (or one-shot mode on the bus clock, where the CPU lacks it), while the PIT keeps the periodic ticks
+    static const bool one_shot = false;
 };
 
 template<> struct Traits<RTC>: public Traits<Machine_Common>
@@ -104,6 +124,7 @@ template<> struct Traits<Serial_Display>: public Traits<Machine_Common>
     static const int COLUMNS = 80;
     static const int LINES = 24;
     static const int TAB_SIZE = 8;
+    static const unsigned int BUFFER_SIZE = 0; // bytes waiting for the engine (0 = synchronous)
 };
 
 template<> struct Traits<Serial_Keyboard>: public Traits<Machine_Common>
@@ -117,11 +138,13 @@ template<> struct Traits<Display>: public Traits<Machine_Common>
     static const int COLUMNS = 80;
     static const int LINES = 25;
     static const int TAB_SIZE = 8;
+    static const unsigned int REFRESH = 0; // Hz at which a RAM shadow is flushed to the frame buffer (0 = write through)
 };
 
 template<> struct Traits<Keyboard>: public Traits<Machine_Common>
 {
     static const bool enabled = !Traits<Serial_Keyboard>::enabled;
+    static const bool lazy = false; // initialize on the first get() or attach() instead of at boot
 };
 
 template<> struct Traits<Scratchpad>: public Traits<Machine_Common>
@@ -129,6 +152,7 @@ template<> struct Traits<Scratchpad>: public Traits<Machine_Common>
     static const bool enabled = true;
     static const unsigned int ADDRESS = 0xa0000; // VGA Graphic mode frame buffer
     static const unsigned int SIZE = 96 * 1024;
+    static const bool lazy = false; // map on the first allocation instead of at boot (into the address space current then)
 };
 
 template<> struct Traits<FPGA>: public Traits<Machine_Common>
@@ -138,6 +162,27 @@ template<> struct Traits<FPGA>: public Traits<Machine_Common>
     static const unsigned int DMA_BUFFER_SIZE = 64 * 1024; // 64 KB
 };
 
+template<> struct Traits<Ethernet>: public Traits<Machine_Common>
+{
+    typedef LIST<PCNet32> DEVICES;
+    static const unsigned int UNITS = DEVICES::Length;
+
+    static const bool enabled = (Traits<Build>::NODES > 1) && (UNITS > 0);
+
+    static const bool polled = false; // mask RX interrupts after the first frame and poll the rings from a thread
+    static const unsigned int POLL_BUDGET = 16; // frames handed up per batch
+};
+
+template<> struct Traits<PCNet32>: public Traits<Machine_Common>
+{
+    static const unsigned int UNITS = Traits<Ethernet>::DEVICES::Count<PCNet32>::Result;
+    static const bool enabled = Traits<Ethernet>::enabled && (UNITS > 0);
+
+    static const unsigned int SEND_BUFFERS = 16; // per unit, a power of two up to 512
+    static const unsigned int RECEIVE_BUFFERS = 32; // per unit, a power of two up to 512
+    static const bool promiscuous = false;
+};
+
 __END_SYS
 
 #endif
@@ -52,10 +52,16 @@ public:
 };
 
 // VGA (actually CGA) PC Display
+// With a REFRESH rate, characters go to a shadow of the screen in RAM instead of the frame buffer, along with the
+// cursor, which is no longer read back from the MC6845 for every character. The shadow is a ring of lines, so scrolling
+// just moves its first line (_top) and clears one, and flush() copies only the lines changed since the last flush to
+// the frame buffer, in screen order. The Timer flushes it REFRESH times per second (see refresh()), while output with
+// interrupts disabled (e.g. during the initialization or a panic) is flushed right away.
 class VGA: public Display_Common, private MC6845
 {
     friend class Setup;
     friend class Machine;
+    friend class Timer;
 
 public:
     static const unsigned int FB_PHY_ADDR = 0xb8000;
@@ -65,6 +71,15 @@ public:
     static const int LINES = Traits<Display>::LINES;
     static const int COLUMNS = Traits<Display>::COLUMNS;
     static const int TAB_SIZE = Traits<Display>::TAB_SIZE;
+    static const unsigned int REFRESH = Traits<Display>::REFRESH;
+
+    static_assert(!REFRESH || (LINES <= 32), "VGA's dirty lines must fit in an unsigned int");
+
+private:
+    static const unsigned int ALL_LINES = (LINES < 32) ? (1U << LINES) - 1 : ~0U;
+    static const int TICKS = Traits<Timer>::FREQUENCY / (REFRESH ? REFRESH : 1); // between flushes
+
+    static_assert(REFRESH <= Traits<Timer>::FREQUENCY, "VGA can't be flushed more often than the Timer ticks");
 
 public:
     // Frame Buffer
@@ -81,7 +96,7 @@ public:
     VGA() {}
 
     static void putc(char c) {
-        unsigned int pos = MC6845::position();
+        unsigned int pos = REFRESH ? _position : MC6845::position();
 
         switch(c) {
         case '\n':
@@ -91,13 +106,18 @@ public:
             pos = (pos + TAB_SIZE) / TAB_SIZE * TAB_SIZE;
             break;
         default:
-            _frame_buffer[pos++] = NORMAL | c;
+            if(REFRESH) {
+                _shadow[cell(pos)] = NORMAL | c;
+                _dirty |= 1U << (pos / COLUMNS);
+                pos++;
+            } else
+                _frame_buffer[pos++] = NORMAL | c;
         }
         if(pos >= LINES * COLUMNS) {
             scroll();
             pos-= COLUMNS;
         }
-        MC6845::position(pos);
+        position(pos);
     }
 
     static void puts(const char * s) {
@@ -106,13 +126,19 @@ public:
     }
 
     static void clear() {
-        for(unsigned int i = 0; i < LINES * COLUMNS; i++)
-            _frame_buffer[i] = NORMAL | ' ';
-        MC6845::position(0);
+        if(REFRESH) {
+            for(unsigned int i = 0; i < LINES * COLUMNS; i++)
+                _shadow[i] = NORMAL | ' ';
+            _top = 0;
+            _dirty = ALL_LINES;
+        } else
+            for(unsigned int i = 0; i < LINES * COLUMNS; i++)
+                _frame_buffer[i] = NORMAL | ' ';
+        position(0);
     }
 
     static void position(int * line, int * column) {
-        unsigned int pos = MC6845::position();
+        unsigned int pos = REFRESH ? _position : MC6845::position();
         *column = pos % COLUMNS;
         *line = pos / COLUMNS;
     }
@@ -130,7 +156,7 @@ public:
             if(line < 0)
                 line = old_line;
         }
-        MC6845::position(line * COLUMNS + column);
+        position(line * COLUMNS + column);
     }
 
     static void geometry(int * lines, int * columns) {
@@ -138,20 +164,85 @@ public:
         *columns = COLUMNS;
     }
 
+    // Copies the lines of the shadow changed since the last flush to the frame buffer and moves the cursor
+    static void flush() {
+        if(!REFRESH)
+            return;
+
+        unsigned int dirty = _dirty;
+        _dirty = 0; // lines written from now on (even by an interrupted putc()) wait for the next flush
+        unsigned int top = _top;
+        for(unsigned int l = 0; dirty; l++, dirty >>= 1)
+            if(dirty & 1) {
+                const Cell * from = &_shadow[((top + l) % LINES) * COLUMNS];
+                Cell * to = &_frame_buffer[l * COLUMNS];
+                for(unsigned int i = 0; i < COLUMNS; i++)
+                    to[i] = from[i];
+            }
+
+        unsigned int pos = _position;
+        if(pos != _cursor) {
+            _cursor = pos;
+            MC6845::position(pos);
+        }
+    }
+
 private:
+    // Cell of the shadow holding screen position "pos"
+    static unsigned int cell(unsigned int pos) { return ((_top + pos / COLUMNS) % LINES) * COLUMNS + pos % COLUMNS; }
+
+    static void position(unsigned int pos) {
+        if(REFRESH) {
+            _position = pos;
+            if(CPU::int_disabled())
+                flush();
+        } else
+            MC6845::position(pos);
+    }
+
     static void scroll() {
-        for(unsigned int i = 0; i < (LINES - 1) * COLUMNS; i++)
-            _frame_buffer[i] = _frame_buffer[i + COLUMNS];
-        for(unsigned int i = (LINES - 1) * COLUMNS; i < LINES * COLUMNS; i++)
-            _frame_buffer[i] = NORMAL | ' ';
+        if(REFRESH) {
+            for(unsigned int i = _top * COLUMNS; i < (_top + 1) * COLUMNS; i++)
+                _shadow[i] = NORMAL | ' ';
+            _top = (_top + 1) % LINES;
+            _dirty = ALL_LINES;
+        } else {
+            for(unsigned int i = 0; i < (LINES - 1) * COLUMNS; i++)
+                _frame_buffer[i] = _frame_buffer[i + COLUMNS];
+            for(unsigned int i = (LINES - 1) * COLUMNS; i < LINES * COLUMNS; i++)
+                _frame_buffer[i] = NORMAL | ' ';
+        }
+    }
+
+    // Called by the Timer on every tick
+    static void refresh() {
+        if(--_countdown <= 0) {
+            _countdown = TICKS;
+            flush();
+        }
     }
 
     static void init(unsigned int fb = FB_LOG_ADDR) {
         _frame_buffer = reinterpret_cast<Frame_Buffer>(fb);
+
+        // Whatever is already on the screen (e.g. from SETUP) is kept
+        if(REFRESH) {
+            for(unsigned int i = 0; i < LINES * COLUMNS; i++)
+                _shadow[i] = _frame_buffer[i];
+            _top = 0;
+            _dirty = 0;
+            _position = _cursor = MC6845::position();
+        }
     }
 
 private:
     static Frame_Buffer _frame_buffer;
+    static Cell _shadow[REFRESH ? LINES * COLUMNS : 1];
+    static unsigned int _top;                   // line of the shadow shown on the first line of the screen
+    static volatile unsigned int _dirty;        // screen lines changed since the last flush
+    static volatile unsigned int _position;     // cursor, as putc() sees it
+    static unsigned int _cursor;                // cursor, as the MC6845 has it
+    static int _countdown;                      // ticks to the next flush
 };
 
 class Display: public IF<Traits<Serial_Display>::enabled, Serial_Display, VGA>::Result {};
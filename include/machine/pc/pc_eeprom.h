@@ -4,7 +4,7 @@
 #define __pc_eeprom_h
 
 #include <machine/eeprom.h>
-#include "rtc.h"
+#include <machine/pc/pc_rtc.h>
 
 __BEGIN_SYS
 
@@ -20,6 +20,16 @@ public:
 
     unsigned char read(const Address & a) { return cmos_read(a); }
     void write(const Address & a, unsigned char d) { cmos_write(a, d); }
+
+    void read(const Address & a, void * data, unsigned int size) {
+        for(unsigned int i = 0; i < size; i++)
+            reinterpret_cast<unsigned char *>(data)[i] = cmos_read(a + i);
+    }
+
+    void write(const Address & a, const void * data, unsigned int size) {
+        for(unsigned int i = 0; i < size; i++)
+            cmos_write(a + i, reinterpret_cast<const unsigned char *>(data)[i]);
+    }
 };
 
 __END_SYS
@@ -298,6 +298,7 @@ public:
         // Local Timer (32 bits)
         TIMER_PERIODIC          = (1 << 17),
         TIMER_ONE_SHOT          = (0 << 17),
+        TIMER_TSC_DEADLINE      = (2 << 17), // fires when the TSC reaches IA32_TSC_DEADLINE (if CPUID.1:ECX[24])
         TIMER_MASKED            = LVT_MASKED,
         TIMER_PRESCALE_BY_1     = 0xb,
         TIMER_PRESCALE_BY_2     = 0x0,
@@ -374,6 +375,28 @@ public:
         write(LVT_TIMER, v);
     }
 
+    // TSC-deadline mode: the timer is armed by a single MSR write and disarmed by writing 0 (see timer_deadline())
+    static bool tsc_deadline() {
+        CPU::Reg32 a = 1, b, c = 0, d;
+        CPU::cpuid(1, &a, &b, &c, &d);
+        return c & (1 << 24);
+    }
+    static void config_timer_deadline(Reg vector) {
+        write(LVT_TIMER, vector | TIMER_TSC_DEADLINE);
+    }
+    static void timer_deadline(const CPU::Reg64 & deadline) {
+        CPU::wrmsr(CPU::IA32_TSC_DEADLINE, deadline);
+    }
+
+    // One-shot mode on the bus clock, for CPUs without TSC-deadline mode
+    static void config_timer_one_shot(Reg vector) {
+        write(TIMER_PRESCALE, TIMER_PRESCALE_BY_1);
+        write(LVT_TIMER, vector | TIMER_ONE_SHOT);
+    }
+    static void timer_count(Reg count) {
+        write(TIMER_INITIAL, count);
+    }
+
     static void enable_timer() {
         write(LVT_TIMER, read(LVT_TIMER) & ~TIMER_MASKED);
     }
@@ -469,6 +492,7 @@ private:
     typedef i8259A Engine;
 
     typedef CPU::Reg Reg;
+    typedef CPU::Reg16 Reg16;
     typedef CPU::Log_Addr Log_Addr;
 
 public:
@@ -480,11 +504,16 @@ public:
         INT_SYS_TIMER   = Engine::INT_TIMER,
         INT_KEYBOARD    = Engine::INT_KEYBOARD,
         INT_LAST_HARD   = Engine::INT_LAST_HARD,
+        INT_RESCHEDULER = Engine::INT_IPI,
         INT_PMU,
-        LAST_INT
+        INT_ONE_SHOT,   // local APIC timer, used by Timer::one_shot()
+        INT_FIRST_MSI,  // PCI Message Signaled Interrupts, delivered through the local APIC and allocated by PCI::msi()
+        INT_LAST_MSI    = INT_FIRST_MSI + Traits<IC>::MSI_VECTORS - 1,
+        LAST_INT        = INT_FIRST_MSI + Traits<IC>::MSI_VECTORS
     };
 
     static const unsigned int INTS = LAST_INT;
+    static_assert(Traits<IC>::MSI_VECTORS <= 16, "IC::entry() only has stubs for 16 MSI vectors");
 
 public:
     IC() {}
@@ -502,46 +531,115 @@ public:
 
     static void enable() {
         db<IC>(TRC) << "IC::enable()" << endl;
-        Engine::enable();
+        _enabled = ~(1 << IRQ_CASCADE); // as Engine::enable()
+        mask();
     }
 
     static void enable(Interrupt_Id i) {
         db<IC>(TRC) << "IC::enable(int=" << i << ")" << endl;
         assert(i < INTS);
-        Engine::enable(i);
+        if((i >= INT_FIRST_HARD) && (i < INT_FIRST_HARD + IRQS)) { // MSIs are masked at the device
+            _enabled |= 1 << Engine::int2irq(i);
+            mask();
+        }
     }
 
     static void disable() {
         db<IC>(TRC) << "IC::disable()" << endl;
-        Engine::disable();
+        _enabled = 1 << IRQ_CASCADE;    // as Engine::disable()
+        mask();
     }
 
     static void disable(Interrupt_Id i) {
         db<IC>(TRC) << "IC::disable(int=" << i << ")" << endl;
         assert(i < INTS);
-        Engine::disable(i);
+        if((i >= INT_FIRST_HARD) && (i < INT_FIRST_HARD + IRQS)) {
+            _enabled &= ~(1 << Engine::int2irq(i));
+            mask();
+        }
+    }
+
+    // Priorities go from 1 to PRIORITIES (higher is more urgent) and only IRQs of priority above the current level are
+    // taken. With Traits<IC>::nested, dispatch() raises the level to the priority of the IRQ being handled.
+    // The 8259A's own priorities are fixed, so levels are implemented by masking the IRQs at or below the level in the
+    // IMR, on top of what enable() and disable() have set.
+    static const unsigned int PRIORITIES = 15;
+
+    static void priority(Interrupt_Id i, unsigned int p) {
+        db<IC>(TRC) << "IC::priority(int=" << i << ",p=" << p << ")" << endl;
+        assert((i >= INT_FIRST_HARD) && (i < INT_FIRST_HARD + IRQS) && (p <= PRIORITIES));
+        _priority[Engine::int2irq(i)] = p;
+        mask();
+    }
+    static unsigned int priority(Interrupt_Id i) {
+        return ((i >= INT_FIRST_HARD) && (i < INT_FIRST_HARD + IRQS)) ? _priority[Engine::int2irq(i)] : PRIORITIES;
+    }
+
+    // Only MSIs can be steered, by rewriting their destination at the device (to the first CPU in "cpus"). ISA IRQs
+    // always reach CPU 0 through the 8259A, since there is no I/O APIC mediator.
+    static bool affinity(Interrupt_Id i, unsigned long cpus);
+
+    static void level(unsigned int l) {
+        assert(l <= PRIORITIES);
+        _level = l;
+        mask();
     }
+    static unsigned int level() { return _level; }
 
     using Engine::ipi;
     using Engine::irq2int;
 
 private:
+    // With Traits<IC>::STACK_SIZE, the outermost handler runs on its CPU's interrupt stack, where nested ones stay
     static void dispatch(unsigned int i) __attribute__ ((thiscall));
+    static void serve(unsigned int i);
+
+    // Threads can't be switched from the interrupt stack, which the next interrupt would reuse along with whatever the
+    // thread left there, so Thread::reschedule() leaves it to dispatch(), once back on the interrupted thread's stack.
+    // Traits<IC>::deferred does the same without an interrupt stack, so a burst of wakeups switches threads only once
+    static bool defer_reschedule() {
+        if(!deferring || !_nesting[CPU::id()])
+            return false;
+        _rescheduling[CPU::id()] = true;
+        return true;
+    }
 
     // Logical handlers
     static void int_not(Interrupt_Id i);
+    static bool lazy_pf();
 
     // Physical handlers
     static void entry() __attribute__ ((naked));
     static void exc_not(Reg eip, Reg cs, Reg eflags, Reg error) __attribute__ ((naked));
+    static void exc_lpf(Reg eip, Reg cs, Reg eflags, Reg error) __attribute__ ((naked));
     static void exc_pf (Reg eip, Reg cs, Reg eflags, Reg error) __attribute__ ((naked));
     static void exc_gpf(Reg eip, Reg cs, Reg eflags, Reg error) __attribute__ ((naked));
     static void exc_fpu(Reg eip, Reg cs, Reg eflags, Reg error) __attribute__ ((naked));
 
     static void init();
 
+    static void mask() {
+        Reg16 unmasked = 1 << IRQ_CASCADE;
+        for(unsigned int i = 0; i < IRQS; i++)
+            if(_priority[i] > _level)
+                unmasked |= 1 << i;
+        imr(~(_enabled & unmasked));
+    }
+
 private:
+    static const unsigned int IRQS = Engine::INT_IPI - Engine::INT_FIRST_HARD;
+    static const unsigned int CPUS = Traits<Machine>::CPUS;
+    static const unsigned int STACK_SIZE = Traits<IC>::STACK_SIZE;
+    static const bool deferring = STACK_SIZE || Traits<IC>::deferred; // handlers' reschedules wait for dispatch()
+    static_assert(!(STACK_SIZE % 16), "interrupt stacks must keep SP 16-byte aligned");
+
     static Interrupt_Handler _int_vector[INTS];
+    static Reg16 _enabled;
+    static unsigned int _level;
+    static unsigned int _priority[IRQS];
+    static unsigned int _nesting[CPUS];
+    static bool _rescheduling[CPUS];
+    static char _stack[CPUS][STACK_SIZE];
 };
 
 __END_SYS
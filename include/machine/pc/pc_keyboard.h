@@ -7,6 +7,9 @@
 #include <architecture/cpu.h>
 #include <machine/ic.h>
 #include <machine/keyboard.h>
+#define __mach_common_only__
+#include <machine/machine.h>
+#undef __mach_common_only__
 
 __BEGIN_SYS
 
@@ -161,12 +164,12 @@ public:
     PS2_Keyboard() {}
 
     static char get();
-    static bool ready_to_get() { return (status() & OUT_BUF_FULL); }
+    static bool ready_to_get() { ready(); return (status() & OUT_BUF_FULL); }
 
     using Engine::int_enable;
     using Engine::int_disable;
 
-    static void attach(Observer * obs) { _observed.attach(obs); }
+    static void attach(Observer * obs) { ready(); _observed.attach(obs); }
     static void detach(Observer * obs) { _observed.detach(obs); }
 
 private:
@@ -181,6 +184,12 @@ private:
 
     static void init();
 
+    // With Traits<Keyboard>::lazy, the keyboard is only set up (and its interrupt enabled) when first read or observed
+    static void ready() {
+        if(Traits<Keyboard>::enabled && Traits<Keyboard>::lazy)
+            Machine_Common::Lazy<&init>::init();
+    }
+
 private:
     static unsigned int _status;
     static Scancode _scancodes[255];
@@ -28,6 +28,7 @@ public:
 
     using Machine_Common::delay;
     using Machine_Common::clear_bss;
+    using Machine_Common::temperature;
 
     static void panic();
     static void reboot();
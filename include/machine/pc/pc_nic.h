@@ -0,0 +1,9 @@
+// EPOS PC NIC Mediators Declarations
+
+#ifndef __pc_nic_h
+#define __pc_nic_h
+
+// One header per device, for those listed in Traits<Ethernet>::DEVICES
+#include <machine/pc/pc_pcnet32.h>
+
+#endif
@@ -4,6 +4,10 @@
 #define __pc_pci_h
 
 #include <machine/pci.h>
+#include <machine/ic.h>
+#define __mach_common_only__
+#include <machine/machine.h>
+#undef __mach_common_only__
 #include <system/memory_map.h>
 
 __BEGIN_SYS
@@ -37,6 +41,12 @@ private:
     // determined by the contents of CONFADDR.
     static const int CONFDATA = 0xcfc;
 
+    // With Traits<PCI>::ecam, the PCIe Enhanced Configuration Access Mechanism (ECAM, or MMCONFIG) of the buses listed
+    // in the ACPI MCFG table is mapped by SETUP, 4 KB per function, with bus in [27:20], device and function in [19:12]
+    // and register in [11:0]. Each access is then a single load or store, with no CONFADDR to be kept consistent, and
+    // the extended configuration space (from EXT_CAPABILITIES to EXT_CONFIG_SIZE - 1) is reachable. Other buses and
+    // machines without MCFG still go through CONFADDR and CONFDATA, where extended registers read as ~0.
+
 public:
     PCI() {}
 
@@ -57,36 +67,110 @@ public:
         cfg16(l.bus, l.dev_fn, STATUS, v);
     }
 
+    // Raw access to the configuration space of the device, whose size is EXT_CONFIG_SIZE through ECAM, else CONFIG_SIZE
+    static unsigned int config_size(const Locator & l) {
+        return ecam(l.bus, l.dev_fn, 0) ? EXT_CONFIG_SIZE : CONFIG_SIZE;
+    }
+    static Reg32 config(const Locator & l, Reg16 offset) {
+        return cfg32(l.bus, l.dev_fn, offset);
+    }
+    static void config(const Locator & l, Reg16 offset, Reg32 v) {
+        cfg32(l.bus, l.dev_fn, offset, v);
+    }
+
+    // Offset of the capability "id" in the configuration space of the device, or 0 if it doesn't have it
+    static Reg8 capability(const Locator & l, Reg8 id);
+
+    // Offset of the PCIe extended capability "id" (e.g. EXT_CAP_ID_AER), or 0 if it isn't there or ECAM isn't used
+    static Reg16 extended_capability(const Locator & l, Reg16 id);
+
+    // Message Signaled Interrupts: route "n" interrupts of the device (a power of two for MSI, the first "n" entries of
+    // the table for MSI-X) to consecutive IC interrupts (from IC::INT_FIRST_MSI to IC::INT_LAST_MSI), delivered to
+    // the local APIC of "cpu". The first one is returned (IC_Common::INT_UNKNOWN if the device or the remaining vectors
+    // can't take them) and INTx is disabled for the device. Vectors are never given back.
+    static IC_Common::Interrupt_Id msi(const Locator & l, unsigned int n = 1, unsigned int cpu = 0);
+    static IC_Common::Interrupt_Id msix(const Locator & l, unsigned int n, unsigned int cpu = 0);
+
+    // Masks (or unmasks) a single MSI-X table entry, e.g. the interrupt of one queue while it is being polled
+    static void msix_mask(const Locator & l, unsigned int entry, bool masked);
+
+    // Redirects an interrupt allocated by msi() or msix() to the local APIC of "cpu". MSI vectors of a device share a
+    // single address, so all of them follow; an MSI-X entry moves alone. Returns false for any other interrupt.
+    static bool msi_affinity(IC_Common::Interrupt_Id i, unsigned int cpu);
+
 private:
     static void init();
 
-    static int cmd(Reg8 bus, Reg8 dev_fn, Reg8 addr) {
-        return 0x80000000 | (bus << 16) | (dev_fn << 8) | (addr & ~3);
+    // With Traits<PCI>::lazy, the configuration mechanism is only probed when devices are first looked up
+    static void ready() {
+        if(Traits<PCI>::enabled && Traits<PCI>::lazy)
+            Machine_Common::Lazy<&init>::init();
     }
 
-    static Reg8 cfg8(Reg8 bus, Reg8 dev_fn, Reg8 addr) {
+    static int cmd(Reg8 bus, Reg8 dev_fn, Reg16 addr) {
+        return 0x80000000 | (bus << 16) | (dev_fn << 8) | (addr & 0xfc);
+    }
+
+    // Address of the register in the ECAM, or 0 if the bus is not mapped there
+    static volatile Reg8 * ecam(Reg8 bus, Reg8 dev_fn, Reg16 addr) {
+        if(!Traits<PCI>::ecam || !_ecam || (bus < _ecam_first_bus) || (bus > _ecam_last_bus))
+            return 0;
+        return _ecam + (((bus - _ecam_first_bus) << 20) | (dev_fn << 12) | addr);
+    }
+
+    static Reg8 cfg8(Reg8 bus, Reg8 dev_fn, Reg16 addr) {
+        volatile Reg8 * e = ecam(bus, dev_fn, addr);
+        if(e)
+            return *e;
+        if(addr >= CONFIG_SIZE)
+            return ~0;
         CPU::out32(CONFADDR, cmd(bus, dev_fn, addr));
         return CPU::in8(CONFDATA + (addr & 3));
     }
-    static Reg16 cfg16(Reg8 bus, Reg8 dev_fn, Reg8 addr) {
+    static Reg16 cfg16(Reg8 bus, Reg8 dev_fn, Reg16 addr) {
+        volatile Reg8 * e = ecam(bus, dev_fn, addr);
+        if(e)
+            return *reinterpret_cast<volatile Reg16 *>(e);
+        if(addr >= CONFIG_SIZE)
+            return ~0;
         CPU::out32(CONFADDR, cmd(bus, dev_fn, addr));
         return CPU::in16(CONFDATA + (addr & 2));
     }
-    static Reg32 cfg32(Reg8 bus, Reg8 dev_fn, Reg8 addr) {
+    static Reg32 cfg32(Reg8 bus, Reg8 dev_fn, Reg16 addr) {
+        volatile Reg8 * e = ecam(bus, dev_fn, addr);
+        if(e)
+            return *reinterpret_cast<volatile Reg32 *>(e);
+        if(addr >= CONFIG_SIZE)
+            return ~0;
         CPU::out32(CONFADDR, cmd(bus, dev_fn, addr));
         return CPU::in32(CONFDATA);
     }
-    static void cfg8(Reg8 bus, Reg8 dev_fn, Reg8 addr, Reg8 value) {
-        CPU::out32(CONFADDR, cmd(bus, dev_fn, addr));
-        CPU::out8(CONFDATA + (addr & 3), value);
+    static void cfg8(Reg8 bus, Reg8 dev_fn, Reg16 addr, Reg8 value) {
+        volatile Reg8 * e = ecam(bus, dev_fn, addr);
+        if(e)
+            *e = value;
+        else if(addr < CONFIG_SIZE) {
+            CPU::out32(CONFADDR, cmd(bus, dev_fn, addr));
+            CPU::out8(CONFDATA + (addr & 3), value);
+        }
     }
-    static void cfg16(Reg8 bus, Reg8 dev_fn, Reg8 addr, Reg16 value) {
-        CPU::out32(CONFADDR, cmd(bus, dev_fn, addr));
-        CPU::out16(CONFDATA + (addr & 2), value);
+    static void cfg16(Reg8 bus, Reg8 dev_fn, Reg16 addr, Reg16 value) {
+        volatile Reg8 * e = ecam(bus, dev_fn, addr);
+        if(e)
+            *reinterpret_cast<volatile Reg16 *>(e) = value;
+        else if(addr < CONFIG_SIZE) {
+            CPU::out32(CONFADDR, cmd(bus, dev_fn, addr));
+            CPU::out16(CONFDATA + (addr & 2), value);
+        }
     }
-    static void cfg32(Reg8 bus, Reg8 dev_fn, Reg8 addr, Reg32 value) {
-        CPU::out32(CONFADDR, cmd(bus, dev_fn, addr));
-        CPU::out32(CONFDATA, value);
+    static void cfg32(Reg8 bus, Reg8 dev_fn, Reg16 addr, Reg32 value) {
+        volatile Reg8 * e = ecam(bus, dev_fn, addr);
+        if(e)
+            *reinterpret_cast<volatile Reg32 *>(e) = value;
+        else if(addr < CONFIG_SIZE) {
+            CPU::out32(CONFADDR, cmd(bus, dev_fn, addr));
+            CPU::out32(CONFDATA, value);
+        }
     }
 
     static Reg16 vendor_id(Reg8 bus, Reg8 dev_fn) {
@@ -103,9 +187,26 @@ private:
         return LOG_IO_MEM + (addr - _phy_io_mem);
     }
 
+    static Reg32 msi_address(unsigned int cpu) {
+        return APIC::LOCAL_APIC_PHY_ADDR | (cpu << 12); // destination APIC id in bits 19:12, physical mode
+    }
+    static IC_Common::Interrupt_Id msi_alloc(unsigned int n, unsigned int align);
+    static void msi_route(IC_Common::Interrupt_Id first, unsigned int n, const Locator & l, Reg8 cap, bool msix);
+    static volatile Reg32 * msix_table(const Locator & l, Reg8 cap);
+
   private:
     static Phy_Addr _phy_io_mem;
+    static volatile Reg8 * _ecam;
+    static unsigned int _ecam_first_bus;
+    static unsigned int _ecam_last_bus;
     static Reg32 _base_address[Region::N];
+    static unsigned int _msi_next;
+    static struct Route {
+        Locator locator;
+        Reg8 cap;                       // 0 for a vector not allocated yet
+        bool msix;
+        unsigned short entry;           // of the MSI-X table
+    } _msi_routes[Traits<IC>::MSI_VECTORS ? Traits<IC>::MSI_VECTORS : 1];
 };
 
 __END_SYS
@@ -0,0 +1,280 @@
+// EPOS PC AMD PCNet II (Am79C970A) Ethernet NIC Mediator Declarations
+
+#ifndef __pc_pcnet32_h
+#define __pc_pcnet32_h
+
+#include <architecture/cpu.h>
+#include <architecture/mmu.h>
+#include <machine/ic.h>
+#include <machine/pci.h>
+#include <network/ethernet.h>
+#include <utility/handler.h>
+
+__BEGIN_SYS
+
+class Interrupt_Thread;
+
+// AMD PCNet II (Am79C970A), as emulated by QEMU, used with 32-bit structures (software style 2) and word I/O
+class Am79C970A
+{
+protected:
+    // Type Imports
+    typedef CPU::Reg8 Reg8;
+    typedef CPU::Reg16 Reg16;
+    typedef CPU::Reg32 Reg32;
+    typedef CPU::Log_Addr Log_Addr;
+    typedef CPU::Phy_Addr Phy_Addr;
+    typedef CPU::IO_Port IO_Port;
+    typedef MMU::DMA_Buffer DMA_Buffer;
+    typedef Ethernet::Address MAC_Address;
+
+    // PCI ID
+    static const unsigned int PCI_VENDOR_ID = 0x1022;
+    static const unsigned int PCI_DEVICE_ID = 0x2000;
+    static const unsigned int PCI_REG_IO = 0;
+
+public:
+    // Offsets from base I/O address (PCI region 0) in word I/O mode
+    enum {
+        APROM   = 0x00, // Address PROM (the MAC in the first 6 bytes)
+        RDP     = 0x10, // Register Data Port (the CSR selected by RAP)
+        RAP     = 0x12, // Register Address Port
+        RESET   = 0x14, // Reading it resets the chip
+        BDP     = 0x16  // BCR Data Port (the BCR selected by RAP)
+    };
+
+    // Control and Status Registers (CSR)
+    enum {
+        CSR0    = 0,    // Controller Status
+        CSR1    = 1,    // Init Block Address [15:0]
+        CSR2    = 2,    // Init Block Address [31:16]
+        CSR3    = 3,    // Interrupt Masks and Deferral Control
+        CSR4    = 4,    // Test and Features Control
+        CSR15   = 15    // Mode
+    };
+
+    // CSR0 bits (interrupt causes are cleared by writing a one to them)
+    enum {
+        INIT    = 1 << 0,  // Read the init block
+        STRT    = 1 << 1,  // Start
+        STOP    = 1 << 2,  // Stop
+        TDMD    = 1 << 3,  // Transmit demand (poll the TX ring now)
+        TXON    = 1 << 4,  // Transmitter on
+        RXON    = 1 << 5,  // Receiver on
+        IENA    = 1 << 6,  // Interrupt enable
+        INTR    = 1 << 7,  // Interrupt flag
+        IDON    = 1 << 8,  // Initialization done
+        TINT    = 1 << 9,  // Transmit interrupt
+        RINT    = 1 << 10, // Receive interrupt
+        MERR    = 1 << 11, // Memory error
+        MISS    = 1 << 12, // Missed frame (no RX descriptor owned by the chip)
+        CERR    = 1 << 13, // Collision error
+        BABL    = 1 << 14, // Babble (transmitter time-out)
+        ERR     = 1 << 15  // BABL | CERR | MISS | MERR
+    };
+
+    // CSR3 bits (interrupt masks)
+    enum {
+        IDONM   = 1 << 8,
+        TINTM   = 1 << 9,
+        RINTM   = 1 << 10,
+        MERRM   = 1 << 11,
+        MISSM   = 1 << 12
+    };
+
+    // CSR4 bits
+    enum {
+        APAD_XMT = 1 << 11  // Pad short frames on transmission
+    };
+
+    // Bus Configuration Registers (BCR)
+    enum {
+        BCR20   = 20    // Software Style
+    };
+
+    // BCR20 software styles
+    enum {
+        SWSTYLE_PCNET_PCI = 2   // 32-bit init block and descriptors
+    };
+
+    // Initialization block (software style 2)
+    struct Init_Block {
+        enum {
+            PROM = 1 << 15 // Promiscuous mode
+        };
+
+        Reg16 mode;
+        Reg8 rlen;          // log2(RX ring length) << 4
+        Reg8 tlen;          // log2(TX ring length) << 4
+        MAC_Address mac_addr;
+        Reg16 reserved;
+        Reg32 filter1;      // Logical (multicast) address filter
+        Reg32 filter2;
+        Reg32 rx_ring;
+        Reg32 tx_ring;
+    } __attribute__((packed));
+
+    // Descriptors (software style 2), 16-byte aligned
+    struct Desc {
+        enum {
+            OWN = 0x8000,   // Owned by the chip
+            ERR = 0x4000,
+            STP = 0x0200,   // Start of packet
+            ENP = 0x0100    // End of packet
+        };
+
+        volatile Reg32 phy_addr;
+        volatile Reg16 size;    // Two's complement of the byte count, with the four upper bits set
+        volatile Reg16 status;
+        volatile Reg32 misc;
+        volatile Reg32 reserved;
+    };
+
+    struct Rx_Desc: public Desc {
+        enum {
+            FRAM = 0x2000,  // Framing error
+            OFLO = 0x1000,  // Overflow
+            CRC  = 0x0800,  // CRC error
+            BUFF = 0x0400   // Buffer error
+        };
+        // misc[11:0] is the message byte count, including the CRC
+    };
+
+    struct Tx_Desc: public Desc {
+        enum {
+            MORE = 0x1000,  // More than one retry was needed
+            ONE  = 0x0800,  // Exactly one retry was needed
+            DEF  = 0x0400   // Deferred
+        };
+    };
+
+protected:
+    Am79C970A(IO_Port io): _io_port(io) {}
+
+    void s_reset() { CPU::in16(_io_port + RESET); }
+
+    Reg16 csr(unsigned int r) { CPU::out16(_io_port + RAP, r); return CPU::in16(_io_port + RDP); }
+    void csr(unsigned int r, Reg16 v) { CPU::out16(_io_port + RAP, r); CPU::out16(_io_port + RDP, v); }
+    Reg16 bcr(unsigned int r) { CPU::out16(_io_port + RAP, r); return CPU::in16(_io_port + BDP); }
+    void bcr(unsigned int r, Reg16 v) { CPU::out16(_io_port + RAP, r); CPU::out16(_io_port + BDP, v); }
+
+    Reg8 prom(unsigned int i) { return CPU::in8(_io_port + APROM + i); }
+
+    static Reg16 byte_count(unsigned int s) { return 0xf000 | (-s & 0x0fff); }
+
+protected:
+    IO_Port _io_port;
+};
+
+
+// PCNet32 Ethernet NIC
+// RX and TX rings, the init block and the buffers are cut from a single DMA_Buffer per unit. Each RX descriptor is bound
+// to a Buffer for good, so frames are received in place and handed up (see NIC) without being copied. A received
+// Buffer keeps its descriptor away from the chip until it is free()d, so holding many of them makes the chip miss
+// frames. TX Buffers are taken from a pool by alloc() and bound to the next TX descriptor, in ring order, by send().
+// With Traits<Ethernet>::polled, the interrupt handler only acknowledges the chip and masks RX interrupts, waking up an
+// Interrupt_Thread that hands the frames up in batches of POLL_BUDGET while the ring has them, unmasking RX interrupts
+// again once it is drained (as Linux's NAPI does). The thread is created by the first attach().
+class PCNet32: public NIC<Ethernet>, private Am79C970A
+{
+    friend class Machine;
+
+private:
+    // Traits
+    static const unsigned int UNITS = Traits<PCNet32>::UNITS;
+    static const unsigned int TX_BUFS = Traits<PCNet32>::SEND_BUFFERS;
+    static const unsigned int RX_BUFS = Traits<PCNet32>::RECEIVE_BUFFERS;
+    static const bool promiscuous = Traits<PCNet32>::promiscuous;
+    static const bool polled = Traits<Ethernet>::polled;
+    static const unsigned int POLL_BUDGET = Traits<Ethernet>::POLL_BUDGET;
+
+    static_assert(TX_BUFS && !(TX_BUFS & (TX_BUFS - 1)) && (TX_BUFS <= 512), "PCNet32 rings must be powers of two up to 512");
+    static_assert(RX_BUFS && !(RX_BUFS & (RX_BUFS - 1)) && (RX_BUFS <= 512), "PCNet32 rings must be powers of two up to 512");
+
+    // Sizes of the pieces of the DMA_Buffer, each 16-byte aligned
+    static const unsigned int ALIGN = 16;
+    static const unsigned int INIT_BLOCK_SIZE = (sizeof(Init_Block) + ALIGN - 1) & ~(ALIGN - 1);
+    static const unsigned int RX_RING_SIZE = RX_BUFS * sizeof(Rx_Desc);
+    static const unsigned int TX_RING_SIZE = TX_BUFS * sizeof(Tx_Desc);
+    static const unsigned int BUFFER_SIZE = (sizeof(Buffer) + ALIGN - 1) & ~(ALIGN - 1);
+    static const unsigned int DMA_BUFFER_SIZE = INIT_BLOCK_SIZE + RX_RING_SIZE + TX_RING_SIZE + (RX_BUFS + TX_BUFS) * BUFFER_SIZE;
+
+    // Interrupt dispatching binding
+    struct Device {
+        PCNet32 * device;
+        IC::Interrupt_Id interrupt;
+    };
+
+protected:
+    PCNet32(unsigned int unit, IO_Port io, const IC::Interrupt_Id & irq, DMA_Buffer * dma);
+
+public:
+    ~PCNet32();
+
+    int send(const Address & dst, const Protocol & prot, const void * data, unsigned int size);
+    int receive(Address * src, Protocol * prot, void * data, unsigned int size);
+
+    Buffer * alloc(const Address & dst, const Protocol & prot, unsigned int payload);
+    int send(Buffer * buf);
+    void free(Buffer * buf);
+
+    const Address & address() { return _address; }
+    const Statistics & statistics() { return _statistics; }
+
+    void reset();
+
+    void attach(Observer * o, const Protocol & p);
+
+    static PCNet32 * get(unsigned int unit = 0) { return (unit < UNITS) ? _devices[unit].device : 0; }
+
+private:
+    Buffer * take();
+    void reclaim();
+    void recycle(Buffer * buf);
+    Reg16 acknowledge();
+    unsigned int deliver(unsigned int budget);
+    void poll();
+    void handle_int();
+
+    bool lock();
+    void unlock(bool ie);
+
+    Phy_Addr phy(const void * log) const { return _dma_buf->phy_address() + (Log_Addr(log) - _dma_buf->log_address()); }
+
+    static void int_handler(IC::Interrupt_Id interrupt);
+    static void int_ack(IC::Interrupt_Id interrupt);
+    static void bottom_half(PCNet32 * dev);
+
+    static void init(unsigned int unit);
+    static void init();
+
+private:
+    unsigned int _unit;
+    IC::Interrupt_Id _interrupt;
+    Address _address;
+    Statistics _statistics;
+    volatile int _lock;
+
+    DMA_Buffer * _dma_buf;
+    Init_Block * _iblock;
+    Rx_Desc * _rx_ring;
+    Tx_Desc * _tx_ring;
+
+    unsigned int _rx_cur;   // next RX descriptor the chip will fill
+    unsigned int _tx_cur;   // next TX descriptor to be given to the chip
+    unsigned int _tx_clean; // oldest TX descriptor not yet reclaimed
+    unsigned int _tx_pending;
+
+    Buffer * _rx_buffer[RX_BUFS];
+    Buffer * _tx_buffer[TX_BUFS];
+    Buffer * _tx_sent[TX_BUFS]; // the Buffer each TX descriptor is sending
+
+    Functor_Handler<PCNet32> _bottom_half;
+    Interrupt_Thread * _poller;
+
+    static Device _devices[UNITS];
+};
+
+__END_SYS
+
+#endif
@@ -6,6 +6,9 @@
 #define __scratchpad_common_only__
 #include <machine/scratchpad.h>
 #undef __scratchpad_common_only__
+#define __mach_common_only__
+#include <machine/machine.h>
+#undef __mach_common_only__
 
 __BEGIN_SYS
 
@@ -20,6 +23,13 @@ private:
 public:
     Scratchpad() {}
 
+    // With Traits<Scratchpad>::lazy, the scratchpad is only mapped by the first allocation
+    static void * alloc(unsigned int bytes) {
+        if(Traits<Scratchpad>::enabled && Traits<Scratchpad>::lazy)
+            Machine_Common::Lazy<&init>::init();
+        return Scratchpad_Base::alloc(bytes);
+    }
+
 private:
     static void init();
 };
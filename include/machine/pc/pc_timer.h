@@ -3,6 +3,7 @@
 #ifndef __pc_timer_h
 #define __pc_timer_h
 
+#include <architecture/tsc.h>
 #include <machine/machine.h>
 #include <machine/ic.h>
 #include <machine/rtc.h>
@@ -121,6 +122,16 @@ public:
         return count;
     }
 
+    // Counts since channel 0 last raised its interrupt, given its "period". In the square wave mode it is set to, it
+    // counts down twice per period, by 2, with OUT high during the first half, which only a read-back can tell.
+    static Count elapsed(const Count & period) {
+        CPU::out8(CTRL, RB | 0x02); // latch both the status and the count of counter 0
+        bool first = CPU::in8(CNT_0) & 0x80; // OUT
+        Count count = CPU::in8(CNT_0) | (CPU::in8(CNT_0) << 8);
+        Count half = (period - count) / 2;
+        return first ? half : period / 2 + half;
+    }
+
     static void reset(int channel) {
         // 8253 doesn't feature a reset, but a counter can be reset by writing
         // the corresponding control register
@@ -285,8 +296,27 @@ public:
 
     void handler(const Handler & handler) { _handler = handler; }
 
+    // Tickless operation is not supported (yet) by this timer: ticks are never suppressed
+    static void sleep(const Tick & ticks) {}
+    static bool sleeping() { return false; }
+    static Tick skipped() { return 0; }
+
+    // One-shot operation (Traits<Timer>::one_shot): besides the PIT's periodic ticks, the local APIC timer interrupts once
+    // when the TSC reaches "deadline" and calls "handler". With TSC-deadline mode, arming it is a single MSR write; elsewhere,
+    // the APIC timer counts down the bus clock and may fire early for deadlines over a second away (which finds nothing due).
+    // A new deadline replaces the previous one, which is never reported.
+    static const bool ONE_SHOT = Traits<Timer>::one_shot;
+    static const bool LOCAL = true; // every CPU's local APIC timer ticks through int_handler() (see Alarm_Timer)
+    static void one_shot(const TSC_Common::Time_Stamp & deadline, const Handler & handler);
+
+    // TSC ticks since channel 0 raised its interrupt, i.e. how late it is being served if called before its handler
+    static TSC_Common::Time_Stamp late() {
+        return TSC_Common::Time_Stamp(Engine::elapsed(Engine::clock() / FREQUENCY)) * TSC::frequency() / Engine::clock();
+    }
+
 private:
     static void int_handler(Interrupt_Id i);
+    static void one_shot_handler(Interrupt_Id i);
 
     static void init();
 
@@ -298,6 +328,8 @@ protected:
     Handler _handler;
 
     static Timer * _channels[CHANNELS];
+    static bool _tsc_deadline;
+    static Handler _one_shot;
 };
 
 
@@ -306,13 +338,23 @@ class Scheduler_Timer: public Timer
 {
 public:
     Scheduler_Timer(Microsecond quantum, const Handler & handler): Timer(SCHEDULER, 1000000 / quantum, handler) {}
+
+    using Timer::restart;
+
+    // Starts a slice of "quantum" instead of the one given at construction (see Criterion::quantum())
+    int restart(const Microsecond & quantum) {
+        int percentage = restart();
+        Tick ticks = static_cast<unsigned long long>(quantum) * FREQUENCY / 1000000;
+        _current = ticks ? ticks : 1;
+        return percentage;
+    }
 };
 
 // Timer used by Alarm
 class Alarm_Timer: public Timer
 {
 public:
-    Alarm_Timer(const Handler & handler): Timer(ALARM, FREQUENCY, handler) {}
+    Alarm_Timer(const Handler & handler, bool local = false): Timer(ALARM, FREQUENCY, handler) {}
 };
 
 
@@ -43,7 +43,8 @@ public:
         SUBSYSTEM_VENDOR_ID	= 0x2c, // 16 bits
         SUBSYSTEM_DEVICE_ID	= 0x2e, // 16 bits
         ROM_ADDRESS		= 0x30, // [11:31] address, [1:10] reserved
-        				// 0x34-0x3b are reserved	
+        CAPABILITIES		= 0x34, //  8 bits, first capability (if STATUS_CAP_LIST)
+        				// 0x35-0x3b are reserved
         INTERRUPT_LINE		= 0x3c, //  8 bits
         INTERRUPT_PIN		= 0x3d, //  8 bits
         MIN_GNT			= 0x3e, //  8 bits
@@ -62,6 +63,7 @@ public:
         COMMAND_WAIT		= 0x80,  // Enable address/data stepping
         COMMAND_SERR		= 0x100, // Enable SERR
         COMMAND_FAST_BACK	= 0x200, // Enable back-to-back writes
+        COMMAND_INTX_DISABLE	= 0x400, // Disable INTx (legacy) interrupts
     };
 
     // PCI STATUS register
@@ -89,6 +91,58 @@ public:
         HEADER_TYPE_CARDBUS	= 2,
     };
 
+    // PCI capabilities (each one starts with an 8-bit id followed by the 8-bit offset of the next)
+    enum {
+        CAP_ID			= 0x00,
+        CAP_NEXT		= 0x01,
+        CAP_ID_MSI		= 0x05,
+        CAP_ID_MSIX		= 0x11
+    };
+
+    // PCIe extended capabilities (from EXT_CAPABILITIES on, only through ECAM; each starts with a 32-bit header holding
+    // a 16-bit id, a 4-bit version and the 12-bit offset of the next)
+    enum {
+        CONFIG_SIZE		= 0x100,
+        EXT_CONFIG_SIZE		= 0x1000,
+        EXT_CAPABILITIES	= 0x100,
+        EXT_CAP_ID_MASK		= 0xffff,
+        EXT_CAP_NEXT_SHIFT	= 20,
+        EXT_CAP_ID_AER		= 0x0001,
+        EXT_CAP_ID_SRIOV	= 0x0010
+    };
+
+    // MSI capability
+    enum {
+        MSI_CONTROL		= 0x02, // 16 bits
+        MSI_ADDRESS		= 0x04, // 32 bits
+        MSI_ADDRESS_HI		= 0x08, // 32 bits, if MSI_CONTROL_64
+        MSI_DATA_32		= 0x08, // 16 bits
+        MSI_DATA_64		= 0x0c, // 16 bits
+        MSI_CONTROL_ENABLE	= 0x0001,
+        MSI_CONTROL_MMC_SHIFT	= 1,    // Multiple Message Capable (log2)
+        MSI_CONTROL_MMC_MASK	= 0x000e,
+        MSI_CONTROL_MME_SHIFT	= 4,    // Multiple Message Enable (log2)
+        MSI_CONTROL_MME_MASK	= 0x0070,
+        MSI_CONTROL_64		= 0x0080
+    };
+
+    // MSI-X capability and table entries
+    enum {
+        MSIX_CONTROL		= 0x02, // 16 bits
+        MSIX_TABLE		= 0x04, // 32 bits, offset in the BAR selected by the lower 3 bits (BIR)
+        MSIX_PBA		= 0x08, // 32 bits, same as above, for the pending bits
+        MSIX_CONTROL_SIZE_MASK	= 0x07ff, // table size - 1
+        MSIX_CONTROL_MASK	= 0x4000, // Function mask
+        MSIX_CONTROL_ENABLE	= 0x8000,
+        MSIX_BIR_MASK		= 0x7,
+        MSIX_ENTRY_SIZE		= 16,
+        MSIX_ENTRY_ADDRESS	= 0x00,
+        MSIX_ENTRY_ADDRESS_HI	= 0x04,
+        MSIX_ENTRY_DATA		= 0x08,
+        MSIX_ENTRY_CONTROL	= 0x0c,
+        MSIX_ENTRY_MASKED	= 0x1
+    };
+
     // PCI BIST register
     enum {
         BIST_CODE_MASK	= 0x0f, // Return result
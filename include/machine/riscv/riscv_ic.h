@@ -31,6 +31,7 @@ public:
         IRQ_USR_EXT             = 8,
         IRQ_SUP_EXT             = 9,
         IRQ_MAC_EXT             = 11,
+        IRQ_PMU                 = 13,   // local counter overflow (Sscofpmf)
         INTERRUPT               = 1UL << (Traits<CPU>::WORD_SIZE - 1),
         INT_MASK                = ~INTERRUPT
 
@@ -76,24 +77,94 @@ public:
     }
 };
 
+// Platform-Level Interrupt Controller (PLIC)
+// Routes the external sources (1 to IRQS - 1; 0 means "none") to the hart contexts. A source only interrupts a
+// context that has it enabled if its priority (0 = never) is above the context's threshold. The machine external
+// interrupt is taken while any such source is pending; claim() returns the one with the highest priority and keeps
+// it from being claimed again until complete().
+class PLIC
+{
+public:
+    static const unsigned int IRQS = Traits<IC>::PLIC_IRQS;
+    static const unsigned int PRIORITIES = 7;
+
+    // Registers offsets from PLIIC_CPU_BASE
+    enum {                                // Description
+        PRIORITY                = 0x000000, // Priority of each source (one word each)
+        PENDING                 = 0x001000, // Pending bits (one per source)
+        ENABLE                  = 0x002000, // Enable bits (one per source) of each context
+        ENABLE_CONTEXT_OFFSET   = 0x80,
+        THRESHOLD               = 0x200000, // Priority threshold of each context
+        CLAIM                   = 0x200004, // Claim (read) and complete (write) of each context
+        CONTEXT_OFFSET          = 0x1000
+    };
+
+public:
+    static void priority(unsigned int irq, unsigned int p) { reg(PRIORITY + irq * 4) = p; }
+    static unsigned int priority(unsigned int irq) { return reg(PRIORITY + irq * 4); }
+
+    static bool pending(unsigned int irq) { return reg(PENDING + irq / 32 * 4) & (1 << (irq % 32)); }
+
+    static void enable(unsigned int irq) { enables(irq) = enables(irq) | (1 << (irq % 32)); }
+    static void disable(unsigned int irq) { enables(irq) = enables(irq) & ~(1 << (irq % 32)); }
+    static bool enabled(unsigned int irq) { return enables(irq) & (1 << (irq % 32)); }
+
+    // The same for the context of any hart, which is how a source is steered to some of them
+    static void enable(unsigned int irq, unsigned int hart) { enables(irq, hart) = enables(irq, hart) | (1 << (irq % 32)); }
+    static void disable(unsigned int irq, unsigned int hart) { enables(irq, hart) = enables(irq, hart) & ~(1 << (irq % 32)); }
+
+    static void threshold(unsigned int t) { reg(THRESHOLD + context() * CONTEXT_OFFSET) = t; }
+    static unsigned int threshold() { return reg(THRESHOLD + context() * CONTEXT_OFFSET); }
+
+    static unsigned int claim() { return reg(CLAIM + context() * CONTEXT_OFFSET); }
+    static void complete(unsigned int irq) { reg(CLAIM + context() * CONTEXT_OFFSET) = irq; }
+
+private:
+    // Machine-mode context of the running hart: hart 0's is always 0, the others' start at PLIC_CONTEXT_1 and
+    // alternate with their supervisor-mode ones
+    static unsigned int context() { return context(CPU::mhartid()); }
+    static unsigned int context(unsigned int hart) { return hart ? Traits<IC>::PLIC_CONTEXT_1 + (hart - 1) * 2 : 0; }
+
+    static volatile CPU::Reg32 & enables(unsigned int irq) { return enables(irq, CPU::mhartid()); }
+    static volatile CPU::Reg32 & enables(unsigned int irq, unsigned int hart) {
+        return reg(ENABLE + context(hart) * ENABLE_CONTEXT_OFFSET + irq / 32 * 4);
+    }
+
+    static volatile CPU::Reg32 & reg(unsigned int o) { return reinterpret_cast<volatile CPU::Reg32 *>(Memory_Map::PLIIC_CPU_BASE)[o / sizeof(CPU::Reg32)]; }
+};
+
 class IC: private IC_Common, private CLINT
 {
     friend class Setup;
     friend class Machine;
+    friend class Thread;
 
 private:
     typedef CPU::Reg Reg;
 
+    static const unsigned int CPUS = Traits<Machine>::CPUS;
+    static const unsigned int STACK_SIZE = Traits<IC>::STACK_SIZE;
+    static const bool deferring = STACK_SIZE || Traits<IC>::deferred; // handlers' reschedules wait for stacked()
+    static_assert(!(STACK_SIZE % 16), "interrupt stacks must keep SP 16-byte aligned");
+
 public:
     static const unsigned int EXCS = CPU::EXCEPTIONS;
     static const unsigned int IRQS = CLINT::IRQS;
-    static const unsigned int INTS = EXCS + IRQS;
+    static const unsigned int PLIC_IRQS = PLIC::IRQS;
+    static const unsigned int INTS = EXCS + IRQS + PLIC_IRQS;
 
     using IC_Common::Interrupt_Id;
     using IC_Common::Interrupt_Handler;
 
+    // External interrupts get their own ids after CLINT's, from INT_PLIC on
     enum {
-        INT_SYS_TIMER = EXCS + IRQ_MAC_TIMER
+        INT_IPI       = EXCS + IRQ_MAC_SOFT,
+        INT_SYS_TIMER = EXCS + IRQ_MAC_TIMER,
+        INT_EXTERNAL  = EXCS + IRQ_MAC_EXT,
+        INT_PMU       = EXCS + IRQ_PMU,
+        INT_PLIC      = EXCS + IRQS,
+        INT_UART0     = INT_PLIC + Traits<IC>::UART0_IRQ,
+        INT_RESCHEDULER = INT_IPI // harts have a single software interrupt, which carries all IPI messages
     };
 
 public:
@@ -112,28 +183,77 @@ public:
 
     static void enable() {
         db<IC>(TRC) << "IC::enable()" << endl;
-        CPU::mie(CPU::MSI | CPU::MTI | CPU::MEI);
+        CPU::mie((CPU::mie() & CPU::LCOFI) | CPU::MSI | CPU::MTI | CPU::MEI);
     }
 
+    // External interrupts are enabled one by one at the PLIC, for the running hart. CLINT's are still enabled together.
+    // Counter overflows (INT_PMU) are local to each hart and enabled on their own.
     static void enable(Interrupt_Id i) {
         db<IC>(TRC) << "IC::enable(int=" << i << ")" << endl;
         assert(i < INTS);
-        enable();
-        // TODO: this should handle individual INTs and also be done at PLIC
+        if(i >= INT_PLIC) {
+            PLIC::enable(i - INT_PLIC);
+            CPU::mies(CPU::MEI);
+        } else if(i == INT_PMU)
+            CPU::mies(CPU::LCOFI);
+        else
+            enable();
     }
 
     static void disable() {
         db<IC>(TRC) << "IC::disable()" << endl;
-        CPU::miec(CPU::MSI | CPU::MTI | CPU::MEI);
+        CPU::miec(CPU::MSI | CPU::MTI | CPU::MEI | CPU::LCOFI);
     }
 
     static void disable(Interrupt_Id i) {
         db<IC>(TRC) << "IC::disable(int=" << i << ")" << endl;
         assert(i < INTS);
-        disable();
-        // TODO: this should handle individual INTs and also be done at PLIC
+        if(i >= INT_PLIC)
+            PLIC::disable(i - INT_PLIC);
+        else if(i == INT_PMU)
+            CPU::miec(CPU::LCOFI);
+        else
+            disable();
+    }
+
+    // Steers an external interrupt to the harts in "cpus" (bit n for hart n), the first of which to claim it serves it.
+    // CLINT's interrupts are per hart and can't be steered.
+    static bool affinity(Interrupt_Id i, unsigned long cpus) {
+        db<IC>(TRC) << "IC::affinity(int=" << i << ",cpus=" << cpus << ")" << endl;
+        assert(i < INTS);
+        if((i < INT_PLIC) || !(cpus & ((1UL << CPUS) - 1)))
+            return false;
+        for(unsigned int cpu = 0; cpu < CPUS; cpu++)
+            if(cpus & (1UL << cpu))
+                PLIC::enable(i - INT_PLIC, cpu);
+            else
+                PLIC::disable(i - INT_PLIC, cpu);
+        return true;
     }
 
+    // Priorities (1 to PLIC::PRIORITIES, 0 masks the source) and the threshold only apply to external interrupts:
+    // a source interrupts the running hart only if its priority is above the hart's threshold
+    // The threshold is this IC's level: with Traits<IC>::nested, dispatch() raises it to the priority of the source
+    // being handled, while the CLINT interrupts (e.g. the timer) remain above any level
+    static const unsigned int PRIORITIES = PLIC::PRIORITIES;
+
+    static void priority(Interrupt_Id i, unsigned int p) {
+        db<IC>(TRC) << "IC::priority(int=" << i << ",p=" << p << ")" << endl;
+        assert((i >= INT_PLIC) && (i < INTS) && (p <= PLIC::PRIORITIES));
+        PLIC::priority(i - INT_PLIC, p);
+    }
+    static unsigned int priority(Interrupt_Id i) { return (i >= INT_PLIC) ? PLIC::priority(i - INT_PLIC) : 0; }
+
+    static void threshold(unsigned int t) {
+        db<IC>(TRC) << "IC::threshold(t=" << t << ")" << endl;
+        assert(t <= PLIC::PRIORITIES);
+        PLIC::threshold(t);
+    }
+    static unsigned int threshold() { return PLIC::threshold(); }
+
+    static void level(unsigned int l) { PLIC::threshold(l); }
+    static unsigned int level() { return PLIC::threshold(); }
+
     static Interrupt_Id int_id() {
         // Id is retrieved from [m|s]cause even if mip has the equivalent bit up, because only [m|s]cause can tell if it is an interrupt or an exception
         Reg id = CPU::mcause();
@@ -143,18 +263,41 @@ public:
             return (id & INT_MASK);
     }
 
+    // Inter-processor interrupts are CLINT's machine software interrupts, which dispatch() acknowledges before calling
+    // the handler of INT_IPI
+    static void ipi(unsigned int cpu) { reg(MSIP + cpu * MSIP_CORE_OFFSET) = 1; }
+    static void ipi(unsigned int cpu, Interrupt_Id i) { ipi(cpu); }
+    static void ipi_eoi() { reg(MSIP + CPU::id() * MSIP_CORE_OFFSET) = 0; }
+
     static int irq2int(int i) { return i + EXCS; }
     static int int2irq(int i) { return i - EXCS; }
 
 private:
     static void dispatch();
+    static void serve(Interrupt_Id id);
+    static void stacked(Interrupt_Handler handler, Interrupt_Id id);
+
+    // Whether a context switch requested by a handler must wait for stacked() to be back on the thread's stack (or, with
+    // Traits<IC>::deferred, for the outermost handler to return, so several wakeups in a burst of them switch only once)
+    static bool defer_reschedule() {
+        if(!deferring || !_nesting[CPU::id()])
+            return false;
+        _rescheduling[CPU::id()] = true;
+        return true;
+    }
 
     // Logical handlers
     static void int_not(Interrupt_Id i);
     static void exception(Interrupt_Id i);
 
-    // Physical handler
+    // Physical handlers
+    // With Traits<IC>::vectored, mtvec points to vector(), a table of jumps indexed by the interrupt cause: the
+    // machine timer goes straight to timer_entry() and everything else (including exceptions) to entry()
     static void entry() __attribute((naked, aligned(4)));
+    static void timer_entry() __attribute((naked, aligned(4)));
+    static void timer_dispatch();
+    static void timer_serve(Interrupt_Id i);
+    static void vector() __attribute((naked, aligned(256)));
 
     static void init();
 
@@ -162,6 +305,9 @@ private:
 
 private:
     static Interrupt_Handler _int_vector[INTS];
+    static unsigned int _nesting[CPUS];
+    static bool _rescheduling[CPUS];
+    static char _stack[CPUS][STACK_SIZE];
 };
 
 __END_SYS
@@ -6,6 +6,7 @@
 #include <machine/io.h>
 #include <system/memory_map.h>
 #include <time.h>
+#include <utility/bitmap.h>
 
 __BEGIN_SYS
 
@@ -55,6 +56,10 @@ public:
     static const unsigned int TKL_DELAY = Traits<OTP>::TKL_DELAY;
     static const unsigned int TMS_DELAY = Traits<OTP>::TMS_DELAY;
 
+    // Fuses read so far are kept in RAM (see read_shot())
+    static const bool cached = Traits<OTP>::cached;
+    static const unsigned int CACHED_FUSES = cached ? TOTAL_FUSES : 1;
+
     // OTP registers offsets from OTP_BASE
     enum
     {
@@ -95,9 +100,7 @@ public:
         unsigned int fuse_id = offset;  // 0
         unsigned int fuse_count = size; // 3840
 
-        db<OTP>(WRN) << "Started reading OTP!" << endl;
-        db<OTP>(WRN) << "Offset = " << offset << endl;
-        db<OTP>(WRN) << "Size = " << size << endl;
+        db<OTP>(TRC) << "SiFive_OTP::read_shot(offset=" << offset << ",size=" << size << ")" << endl;
 
         //  Check bounds.
         if (offset < 0 || size < 0)
@@ -107,52 +110,26 @@ public:
         if ((fuse_id + fuse_count) > TOTAL_FUSES)
             return EINVAL + 3;
 
-        int fuse_buf[fuse_count];
-
-        db<OTP>(WRN) << "Gathering registers!" << endl;
-
-        // Init OTP.
-        IO::writel(PDSTB_DEEP_STANDBY_ENABLE, (volatile void*) SiFive_OTP::PDSTB);
-        IO::writel(PTRIM_ENABLE_INPUT,  (volatile void*) SiFive_OTP::PTRIM);
-        IO::writel(PCE_ENABLE_INPUT, (volatile void*) SiFive_OTP::PCE);
-
-        // db<OTP>(WRN) << "PDSTB REG = " << reg(SiFive_OTP::PDSTB) << endl;
-        // db<OTP>(WRN) << "PTRIM REG = " << reg(SiFive_OTP::PTRIM) << endl;
-        // db<OTP>(WRN) << "PCE REG = " << reg(SiFive_OTP::PCE) << endl;
-
-        // Read all requested fuses.
-        for (unsigned int i = 0; i < fuse_count; i++, fuse_id++)
-        {
-            IO::writel(fuse_id, (volatile void*) SiFive_OTP::PA);
-            // db<OTP>(WRN) << "PA REG = " << reg(SiFive_OTP::PA) << endl;
-
-            /* cycle clock to read */
-            IO::writel(PCLK_ENABLE_VAL, (volatile void*) SiFive_OTP::PCLK);
-            // db<OTP>(WRN) << "PCLK REG = " << reg(SiFive_OTP::PCLK) << endl;
-
-            Delay tcd(TCD_DELAY);
-
-            IO::writel(PCLK_DISABLE_VAL, (volatile void*) SiFive_OTP::PCLK);
-            // db<OTP>(WRN) << "PCLK REG = " << reg(SiFive_OTP::PCLK) << endl;
-
-            Delay tkl(TKL_DELAY);
-
-            /* read the value */
-            // db<OTP>(WRN) << "PDOUT REG = " << reg(SiFive_OTP::PDOUT) << endl;
-            fuse_buf[i] = IO::readl((volatile void*) SiFive_OTP::PDOUT);
+        Reg32 * out = reinterpret_cast<Reg32 *>(buf);
+        if(!cached) {
+            fetch(fuse_id, out, fuse_count);
+            return size;
         }
 
-        // db<OTP>(WRN) << "PCE REG = " << reg(SiFive_OTP::PCE) << endl;
-        // db<OTP>(WRN) << "PTRIM REG = " << reg(SiFive_OTP::PTRIM) << endl;
-        // db<OTP>(WRN) << "PDSTB REG = " << reg(SiFive_OTP::PDSTB) << endl;
-
-        // Shut down.
-        IO::writel(PCE_DISABLE_INPUT, (volatile void*) SiFive_OTP::PCE);
-        IO::writel(PTRIM_DISABLE_INPUT, (volatile void*) SiFive_OTP::PTRIM);
-        IO::writel(PDSTB_DEEP_STANDBY_DISABLE, (volatile void*) SiFive_OTP::PDSTB);
-
-        // Copy out.
-        memcpy(buf, fuse_buf, size);
+        // Fuses that are not in the cache yet are read in runs, each with a single power-up of the macro
+        for(unsigned int i = 0; i < fuse_count; ) {
+            if(_valid.test(fuse_id + i)) {
+                out[i] = _cache[fuse_id + i];
+                i++;
+                continue;
+            }
+            int next = _valid.find_first_set(fuse_id + i);
+            unsigned int n = ((next < 0) || (next > int(fuse_id + fuse_count))) ? fuse_count - i : next - (fuse_id + i);
+            fetch(fuse_id + i, &_cache[fuse_id + i], n);
+            _valid.set(fuse_id + i, fuse_id + i + n);
+            memcpy(&out[i], &_cache[fuse_id + i], n * sizeof(Reg32));
+            i += n;
+        }
 
         return size;
     }
@@ -244,10 +221,50 @@ public:
         IO::writel(PTM_RESET_VAL, (volatile void*) SiFive_OTP::PTM);
         IO::writel(PTRIM_DISABLE_INPUT, (volatile void*) SiFive_OTP::PTRIM);
         IO::writel(PDSTB_DEEP_STANDBY_DISABLE, (volatile void*) SiFive_OTP::PDSTB);
-        
+
+        // Programming only sets bits (and might not set them all), so the fuses are read again next time
+        if(cached)
+            _valid.reset(offset, offset + size);
+
         return size;
     }
 
+private:
+    // Reads "n" fuses from "fuse" on into "dst"
+    void fetch(unsigned int fuse, Reg32 * dst, unsigned int n)
+    {
+        db<OTP>(TRC) << "SiFive_OTP::fetch(fuse=" << fuse << ",n=" << n << ")" << endl;
+
+        // Init OTP.
+        IO::writel(PDSTB_DEEP_STANDBY_ENABLE, (volatile void*) SiFive_OTP::PDSTB);
+        IO::writel(PTRIM_ENABLE_INPUT,  (volatile void*) SiFive_OTP::PTRIM);
+        IO::writel(PCE_ENABLE_INPUT, (volatile void*) SiFive_OTP::PCE);
+
+        // Read all requested fuses.
+        for (unsigned int i = 0; i < n; i++, fuse++)
+        {
+            IO::writel(fuse, (volatile void*) SiFive_OTP::PA);
+
+            /* cycle clock to read */
+            IO::writel(PCLK_ENABLE_VAL, (volatile void*) SiFive_OTP::PCLK);
+            Delay tcd(TCD_DELAY);
+            IO::writel(PCLK_DISABLE_VAL, (volatile void*) SiFive_OTP::PCLK);
+            Delay tkl(TKL_DELAY);
+
+            /* read the value */
+            dst[i] = IO::readl((volatile void*) SiFive_OTP::PDOUT);
+        }
+
+        // Shut down.
+        IO::writel(PCE_DISABLE_INPUT, (volatile void*) SiFive_OTP::PCE);
+        IO::writel(PTRIM_DISABLE_INPUT, (volatile void*) SiFive_OTP::PTRIM);
+        IO::writel(PDSTB_DEEP_STANDBY_DISABLE, (volatile void*) SiFive_OTP::PDSTB);
+    }
+
+private:
+    static Reg32 _cache[CACHED_FUSES];
+    static Bitmap<CACHED_FUSES> _valid;
+
 //private:
 //    static volatile CPU::Reg32 &reg(unsigned int o)
 //    {
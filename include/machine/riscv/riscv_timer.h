@@ -4,6 +4,7 @@
 #define __riscv_timer_h
 
 #include <architecture/cpu.h>
+#include <architecture/tsc.h>
 #include <machine/ic.h>
 #include <machine/timer.h>
 #include <system/memory_map.h>
@@ -23,10 +24,15 @@ protected:
 
     static const unsigned int CHANNELS = 2;
     static const unsigned int FREQUENCY = Traits<Timer>::FREQUENCY;
+    static const unsigned int PERIOD = Traits<Timer>::CLOCK / FREQUENCY;    // in MTIME counts
+    static const Tick MAX_SLEEP = 0x7fffffff / PERIOD;                      // keeps MTIMECMP within the 32-bit window used by config()
+    static const unsigned int CPUS = Traits<Build>::CPUS;
+    static const bool dedicated = Traits<Timer>::quantum_comparator && (CPUS > 1);
 
 public:
     using Timer_Common::Tick;
     using Timer_Common::Handler;
+    typedef TSC_Common::Time_Stamp Time_Stamp;
 
     // Channels
     enum {
@@ -35,6 +41,8 @@ public:
     };
 
     static const Hertz CLOCK = Traits<Timer>::CLOCK;
+    static const bool ONE_SHOT = true;
+    static const bool LOCAL = !dedicated; // see Alarm_Timer
 
 protected:
     Timer(unsigned int channel, const Hertz & frequency, const Handler & handler, bool retrigger = true)
@@ -46,7 +54,8 @@ protected:
         else
             db<Timer>(WRN) << "Timer not installed!"<< endl;
 
-        _current = _initial;
+        for(unsigned int i = 0; i < CPUS; i++)
+            _current[i] = _initial;
     }
 
 public:
@@ -56,18 +65,36 @@ public:
         _channels[_channel] = 0;
     }
 
-    Tick read() { return _current; }
+    // Each CPU counts its own ticks (every hart has its own MTIMECMP), but only CPU 0 serves the ALARM channel (unless
+    // it is local), one-shots and tickless sleeps. With Traits<Timer>::quantum_comparator, the other CPUs don't tick at all: the
+    // SCHEDULER channel owns their MTIMECMP, which is set to the end of the running time slice by each restart()
+    Tick read() { return owner() ? remaining() : _current[cpu()]; }
 
     int restart() {
-        db<Timer>(TRC) << "Timer::restart() => {f=" << frequency() << ",h=" << reinterpret_cast<void *>(_handler) << ",count=" << _current << "}" << endl;
+        db<Timer>(TRC) << "Timer::restart() => {f=" << frequency() << ",h=" << reinterpret_cast<void *>(_handler) << ",count=" << read() << "}" << endl;
 
-        int percentage = _current * 100 / _initial;
-        _current = _initial;
+        int percentage = read() * 100 / _initial;
+        _current[cpu()] = _initial;
+        if(owner())
+            slice(_initial);
 
         return percentage;
     }
 
-    static void reset() { config(FREQUENCY); }
+    static void reset() {
+        if(cpu() != 0) {
+            if(dedicated && _channels[SCHEDULER])
+                slice(_channels[SCHEDULER]->_initial); // a new slice, unless the handler restarts one of its own
+            else
+                config(FREQUENCY);
+        }
+        else if(_armed)
+            rearm();
+        else {
+            _off_tick = false;
+            config(FREQUENCY);
+        }
+    }
     static void enable() {}
     static void disable() {}
 
@@ -76,25 +103,65 @@ public:
 
     void handler(const Handler & handler) { _handler = handler; }
 
+    // Tickless operation: suppress the periodic interrupt for the next "ticks" periods. The first interrupt of any kind
+    // afterwards (see IC::dispatch()) accounts for the periods that actually elapsed and reports them through skipped()
+    static void sleep(const Tick & ticks);
+    static bool sleeping() { return (cpu() == 0) && _sleeping; }
+    static Tick skipped() { return _skipped; }
+
+    // One-shot operation: besides the periodic ticks, interrupt once when MTIME (i.e. TSC::time_stamp()) reaches "deadline"
+    // and call "handler" before the channels. A new deadline replaces the previous one, which is never reported.
+    // Deadlines must lie within 2^31 counts of now and the interrupt doesn't count as a tick (see rearm())
+    static void one_shot(const Time_Stamp & deadline, const Handler & handler);
+
+    // MTIME counts since MTIMECMP was reached, i.e. how late the interrupt is being served if called before reset()
+    static Time_Stamp late() { return static_cast<CPU::Reg32>(reg(MTIME) - mtimecmp()); }
+
 private:
+    static Tick wakeup();
+    static void rearm();
+
     static volatile CPU::Reg32 & reg(unsigned int o) { return reinterpret_cast<volatile CPU::Reg32 *>(Memory_Map::CLINT_BASE)[o / sizeof(CPU::Reg32)]; }
+    static volatile CPU::Reg32 & mtimecmp() { return reg(MTIMECMP + cpu() * MTIMECMP_CORE_OFFSET); }
 
     static void config(const Hertz & frequency) {
-        reg(MTIMECMP) = reg(MTIME) + (CLOCK / frequency);
+        mtimecmp() = reg(MTIME) + (CLOCK / frequency);
     }
 
     static void int_handler(Interrupt_Id i);
 
     static void init();
 
+protected:
+    static unsigned int cpu() { return (CPUS > 1) ? CPU::id() : 0; }
+
+    bool owner() const { return dedicated && (_channel == SCHEDULER) && (cpu() != 0); }
+
+    // Programs this hart's MTIMECMP to the end of a time slice of "ticks" periods and tells how many are left of it
+    static void slice(const Tick & ticks) { mtimecmp() = reg(MTIME) + ((ticks > MAX_SLEEP) ? MAX_SLEEP : ticks) * PERIOD; }
+    static Tick remaining() {
+        int counts = mtimecmp() - reg(MTIME);
+        return (counts > 0) ? counts / PERIOD : 0;
+    }
+
 protected:
     unsigned int _channel;
     Tick _initial;
     bool _retrigger;
-    volatile Tick _current;
+    volatile Tick _current[CPUS];
     Handler _handler;
 
     static Timer * _channels[CHANNELS];
+    static volatile bool _sleeping;
+    static CPU::Reg32 _sleep;
+    static Tick _skipped;
+    static volatile bool _armed;
+    static bool _expired;
+    static bool _off_tick;
+    static CPU::Reg32 _deadline;
+    static CPU::Reg32 _tick;
+    static Handler _one_shot;
+    static bool _local;
 };
 
 // Timer used by Thread::Scheduler
@@ -102,13 +169,28 @@ class Scheduler_Timer: public Timer
 {
 public:
     Scheduler_Timer(const Microsecond & quantum, const Handler & handler): Timer(SCHEDULER, 1000000 / quantum, handler) {}
+
+    using Timer::restart;
+
+    // Starts a slice of "quantum" instead of the one given at construction (see Criterion::quantum())
+    int restart(const Microsecond & quantum) {
+        int percentage = restart();
+        Tick ticks = static_cast<unsigned long long>(quantum) * FREQUENCY / 1000000;
+        if(!ticks)
+            ticks = 1;
+        _current[cpu()] = ticks;
+        if(owner())
+            slice(ticks);
+        return percentage;
+    }
 };
 
 // Timer used by Alarm
 class Alarm_Timer: public Timer
 {
 public:
-    Alarm_Timer(const Handler & handler): Timer(ALARM, FREQUENCY, handler) {}
+    // A local Alarm_Timer is served by every CPU, for each one's own alarms, instead of only by CPU 0
+    Alarm_Timer(const Handler & handler, bool local = false): Timer(ALARM, FREQUENCY, handler) { _local = local && LOCAL; }
 };
 
 __END_SYS
@@ -4,11 +4,15 @@
 #define __riscv_uart_h
 
 #include <architecture/cpu.h>
+#include <machine/ic.h>
 #include <machine/uart.h>
 #include <system/memory_map.h>
+#include <utility/buffer.h>
 
 __BEGIN_SYS
 
+class Semaphore;
+
 class SiFive_UART
 {
 private:
@@ -18,6 +22,7 @@ private:
 public:
     static const unsigned int UNITS = Traits<UART>::UNITS;
     static const unsigned int CLOCK = Traits<UART>::CLOCK;
+    static const unsigned int FIFO_SIZE = 8;
 
     // UART registers offsets from UART_BASE
     enum {
@@ -51,8 +56,8 @@ public:
     }
 
     void config(unsigned int baud_rate, unsigned int data_bits, unsigned int parity, unsigned int stop_bits) {
-        reg(TXCTRL) = 1 << 16 | stop_bits | TXEN; // TXCNT = 1, STOP = (stop_bits - 1) << 1
-        reg(RXCTRL) = 1 << 16 | RXEN; // RXCNT = 1
+        reg(TXCTRL) = 1 << 16 | stop_bits | TXEN; // TXCNT = 1 (TXWM when the FIFO is empty), STOP = (stop_bits - 1) << 1
+        reg(RXCTRL) = ((Traits<UART>::RX_WATERMARK - 1) & 7) << 16 | RXEN; // RXWM when the FIFO holds RX_WATERMARK bytes
         reg(DIV) = ((Traits<UART>::CLOCK / baud_rate) - 1) & 0xffff;
     }
 
@@ -73,8 +78,11 @@ public:
     }
     bool txd_ok() { return !(reg(TXDATA) & FULL); }
 
+    // Bytes that can be written to TXDATA without checking txd_ok() in between
+    unsigned int txd_burst() { return txd_ok() ? 1 : 0; }
+
     void int_enable(bool receive = true, bool transmit = true, bool line = true, bool modem = true) {
-         reg(IE) = (receive << 1) | transmit;
+         reg(IE) = reg(IE) | (receive << 1) | transmit;
     }
     void int_disable(bool receive = true, bool transmit = true, bool line = true, bool modem = true) {
          reg(IE) = reg(IE) & ~((receive << 1) | transmit);
@@ -98,6 +106,9 @@ private:
     static const unsigned int UNITS = Traits<UART>::UNITS;
     static const unsigned int CLOCK = Traits<UART>::CLOCK / 16; // reference clock is pre-divided by 16
 
+public:
+    static const unsigned int FIFO_SIZE = 16;
+
 public:
     // UART registers offsets from UART_BASE
     enum {
@@ -158,8 +169,10 @@ public:
 
         reg(LCR) = lcr;
 
-        // Enables Tx and Rx FIFOs, clear them, set trigger to 14 bytes
-        reg(FCR) = 0xc7;
+        // Enables Tx and Rx FIFOs, clear them, set the RX trigger to the largest level (1, 4, 8 or 14 bytes) up to
+        // RX_WATERMARK (bytes below it still raise the character timeout interrupt)
+        const unsigned int wm = Traits<UART>::RX_WATERMARK;
+        reg(FCR) = ((wm >= 14) ? 3 : (wm >= 8) ? 2 : (wm >= 4) ? 1 : 0) << 6 | 0x07;
 
         // Set DTR, RTS and OUT2 of MCR
         reg(MCR) = reg(MCR) | 0x0b;
@@ -184,8 +197,11 @@ public:
     bool rxd_ok() { return (reg(LSR) & DATA_READY); }
     bool txd_ok() {  return (reg(LSR) & THOLD_REG); }
 
+    // THRE means the whole TX FIFO is empty
+    unsigned int txd_burst() { return txd_ok() ? FIFO_SIZE : 0; }
+
     void int_enable(bool receive = true, bool transmit = true, bool line = true, bool modem = true) {
-        reg(IER) = receive | (transmit << 1) | (line << 2) | (modem << 3);
+        reg(IER) = reg(IER) | receive | (transmit << 1) | (line << 2) | (modem << 3);
     }
     void int_disable(bool receive = true, bool transmit = true, bool line = true, bool modem = true) {
         reg(IER) = reg(IER) & ~(receive | (transmit << 1) | (line << 2) | (modem << 3));
@@ -213,8 +229,17 @@ private:
     static volatile CPU::Reg8 & reg(unsigned int o) { return reinterpret_cast<volatile CPU::Reg8 *>(Memory_Map::UART0_BASE)[o / sizeof(CPU::Reg8)]; }
 };
 
+// UART
+// get() and put() poll the engine. With a Traits<UART>::BUFFER_SIZE, read() and write() go through an RX and a TX ring
+// instead, which int_handler() moves to and from the FIFOs, and sleep on a Semaphore only when there is nothing to
+// read or no room to write. A reader is woken once the RX ring holds all it still needs (or half of the ring) and a
+// writer once the TX ring has drained to half, so neither is woken for every byte. Each ring has a single producer
+// and a single consumer, so there should be a single reading and a single writing thread. On SiFive, bytes below
+// RX_WATERMARK raise no interrupt and only reach the ring with the next interrupt or read() (NS16550 has a timeout).
 class UART: private UART_Common, private IF<(Traits<Build>::MODEL == Traits<Build>::SiFive_U) && (Traits<CPU>::WORD_SIZE != 64), NS16500A, SiFive_UART>::Result
 {
+    friend class Machine;
+
 private:
     static const unsigned int UNIT = Traits<UART>::DEF_UNIT;
     static const unsigned int BAUD_RATE = Traits<UART>::DEF_BAUD_RATE;
@@ -224,6 +249,11 @@ private:
 
     typedef IF<(Traits<Build>::MODEL == Traits<Build>::SiFive_U) && (Traits<CPU>::WORD_SIZE != 64), NS16500A, SiFive_UART>::Result Engine;
 
+    static const unsigned int BUFFER_SIZE = Traits<UART>::BUFFER_SIZE;
+    static const bool buffered = (BUFFER_SIZE != 0);
+
+    typedef SPSC_Circular_Buffer<char, buffered ? BUFFER_SIZE : 1> Ring;
+
 public:
     using UART_Common::NONE;
     using UART_Common::EVEN;
@@ -231,7 +261,13 @@ public:
 
 public:
     UART(unsigned int unit = UNIT, unsigned int baud_rate = BAUD_RATE, unsigned int data_bits = DATA_BITS, unsigned int parity = PARITY, unsigned int stop_bits = STOP_BITS)
-    : Engine(unit, baud_rate, data_bits, parity, stop_bits) {}
+    : Engine(unit, baud_rate, data_bits, parity, stop_bits) {
+        // All units share the registers, so the rings are served through the first one created
+        if(buffered && !_device) {
+            _device = this;
+            int_enable(true, false, false, false);
+        }
+    }
 
     using Engine::config;
 
@@ -239,14 +275,20 @@ public:
     void put(char c) { while(!txd_ok()); txd(c); }
 
     int read(char * data, unsigned int max_size) {
+        if(buffered)
+            return receive(data, max_size);
+
         for(unsigned int i = 0; i < max_size; i++)
             data[i] = get();
-        return 0;
+        return max_size;
     }
     int write(const char * data, unsigned int size) {
+        if(buffered)
+            return send(data, size);
+
         for(unsigned int i = 0; i < size; i++)
             put(data[i]);
-        return 0;
+        return size;
     }
 
     bool ready_to_get() { return rxd_ok(); }
@@ -257,6 +299,29 @@ public:
     using Engine::flush;
 
     void power(const Power_Mode & mode);
+
+    static void int_handler(IC::Interrupt_Id i);
+
+private:
+    static void init();
+
+    int receive(char * data, unsigned int size);
+    int send(const char * data, unsigned int size);
+
+    static void serve();
+    static bool lock();
+    static void unlock(bool ie);
+
+private:
+    static UART * _device;
+    static Ring _rx;
+    static Ring _tx;
+    static volatile unsigned int _rx_wanted;
+    static volatile int _rx_waiting;
+    static volatile int _tx_waiting;
+    static volatile int _lock;
+    static Semaphore _rx_semaphore;
+    static Semaphore _tx_semaphore;
 };
 
 __END_SYS
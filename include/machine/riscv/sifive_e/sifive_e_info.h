@@ -11,6 +11,7 @@ struct System_Info: public System_Info_Common
 {
     Boot_Map bm;
     Library_Load_Map lm;
+    Boot_Profile bp;
 };
 
 __END_SYS
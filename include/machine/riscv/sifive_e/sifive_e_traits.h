@@ -44,6 +44,9 @@ public:
     static const unsigned int IO                = 0x00000000;                           // 0 (max 512 MB of IO = MIO_TOP - MIO_BASE)
     static const unsigned int SYS               = 0xff800000;                           // 4 GB - 8 MB
 
+    // CPUs (with consecutive ids) sharing a cache beyond L1 (single hart)
+    static const unsigned int CACHE_SHARING     = 1;
+
     // Default Sizes and Quantities
     static const unsigned int MAX_THREADS       = 7;
     static const unsigned int STACK_SIZE        = 640;
@@ -53,6 +56,18 @@ public:
 template <> struct Traits<IC>: public Traits<Machine_Common>
 {
     static const bool debugged = hysterically_debugged;
+    static const bool vectored = false; // mtvec in vectored mode, with a shortcut from the timer interrupt to its handler
+    static const bool nested = false;   // let the timer and PLIC sources of higher priority (1 to 7) preempt handlers
+
+    // Per-CPU interrupt stack (0 keeps handlers on the interrupted thread's stack, which must then have room for them)
+    static const unsigned int STACK_SIZE = 0;
+    static const bool deferred = false; // without STACK_SIZE, still leave the reschedules of handlers to the outermost one's exit
+
+    // PLIC
+    static const unsigned int PLIC_IRQS = 53;       // sources, including the reserved 0
+    static const unsigned int PLIC_CONTEXT_1 = 1;   // there is a single hart
+    static const unsigned int UART0_IRQ = 3;
+    static constexpr unsigned int priority(unsigned int irq) { return 1; } // per source, 1 (lowest) to 7
 };
 
 template <> struct Traits<Timer>: public Traits<Machine_Common>
@@ -66,6 +81,8 @@ template <> struct Traits<Timer>: public Traits<Machine_Common>
     // choice must respect the scheduler time-slice, i. e., it must be higher
     // than the scheduler invocation frequency.
     static const int FREQUENCY = 1000; // Hz
+
+    static const bool quantum_comparator = false; // harts other than 0 set their MTIMECMP to the end of the time slice instead of ticking
 };
 
 template <> struct Traits<UART>: public Traits<Machine_Common>
@@ -79,6 +96,9 @@ template <> struct Traits<UART>: public Traits<Machine_Common>
     static const unsigned int DEF_DATA_BITS = 8;
     static const unsigned int DEF_PARITY = 0; // none
     static const unsigned int DEF_STOP_BITS = 1;
+
+    static const unsigned int BUFFER_SIZE = 0;  // bytes in each of the RX and TX rings behind read() and write() (0 = polled)
+    static const unsigned int RX_WATERMARK = 1; // bytes in the RX FIFO that raise an interrupt
 };
 
 template<> struct Traits<Serial_Display>: public Traits<Machine_Common>
@@ -89,6 +109,7 @@ template<> struct Traits<Serial_Display>: public Traits<Machine_Common>
     static const int COLUMNS = 80;
     static const int LINES = 24;
     static const int TAB_SIZE = 8;
+    static const unsigned int BUFFER_SIZE = 0; // bytes waiting for the engine (0 = synchronous)
 };
 
 template<> struct Traits<Scratchpad>: public Traits<Machine_Common>
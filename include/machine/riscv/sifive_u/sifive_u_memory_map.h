@@ -21,7 +21,7 @@ public:
         RAM_TOP         = Traits<Machine>::RAM_TOP,
         MIO_BASE        = Traits<Machine>::MIO_BASE,
         MIO_TOP         = Traits<Machine>::MIO_TOP,
-        BOOT_STACK      = RAM_TOP + 1 - Traits<Machine>::STACK_SIZE, // will be used as the stack's base, not the stack pointer
+        BOOT_STACK      = RAM_TOP + 1 - Traits<Machine>::STACK_SIZE * Traits<Machine>::CPUS, // will be used as the stack's base, not the stack pointer; one STACK_SIZE per CPU
         FREE_BASE       = RAM_BASE,
         FREE_TOP        = BOOT_STACK,
 
@@ -42,6 +42,9 @@ public:
     static const unsigned int IO                = 0x00000000;                           // 0 (max 512 MB of IO = MIO_TOP - MIO_BASE)
     static const unsigned int SYS               = 0xff800000;                           // 4 GB - 8 MB
 
+    // CPUs (with consecutive ids) sharing a cache beyond L1 (all harts share the L2)
+    static const unsigned int CACHE_SHARING     = Traits<Build>::CPUS;
+
     // Default Sizes and Quantities
     static const unsigned int MAX_THREADS       = 16;
     static const unsigned int STACK_SIZE        = 64 * 1024;
@@ -51,6 +54,18 @@ public:
 template <> struct Traits<IC>: public Traits<Machine_Common>
 {
     static const bool debugged = hysterically_debugged;
+    static const bool vectored = false; // mtvec in vectored mode, with a shortcut from the timer interrupt to its handler
+    static const bool nested = false;   // let the timer and PLIC sources of higher priority (1 to 7) preempt handlers
+
+    // Per-CPU interrupt stack (0 keeps handlers on the interrupted thread's stack, which must then have room for them)
+    static const unsigned int STACK_SIZE = 0;
+    static const bool deferred = false; // without STACK_SIZE, still leave the reschedules of handlers to the outermost one's exit
+
+    // PLIC (RV32 runs on QEMU's Virt)
+    static const unsigned int PLIC_IRQS = (Traits<CPU>::WORD_SIZE != 64) ? 96 : 54;   // sources, including the reserved 0
+    static const unsigned int PLIC_CONTEXT_1 = (Traits<CPU>::WORD_SIZE != 64) ? 2 : 1; // machine-mode context of hart 1
+    static const unsigned int UART0_IRQ = (Traits<CPU>::WORD_SIZE != 64) ? 10 : 4;
+    static constexpr unsigned int priority(unsigned int irq) { return 1; } // per source, 1 (lowest) to 7
 };
 
 template <> struct Traits<Timer>: public Traits<Machine_Common>
@@ -64,6 +79,8 @@ template <> struct Traits<Timer>: public Traits<Machine_Common>
     // choice must respect the scheduler time-slice, i. e., it must be higher
     // than the scheduler invocation frequency.
     static const int FREQUENCY = 1000; // Hz
+
+    static const bool quantum_comparator = false; // harts other than 0 set their MTIMECMP to the end of the time slice instead of ticking
 };
 
 template <> struct Traits<OTP>: public Traits<Machine_Common>
@@ -77,6 +94,8 @@ template <> struct Traits<OTP>: public Traits<Machine_Common>
     static const unsigned int TCD_DELAY      = 40;    // Read data access delay
     static const unsigned int TKL_DELAY      = 10;    // Clock pulse low delay
     static const unsigned int TMS_DELAY      = 1;     // PTM mode setup delay
+
+    static const bool cached = false;                 // keep the fuses read in RAM (TOTAL_FUSES words)
 };
 
 template <> struct Traits<IO>: public Traits<Machine_Common> {};
@@ -92,6 +111,9 @@ template <> struct Traits<UART>: public Traits<Machine_Common>
     static const unsigned int DEF_DATA_BITS = 8;
     static const unsigned int DEF_PARITY = 0; // none
     static const unsigned int DEF_STOP_BITS = 1;
+
+    static const unsigned int BUFFER_SIZE = 0;  // bytes in each of the RX and TX rings behind read() and write() (0 = polled)
+    static const unsigned int RX_WATERMARK = 1; // bytes in the RX FIFO that raise an interrupt
 };
 
 template<> struct Traits<Serial_Display>: public Traits<Machine_Common>
@@ -102,6 +124,7 @@ template<> struct Traits<Serial_Display>: public Traits<Machine_Common>
     static const int COLUMNS = 80;
     static const int LINES = 24;
     static const int TAB_SIZE = 8;
+    static const unsigned int BUFFER_SIZE = 0; // bytes waiting for the engine (0 = synchronous)
 };
 
 template<> struct Traits<Scratchpad>: public Traits<Machine_Common>
@@ -9,16 +9,16 @@
 __BEGIN_SYS
 
 // TODO: This design is a bit weird, since this is not a Common package (it's a base indeed). It could be refactored to have an "Engine" or to just leave ::init() to be implemented by each Machine
+// Objects created with "new (SCRATCHPAD)" (e.g. hot lookup tables, data used by ISRs, and stacks of threads configured
+// with Thread::Configuration::scratchpad) come from the scratchpad heap. When the machine has no scratchpad, or it has
+// no room left, they come from the system heap instead, so the same code runs on every machine.
 class Scratchpad_Base
 {
-    friend void * ::operator new(size_t, const EPOS::Scratchpad_Allocator &);
-    friend void * ::operator new[](size_t, const EPOS::Scratchpad_Allocator &);
-
 protected:
     Scratchpad_Base() {}
 
 public:
-    static void * alloc(unsigned int bytes) { return _heap->alloc(bytes); }
+    static void * alloc(unsigned int bytes);
 
 protected:
     static Segment * _segment;
@@ -31,14 +31,5 @@ __END_SYS
 
 #if defined(__SCRATCHPAD_H) && !defined(__scratchpad_common_only__)
 #include __SCRATCHPAD_H
-
-inline void * operator new(size_t bytes, const EPOS::Scratchpad_Allocator & allocator) {
-    return _SYS::Scratchpad::_heap->alloc(bytes);
-}
-
-inline void * operator new[](size_t bytes, const EPOS::Scratchpad_Allocator & allocator) {
-    return _SYS::Scratchpad::_heap->alloc(bytes);
-}
-
 #endif
 
@@ -4,9 +4,13 @@
 #define __spi_h
 
 #include <system/config.h>
+#include <utility/handler.h>
+#include <utility/list.h>
 
 __BEGIN_SYS
 
+class SPI_Engine;
+
 class SPI_Common
 {
 public:
@@ -25,6 +29,34 @@ public:
         SLAVE_OD
     };
 
+    // A transfer of "size" items (of "data_bits" each) that shifts "tx" out (zeros if it is null) while shifting data
+    // in into "rx" (discarded if it is null). Transactions are queued in the engine with submit() and run in order;
+    // "handler" (e.g. a Semaphore_Handler) is called as each of them finishes, in interrupt context when the engine
+    // moves the data with DMA. A Transaction must not be touched until it is done().
+    class Transaction
+    {
+        friend class SPI_Engine;
+
+    public:
+        typedef Simple_List<Transaction> List;
+        typedef List::Element Element;
+
+    public:
+        Transaction(const void * tx, void * rx, unsigned int size, Handler * handler = 0)
+        : _tx(tx), _rx(rx), _size(size), _handler(handler), _offset(0), _done(false), _link(this) {}
+
+        bool done() const { return _done; }
+
+    private:
+        const void * _tx;
+        void * _rx;
+        unsigned int _size;
+        Handler * _handler;
+        unsigned int _offset;           // items already moved (DMA cycles are limited in length)
+        volatile bool _done;
+        Element _link;
+    };
+
 protected:
     SPI_Common() {}
 
@@ -39,6 +71,9 @@ public:
     int read(char * data, unsigned int max_size);
     int write(const char * data, unsigned int size);
 
+    void submit(Transaction * t, unsigned int n = 1);
+    void transfer(const void * tx, void * rx, unsigned int size);
+
     void flush();
     bool ready_to_get();
     bool ready_to_put();
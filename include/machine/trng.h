@@ -0,0 +1,26 @@
+// EPOS True Random Number Generator (TRNG) Mediator Common Package
+
+#ifndef __trng_h
+#define __trng_h
+
+#include <system/config.h>
+
+__BEGIN_SYS
+
+class TRNG_Common
+{
+protected:
+    TRNG_Common() {}
+
+public:
+    // 32 bits of entropy, waiting for the hardware to gather them
+    static unsigned int random();
+};
+
+__END_SYS
+
+#endif
+
+#if defined(__TRNG_H) && !defined(__trng_common_only__)
+#include __TRNG_H
+#endif
@@ -4,32 +4,52 @@
 #define __memory_h
 
 #include <architecture.h>
+#include <utility/slab.h>
+#include <utility/heap.h>
 
 __BEGIN_SYS
 
+// Each new Address_Space gets a cache color of its own (round-robin over the colors but WHITE, which is left to the
+// system), so the Segments a task creates with color() don't evict each other's lines from a physically indexed cache
 class Address_Space: private MMU::Directory
 {
+private:
+    static const unsigned int COLORS = (Traits<MMU>::colorful && (Traits<MMU>::COLORS > 1)) ? Traits<MMU>::COLORS - 1 : 0; // but WHITE
+
 public:
     typedef CPU::Phy_Addr Phy_Addr;
     typedef CPU::Log_Addr Log_Addr;
 
 public:
     Address_Space();
+    Address_Space(Color color);
     Address_Space(MMU::Page_Directory * pd);
     ~Address_Space();
 
     using MMU::Directory::pd;
 
+    void activate();
+
+    Color color() const { return _color; }
+
     Log_Addr attach(Segment * seg);
     Log_Addr attach(Segment * seg, Log_Addr addr);
     void detach(Segment * seg);
     void detach(Segment * seg, Log_Addr addr);
 
     Phy_Addr physical(Log_Addr address);
+
+private:
+    static Color next_color();
+
+private:
+    Color _color;
+
+    static unsigned int _next_color;
 };
 
 
-class Segment: public MMU::Chunk
+class Segment: public MMU::Chunk, public Slab_Allocated<Segment>
 {
 private:
     typedef MMU::Chunk Chunk;
@@ -39,8 +59,9 @@ public:
     typedef MMU::Flags Flags;
 
 public:
-    Segment(unsigned int bytes, Flags flags = Flags::APP);
+    Segment(unsigned int bytes, Flags flags = Flags::APP, Color color = WHITE);
     Segment(Phy_Addr phy_addr, unsigned int bytes, Flags flags);
+    Segment(const Segment & segment); // a clone, copy-on-write if the MMU supports it (see MMU::Chunk)
     ~Segment();
 
     unsigned int size() const;
@@ -48,6 +69,114 @@ public:
     int resize(int amount);
 };
 
+
+// Segment_Heap
+// A Heap in a Segment of its own, attached to the current Address_Space, whose size bounds whatever is allocated from
+// it: when it runs out, alloc() returns 0 instead of panicking, so a module that leaks starves only itself. Deleting
+// it gives the whole Segment back at once, whatever blocks are still taken. Its blocks can be freed with free() and
+// delete with Traits<System>::multiheap, so a group of threads can share one through new (heap) (see Task::heap()).
+// With "max" above "bytes", the Segment is resized instead of failing an allocation, in steps of the initial size, up
+// to "max" or to what its page tables map (the Segment stays attached, so they can't move). Once the top of the heap
+// has two steps free, all of it but one step goes back to the frame allocator, but never below the initial size.
+class Segment_Heap: public Heap
+{
+public:
+    Segment_Heap(unsigned int bytes, unsigned int max = 0);
+    ~Segment_Heap();
+
+    Segment * segment() const { return _segment; }
+
+private:
+    static bool resize(Heap * heap, unsigned long bytes);
+
+    bool grow(unsigned long bytes);
+    bool trim();
+
+private:
+    Segment * _segment;
+    MMU::Page_Directory * _pd;
+    CPU::Log_Addr _base;
+    unsigned long _step;
+    unsigned long _max;
+};
+
+
+// DMA_Pool
+// N buffers of SIZE bytes (rounded up to whole cache lines, so no two buffers share a line) cut from a single contiguous
+// DMA_Buffer allocated when the pool is created. Drivers get() and put() buffers (e.g. one per packet) from a stack of
+// free indexes and take their physical addresses with physical(), all in O(1) and without going through the MMU again.
+template<unsigned int N, unsigned int SIZE>
+class DMA_Pool
+{
+private:
+    static const unsigned int LINE = Traits<CPU>::CACHE_LINE_SIZE;
+    static const bool smp = Traits<System>::multicore;
+
+public:
+    typedef CPU::Reg Reg;
+    typedef CPU::Phy_Addr Phy_Addr;
+    typedef CPU::Log_Addr Log_Addr;
+    typedef MMU::DMA_Buffer DMA_Buffer;
+
+    static const unsigned int BUFFER_SIZE = (SIZE + LINE - 1) & ~(LINE - 1);
+
+public:
+    DMA_Pool(): _buffer(N * BUFFER_SIZE + LINE), _free(N) {
+        _base = (Reg(_buffer.log_address()) + LINE - 1) & ~Reg(LINE - 1);
+        for(unsigned int i = 0; i < N; i++)
+            _stack[i] = N - 1 - i; // buffer 0 on top
+        db<MMU>(TRC) << "DMA_Pool(n=" << N << ",s=" << BUFFER_SIZE << ",buffer=" << _buffer << ") => " << this << endl;
+    }
+
+    unsigned int available() const { return _free; }
+
+    // Returns a buffer, or 0 if all of them are in use
+    Log_Addr get() {
+        bool enabled = enter();
+        Log_Addr buf = _free ? buffer(_stack[--_free]) : Log_Addr(Reg(0));
+        leave(enabled);
+        return buf;
+    }
+
+    void put(Log_Addr buf) {
+        assert(contains(buf));
+        bool enabled = enter();
+        _stack[_free++] = index(buf);
+        leave(enabled);
+    }
+
+    bool contains(Log_Addr addr) const { return (Reg(addr) >= _base) && (Reg(addr) < _base + N * BUFFER_SIZE); }
+
+    Log_Addr buffer(unsigned int i) const { return _base + i * BUFFER_SIZE; }
+    unsigned int index(Log_Addr buf) const { return (Reg(buf) - _base) / BUFFER_SIZE; }
+
+    // The buffer is physically contiguous, so its physical address is just an offset from the DMA_Buffer's
+    Phy_Addr physical(Log_Addr addr) const { return Reg(_buffer.phy_address()) + (Reg(addr) - Reg(_buffer.log_address())); }
+
+private:
+    bool enter() {
+        bool enabled = CPU::int_enabled();
+        CPU::int_disable();
+        if(smp)
+            _lock.acquire();
+        return enabled;
+    }
+
+    void leave(bool enabled) {
+        if(smp)
+            _lock.release();
+        if(enabled)
+            CPU::int_enable();
+    }
+
+private:
+    DMA_Buffer _buffer;
+    Reg _base;
+    unsigned int _free;
+    unsigned int _stack[N];
+    Spin _lock;
+};
+
 __END_SYS
 
 #endif
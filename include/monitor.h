@@ -0,0 +1,221 @@
+// EPOS System Monitor Declarations
+
+#ifndef __monitor_h
+#define __monitor_h
+
+#include <architecture.h>
+#include <machine.h>
+#include <process.h>
+#include <time.h>
+
+__BEGIN_SYS
+
+// Clerks read a single metric each, on the CPU they are called on
+
+// PMU events, counted by a PMU channel of each CPU (see PMU_Event)
+template<>
+class Clerk<PMU>: public PMU_Event
+{
+public:
+    typedef PMU::Event Event;
+    typedef PMU::Count Data;
+
+public:
+    Clerk(PMU::Channel channel, const Event & event): _channel(channel), _event(event) {}
+
+    // Programs the channel of the calling CPU
+    void start() {
+        PMU::config(_channel, _event);
+        PMU::reset(_channel);
+        PMU::start(_channel);
+    }
+    void stop() { PMU::stop(_channel); }
+
+    Data read() { return PMU::read(_channel); }
+
+    const Event & event() const { return _event; }
+
+private:
+    PMU::Channel _channel;
+    Event _event;
+};
+
+// System events, taken from the scheduler's statistics (see System_Event and Traits<Thread>::collecting)
+template<>
+class Clerk<System>: public System_Event
+{
+private:
+    typedef Thread::Criterion::Statistics Statistics;
+
+public:
+    typedef unsigned int Event;
+    typedef unsigned long long Data;
+
+public:
+    Clerk(const Event & event): _event(event) {}
+
+    Data read();
+
+    const Event & event() const { return _event; }
+
+private:
+    Event _event;
+};
+
+// Transducer events of the machine itself (see Transducer_Event), e.g. CPU_TEMPERATURE in m°C (Machine::temperature())
+template<>
+class Clerk<Machine>: public Transducer_Event
+{
+public:
+    typedef unsigned int Event;
+    typedef int Data;
+
+public:
+    Clerk(const Event & event): _event(event) {}
+
+    Data read() { return (_event == CPU_TEMPERATURE) ? Machine::temperature() : 0; }
+
+    const Event & event() const { return _event; }
+
+private:
+    Event _event;
+};
+
+
+// Counts more PMU events than there are programmable channels by time-multiplexing them: the events are split in groups
+// of up to CHANNELS, which take turns on the channels (from PMU::FIXED on) every "slice", rotated by an Alarm. Each
+// count is then scaled by the time the whole set ran over the time its group was on the channels, so a full event set
+// (e.g. for a top-down analysis) comes out of a single run. The channels are those of the CPU serving the Alarm (and
+// the one start() and read() must be called on), so they must not be in use by the Monitor (Traits<Monitor>).
+class PMU_Multiplexer
+{
+private:
+    static const unsigned int PROGRAMMABLE = PMU::CHANNELS - PMU::FIXED;
+
+public:
+    static const unsigned int CHANNELS = PROGRAMMABLE ? PROGRAMMABLE : 1;
+    static const unsigned int EVENTS = 32;
+
+    typedef PMU::Event Event;
+    typedef PMU::Count Count;
+    typedef TSC::Time_Stamp Time_Stamp;
+
+public:
+    PMU_Multiplexer(const Event * events, unsigned int n, const Microsecond & slice);
+    ~PMU_Multiplexer() { stop(); }
+
+    void start();
+    void stop();
+
+    // Estimated count of the i-th event (at a precision of 1/1024 of the scaling ratio), its raw count and the time
+    // it was counted for, in TSC units
+    Count read(unsigned int i);
+    Count raw(unsigned int i) const { return _count[i]; }
+    Time_Stamp enabled(unsigned int i) const { return _enabled[i]; }
+
+    unsigned int events() const { return _events; }
+    unsigned int groups() const { return (_events + CHANNELS - 1) / CHANNELS; }
+    unsigned long rotations() const { return _rotations; }
+
+private:
+    unsigned int first(unsigned int group) const { return group * CHANNELS; }
+    unsigned int last(unsigned int group) const {
+        return (first(group) + CHANNELS < _events) ? first(group) + CHANNELS : _events;
+    }
+
+    void program(unsigned int group, const Time_Stamp & now);
+    void collect(const Time_Stamp & now);
+    void rotate();
+
+private:
+    Event _event[EVENTS];
+    unsigned int _events;
+    Microsecond _slice;
+    Alarm * _alarm;
+
+    bool _running;
+    unsigned int _group;                    // on the channels
+    Time_Stamp _since;                      // it went on
+    Time_Stamp _total;                      // of all rotations so far
+    unsigned long _rotations;
+
+    Count _count[EVENTS];
+    Time_Stamp _enabled[EVENTS];
+};
+
+
+// Captures the metrics selected in Traits<Monitor> on every CPU at FREQUENCY: an Alarm on CPU 0 captures its own and
+// sends the others an IPI (IPI::MONITOR) to capture theirs, each CPU into a ring of its own that keeps the last SAMPLES
+// Captures, for scheduling heuristics to look at (last()) or to be dumped for offline analysis (dump(), one line each)
+// The PMU events are counted by the first PMU_CHANNELS programmable channels (from PMU::FIXED on) of each CPU.
+class Monitor: public System_Event, public Transducer_Event
+{
+    friend class System;                            // for init()
+    friend class Init_System;                       // for init() on CPU != 0
+    friend class Clerk<System>;                     // for _deadline_misses
+    friend class Periodic_Thread;                   // for deadline_missed()
+
+private:
+    static const bool enabled = Traits<Monitor>::enabled;
+    static const unsigned int CPUS = Traits<Build>::CPUS;
+    static const unsigned int FREQUENCY = Traits<Monitor>::FREQUENCY;
+    static const unsigned int SAMPLES = enabled ? Traits<Monitor>::SAMPLES : 1;
+    static const bool thermal = Traits<Monitor>::temperature;
+
+    static const unsigned int PROGRAMMABLE = PMU::CHANNELS - PMU::FIXED;
+    static const unsigned int TRAITED = (Traits<Monitor>::PMU_CHANNELS < 4) ? Traits<Monitor>::PMU_CHANNELS : 4;
+
+public:
+    static const unsigned int PMU_CHANNELS = (TRAITED < PROGRAMMABLE) ? TRAITED : PROGRAMMABLE;
+
+    struct Capture {
+        TSC::Time_Stamp time;                       // ELAPSED_TIME
+        TSC::Time_Stamp cpu_time;                   // CPU_EXECUTION_TIME
+        TSC::Time_Stamp thread_time;                // THREAD_EXECUTION_TIME of RUNNING_THREAD, so far
+        const void * thread;                        // RUNNING_THREAD
+        unsigned int deadline_misses;               // DEADLINE_MISSES of Periodic_Threads on this CPU, so far
+        int temperature;                            // CPU_TEMPERATURE (m°C)
+        PMU::Count pmu[PMU_CHANNELS ? PMU_CHANNELS : 1];
+    };
+
+public:
+    // Captures so far and the most recent one (if any) of "cpu"
+    static unsigned int captures(unsigned int cpu) { return _head[cpu]; }
+    static const Capture & last(unsigned int cpu) { return _ring[cpu][(_head[cpu] + SAMPLES - 1) % SAMPLES]; }
+
+    static void dump();
+    static void reset();
+
+private:
+    static void capture();
+    static void alarm();
+    static void interrupt(IC::Interrupt_Id i) { capture(); }
+
+    // PMU event counted by the i-th channel (from PMU::FIXED on)
+    static PMU::Event event(unsigned int i) {
+        switch(i) {
+        case 0: return Traits<Monitor>::PMU_EVENT0;
+        case 1: return Traits<Monitor>::PMU_EVENT1;
+        case 2: return Traits<Monitor>::PMU_EVENT2;
+        default: return Traits<Monitor>::PMU_EVENT3;
+        }
+    }
+    static Clerk<PMU> clerk(unsigned int i) { return Clerk<PMU>(PMU::FIXED + i, event(i)); }
+
+    static void deadline_missed() {
+        if(enabled)
+            _deadline_misses[(CPUS > 1) ? CPU::id() : 0]++;
+    }
+
+    static void init();
+
+private:
+    static volatile unsigned int _deadline_misses[CPUS];
+    static unsigned int _head[CPUS];
+    static Capture _ring[CPUS][SAMPLES];
+    static Alarm * _alarm;
+};
+
+__END_SYS
+
+#endif
@@ -0,0 +1,183 @@
+// EPOS ARP Protocol Declarations
+
+#ifndef __arp_h
+#define __arp_h
+
+#include <synchronizer.h>
+
+__BEGIN_SYS
+
+// Address Resolution Protocol (RFC 826) for a Network (e.g. IP) over a NIC (e.g. NIC<Ethernet>), HTYPE being the
+// hardware type of the NIC (1 for Ethernet). Bindings are kept in a small table replaced round-robin, learned from
+// every request and reply that mention the Network's address, and never expire.
+template<typename NIC, typename Network, unsigned int HTYPE>
+class ARP: private NIC::Observer
+{
+public:
+    typedef typename NIC::Address MAC;
+    typedef typename Network::Address Address;
+    typedef typename NIC::Buffer Buffer;
+    typedef typename NIC::Protocol Protocol;
+    typedef typename NIC::Observer::Observed Observed;
+
+    static const unsigned int ENTRIES = Traits<Network>::ARP_ENTRIES;
+    static const unsigned int RETRIES = Traits<Network>::ARP_RETRIES;
+    static const unsigned int TIMEOUT = Traits<Network>::ARP_TIMEOUT; // us
+
+    // Operations
+    enum {
+        REQUEST = 1,
+        REPLY   = 2
+    };
+
+    class Packet
+    {
+    public:
+        Packet(unsigned short op, const MAC & sha, const Address & spa, const MAC & tha, const Address & tpa)
+        : _htype(htons(HTYPE)), _ptype(htons(Network::PROTOCOL)), _hlen(sizeof(MAC)), _plen(sizeof(Address)),
+          _oper(htons(op)), _sha(sha), _spa(spa), _tha(tha), _tpa(tpa) {}
+
+        bool valid() const {
+            return (ntohs(_htype) == HTYPE) && (ntohs(_ptype) == Network::PROTOCOL) && (_hlen == sizeof(MAC)) && (_plen == sizeof(Address));
+        }
+
+        unsigned short op() const { return ntohs(_oper); }
+        const MAC & sha() const { return _sha; }
+        const Address & spa() const { return _spa; }
+        const MAC & tha() const { return _tha; }
+        const Address & tpa() const { return _tpa; }
+
+        friend OStream & operator<<(OStream & os, const Packet & p) {
+            os << "{op=" << p.op() << ",sha=" << p._sha << ",spa=" << p._spa << ",tha=" << p._tha << ",tpa=" << p._tpa << "}";
+            return os;
+        }
+
+    private:
+        unsigned short _htype;
+        unsigned short _ptype;
+        unsigned char _hlen;
+        unsigned char _plen;
+        unsigned short _oper;
+        MAC _sha;
+        Address _spa;
+        MAC _tha;
+        Address _tpa;
+    } __attribute__((packed));
+
+public:
+    ARP(NIC * nic, Network * net): _nic(nic), _net(net), _next(0), _replied(0) {
+        db<ARP>(TRC) << "ARP(nic=" << nic << ",net=" << net << ") => " << this << endl;
+
+        for(unsigned int i = 0; i < ENTRIES; i++)
+            _table[i].ip = Address(static_cast<unsigned char>(0));
+
+        _nic->attach(this, NIC::PROTO_ARP);
+    }
+
+    ~ARP() {
+        db<ARP>(TRC) << "~ARP(this=" << this << ")" << endl;
+
+        _nic->detach(this, NIC::PROTO_ARP);
+    }
+
+    // Returns the MAC bound to "a", asking for it if needed (and blocking for up to RETRIES * TIMEOUT), or a null MAC
+    MAC resolve(const Address & a) {
+        db<ARP>(TRC) << "ARP::resolve(a=" << a << ")" << endl;
+
+        MAC mac(static_cast<unsigned char>(0));
+        if(!a)
+            return mac;
+
+        for(unsigned int i = 0; (i <= RETRIES) && !lookup(a, &mac); i++) {
+            if(i == RETRIES) {
+                db<ARP>(WRN) << "ARP::resolve: " << a << " did not answer!" << endl;
+                return MAC(static_cast<unsigned char>(0));
+            }
+            while(_replied.try_p()); // replies to previous requests
+            send(REQUEST, MAC(static_cast<unsigned char>(0)), a, MAC::broadcast());
+            _replied.p(TIMEOUT);
+        }
+
+        db<ARP>(INF) << "ARP::resolve(a=" << a << ") => " << mac << endl;
+
+        return mac;
+    }
+
+    void insert(const Address & a, const MAC & mac) {
+        bool ie = CPU::int_enabled();
+        CPU::int_disable();
+
+        unsigned int i = 0;
+        for(; (i < ENTRIES) && !(_table[i].ip == a); i++);
+        if(i == ENTRIES) {
+            i = _next;
+            _next = (_next + 1) % ENTRIES;
+        }
+        _table[i].ip = a;
+        _table[i].mac = mac;
+
+        if(ie)
+            CPU::int_enable();
+    }
+
+private:
+    bool lookup(const Address & a, MAC * mac) {
+        bool ie = CPU::int_enabled();
+        CPU::int_disable();
+
+        bool found = false;
+        for(unsigned int i = 0; (i < ENTRIES) && !found; i++)
+            if(_table[i].ip == a) {
+                *mac = _table[i].mac;
+                found = true;
+            }
+
+        if(ie)
+            CPU::int_enable();
+
+        return found;
+    }
+
+    void send(unsigned short op, const MAC & tha, const Address & tpa, const MAC & dst) {
+        Buffer * buf = _nic->alloc(dst, NIC::PROTO_ARP, sizeof(Packet));
+        if(!buf)
+            return;
+        new (buf->frame()->template data<Packet>()) Packet(op, _nic->address(), _net->address(), tha, tpa);
+        _nic->send(buf);
+    }
+
+    // Runs in interrupt context, or in the NIC's polling thread
+    void update(Observed * o, const Protocol & p, Buffer * buf) {
+        const Packet * packet = buf->frame()->template data<Packet>();
+
+        if((buf->size() >= sizeof(Packet)) && packet->valid()) {
+            db<ARP>(TRC) << "ARP::update(p=" << *packet << ")" << endl;
+
+            if(packet->tpa() == _net->address()) {
+                insert(packet->spa(), packet->sha());
+                if(packet->op() == REQUEST)
+                    send(REPLY, packet->sha(), packet->spa(), packet->sha());
+                else if(packet->op() == REPLY)
+                    _replied.v();
+            }
+        }
+
+        _nic->free(buf);
+    }
+
+private:
+    struct Entry {
+        Address ip;
+        MAC mac;
+    };
+
+    NIC * _nic;
+    Network * _net;
+    Entry _table[ENTRIES];
+    unsigned int _next;
+    Semaphore _replied;
+};
+
+__END_SYS
+
+#endif
@@ -0,0 +1,89 @@
+// EPOS Ethernet Family Declarations
+
+#ifndef __ethernet_h
+#define __ethernet_h
+
+#include <architecture/cpu.h>
+#define __nic_common_only__
+#include <machine/nic.h>
+#undef __nic_common_only__
+
+__BEGIN_SYS
+
+class Ethernet: public NIC_Common
+{
+public:
+    static const unsigned int MTU = 1500;
+    static const unsigned int HEADER_SIZE = 14;
+    static const unsigned int MIN_FRAME = 60; // without the CRC, shorter frames are padded by the NIC
+
+    typedef NIC_Common::Address<6> Address;
+    typedef NIC_Common::Protocol Protocol;
+    typedef unsigned char Data[MTU];
+    typedef unsigned int CRC;
+
+    // EtherTypes
+    enum {
+        PROTO_IP        = 0x0800,
+        PROTO_ARP       = 0x0806,
+        PROTO_RARP      = 0x8035,
+        PROTO_IPV6      = 0x86dd
+    };
+
+    // The header is kept in network byte order, as it goes on the wire
+    class Header
+    {
+    public:
+        Header() {}
+        Header(const Address & src, const Address & dst, const Protocol & prot): _dst(dst), _src(src), _prot(htons(prot)) {}
+
+        const Address & src() const { return _src; }
+        const Address & dst() const { return _dst; }
+        Protocol prot() const { return ntohs(_prot); }
+
+        friend OStream & operator<<(OStream & os, const Header & h) {
+            os << "{dst=" << h._dst << ",src=" << h._src << ",prot=" << hex << h.prot() << dec << "}";
+            return os;
+        }
+
+    protected:
+        Address _dst;
+        Address _src;
+        Protocol _prot;
+    } __attribute__((packed));
+
+    class Frame: public Header
+    {
+    public:
+        Frame() {}
+        Frame(const Address & src, const Address & dst, const Protocol & prot): Header(src, dst, prot) {}
+
+        Header * header() { return this; }
+
+        template<typename T>
+        T * data() { return reinterpret_cast<T *>(&_data); }
+
+    protected:
+        Data _data;
+        CRC _crc;
+    } __attribute__((packed));
+
+    // Buffers hold whole frames and their sizes are those of the payloads
+    typedef _UTIL::Buffer<NIC<Ethernet>, Frame> Buffer;
+    typedef Data_Observer<Buffer, Protocol> Observer;
+    typedef Indexed_Data_Observed<Buffer, Protocol, 8> Observed;
+
+    struct Statistics: public NIC_Common::Statistics
+    {
+        Statistics(): collisions(0) {}
+
+        unsigned int collisions;
+    };
+
+protected:
+    Ethernet() {}
+};
+
+__END_SYS
+
+#endif
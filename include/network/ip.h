@@ -0,0 +1,186 @@
+// EPOS IP Protocol Declarations
+
+#ifndef __ip_h
+#define __ip_h
+
+#include <machine/nic.h>
+#include <network/ethernet.h>
+#include <network/arp.h>
+
+__BEGIN_SYS
+
+// Internet Protocol version 4 (RFC 791) over the first Ethernet NIC, statically configured through Traits<IP>
+// Datagrams move across the stack in the Buffers of the NIC (see NIC), with the IP header right after the Ethernet one
+// and the payload after it. Received datagrams are handed up to the protocol attached (as an observer) to their
+// protocol number, which must free() them once it is done. Fragments and options are not supported: fragments are
+// dropped, options are skipped, and datagrams are sent with DF set, so payloads are limited to MTU.
+class IP: private Ethernet::Observer, public Data_Observed<Ethernet::Buffer, unsigned char>
+{
+public:
+    static const unsigned int PROTOCOL = Ethernet::PROTO_IP;
+    static const unsigned int TTL = Traits<IP>::TTL;
+
+    typedef NIC<Ethernet> Interface;
+    typedef Ethernet::Buffer Buffer;
+    typedef unsigned char Protocol;
+    typedef Data_Observer<Buffer, Protocol> Observer;
+    typedef Data_Observed<Buffer, Protocol> Observed;
+
+    // Protocol numbers
+    enum {
+        PROTO_ICMP      = 0x01,
+        PROTO_TCP       = 0x06,
+        PROTO_UDP       = 0x11
+    };
+
+    class Address: public NIC_Common::Address<4>
+    {
+    public:
+        Address() {}
+        Address(unsigned char a): NIC_Common::Address<4>(a) {}
+        Address(unsigned char a0, unsigned char a1, unsigned char a2, unsigned char a3) {
+            (*this)[0] = a0;
+            (*this)[1] = a1;
+            (*this)[2] = a2;
+            (*this)[3] = a3;
+        }
+        Address(unsigned long a) { // as in 0x0a000201 for 10.0.2.1
+            for(unsigned int i = 0; i < 4; i++)
+                (*this)[i] = a >> (24 - i * 8);
+        }
+
+        Address operator&(const Address & a) const {
+            Address r;
+            for(unsigned int i = 0; i < 4; i++)
+                r[i] = (*this)[i] & a[i];
+            return r;
+        }
+        Address operator|(const Address & a) const {
+            Address r;
+            for(unsigned int i = 0; i < 4; i++)
+                r[i] = (*this)[i] | a[i];
+            return r;
+        }
+        Address operator~() const {
+            Address r;
+            for(unsigned int i = 0; i < 4; i++)
+                r[i] = ~(*this)[i];
+            return r;
+        }
+
+        friend OStream & operator<<(OStream & os, const Address & a) {
+            os << a[0] << "." << a[1] << "." << a[2] << "." << a[3];
+            return os;
+        }
+    } __attribute__((packed));
+
+    class Header
+    {
+    public:
+        enum {
+            DF          = 0x4000,   // Don't fragment
+            MF          = 0x2000,   // More fragments
+            OFFSET      = 0x1fff
+        };
+
+    public:
+        Header() {}
+        Header(const Address & from, const Address & to, const Protocol & prot, unsigned int size, unsigned short id)
+        : _vhl(0x45), _tos(0), _length(htons(sizeof(Header) + size)), _id(htons(id)), _offset(htons(DF)), _ttl(TTL),
+          _protocol(prot), _checksum(0), _from(from), _to(to) {}
+
+        unsigned int version() const { return _vhl >> 4; }
+        unsigned int hlength() const { return (_vhl & 0x0f) * 4; }
+        unsigned int length() const { return ntohs(_length); }
+        unsigned short id() const { return ntohs(_id); }
+        bool fragmented() const { return ntohs(_offset) & (MF | OFFSET); }
+        unsigned char ttl() const { return _ttl; }
+        const Protocol & protocol() const { return _protocol; }
+        const Address & from() const { return _from; }
+        const Address & to() const { return _to; }
+
+        void sum() { _checksum = 0; _checksum = IP::checksum(this, hlength()); }
+        bool check() const { return IP::checksum(this, hlength()) == 0; }
+
+        template<typename T>
+        T * data() { return reinterpret_cast<T *>(reinterpret_cast<unsigned char *>(this) + hlength()); }
+
+        friend OStream & operator<<(OStream & os, const Header & h) {
+            os << "{v=" << h.version() << ",hl=" << h.hlength() << ",len=" << h.length() << ",id=" << h.id()
+               << ",ttl=" << h._ttl << ",p=" << h._protocol << ",from=" << h._from << ",to=" << h._to << "}";
+            return os;
+        }
+
+    private:
+        unsigned char _vhl;         // version and header length (in 32-bit words)
+        unsigned char _tos;
+        unsigned short _length;
+        unsigned short _id;
+        unsigned short _offset;     // flags and fragment offset
+        unsigned char _ttl;
+        Protocol _protocol;
+        unsigned short _checksum;
+        Address _from;
+        Address _to;
+    } __attribute__((packed));
+
+    static const unsigned int MTU = Ethernet::MTU - sizeof(Header);
+
+    typedef _SYS::ARP<Interface, IP, 1> ARP;
+
+protected:
+    IP(Interface * nic);
+
+public:
+    ~IP();
+
+    // Returns the IP bound to the first NIC, creating it on the first call (NICs can only be observed once threads exist)
+    static IP * get();
+
+    // Allocates a Buffer for a datagram of "payload" bytes to "to", with the Ethernet and IP headers already filled.
+    // The payload starts at header(buf)->data<T>(). Returns 0 if the next hop can't be resolved or the NIC is busy.
+    Buffer * alloc(const Address & to, const Protocol & prot, unsigned int payload);
+    int send(Buffer * buf);
+    void free(Buffer * buf) { buf->nic()->free(buf); }
+
+    static Header * header(Buffer * buf) { return buf->frame()->data<Header>(); }
+
+    Interface * nic() const { return _nic; }
+    const Address & address() const { return _address; }
+    const Address & netmask() const { return _netmask; }
+    const Address & gateway() const { return _gateway; }
+    const Address & broadcast() const { return _broadcast; }
+
+    // Offloads of the NIC (see NIC_Common::Offload), for the protocols above to skip their own checksums
+    unsigned int offloads() const { return _offloads; }
+
+    // Internet checksum (RFC 1071): sum() accumulates 16-bit words in memory order (so any partial sums, such as that
+    // of a pseudo header, can be added up before folding) and checksum() folds and complements the result. Both are
+    // independent of the byte order, so the checksum can be stored as it is.
+    static unsigned int sum(const void * data, unsigned int size, unsigned int partial = 0);
+    static unsigned short checksum(const void * data, unsigned int size, unsigned int partial = 0) {
+        unsigned int s = sum(data, size, partial);
+        while(s >> 16)
+            s = (s & 0xffff) + (s >> 16);
+        return ~s;
+    }
+
+private:
+    void update(Ethernet::Observer::Observed * o, const Ethernet::Protocol & p, Buffer * buf);
+
+private:
+    Interface * _nic;
+    ARP * _arp;
+    Address _address;
+    Address _netmask;
+    Address _gateway;
+    Address _broadcast;
+    unsigned int _offloads;
+    volatile unsigned int _id;
+
+    static IP * _ip;
+};
+
+__END_SYS
+
+#endif
@@ -0,0 +1,142 @@
+// EPOS UDP Protocol Declarations
+
+#ifndef __udp_h
+#define __udp_h
+
+#include <utility/buffer.h>
+#include <network/ip.h>
+
+__BEGIN_SYS
+
+// User Datagram Protocol (RFC 768) over IP
+// Sockets are bound to local ports and observe UDP for them. Received datagrams stay in the Buffers of the NIC, queued
+// in the socket (up to QUEUE_SIZE of them, the next ones being dropped) until they are taken. Besides the copying
+// receive(), receive() with an array of Datagrams takes as many of them as there are at once, without copying, and
+// each of them must then be given back with free(), since its Buffer holds one RX descriptor of the NIC.
+class UDP: private IP::Observer, public Data_Observed<IP::Buffer, unsigned short>
+{
+public:
+    static const unsigned int QUEUE_SIZE = Traits<UDP>::QUEUE_SIZE;
+    static const bool checksummed = Traits<UDP>::checksummed;
+
+    typedef IP::Buffer Buffer;
+    typedef unsigned short Port;
+    typedef Data_Observer<Buffer, Port> Observer;
+    typedef Data_Observed<Buffer, Port> Observed;
+
+    class Address
+    {
+    public:
+        Address() {}
+        Address(const IP::Address & ip, const Port & port): _ip(ip), _port(port) {}
+
+        const IP::Address & ip() const { return _ip; }
+        const Port & port() const { return _port; }
+
+        bool operator==(const Address & a) const { return (_ip == a._ip) && (_port == a._port); }
+        bool operator!=(const Address & a) const { return !(*this == a); }
+
+        friend OStream & operator<<(OStream & os, const Address & a) {
+            os << a._ip << ":" << a._port;
+            return os;
+        }
+
+    private:
+        IP::Address _ip;
+        Port _port;
+    };
+
+    class Header
+    {
+    public:
+        Header() {}
+        Header(const Port & from, const Port & to, unsigned int size)
+        : _from(htons(from)), _to(htons(to)), _length(htons(sizeof(Header) + size)), _checksum(0) {}
+
+        Port from() const { return ntohs(_from); }
+        Port to() const { return ntohs(_to); }
+        unsigned int length() const { return ntohs(_length); }
+        unsigned short checksum() const { return _checksum; }
+
+        void sum(const IP::Header * ip);
+        bool check(const IP::Header * ip) const;
+
+        template<typename T>
+        T * data() { return reinterpret_cast<T *>(this + 1); }
+
+        friend OStream & operator<<(OStream & os, const Header & h) {
+            os << "{from=" << h.from() << ",to=" << h.to() << ",len=" << h.length() << "}";
+            return os;
+        }
+
+    private:
+        unsigned int pseudo(const IP::Header * ip) const;
+
+    private:
+        Port _from;
+        Port _to;
+        unsigned short _length;
+        unsigned short _checksum;
+    } __attribute__((packed));
+
+    static const unsigned int MTU = IP::MTU - sizeof(Header);
+
+    // A datagram received by reference: its payload lives in "buffer" until the socket free()s it
+    struct Datagram
+    {
+        Buffer * buffer;
+        Address from;
+        void * data;
+        unsigned int size;
+    };
+
+    class Socket: private Observer
+    {
+    public:
+        Socket(const Port & port);
+        ~Socket();
+
+        const Port & port() const { return _port; }
+
+        int send(const Address & to, const void * data, unsigned int size);
+
+        // Block until at least one datagram arrives. The first copies it (truncated to "size"), the second takes up to
+        // "n" of them at once, in order, and returns how many it took.
+        int receive(Address * from, void * data, unsigned int size);
+        unsigned int receive(Datagram * batch, unsigned int n);
+
+        void free(const Datagram & d) { _udp->_ip->free(d.buffer); }
+
+    private:
+        bool take(Datagram * d);
+        void update(UDP::Observed * o, const Port & p, Buffer * buf);
+
+    private:
+        UDP * _udp;
+        Port _port;
+        SPSC_Circular_Buffer<Buffer *, QUEUE_SIZE> _queue;
+        Semaphore _ready;
+    };
+
+protected:
+    UDP(IP * ip);
+
+public:
+    ~UDP();
+
+    static UDP * get();
+
+    static Header * header(Buffer * buf) { return IP::header(buf)->data<Header>(); }
+
+private:
+    void update(IP::Observed * o, const IP::Protocol & p, Buffer * buf);
+
+private:
+    IP * _ip;
+
+    static UDP * _udp;
+};
+
+__END_SYS
+
+#endif
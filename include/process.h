@@ -7,7 +7,12 @@
 #include <machine.h>
 #include <utility/queue.h>
 #include <utility/handler.h>
+#include <utility/spin.h>
+#include <utility/slab.h>
+#include <utility/latency.h>
 #include <scheduler.h>
+#include <memory.h>
+#include <energy.h>
 
 extern "C" { void __exit(); }
 
@@ -20,18 +25,37 @@ class Thread
     friend class Scheduler<Thread>;     // for link()
     friend class Synchronizer_Common;   // for lock() and sleep()
     friend class Alarm;                 // for lock()
+    friend class Reservation;           // for lock() and wakeup_all()
     friend class System;                // for init()
-    friend class IC;                    // for link() for priority ceiling
+    friend class IC;                    // for link() for priority ceiling and for rescheduler()
+    friend class Task;                  // for _task
+    template<unsigned int> friend class Batch; // for batch_begin() and batch_end()
 
 protected:
+    static const bool smp = Traits<Thread>::smp;
     static const bool preemptive = Traits<Thread>::Criterion::preemptive;
     static const bool reboot = Traits<System>::reboot;
+    static const bool tls = Traits<Thread>::tls;
+    static const bool pooled = Traits<Thread>::pooled;
+    static const bool slabbed = Traits<System>::slabs;
+    static const bool cached = (pooled || slabbed) && !Traits<System>::multiheap; // Thread objects can only be recycled if all of them come from the same heap
+    static const unsigned int STATIC_OBJECTS = Traits<Thread>::STATIC_OBJECTS; // Thread objects in a static Pool, whatever the heaps
+    static const bool watermark = Traits<Thread>::stack_watermark;
+    static const bool multitask = Traits<System>::multitask;
+    static const bool batching = Traits<Thread>::batching;
+    static const bool balanced = Traits<Thread>::Criterion::balanced;
+    static const bool wake_affine = Traits<Thread>::wake_affine && Traits<Thread>::Criterion::migrating && (Traits<Thread>::Criterion::QUEUES > 1);
+    static const unsigned int CACHE_SHARING = Traits<Machine>::CACHE_SHARING;
+    static const unsigned int CPUS = Traits<Build>::CPUS;
+    static const unsigned char STACK_PAINT = 0xa5;
 
     static const unsigned int QUANTUM = Traits<Thread>::QUANTUM;
     static const unsigned int STACK_SIZE = Traits<Application>::STACK_SIZE;
+    static const unsigned int STACK_CLASSES = 4;
 
     typedef CPU::Log_Addr Log_Addr;
     typedef CPU::Context Context;
+    typedef Traits<Thread>::Kernel_Lock Kernel_Lock; // Spin, Ticket_Spin or MCS_Spin (see utility/spin.h)
 
 public:
     // Thread State
@@ -54,16 +78,22 @@ public:
     };
 
     // Thread Queue
-    typedef Ordered_Queue<Thread, Criterion, Scheduler<Thread>::Element> Queue;
+    typedef IF<Traits<Thread>::heap_queues, Heap_Queue<Thread, Criterion, Scheduler<Thread>::Element>, Ordered_Queue<Thread, Criterion, Scheduler<Thread>::Element>>::Result Queue;
 
     // Thread Configuration
+    // Under partitioned criteria (e.g. Fixed_CPU), "cpu" pins the thread to that CPU's queue (ANY leaves the criterion's choice)
+    // "scratchpad" places the stack in the machine's scratchpad memory (see new (SCRATCHPAD)), if it has one with room left
+    // "task" is the Task the thread will run in (0 for the creator's)
     struct Configuration {
-        Configuration(const State & s = READY, const Criterion & c = NORMAL, unsigned int ss = STACK_SIZE)
-        : state(s), criterion(c), stack_size(ss) {}
+        Configuration(const State & s = READY, const Criterion & c = NORMAL, unsigned int ss = STACK_SIZE, unsigned int cpu = Criterion::ANY, bool sp = false, Task * t = 0)
+        : state(s), criterion(c), stack_size(ss), cpu(cpu), scratchpad(sp), task(t) {}
 
         State state;
         Criterion criterion;
         unsigned int stack_size;
+        unsigned int cpu;
+        bool scratchpad;
+        Task * task;
     };
 
 
@@ -76,10 +106,23 @@ public:
 
     const volatile State & state() const { return _state; }
     const volatile Criterion::Statistics & statistics() { return criterion().statistics(); }
+    const Latency::Histogram & latency() const { return _wakeup.histogram(); } // wakeup-to-run (see utility/latency.h)
+    Energy_Meter::Energy energy() const { return _energy; } // nJ, up to its last dispatch (see energy.h)
+
+    // Deepest the stack has ever been used, in bytes, i.e. the lowest byte that no longer holds the paint from
+    // creation (with Traits<Thread>::stack_watermark, 0 otherwise). A thread using all of it has likely overflowed.
+    unsigned int stack_peak() const;
 
     const volatile Criterion & priority() const { return _link.rank(); }
     void priority(const Criterion & p);
 
+    unsigned int cpu() { return criterion().queue(); }
+    void migrate(unsigned int cpu);
+
+    // CPUs (one bit each) that work stealing and load balancing may move the thread to (CPU_Affinity, all by default)
+    unsigned long affinity() { return criterion().affinity(); }
+    void affinity(unsigned long mask);
+
     int join();
     void pass();
     void suspend();
@@ -89,44 +132,151 @@ public:
     static void yield();
     static void exit(int status = 0);
 
+    // Creates n threads of the same entry and arguments, all SUSPENDED (whatever conf.state says), under a single
+    // acquisition of the kernel lock (and of the Thread object pool), so the creator is neither preempted nor are the
+    // queues reordered until resume_all() makes them all READY at once, with a single reschedule. Interrupts stay
+    // disabled while all the stacks are allocated. Each thread is then deleted on its own, as any other.
+    template<typename ... Tn>
+    static void spawn(Thread * threads[], unsigned int n, const Configuration & conf, int (* entry)(Tn ...), Tn ... an);
+    static void resume_all(Thread * const threads[], unsigned int n);
+
+    // Thread objects come from a static Pool (see Traits<Thread>::STATIC_OBJECTS), are recycled through a free list (see Traits<Thread>::pooled) or come from a slab (see Traits<System>::slabs); derived classes fall through to the heap
+    static void * operator new(size_t bytes) { return ((cached || STATIC_OBJECTS) && (bytes == sizeof(Thread))) ? object_alloc(false) : ::operator new(bytes); }
+    static void * operator new(size_t bytes, const System_Allocator & allocator) { return ((cached || STATIC_OBJECTS) && (bytes == sizeof(Thread))) ? object_alloc(true) : ::operator new(bytes, SYSTEM); }
+    static void operator delete(void * object, size_t bytes) {
+        if((cached || STATIC_OBJECTS) && (bytes == sizeof(Thread)))
+            object_free(object);
+        else
+            ::operator delete(object);
+    }
+
 protected:
-    void constructor_prologue(unsigned int stack_size);
-    void constructor_epilogue(Log_Addr entry, unsigned int stack_size);
+    // Batched threads are created by spawn(), which holds the kernel lock for all of them
+    struct Batched {};
+
+    template<typename ... Tn>
+    Thread(const Batched &, const Configuration & conf, int (* entry)(Tn ...), Tn ... an);
+
+    void constructor_prologue(unsigned int stack_size, bool scratchpad = false, Task * task = 0, bool batched = false);
+    void constructor_epilogue(Log_Addr entry, unsigned int stack_size, bool batched = false);
 
     Criterion & criterion() { return const_cast<Criterion &>(_link.rank()); }
     Queue::Element * link() { return &_link; }
 
+    void rank(int p);
+
+    void relocate(unsigned int cpu);
+
+    // Execution time, halved every BALANCE_PERIOD, as of "ts" (see balance())
+    TSC::Time_Stamp load(const TSC::Time_Stamp & ts);
+
     static Thread * volatile running() { return _scheduler.chosen(); }
 
-    static void lock() { CPU::int_disable(); }
-    static void unlock() { CPU::int_enable(); }
-    static bool locked() { return CPU::int_disabled(); }
+    // Kernel locking masks interrupts on the local CPU and, on SMP, also
+    // takes a spin lock: the scheduler's by default, or a subsystem's own
+    static void lock(Kernel_Lock * lock = &_lock) {
+        CPU::int_disable();
+        if(smp) {
+            switched(); // an interrupt may hit a brand new thread before first_run() gets to it
+            lock->acquire();
+        }
+    }
+
+    static void unlock(Kernel_Lock * lock = &_lock) {
+        if(smp)
+            lock->release();
+        CPU::int_enable();
+    }
+
+    static bool locked(Kernel_Lock * lock = &_lock) { return (smp) ? lock->taken() : CPU::int_disabled(); }
+
+    // On SMP, dispatch() switches with the scheduler lock held by "prev", which the first code to run on the other side
+    // (i.e. "next") releases
+    static void switched() {
+        if(smp && _switching[CPU::id()]) {
+            _switching[CPU::id()] = false;
+            _lock.release();
+        }
+    }
 
     static void sleep(Queue * q);
+    static bool sleep(Queue * q, const Microsecond & timeout);
     static void wakeup(Queue * q);
+    static void handoff(Queue * q);
     static void wakeup_all(Queue * q);
+    static void requeue(Queue * from, Queue * to);
+    static void place(Thread * t);
 
     static void reschedule();
+    static void reschedule(unsigned int cpu);
+    static bool throttle();
+    static void rescheduler(IC::Interrupt_Id interrupt);
     static void time_slicer(IC::Interrupt_Id interrupt);
+    static void balance();
+    static TSC::Time_Stamp weight(Queue::Element * e);
+    static TSC::Time_Stamp migration_cost(Queue::Element * e);
 
     static void dispatch(Thread * prev, Thread * next, bool charge = true);
 
+    // While the running thread is in a batch, reschedule() only takes note and batch_end() does it once
+    static void batch_begin();
+    static void batch_end();
+
     static int idle();
 
+    // Brand new threads start here, since they don't return to dispatch() as the others do
+    template<typename ... Tn>
+    static int first_run(int (* entry)(Tn ...), Tn ... an) {
+        switched();
+        return entry(an ...);
+    }
+
+    static char * stack_alloc(unsigned int bytes);
+    static void stack_free(char * stack, unsigned int bytes);
+    static void * object_alloc(bool system);
+    static void object_alloc(void * objects[], unsigned int n);
+    static void object_free(void * object);
+    static char * tls_alloc();
+
 private:
     static void init();
 
+private:
+    // Stacks are recycled per size class, i.e. one free list for each distinct Configuration::stack_size seen, linked through their first word
+    struct Stack_Class {
+        unsigned int size;
+        char * free;
+    };
+
 protected:
     char * _stack;
+    unsigned int _stack_size;
+    unsigned int _stack_peak; // taken by exit(), before the status overwrites the bottom of the stack, or by ~Thread()
+    bool _scratchpad_stack;
     Context * volatile _context;
     volatile State _state;
     Queue * _waiting;
     Thread * volatile _joining;
     Queue::Element _link;
+    CPU::FPU_Context _fpu;
+    char * _tls;
+    unsigned int _ic_level;
+    Latency::Wakeup _wakeup;
+    Energy_Meter::Energy _energy;
+    Task * _task;
 
     static volatile unsigned int _thread_count;
     static Scheduler_Timer * _timer;
     static Scheduler<Thread> _scheduler;
+    static Kernel_Lock _lock;
+    static volatile bool _switching[CPUS];
+    static Stack_Class _stack_pool[STACK_CLASSES];
+    static void * _object_pool;
+    static Slab<Thread> _slab;
+    static unsigned int _batching[CPUS];
+    static bool _batched[CPUS];
+    static TSC::Time_Stamp _balanced;
+    static volatile bool _busy[CPUS];
 };
 
 
@@ -135,7 +285,7 @@ inline Thread::Thread(int (* entry)(Tn ...), Tn ... an)
 : _state(READY), _waiting(0), _joining(0), _link(this, NORMAL)
 {
     constructor_prologue(STACK_SIZE);
-    _context = CPU::init_stack(0, _stack + STACK_SIZE, &__exit, entry, an ...);
+    _context = CPU::init_stack(0, _stack + STACK_SIZE, &__exit, &first_run<Tn ...>, entry, an ...);
     constructor_epilogue(entry, STACK_SIZE);
 }
 
@@ -143,11 +293,140 @@ template<typename ... Tn>
 inline Thread::Thread(const Configuration & conf, int (* entry)(Tn ...), Tn ... an)
 : _state(conf.state), _waiting(0), _joining(0), _link(this, conf.criterion)
 {
-    constructor_prologue(conf.stack_size);
-    _context = CPU::init_stack(0, _stack + conf.stack_size, &__exit, entry, an ...);
+    if(conf.cpu != Criterion::ANY) {
+        assert(conf.cpu < Criterion::QUEUES);
+        criterion().queue(conf.cpu);
+    }
+    constructor_prologue(conf.stack_size, conf.scratchpad, conf.task);
+    _context = CPU::init_stack(0, _stack + conf.stack_size, &__exit, &first_run<Tn ...>, entry, an ...);
     constructor_epilogue(entry, conf.stack_size);
 }
 
+template<typename ... Tn>
+inline Thread::Thread(const Batched &, const Configuration & conf, int (* entry)(Tn ...), Tn ... an)
+: _state(SUSPENDED), _waiting(0), _joining(0), _link(this, conf.criterion)
+{
+    if(conf.cpu != Criterion::ANY) {
+        assert(conf.cpu < Criterion::QUEUES);
+        criterion().queue(conf.cpu);
+    }
+    constructor_prologue(conf.stack_size, conf.scratchpad, conf.task, true);
+    _context = CPU::init_stack(0, _stack + conf.stack_size, &__exit, &first_run<Tn ...>, entry, an ...);
+    constructor_epilogue(entry, conf.stack_size, true);
+}
+
+// The objects are those "new Thread" would get, so "delete" gives them back as usual
+template<typename ... Tn>
+inline void Thread::spawn(Thread * threads[], unsigned int n, const Configuration & conf, int (* entry)(Tn ...), Tn ... an)
+{
+    void ** objects = reinterpret_cast<void **>(threads);
+    object_alloc(objects, n);
+
+    lock();
+
+    db<Thread>(TRC) << "Thread::spawn(n=" << n << ")" << endl;
+
+    for(unsigned int i = 0; i < n; i++)
+        threads[i] = ::new (objects[i]) Thread(Batched(), conf, entry, an ...);
+
+    unlock();
+}
+
+
+
+// A Task is an Address_Space with a code and a data Segment attached to it and the threads that run in it, starting
+// with main(). Threads created by one of its threads join it, unless their Configuration says otherwise, and
+// dispatching a thread of another Task activates that Task's Address_Space (see Traits<System>::multitask).
+// The system is mapped into every Address_Space, so the entry point may be either in the code segment attached at
+// "code" or in the system itself.
+class Task
+{
+    friend class Thread;                // for activate() and init()
+
+private:
+    static const bool multitask = Traits<System>::multitask;
+    static const unsigned int CPUS = Traits<Build>::CPUS;
+
+    typedef CPU::Log_Addr Log_Addr;
+
+public:
+    template<typename ... Tn>
+    Task(Segment * cs, Segment * ds, int (* entry)(Tn ...), Tn ... an);
+    template<typename ... Tn>
+    Task(Segment * cs, Segment * ds, const Log_Addr & code, const Log_Addr & data, int (* entry)(Tn ...), Tn ... an);
+    ~Task();
+
+    Address_Space * address_space() const { return _as; }
+    Segment * code_segment() const { return _cs; }
+    Segment * data_segment() const { return _ds; }
+    Log_Addr code() const { return _code; }
+    Log_Addr data() const { return _data; }
+    Thread * main() const { return _main; }
+
+    int join() { return _main->join(); }
+
+    // A bounded heap of the Task's own, which malloc() and new in its threads take from (see Traits<System>::task_heaps)
+    // and which goes away with it. It can only be given once, by one of its threads when each Task has its own MMU
+    // Address_Space, so the heap's Segment is attached there (0 otherwise). With "max" above "bytes", the heap grows
+    // up to it as needed and gives memory back as it empties (see Segment_Heap).
+    Heap * heap() const { return _heap; }
+    Heap * heap(unsigned int bytes, unsigned int max = 0);
+
+    static Task * volatile self() { return Thread::self()->_task; }
+
+    // Loads an application ELF image (e.g. received into memory or read from flash) into new code and data Segments,
+    // which the Task will own, and starts it at the image's entry point. Executables (ET_EXEC) are attached where they
+    // were linked, which takes an MMU, while position independent ones (ET_DYN, -static-pie) go wherever the segments
+    // can be attached, being relocated as they are copied. Returns 0 if the image can't be loaded.
+    static Task * load(const void * image);
+
+private:
+    Task(Address_Space * as);
+    Task(Segment * cs, Segment * ds, const Log_Addr & code, const Log_Addr & data);
+
+    void constructor_prologue();
+    template<typename ... Tn>
+    void constructor_epilogue(int (* entry)(Tn ...), Tn ... an) {
+        _main = new (SYSTEM) Thread(Thread::Configuration(Thread::READY, Thread::MAIN, Thread::STACK_SIZE, Thread::Criterion::ANY, false, this), entry, an ...);
+        db<Task>(TRC) << "Task(as=" << _as << ",cs=" << _cs << ",ds=" << _ds << ",code=" << _code << ",data=" << _data << ",main=" << _main << ") => " << this << endl;
+    }
+
+    void activate();
+    static Task * active() { return _active[CPU::id()]; }
+
+    static void init();
+
+private:
+    Address_Space * _as;
+    Segment * _cs;
+    Segment * _ds;
+    Log_Addr _code;
+    Log_Addr _data;
+    Thread * _main;
+    Segment_Heap * _heap;
+    bool _loaded;
+
+    static Task * _master; // the system's own, in the Address_Space SETUP left active
+    static Task * _active[CPUS];
+};
+
+
+template<typename ... Tn>
+inline Task::Task(Segment * cs, Segment * ds, int (* entry)(Tn ...), Tn ... an)
+: _as(new (SYSTEM) Address_Space), _cs(cs), _ds(ds), _code(_as->attach(_cs)), _data(_as->attach(_ds)), _heap(0), _loaded(false)
+{
+    constructor_prologue();
+    constructor_epilogue(entry, an ...);
+}
+
+template<typename ... Tn>
+inline Task::Task(Segment * cs, Segment * ds, const Log_Addr & code, const Log_Addr & data, int (* entry)(Tn ...), Tn ... an)
+: _as(new (SYSTEM) Address_Space), _cs(cs), _ds(ds), _code(_as->attach(_cs, code)), _data(_as->attach(_ds, data)), _heap(0), _loaded(false)
+{
+    constructor_prologue();
+    constructor_epilogue(entry, an ...);
+}
+
 
 // A Java-like Active Object
 class Active: public Thread
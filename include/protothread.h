@@ -0,0 +1,118 @@
+// EPOS Protothread Declarations
+
+#ifndef __protothread_h
+#define __protothread_h
+
+#include <process.h>
+#include <synchronizer.h>
+#include <time.h>
+#include <utility/list.h>
+
+__BEGIN_SYS
+
+// Protothreads are stackless cooperative tasks multiplexed on a single Thread (a Protothread_Scheduler)
+// Each one costs a few words (a continuation, a deadline and a list link), so many of them fit where a
+// couple of Thread stacks wouldn't. Their run() must be written as a PT_BEGIN() ... PT_END() block, in
+// which local variables don't survive blocking (keep them in the object), "switch" can't be used and
+// there can be at most one PT_ macro per line (the continuation is the line number).
+//
+// class Blinker: public Protothread
+// {
+//     State run() {
+//         PT_BEGIN();
+//         for(;;) {
+//             led.toggle();
+//             PT_SLEEP(500000);
+//         }
+//         PT_END();
+//     }
+// };
+#define PT_BEGIN()          switch(_lc) { case 0:
+#define PT_END()            } _lc = 0; return FINISHED
+#define PT_YIELD()          do { _lc = __LINE__; return READY; case __LINE__:; } while(0)
+#define PT_WAIT_UNTIL(c)    do { _lc = __LINE__; case __LINE__: if(!(c)) return WAITING; } while(0)
+#define PT_SLEEP(t)         do { sleep(t); _lc = __LINE__; return SLEEPING; case __LINE__:; } while(0)
+#define PT_P(s)             PT_WAIT_UNTIL((s).try_p())
+
+class Protothread_Scheduler;
+
+class Protothread
+{
+    friend class Protothread_Scheduler;
+
+protected:
+    typedef Alarm::Tick Tick;
+    typedef Simple_List<Protothread> List;
+
+public:
+    // What run() returns
+    enum State {
+        READY,      // yielded, run again in the next round
+        WAITING,    // blocked on a condition, run again after the next notify()
+        SLEEPING,   // blocked until the deadline set by sleep()
+        FINISHED
+    };
+
+public:
+    Protothread(): _lc(0), _deadline(0), _link(this) {}
+    virtual ~Protothread() {}
+
+    virtual State run() = 0;
+
+protected:
+    void sleep(const Microsecond & time) { _deadline = Alarm::elapsed() + Alarm::ticks(time); }
+
+protected:
+    unsigned short _lc; // local continuation, i.e. the line to resume at
+
+private:
+    Tick _deadline;
+    List::Element _link;
+};
+
+
+// The Thread running a set of protothreads in rounds. It sleeps on a semaphore while none are READY,
+// with a timeout for the earliest deadline, and finishes when all of them do
+class Protothread_Scheduler: public Active
+{
+public:
+    Protothread_Scheduler(): _wakeup(0) {}
+    ~Protothread_Scheduler() {}
+
+    void insert(Protothread * pt);
+
+    // Events that protothreads WAIT for must call notify() (see Protothread_Semaphore)
+    void notify() { _wakeup.v(); }
+
+    int run();
+
+private:
+    Mutex _mutex;
+    Semaphore _wakeup;
+    Protothread::List _ready;
+};
+
+
+// A counting semaphore for protothreads (PT_P(s) and s.v()), that can also be signaled from ordinary threads and ISRs
+class Protothread_Semaphore
+{
+public:
+    Protothread_Semaphore(Protothread_Scheduler * s, int v = 0): _scheduler(s), _value(v) {}
+
+    bool try_p() {
+        for(int value = _value; value > 0; value = _value)
+            if(CPU::cas(_value, value, value - 1) == value)
+                return true;
+        return false;
+    }
+
+    void v() { CPU::finc(_value); _scheduler->notify(); }
+
+private:
+    Protothread_Scheduler * _scheduler;
+    volatile int _value;
+};
+
+__END_SYS
+
+#endif
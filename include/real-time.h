@@ -0,0 +1,160 @@
+// EPOS Real-time Declarations
+
+#ifndef __real_time_h
+#define __real_time_h
+
+#include <process.h>
+#include <synchronizer.h>
+#include <time.h>
+#include <monitor.h>
+
+__BEGIN_SYS
+
+// Periodic threads are released by a private Alarm and call wait_next() at the end of each job
+class Periodic_Thread: public Thread
+{
+public:
+    enum {
+        SAME    = Criterion::SAME,
+        UNKNOWN = Criterion::UNKNOWN,
+        ANY     = Criterion::ANY
+    };
+
+protected:
+    // Alarm handler that releases the next job
+    class Handler: public Semaphore_Handler
+    {
+    public:
+        Handler(Semaphore * s, Periodic_Thread * t): Semaphore_Handler(s), _thread(t) {}
+        ~Handler() {}
+
+        void operator()() {
+            if(Criterion::dynamic)
+                _thread->release();
+            Semaphore_Handler::operator()();
+        }
+
+    private:
+        Periodic_Thread * _thread;
+    };
+
+public:
+    struct Configuration: public Thread::Configuration {
+        Configuration(const Microsecond & p, const Microsecond & d = SAME, const Microsecond & c = UNKNOWN, unsigned int n = INFINITE,
+                      const State & s = READY, unsigned int ss = STACK_SIZE)
+        : Thread::Configuration(s, Criterion(p, d, c), ss), period(p), times(n) {}
+
+        Microsecond period;
+        unsigned int times;
+    };
+
+public:
+    template<typename ... Tn>
+    Periodic_Thread(const Microsecond & p, int (* entry)(Tn ...), Tn ... an)
+    : Thread(Thread::Configuration(SUSPENDED, Criterion(p)), entry, an ...),
+      _semaphore(0), _handler(&_semaphore, this), _alarm(p, &_handler, INFINITE) { resume(); }
+
+    template<typename ... Tn>
+    Periodic_Thread(const Configuration & conf, int (* entry)(Tn ...), Tn ... an)
+    : Thread(Thread::Configuration(SUSPENDED, conf.criterion, conf.stack_size), entry, an ...),
+      _semaphore(0), _handler(&_semaphore, this), _alarm(conf.period, &_handler, conf.times) {
+        if((conf.state == READY) || (conf.state == RUNNING))
+            resume();
+    }
+
+    const Microsecond & period() const { return _alarm.period(); }
+    void period(const Microsecond & p) { _alarm.period(p); }
+
+    static volatile bool wait_next() {
+        Periodic_Thread * t = reinterpret_cast<Periodic_Thread *>(running());
+
+        db<Thread>(TRC) << "Periodic_Thread::wait_next(this=" << t << ",times=" << t->_alarm.times() << ")" << endl;
+
+        if(t->_alarm.times()) {
+            if(t->_semaphore.try_p()) // the next job was released before this one was over, so it missed its deadline
+                Monitor::deadline_missed();
+            else
+                t->_semaphore.p();
+        }
+
+        return t->_alarm.times();
+    }
+
+protected:
+    // Dynamic criteria (e.g. EDF) get a new rank for each job. A thread that overran
+    // its previous job is still in the ready queue and must be reinserted for that
+    void release() {
+        lock();
+
+        db<Thread>(TRC) << "Periodic_Thread::release(this=" << this << ")" << endl;
+
+        if(_state == READY) {
+            _scheduler.remove(this);
+            criterion().update();
+            _scheduler.insert(this);
+        } else
+            criterion().update();
+
+        unlock();
+    }
+
+protected:
+    Semaphore _semaphore;
+    Handler _handler;
+    Alarm _alarm;
+};
+
+
+// CPU bandwidth reservation: a budget of CPU time every period, shared by the threads given it through the Reserved
+// criterion (e.g. Thread::Configuration(READY, Criterion(NORMAL, &reservation))). A thread that finds it used up when
+// its CPU reschedules is throttled, i.e. waits out of the ready queue, until the private Alarm replenishes the budget
+// at the end of the period. Their slices never outlast what is left of it (see Reserved::quantum()), which already
+// discounts what the threads running on other CPUs have taken of it so far
+class Reservation
+{
+    friend class Thread;
+
+public:
+    Reservation(const Microsecond & budget, const Microsecond & period);
+    ~Reservation();
+
+    const Microsecond & budget() const { return _budget; }
+    const Microsecond & period() const { return _alarm.period(); }
+
+    // What is left of the budget in the current period
+    Microsecond left() const;
+
+private:
+    // Threads of the reservation are accounted from their dispatch ("start") to their leaving the CPU ("stop"), but
+    // never before the last replenishment, so what they ran before it isn't charged to the new period
+    void start(const TSC::Time_Stamp & ts) {
+        _running++;
+        _since += ts;
+    }
+    void stop(const TSC::Time_Stamp & ts, const TSC::Time_Stamp & dispatched) {
+        TSC::Time_Stamp from = (dispatched > _replenished) ? dispatched : _replenished;
+        _consumed += ts - from;
+        _running--;
+        _since -= from;
+    }
+
+    // What has been consumed of the budget as of "ts", including what the running threads have not been charged yet
+    TSC::Time_Stamp consumed(const TSC::Time_Stamp & ts) const { return _consumed + _running * ts - _since; }
+    bool exhausted(const TSC::Time_Stamp & ts) const { return consumed(ts) >= _counts; }
+
+    void replenish();
+
+private:
+    Microsecond _budget;
+    TSC::Time_Stamp _counts;                // the budget in TSC counts
+    volatile TSC::Time_Stamp _consumed;     // of it in the current period, by threads that have left the CPU
+    volatile unsigned int _running;         // threads of the reservation running now
+    volatile TSC::Time_Stamp _since;        // sum of the time stamps they have been accounted from
+    volatile TSC::Time_Stamp _replenished;
+    Thread::Queue _throttled;
+    Alarm _alarm;
+};
+
+__END_SYS
+
+#endif
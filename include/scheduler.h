@@ -51,35 +51,55 @@ public:
     static const bool timed = false;
     static const bool dynamic = false;
     static const bool preemptive = true;
-    static const bool collecting = false;
+    static const bool collecting = Traits<Thread>::collecting;
     static const bool charging = false;
     static const bool awarding = false;
     static const bool migrating = false;
+    static const bool balanced = false;
+    static const bool reserving = false;
     static const bool track_idle = false;
     static const bool task_wide = false;
     static const bool cpu_wide = false;
     static const bool system_wide = false;
+    static const bool banded = false;
+    static const bool adaptive = false;
     static const unsigned int QUEUES = 1;
+    static const unsigned int BANDS = 1;
 
     // Runtime Statistics (for policies that don't use any; that´s why its a union)
     union Statistics {
-        // Thread Execution Time
-        TSC::Time_Stamp thread_execution_time;  // accumulated thread execution time
-        TSC::Time_Stamp last_thread_dispatch;   // time stamp of last dispatch
+        // Virtualized PMU channels (the first PMU_CHANNELS ones, counted per thread by Thread::dispatch())
+        static const bool virtual_pmu = Traits<Thread>::virtual_pmu;
+        static const unsigned int PMU_CHANNELS = virtual_pmu ? Traits<Thread>::PMU_CHANNELS : 0;
+        static_assert(PMU_CHANNELS <= PMU::CHANNELS, "Traits<Thread>::PMU_CHANNELS exceeds the channels of this PMU");
+
+        // Thread Execution Time (filled in by Thread::dispatch() for collecting criteria) and PMU counts (virtual_pmu)
+        struct {
+            TSC::Time_Stamp thread_execution_time;  // accumulated thread execution time
+            TSC::Time_Stamp last_thread_dispatch;   // time stamp of last dispatch
+            PMU::Count pmu_count[PMU_CHANNELS];     // accumulated counts of each virtualized PMU channel
+            TSC::Time_Stamp load;                   // execution time, halved every BALANCE_PERIOD (balanced criteria)
+            TSC::Time_Stamp load_decay;             // time stamp up to which load has been decayed
+        };
 
         // Deadline Miss count - Used By Clerk
-        Alarm * alarm_times;                    // pointer to RT_Thread private alarm (for monitoring purposes)
-        unsigned int finished_jobs;             // number of finished jobs given by the number of times alarm->p() was called for this thread
-        unsigned int missed_deadlines;          // number of missed deadlines given by the number of finished jobs (finished_jobs) minus the number of dispatched jobs (alarm_times->times)
+        struct {
+            Alarm * alarm_times;                    // pointer to RT_Thread private alarm (for monitoring purposes)
+            unsigned int finished_jobs;             // number of finished jobs given by the number of times alarm->p() was called for this thread
+            unsigned int missed_deadlines;          // number of missed deadlines given by the number of finished jobs (finished_jobs) minus the number of dispatched jobs (alarm_times->times)
+        };
 
         // CPU Execution Time (capture ts)
         static TSC::Time_Stamp _cpu_time[Traits<Build>::CPUS];              // accumulated CPU time in the current hyperperiod for each CPU
         static TSC::Time_Stamp _last_dispatch_time[Traits<Build>::CPUS];    // time Stamp of last dispatch in each CPU
         static TSC::Time_Stamp _last_activation_time;                       // global time stamp of the last heuristic activation
+
+        // PMU readings at the last dispatch on each CPU (virtual_pmu)
+        static PMU::Count _last_pmu_count[Traits<Build>::CPUS][PMU_CHANNELS];
     };
 
 protected:
-    Scheduling_Criterion_Common() {}
+    Scheduling_Criterion_Common(): _statistics() {}
 
 public:
     const Microsecond period() { return 0;}
@@ -88,6 +108,18 @@ public:
     unsigned int queue() const { return 0; }
     void queue(unsigned int q) {}
 
+    unsigned long affinity() const { return ~0UL; }
+    void affinity(unsigned long mask) {}
+    bool affine(unsigned int cpu) const { return true; }
+
+    Reservation * reservation() const { return 0; }
+
+    unsigned int band() const { return 0; }
+
+    const Microsecond quantum() const { return Traits<Thread>::QUANTUM; }
+    void quantum(const Microsecond & q) {}
+    void adapt(bool expired) {}
+
     bool update() { return false; }
 
     bool collect(bool end = false) { return false; }
@@ -109,27 +141,89 @@ class Priority: public Scheduling_Criterion_Common
     friend class _SYS::Periodic_Thread;
     friend class _SYS::RT_Thread;
 
+public:
+    // Bitmap-indexed ready queue (see Bitmap_Scheduling_List)
+    static const bool banded = Traits<Thread>::banded_queue;
+    static const unsigned int BANDS = Traits<Thread>::PRIORITY_BANDS;
+
 public:
     template <typename ... Tn>
     Priority(int p = NORMAL, Tn & ... an): _priority(p) {}
 
     operator const volatile int() const volatile { return _priority; }
 
+    // MAIN, HIGH and the numeric priorities up to BANDS - 4 get a band each,
+    // the remaining numeric ones share the band right above NORMAL's, and
+    // NORMAL, LOW and IDLE get the three lowest bands
+    unsigned int band() const {
+        switch(_priority) {
+        case NORMAL: return BANDS - 3;
+        case LOW: return BANDS - 2;
+        case IDLE: return BANDS - 1;
+        default: return (_priority <= MAIN) ? 0 : (unsigned(_priority) < BANDS - 4) ? _priority : BANDS - 4;
+        }
+    }
+
 protected:
     volatile int _priority;
 };
 
 // Round-Robin
+// Each thread carries its own quantum (Traits<Thread>::QUANTUM unless set with quantum()). In adaptive
+// mode, threads that use their whole slice up (CPU-bound) get it doubled and threads that block before
+// it ends (I/O-bound) get it halved, within [QUANTUM / 4, QUANTUM * 4]
 class RR: public Priority
 {
 public:
     static const bool timed = true;
     static const bool dynamic = false;
     static const bool preemptive = true;
+    static const bool adaptive = Traits<Thread>::adaptive_quantum;
+
+    static const unsigned int MIN_QUANTUM = Traits<Thread>::QUANTUM / 4;
+    static const unsigned int MAX_QUANTUM = Traits<Thread>::QUANTUM * 4;
 
 public:
     template <typename ... Tn>
-    RR(int p = NORMAL, Tn & ... an): Priority(p) {}
+    RR(int p = NORMAL, Tn & ... an): Priority(p), _quantum(Traits<Thread>::QUANTUM) {}
+
+    const Microsecond quantum() const { return _quantum; }
+    void quantum(const Microsecond & q) { _quantum = q; }
+
+    void adapt(bool expired) {
+        if(expired)
+            _quantum = (_quantum * 2 < MAX_QUANTUM) ? _quantum * 2 : MAX_QUANTUM;
+        else
+            _quantum = (_quantum / 2 > MIN_QUANTUM) ? _quantum / 2 : MIN_QUANTUM;
+    }
+
+protected:
+    Microsecond _quantum;
+};
+
+// Reserved (Round-Robin with CPU bandwidth reservations)
+// Threads given a Reservation run as in RR while its budget lasts and are
+// throttled until it is replenished (see Reservation in real-time.h), so a
+// burst of theirs can't starve threads of lower priority. Threads without one
+// are plain RR threads
+class Reserved: public RR
+{
+public:
+    static const bool reserving = true;
+    static const bool collecting = true; // budgets are charged at each dispatch
+
+public:
+    template <typename ... Tn>
+    Reserved(int p = NORMAL, Tn & ... an): RR(p), _reservation(0) {}
+    Reserved(int p, Reservation * r): RR(p), _reservation(r) {}
+
+    // Slices end when the budget runs out
+    const Microsecond quantum() const;
+
+    Reservation * reservation() const { return _reservation; }
+
+protected:
+    Reservation * _reservation;
 };
 
 // First-Come, First-Served (FIFO)
@@ -139,12 +233,203 @@ public:
     static const bool timed = false;
     static const bool dynamic = false;
     static const bool preemptive = false;
+    static const bool banded = false;
 
 public:
     template <typename ... Tn>
     FCFS(int p = NORMAL, Tn & ... an);
 };
 
+
+// Real-time Algorithms
+// Periodic threads are given a period, a relative deadline (SAME means the
+// period) and a capacity (worst-case execution time, UNKNOWN if not given);
+// aperiodic ones use the plain priorities (APERIODIC, NORMAL, LOW, ...)
+class RT_Common: public Priority
+{
+    friend class _SYS::Periodic_Thread;
+    friend class _SYS::RT_Thread;
+
+public:
+    static const bool timed = true;
+    static const bool dynamic = false;
+    static const bool preemptive = true;
+    static const bool banded = false; // ranks are times, so they don't map onto bands
+
+protected:
+    RT_Common(int p): Priority(p), _period(0), _deadline(0), _capacity(0) {} // aperiodic
+    RT_Common(int p, const Microsecond & t, const Microsecond & d, const Microsecond & c)
+    : Priority(p), _period(t), _deadline(d ? d : t), _capacity(c) {}
+
+public:
+    const Microsecond period() { return _period; }
+    void period(const Microsecond & p) { _period = p; }
+
+    const Microsecond deadline() { return _deadline; }
+    const Microsecond capacity() { return _capacity; }
+
+    bool periodic() const { return _period; }
+
+protected:
+    Microsecond _period;
+    Microsecond _deadline;
+    Microsecond _capacity;
+};
+
+// Rate Monotonic (the shorter the period, the higher the priority)
+class RM: public RT_Common
+{
+public:
+    static const bool dynamic = false;
+
+public:
+    RM(int p = APERIODIC): RT_Common(p) {}
+    RM(const Microsecond & p, const Microsecond & d = SAME, const Microsecond & c = UNKNOWN, unsigned int cpu = ANY)
+    : RT_Common(int(p), p, d, c) {}
+};
+
+// Deadline Monotonic (the shorter the relative deadline, the higher the priority)
+class DM: public RT_Common
+{
+public:
+    static const bool dynamic = false;
+
+public:
+    DM(int p = APERIODIC): RT_Common(p) {}
+    DM(const Microsecond & p, const Microsecond & d = SAME, const Microsecond & c = UNKNOWN, unsigned int cpu = ANY)
+    : RT_Common(int(d ? d : p), p, d, c) {}
+};
+
+// Earliest Deadline First (the rank is the absolute deadline of the current
+// job, in Alarm ticks, and is recomputed by update() at each job release)
+class EDF: public RT_Common
+{
+public:
+    static const bool dynamic = true;
+
+public:
+    EDF(int p = APERIODIC): RT_Common(p) {}
+    EDF(const Microsecond & p, const Microsecond & d = SAME, const Microsecond & c = UNKNOWN, unsigned int cpu = ANY);
+
+    bool update();
+};
+
+
+// Multicore Algorithms
+class Variable_Queue_Scheduler
+{
+protected:
+    Variable_Queue_Scheduler(unsigned int queue): _queue(queue) {};
+
+    unsigned int queue() const volatile { return _queue; }
+    void queue(unsigned int q) { _queue = q; }
+
+protected:
+    volatile unsigned int _queue;
+    static volatile unsigned int _next_queue;
+};
+
+// Fixed CPU (fully partitioned Round-Robin, one queue per CPU)
+// MAIN and IDLE stay on the CPU creating them, other threads go either to the
+// CPU given at creation or to the next one in a round-robin fashion
+class Fixed_CPU: public Priority, public Variable_Queue_Scheduler
+{
+public:
+    static const bool timed = true;
+    static const bool dynamic = false;
+    static const bool preemptive = true;
+    static const unsigned int QUEUES = Traits<Build>::CPUS;
+
+public:
+    template <typename ... Tn>
+    Fixed_CPU(int p = NORMAL, unsigned int cpu = ANY, Tn & ... an)
+    : Priority(p), Variable_Queue_Scheduler(((p == IDLE) || (p == MAIN)) ? CPU::id() : (cpu != ANY) ? cpu : ++_next_queue %= CPU::cores()) {}
+
+    using Variable_Queue_Scheduler::queue;
+    static unsigned int current_queue() { return CPU::id(); }
+};
+
+// CPU Affinity (partitioned Round-Robin with work stealing)
+// Threads start on a CPU as in Fixed_CPU, but an idle CPU steals the
+// highest-priority ready thread from the most loaded queue. When balanced,
+// the scheduler timer also moves threads from the busiest CPU to the idlest
+// one every BALANCE_PERIOD (see Thread::balance()). Either way, threads only
+// go to the CPUs in their affinity mask (one bit per CPU, all by default)
+class CPU_Affinity: public Fixed_CPU
+{
+public:
+    static const bool migrating = true;
+    static const bool balanced = Traits<Thread>::balanced && (QUEUES > 1);
+    static const bool collecting = Traits<Thread>::collecting || balanced; // loads come from the dispatch statistics
+
+public:
+    template <typename ... Tn>
+    CPU_Affinity(int p = NORMAL, unsigned int cpu = ANY, Tn & ... an): Fixed_CPU(p, cpu), _affinity(~0UL) {}
+
+    unsigned long affinity() const { return _affinity; }
+    void affinity(unsigned long mask) { _affinity = mask; }
+    bool affine(unsigned int cpu) const { return _affinity & (1UL << cpu); }
+
+protected:
+    unsigned long _affinity;
+};
+
+// Global Round-Robin (a single queue shared by all CPUs, each with its own chosen thread)
+// Any CPU can run any thread, so a burst of wakeups spreads over all of them instead of
+// piling up on the queue of the CPU that created the threads
+class GRR: public RR
+{
+public:
+    static const bool migrating = true;
+    static const bool banded = false; // heads are taken from a single rank-ordered list
+    static const unsigned int HEADS = Traits<Build>::CPUS;
+
+public:
+    template <typename ... Tn>
+    GRR(int p = NORMAL, Tn & ... an): RR(p) {}
+
+    static unsigned int current_head() { return CPU::id(); }
+};
+
+// Global EDF (the earliest deadlines run on all CPUs, see GRR)
+class GEDF: public EDF
+{
+public:
+    static const bool migrating = true;
+    static const unsigned int HEADS = Traits<Build>::CPUS;
+
+public:
+    GEDF(int p = APERIODIC): EDF(p) {}
+    GEDF(const Microsecond & p, const Microsecond & d = SAME, const Microsecond & c = UNKNOWN, unsigned int cpu = ANY)
+    : EDF(p, d, c, cpu) {}
+
+    static unsigned int current_head() { return CPU::id(); }
+};
+
 __END_SYS
 
+__BEGIN_UTIL
+
+// Partitioned criteria keep a sublist per CPU, each either rank-ordered or bitmap-indexed
+template<typename T>
+class Scheduling_Queue<T, Fixed_CPU>:
+public Scheduling_Multilist<T, Fixed_CPU, typename Scheduling_Element<T, Fixed_CPU>::Result,
+                            typename IF<Fixed_CPU::banded, Bitmap_Scheduling_List<T, Fixed_CPU, typename Scheduling_Element<T, Fixed_CPU>::Result>,
+                                                      Scheduling_List<T, Fixed_CPU, typename Scheduling_Element<T, Fixed_CPU>::Result>>::Result> {};
+
+template<typename T>
+class Scheduling_Queue<T, CPU_Affinity>:
+public Scheduling_Multilist<T, CPU_Affinity, typename Scheduling_Element<T, CPU_Affinity>::Result,
+                            typename IF<CPU_Affinity::banded, Bitmap_Scheduling_List<T, CPU_Affinity, typename Scheduling_Element<T, CPU_Affinity>::Result>,
+                                                      Scheduling_List<T, CPU_Affinity, typename Scheduling_Element<T, CPU_Affinity>::Result>>::Result> {};
+
+// Global criteria share a single list with one chosen element per CPU
+template<typename T>
+class Scheduling_Queue<T, GRR>: public Multihead_Scheduling_List<T, GRR, typename Scheduling_Element<T, GRR>::Result> {};
+
+template<typename T>
+class Scheduling_Queue<T, GEDF>: public Multihead_Scheduling_List<T, GEDF, typename Scheduling_Element<T, GEDF>::Result> {};
+
+__END_UTIL
+
 #endif
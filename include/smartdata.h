@@ -0,0 +1,173 @@
+// EPOS SmartData Declarations
+
+#ifndef __smartdata_h
+#define __smartdata_h
+
+#include <utility/observer.h>
+#include <utility/predictor.h>
+#include <time.h>
+#include <transducer.h>
+
+__BEGIN_SYS
+
+// Data of a transducer (see transducer.h) kept with the time it was sensed at, so reads within its expiry don't go to
+// the device (and its bus) again. Transmissions are suppressed while the predictor selected in Traits<SmartData>
+// (Traits<Build>::LVP so far) stays within its configured error of the samples: interested parties then predict the
+// values with the model they got with the last transmission. With NONE, every sample is transmitted.
+class SmartData
+{
+public:
+    static const unsigned char PREDICTOR = Traits<SmartData>::PREDICTOR;
+
+    typedef Time_Base Time;     // in us since boot
+    typedef Microsecond Expiry;
+
+protected:
+    SmartData() {}
+
+    static Time now() { return S::Time::us(TSC::time_stamp()); }
+};
+
+// The producing end, which owns the transducer. With a "period", an Alarm samples it at that rate, in interrupt
+// context, so sense() must then be short enough for that. Each transmission is a notify() to the attached Observers
+// (e.g. Interested_SmartData), which run in the context of the sampling. Network is just a tag so far, since there is
+// no TSTP to carry transmissions to other nodes in this tree.
+template<typename Transducer, typename Network>
+class Responsive_SmartData: public SmartData, public Observed
+{
+    friend class Interested_SmartData<Transducer, Network>;
+
+    static_assert(PREDICTOR != Traits<Build>::DBP, "DBP is not usable with SmartData yet");
+
+public:
+    typedef typename Transducer::Value Value;
+    typedef typename Select_Predictor<PREDICTOR>::template Predictor<Time, Value> Predictor;
+    typedef typename Predictor::Model Model;
+    typedef typename Predictor::Configuration Configuration;
+
+public:
+    Responsive_SmartData(Transducer * transducer, const Expiry & expiry, const Microsecond & period = 0,
+                         const Configuration & config = Configuration())
+    : _transducer(transducer), _expiry(expiry), _value(0), _time(0), _predictor(config, false), _alarm(0), _samples(0),
+      _transmissions(0) {
+        db<SmartData>(TRC) << "Responsive_SmartData(t=" << transducer << ",x=" << expiry << ",p=" << period << ") => "
+                           << this << endl;
+
+        if(period)
+            _alarm = new Alarm(period, Delegate::bind<Responsive_SmartData, &Responsive_SmartData::update>(this),
+                               INFINITE);
+    }
+    ~Responsive_SmartData() {
+        db<SmartData>(TRC) << "~Responsive_SmartData(this=" << this << ")" << endl;
+
+        if(_alarm)
+            delete _alarm;
+    }
+
+    // The cached value, unless it has expired
+    Value value() {
+        if(expired())
+            update();
+        return _value;
+    }
+    operator Value() { return value(); }
+
+    Time time() const { return _time; }
+    const Expiry & expiry() const { return _expiry; }
+    bool expired() const { return !_samples || (now() - _time > _expiry); }
+
+    // The model interested parties would get now (with a predictor)
+    const Model & model() const { return _predictor.model(); }
+
+    unsigned long samples() const { return _samples; }
+    unsigned long transmissions() const { return _transmissions; }
+
+private:
+    void update() {
+        Value v = _transducer->sense();
+        Time t = now();
+
+        bool disabled = CPU::int_disabled();
+        if(!disabled)
+            CPU::int_disable();
+        _value = v;
+        _time = t;
+        _samples++;
+        bool predicted = (PREDICTOR != Traits<Build>::NONE) && _predictor.trickle(t, v);
+        if(!predicted)
+            _transmissions++;
+        if(!disabled)
+            CPU::int_enable();
+
+        db<SmartData>(INF) << "Responsive_SmartData::update(v=" << v << ",t=" << t << ",p=" << predicted << ")" << endl;
+
+        if(!predicted)
+            notify();
+    }
+
+private:
+    Transducer * _transducer;
+    Expiry _expiry;
+    Value _value;
+    Time _time;
+    Predictor _predictor;
+    Alarm * _alarm;
+    unsigned long _samples;
+    unsigned long _transmissions;
+};
+
+// The consuming end, fed by the transmissions of a Responsive_SmartData. Between them, values come from the model of
+// the last one (or are the last value transmitted, without a predictor), so readers never wait for the device.
+template<typename Transducer, typename Network>
+class Interested_SmartData: public SmartData, private Observer
+{
+public:
+    typedef Responsive_SmartData<Transducer, Network> Responsive;
+    typedef typename Responsive::Value Value;
+    typedef typename Responsive::Predictor Predictor;
+
+public:
+    Interested_SmartData(Responsive * origin)
+    : _origin(origin), _value(0), _time(0), _predictor(typename Predictor::Configuration(), false), _updates(0) {
+        db<SmartData>(TRC) << "Interested_SmartData(o=" << origin << ") => " << this << endl;
+
+        _origin->attach(this);
+    }
+    ~Interested_SmartData() {
+        db<SmartData>(TRC) << "~Interested_SmartData(this=" << this << ")" << endl;
+
+        _origin->detach(this);
+    }
+
+    Value value() const {
+        if((PREDICTOR != Traits<Build>::NONE) && _updates)
+            return _predictor.predict(now());
+        return _value;
+    }
+    operator Value() const { return value(); }
+
+    // Of the last transmission
+    Time time() const { return _time; }
+
+    unsigned long updates() const { return _updates; }
+
+private:
+    void update(Observed * o) {
+        _value = _origin->_value;
+        _time = _origin->_time;
+        if(PREDICTOR != Traits<Build>::NONE)
+            _predictor.update(_origin->model(), false);
+        _updates++;
+    }
+
+private:
+    Responsive * _origin;
+    Value _value;
+    Time _time;
+    Predictor _predictor;
+    unsigned long _updates;
+};
+
+__END_SYS
+
+#endif
@@ -5,6 +5,9 @@
 
 #include <architecture.h>
 #include <utility/handler.h>
+#include <utility/list.h>
+#include <utility/slab.h>
+#include <utility/contention.h>
 #include <process.h>
 
 __BEGIN_SYS
@@ -14,6 +17,8 @@ class Synchronizer_Common
 protected:
     typedef Thread::Queue Queue;
 
+    static const bool handoff = Traits<Synchronizer>::handoff;
+
 protected:
     Synchronizer_Common() {}
     ~Synchronizer_Common() { begin_atomic(); wakeup_all(); end_atomic(); }
@@ -22,59 +27,376 @@ protected:
     bool tsl(volatile bool & lock) { return CPU::tsl(lock); }
     int finc(volatile int & number) { return CPU::finc(number); }
     int fdec(volatile int & number) { return CPU::fdec(number); }
+    int cas(volatile int & value, int compare, int replacement) { return CPU::cas(value, compare, replacement); }
 
     // Thread operations
     void begin_atomic() { Thread::lock(); }
     void end_atomic() { Thread::unlock(); }
 
     void sleep() { Thread::sleep(&_queue); }
-    void wakeup() { Thread::wakeup(&_queue); }
+    bool sleep(const Microsecond & timeout) { return Thread::sleep(&_queue, timeout); } // false if timed out
+    void wakeup() { wakeup(&_queue); }
     void wakeup_all() { Thread::wakeup_all(&_queue); }
 
+    // For synchronizers with more than one queue
+    void sleep(Queue * q) { Thread::sleep(q); }
+    bool sleep(Queue * q, const Microsecond & timeout) { return Thread::sleep(q, timeout); }
+    void wakeup(Queue * q) { if(handoff) Thread::handoff(q); else Thread::wakeup(q); }
+    void wakeup_all(Queue * q) { Thread::wakeup_all(q); }
+    void requeue(Queue * from, Queue * to) { Thread::requeue(from, to); }
+
+    // Priority inversion control (locking handled by caller)
+    Thread * running() { return Thread::running(); }
+    void rank(Thread * t, int p) { t->rank(p); }
+    void reschedule() { if(Thread::preemptive) Thread::reschedule(); }
+
+    // Contention profiling (see utility/contention.h): contended() before waiting, acquired() once the lock is held
+    Contention::Time_Stamp contended() { return _statistics.contended(_queue.size() + 1); }
+    void acquired(const Contention::Time_Stamp & since = 0, const void * caller = __builtin_return_address(0)) {
+        _statistics.acquired(this, since, caller);
+    }
+    const Contention::Statistics & statistics() const { return _statistics; }
+
 protected:
     Queue _queue;
+    Contention::Statistics _statistics;
 };
 
 
-class Mutex: protected Synchronizer_Common
+// Uncontended lock() and unlock() take a lock-free fast path on _state; only contention enters the kernel
+// Adaptive Mutexes (on SMP) track their owner and spin for a while, instead of sleeping, as long as it runs on another
+// CPU, since it might release the lock before two context switches could take place
+class Mutex: protected Synchronizer_Common, public Slab_Allocated<Mutex>
 {
+    friend class Condition;     // for wait morphing
+
+private:
+    static const bool adaptive = Traits<Synchronizer>::adaptive && Traits<Thread>::smp;
+    static const unsigned int SPINS = Traits<Synchronizer>::SPINS;
+
+    enum {
+        FREE,
+        LOCKED,
+        CONTENDED   // locked, and there might be threads sleeping on _queue
+    };
+
 public:
     Mutex();
     ~Mutex();
 
+    void lock();
+    bool try_lock();
+    void unlock();
+
+    using Synchronizer_Common::statistics;
+
+private:
+    bool spin();
+    void own() { if(adaptive) _owner = running(); }
+
+private:
+    volatile int _state;
+    Thread * volatile _owner;   // only tracked if adaptive
+};
+
+
+// Mutexes that bound priority inversion by raising the priority of the owner while it holds the lock.
+// Under Priority Inheritance, the owner runs with the priority of the highest-priority thread waiting
+// for it; under Priority Ceiling, it runs at least with the ceiling given at construction.
+// The owner's priority is restored on unlock() to the value it had when it got the lock.
+class Inheritance_Mutex: protected Synchronizer_Common
+{
+public:
+    Inheritance_Mutex();
+    ~Inheritance_Mutex();
+
+    void lock();
+    void unlock();
+
+private:
+    volatile bool _locked;
+    Thread * _owner;
+    int _priority;
+};
+
+
+class Ceiling_Mutex: protected Synchronizer_Common
+{
+public:
+    Ceiling_Mutex(int ceiling = Thread::HIGH);
+    ~Ceiling_Mutex();
+
     void lock();
     void unlock();
 
 private:
     volatile bool _locked;
+    int _ceiling;
+    int _priority;
 };
 
 
-class Semaphore: protected Synchronizer_Common
+// p() on a positive value and v() with no sleepers take a lock-free fast path; a negative _value counts the sleepers
+class Semaphore: protected Synchronizer_Common, public Slab_Allocated<Semaphore>
 {
 public:
     Semaphore(int v = 1);
     ~Semaphore();
 
     void p();
+    bool p(const Microsecond & timeout);
+    bool try_p();
     void v();
 
+    using Synchronizer_Common::statistics;
+
+private:
+    bool take();
+
 private:
     volatile int _value;
 };
 
 
+// Readers share the lock, while writers hold it alone. Waiting writers keep new readers out (writer preference) and
+// sleep on _queue, readers on _read_queue. The lock is handed over on release: to the next writer, if any, or else
+// to all waiting readers at once. Readers take a lock-free fast path on _state unless writers wait, and so does the
+// release of any reader but the last one.
+class RW_Lock: protected Synchronizer_Common
+{
+private:
+    enum {
+        WRITER = -1     // _state: number of readers holding the lock, or WRITER
+    };
+
+public:
+    RW_Lock();
+    ~RW_Lock();
+
+    void read_lock();
+    bool try_read_lock();
+    void read_unlock();
+
+    void write_lock();
+    bool try_write_lock();
+    void write_unlock();
+
+private:
+    volatile int _state;
+    volatile int _writers;      // waiting on _queue
+    volatile int _readers;      // waiting on _read_queue
+    Queue _read_queue;
+};
+
+
+// All threads but the last one to reach wait() sleep, and the last one releases them with a single wakeup_all(), so
+// a phase costs one reschedule instead of one per waiter. wait() returns true for the last one (e.g. for the serial
+// part of a phase) and the Barrier is ready for the next phase as soon as it returns.
+class Barrier: protected Synchronizer_Common
+{
+public:
+    Barrier(unsigned int parties);
+    ~Barrier();
+
+    bool wait();
+
+    unsigned int parties() const { return _parties; }
+
+private:
+    unsigned int _parties;
+    volatile unsigned int _arrived;
+};
+
+
+// A group of event flags, on which threads wait for ANY or ALL of the bits of a mask, set() either by threads or by
+// ISRs through an Event_Flags_Handler. Each waiter sleeps on a queue of its own, so set() only wakes up those whose
+// condition holds, all with a single reschedule. They all see the same flags and, if so asked, consume the bits that
+// satisfied them once the pass is over.
+class Event_Flags: protected Synchronizer_Common
+{
+public:
+    typedef unsigned int Mask;
+
+    enum Mode {
+        ANY,
+        ALL
+    };
+
+private:
+    struct Waiter;
+    typedef Simple_List<Waiter> List;
+
+    struct Waiter {
+        Waiter(Mask m, Mode md, bool c): mask(m), mode(md), consume(c), got(0), link(this) {}
+
+        bool satisfied(Mask flags) const { return (mode == ALL) ? ((flags & mask) == mask) : (flags & mask); }
+
+        Mask mask;
+        Mode mode;
+        bool consume;
+        Mask got;
+        Queue queue;
+        List::Element link;
+    };
+
+public:
+    Event_Flags(Mask flags = 0);
+    ~Event_Flags();
+
+    // Returns the flags that satisfied the wait, or 0 if the group was destroyed or the wait timed out
+    Mask wait(Mask mask, Mode mode = ANY, bool consume = true);
+    Mask wait(Mask mask, const Microsecond & timeout, Mode mode = ANY, bool consume = true);
+
+    void set(Mask mask);
+    void clear(Mask mask);
+    Mask flags() const { return _flags; }
+
+private:
+    bool take(Waiter * w);
+
+private:
+    volatile Mask _flags;
+    List _waiters;
+};
+
+
+// Bounded zero-copy mailbox: messages live in a pool of BUFFERS buffers of T of the mailbox's own, which senders
+// alloc(), fill in place and send() with a rank (lower ranks are received first, in FIFO order among equals), and
+// which receivers give back with free() once they are done, so messages are never copied. alloc() blocks while all
+// buffers are in use (i.e. the mailbox is full) and receive() while no message is queued. send() never blocks, so
+// ISRs can send messages (in buffers from try_alloc()) as well as take them (with try_receive()).
+template<typename T, unsigned int BUFFERS = 16>
+class Mailbox: protected Synchronizer_Common
+{
+private:
+    struct Buffer;
+    typedef Ordered_Queue<Buffer> Messages;
+
+    struct Buffer {
+        Buffer(): link(this), next(0) {}
+
+        T message; // first, so a T * is also a Buffer *
+        typename Messages::Element link;
+        Buffer * next; // in the free list
+    };
+
+public:
+    Mailbox(): _free(0) {
+        db<Synchronizer>(TRC) << "Mailbox(buffers=" << BUFFERS << ",size=" << sizeof(T) << ") => " << this << endl;
+
+        for(unsigned int i = 0; i < BUFFERS; i++)
+            push(&_pool[i]);
+    }
+
+    ~Mailbox() {
+        db<Synchronizer>(TRC) << "~Mailbox(this=" << this << ")" << endl;
+
+        begin_atomic();
+        wakeup_all(&_space);
+        end_atomic();
+    }
+
+    T * alloc() {
+        db<Synchronizer>(TRC) << "Mailbox::alloc(this=" << this << ")" << endl;
+
+        begin_atomic();
+        while(!_free)
+            sleep(&_space);
+        Buffer * b = pop();
+        end_atomic();
+
+        return &b->message;
+    }
+
+    T * try_alloc() {
+        begin_atomic();
+        Buffer * b = _free ? pop() : 0;
+        end_atomic();
+
+        return b ? &b->message : 0;
+    }
+
+    void free(T * message) {
+        db<Synchronizer>(TRC) << "Mailbox::free(this=" << this << ",m=" << message << ")" << endl;
+
+        begin_atomic();
+        push(buffer(message));
+        wakeup(&_space);
+        end_atomic();
+    }
+
+    void send(T * message, int rank = 0) {
+        db<Synchronizer>(TRC) << "Mailbox::send(this=" << this << ",m=" << message << ",r=" << rank << ")" << endl;
+
+        Buffer * b = buffer(message);
+        b->link.rank(rank);
+
+        begin_atomic();
+        _messages.insert(&b->link);
+        wakeup();
+        end_atomic();
+    }
+
+    T * receive() {
+        db<Synchronizer>(TRC) << "Mailbox::receive(this=" << this << ")" << endl;
+
+        begin_atomic();
+        while(_messages.empty())
+            sleep();
+        Buffer * b = _messages.remove()->object();
+        end_atomic();
+
+        return &b->message;
+    }
+
+    T * try_receive() {
+        begin_atomic();
+        Buffer * b = _messages.empty() ? 0 : _messages.remove()->object();
+        end_atomic();
+
+        return b ? &b->message : 0;
+    }
+
+    unsigned int pending() { return _messages.size(); }
+
+private:
+    static Buffer * buffer(T * message) { return reinterpret_cast<Buffer *>(message); }
+
+    // Free list operations (locking handled by caller)
+    void push(Buffer * b) { b->next = _free; _free = b; }
+    Buffer * pop() { Buffer * b = _free; _free = b->next; return b; }
+
+private:
+    Buffer _pool[BUFFERS];
+    Buffer * _free;
+    Messages _messages;
+    Queue _space;       // threads waiting in alloc(), while receivers wait on _queue
+};
+
+
 // This is actually no Condition Variable
 // check http://www.cs.duke.edu/courses/spring01/cps110/slides/sem/sld002.htm
+// unless it is bound to a Mutex, which must then be held when calling wait(), signal() and broadcast().
+// wait() releases it atomically and returns with it held again, and signal() and broadcast() move the
+// waiters straight onto the Mutex's queue (wait morphing), so they become READY one at a time as
+// each previous owner unlocks the Mutex instead of all at once just to block on it again.
 class Condition: protected Synchronizer_Common
 {
 public:
-    Condition();
+    Condition(Mutex * mutex = 0);
     ~Condition();
 
     void wait();
+    bool wait(const Microsecond & timeout);
     void signal();
     void broadcast();
+
+private:
+    void release();
+    void morph(bool all);
+
+private:
+    Mutex * _mutex;
 };
 
 
@@ -104,6 +426,20 @@ private:
     Semaphore * _handler;
 };
 
+// An event handler that sets a group of event flags (see handler.h)
+class Event_Flags_Handler: public Handler
+{
+public:
+    Event_Flags_Handler(Event_Flags * h, Event_Flags::Mask mask) : _handler(h), _mask(mask) {}
+    ~Event_Flags_Handler() {}
+
+    void operator()() { _handler->set(_mask); }
+
+private:
+    Event_Flags * _handler;
+    Event_Flags::Mask _mask;
+};
+
 // An event handler that triggers a condition variable (see handler.h)
 class Condition_Handler: public Handler
 {
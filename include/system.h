@@ -14,10 +14,15 @@ class Application
 {
     friend class Init_Application;
     friend void * ::malloc(size_t);
+    friend void * ::aligned_alloc(size_t, size_t);
     friend void ::free(void *);
 
+public:
+    static Heap * heap(); // the one malloc() and new use
+
 private:
     static void init();
+    static Heap * task_heap(); // see Task::heap()
 
 private:
     static char _preheap[sizeof(Heap)];
@@ -30,7 +35,9 @@ class System
     friend class Init_Application;                                              // for _heap with multiheap = false
     friend void CPU::Context::load() const volatile;
     friend void * ::malloc(size_t);						// for _heap
+    friend void * ::aligned_alloc(size_t, size_t);				// for _heap
     friend void ::free(void *);							// for _heap
+    friend void * ::realloc(void *, size_t);					// for _heap
     friend void * ::operator new(size_t, const EPOS::System_Allocator &);	// for _heap
     friend void * ::operator new[](size_t, const EPOS::System_Allocator &);	// for _heap
     friend void ::operator delete(void *);					// for _heap
@@ -38,6 +45,13 @@ class System
 
 public:
     static System_Info * const info() { assert(_si); return _si; }
+    static Heap * heap() { return _heap; }
+
+    // Marks the beginning of a boot phase (see System_Info::Boot_Profile)
+    static void profile(const System_Info::Boot_Profile::Phase & p) {
+        if(Traits<Init>::profiled)
+            _si->bp.stamp[p] = TSC::time_stamp();
+    }
 
 private:
     static void init();
@@ -49,17 +63,31 @@ private:
     static Heap * _heap;
 };
 
+inline Heap * Application::heap()
+{
+    if(!Traits<System>::multiheap)
+        return System::heap();
+
+    Heap * heap = Traits<System>::task_heaps ? task_heap() : 0;
+    return heap ? heap : _heap;
+}
+
 __END_SYS
 
 extern "C"
 {
     // Standard C Library allocators
+    // Being inline, they take CPU::pc() as the allocation site for Heap_Profiler (see utility/heap.h)
     inline void * malloc(size_t bytes) {
         __USING_SYS;
+        void * ptr;
         if(Traits<System>::multiheap)
-            return Application::_heap->alloc(bytes);
+            ptr = Application::heap()->alloc(bytes);
         else
-            return System::_heap->alloc(bytes);
+            ptr = System::_heap->alloc(bytes);
+        if(Traits<System>::heap_profiled)
+            Heap_Profiler::tag(ptr, CPU::pc());
+        return ptr;
     }
 
     inline void * calloc(size_t n, unsigned int bytes) {
@@ -75,6 +103,38 @@ extern "C"
         else
             Heap::untyped_free(System::_heap, ptr);
     }
+
+    inline void * aligned_alloc(size_t align, size_t bytes) {
+        __USING_SYS;
+        void * ptr;
+        if(Traits<System>::multiheap)
+            ptr = Application::heap()->alloc(bytes, align);
+        else
+            ptr = System::_heap->alloc(bytes, align);
+        if(Traits<System>::heap_profiled)
+            Heap_Profiler::tag(ptr, CPU::pc());
+        return ptr;
+    }
+
+    inline void * memalign(size_t align, size_t bytes) { return aligned_alloc(align, bytes); }
+
+    inline void * realloc(void * ptr, size_t bytes) {
+        __USING_SYS;
+        if(!ptr)
+            return malloc(bytes);
+        if(!bytes) {
+            free(ptr);
+            return 0;
+        }
+        void * moved;
+        if(Traits<System>::multiheap)
+            moved = Heap::typed_realloc(ptr, bytes);
+        else
+            moved = Heap::untyped_realloc(System::_heap, ptr, bytes);
+        if(Traits<System>::heap_profiled)
+            Heap_Profiler::tag(moved, CPU::pc());
+        return moved;
+    }
 }
 
 // C++ dynamic memory allocators and deallocators
@@ -87,11 +147,17 @@ inline void * operator new[](size_t bytes) {
 }
 
 inline void * operator new(size_t bytes, const EPOS::System_Allocator & allocator) {
-    return _SYS::System::_heap->alloc(bytes);
+    void * ptr = _SYS::System::_heap->alloc(bytes);
+    if(_SYS::Traits<_SYS::System>::heap_profiled)
+        _SYS::Heap_Profiler::tag(ptr, _SYS::CPU::pc());
+    return ptr;
 }
 
 inline void * operator new[](size_t bytes, const EPOS::System_Allocator & allocator) {
-    return _SYS::System::_heap->alloc(bytes);
+    void * ptr = _SYS::System::_heap->alloc(bytes);
+    if(_SYS::Traits<_SYS::System>::heap_profiled)
+        _SYS::Heap_Profiler::tag(ptr, _SYS::CPU::pc());
+    return ptr;
 }
 
 // Delete cannot be declared inline due to virtual destructors
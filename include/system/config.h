@@ -89,6 +89,7 @@ namespace EPOS {
 #define __UART_H                __HEADER_MACH(uart)
 #define __DISPLAY_H             __HEADER_MACH(display)
 #define __KEYBOARD_H            __HEADER_MACH(keyboard)
+#define __NIC_H                 __HEADER_MACH(nic)
 #define __SCRATCHPAD_H          __HEADER_MACH(scratchpad)
 #define __FPGA_H                __HEADER_MACH(fpga)
 
@@ -123,6 +124,7 @@ namespace EPOS {
 #define __ADC_H                 __HEADER_MACH(adc)
 #define __PWM_H                 __HEADER_MACH(pwm)
 #define __WATCHDOG_H            __HEADER_MACH(watchdog)
+#define __TRNG_H                __HEADER_MACH(trng)
 
 #define __ACCELEROMETER_H       __HEADER_TRAN(accelerometer)
 #define __GYROSCOPE_H           __HEADER_TRAN(gyroscope)
@@ -141,8 +143,10 @@ namespace EPOS {
 #define __PMU_H                 __HEADER_ARCH(pmu)
 
 #define __UART_H                __HEADER_MACH(uart)
+#define __NIC_H                 __HEADER_MACH(nic)
 #define __ethernet__
 #define __AES_H                 __HEADER_MACH(aes)
+#define __FPGA_H                __HEADER_MACH(fpga)
 #define __ipv4__
 #endif
 
@@ -164,6 +168,7 @@ namespace EPOS {
 #define __PMU_H                 __HEADER_ARCH(pmu)
 
 #define __UART_H                __HEADER_MACH(uart)
+#define __TRNG_H                __HEADER_MACH(trng)
 #endif
 
 #ifdef __sifive_e__
@@ -67,6 +67,25 @@ public:
         PAddr free3_top;        // Third free memory chunk top address (zero if not used)
     };
 
+    // Time stamps (TSC::time_stamp()) taken at the beginning of each boot phase if Traits<Init>::profiled, from
+    // SETUP to Init_End, which prints them (see System::profile()). On machines whose TSC only starts counting when
+    // Machine::init() initializes it, the earlier phases read as 0 or as whatever the boot loader left in it.
+    struct Boot_Profile
+    {
+        enum Phase {
+            SETUP,
+            INIT_SYSTEM,        // CPU::init() included
+            HEAP,
+            MACHINE,
+            SYSTEM,
+            INIT_APPLICATION,   // only before Init_End in the LIBRARY and BUILTIN modes
+            INIT_END,
+            PHASES
+        };
+
+        unsigned long long stamp[PHASES];
+    };
+
     // Load Map (built by SETUP)
     struct Library_Load_Map
     {
@@ -369,6 +369,21 @@ template<> struct LARGER<unsigned short> { typedef unsigned int Result; };
 template<> struct LARGER<unsigned int> { typedef unsigned long long Result; };
 template<> struct LARGER<unsigned long> { typedef unsigned long long Result; };
 
+// Returns T without a reference
+template<typename T> struct REMOVE_REFERENCE { typedef T Result; };
+template<typename T> struct REMOVE_REFERENCE<T &> { typedef T Result; };
+template<typename T> struct REMOVE_REFERENCE<T &&> { typedef T Result; };
+
+// Rvalue casts, like std::move() and std::forward(), so objects are moved along instead of copied
+template<typename T>
+constexpr typename REMOVE_REFERENCE<T>::Result && move(T && t) { return static_cast<typename REMOVE_REFERENCE<T>::Result &&>(t); }
+
+template<typename T>
+constexpr T && forward(typename REMOVE_REFERENCE<T>::Result & t) { return static_cast<T &&>(t); }
+
+template<typename T>
+constexpr T && forward(typename REMOVE_REFERENCE<T>::Result && t) { return static_cast<T &&>(t); }
+
 __END_SYS
 
 #endif
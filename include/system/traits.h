@@ -6,6 +6,7 @@ __BEGIN_UTIL
 // Utilities
 template<unsigned int KEY_SIZE> class SWAES;
 template<typename T, unsigned int LENGHT> class Array;
+class AT_Engine;
 class Bitmaps;
 class Ciphers;
 class CRC;
@@ -13,13 +14,19 @@ class Debug;
 class ELF;
 class Handler;
 class Lists;
+class Log;
+class Call_Tracer;
+class PCAP;
 class Heaps;
 class Observers;
 class OStream;
 class Predictors;
 class Queues;
 class Random;
+class RCU;
 class Spin;
+class Ticket_Spin;
+class MCS_Spin;
 class SREC;
 class Vectors;
 template<typename> class Scheduler;
@@ -61,9 +68,11 @@ class Keyboard;
 class Serial_Keyboard;
 class Scratchpad;
 class Watchdog;
+class TRNG;
 class GPIO;
 class I2C;
 class ADC;
+class PWM;
 class FPGA;
 template<unsigned int KEY_SIZE> class HWAES;
 class Ethernet;
@@ -98,8 +107,10 @@ class Application;
 
 class Thread;
 class Active;
+class Thread_Pool;
 class Periodic_Thread;
 class RT_Thread;
+class Reservation;
 class Task;
 class Priority;
 class FCFS;
@@ -110,6 +121,7 @@ class EDF;
 class GRR;
 class Fixed_CPU;
 class CPU_Affinity;
+class Reserved;
 class GEDF;
 class PEDF;
 class CEDF;
@@ -130,8 +142,12 @@ class Chronometer;
 class Alarm;
 class Delay;
 
+class AIO;
+
 template<typename T> class Clerk;
 class Monitor;
+class Governor;
+class Energy_Meter;
 
 class Network;
 class ELP;
@@ -483,6 +499,8 @@ struct Traits {
     static const bool monitored = false;
     static const bool debugged = true;
     static const bool hysterically_debugged = false;
+    static const bool call_traced = false;
+    static const unsigned int STATIC_OBJECTS = 0;
 
     typedef ALIST<> ASPECTS;
 };
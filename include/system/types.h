@@ -35,6 +35,8 @@ __END_API
 extern "C"
 {
     void * malloc(size_t);
+    void * aligned_alloc(size_t, size_t);
+    void * realloc(void *, size_t);
     void free(void *);
 }
 
@@ -150,6 +152,9 @@ private:
     Time_Base _time;
 };
 
+// Nanoseconds are only used for monotonic time (see Time) and are always 64-bit
+typedef unsigned long long Nanosecond;
+
 typedef unsigned long Hertz;
 typedef unsigned long PPM; // parts per million
 typedef unsigned long long PPB; // parts per billion
@@ -0,0 +1,56 @@
+// EPOS Thread Pool Declarations
+
+#ifndef __thread_pool_h
+#define __thread_pool_h
+
+#include <process.h>
+#include <synchronizer.h>
+
+__BEGIN_SYS
+
+// A fixed set of worker threads (Active objects) running jobs submitted to a bounded queue
+// Jobs are Handlers owned by the submitter, which must keep them alive until they run
+// Idle workers sleep on a semaphore, so dispatching a job costs a queue push instead of a thread creation
+class Thread_Pool
+{
+private:
+    static const unsigned int WORKERS = Traits<Thread_Pool>::WORKERS;
+    static const unsigned int JOBS = Traits<Thread_Pool>::JOBS;
+
+    class Worker: public Active
+    {
+    public:
+        Worker(Thread_Pool * pool): _pool(pool) {}
+
+        int run() { return _pool->work(); }
+
+    private:
+        Thread_Pool * _pool;
+    };
+
+public:
+    Thread_Pool();
+    ~Thread_Pool();
+
+    void submit(Handler * job);
+    bool try_submit(Handler * job);
+
+private:
+    void push(Handler * job);
+    Handler * pop();
+
+    int work();
+
+private:
+    Handler * _jobs[JOBS];
+    unsigned int _head;
+    unsigned int _tail;
+    Mutex _mutex;
+    Semaphore _slots;
+    Semaphore _pending;
+    Worker * _workers[WORKERS];
+};
+
+__END_SYS
+
+#endif
@@ -7,7 +7,9 @@
 #include <machine/timer.h>
 #include <process.h>
 #include <utility/queue.h>
+#include <utility/wheel.h>
 #include <utility/handler.h>
+#include <utility/slab.h>
 
 __BEGIN_SYS
 
@@ -28,18 +30,93 @@ public:
 };
 
 
-class Alarm
+// Monotonic time since boot, derived from the TSC. Conversions are a multiply and a shift with factors
+// computed at initialization from TSC::frequency(), so they are cheap enough for hot paths
+class Time
+{
+    friend class System;                        // for init()
+
+public:
+    typedef TSC::Time_Stamp Time_Stamp;
+
+private:
+    // Converts TSC counts into units of which there are "to" per second as (ts * mult) >> shift, with the
+    // product split in 32-bit halves so it never overflows. Shift is the largest (up to 32) to fit mult in 32 bits
+    class Scale
+    {
+    public:
+        void calibrate(const Hertz & from, unsigned long long to) {
+            for(_shift = 32; _shift && (((to << _shift) / from) >> 32); _shift--);
+            _mult = (to << _shift) / from;
+        }
+
+        unsigned long long operator()(const Time_Stamp & ts) const {
+            unsigned long long hi = (ts >> 32) * _mult;
+            unsigned long long lo = (ts & 0xffffffff) * _mult;
+            return (hi << (32 - _shift)) + (lo >> _shift);
+        }
+
+    private:
+        unsigned int _mult;
+        unsigned int _shift;
+    };
+
+public:
+    Time() {}
+
+    static Nanosecond now() { return ns(TSC::time_stamp()); }
+
+    static Nanosecond ns(const Time_Stamp & ts) { return _ns(ts); }
+    static Microsecond us(const Time_Stamp & ts) { return _us(ts); }
+
+private:
+    static void init();
+
+private:
+    static Scale _ns;
+    static Scale _us;
+};
+
+
+class Alarm: public Slab_Allocated<Alarm>
 {
     friend class System;                        // for init()
     friend class Alarm_Chronometer;             // for elapsed()
     friend class FCFS;                          // for ticks() and elapsed()
+    friend class EDF;                           // for ticks() and elapsed()
+    friend class Periodic_Thread;               // for times()
+    friend class Protothread;                   // for Tick, ticks() and elapsed()
+    friend class Protothread_Scheduler;         // for Tick, elapsed() and timer_period()
+    friend class Thread;                        // for sleep()
 
 private:
     typedef Timer_Common::Tick Tick;
-    typedef Relative_Queue<Alarm, Tick> Queue;
+    typedef TSC::Time_Stamp Time_Stamp;
+
+    // In one-shot mode, alarms are kept by absolute deadline in TSC counts and the timer is programmed to interrupt at the
+    // earliest one, so they aren't rounded to ticks. Ticks still drive elapsed() and the scheduler
+    static const bool one_shot = Traits<Alarm>::one_shot && Alarm_Timer::ONE_SHOT;
+    typedef IF<one_shot, Ordered_Queue<Alarm, Time_Stamp>, Relative_Queue<Alarm, Tick>>::Result Queue;
+    typedef IF<one_shot, Time_Stamp, Tick>::Result Units; // TSC counts would overflow a 32-bit Tick in about a second
+    typedef Simple_List<Alarm> Fired;
+
+    // With the timing wheel, ranks are absolute deadlines (in ticks since boot) instead of deltas to the previous alarm
+    static const bool wheel = Traits<Alarm>::wheel && !one_shot;
+    typedef Timing_Wheel<Alarm, Tick, Queue::Element, wheel ? Traits<Alarm>::WHEEL_SLOTS : 1> Wheel;
+
+    // Tickless idle only works for a single CPU, since alarms created on other CPUs would not reprogram the sleeping one's timer
+    static const bool tickless = Traits<Alarm>::tickless && !Traits<System>::multicore && !one_shot;
+
+    // Local alarms are kept in a queue (with its own lock) for each CPU, are armed on the CPU that creates them and are
+    // served by its own timer interrupts, so cores don't contend for one queue. Ticks (elapsed()) still come from CPU 0
+    static const bool local = Traits<Alarm>::per_cpu && Traits<System>::multicore && !one_shot && Alarm_Timer::LOCAL;
+    static const unsigned int QUEUES = local ? Traits<Build>::CPUS : 1;
 
 public:
-    Alarm(const Microsecond & time, Handler * handler, unsigned int times = 1);
+    // Alarms with some "slack" may be postponed by up to that much to expire along with others
+    // and save interrupts (i.e. wakeups in tickless idle). The handler is a Delegate, so a plain function or one bound
+    // to an object will do, besides a Handler.
+    Alarm(const Microsecond & time, const Delegate & handler, unsigned int times = 1, const Microsecond & slack = 0);
     ~Alarm();
 
     const Microsecond & period() const { return _time; }
@@ -59,23 +136,52 @@ private:
     static Microsecond timer_period() { return 1000000 / frequency(); }
     static Tick ticks(const Microsecond & time) { return (time + timer_period() / 2) / timer_period(); }
 
-    static void lock() { Thread::lock(); }
-    static void unlock() { Thread::unlock(); }
+    // Periods are kept in TSC counts in one-shot mode and in ticks otherwise
+    static Units units(const Microsecond & time) { return one_shot ? Units(Time_Stamp(time) * TSC::frequency() / 1000000) : ticks(time); }
+
+    // TSC::time_stamp() might be narrower than Time_Stamp (e.g. the 32-bit MTIME window on RISC-V), so it is extended
+    // with the previous reading, which the tick handler refreshes often enough for it to never wrap twice in between
+    static Time_Stamp now() { _now += static_cast<unsigned int>(TSC::time_stamp() - _now); return _now; }
+
+    void arm() { arm(_ticks, one_shot ? now() : Time_Stamp(0)); }
+    void arm(const Units & ticks, const Time_Stamp & base);
+    void disarm();
+
+    // Periodic alarms are rearmed from the tick they were due at, so slack doesn't add up
+    void rearm() { arm((_ticks > _late) ? _ticks - _late : 1, Time_Stamp(0)); }
+
+    // Alarms have their own lock, so timer interrupts on one CPU don't contend with scheduling on another
+    static void lock(unsigned int q) { Thread::lock(&_lock[q]); }
+    static void unlock(unsigned int q) { Thread::unlock(&_lock[q]); }
+
+    static unsigned int queue() { return local ? CPU::id() : 0; }
 
     static void handler(IC::Interrupt_Id i);
+    static void expire(IC::Interrupt_Id i);
+    static void dispatch(unsigned int q);
+    static void sleep();
 
     static void init();
 
 private:
     Microsecond _time;
-    Handler * _handler;
+    Delegate _handler;
     unsigned int _times;
-    Tick _ticks;
+    Units _ticks;
+    Units _slack;
+    Units _late;    // how much slack the current expiration took
     Queue::Element _link;
+    Fired::Element _fired_link;
+    unsigned int _queue;
 
     static Alarm_Timer * _timer;
     static volatile Tick _elapsed;
-    static Queue _request;
+    static Time_Stamp _now;
+    static volatile Time_Stamp _latency;    // of the wake-ups of delay()
+    static Queue _request[QUEUES];
+    static Wheel _wheel[QUEUES];
+    static Fired _fired[QUEUES];
+    static Thread::Kernel_Lock _lock[QUEUES];
 };
 
 
@@ -104,7 +210,7 @@ public:
     void lap() { if(_start != 0) _stop = tsc.time_stamp(); }
     void stop() { lap(); }
 
-    Microsecond read() { return ticks() * 1000000 / frequency(); }
+    Microsecond read() { return Time::us(ticks()); }
 
 private:
     Time_Stamp ticks() {
@@ -0,0 +1,91 @@
+// EPOS Transducer Mediators Declarations
+
+#ifndef __transducer_h
+#define __transducer_h
+
+#include <machine.h>
+
+__BEGIN_SYS
+
+// Transducers give SmartData (see smartdata.h) a Value type and a sense() method that reads it once from the device
+
+// The temperature of the machine itself (see Machine::temperature()), in m°C
+class Thermometer
+{
+public:
+    typedef int Value;
+
+public:
+    Thermometer() {}
+
+    Value sense() { return Machine::temperature(); }
+};
+
+__END_SYS
+
+#ifdef __I2C_H
+#include <machine/i2c.h>
+#include <machine/engine/si7020.h>
+
+__BEGIN_SYS
+
+// Temperature of a SI7020 on an I2C bus (see SI7020::temperature())
+class Alternate_Thermometer
+{
+public:
+    typedef int Value;
+
+public:
+    Alternate_Thermometer(I2C * i2c): _si7020(i2c) {}
+
+    Value sense() { return _si7020.temperature(); }
+
+private:
+    SI7020 _si7020;
+};
+
+// Relative humidity of a SI7020 on an I2C bus, in %
+class Hygrometer
+{
+public:
+    typedef int Value;
+
+public:
+    Hygrometer(I2C * i2c): _si7020(i2c) {}
+
+    Value sense() { return _si7020.humidity(); }
+
+private:
+    SI7020 _si7020;
+};
+
+__END_SYS
+
+#endif
+
+#ifdef __UART_H
+#include <machine/uart.h>
+#include <machine/engine/cm1101.h>
+
+__BEGIN_SYS
+
+// CO2 concentration of a CM1101 on a UART, in PPM
+class CO2_Sensor
+{
+public:
+    typedef int Value;
+
+public:
+    CO2_Sensor(UART * uart): _cm1101(uart) {}
+
+    Value sense() { return _cm1101.sample(); }
+
+private:
+    CM1101 _cm1101;
+};
+
+__END_SYS
+
+#endif
+
+#endif
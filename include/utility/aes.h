@@ -10,41 +10,58 @@
 
 __BEGIN_UTIL
 
+class AES_GCM;
+
 // EPOS 128-bit Advanced Encryption Standard (AES) Software Implementation
-// Adapted from https://github.com/kokke/tiny-AES128-C
+// Rounds are table-driven: SubBytes, ShiftRows and MixColumns are merged into four lookups per column in the T-tables
+// (Te for encryption, Td for the equivalent inverse cipher), built from the S-boxes on first use. The key schedule is
+// only expanded again when a different key is given, so a stream of blocks under the same key pays it once.
+// On ARMv8 with the Crypto Extensions, blocks go through AESE/AESMC (AESD/AESIMC) instead.
+// Blocks that do not depend on each other (ECB encryption and CTR keystream) go PARALLEL at a time, with the rounds of
+// all of them interleaved, so the lookups (or AESE latencies) of one block overlap with those of the others.
 template<>
 class SWAES<16>: public AES_Common
 {
+    friend class AES_GCM;
+
 private:
-    static const unsigned int Nb = 4; // number of columns comprising a _state
+    static const unsigned int Nb = 4; // number of columns comprising a state
     static const unsigned int Nk = 4; // number of 32 bit words in a key
     static const int Nr = 10; // number of rounds in AES cipher
 
-    typedef unsigned char State[4][4]; // array holding the intermediate results during decryption
-
 public:
     static const unsigned int KEY_SIZE = 16;
+    static const unsigned int BLOCK_SIZE = 16;
+    static const unsigned int PARALLEL = 4;
 
 public:
-    SWAES(const Mode & m = ECB): _mode(m) {
-        assert((m == ECB) || (m == CBC));
-        for(unsigned int i = 0; i < 23; i++)
-            iv[i] = 0;
+    SWAES(const Mode & m = ECB): _mode(m), _keyed(false) {
+        assert((m == ECB) || (m == CBC) || (m == CTR));
+        for(unsigned int i = 0; i < BLOCK_SIZE; i++)
+            _iv[i] = 0;
     }
 
     Mode mode() { return _mode; }
 
-    void encrypt(const unsigned char * data, const unsigned char * key, unsigned char * result) { crypt(data, key, result, true); }
-    void decrypt(const unsigned char * data, const unsigned char * key, unsigned char * result) { crypt(data, key, result, false); }
+    // Initialization vector for CBC, or initial counter block for CTR (zeros by default); each call starts from it anew
+    void iv(const unsigned char * v) { memcpy(_iv, v, BLOCK_SIZE); }
+
+    void encrypt(const unsigned char * data, const unsigned char * key, unsigned char * result) { crypt(data, BLOCK_SIZE, key, result, true); }
+    void decrypt(const unsigned char * data, const unsigned char * key, unsigned char * result) { crypt(data, BLOCK_SIZE, key, result, false); }
+
+    // Bulk versions: length is rounded up to whole blocks, with the last one zero-padded, so result must hold them all
+    // In CTR, both XOR data with the keystream of the counter (a 128-bit big-endian integer) and write length bytes
+    void encrypt(const unsigned char * data, unsigned int length, const unsigned char * key, unsigned char * result) { crypt(data, length, key, result, true); }
+    void decrypt(const unsigned char * data, unsigned int length, const unsigned char * key, unsigned char * result) { crypt(data, length, key, result, false); }
 
 private:
     void mode(const Mode & m) {
-        assert((m == ECB) || (m == CBC));
+        assert((m == ECB) || (m == CBC) || (m == CTR));
         _mode = m;
     }
 
-    void crypt(const unsigned char * data, const unsigned char * key, unsigned char * result, bool encrypt) {
-        db<Ciphers>(TRC) << "AES::" << (encrypt ? "en" : "de") << "crypt(data=" << data << ",key=" << key << ",result=" << result << endl;
+    void crypt(const unsigned char * data, unsigned int length, const unsigned char * key, unsigned char * result, bool encrypt) {
+        db<Ciphers>(TRC) << "AES::" << (encrypt ? "en" : "de") << "crypt(data=" << data << ",length=" << length << ",key=" << key << ",result=" << result << endl;
         db<Ciphers>(INF) << "AES::" << (encrypt ? "en" : "de") << "crypt:data = {" << int(data[0]);
         for(unsigned int i = 1; i < 16; i++)
             db<Ciphers>(INF) << "," << int(data[i]);
@@ -54,20 +71,11 @@ private:
             db<Ciphers>(INF) << "," << int(key[i]);
         db<Ciphers>(INF) << "}" << endl;
 
-        switch(_mode) {
-        case CBC:
-            if(encrypt)
-                cbc_encrypt_buffer(result, data, 16, key, iv);
-            else
-                cbc_decrypt_buffer(result, data, 16, key, iv);
-            break;
-        case ECB:
-            if(encrypt)
-                ebc_encrypt(data, key, result);
-            else
-                ebc_decrypt(data, key, result);
-            break;
-        }
+        set_key(key);
+        if(encrypt || (_mode == CTR))
+            encrypt_buffer(result, data, length);
+        else
+            decrypt_buffer(result, data, length);
 
         db<Ciphers>(INF) << "AES::" << (encrypt ? "en" : "de") << "crypt:result = {" << int(result[0]);
         for(unsigned int i = 1; i < 16; i++)
@@ -75,27 +83,36 @@ private:
         db<Ciphers>(INF) << "}" << endl;
     }
 
-    void cbc_encrypt_buffer(unsigned char * output, const unsigned char * input, int length, const unsigned char * key, unsigned char * iv);
-    void cbc_decrypt_buffer(unsigned char * output, const unsigned char * input, int length, const unsigned char * key, unsigned char * iv);
-    void ebc_encrypt(const unsigned char * input, const unsigned char * key, unsigned char *output);
-    void ebc_decrypt(const unsigned char * input, const unsigned char * key, unsigned char *output);
+    void set_key(const unsigned char * key) {
+        if(!_keyed || memcmp(_key, key, KEY_SIZE)) {
+            memcpy(_key, key, KEY_SIZE);
+            expand_key();
+            _keyed = true;
+        }
+    }
+
+    void encrypt_buffer(unsigned char * output, const unsigned char * input, unsigned int length);
+    void decrypt_buffer(unsigned char * output, const unsigned char * input, unsigned int length);
+
+    // output = input ^ keystream of counter, whose last "width" bytes are incremented past the blocks used
+    void ctr(unsigned char * output, const unsigned char * input, unsigned int length, unsigned char counter[BLOCK_SIZE],
+             unsigned int width);
 
     void expand_key();
-    void add_round_key(int round);
-    void sub_bytes();
-    void shift_rows();
-    void mix_columns();
-    void inv_mix_columns();
-    void inv_sub_bytes();
-    void inv_shift_rows();
+    void cipher(unsigned char * output, const unsigned char * input);
+    void inv_cipher(unsigned char * output, const unsigned char * input);
+    void cipher(unsigned char * output, const unsigned char * input, unsigned int blocks); // PARALLEL at a time
 
-    void cipher();
-    void inv_cipher();
+    static void build_tables();
 
-    void block_copy(unsigned char * output, const unsigned char * input) { memcpy(output, input, KEY_SIZE); }
+    static void increment(unsigned char counter[BLOCK_SIZE], unsigned int width) {
+        for(unsigned int i = BLOCK_SIZE; i-- > BLOCK_SIZE - width; )
+            if(++counter[i])
+                break;
+    }
 
-    unsigned char xtime(unsigned char x) { return ((x<<1) ^ (((x>>7) & 1) * 0x1b)); }
-    unsigned char multiply(unsigned char x, unsigned char y) {
+    static unsigned char xtime(unsigned char x) { return ((x<<1) ^ (((x>>7) & 1) * 0x1b)); }
+    static unsigned char multiply(unsigned char x, unsigned char y) {
         return (((y & 1) * x) ^
                 ((y >> 1 & 1) * xtime(x)) ^
                 ((y >> 2 & 1) * xtime(xtime(x))) ^
@@ -103,20 +120,22 @@ private:
                 ((y >> 4 & 1) * xtime(xtime(xtime(xtime(x))))));
     }
 
-    void xor_with_iv(unsigned char * buf) { for(unsigned int i = 0; i < KEY_SIZE; ++i) buf[i] ^= _iv[i]; }
-
 private:
     Mode _mode;
 
-    State * _state;
-    unsigned char _round_key[176];
-    const unsigned char * _key;
-    unsigned char * _iv; // initial Vector used only for CBC mode
-    unsigned char iv[23];
+    bool _keyed;
+    unsigned char _key[KEY_SIZE]; // the key the schedule below was expanded from
+    unsigned int _ek[Nb * (Nr + 1)]; // encryption round keys
+    unsigned int _dk[Nb * (Nr + 1)]; // decryption round keys, with InvMixColumns applied to the inner ones
+    unsigned char _iv[BLOCK_SIZE]; // initial Vector for CBC mode, or initial counter for CTR
 
     static const unsigned char sbox[256];
     static const unsigned char rsbox[256];
     static const unsigned char rcon[255];
+
+    static bool _tables;
+    static unsigned int _te[256];
+    static unsigned int _td[256];
 };
 
 __END_UTIL
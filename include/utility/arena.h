@@ -0,0 +1,62 @@
+// EPOS Arena Allocator Utility Declarations
+
+#ifndef __arena_h
+#define __arena_h
+
+#include <utility/debug.h>
+
+__BEGIN_UTIL
+
+// Arena
+// Objects are allocated by bumping a pointer and can't be freed one by one: reset() gives everything back at once
+// and release() everything allocated since a mark(). The memory is either carved out of the system heap (and given
+// back when the arena is destroyed) or provided by the caller, e.g. a Segment attached to the address space.
+// Arenas are not synchronized, since they are meant to hold data private to a thread (e.g. a request being served).
+// Objects are created with "new (arena) T(...)", but their destructors are never called.
+class Arena
+{
+public:
+    typedef char * Mark;
+
+public:
+    Arena(unsigned long bytes);
+    Arena(void * addr, unsigned long bytes): _base(reinterpret_cast<char *>(addr)), _top(_base), _end(_base + bytes), _owned(false) {
+        db<Heaps>(TRC) << "Arena(addr=" << addr << ",bytes=" << bytes << ") => " << this << endl;
+    }
+    ~Arena();
+
+    unsigned long size() const { return _end - _base; }
+    unsigned long used() const { return _top - _base; }
+    unsigned long available() const { return _end - _top; }
+
+    void * alloc(unsigned long bytes, unsigned long align = sizeof(long)) {
+        char * addr = reinterpret_cast<char *>((reinterpret_cast<unsigned long>(_top) + align - 1) & ~(align - 1));
+        if((addr < _top) || (bytes > static_cast<unsigned long>(_end - addr))) {
+            db<Heaps>(WRN) << "Arena::alloc(this=" << this << ",bytes=" << bytes << ") => failed!" << endl;
+            return 0;
+        }
+        _top = addr + bytes;
+
+        db<Heaps>(TRC) << "Arena::alloc(this=" << this << ",bytes=" << bytes << ") => " << reinterpret_cast<void *>(addr) << endl;
+
+        return addr;
+    }
+
+    Mark mark() const { return _top; }
+    void release(const Mark & mark) { _top = mark; }
+    void reset() { _top = _base; }
+
+private:
+    char * _base;
+    char * _top;
+    char * _end;
+    bool _owned;
+};
+
+__END_UTIL
+
+// Allocation tag, as in "new (SYSTEM)"
+inline void * operator new(size_t bytes, _UTIL::Arena & arena) { return arena.alloc(bytes); }
+inline void * operator new[](size_t bytes, _UTIL::Arena & arena) { return arena.alloc(bytes); }
+
+#endif
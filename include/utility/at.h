@@ -0,0 +1,124 @@
+// EPOS AT Command Engine Utility Declarations
+
+#ifndef __at_h
+#define __at_h
+
+#include <architecture.h>
+#include <utility/handler.h>
+#include <utility/list.h>
+#include <utility/string.h>
+
+__BEGIN_UTIL
+
+// Pipelined AT command engine for modems on a serial port, with no thread of its own
+// Commands are queued with submit() and run in order. The interrupt handler of the port feeds what arrives to
+// received(), which parses it line by line and, as soon as the final result code of a command (its "final" line, OK,
+// ERROR, +CME ERROR or +CMS ERROR) is there, completes it and starts the next one, so a batch goes through with no
+// thread switch in between. The bytes to be sent are taken with transmit(), usually by the TX interrupt handler, and
+// "kick" is called when there are new ones while there were none (e.g. to enable that interrupt). A command's payload
+// (e.g. the data of AT+QISEND=<n>) is sent right when the modem's "> " prompt arrives, so data-mode transfers go on
+// while threads prepare the next ones. Lines in between are appended to the command's "response", if it has one.
+// Lines that belong to no command (unsolicited result codes) are given to "unsolicited" through line(), and the
+// echo of commands is skipped. Commands with a "timeout" fail with TIMEOUT if timeout() is called (e.g. by an Alarm)
+// after it has passed. A Command must not be touched until it is done(). All handlers run in interrupt context.
+class AT_Engine
+{
+public:
+    static const unsigned int LINE = 128;
+
+    typedef TSC::Time_Stamp Time_Stamp;
+
+    enum Status {
+        QUEUED,
+        RUNNING,
+        OK,
+        ERROR,
+        TIMEOUT
+    };
+
+    class Command
+    {
+        friend class AT_Engine;
+
+    public:
+        typedef Simple_List<Command> List;
+        typedef List::Element Element;
+
+    public:
+        Command(const char * command, const char * final = "OK", const Microsecond & timeout = 0, Handler * handler = 0,
+                const void * payload = 0, unsigned int payload_size = 0, char * response = 0, unsigned int response_size = 0)
+        : _command(command), _final(final), _timeout(timeout), _handler(handler),
+          _payload(reinterpret_cast<const char *>(payload)), _payload_size(payload_size),
+          _response(response), _response_size(response_size), _response_length(0), _status(QUEUED), _deadline(0),
+          _link(this) {}
+
+        Status status() const { return _status; }
+        bool done() const { return _status > RUNNING; }
+
+        // Information lines, each one ended by '\n' (truncated to the buffer given, which is always terminated)
+        const char * response() const { return _response; }
+        unsigned int response_length() const { return _response_length; }
+
+    private:
+        const char * _command;      // without the final '\r'
+        const char * _final;
+        Microsecond _timeout;
+        Handler * _handler;
+        const char * _payload;
+        unsigned int _payload_size;
+        char * _response;
+        unsigned int _response_size;
+        unsigned int _response_length;
+        volatile Status _status;
+        Time_Stamp _deadline;
+        Element _link;
+    };
+
+public:
+    AT_Engine(Handler * kick = 0, Handler * unsolicited = 0)
+    : _kick(kick), _unsolicited(unsolicited), _current(0), _tx(0), _tx_left(0), _cr(false), _length(0),
+      _commands(0), _timeouts(0) {}
+
+    void submit(Command * c);
+
+    // Called from the interrupt handlers of the port: up to "max" bytes to send and "size" bytes received
+    unsigned int transmit(char * data, unsigned int max);
+    void received(const char * data, unsigned int size);
+
+    void timeout();
+
+    // The line being given to "unsolicited"
+    const char * line() const { return _line; }
+
+    bool busy() const { return _current; }
+    unsigned long commands() const { return _commands; }
+    unsigned long timeouts() const { return _timeouts; }
+
+private:
+    void start(Command * c);
+    void finish(const Status & status);
+    void parse();
+    void send(const char * data, unsigned int size, bool cr);
+
+    static bool prefix(const char * line, const char * p) { return !strncmp(line, p, strlen(p)); }
+
+private:
+    Handler * _kick;
+    Handler * _unsolicited;
+    Command::List _queue;
+    Command * volatile _current;
+
+    const char * volatile _tx;
+    volatile unsigned int _tx_left;
+    volatile bool _cr;                  // '\r' to go after _tx
+
+    char _line[LINE];
+    unsigned int _length;
+
+    unsigned long _commands;
+    unsigned long _timeouts;
+};
+
+__END_UTIL
+
+#endif
@@ -0,0 +1,106 @@
+// EPOS Atomic Variable Utility Declarations
+
+#ifndef __atomic_h
+#define __atomic_h
+
+#include <architecture.h>
+
+__BEGIN_UTIL
+
+// Memory orderings, as in C++11, for Atomic<T> and Atomic_Fence()
+enum Memory_Order {
+    RELAXED     = __ATOMIC_RELAXED, // only the access itself is atomic
+    ACQUIRE     = __ATOMIC_ACQUIRE, // later accesses can't move before it (loads and read-modify-writes)
+    RELEASE     = __ATOMIC_RELEASE, // earlier accesses can't move after it (stores and read-modify-writes)
+    ACQ_REL     = __ATOMIC_ACQ_REL, // both (read-modify-writes)
+    SEQ_CST     = __ATOMIC_SEQ_CST  // both, plus a single total order of all SEQ_CST operations
+};
+
+inline void Atomic_Fence(Memory_Order o = SEQ_CST) { __atomic_thread_fence(o); }
+
+// Atomic variable of an integral or pointer type T no wider than a CPU register (fetch_*() only for integral ones)
+// On multicores, operations map to the native atomics of each CPU with the ordering asked for (RISC-V AMOs and LR/SC
+// with .aq/.rl, ARMv8 LDAR/STLR and LDAXR/STLXR, ARMv7 LDREX/STREX with DMBs, IA-32 LOCK-prefixed instructions).
+// With a single core there is nothing to order against, so read-modify-writes are built on CPU::cas(), which is
+// atomic with respect to interrupts on every CPU (e.g. ARMv8 without the MMU, whose exclusive monitor isn't usable).
+template<typename T>
+class Atomic
+{
+private:
+    static const bool smp = Traits<Build>::CPUS > 1;
+
+    static_assert(sizeof(T) <= sizeof(CPU::Reg), "Atomic<T> is limited to the width of CPU registers");
+
+public:
+    Atomic(T v = 0): _value(v) {}
+
+    T load(Memory_Order o = SEQ_CST) const { return __atomic_load_n(&_value, o); }
+    void store(T v, Memory_Order o = SEQ_CST) { __atomic_store_n(&_value, v, o); }
+
+    T exchange(T v, Memory_Order o = SEQ_CST) {
+        if(smp)
+            return __atomic_exchange_n(&_value, v, o);
+        T old;
+        do
+            old = _value;
+        while(CPU::cas(_value, old, v) != old);
+        return old;
+    }
+
+    // On failure, "expected" gets the current value
+    bool compare_exchange(T & expected, T desired, Memory_Order o = SEQ_CST) {
+        if(smp)
+            return __atomic_compare_exchange_n(&_value, &expected, desired, false, o, failure(o));
+        T old = CPU::cas(_value, expected, desired);
+        bool ok = (old == expected);
+        expected = old;
+        return ok;
+    }
+
+    T fetch_add(T v, Memory_Order o = SEQ_CST) { return smp ? __atomic_fetch_add(&_value, v, o) : update<Add>(v); }
+    T fetch_sub(T v, Memory_Order o = SEQ_CST) { return smp ? __atomic_fetch_sub(&_value, v, o) : update<Sub>(v); }
+    T fetch_and(T v, Memory_Order o = SEQ_CST) { return smp ? __atomic_fetch_and(&_value, v, o) : update<And>(v); }
+    T fetch_or(T v, Memory_Order o = SEQ_CST) { return smp ? __atomic_fetch_or(&_value, v, o) : update<Or>(v); }
+    T fetch_xor(T v, Memory_Order o = SEQ_CST) { return smp ? __atomic_fetch_xor(&_value, v, o) : update<Xor>(v); }
+
+    operator T() const { return load(); }
+    T operator=(T v) { store(v); return v; }
+    T operator++() { return fetch_add(1) + 1; }
+    T operator++(int) { return fetch_add(1); }
+    T operator--() { return fetch_sub(1) - 1; }
+    T operator--(int) { return fetch_sub(1); }
+    T operator+=(T v) { return fetch_add(v) + v; }
+    T operator-=(T v) { return fetch_sub(v) - v; }
+    T operator&=(T v) { return fetch_and(v) & v; }
+    T operator|=(T v) { return fetch_or(v) | v; }
+    T operator^=(T v) { return fetch_xor(v) ^ v; }
+
+private:
+    Atomic(const Atomic &);
+    Atomic & operator=(const Atomic &);
+
+    // A failed compare_exchange is only a load, which can't have release semantics
+    static Memory_Order failure(Memory_Order o) { return (o == RELEASE) ? RELAXED : (o == ACQ_REL) ? ACQUIRE : o; }
+
+    struct Add { static T op(T a, T b) { return a + b; } };
+    struct Sub { static T op(T a, T b) { return a - b; } };
+    struct And { static T op(T a, T b) { return a & b; } };
+    struct Or  { static T op(T a, T b) { return a | b; } };
+    struct Xor { static T op(T a, T b) { return a ^ b; } };
+
+    template<typename Op>
+    T update(T v) {
+        T old;
+        do
+            old = _value;
+        while(CPU::cas(_value, old, Op::op(old, v)) != old);
+        return old;
+    }
+
+private:
+    volatile T _value;
+};
+
+__END_UTIL
+
+#endif
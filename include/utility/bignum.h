@@ -21,6 +21,7 @@ public:
 
     static const unsigned int DIGITS = (SIZE + sizeof(Digit) - 1) / sizeof(Digit);
     static const unsigned int BITS_PER_DIGIT = sizeof(Digit) * 8;
+    static const unsigned int KARATSUBA_DIGITS = 16; // below this, schoolbook multiplication is faster
 
     typedef Digit Word[DIGITS];
     typedef Double_Digit Double_Word[DIGITS];
@@ -137,6 +138,42 @@ public:
             db<Bignum>(TRC) << *this << endl;
     }
 
+    // Montgomery form: a number x is represented as (x * R) % _mod, with R = 2^(BITS_PER_DIGIT * DIGITS).
+    // montgomery_multiply() reduces the product of two numbers in this form by interleaving multiplication and
+    // reduction digit by digit (CIOS), without the divisions of a full reduction, so long chains of multiplications
+    // (e.g. an exponentiation or a scalar multiplication on a curve) are cheaper in it, paying for to_montgomery() and
+    // from_montgomery() only once. Additions and subtractions (and thus multiplications by small constants, done with
+    // additions) work unchanged in the Montgomery form.
+    void to_montgomery() { montgomery(_data, _data, _montgomery_r2.data); }
+    void from_montgomery() {
+        Word one = {1};
+        montgomery(_data, _data, one);
+    }
+    void montgomery_multiply(const Bignum & b) { montgomery(_data, _data, b._data); } // _data = (_data * b._data / R) % _mod
+
+    // _data = (_data ^ e) % _mod, taking e in fixed 4-bit windows, with the powers up to 15 of _data precomputed
+    void pow(const Bignum & e) __attribute__((noinline)) {
+        static const unsigned int WINDOW = 4;
+
+        Bignum power[1 << WINDOW];
+        power[0] = 1;
+        power[0].to_montgomery();
+        power[1] = *this;
+        power[1].to_montgomery();
+        for(unsigned int i = 2; i < (1 << WINDOW); i++) {
+            power[i] = power[i - 1];
+            power[i].montgomery_multiply(power[1]);
+        }
+
+        *this = power[0];
+        for(int i = DIGITS * BITS_PER_DIGIT - WINDOW; i >= 0; i -= WINDOW) {
+            for(unsigned int j = 0; j < WINDOW; j++)
+                montgomery_multiply(*this);
+            montgomery_multiply(power[(e._data[i / BITS_PER_DIGIT] >> (i % BITS_PER_DIGIT)) & ((1 << WINDOW) - 1)]);
+        }
+        from_montgomery();
+    }
+
     // Shift left (actually shift right, because of little endianness)
     // - Does not apply modulo
     // - Returns carry bit
@@ -304,6 +341,11 @@ private:
     // - a and b are assumed to be of size 'size'
     // - res is assumed to be of size '2*size'
     static void simple_mult(Digit * res, const Digit * a, const Digit * b, unsigned int size) {
+        if(size >= KARATSUBA_DIGITS) {
+            karatsuba(res, a, b, size);
+            return;
+        }
+
         unsigned int i;
         Double_Digit r0 = 0, r1 = 0, r2 = 0;
         for(i = 0; i < size * 2 - 1; i++) {
@@ -328,6 +370,99 @@ private:
         res[i] = r0;
     }
 
+    // res = (a * b), as (a1 * B + a0) * (b1 * B + b0) = a1b1 * B^2 + ((a0 + a1) * (b0 + b1) - a0b0 - a1b1) * B + a0b0,
+    // that is, with three multiplications of half the size instead of four
+    // - Same conditions as simple_mult
+    static void karatsuba(Digit * res, const Digit * a, const Digit * b, unsigned int size) {
+        unsigned int l = size / 2; // digits in a0 and b0
+        unsigned int h = size - l; // digits in a1 and b1 (h >= l)
+
+        simple_mult(res, a, b, l);
+        simple_mult(res + 2 * l, a + l, b + l, h);
+
+        Digit sa[h + 1], sb[h + 1];
+        Double_Digit ca = 0, cb = 0;
+        for(unsigned int i = 0; i < h; i++) {
+            ca += Double_Digit(a[l + i]) + (i < l ? a[i] : 0);
+            cb += Double_Digit(b[l + i]) + (i < l ? b[i] : 0);
+            sa[i] = ca;
+            sb[i] = cb;
+            ca >>= BITS_PER_DIGIT;
+            cb >>= BITS_PER_DIGIT;
+        }
+        sa[h] = ca;
+        sb[h] = cb;
+
+        Digit mid[2 * (h + 1)];
+        simple_mult(mid, sa, sb, h + 1);
+        accumulate(mid, 2 * (h + 1), res, 2 * l, true);
+        accumulate(mid, 2 * (h + 1), res + 2 * l, 2 * h, true);
+
+        // The middle term fits in what is left of res, so whatever would carry beyond it is zero
+        accumulate(res + l, 2 * size - l, mid, (2 * (h + 1) < 2 * size - l) ? 2 * (h + 1) : 2 * size - l, false);
+    }
+
+    // res = res +/- a, propagating carries (borrows) over the whole of res
+    // - a is assumed to have 'asize' <= 'rsize' digits
+    static void accumulate(Digit * res, unsigned int rsize, const Digit * a, unsigned int asize, bool subtract) {
+        Double_Digit c = 0;
+        for(unsigned int i = 0; i < rsize; i++) {
+            if(i >= asize && !c)
+                break;
+            Digit d = (i < asize) ? a[i] : 0;
+            if(subtract) {
+                Double_Digit s = Double_Digit(d) + c;
+                c = (res[i] < s);
+                res[i] = Digit(res[i] - s);
+            } else {
+                c += Double_Digit(res[i]) + d;
+                res[i] = c;
+                c >>= BITS_PER_DIGIT;
+            }
+        }
+    }
+
+    // res = (a * b / R) % _mod, with R = base^DIGITS, by Coarsely Integrated Operand Scanning: each digit of b is
+    // multiplied into the partial result, which is then made divisible by the base by adding a multiple of _mod
+    // (_montgomery_n0 = -1 / _mod % base) and shifted one digit down
+    // - a and b are assumed to be smaller than _mod
+    // - a, b and res are allowed to point to the same place
+    static void montgomery(Digit * res, const Digit * a, const Digit * b) __attribute__((noinline)) {
+        Digit t[DIGITS + 2];
+        for(unsigned int i = 0; i < DIGITS + 2; i++)
+            t[i] = 0;
+
+        for(unsigned int i = 0; i < DIGITS; i++) {
+            Double_Digit c = 0;
+            for(unsigned int j = 0; j < DIGITS; j++) {
+                c += Double_Digit(t[j]) + Double_Digit(a[j]) * b[i];
+                t[j] = c;
+                c >>= BITS_PER_DIGIT;
+            }
+            c += t[DIGITS];
+            t[DIGITS] = c;
+            t[DIGITS + 1] = c >> BITS_PER_DIGIT;
+
+            Digit m = t[0] * _montgomery_n0;
+            c = (Double_Digit(t[0]) + Double_Digit(m) * _mod.data[0]) >> BITS_PER_DIGIT;
+            for(unsigned int j = 1; j < DIGITS; j++) {
+                c += Double_Digit(t[j]) + Double_Digit(m) * _mod.data[j];
+                t[j - 1] = c;
+                c >>= BITS_PER_DIGIT;
+            }
+            c += t[DIGITS];
+            t[DIGITS - 1] = c;
+            t[DIGITS] = t[DIGITS + 1] + Digit(c >> BITS_PER_DIGIT);
+        }
+
+        // t < 2 * _mod
+        if(t[DIGITS] || (cmp(t, _mod.data, DIGITS) >= 0))
+            simple_sub(t, t, _mod.data, DIGITS);
+
+        for(unsigned int i = 0; i < DIGITS; i++)
+            res[i] = t[i];
+    }
+
     // res = a % _mod
     // - Intended to be used after a multiplication
     // - res is assumed to be of size 'size'
@@ -402,6 +537,8 @@ private:
 
     static const _Word _mod;
     static const _Barrett _barrett_u;
+    static const _Word _montgomery_r2; // R^2 % _mod, which takes a number into the Montgomery form
+    static const Digit _montgomery_n0;
 };
 
 __END_UTIL
@@ -7,6 +7,8 @@
 
 __BEGIN_UTIL
 
+// Searches and counts go a word at a time with __builtin_ctz(), __builtin_clz() and __builtin_popcount(), which the
+// compiler maps to single instructions where the target has them (e.g. BSF/BSR, ARM CLZ, or RISC-V Zbb's ctz/clz/cpop)
 template<unsigned int BITS>
 class Bitmap
 {
@@ -34,6 +36,67 @@ public:
         return false;
     }
 
+    bool test(unsigned int index) const {
+        return (index < BITS) && (_map[index / BPI] & (1 << (index & mask)));
+    }
+
+    // Sets (or resets) all bits in [from, to)
+    void set(unsigned int from, unsigned int to) {
+        for(unsigned int n; from < ((to < BITS) ? to : BITS); from += n)
+            _map[from / BPI] |= span(from, to, n);
+    }
+
+    void reset(unsigned int from, unsigned int to) {
+        for(unsigned int n; from < ((to < BITS) ? to : BITS); from += n)
+            _map[from / BPI] &= ~span(from, to, n);
+    }
+
+    // Index of the lowest set bit or -1 if none is set
+    int first() const { return find_first_set(); }
+
+    // Index of the lowest set (or clear) bit at or above "from", or -1 if there is none
+    int find_first_set(unsigned int from = 0) const {
+        if(from >= BITS)
+            return -1;
+        unsigned int i = from / BPI;
+        for(unsigned int w = _map[i] & (~0U << (from & mask)); ; w = _map[i]) {
+            if(w)
+                return i * BPI + __builtin_ctz(w);
+            if(++i == SIZE)
+                return -1;
+        }
+    }
+
+    int find_first_clear(unsigned int from = 0) const {
+        if(from >= BITS)
+            return -1;
+        unsigned int i = from / BPI;
+        for(unsigned int w = ~_map[i] & (~0U << (from & mask)); ; w = ~_map[i]) {
+            if(w) {
+                unsigned int b = i * BPI + __builtin_ctz(w);
+                return (b < BITS) ? int(b) : -1; // the bits of the last word past BITS are always clear
+            }
+            if(++i == SIZE)
+                return -1;
+        }
+    }
+
+    // Index of the highest set bit or -1 if none is set
+    int last() const {
+        for(unsigned int i = SIZE; i-- > 0; )
+            if(_map[i])
+                return i * BPI + BPI - 1 - __builtin_clz(_map[i]);
+        return -1;
+    }
+
+    // Number of set bits
+    unsigned int count() const {
+        unsigned int n = 0;
+        for(unsigned int i = 0; i < SIZE; i++)
+            n += __builtin_popcount(_map[i]);
+        return n;
+    }
+
     bool full(unsigned int upto) const {
         unsigned int i;
         for(i = 0; i < upto / BPI; i++)
@@ -54,6 +117,16 @@ public:
         return true;
     }
 
+private:
+    // The bits of [from, to) in from's word, whose number is returned in n
+    static unsigned int span(unsigned int from, unsigned int to, unsigned int & n) {
+        if(to > BITS)
+            to = BITS;
+        unsigned int lo = from & mask;
+        n = (to - from < BPI - lo) ? to - from : BPI - lo;
+        return ((n == BPI) ? ~0U : ((1U << n) - 1)) << lo;
+    }
+
 private:
      unsigned int _map[SIZE];
 };
@@ -0,0 +1,217 @@
+// EPOS Buddy Frame Allocator Utility Declarations
+
+// Frames are numbered from the base given to base() and kept in blocks of 2^order frames aligned to their size, with
+// one free list per order and color. Allocating splits the smallest block large enough and freeing merges a block
+// with its buddy (the other half of the block of the next order) while the buddy is free and has the same order and
+// color, so both take O(log FRAMES). Free blocks hold their list links in their first frame and a bitmap tells which
+// frames start a free block, so buddies can be checked without touching memory that might be in use.
+// Regions given with free_region() are only carved into blocks (from their top) when the lists run out, so their
+// memory is left untouched until it is needed (MMU::init() gives away INIT while it is still running).
+
+#ifndef __buddy_h
+#define __buddy_h
+
+#include <utility/debug.h>
+
+__BEGIN_UTIL
+
+template<unsigned long FRAMES, unsigned long FRAME_SIZE, unsigned int COLORS = 1, unsigned int ORDERS = 20>
+class Buddy
+{
+public:
+    typedef unsigned long Frame;
+
+    static const Frame NONE = ~0UL;
+
+private:
+    static const unsigned int EXTENTS = 4;
+
+    struct Block {
+        Block * next;
+        Block * prev;
+        unsigned int order;
+        unsigned int color;
+    };
+
+    struct Extent {
+        Frame base;
+        Frame top;
+        unsigned int color;
+    };
+
+public:
+    Buddy(): _base(0), _extents(0) {
+        for(unsigned int i = 0; i < COLORS; i++) {
+            _frames[i] = 0;
+            for(unsigned int j = 0; j < ORDERS; j++)
+                _free[i][j] = 0;
+        }
+        for(unsigned int i = 0; i < (FRAMES + 31) / 32; i++)
+            _head[i] = 0;
+    }
+
+    // Logical address of frame 0
+    void base(void * addr) { _base = reinterpret_cast<char *>(addr); }
+
+    // Frames in free blocks and regions
+    unsigned long grouped_size(unsigned int color = 0) const {
+        unsigned long n = _frames[color];
+        for(unsigned int i = 0; i < _extents; i++)
+            if(_extent[i].color == color)
+                n += _extent[i].top - _extent[i].base;
+        return n;
+    }
+
+    // Size of the largest block alloc() can return
+    unsigned long allocable(unsigned int color = 0) const {
+        unsigned long n = 0;
+        for(unsigned int j = ORDERS; j > 0; j--)
+            if(_free[color][j - 1]) {
+                n = 1UL << (j - 1);
+                break;
+            }
+        for(unsigned int i = 0; i < _extents; i++)
+            if(_extent[i].color == color)
+                for(Frame top = _extent[i].top; (top > _extent[i].base) && (n < (1UL << (ORDERS - 1))); ) {
+                    unsigned int o = carvable(_extent[i].base, top);
+                    if((1UL << o) > n)
+                        n = 1UL << o;
+                    top -= 1UL << o;
+                }
+        return n;
+    }
+
+    Frame alloc(unsigned long frames, unsigned int color = 0) {
+        unsigned int order = 0;
+        while((1UL << order) < frames)
+            order++;
+        if(order >= ORDERS)
+            return NONE;
+
+        unsigned int j;
+        for(;;) {
+            for(j = order; (j < ORDERS) && !_free[color][j]; j++);
+            if(j < ORDERS)
+                break;
+            if(!carve(color))
+                return NONE;
+        }
+
+        Frame f = frame(_free[color][j]);
+        remove(f);
+        for(; j > order; j--) // split, keeping the lower half
+            insert(f + (1UL << (j - 1)), j - 1, color);
+
+        free(f + frames, (1UL << order) - frames, color); // give back what was not asked for
+
+        return f;
+    }
+
+    // Frees any [f, f + n) range, which need not be a single block nor have been allocated at once
+    void free(Frame f, unsigned long n, unsigned int color = 0) {
+        while(n) {
+            unsigned int order = 0;
+            while((order + 1 < ORDERS) && !(f & ((1UL << (order + 1)) - 1)) && ((1UL << (order + 1)) <= n))
+                order++;
+            release(f, order, color);
+            f += 1UL << order;
+            n -= 1UL << order;
+        }
+    }
+
+    // Gives a whole region at once, to be split into blocks only as needed
+    void free_region(Frame f, unsigned long n, unsigned int color = 0) {
+        if(!n)
+            return;
+        if(_extents < EXTENTS) {
+            _extent[_extents].base = f;
+            _extent[_extents].top = f + n;
+            _extent[_extents].color = color;
+            _extents++;
+        } else
+            free(f, n, color);
+    }
+
+private:
+    Block * block(Frame f) const { return reinterpret_cast<Block *>(_base + f * FRAME_SIZE); }
+    Frame frame(Block * b) const { return (reinterpret_cast<char *>(b) - _base) / FRAME_SIZE; }
+
+    bool head(Frame f) const { return _head[f / 32] & (1U << (f % 32)); }
+    void head(Frame f, bool h) {
+        if(h)
+            _head[f / 32] |= 1U << (f % 32);
+        else
+            _head[f / 32] &= ~(1U << (f % 32));
+    }
+
+    // Order of the largest aligned block just below top that fits in [base, top)
+    static unsigned int carvable(Frame base, Frame top) {
+        unsigned int order = 0;
+        while((order + 1 < ORDERS) && !(top & ((1UL << (order + 1)) - 1)) && (top - base >= (1UL << (order + 1))))
+            order++;
+        return order;
+    }
+
+    // Moves the block at the top of a region of the given color to the free lists
+    bool carve(unsigned int color) {
+        for(unsigned int i = 0; i < _extents; i++)
+            if(_extent[i].color == color) {
+                unsigned int order = carvable(_extent[i].base, _extent[i].top);
+                _extent[i].top -= 1UL << order;
+                insert(_extent[i].top, order, color);
+                if(_extent[i].top == _extent[i].base)
+                    _extent[i] = _extent[--_extents];
+                return true;
+            }
+        return false;
+    }
+
+    void insert(Frame f, unsigned int order, unsigned int color) {
+        Block * b = block(f);
+        b->order = order;
+        b->color = color;
+        b->prev = 0;
+        b->next = _free[color][order];
+        if(b->next)
+            b->next->prev = b;
+        _free[color][order] = b;
+        _frames[color] += 1UL << order;
+        head(f, true);
+    }
+
+    void remove(Frame f) {
+        Block * b = block(f);
+        if(b->prev)
+            b->prev->next = b->next;
+        else
+            _free[b->color][b->order] = b->next;
+        if(b->next)
+            b->next->prev = b->prev;
+        _frames[b->color] -= 1UL << b->order;
+        head(f, false);
+    }
+
+    void release(Frame f, unsigned int order, unsigned int color) {
+        for(; order + 1 < ORDERS; order++) {
+            Frame buddy = f ^ (1UL << order);
+            if((buddy >= FRAMES) || !head(buddy) || (block(buddy)->order != order) || (block(buddy)->color != color))
+                break;
+            remove(buddy);
+            if(buddy < f)
+                f = buddy;
+        }
+        insert(f, order, color);
+    }
+
+private:
+    char * _base;
+    Block * _free[COLORS][ORDERS];
+    unsigned long _frames[COLORS];
+    Extent _extent[EXTENTS];
+    unsigned int _extents;
+    unsigned int _head[(FRAMES + 31) / 32];
+};
+
+__END_UTIL
+
+#endif
@@ -153,6 +153,64 @@ private:
     unsigned int _tail;
     T _data[N_ELEMENTS];
 };
+
+
+// Single-Producer, Single-Consumer Circular Buffer
+// One side (e.g. a UART or ADC ISR) only insert()s and the other (e.g. a thread) only remove()s, so neither a lock nor
+// masking interrupts is needed. The tail is only written by the producer and the head only by the consumer. Each side
+// publishes its index with release semantics after touching the slot, and reads the other side's index with acquire
+// semantics before touching it. Indexes run free and are masked, so N_ELEMENTS must be a power of two (and all
+// elements can be used).
+template<typename T, unsigned int N_ELEMENTS>
+class SPSC_Circular_Buffer
+{
+private:
+    static_assert(N_ELEMENTS && !(N_ELEMENTS & (N_ELEMENTS - 1)), "SPSC_Circular_Buffer size must be a power of two");
+
+    static const unsigned int MASK = N_ELEMENTS - 1;
+
+public:
+    typedef T Object_Type;
+
+public:
+    SPSC_Circular_Buffer(): _head(0), _tail(0) {}
+
+    // Exact from either side, conservative from the other one
+    unsigned int size() const { return acquire(_tail) - acquire(_head); }
+    bool empty() const { return size() == 0; }
+    bool full() const { return size() == N_ELEMENTS; }
+
+    // Producer only
+    bool insert(const Object_Type & o) {
+        unsigned int tail = relaxed(_tail);
+        if(tail - acquire(_head) == N_ELEMENTS)
+            return false;
+        _data[tail & MASK] = o;
+        release(_tail, tail + 1);
+        return true;
+    }
+
+    // Consumer only
+    bool remove(Object_Type * o) {
+        unsigned int head = relaxed(_head);
+        if(acquire(_tail) == head)
+            return false;
+        *o = _data[head & MASK];
+        release(_head, head + 1);
+        return true;
+    }
+
+private:
+    static unsigned int relaxed(const unsigned int & i) { return __atomic_load_n(&i, __ATOMIC_RELAXED); }
+    static unsigned int acquire(const unsigned int & i) { return __atomic_load_n(&i, __ATOMIC_ACQUIRE); }
+    static void release(unsigned int & i, unsigned int v) { __atomic_store_n(&i, v, __ATOMIC_RELEASE); }
+
+private:
+    unsigned int _head;
+    unsigned int _tail;
+    T _data[N_ELEMENTS];
+};
+
 __END_UTIL
 
 #endif
@@ -0,0 +1,77 @@
+// EPOS Function Call Tracer Utility Declarations
+
+#ifndef __call_tracer_h
+#define __call_tracer_h
+
+#include <architecture.h>
+#include <utility/per_cpu.h>
+
+__BEGIN_UTIL
+
+// Per-CPU rings of function entries and exits (enabled by Traits<Call_Tracer>::enabled)
+// The source files of components with Traits<T>::call_traced are compiled with -finstrument-functions (see makedefs),
+// so GCC makes each of their functions call __cyg_profile_func_enter() and __cyg_profile_func_exit(), which record
+// the function's address and a time stamp. Rings wrap around, keeping the last RECORDS records of each CPU.
+// dump() replays them on a shadow call stack and prints one "@call cpu function calls inclusive exclusive" line per
+// function, with the time stamp cycles spent in it with and without the functions it called, whose addresses can be
+// symbolized as the Profiler's. Times are elapsed cycles, so they also cover the threads and handlers that preempted
+// a function. Exits whose entries were overwritten, and entries that never exited, are left out.
+class Call_Tracer
+{
+public:
+    static const bool enabled = Traits<Call_Tracer>::enabled;
+    static const unsigned int RECORDS = enabled ? Traits<Call_Tracer>::RECORDS : 1;
+    static const unsigned int FUNCTIONS = enabled ? Traits<Call_Tracer>::FUNCTIONS : 1;
+    static const unsigned int DEPTH = 64;
+    static const unsigned int PROBES = 8;
+
+    typedef TSC::Time_Stamp Time_Stamp;
+
+    struct Record {
+        Time_Stamp ts;
+        const void * function;
+        bool entry;
+    };
+
+    struct Function {
+        const void * function;
+        unsigned long calls;
+        Time_Stamp inclusive;
+        Time_Stamp exclusive;
+    };
+
+public:
+    __attribute__((no_instrument_function)) static void record(const void * function, bool entry) {
+        if(!enabled)
+            return;
+
+        // As Log::log(), but the hooks can't afford to be traced themselves, so nothing here is instrumented
+        bool disabled = CPU::int_disabled();
+        if(!disabled)
+            CPU::int_disable();
+
+        unsigned int cpu = CPU::id();
+        Record & r = _ring[cpu][_head[cpu]++ % RECORDS];
+        r.ts = TSC::time_stamp();
+        r.function = function;
+        r.entry = entry;
+
+        if(!disabled)
+            CPU::int_enable();
+    }
+
+    static void dump();
+    static void reset();
+
+private:
+    static Function * function(const void * f);
+
+private:
+    static Per_CPU<unsigned int> _head;
+    static Record _ring[Traits<Build>::CPUS][RECORDS];
+    static Function _functions[FUNCTIONS];
+};
+
+__END_UTIL
+
+#endif
@@ -0,0 +1,82 @@
+// EPOS ChaCha20 and ChaCha20-Poly1305 Utility Declarations
+
+#ifndef __chacha20_h
+#define __chacha20_h
+
+#include <utility/string.h>
+#include <utility/poly1305.h>
+
+__BEGIN_UTIL
+
+// ChaCha20 Stream Cipher (RFC 8439): a 256-bit key, a 96-bit nonce and a 32-bit block counter
+// Rounds only add, rotate and xor 32-bit words, so they need neither AES hardware nor lookup tables and run at the same
+// pace on cores that have neither (e.g. Cortex-M and RV32). crypt() XORs data with the keystream of consecutive blocks,
+// word by word, in a single pass that both encrypts and decrypts. On ARMv8 with NEON, each row of the state is held in
+// a vector register, so a quarter round works on the four columns (or diagonals, with the rows' lanes rotated) at once.
+class ChaCha20
+{
+public:
+    static const unsigned int KEY_SIZE = 32;
+    static const unsigned int NONCE_SIZE = 12;
+    static const unsigned int BLOCK_SIZE = 64;
+
+public:
+    ChaCha20() {}
+    ChaCha20(const unsigned char key[KEY_SIZE], const unsigned char nonce[NONCE_SIZE], unsigned int counter = 0) {
+        reset(key, nonce, counter);
+    }
+
+    void reset(const unsigned char key[KEY_SIZE], const unsigned char nonce[NONCE_SIZE], unsigned int counter = 0);
+
+    unsigned int counter() const { return _state[12]; }
+    void counter(unsigned int c) { _state[12] = c; }
+
+    // Keystream block at the counter, which is then incremented
+    void block(unsigned char out[BLOCK_SIZE]);
+
+    // out = in ^ keystream (in place too) from the counter on; the rest of the keystream of a partial block is dropped
+    void crypt(unsigned char * out, const unsigned char * in, unsigned int length);
+
+private:
+    void keystream(unsigned int x[16]);
+
+private:
+    unsigned int _state[16] __attribute__((aligned(16)));
+};
+
+
+// ChaCha20-Poly1305 Authenticated Encryption with Associated Data (RFC 8439)
+// Poly1305 is keyed by the first ChaCha20 block of each nonce and the message is encrypted from the next block on.
+// Buffers are taken BLOCK_SIZE bytes at a time, each authenticated right after it is encrypted (or right before it is
+// decrypted), while still in cache, so each is only gone through once. decrypt() checks the tag in constant time and
+// clears the plaintext if it does not match. A nonce must never be used twice with the same key.
+class ChaCha20_Poly1305
+{
+public:
+    static const unsigned int KEY_SIZE = ChaCha20::KEY_SIZE;
+    static const unsigned int NONCE_SIZE = ChaCha20::NONCE_SIZE;
+    static const unsigned int TAG_SIZE = 16;
+
+private:
+    static const unsigned int BLOCK_SIZE = ChaCha20::BLOCK_SIZE;
+
+public:
+    ChaCha20_Poly1305(const unsigned char key[KEY_SIZE]) { memcpy(_key, key, KEY_SIZE); }
+
+    void encrypt(unsigned char * out, unsigned char tag[TAG_SIZE], const unsigned char nonce[NONCE_SIZE],
+                 const unsigned char * in, unsigned int length, const unsigned char * aad = 0, unsigned int aad_length = 0);
+    bool decrypt(unsigned char * out, const unsigned char tag[TAG_SIZE], const unsigned char nonce[NONCE_SIZE],
+                 const unsigned char * in, unsigned int length, const unsigned char * aad = 0, unsigned int aad_length = 0);
+
+private:
+    void crypt(unsigned char * out, unsigned char tag[TAG_SIZE], const unsigned char nonce[NONCE_SIZE],
+               const unsigned char * in, unsigned int length, const unsigned char * aad, unsigned int aad_length,
+               bool encrypt);
+
+private:
+    unsigned char _key[KEY_SIZE];
+};
+
+__END_UTIL
+
+#endif
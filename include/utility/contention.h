@@ -0,0 +1,132 @@
+// EPOS Lock Contention Profiler Utility Declarations
+
+#ifndef __contention_h
+#define __contention_h
+
+#include <architecture.h>
+#include <utility/atomic.h>
+#include <utility/trace.h>
+
+__BEGIN_UTIL
+
+template<bool enabled>
+class Lock_Statistics;
+
+// Lock contention profiler (enabled by Traits<Synchronizer>::profiled)
+// Each Mutex, Semaphore and recursive spin lock embeds a Statistics object, which counts its acquisitions and, for
+// those that had to wait, the time spent waiting (in TSC ticks), the longest wait and the longest queue seen. The
+// caller of the last contended acquisition is kept along, so hot spots can be told apart even for locks shared by many
+// call sites. The HOT_SPOTS most contended locks are registered here and dump() prints them, the hottest first, one
+// "! lock caller acquisitions contentions wait max_wait max_queue" line each, whose callers addr2line can symbolize.
+// reset() only empties the registry, while each lock's statistics are read (and reset) through the lock itself.
+class Contention
+{
+    template<bool> friend class Lock_Statistics;
+
+public:
+    static const bool enabled = Traits<Synchronizer>::profiled;
+    static const unsigned int HOT_SPOTS = enabled ? Traits<Synchronizer>::HOT_SPOTS : 1;
+
+    typedef TSC::Time_Stamp Time_Stamp;
+    typedef Lock_Statistics<enabled> Statistics;
+
+private:
+    struct Hot_Spot {
+        const void * lock;
+        const Lock_Statistics<true> * statistics;
+    };
+
+public:
+    static void dump();
+    static void reset();
+
+private:
+    static void hot(const void * lock, const Lock_Statistics<true> * statistics);
+    static void forget(const Lock_Statistics<true> * statistics);
+
+private:
+    static Hot_Spot _hot_spots[HOT_SPOTS];
+    static volatile bool _lock;
+};
+
+// Updated by the lock owner, or by waiters holding the kernel lock, so only the acquisitions count must be atomic
+template<bool enabled>
+class Lock_Statistics
+{
+public:
+    typedef Contention::Time_Stamp Time_Stamp;
+
+public:
+    Lock_Statistics(): _contentions(0), _wait_time(0), _max_wait(0), _max_queue(0), _caller(0) {}
+    ~Lock_Statistics() { Contention::forget(this); }
+
+    // Stamps the beginning of a wait, behind "queue" other waiters (0 if unknown) and before the lock is taken
+    Time_Stamp contended(unsigned int queue) {
+        if(queue > _max_queue)
+            _max_queue = queue;
+        return TSC::time_stamp();
+    }
+
+    // Accounts for an acquisition, which waited since "since" (as returned by contended()), if it is not 0
+    void acquired(const void * lock, const Time_Stamp & since = 0, const void * caller = __builtin_return_address(0)) {
+        _acquisitions++;
+        if(!since)
+            return;
+
+        Time_Stamp wait = TSC::time_stamp() - since;
+        _contentions++;
+        _wait_time += wait;
+        if(wait > _max_wait)
+            _max_wait = wait;
+        _caller = caller;
+        Contention::hot(lock, this);
+        Trace::lock(lock, caller, wait);
+    }
+
+    unsigned int acquisitions() const { return _acquisitions; }
+    unsigned int contentions() const { return _contentions; }
+    Time_Stamp wait_time() const { return _wait_time; }
+    Time_Stamp max_wait() const { return _max_wait; }
+    unsigned int max_queue() const { return _max_queue; }
+    const void * caller() const { return _caller; }
+
+    void reset() {
+        _acquisitions = 0;
+        _contentions = 0;
+        _wait_time = _max_wait = 0;
+        _max_queue = 0;
+    }
+
+private:
+    Atomic<unsigned int> _acquisitions;
+    volatile unsigned int _contentions;
+    Time_Stamp _wait_time;
+    Time_Stamp _max_wait;
+    unsigned int _max_queue;
+    const void * _caller;
+};
+
+// Nothing is counted without the profiler
+template<>
+class Lock_Statistics<false>
+{
+public:
+    typedef Contention::Time_Stamp Time_Stamp;
+
+public:
+    Time_Stamp contended(unsigned int queue) { return 0; }
+    void acquired(const void * lock, const Time_Stamp & since = 0, const void * caller = 0) {}
+
+    unsigned int acquisitions() const { return 0; }
+    unsigned int contentions() const { return 0; }
+    Time_Stamp wait_time() const { return 0; }
+    Time_Stamp max_wait() const { return 0; }
+    unsigned int max_queue() const { return 0; }
+    const void * caller() const { return 0; }
+
+    void reset() {}
+};
+
+__END_UTIL
+
+#endif
@@ -1,5 +1,14 @@
 // EPOS CRC Utility Declarations
 
+// Table-driven CRCs that take SLICES bytes per step, with a 256-entry table for each of them built at compile time
+// (table k holds the CRC of a byte followed by k zeros). All of them can be computed incrementally, over data arriving
+// in chunks, by passing the CRC of the previous chunks as the last argument:
+//     unsigned int crc = CRC::crc32(header, sizeof(header));
+//     crc = CRC::crc32(payload, length, crc);
+// crc16() is CRC-16/XMODEM (polynomial 0x1021, MSB first, no final XOR), crc32() is the CRC-32 of Ethernet and zlib
+// (0x04c11db7, reflected) and crc32c() is Castagnoli's (0x1edc6f41, reflected), used by iSCSI, SCTP and ext4.
+// On AArch64 cores with the CRC32 extension, crc32() and crc32c() use its instructions instead of the tables.
+
 #ifndef __crc_h
 #define __crc_h
 
@@ -9,24 +18,44 @@ __BEGIN_UTIL
 
 class CRC
 {
-public:
-    static unsigned short crc16(char * ptr, int size) {
-        unsigned short crc = 0;
-
-        while(--size >= 0) {
-            crc ^= (unsigned short)(*ptr++) << 8;
-            int i = 8;
-            do{
-        	if(crc & 0x8000)
-        	    crc = (crc << 1) ^ 0x1021;
-        	else
-        	    crc = crc << 1;
-            } while(--i);
+private:
+    static const unsigned int SLICES = 8;
+
+    template<typename T, T POLY, bool REFLECTED>
+    struct Table
+    {
+        constexpr Table(): t() {
+            for(unsigned int x = 0; x < 256; x++) {
+                T crc = REFLECTED ? T(x) : T(T(x) << (sizeof(T) * 8 - 8));
+                for(unsigned int i = 0; i < 8; i++) {
+                    if(REFLECTED)
+                        crc = (crc & 1) ? T((crc >> 1) ^ POLY) : T(crc >> 1);
+                    else
+                        crc = (crc >> (sizeof(T) * 8 - 1)) ? T((crc << 1) ^ POLY) : T(crc << 1);
+                }
+                t[0][x] = crc;
+            }
+            for(unsigned int k = 1; k < SLICES; k++)
+                for(unsigned int x = 0; x < 256; x++)
+                    t[k][x] = REFLECTED ? T((t[k - 1][x] >> 8) ^ t[0][t[k - 1][x] & 0xff])
+                                        : T((t[k - 1][x] << 8) ^ t[0][t[k - 1][x] >> (sizeof(T) * 8 - 8)]);
         }
 
-        return crc;
-    }
+        T t[SLICES][256];
+    };
+
+public:
+    static unsigned short crc16(const void * data, unsigned int size, unsigned short crc = 0);
+    static unsigned int crc32(const void * data, unsigned int size, unsigned int crc = 0);
+    static unsigned int crc32c(const void * data, unsigned int size, unsigned int crc = 0);
+
+private:
+    static unsigned int reflected(const unsigned int (* t)[256], const unsigned char * data, unsigned int size, unsigned int crc);
 
+private:
+    static const Table<unsigned short, 0x1021, false> _crc16;
+    static const Table<unsigned int, 0xedb88320, true> _crc32;
+    static const Table<unsigned int, 0x82f63b78, true> _crc32c;
 };
 
 __END_UTIL
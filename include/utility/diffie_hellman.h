@@ -8,6 +8,13 @@
 
 __BEGIN_UTIL
 
+// Public keys are multiples of the default base point, taken with a fixed-base comb: the scalar's bits are read in
+// COMB_TEETH rows of COMB_SPACING bits, and each column of them picks one of the 2^COMB_TEETH - 1 sums of the rows' base
+// points, precomputed once in affine coordinates for all instances, so a multiplication takes COMB_SPACING doublings
+// and as many mixed additions at most. Other points (e.g. the peer's public key, to compute a shared key) are
+// multiplied through the width-WINDOW non-adjacent form of the scalar, whose nonzero digits are odd multiples up to
+// 2^(WINDOW-1) - 1 precomputed for each point and are at least WINDOW bits apart, so there is about one addition for
+// every WINDOW + 1 doublings instead of one for every two.
 template<typename Cipher>
 class Diffie_Hellman
 {
@@ -18,8 +25,17 @@ public:
 private:
     typedef _UTIL::Bignum<SECRET_SIZE> Bignum;
 
+    static const unsigned int BITS = SECRET_SIZE * 8;
+    static const unsigned int COMB_TEETH = 4;
+    static const unsigned int COMB_SPACING = (BITS + COMB_TEETH - 1) / COMB_TEETH;
+
     class Elliptic_Curve_Point
     {
+        friend class Diffie_Hellman;
+
+    private:
+        static const unsigned int WINDOW = 4;
+
     public:
         typedef typename Diffie_Hellman::Bignum Coordinate;
 
@@ -38,8 +54,24 @@ private:
         }
 
     private:
+        void to_montgomery() {
+            x.to_montgomery();
+            y.to_montgomery();
+            z.to_montgomery();
+        }
+        void to_affine();
+
+        void negate() {
+            Coordinate n(0);
+            n -= y;
+            y = n;
+        }
+
         void jacobian_double();
         void add_jacobian_affine(const Elliptic_Curve_Point &b);
+        void add_jacobian(const Elliptic_Curve_Point &b);
+
+        static int naf(signed char * digits, const Coordinate & b);
 
     public:
         Coordinate x, y, z;
@@ -50,14 +82,14 @@ public:
     typedef Bignum Shared_Key;
     typedef Bignum Private_Key;
 
-    Diffie_Hellman() {
+    Diffie_Hellman(): _fixed(true) {
         new (&_base_point.x) Bignum(_default_base_point_x, SECRET_SIZE);
         new (&_base_point.y) Bignum(_default_base_point_y, SECRET_SIZE);
         _base_point.z = 1;
         generate_keypair();
     }
 
-    Diffie_Hellman(const Elliptic_Curve_Point & base_point): _base_point(base_point) {
+    Diffie_Hellman(const Elliptic_Curve_Point & base_point): _base_point(base_point), _fixed(false) {
         generate_keypair();
     }
 
@@ -82,18 +114,28 @@ private:
         db<Diffie_Hellman>(INF) << "Diffie_Hellman Private: " << _private << endl;
         db<Diffie_Hellman>(INF) << "Diffie_Hellman Base Point: " << _base_point << endl;
 
-        _public = _base_point;
-        _public *= _private;
+        if(_fixed)
+            comb_multiply(_public, _private);
+        else {
+            _public = _base_point;
+            _public *= _private;
+        }
 
         db<Diffie_Hellman>(INF) << "Diffie_Hellman Public: " << _public << endl;
     }
 
+    static void build_comb();
+    static void comb_multiply(Elliptic_Curve_Point & p, const Bignum & k);
+
 private:
     Private_Key _private;
     Elliptic_Curve_Point _base_point;
     Elliptic_Curve_Point _public;
+    bool _fixed; // _base_point is the default one, whose comb is shared
     static const char _default_base_point_x[SECRET_SIZE];
     static const char _default_base_point_y[SECRET_SIZE];
+    static bool _combed;
+    static Elliptic_Curve_Point _comb[1 << COMB_TEETH]; // _comb[i] = sum of 2^(j * COMB_SPACING) * G for bits j in i
 };
 
 //TODO: base point is dependent of SECRET_SIZE
@@ -116,51 +158,181 @@ const char Diffie_Hellman<Cipher>::_default_base_point_y[SECRET_SIZE] =
 };
 
 template<typename Cipher>
-void Diffie_Hellman<Cipher>::Elliptic_Curve_Point::operator*=(const Coordinate & b)
+bool Diffie_Hellman<Cipher>::_combed;
+
+template<typename Cipher>
+typename Diffie_Hellman<Cipher>::Elliptic_Curve_Point Diffie_Hellman<Cipher>::_comb[1 << COMB_TEETH];
+
+// The teeth (the base point shifted by each row) are doubled from one another and every other entry is a sum of two
+// previous ones; all of them are kept in the Montgomery form, with z = 1, ready for add_jacobian_affine()
+template<typename Cipher>
+void Diffie_Hellman<Cipher>::build_comb()
 {
-    // Finding last '1' bit of b
-    static const unsigned int bits_in_digit = sizeof(typename Coordinate::Digit) * 8;
+    Elliptic_Curve_Point tooth;
+    new (&tooth.x) Bignum(_default_base_point_x, SECRET_SIZE);
+    new (&tooth.y) Bignum(_default_base_point_y, SECRET_SIZE);
+    tooth.z = 1;
+    tooth.to_montgomery();
+    _comb[1] = tooth;
+
+    for(unsigned int j = 1; j < COMB_TEETH; j++) {
+        for(unsigned int i = 0; i < COMB_SPACING; i++)
+            tooth.jacobian_double();
+        tooth.to_affine();
+        tooth.to_montgomery();
+        _comb[1 << j] = tooth;
+    }
 
-    typename Coordinate::Digit now;
-    unsigned int b_len = sizeof(Coordinate) / sizeof(typename Coordinate::Digit);
-    for(; (b_len > 1) && (b[b_len - 1] == 0); b_len--);
-    if((b_len == 0) || (b[b_len - 1] == 0)) {
-        x = 0;
-        y = 0;
-        z = 0;
-        return;
+    for(unsigned int i = 3; i < (1U << COMB_TEETH); i++) {
+        unsigned int low = i & -i;
+        if(i == low)
+            continue;
+        Elliptic_Curve_Point sum(_comb[i - low]);
+        sum.add_jacobian_affine(_comb[low]);
+        sum.to_affine();
+        sum.to_montgomery();
+        _comb[i] = sum;
     }
 
-    now = b[b_len - 1];
+    _combed = true;
+}
 
-    bool bin[bits_in_digit]; // Binary representation of 'now'
-    unsigned int current_bit = bits_in_digit;
+template<typename Cipher>
+void Diffie_Hellman<Cipher>::comb_multiply(Elliptic_Curve_Point & p, const Bignum & k)
+{
+    static const unsigned int BITS_PER_DIGIT = Bignum::BITS_PER_DIGIT;
 
-    Elliptic_Curve_Point pp(*this);
+    if(!_combed)
+        build_comb();
 
-    for(int i = bits_in_digit - 1; i >= 0; i--) {
-        if(now % 2)
-            current_bit = i + 1;
-        bin[i] = now % 2;
-        now /= 2;
-    }
+    bool started = false;
+    for(int column = COMB_SPACING - 1; column >= 0; column--) {
+        if(started)
+            p.jacobian_double();
 
-    for(int i = b_len - 1; i >= 0; i--) {
-        for(; current_bit < bits_in_digit; current_bit++) {
-            jacobian_double();
-            if(bin[current_bit])
-                add_jacobian_affine(pp);
+        unsigned int i = 0;
+        for(unsigned int j = 0; j < COMB_TEETH; j++) {
+            unsigned int bit = j * COMB_SPACING + column;
+            if((bit < BITS) && ((k[bit / BITS_PER_DIGIT] >> (bit % BITS_PER_DIGIT)) & 1))
+                i |= 1 << j;
         }
-        if(i > 0) {
-            now = b[i-1];
-            for(int j = bits_in_digit-1; j >= 0; j--) {
-                bin[j] = now % 2;
-                now /= 2;
+
+        if(i) {
+            if(started)
+                p.add_jacobian_affine(_comb[i]);
+            else {
+                p = _comb[i];
+                started = true;
+            }
+        }
+    }
+
+    if(started)
+        p.to_affine();
+    else {
+        p.x = 0;
+        p.y = 0;
+        p.z = 0;
+    }
+}
+
+// Width-WINDOW NAF of b, least significant digit first, returning the index of the most significant (-1 if b = 0)
+template<typename Cipher>
+int Diffie_Hellman<Cipher>::Elliptic_Curve_Point::naf(signed char * digits, const Coordinate & b)
+{
+    typedef typename Coordinate::Digit Digit;
+    typedef typename Coordinate::Double_Digit Double_Digit;
+    static const unsigned int DIGITS = Coordinate::DIGITS;
+    static const unsigned int BITS_PER_DIGIT = Coordinate::BITS_PER_DIGIT;
+
+    // One more digit, since subtracting a negative digit might carry beyond the top one
+    Digit k[DIGITS + 1];
+    for(unsigned int i = 0; i < DIGITS; i++)
+        k[i] = b[i];
+    k[DIGITS] = 0;
+
+    int top = -1;
+    for(unsigned int i = 0; i <= BITS; i++) {
+        int d = 0;
+        if(k[0] & 1) {
+            d = k[0] & ((1 << WINDOW) - 1);
+            if(d >= (1 << (WINDOW - 1)))
+                d -= 1 << WINDOW;
+
+            // k -= d, which clears its WINDOW low bits
+            if(d > 0)
+                k[0] -= d; // only the low bits of k[0] change
+            else {
+                Double_Digit c = -d;
+                for(unsigned int j = 0; c && (j <= DIGITS); j++) {
+                    c += k[j];
+                    k[j] = c;
+                    c >>= BITS_PER_DIGIT;
+                }
             }
-            current_bit = 0;
+            top = i;
         }
+        digits[i] = d;
+
+        for(unsigned int j = 0; j < DIGITS; j++)
+            k[j] = (k[j] >> 1) | (k[j + 1] << (BITS_PER_DIGIT - 1));
+        k[DIGITS] >>= 1;
     }
 
+    return top;
+}
+
+// The point can be in any Jacobian coordinates (z = 1 for affine ones); its odd multiples are computed and added as
+// they are, with full Jacobian additions, which are cheaper than the field inversions to make them affine
+template<typename Cipher>
+void Diffie_Hellman<Cipher>::Elliptic_Curve_Point::operator*=(const Coordinate & b)
+{
+    signed char digits[BITS + 1];
+    int top = naf(digits, b);
+    if(top < 0) {
+        x = 0;
+        y = 0;
+        z = 0;
+        return;
+    }
+
+    // The coordinates are kept in the Montgomery form along the whole multiplication
+    to_montgomery();
+
+    // odd[i] = (2 * i + 1) * this
+    Elliptic_Curve_Point odd[1 << (WINDOW - 2)];
+    Elliptic_Curve_Point twice(*this);
+    twice.jacobian_double();
+    odd[0] = *this;
+    for(unsigned int i = 1; i < (1 << (WINDOW - 2)); i++) {
+        odd[i] = odd[i - 1];
+        odd[i].add_jacobian(twice);
+    }
+
+    // The most significant digit of a NAF is positive
+    *this = odd[digits[top] / 2];
+    for(int i = top - 1; i >= 0; i--) {
+        jacobian_double();
+        if(digits[i] > 0)
+            add_jacobian(odd[digits[i] / 2]);
+        else if(digits[i] < 0) {
+            Elliptic_Curve_Point n(odd[-digits[i] / 2]);
+            n.negate();
+            add_jacobian(n);
+        }
+    }
+
+    to_affine();
+}
+
+// From the Montgomery form in Jacobian coordinates back to affine ones (z = 1), outside the Montgomery form
+template<typename Cipher>
+void Diffie_Hellman<Cipher>::Elliptic_Curve_Point::to_affine()
+{
+    x.from_montgomery();
+    y.from_montgomery();
+    z.from_montgomery();
+
     Coordinate Z;
     z.invert();
     Z = z;
@@ -173,28 +345,29 @@ void Diffie_Hellman<Cipher>::Elliptic_Curve_Point::operator*=(const Coordinate &
     z = 1;
 }
 
+// These operate on coordinates in the Montgomery form, multiplying by small constants with additions
 template<typename Cipher>
 void Diffie_Hellman<Cipher>::Elliptic_Curve_Point::jacobian_double()
 {
     Coordinate B, C(x), aux(z);
 
-    aux *= z; C -= aux;
-    aux += x; C *= aux;
-    C *= 3;
+    aux.montgomery_multiply(z); C -= aux;
+    aux += x; C.montgomery_multiply(aux);
+    aux = C; C += aux; C += aux;
 
-    z *= y; z *= 2;
+    z.montgomery_multiply(y); z += z;
 
-    y *= y; B = y;
+    y.montgomery_multiply(y); B = y;
 
-    y *= x; y *= 4;
+    y.montgomery_multiply(x); y += y; y += y;
 
-    B *= B; B *= 8;
+    B.montgomery_multiply(B); B += B; B += B; B += B;
 
-    x = C; x *= x;
-    aux = y; aux *= 2;
+    x = C; x.montgomery_multiply(x);
+    aux = y; aux += aux;
     x -= aux;
 
-    y -= x; y *= C;
+    y -= x; y.montgomery_multiply(C);
     y -= B;
 }
 
@@ -203,38 +376,65 @@ void Diffie_Hellman<Cipher>::Elliptic_Curve_Point::add_jacobian_affine(const Ell
 {
     Coordinate A(z), B, C, X, Y, aux, aux2;
 
-    A *= z;
+    A.montgomery_multiply(z);
 
     B = A;
 
-    A *= b.x;
+    A.montgomery_multiply(b.x);
 
-    B *= z; B *= b.y;
+    B.montgomery_multiply(z); B.montgomery_multiply(b.y);
 
     C = A; C -= x;
 
     B -= y;
 
-    X = B; X *= B;
-    aux = C; aux *= C;
+    X = B; X.montgomery_multiply(B);
+    aux = C; aux.montgomery_multiply(C);
 
     Y = aux;
 
-    aux2 = aux; aux *= C;
-    aux2 *= 2; aux2 *= x;
+    aux2 = aux; aux.montgomery_multiply(C);
+    aux2 += aux2; aux2.montgomery_multiply(x);
     aux += aux2; X -= aux;
 
-    aux = Y; Y *= x;
-    Y -= X; Y *= B;
-    aux *= y; aux *= C;
+    aux = Y; Y.montgomery_multiply(x);
+    Y -= X; Y.montgomery_multiply(B);
+    aux.montgomery_multiply(y); aux.montgomery_multiply(C);
     Y -= aux;
 
-    z *= C;
+    z.montgomery_multiply(C);
 
     x = X; y = Y;
 }
 
+template<typename Cipher>
+void Diffie_Hellman<Cipher>::Elliptic_Curve_Point::add_jacobian(const Elliptic_Curve_Point &b)
+{
+    Coordinate Z1Z1(z), Z2Z2(b.z), U1(x), U2(b.x), S1(y), S2(b.y), H, R, HH, HHH, V;
+
+    Z1Z1.montgomery_multiply(z);
+    Z2Z2.montgomery_multiply(b.z);
+
+    U1.montgomery_multiply(Z2Z2);
+    U2.montgomery_multiply(Z1Z1);
+    S1.montgomery_multiply(b.z); S1.montgomery_multiply(Z2Z2);
+    S2.montgomery_multiply(z); S2.montgomery_multiply(Z1Z1);
+
+    H = U2; H -= U1;
+    R = S2; R -= S1;
 
+    HH = H; HH.montgomery_multiply(H);
+    HHH = HH; HHH.montgomery_multiply(H);
+    V = U1; V.montgomery_multiply(HH);
+
+    x = R; x.montgomery_multiply(R);
+    x -= HHH; x -= V; x -= V;
+
+    y = V; y -= x; y.montgomery_multiply(R);
+    S1.montgomery_multiply(HHH); y -= S1;
+
+    z.montgomery_multiply(b.z); z.montgomery_multiply(H);
+}
 
 __END_UTIL
 
@@ -0,0 +1,157 @@
+// EPOS Dynamic Vector Utility Declarations
+
+#ifndef __dynamic_vector_h
+#define __dynamic_vector_h
+
+#include <utility/heap.h>
+
+__BEGIN_UTIL
+
+// Dynamic Vector
+// Objects are kept by value, contiguously, in an array that grows geometrically (by half of its capacity) from a Heap
+// whenever it gets full. Objects are moved, not copied, into a new array and when insert() and remove() shift them.
+// The first INLINE objects are kept inside the vector itself, so vectors that are usually small never touch the heap
+// and a vector without a heap holds at most INLINE objects. Insertions return false when there is no room left.
+template<typename T, unsigned int INLINE = 0>
+class Dynamic_Vector
+{
+public:
+    typedef T Object_Type;
+
+public:
+    Dynamic_Vector(Heap * heap = 0): _heap(heap), _data(storage()), _size(0), _capacity(INLINE) {}
+
+    Dynamic_Vector(Dynamic_Vector && v): _heap(v._heap), _data(storage()), _size(0), _capacity(INLINE) {
+        if(v._data != v.storage()) {
+            _data = v._data;
+            _size = v._size;
+            _capacity = v._capacity;
+            v._data = v.storage();
+            v._size = 0;
+            v._capacity = INLINE;
+        } else {
+            for(; _size < v._size; _size++)
+                new (&_data[_size]) T(move(v._data[_size]));
+            v.clear();
+        }
+    }
+
+    Dynamic_Vector(const Dynamic_Vector &) = delete;
+    Dynamic_Vector & operator=(const Dynamic_Vector &) = delete;
+
+    ~Dynamic_Vector() {
+        clear();
+        release(_data);
+    }
+
+    unsigned int size() const { return _size; }
+    unsigned int capacity() const { return _capacity; }
+    bool empty() const { return (_size == 0); }
+
+    T & operator[](unsigned int i) { assert(i < _size); return _data[i]; }
+    const T & operator[](unsigned int i) const { assert(i < _size); return _data[i]; }
+
+    T * begin() { return _data; }
+    T * end() { return _data + _size; }
+    const T * begin() const { return _data; }
+    const T * end() const { return _data + _size; }
+
+    T & front() { return _data[0]; }
+    T & back() { return _data[_size - 1]; }
+
+    // Makes room for at least n objects, so the next insertions up to n don't move them
+    bool reserve(unsigned int n) {
+        if(n <= _capacity)
+            return true;
+        if(!_heap)
+            return false;
+
+        T * data = reinterpret_cast<T *>(_heap->try_alloc(n * sizeof(T)));
+        if(!data)
+            return false;
+
+        db<Vectors>(TRC) << "Dynamic_Vector::reserve(n=" << n << ") => " << data << endl;
+
+        for(unsigned int i = 0; i < _size; i++) {
+            new (&data[i]) T(move(_data[i]));
+            _data[i].~T();
+        }
+        release(_data);
+        _data = data;
+        _capacity = n;
+
+        return true;
+    }
+
+    template<typename ... Tn>
+    bool emplace(unsigned int i, Tn && ... an) {
+        assert(i <= _size);
+
+        // The new object is made before anything moves, since the arguments might be in the array
+        if(_size == _capacity) {
+            T o(forward<Tn>(an) ...);
+            if(!reserve(_capacity + ((_capacity > 1) ? _capacity / 2 : 2)))
+                return false;
+            return emplace(i, move(o));
+        }
+
+        if(i == _size)
+            new (&_data[i]) T(forward<Tn>(an) ...);
+        else {
+            T o(forward<Tn>(an) ...);
+            new (&_data[_size]) T(move(_data[_size - 1]));
+            for(unsigned int j = _size - 1; j > i; j--)
+                _data[j] = move(_data[j - 1]);
+            _data[i] = move(o);
+        }
+        _size++;
+
+        return true;
+    }
+
+    template<typename ... Tn>
+    bool emplace_back(Tn && ... an) { return emplace(_size, forward<Tn>(an) ...); }
+
+    bool insert(unsigned int i, const T & o) { return emplace(i, o); }
+    bool insert(unsigned int i, T && o) { return emplace(i, move(o)); }
+    bool push_back(const T & o) { return emplace(_size, o); }
+    bool push_back(T && o) { return emplace(_size, move(o)); }
+
+    void remove(unsigned int i) {
+        assert(i < _size);
+
+        for(unsigned int j = i; j + 1 < _size; j++)
+            _data[j] = move(_data[j + 1]);
+        _data[--_size].~T();
+    }
+
+    void pop_back() { remove(_size - 1); }
+
+    void clear() {
+        while(_size)
+            _data[--_size].~T();
+    }
+
+private:
+    T * storage() { return reinterpret_cast<T *>(_storage); }
+
+    void release(T * data) {
+        if(data == storage())
+            return;
+        if(Traits<System>::multiheap)
+            Heap::typed_free(data);
+        else
+            Heap::untyped_free(_heap, data);
+    }
+
+private:
+    Heap * _heap;
+    T * _data;
+    unsigned int _size;
+    unsigned int _capacity;
+    char _storage[INLINE ? INLINE * sizeof(T) : 1] __attribute__((aligned(__alignof__(T))));
+};
+
+__END_UTIL
+
+#endif
@@ -12,8 +12,32 @@
 #define EI_MAG3 3
 #define ELFMAG3 'F'
 
+#define ET_EXEC 2
+#define ET_DYN 3
+
 #define PT_NULL 0
 #define PT_LOAD 1
+#define PT_DYNAMIC 2
+
+#define PF_X 0x1
+#define PF_W 0x2
+#define PF_R 0x4
+
+#define DT_NULL 0
+#define DT_RELA 7
+#define DT_RELASZ 8
+#define DT_RELAENT 9
+#define DT_REL 17
+#define DT_RELSZ 18
+#define DT_RELENT 19
+
+#define R_386_RELATIVE 8
+#define R_ARM_RELATIVE 23
+#define R_AARCH64_RELATIVE 1027
+#define R_RISCV_RELATIVE 3
+
+#define ELF32_R_TYPE(i) ((i) & 0xff)
+#define ELF64_R_TYPE(i) ((i) & 0xffffffff)
 
 typedef unsigned short Elf32_Half;
 typedef unsigned short Elf64_Half;
@@ -25,6 +49,8 @@ typedef unsigned long Elf32_Addr;
 typedef unsigned long Elf64_Addr;
 typedef unsigned long Elf32_Off;
 typedef unsigned long Elf64_Off;
+typedef long Elf32_Sword;
+typedef long long Elf64_Sxword;
 
 struct Elf32_Ehdr
 {
@@ -86,4 +112,42 @@ struct Elf64_Phdr
   Elf64_Xword p_align;
 };
 
+struct Elf32_Dyn
+{
+  Elf32_Sword d_tag;
+  Elf32_Addr d_ptr; // or d_val
+};
+
+struct Elf64_Dyn
+{
+  Elf64_Sxword d_tag;
+  Elf64_Addr d_ptr; // or d_val
+};
+
+struct Elf32_Rel
+{
+  Elf32_Addr r_offset;
+  Elf32_Word r_info;
+};
+
+struct Elf64_Rel
+{
+  Elf64_Addr r_offset;
+  Elf64_Xword r_info;
+};
+
+struct Elf32_Rela
+{
+  Elf32_Addr r_offset;
+  Elf32_Word r_info;
+  Elf32_Sword r_addend;
+};
+
+struct Elf64_Rela
+{
+  Elf64_Addr r_offset;
+  Elf64_Xword r_info;
+  Elf64_Sxword r_addend;
+};
+
 #endif
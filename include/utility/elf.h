@@ -5,6 +5,7 @@
 
 #include <system/config.h>
 #include "elf-linux.h"
+#include <utility/page_writer.h>
 
 __BEGIN_UTIL
 
@@ -12,9 +13,34 @@ typedef IF<Traits<CPU>::WORD_SIZE == 32, Elf32_Ehdr, Elf64_Ehdr>::Result Elf_Ehd
 typedef IF<Traits<CPU>::WORD_SIZE == 32, Elf32_Addr, Elf64_Addr>::Result Elf_Addr;
 typedef IF<Traits<CPU>::WORD_SIZE == 32, Elf32_Word, Elf64_Word>::Result Elf_Word;
 typedef IF<Traits<CPU>::WORD_SIZE == 32, Elf32_Phdr, Elf64_Phdr>::Result Elf_Phdr;
+typedef IF<Traits<CPU>::WORD_SIZE == 32, Elf32_Sword, Elf64_Sxword>::Result Elf_Sword;
+typedef IF<Traits<CPU>::WORD_SIZE == 32, Elf32_Dyn, Elf64_Dyn>::Result Elf_Dyn;
+typedef IF<Traits<CPU>::WORD_SIZE == 32, Elf32_Rel, Elf64_Rel>::Result Elf_Rel;
+typedef IF<Traits<CPU>::WORD_SIZE == 32, Elf32_Rela, Elf64_Rela>::Result Elf_Rela;
 
 class ELF: private Elf_Ehdr
 {
+public:
+    // Segment flag (from the range reserved to operating systems) set by eposmkbi -z on segments whose contents are
+    // LZ4-compressed in the file, in which case p_offset points to the compressed block (see utility/lz4.h)
+    static const Elf_Word PF_LZ4 = 0x00100000;
+
+    // The only relocation position independent executables (ET_DYN, -static-pie) have is "base + addend"
+    static const Elf_Word R_RELATIVE = (Traits<Build>::ARCHITECTURE == Traits<Build>::IA32) ? R_386_RELATIVE
+                                     : (Traits<Build>::ARCHITECTURE == Traits<Build>::ARMv7) ? R_ARM_RELATIVE
+                                     : (Traits<Build>::ARCHITECTURE == Traits<Build>::ARMv8) ? R_AARCH64_RELATIVE
+                                     : R_RISCV_RELATIVE;
+
+    // Where a range of link addresses went, to relocate the addresses inside it
+    struct Placement {
+        Elf_Addr link;
+        Elf_Addr size;
+        Elf_Addr load;
+    };
+
+    template<typename Sink, unsigned int PAGE = 256>
+    class Stream;
+
 public:
     ELF() {}
 
@@ -26,21 +52,124 @@ public:
 
     Elf_Addr entry() { return e_entry; }
 
+    bool relocatable() { return e_type == ET_DYN; }
+
     int segments() { return e_phnum; }
 
     Elf_Word segment_type(int i) { return (i > segments()) ? PT_NULL : seg(i)->p_type; }
 
+    Elf_Word segment_flags(int i) { return (i > segments()) ? 0 : seg(i)->p_flags; }
+
     Elf_Addr segment_address(int i) { return (i > segments()) ? 0 : seg(i)->p_align ? seg(i)->p_vaddr: (seg(i)->p_vaddr & ~(seg(i)->p_align - 1)); }
 
-    int segment_size(int i) { return (i > segments()) ? -1 : (int)(((seg(i)->p_offset % seg(i)->p_align) + seg(i)->p_memsz + seg(i)->p_align - 1) & ~(seg(i)->p_align - 1)); }
+    // p_vaddr and p_offset are congruent modulo p_align, but only p_vaddr is preserved by eposmkbi -z
+    int segment_size(int i) { return (i > segments()) ? -1 : (int)(((seg(i)->p_vaddr % seg(i)->p_align) + seg(i)->p_memsz + seg(i)->p_align - 1) & ~(seg(i)->p_align - 1)); }
 
-    int load_segment(int i, Elf_Addr addr = 0);
+    int load_segment(int i, Elf_Addr addr = 0) { return load_segment(i, addr, 0, 0); }
+
+    // Loads segment "i" at "addr", relocating the R_RELATIVE words in it as they are copied, in a single pass over the
+    // segment (a second one only for LZ4-compressed segments), by the Placement that holds their link addresses
+    int load_segment(int i, Elf_Addr addr, const Placement * map, unsigned int n);
+
+    static Elf_Addr relocate(Elf_Addr addr, const Placement * map, unsigned int n) {
+        for(unsigned int i = 0; i < n; i++)
+            if(addr - map[i].link < map[i].size)
+                return map[i].load + (addr - map[i].link);
+        return addr;
+    }
 
 private:
+    // The file contents at a link address, if they are there uncompressed
+    void * image(Elf_Addr addr);
+
+    // The value of a tag in the dynamic section
+    bool dynamic(Elf_Sword tag, Elf_Addr * value);
     Elf_Phdr * pht() { return (Elf_Phdr *)(((char *) this) + e_phoff); }
     Elf_Phdr * seg(int i) { return &pht()[i];  }
 };
 
+
+// Incremental ELF decoder
+// Takes an image in chunks of any size and hands the file contents of its loadable segments to "sink" (through a
+// Page_Writer) at their physical addresses, i.e. where they are stored, which is what flashing an image is about.
+// The ELF header and the program header table must be in the first HEADER bytes, which are held until they are all
+// in, and segments must not be compressed (see eposmkbi -z).
+template<typename Sink, unsigned int PAGE>
+class ELF::Stream
+{
+private:
+    static const unsigned int HEADER = 512;
+
+public:
+    Stream(Sink * sink): _writer(sink), _offset(0), _error(false) {}
+
+    // Returns false once the image turned out to be invalid
+    bool feed(const void * data, unsigned int size) {
+        const char * d = reinterpret_cast<const char *>(data);
+        if(_error)
+            return false;
+
+        if(_offset < HEADER) {
+            unsigned int n = (size < HEADER - _offset) ? size : HEADER - _offset;
+            memcpy(&_header[_offset], d, n);
+            _offset += n;
+            d += n;
+            size -= n;
+            if(_offset < HEADER)
+                return true;
+            if(!check())
+                return false;
+            write(0, _header, HEADER);
+        }
+
+        write(_offset, d, size);
+        _offset += size;
+
+        return true;
+    }
+
+    // Flushes what is pending and returns the number of bytes written to the sink, or -1 if the image was invalid
+    long finish() {
+        if(!_error && (_offset < HEADER) && check())
+            write(0, _header, _offset);
+        _writer.flush();
+        return _error ? -1 : static_cast<long>(_writer.bytes());
+    }
+
+    Elf_Addr entry() { return elf()->entry(); }
+
+private:
+    ELF * elf() { return reinterpret_cast<ELF *>(_header); }
+
+    bool check() {
+        ELF * e = elf();
+        _error = (_offset < sizeof(Elf_Ehdr)) || !e->valid() || (e->e_phoff + e->segments() * sizeof(Elf_Phdr) > _offset);
+        for(int i = 0; !_error && (i < e->segments()); i++)
+            _error = (e->seg(i)->p_type == PT_LOAD) && (e->seg(i)->p_flags & PF_LZ4);
+        return !_error;
+    }
+
+    // Writes the parts of [offset, offset + size) of the file that are in loadable segments
+    void write(Elf_Addr offset, const char * data, unsigned int size) {
+        ELF * e = elf();
+        for(int i = 0; i < e->segments(); i++) {
+            Elf_Phdr * s = e->seg(i);
+            if(s->p_type != PT_LOAD)
+                continue;
+            Elf_Addr begin = (offset > s->p_offset) ? offset : s->p_offset;
+            Elf_Addr end = ((offset + size) < (s->p_offset + s->p_filesz)) ? offset + size : s->p_offset + s->p_filesz;
+            if(begin < end)
+                _writer.write(s->p_paddr + (begin - s->p_offset), data + (begin - offset), end - begin);
+        }
+    }
+
+private:
+    Page_Writer<Sink, PAGE> _writer;
+    Elf_Addr _offset;
+    bool _error;
+    char _header[HEADER] __attribute__((aligned(8)));
+};
+
 __END_UTIL
 
 #endif
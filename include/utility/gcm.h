@@ -0,0 +1,80 @@
+// EPOS GHASH and AES-GCM Utility Declarations
+
+#ifndef __gcm_h
+#define __gcm_h
+
+#include <utility/string.h>
+#include <utility/aes.h>
+
+__BEGIN_UTIL
+
+// GHASH, the universal hash of the Galois/Counter Mode (NIST SP 800-38D): Y = (Y ^ X) * H in GF(2^128)
+// Blocks are multiplied with CPU carry-less multiply instructions (PCLMULQDQ, PMULL or RISC-V Zbc clmul) where the
+// compiler targets them, and with a constant-time software one elsewhere, always as three 64 x 64-bit products. With
+// H^2..H^PARALLEL kept along with H, PARALLEL blocks are hashed as Y' = (Y ^ X1) * H^4 ^ X2 * H^3 ^ X3 * H^2 ^ X4 * H,
+// whose products are independent of each other and are reduced once, instead of one block after the other.
+class GHASH
+{
+public:
+    static const unsigned int BLOCK_SIZE = 16;
+    static const unsigned int PARALLEL = 4;
+
+private:
+    typedef unsigned long long Word;
+
+public:
+    GHASH() {}
+    GHASH(const unsigned char h[BLOCK_SIZE]) { key(h); }
+
+    void key(const unsigned char h[BLOCK_SIZE]);
+    void reset() { _y[0] = _y[1] = 0; }
+
+    // A last partial block is zero-padded, so only the last piece of a message may have any length
+    void update(const unsigned char * data, unsigned int length);
+    void digest(unsigned char out[BLOCK_SIZE]) const;
+
+private:
+    Word _h[PARALLEL][3];       // H^(i+1) as its high and low halves and their xor (for Karatsuba)
+    Word _y[2];
+};
+
+
+// AES-128 in Galois/Counter Mode (NIST SP 800-38D) with 96-bit IVs and 128-bit tags
+// The message goes through SWAES CTR and GHASH PARALLEL blocks at a time, each chunk authenticated right after it is
+// encrypted (or right before it is decrypted), so both engines get several independent blocks per call and buffers
+// are only gone through once. decrypt() checks the tag in constant time and clears the plaintext if it does not
+// match. An IV must never be used twice with the same key.
+class AES_GCM
+{
+public:
+    static const unsigned int KEY_SIZE = 16;
+    static const unsigned int IV_SIZE = 12;
+    static const unsigned int TAG_SIZE = 16;
+
+private:
+    typedef SWAES<16> AES;
+
+    static const unsigned int BLOCK_SIZE = AES::BLOCK_SIZE;
+    static const unsigned int CHUNK = AES::PARALLEL * BLOCK_SIZE;
+
+public:
+    AES_GCM(const unsigned char key[KEY_SIZE]);
+
+    void encrypt(unsigned char * out, unsigned char tag[TAG_SIZE], const unsigned char iv[IV_SIZE],
+                 const unsigned char * in, unsigned int length, const unsigned char * aad = 0, unsigned int aad_length = 0);
+    bool decrypt(unsigned char * out, const unsigned char tag[TAG_SIZE], const unsigned char iv[IV_SIZE],
+                 const unsigned char * in, unsigned int length, const unsigned char * aad = 0, unsigned int aad_length = 0);
+
+private:
+    void crypt(unsigned char * out, unsigned char tag[TAG_SIZE], const unsigned char iv[IV_SIZE],
+               const unsigned char * in, unsigned int length, const unsigned char * aad, unsigned int aad_length,
+               bool encrypt);
+
+private:
+    AES _aes;
+    GHASH _ghash;
+};
+
+__END_UTIL
+
+#endif
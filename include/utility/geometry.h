@@ -33,6 +33,17 @@ public:
         return sqrt(xx*xx + yy*yy);
     }
 
+    // Euclidean distances to n points, the square roots taken in bulk once all squares are known
+    template<typename P>
+    void distances(const P * p, unsigned int n, Distance * d) const {
+        for(unsigned int i = 0; i < n; i++) {
+            Larger_T xx = p[i].x > x ? p[i].x - x : x - p[i].x;
+            Larger_T yy = p[i].y > y ? p[i].y - y : y - p[i].y;
+            d[i] = xx*xx + yy*yy;
+        }
+        Math::sqrt(d, d, n);
+    }
+
     // Translation
     template<typename P>
     Point & operator-=(const P & p) {
@@ -119,6 +130,18 @@ public:
         return Math::sqrt(xx * xx + yy * yy + zz * zz);
     }
 
+    // Euclidean distances to n points, the square roots taken in bulk once all squares are known
+    template<typename P>
+    void distances(const P * p, unsigned int n, Distance * d) const {
+        for(unsigned int i = 0; i < n; i++) {
+            Distance xx = p[i].x > x ? p[i].x - x : x - p[i].x;
+            Distance yy = p[i].y > y ? p[i].y - y : y - p[i].y;
+            Distance zz = p[i].z > z ? p[i].z - z : z - p[i].z;
+            d[i] = xx * xx + yy * yy + zz * zz;
+        }
+        Math::sqrt(d, d, n);
+    }
+
     // Translation
     template<typename P>
     Point & operator-=(const P & p) {
@@ -49,6 +49,58 @@ private:
     T * _ptr;
 };
 
+// A function and its context kept by value, so callers needn't keep a handler object alive and calling it is a single
+// indirect call to a stub that calls the function directly (with bind(), the stub is made for that very function).
+// Delegates can be made at compile time and Handler objects convert to them, at the price of their virtual call.
+class Delegate
+{
+public:
+    typedef Handler::Function Function;
+
+private:
+    union Context {
+        constexpr Context(): object(0) {}
+        constexpr Context(void * o): object(o) {}
+        constexpr Context(Function * f): function(f) {}
+
+        void * object;
+        Function * function;
+    };
+
+    typedef void (Stub)(const Context &);
+
+public:
+    constexpr Delegate(): _stub(&nothing) {}
+    constexpr Delegate(Function * f): _stub(&function), _context(f) {}
+    constexpr Delegate(Handler * h): _stub(&handler), _context(h) {}
+
+    template<typename T, void (* F)(T *)>
+    static constexpr Delegate bind(T * o) { return Delegate(&functor<T, F>, o); }
+
+    template<typename T, void (T::* M)()>
+    static constexpr Delegate bind(T * o) { return Delegate(&method<T, M>, o); }
+
+    void operator()() const { _stub(_context); }
+
+    bool empty() const { return _stub == &nothing; }
+    const void * context() const { return _context.object; }
+
+private:
+    constexpr Delegate(Stub * s, void * o): _stub(s), _context(o) {}
+
+    static void nothing(const Context &) {}
+    static void function(const Context & c) { c.function(); }
+    static void handler(const Context & c) { (*static_cast<Handler *>(c.object))(); }
+    template<typename T, void (* F)(T *)>
+    static void functor(const Context & c) { F(static_cast<T *>(c.object)); }
+    template<typename T, void (T::* M)()>
+    static void method(const Context & c) { (static_cast<T *>(c.object)->*M)(); }
+
+private:
+    Stub * _stub;
+    Context _context;
+};
+
 __END_UTIL
 
 #endif
@@ -6,6 +6,7 @@
 #include <system/config.h>
 #include "list.h"
 #include "vector.h"
+#include "heap.h"
 
 __BEGIN_UTIL
 
@@ -205,6 +206,165 @@ private:
     List _table[SIZE];
 };
 
+
+// Open-Addressing Hash Table (Robin Hood)
+// Objects are kept by key in a single array of slots, probed linearly from the slot each key hashes to (its home).
+// Insertion keeps probe sequences short by letting a key that is further from its home take the slot of one that is
+// closer, which moves on instead. Removal shifts the keys that follow back, instead of leaving tombstones, so a
+// lookup can stop at the first key that is closer to its home than the one searched for.
+// The table starts with the SIZE (a power of two) slots embedded in it. If given a Heap, it doubles from it whenever
+// it becomes more than 7/8 full; otherwise insert() fails once every slot is taken. Keys are unique. The hash of a
+// key is "key % ~0U", so, just like Simple_Hash, it can be changed by redefining operator % for Key, and it is then
+// spread over the table by Fibonacci hashing.
+template<typename T, unsigned int SIZE = 64, typename Key = int>
+class Open_Hash
+{
+private:
+    static_assert(SIZE >= 2 && !(SIZE & (SIZE - 1)), "Open_Hash SIZE must be a power of two");
+
+    struct Slot {
+        Key key;
+        T * object;
+        unsigned int distance;  // from home + 1, 0 if the slot is empty
+    };
+
+public:
+    typedef T Object_Type;
+    typedef Key Key_Type;
+
+public:
+    Open_Hash(Heap * heap = 0): _slots(_embedded), _bits(log2(SIZE)), _size(0), _heap(heap) { clear(_slots, SIZE); }
+    ~Open_Hash() { if(_slots != _embedded) release(_slots); }
+
+    bool empty() const { return !_size; }
+    unsigned int size() const { return _size; }
+    unsigned int capacity() const { return 1U << _bits; }
+
+    bool insert(const Key & key, T * obj) {
+        if((_size + 1) * 8 > capacity() * 7)
+            if(!grow() && (_size == capacity()))
+                return false;
+
+        if(!place(_slots, _bits, key, obj))
+            return false;
+
+        _size++;
+        return true;
+    }
+
+    T * search_key(const Key & key) {
+        unsigned int i = find(key);
+        return (i != NONE) ? _slots[i].object : 0;
+    }
+
+    T * remove_key(const Key & key) {
+        unsigned int i = find(key);
+        if(i == NONE)
+            return 0;
+
+        T * obj = _slots[i].object;
+        unsigned int mask = capacity() - 1;
+        for(unsigned int n = (i + 1) & mask; _slots[n].distance > 1; i = n, n = (n + 1) & mask) {
+            _slots[i] = _slots[n];
+            _slots[i].distance--;
+        }
+        _slots[i].distance = 0;
+        _size--;
+
+        return obj;
+    }
+
+private:
+    static const unsigned int NONE = ~0U;
+
+    static unsigned int log2(unsigned int n) { unsigned int b = 0; for(; n > 1; n >>= 1) b++; return b; }
+
+    static unsigned int home(const Key & key, unsigned int bits) {
+        unsigned int h = key % ~0U;
+        return (h * 2654435769U) >> (32 - bits);
+    }
+
+    static void clear(Slot * slots, unsigned int n) {
+        for(unsigned int i = 0; i < n; i++)
+            slots[i].distance = 0;
+    }
+
+    unsigned int find(const Key & key) const {
+        unsigned int mask = capacity() - 1;
+        unsigned int i = home(key, _bits);
+        for(unsigned int d = 1; _slots[i].distance >= d; d++, i = (i + 1) & mask)
+            if((_slots[i].distance == d) && (_slots[i].key == key))
+                return i;
+        return NONE;
+    }
+
+    // Robin Hood insertion into a table known to have an empty slot; fails if the key is already there
+    static bool place(Slot * slots, unsigned int bits, Key key, T * obj) {
+        unsigned int mask = (1U << bits) - 1;
+        unsigned int i = home(key, bits);
+        for(unsigned int d = 1; ; d++, i = (i + 1) & mask) {
+            Slot & s = slots[i];
+            if(!s.distance) {
+                s.key = key;
+                s.object = obj;
+                s.distance = d;
+                return true;
+            }
+            if((s.distance == d) && (s.key == key))
+                return false;
+            if(s.distance < d) { // s is closer to its home than key would be: key takes its slot and s moves on
+                Key k = s.key;
+                T * o = s.object;
+                unsigned int sd = s.distance;
+                s.key = key;
+                s.object = obj;
+                s.distance = d;
+                key = k;
+                obj = o;
+                d = sd;
+            }
+        }
+    }
+
+    bool grow() {
+        if(!_heap)
+            return false;
+
+        unsigned int bits = _bits + 1;
+        Slot * slots = reinterpret_cast<Slot *>(_heap->try_alloc(sizeof(Slot) << bits));
+        if(!slots)
+            return false;
+
+        db<Lists>(TRC) << "Open_Hash::grow(this=" << this << ",capacity=" << (1U << bits) << ")" << endl;
+
+        clear(slots, 1U << bits);
+        for(unsigned int i = 0; i < capacity(); i++)
+            if(_slots[i].distance)
+                place(slots, bits, _slots[i].key, _slots[i].object);
+
+        if(_slots != _embedded)
+            release(_slots);
+        _slots = slots;
+        _bits = bits;
+
+        return true;
+    }
+
+    void release(Slot * slots) {
+        if(Traits<System>::multiheap)
+            Heap::typed_free(slots);
+        else
+            Heap::untyped_free(_heap, slots);
+    }
+
+private:
+    Slot * _slots;
+    unsigned int _bits;
+    unsigned int _size;
+    Heap * _heap;
+    Slot _embedded[SIZE];
+};
+
 __END_UTIL
 
 #endif
@@ -4,92 +4,737 @@
 #define __heap_h
 
 #include <utility/debug.h>
+#include <utility/string.h>
 #include <utility/list.h>
 #include <utility/spin.h>
+#include <utility/tlsf.h>
+#include <utility/log.h>
+#include <utility/per_cpu.h>
 
 __BEGIN_UTIL
 
+// Per-CPU rings of Heap allocations and deallocations (enabled by Traits<System>::heap_traced)
+// Records keep the bytes asked for (not the rounded block sizes), so traces taken from real workloads with dump() can
+// be replayed against other Heap configurations to compare their fragmentation and latency (see tools/eposbench).
+class Heap_Trace
+{
+public:
+    static const bool enabled = Traits<System>::heap_traced;
+    static const unsigned int EVENTS = enabled ? Traits<System>::HEAP_TRACE_EVENTS : 1;
+
+    struct Record {
+        TSC::Time_Stamp ts;
+        const void * heap;
+        const void * addr;          // as returned by alloc(), 0 if it failed
+        unsigned long bytes;        // asked for by alloc(), 0 for a free()
+    };
+
+public:
+    static void record(const void * heap, const void * addr, unsigned long bytes) {
+        if(!enabled)
+            return;
+
+        bool ie = CPU::int_enabled();
+        CPU::int_disable();
+
+        unsigned int cpu = CPU::id();
+        Record & r = _ring[cpu][_head[cpu]++ % EVENTS];
+        r.ts = TSC::time_stamp();
+        r.heap = heap;
+        r.addr = addr;
+        r.bytes = bytes;
+
+        if(ie)
+            CPU::int_enable();
+    }
+
+    static void dump();
+    static void reset();
+
+private:
+    static Per_CPU<unsigned int> _head;
+    static Record _ring[Traits<Build>::CPUS][EVENTS];
+};
+
+// Per-site accounting of the blocks handed out by malloc() and new (enabled by Traits<System>::heap_profiled)
+// Each block carries, in the word before its size, the index of the site (the PC of the inlined malloc() or new) that
+// allocated it, so free() can credit the site back wherever the block is freed. Sites are found by hashing, as in
+// Profiler, and blocks whose site finds no room in the table are left untagged and counted as dropped. dump() prints
+// one "@site pc live blocks allocations" line per site (live in bytes, headers included), also at out of memory.
+class Heap_Profiler
+{
+public:
+    static const bool enabled = Traits<System>::heap_profiled;
+    static const unsigned int SITES = enabled ? Traits<System>::HEAP_SITES : 1;
+    static const unsigned int PROBES = 8;
+
+    struct Site {
+        const void * pc;
+        unsigned long live;
+        unsigned int blocks;
+        unsigned int allocations;
+    };
+
+public:
+    static void tag(void * ptr, const void * pc) {
+        if(!enabled || !ptr)
+            return;
+
+        long * addr = reinterpret_cast<long *>(ptr);
+        bool ie = enter();
+        unsigned long h = reinterpret_cast<unsigned long>(pc) >> 1;
+        for(unsigned int i = 0; i < PROBES; i++, h++) {
+            Site & s = _sites[h % SITES];
+            if(!s.pc)
+                s.pc = pc;
+            if(s.pc == pc) {
+                s.live += addr[-1];
+                s.blocks++;
+                s.allocations++;
+                addr[-2] = h % SITES + 1;
+                leave(ie);
+                return;
+            }
+        }
+        _dropped++;
+        leave(ie);
+    }
+
+    static void untag(void * ptr) {
+        if(!enabled)
+            return;
+
+        long * addr = reinterpret_cast<long *>(ptr);
+        if(!addr[-2])
+            return;
+
+        bool ie = enter();
+        Site & s = _sites[addr[-2] - 1];
+        s.live -= addr[-1];
+        s.blocks--;
+        addr[-2] = 0;
+        leave(ie);
+    }
+
+    static void dump();
+
+private:
+    static bool enter() {
+        bool ie = CPU::int_enabled();
+        CPU::int_disable();
+        if(Traits<System>::multicore)
+            _lock.acquire();
+        return ie;
+    }
+
+    static void leave(bool ie) {
+        if(Traits<System>::multicore)
+            _lock.release();
+        if(ie)
+            CPU::int_enable();
+    }
+
+private:
+    static Spin _lock;
+    static unsigned int _dropped;
+    static Site _sites[SITES];
+};
+
 // Heap
+// Free memory is kept either in a first-fit list of blocks ordered by address (the default) or, with
+// Traits<System>::tlsf, in a two-level segregated fit allocator, whose alloc() and free() are O(1).
+// With Traits<System>::magazines, small blocks are rounded up to GRAIN-byte classes and recycled through
+// per-CPU magazines (stacks) that are refilled from and flushed to the free memory in batches, so most
+// allocations and deallocations of small objects don't take the heap lock.
+// With Traits<System>::heap_statistics, alloc() and free() also keep the counters returned by statistics().
+// With Traits<System>::heap_traced, they are also recorded in a Heap_Trace.
+// With Traits<System>::heap_profiled, blocks have room for a Heap_Profiler site, which release() credits back.
+// Blocks start with a header holding their size (preceded by the owner heap with multiheap); aligned blocks are
+// cut from a free block at the right place and the rest of it stays free, and realloc() grows blocks in place
+// when the memory right after them is free. Running out of memory is fatal, except for bounded heaps (see Segment_Heap).
+// With Traits<System>::HEAP_SHRINKERS, callbacks registered with shrinker() are asked to give back cached memory before
+// alloc() fails, which then tries once more, and also whenever a successful alloc() leaves the heap with less than
+// HEAP_LOW_WATERMARK free bytes. try_alloc() never calls them.
+// A heap with a Resizer (see Segment_Heap) also grows through it before alloc() fails, and lets it give back the top
+// of its memory whenever a block freed to the heap (not to a magazine) leaves it free.
 class Heap: private Grouping_List<char>
 {
 protected:
     static const bool typed = Traits<System>::multiheap;
+    static const bool smp = Traits<System>::multicore;
+    static const bool tlsf = Traits<System>::tlsf;
+    static const bool cached = Traits<System>::magazines;
+    static const bool monitored = Traits<System>::heap_statistics;
+    static const bool profiled = Traits<System>::heap_profiled;
+    static const unsigned int SHRINKERS = Traits<System>::HEAP_SHRINKERS;
+    static const unsigned long LOW_WATERMARK = Traits<System>::HEAP_LOW_WATERMARK;
+
+    static const unsigned int HEADER = (typed ? sizeof(void *) : 0) + (profiled ? sizeof(long) : 0) + sizeof(long);
+
+    static const unsigned int GRAIN = 16;
+    static const unsigned int CLASSES = cached ? 8 : 1;                             // blocks up to 128 bytes
+    static const unsigned int MAGAZINE = cached ? Traits<System>::MAGAZINE_SIZE : 1;
+
+    typedef Grouping_List<char> List;
+    typedef TLSF<tlsf ? 32 : 1> Segregated_Fit; // heaps up to 4 GB
+
+    struct Magazine {
+        unsigned int count;
+        void * blocks[MAGAZINE];
+    };
 
 public:
-    using Grouping_List<char>::empty;
-    using Grouping_List<char>::size;
-    using Grouping_List<char>::grouped_size;
+    // Frees (to any heap) at least "bytes" of the memory a cache holds, if it can, and returns how much it freed
+    typedef unsigned long (Shrinker)(unsigned long bytes);
+
+    // Gives the heap room for at least "bytes" more (through extend()) or, with 0, maybe takes some back (through trim())
+    typedef bool (Resizer)(Heap * heap, unsigned long bytes);
+
+public:
+    static const unsigned int BUCKETS = monitored ? 16 : 1; // blocks up to 512 KB
+
+    // Sizes include the block headers and the rounding done by alloc()
+    struct Statistics {
+        unsigned long allocated;            // bytes in blocks given by alloc() and not yet freed
+        unsigned long peak;                 // high-water mark of allocated
+        unsigned long allocations;
+        unsigned long failures;
+        unsigned long free;                 // bytes in the free blocks (blocks cached in magazines are allocated)
+        unsigned long free_blocks;
+        unsigned long largest;              // the largest free block, which bounds the largest allocation that can succeed
+        unsigned long histogram[BUCKETS];   // allocations by size: bucket i counts blocks up to 16 << i bytes (the last one, all larger blocks)
+
+        friend OStream & operator<<(OStream & os, const Statistics & s) {
+            os << "{alloc=" << s.allocated << ",peak=" << s.peak << ",allocs=" << s.allocations << ",fails=" << s.failures
+               << ",free=" << s.free << ",blocks=" << s.free_blocks << ",largest=" << s.largest
+               << ",frag=" << (s.free ? 100 - s.largest * 100 / s.free : 0) << "%,hist={";
+            for(unsigned int i = 0; i < BUCKETS; i++)
+                os << ((i > 0) ? "," : "") << s.histogram[i];
+            os << "}}";
+            return os;
+        }
+    };
+
+public:
+    bool empty() const { return tlsf ? _tlsf.empty() : List::empty(); }
+    unsigned int size() const { return tlsf ? _tlsf.size() : List::size(); }
+    unsigned int grouped_size() const { return tlsf ? _tlsf.grouped_size() : List::grouped_size(); }
 
     Heap() {
         db<Init, Heaps>(TRC) << "Heap() => " << this << endl;
+
+        init();
     }
 
     Heap(void * addr, unsigned long bytes) {
         db<Init, Heaps>(TRC) << "Heap(addr=" << addr << ",bytes=" << bytes << ") => " << this << endl;
 
+        init();
         free(addr, bytes);
     }
 
     void * alloc(unsigned long bytes) {
+        void * addr = try_alloc(bytes);
+        if(!addr && bytes && (shrink(bytes) || grow(bytes + HEADER)))
+            addr = try_alloc(bytes);
+        if(!addr && bytes)
+            out_of_memory(bytes);
+        else if(SHRINKERS && LOW_WATERMARK)
+            watermark();
+        return addr;
+    }
+
+    // Like alloc(), but returns 0 instead of panicking if there is no free block large enough (e.g. to try a faster heap first)
+    void * try_alloc(unsigned long bytes) {
         db<Heaps>(TRC) << "Heap::alloc(this=" << this << ",bytes=" << bytes;
 
         if(!bytes)
             return 0;
 
+        unsigned long request = bytes;
         if(!Traits<CPU>::unaligned_memory_access)
             while((bytes % sizeof(void *)))
                 ++bytes;
 
         if(typed)
             bytes += sizeof(void *);  // add room for heap pointer
+        if(profiled)
+            bytes += sizeof(long);    // add room for site
         bytes += sizeof(long);        // add room for size
         if(bytes < sizeof(Element))
             bytes = sizeof(Element);
 
-        Element * e = search_decrementing(bytes);
-        if(!e) {
-            out_of_memory(bytes);
+        long * addr;
+        if(cached && (bytes <= CLASSES * GRAIN)) {
+            bytes = (bytes + GRAIN - 1) / GRAIN * GRAIN;
+            addr = reinterpret_cast<long *>(cached_alloc(bytes));
+            if(monitored) {
+                bool enabled = enter();
+                account(addr, bytes);
+                leave(enabled);
+            }
+        } else {
+            bool enabled = enter();
+            addr = reinterpret_cast<long *>(take(bytes));
+            if(monitored)
+                account(addr, bytes);
+            leave(enabled);
+        }
+        if(!addr) {
+            db<Heaps>(TRC) << ") => failed!" << endl;
+            Heap_Trace::record(this, 0, request);
             return 0;
         }
 
-        long * addr = reinterpret_cast<long *>(e->object() + e->size());
+        if(typed)
+            *addr++ = reinterpret_cast<long>(this);
+        if(profiled)
+            *addr++ = 0;
+        *addr++ = bytes;
+
+        db<Heaps>(TRC) << ") => " << reinterpret_cast<void *>(addr) << endl;
+        Log::log("Heap::alloc(h=%p,b=%u) => %p", this, bytes, addr);
+        Heap_Trace::record(this, addr, request);
+
+        return addr;
+    }
+
+    // Returns a block whose address is a multiple of align (a power of two). Small ones bypass the magazines
+    void * alloc(unsigned long bytes, unsigned long align) {
+        db<Heaps>(TRC) << "Heap::alloc(this=" << this << ",bytes=" << bytes << ",align=" << align;
+
+        if(!bytes)
+            return 0;
+
+        unsigned long request = bytes;
+        if(align < sizeof(long))
+            align = sizeof(long);
+        bytes = round(bytes);
+        if(cached && (bytes <= CLASSES * GRAIN))
+            bytes = (bytes + GRAIN - 1) / GRAIN * GRAIN; // so release() finds its magazine
+
+        long * addr = reinterpret_cast<long *>(take_accounted(bytes, align));
+        if(!addr && (shrink(bytes) || grow(bytes + align)))
+            addr = reinterpret_cast<long *>(take_accounted(bytes, align));
+        if(!addr) {
+            Heap_Trace::record(this, 0, request);
+            out_of_memory(bytes);
+            return 0;
+        }
 
         if(typed)
             *addr++ = reinterpret_cast<long>(this);
+        if(profiled)
+            *addr++ = 0;
         *addr++ = bytes;
 
         db<Heaps>(TRC) << ") => " << reinterpret_cast<void *>(addr) << endl;
+        Log::log("Heap::alloc(h=%p,b=%u,a=%u) => %p", this, bytes, align, addr);
+        Heap_Trace::record(this, addr, request);
+        if(SHRINKERS && LOW_WATERMARK)
+            watermark();
 
         return addr;
     }
 
+    // Gives the heap "bytes" of memory at "ptr"
     void free(void * ptr, unsigned int bytes) {
         db<Heaps>(TRC) << "Heap::free(this=" << this << ",ptr=" << ptr << ",bytes=" << bytes << ")" << endl;
 
-        if(ptr && (bytes >= sizeof(Element))) {
-            Element * e = new (ptr) Element(reinterpret_cast<char *>(ptr), bytes);
-            Element * m1, * m2;
-            insert_merging(e, &m1, &m2);
+        if(tlsf) {
+            if(ptr) {
+                bool enabled = enter();
+                _tlsf.free_region(ptr, bytes);
+                leave(enabled);
+            }
+        } else if(ptr && (bytes >= sizeof(Element))) {
+            bool enabled = enter();
+            give(ptr, bytes);
+            leave(enabled);
         }
     }
 
     static void typed_free(void * ptr) {
         long * addr = reinterpret_cast<long *>(ptr);
         unsigned long bytes = *--addr;
+        if(profiled)
+            --addr;
         Heap * heap = reinterpret_cast<Heap *>(*--addr);
-        heap->free(addr, bytes);
+        heap->release(addr, bytes);
     }
 
     static void untyped_free(Heap * heap, void * ptr) {
         long * addr = reinterpret_cast<long *>(ptr);
         unsigned long bytes = *--addr;
-        heap->free(addr, bytes);
+        if(profiled)
+            --addr;
+        heap->release(addr, bytes);
+    }
+
+    static void * typed_realloc(void * ptr, unsigned long bytes) {
+        long * addr = reinterpret_cast<long *>(ptr);
+        Heap * heap = reinterpret_cast<Heap *>(addr[profiled ? -3 : -2]);
+        return heap->realloc(ptr, bytes);
+    }
+
+    static void * untyped_realloc(Heap * heap, void * ptr, unsigned long bytes) { return heap->realloc(ptr, bytes); }
+
+    // Registers a callback to release memory under pressure (up to HEAP_SHRINKERS of them, for all heaps), which is
+    // called with no heap locked and interrupts as the allocating thread had them
+    static bool shrinker(Shrinker * s);
+
+    // A snapshot of the counters, with the free block figures taken from the free list (or TLSF) as it is now
+    Statistics statistics() {
+        bool enabled = enter();
+
+        Statistics s = _statistics;
+        if(tlsf) {
+            s.free = _tlsf.grouped_size();
+            s.free_blocks = _tlsf.size();
+            s.largest = _tlsf.largest();
+        } else {
+            s.free = List::grouped_size();
+            s.free_blocks = List::size();
+            s.largest = 0;
+            for(Element * e = List::head(); e; e = e->next())
+                if(e->size() > s.largest)
+                    s.largest = e->size();
+        }
+
+        leave(enabled);
+
+        return s;
+    }
+
+protected:
+    // Gives the heap "bytes" of memory right after the region it was given (with free()) that ends at "end"
+    void extend(void * end, unsigned long bytes) {
+        db<Heaps>(TRC) << "Heap::extend(this=" << this << ",end=" << end << ",bytes=" << bytes << ")" << endl;
+
+        if(tlsf) {
+            bool enabled = enter();
+            _tlsf.grow(end, bytes);
+            leave(enabled);
+        } else
+            free(end, bytes);
+    }
+
+    // Takes multiples of "unit" bytes back from the free block that ends at "end", if there is one, leaving at least
+    // "keep" bytes of it. Returns how many bytes were taken.
+    unsigned long trim(void * end, unsigned long unit, unsigned long keep) {
+        bool enabled = enter();
+
+        unsigned long bytes = 0;
+        if(tlsf)
+            bytes = _tlsf.trim(end, unit, keep);
+        else {
+            if(keep < sizeof(Element))
+                keep = sizeof(Element);
+            Element * e = List::head();
+            for(; e && (e->object() + e->size() != end); e = e->next());
+            if(e && (e->size() >= keep + unit)) {
+                bytes = (e->size() - keep) / unit * unit;
+                List::decrement(e, bytes);
+            }
+        }
+
+        leave(enabled);
+
+        db<Heaps>(TRC) << "Heap::trim(this=" << this << ",end=" << end << ",unit=" << unit << ",keep=" << keep << ") => " << bytes << endl;
+
+        return bytes;
     }
 
 private:
+    void init() {
+        _bounded = false;
+        _resizer = 0;
+
+        for(unsigned int cpu = 0; cpu < Traits<Build>::CPUS; cpu++)
+            for(unsigned int c = 0; c < CLASSES; c++)
+                _magazines[cpu][c].count = 0;
+
+        _statistics.allocated = 0;
+        _statistics.peak = 0;
+        _statistics.allocations = 0;
+        _statistics.failures = 0;
+        _statistics.free = 0;
+        _statistics.free_blocks = 0;
+        _statistics.largest = 0;
+        for(unsigned int i = 0; i < BUCKETS; i++)
+            _statistics.histogram[i] = 0;
+    }
+
+    // Block size for a request, as in alloc()
+    static unsigned long round(unsigned long bytes) {
+        if(!Traits<CPU>::unaligned_memory_access)
+            while((bytes % sizeof(void *)))
+                ++bytes;
+        bytes += HEADER;
+        if(bytes < sizeof(Element))
+            bytes = sizeof(Element);
+        return bytes;
+    }
+
+    // Resizes a block given by alloc(), in place if possible or else moving its contents to a new block
+    void * realloc(void * ptr, unsigned long bytes) {
+        db<Heaps>(TRC) << "Heap::realloc(this=" << this << ",ptr=" << ptr << ",bytes=" << bytes << ")" << endl;
+
+        long * addr = reinterpret_cast<long *>(ptr);
+        unsigned long size = addr[-1];
+        unsigned long need = round(bytes);
+
+        // Blocks cached in magazines must keep their size classes
+        if(!cached || ((size > CLASSES * GRAIN) && (need > CLASSES * GRAIN))) {
+            bool enabled = enter();
+            unsigned long resized = resize(reinterpret_cast<char *>(ptr) - HEADER, size, need);
+            if(monitored && resized)
+                _statistics.allocated += resized - size;
+            leave(enabled);
+            if(resized) {
+                Heap_Profiler::untag(ptr); // malloc()'s realloc() tags it again with the new size
+                addr[-1] = resized;
+                Heap_Trace::record(this, ptr, 0);
+                Heap_Trace::record(this, ptr, bytes);
+                return ptr;
+            }
+        }
+
+        void * moved = alloc(bytes);
+        if(moved) {
+            memcpy(moved, ptr, ((size - HEADER) < bytes) ? (size - HEADER) : bytes);
+            release(reinterpret_cast<char *>(ptr) - HEADER, size);
+        }
+
+        return moved;
+    }
+
+    void * take_accounted(unsigned long bytes, unsigned long align) {
+        bool enabled = enter();
+        void * addr = take(bytes, align);
+        if(monitored)
+            account(addr, bytes);
+        leave(enabled);
+        return addr;
+    }
+
+    // account() must be called with the heap locked
+    void account(void * addr, unsigned long bytes) {
+        if(!addr) {
+            _statistics.failures++;
+            return;
+        }
+
+        _statistics.allocated += bytes;
+        if(_statistics.allocated > _statistics.peak)
+            _statistics.peak = _statistics.allocated;
+        _statistics.allocations++;
+
+        unsigned int i = 0;
+        while((i + 1 < BUCKETS) && (bytes > (16UL << i)))
+            i++;
+        _statistics.histogram[i]++;
+    }
+
+    // Returns a block allocated by alloc(). TLSF finds its size in its boundary tag and coalesces it with its neighbors in O(1)
+    void release(void * ptr, unsigned long bytes) {
+        db<Heaps>(TRC) << "Heap::free(this=" << this << ",ptr=" << ptr << ",bytes=" << bytes << ")" << endl;
+        Log::log("Heap::free(h=%p,p=%p,b=%u)", this, ptr, bytes);
+        Heap_Trace::record(this, reinterpret_cast<char *>(ptr) + HEADER, 0);
+        Heap_Profiler::untag(reinterpret_cast<char *>(ptr) + HEADER);
+
+        if(cached && (bytes <= CLASSES * GRAIN)) {
+            cached_free(ptr, bytes);
+            if(monitored) {
+                bool enabled = enter();
+                _statistics.allocated -= bytes;
+                leave(enabled);
+            }
+        } else {
+            bool enabled = enter();
+            give(ptr, bytes);
+            if(monitored)
+                _statistics.allocated -= bytes;
+            if(_resizer)
+                _resizer(this, 0);
+            leave(enabled);
+        }
+    }
+
+    // take() and give() must be called with the heap locked
+    void * take(unsigned long bytes) {
+        if(tlsf)
+            return _tlsf.alloc(bytes);
+
+        Element * e = search_decrementing(bytes);
+        return e ? e->object() + e->size() : 0;
+    }
+
+    // Takes the block from the end of the first free block it fits in, with its header just before an aligned
+    // address and making sure whatever is left before and after it is either nothing or large enough to be free
+    void * take(unsigned long bytes, unsigned long align) {
+        if(tlsf)
+            return _tlsf.alloc(bytes, align, HEADER);
+
+        for(Element * e = List::head(); e; e = e->next()) {
+            unsigned long start = reinterpret_cast<unsigned long>(e->object());
+            unsigned long end = start + e->size();
+            if(e->size() < bytes)
+                continue;
+
+            unsigned long block = ((end - bytes + HEADER) & ~(align - 1)) - HEADER;
+            while((block >= start + align) && (end - block - bytes) && (end - block - bytes < sizeof(Element)))
+                block -= align;
+            if(block < start)
+                continue;
+            unsigned long head = block - start;
+            unsigned long tail = end - block - bytes;
+            if((head && (head < sizeof(Element))) || (tail && (tail < sizeof(Element))))
+                continue;
+
+            List::decrement(e, end - block);
+            if(tail)
+                give(reinterpret_cast<void *>(block + bytes), tail);
+
+            return reinterpret_cast<void *>(block);
+        }
+
+        return 0;
+    }
+
+    // Returns the new size of a block resized in place, or 0 if that wasn't possible
+    unsigned long resize(char * block, unsigned long size, unsigned long need) {
+        if(tlsf)
+            return _tlsf.resize(block, need) ? need : 0;
+
+        if(need <= size) {
+            if(size - need >= sizeof(Element)) {
+                give(block + need, size - need);
+                return need;
+            }
+            return size;
+        }
+
+        Element * r = List::search(block + size);
+        if(!r || (r->size() < need - size))
+            return 0;
+        unsigned long rest = r->size() - (need - size);
+        if(rest < sizeof(Element)) {
+            need += rest;
+            rest = 0;
+        }
+        List::decrement(r, r->size());
+        if(rest)
+            give(block + need, rest);
+
+        return need;
+    }
+
+    void give(void * ptr, unsigned long bytes) {
+        if(tlsf)
+            _tlsf.free(ptr);
+        else {
+            Element * e = new (ptr) Element(reinterpret_cast<char *>(ptr), bytes);
+            Element * m1, * m2;
+            insert_merging(e, &m1, &m2);
+        }
+    }
+
+    // Magazines belong to a CPU, so disabling interrupts is enough to use them. An empty magazine is
+    // refilled to half its size and a full one is flushed down to half, each under a single heap lock
+    void * cached_alloc(unsigned long bytes) {
+        bool enabled = CPU::int_enabled();
+        CPU::int_disable();
+
+        Magazine & m = _magazines[CPU::id()][bytes / GRAIN - 1];
+        if(!m.count) {
+            bool e = enter();
+            for(; (m.count < (MAGAZINE + 1) / 2) && (m.blocks[m.count] = take(bytes)); m.count++);
+            leave(e);
+        }
+        void * addr = m.count ? m.blocks[--m.count] : 0;
+
+        if(enabled)
+            CPU::int_enable();
+
+        return addr;
+    }
+
+    void cached_free(void * ptr, unsigned long bytes) {
+        bool enabled = CPU::int_enabled();
+        CPU::int_disable();
+
+        Magazine & m = _magazines[CPU::id()][bytes / GRAIN - 1];
+        if(m.count == MAGAZINE) {
+            bool e = enter();
+            while(m.count > MAGAZINE / 2)
+                give(m.blocks[--m.count], bytes);
+            leave(e);
+        }
+        m.blocks[m.count++] = ptr;
+
+        if(enabled)
+            CPU::int_enable();
+    }
+
+    // The heap has its own lock, independent of the scheduler's. Interrupts are
+    // restored to their previous state on leave(), since the heap is also used
+    // during initialization, when they must remain disabled.
+    bool enter() {
+        bool enabled = CPU::int_enabled();
+        CPU::int_disable();
+        if(smp)
+            _lock.acquire();
+        return enabled;
+    }
+
+    void leave(bool enabled) {
+        if(smp)
+            _lock.release();
+        if(enabled)
+            CPU::int_enable();
+    }
+
+    // Calls the shrinkers in turn until they have freed "bytes", unless some thread is already at it
+    static unsigned long shrink(unsigned long bytes);
+
+    // The resizer runs with the heap locked, so no other thread sees it half grown
+    bool grow(unsigned long bytes) {
+        if(!_resizer)
+            return false;
+        bool enabled = enter();
+        bool grown = _resizer(this, bytes);
+        leave(enabled);
+        return grown;
+    }
+
+    void watermark() {
+        unsigned long free = grouped_size();
+        if(free < LOW_WATERMARK)
+            shrink(LOW_WATERMARK - free);
+    }
+
     void out_of_memory(unsigned long bytes);
+
+protected:
+    bool _bounded; // running out isn't fatal: alloc() returns 0 (see Segment_Heap)
+    Resizer * _resizer;
+
+private:
+    Spin _lock;
+    Segregated_Fit _tlsf;
+    Magazine _magazines[Traits<Build>::CPUS][CLASSES];
+    Statistics _statistics;
+
+    static Shrinker * _shrinkers[SHRINKERS ? SHRINKERS : 1];
+    static unsigned int _shrinker_count;
+    static volatile bool _shrinking;
 };
 
 __END_UTIL
 
+// Allocation tag, as in "new (SYSTEM)" (blocks go back to their heap with delete only with Traits<System>::multiheap)
+inline void * operator new(size_t bytes, _UTIL::Heap & heap) { return heap.alloc(bytes); }
+inline void * operator new[](size_t bytes, _UTIL::Heap & heap) { return heap.alloc(bytes); }
+
 #endif
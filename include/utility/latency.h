@@ -0,0 +1,136 @@
+// EPOS Latency Measurement Utility Declarations
+
+#ifndef __latency_h
+#define __latency_h
+
+#include <architecture.h>
+#include <utility/ostream.h>
+
+__BEGIN_UTIL
+
+// Histogram in power-of-two buckets: bucket i counts the values in [2^i, 2^(i+1)), with 0 going to the first bucket
+// and everything beyond the last one to it. The spread between min() and max() is the jitter of what is measured.
+template<unsigned int BUCKETS>
+class Log2_Histogram
+{
+public:
+    typedef unsigned long long Value;
+
+public:
+    Log2_Histogram() { reset(); }
+
+    void add(const Value & v) {
+        unsigned int b = v ? 63 - __builtin_clzll(v) : 0;
+        _buckets[(b < BUCKETS) ? b : BUCKETS - 1]++;
+        if(!_count++ || (v < _min))
+            _min = v;
+        if(v > _max)
+            _max = v;
+    }
+
+    Value count() const { return _count; }
+    Value min() const { return _min; }
+    Value max() const { return _max; }
+    Value bucket(unsigned int i) const { return _buckets[i]; }
+
+    void reset() {
+        _count = _min = _max = 0;
+        for(unsigned int i = 0; i < BUCKETS; i++)
+            _buckets[i] = 0;
+    }
+
+    friend OStream & operator<<(OStream & os, const Log2_Histogram & h) {
+        os << "{n=" << h._count << ",min=" << h._min << ",max=" << h._max << ",jitter=" << h._max - h._min;
+        for(unsigned int i = 0; i < BUCKETS; i++)
+            if(h._buckets[i])
+                os << ",2^" << i << "=" << h._buckets[i];
+        os << "}";
+        return os;
+    }
+
+private:
+    Value _count;
+    Value _min;
+    Value _max;
+    Value _buckets[BUCKETS];
+};
+
+// Nothing is measured without buckets
+template<>
+class Log2_Histogram<0>
+{
+public:
+    typedef unsigned long long Value;
+
+public:
+    void add(const Value & v) {}
+
+    Value count() const { return 0; }
+    Value min() const { return 0; }
+    Value max() const { return 0; }
+    Value bucket(unsigned int i) const { return 0; }
+
+    void reset() {}
+
+    friend OStream & operator<<(OStream & os, const Log2_Histogram & h) { return os << "{}"; }
+};
+
+// Interrupt and wakeup latencies, in TSC ticks (enabled by Traits<Thread>::measured)
+// IC::dispatch() feeds each CPU's timer() with how late its timer interrupt was served, i.e. the time since the
+// compare value was reached (Timer::late(): MTIMECMP on RISC-V, the i8253 reload on PCs), which are the only IRQs with
+// a known time of assertion. Each thread holds a Wakeup, stamped when it is made ready and charged by Thread::dispatch()
+// when it runs next (see Thread::latency()). Histograms can be read at any time, e.g. cout << Latency::timer(0).
+class Latency
+{
+public:
+    static const bool enabled = Traits<Thread>::measured;
+    static const unsigned int BUCKETS = enabled ? Traits<Thread>::LATENCY_BUCKETS : 0;
+
+    typedef TSC::Time_Stamp Time_Stamp;
+    typedef Log2_Histogram<BUCKETS> Histogram;
+
+    // Wakeup-to-run latency of a thread
+    class Wakeup
+    {
+    public:
+        Wakeup(): _since(0) {}
+
+        void ready() {
+            if(enabled)
+                _since = TSC::time_stamp();
+        }
+
+        void run() {
+            if(enabled && _since) {
+                _histogram.add(TSC::time_stamp() - _since);
+                _since = 0;
+            }
+        }
+
+        const Histogram & histogram() const { return _histogram; }
+        void reset() { _histogram.reset(); }
+
+    private:
+        Time_Stamp _since;
+        Histogram _histogram;
+    };
+
+public:
+    // Must be called with interrupts disabled (as interrupt handlers are), so the CPU's histogram isn't shared
+    static void timer_interrupt(const Time_Stamp & late) {
+        if(enabled)
+            _timer[CPU::id()].add(late);
+    }
+
+    static const Histogram & timer(unsigned int cpu) { return _timer[cpu]; }
+
+    static void dump();
+    static void reset();
+
+private:
+    static Histogram _timer[Traits<Build>::CPUS];
+};
+
+__END_UTIL
+
+#endif
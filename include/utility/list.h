@@ -4,6 +4,7 @@
 #define __list_h
 
 #include <system/config.h>
+#include <utility/bitmap.h>
 
 __BEGIN_UTIL
 
@@ -261,6 +262,49 @@ namespace List_Elements
         Element * _prev;
         Element * _next;
     };
+
+    // Skip List Element
+    // Each forward link (one per level the element is in) carries the rank of the element it leads to, so a search
+    // can tell whether to move on without touching that element. The rank, which may only change while the element
+    // is out of a list, and the links come first, so searches mostly stay in the first cache line of each element.
+    template<typename T, typename R = Rank, unsigned int LEVELS = 8>
+    class Skip_Linked_Ordered
+    {
+    public:
+        typedef T Object_Type;
+        typedef R Rank_Type;
+        typedef Skip_Linked_Ordered Element;
+
+        static const unsigned int MAX_LEVELS = LEVELS;
+
+        struct Link {
+            Element * next;
+            R rank;         // of next
+        };
+
+    public:
+        Skip_Linked_Ordered(const T * o, const R & r = 0): _rank(r), _levels(0), _prev(0), _object(o) { _links[0].next = 0; }
+
+        T * object() const { return const_cast<T *>(_object); }
+
+        Element * prev() const { return _prev; }
+        Element * next() const { return _links[0].next; }
+        void prev(Element * e) { _prev = e; }
+
+        const R & rank() const { return _rank; }
+        void rank(const R & r) { _rank = r; }
+
+        unsigned int levels() const { return _levels; }
+        void levels(unsigned int l) { _levels = l; }
+        Link * links() { return _links; }
+
+    private:
+        R _rank;
+        unsigned char _levels;
+        Link _links[LEVELS];
+        Element * _prev;
+        const T * _object;
+    };
 };
 
 
@@ -995,6 +1039,164 @@ template<typename T,
 class Relative_List: public Ordered_List<T, R, El, true> {};
 
 
+// Skip List
+// An ordered list with the interface of Ordered_List, whose elements are also linked, at random, in up to LEVELS
+// sparser lists above it, each about a quarter of the size of the one below, so insert(), remove() and search_rank()
+// take O(log n) steps instead of walking the list. Elements with the same rank keep their insertion order. Levels are
+// drawn from a generator of each list, so lists share no state and operations only touch the list they are applied to.
+template<typename T,
+          typename R = List_Element_Rank,
+          typename El = List_Elements::Skip_Linked_Ordered<T, R> >
+class Skip_List
+{
+public:
+    typedef T Object_Type;
+    typedef R Rank_Type;
+    typedef El Element;
+    typedef List_Iterators::Bidirecional<El> Iterator;
+
+private:
+    typedef typename El::Link Link;
+
+    static const unsigned int LEVELS = El::MAX_LEVELS;
+
+    static_assert(LEVELS && (LEVELS <= 16), "Skip_List levels are drawn from 32-bit random numbers");
+
+public:
+    Skip_List(): _size(0), _levels(1), _tail(0), _seed(0x9e3779b9) {
+        for(unsigned int i = 0; i < LEVELS; i++)
+            _head[i].next = 0;
+    }
+
+    bool empty() const { return (_size == 0); }
+    unsigned int size() const { return _size; }
+
+    Element * head() { return _head[0].next; }
+    Element * tail() { return _tail; }
+
+    Iterator begin() { return Iterator(head()); }
+    Iterator end() { return Iterator(0); }
+
+    void insert(Element * e) {
+        db<Lists>(TRC) << "Skip_List::insert(e=" << e << ",o=" << (e ? e->object() : (void *) -1) << ")" << endl;
+
+        Element * update[LEVELS];
+        Element * p = 0;
+        for(int l = _levels - 1; l >= 0; l--) {
+            while(links(p)[l].next && (links(p)[l].rank <= e->rank()))
+                p = links(p)[l].next;
+            update[l] = p;
+        }
+
+        unsigned int levels = level();
+        for(; _levels < levels; _levels++)
+            update[_levels] = 0;
+
+        e->levels(levels);
+        for(unsigned int l = 0; l < levels; l++) {
+            Link & link = links(update[l])[l];
+            e->links()[l] = link;
+            link.next = e;
+            link.rank = e->rank();
+        }
+
+        e->prev(update[0]);
+        if(e->next())
+            e->next()->prev(e);
+        else
+            _tail = e;
+        _size++;
+    }
+
+    Element * remove() {
+        db<Lists>(TRC) << "Skip_List::remove()" << endl;
+
+        Element * e = head();
+        return e ? remove(e) : 0;
+    }
+
+    Element * remove(Element * e) {
+        db<Lists>(TRC) << "Skip_List::remove(e=" << e << ",o=" << (e ? e->object() : (void *) -1) << ")" << endl;
+
+        Element * update[LEVELS];
+        Element * p = 0;
+        for(int l = _levels - 1; l >= 0; l--) {
+            while(links(p)[l].next && (links(p)[l].rank < e->rank()))
+                p = links(p)[l].next;
+            update[l] = p;
+        }
+
+        // Among elements of the same rank, the one before e in each level is found by walking them
+        for(unsigned int l = 0; l < e->levels(); l++) {
+            Element * q = update[l];
+            while(links(q)[l].next && (links(q)[l].next != e))
+                q = links(q)[l].next;
+            if(!links(q)[l].next)
+                return 0; // not in the list
+            links(q)[l] = e->links()[l];
+        }
+
+        if(e->next())
+            e->next()->prev(e->prev());
+        else
+            _tail = e->prev();
+        while((_levels > 1) && !_head[_levels - 1].next)
+            _levels--;
+        _size--;
+
+        return e;
+    }
+
+    Element * remove(const Object_Type * obj) {
+        db<Lists>(TRC) << "Skip_List::remove(o=" << obj << ")" << endl;
+
+        Element * e = search(obj);
+        return e ? remove(e) : 0;
+    }
+
+    Element * search(const Object_Type * obj) {
+        Element * e = head();
+        for(; e && (e->object() != obj); e = e->next());
+        return e;
+    }
+
+    Element * search_rank(const Rank_Type & rank) {
+        Element * p = 0;
+        for(int l = _levels - 1; l >= 0; l--)
+            while(links(p)[l].next && (links(p)[l].rank < rank))
+                p = links(p)[l].next;
+
+        Element * e = links(p)[0].next;
+        return (e && (e->rank() == rank)) ? e : 0;
+    }
+
+    Element * remove_rank(const Rank_Type & rank) {
+        db<Lists>(TRC) << "Skip_List::remove_rank(r=" << rank << ")" << endl;
+
+        Element * e = search_rank(rank);
+        return e ? remove(e) : 0;
+    }
+
+private:
+    Link * links(Element * e) { return e ? e->links() : _head; }
+
+    // Each pair of zero bits (xorshift32) takes the element one level up, i.e. a quarter of the elements of a level
+    unsigned int level() {
+        _seed ^= _seed << 13;
+        _seed ^= _seed >> 17;
+        _seed ^= _seed << 5;
+        return 1 + __builtin_ctz(_seed | (1U << (2 * (LEVELS - 1)))) / 2;
+    }
+
+private:
+    unsigned int _size;
+    unsigned int _levels;
+    Element * _tail;
+    unsigned int _seed;
+    Link _head[LEVELS];
+};
+
+
 // Doubly-Linked, Scheduling List
 // Objects subject to scheduling must export a type "Criterion" compatible
 // with those available at scheduler.h .
@@ -1097,6 +1299,12 @@ public:
         return _chosen;
     }
 
+    // A single list has no one else to steal from or balance with (see Scheduling_Multilist)
+    Element * steal() { return 0; }
+
+    template<typename V>
+    Element * balance(unsigned int queues, V (* load)(Element *), V (* cost)(Element *)) { return 0; }
+
 private:
     using Base::remove;
     void chosen(Element * e) { _chosen = e; }
@@ -1106,6 +1314,154 @@ private:
 };
 
 
+// Doubly-Linked, Bitmap-Indexed Scheduling List
+// Besides declaring "Criterion", objects subject to scheduling policies that
+// use the Bitmap list must export the BANDS constant to indicate the number of
+// priority bands and the band() method to map a rank onto one of them.
+// Each band is a FIFO and a bitmap marks the non-empty ones, so insert(),
+// remove() and choose() take constant time regardless of the number of ready
+// objects. Ranks mapped onto the same band are not ordered among themselves.
+// As in Scheduling_List, the chosen element is kept outside the list.
+template<typename T,
+          typename R = typename T::Criterion,
+          typename El = List_Elements::Doubly_Linked_Scheduling<T, R>,
+          unsigned int B = R::BANDS>
+class Bitmap_Scheduling_List
+{
+    template<typename FT, typename FR, typename FEl, typename FL, unsigned int FQ>
+    friend class Scheduling_Multilist;          // for chosen() and remove()
+
+private:
+    typedef List<T, El> Band;
+
+public:
+    typedef T Object_Type;
+    typedef R Rank_Type;
+    typedef El Element;
+    typedef typename Band::Iterator Iterator;
+
+public:
+    Bitmap_Scheduling_List(): _size(0), _chosen(0) {}
+
+    bool empty() const { return (_size == 0); }
+    unsigned int size() const { return _size; }
+
+    Element * head() { return empty() ? 0 : _bands[_ready.first()].head(); }
+    Element * tail() { return empty() ? 0 : _bands[_ready.last()].tail(); }
+
+    Element * volatile & chosen() { return _chosen; }
+
+    void insert(Element * e) {
+        db<Lists>(TRC) << "Bitmap_Scheduling_List::insert(e=" << e
+                       << ") => {p=" << (e ? e->prev() : (void *) -1)
+                       << ",o=" << (e ? e->object() : (void *) -1)
+                       << ",n=" << (e ? e->next() : (void *) -1)
+                       << "}" << endl;
+
+        if(_chosen)
+            enqueue(e);
+        else
+            _chosen = e;
+    }
+
+    Element * remove(Element * e) {
+        db<Lists>(TRC) << "Bitmap_Scheduling_List::remove(e=" << e
+                       << ") => {p=" << (e ? e->prev() : (void *) -1)
+                       << ",o=" << (e ? e->object() : (void *) -1)
+                       << ",n=" << (e ? e->next() : (void *) -1)
+                       << "}" << endl;
+
+        if(e == _chosen)
+            _chosen = dequeue();
+        else
+            dequeue(e);
+
+        return e;
+    }
+
+    Element * choose() {
+        db<Lists>(TRC) << "Bitmap_Scheduling_List::choose()" << endl;
+
+        if(!empty()) {
+            enqueue(_chosen);
+            _chosen = dequeue();
+        }
+
+        return _chosen;
+    }
+
+    Element * choose_another() {
+        db<Lists>(TRC) << "Bitmap_Scheduling_List::choose_another()" << endl;
+
+        if(!empty() && head()->rank() != R::IDLE) {
+            Element * tmp = _chosen;
+            _chosen = dequeue();
+            enqueue(tmp);
+        }
+
+        return _chosen;
+    }
+
+    Element * choose(Element * e) {
+        db<Lists>(TRC) << "Bitmap_Scheduling_List::choose(e=" << e
+                       << ") => {p=" << (e ? e->prev() : (void *) -1)
+                       << ",o=" << (e ? e->object() : (void *) -1)
+                       << ",n=" << (e ? e->next() : (void *) -1)
+                       << "}" << endl;
+
+        if(e != _chosen) {
+            enqueue(_chosen);
+            _chosen = dequeue(e);
+        }
+
+        return _chosen;
+    }
+
+    // A single list has no one else to steal from or balance with (see Scheduling_Multilist)
+    Element * steal() { return 0; }
+
+    template<typename V>
+    Element * balance(unsigned int queues, V (* load)(Element *), V (* cost)(Element *)) { return 0; }
+
+private:
+    Element * remove() { return dequeue(); }
+    void chosen(Element * e) { _chosen = e; }
+
+    void enqueue(Element * e) {
+        unsigned int b = e->rank().band();
+        _bands[b].insert_tail(e);
+        _ready.set(b);
+        _size++;
+    }
+
+    Element * dequeue() {
+        if(empty())
+            return 0;
+        unsigned int b = _ready.first();
+        Element * e = _bands[b].remove_head();
+        if(_bands[b].empty())
+            _ready.reset(b);
+        _size--;
+        return e;
+    }
+
+    Element * dequeue(Element * e) {
+        unsigned int b = e->rank().band();
+        _bands[b].remove(e);
+        if(_bands[b].empty())
+            _ready.reset(b);
+        _size--;
+        return e;
+    }
+
+private:
+    unsigned int _size;
+    Element * volatile _chosen;
+    Bitmap<B> _ready;
+    Band _bands[B];
+};
+
+
 // Doubly-Linked, Multihead Scheduling List
 // Besides declaring "Criterion", objects subject to scheduling policies that
 // use the Multihead list must export the HEADS constant to indicate the
@@ -1210,6 +1566,18 @@ public:
         return _chosen[R::current_head()];
     }
 
+    // All heads share a single list, so there is nothing to move around, but a head running
+    // something of lower rank (e.g. an idle CPU) is told about a better element to choose()
+    Element * steal() {
+        db<Lists>(TRC) << "Scheduling_List::steal()" << endl;
+
+        return (!empty() && (head()->rank() < _chosen[R::current_head()]->rank())) ? head() : 0;
+    }
+
+    // Nor anything to balance
+    template<typename V>
+    Element * balance(unsigned int queues, V (* load)(Element *), V (* cost)(Element *)) { return 0; }
+
 private:
     using Base::remove;
     void chosen(Element * e) { _chosen[R::current_head()] = e; }
@@ -1266,9 +1634,15 @@ public:
         _list[e->rank().queue()].insert(e);
     }
 
+    // A running element moved to another sublist (see R::queue()) is still the chosen one of its former sublist until
+    // that one's CPU chooses again, so it must be removed from there if it sleeps, is suspended or exits before that
     Element * remove(Element * e) {
-         return _list[e->rank().queue()].remove(e);
-     }
+        for(unsigned int i = 0; i < Q; i++)
+            if(_list[i].chosen() == e)
+                return _list[i].remove(e);
+
+        return _list[e->rank().queue()].remove(e);
+    }
 
     Element * choose() {
     	if(_list[R::current_queue()].chosen()->rank().queue() != R::current_queue()) {
@@ -1297,6 +1671,79 @@ public:
         return _list[e->rank().queue()].choose(e);
     }
 
+    // Work stealing: move the highest-ranked, non-idle ready element of the
+    // most loaded sublist (excluding its chosen one) that may run on the
+    // current one (see affine()) into it
+    Element * steal() {
+        unsigned int victim = R::current_queue();
+        unsigned int load = 0;
+        for(unsigned int i = 0; i < Q; i++)
+            if((i != R::current_queue()) && (_list[i].size() > load) && (_list[i].head()->rank() != R::IDLE)) {
+                victim = i;
+                load = _list[i].size();
+            }
+
+        if(victim == R::current_queue())
+            return 0;
+
+        Element * e = _list[victim].head();
+        for(; e && !e->rank().affine(R::current_queue()); e = e->next());
+        if(!e || (e->rank() == R::IDLE))
+            return 0;
+
+        return transfer(e, R::current_queue());
+    }
+
+    // Moves a ready element to another sublist
+    Element * transfer(Element * e, unsigned int queue) {
+        _list[e->rank().queue()].remove(e);
+        R r = e->rank();
+        r.queue(queue);
+        e->rank(r);
+        _list[queue].insert(e);
+
+        return e;
+    }
+
+    // Load balancing: move the ready element of the most loaded of the first "queues" sublists whose move evens out
+    // its load and the least loaded one's the most, once its "cost" is taken, to the latter (if it may run there, see
+    // affine()). "load" and "cost" are given by the caller for each element, idle ones aside, including the chosen ones
+    template<typename V>
+    Element * balance(unsigned int queues, V (* load)(Element *), V (* cost)(Element *)) {
+        V loads[Q];
+        unsigned int busiest = 0;
+        unsigned int idlest = 0;
+        for(unsigned int i = 0; i < queues; i++) {
+            Element * c = _list[i].chosen();
+            loads[i] = (c && (c->rank() != R::IDLE)) ? load(c) : 0;
+            for(Element * e = _list[i].head(); e; e = e->next())
+                if(e->rank() != R::IDLE)
+                    loads[i] += load(e);
+            if(loads[i] > loads[busiest])
+                busiest = i;
+            if(loads[i] < loads[idlest])
+                idlest = i;
+        }
+
+        // Moving an element of load l leaves both sublists |imbalance - 2l| apart
+        V imbalance = loads[busiest] - loads[idlest];
+        Element * best = 0;
+        V most = 0;
+        for(Element * e = _list[busiest].head(); e && (busiest != idlest); e = e->next()) {
+            if((e->rank() == R::IDLE) || !e->rank().affine(idlest))
+                continue;
+            V l = load(e);
+            V c = cost(e);
+            V gain = (2 * l <= imbalance) ? 2 * l : (l < imbalance) ? 2 * (imbalance - l) : 0;
+            if(gain > most + c) {
+                best = e;
+                most = gain - c;
+            }
+        }
+
+        return best ? transfer(best, idlest) : 0;
+    }
+
 private:
     L _list[Q];
 };
@@ -1391,6 +1838,16 @@ public:
         return e;
     }
 
+    // Takes s units from the end of e, which is removed if nothing is left
+    void decrement(Element * e, unsigned int s) {
+        db<Lists>(TRC) << "Grouping_List::decrement(e=" << e << ",s=" << s << ")" << endl;
+
+        e->shrink(s);
+        _grouped_size -= s;
+        if(!e->size())
+            remove(e);
+    }
+
 private:
     Element * search_left(const Object_Type * obj) {
         Element * e = head();
@@ -0,0 +1,74 @@
+// EPOS Binary Log Utility Declarations
+
+#ifndef __log_h
+#define __log_h
+
+#include <architecture.h>
+#include <utility/per_cpu.h>
+
+__BEGIN_UTIL
+
+// Per-CPU rings of deferred-format records (enabled by Traits<Log>::enabled)
+// Log::log("Heap::alloc(h=%p,b=%u) => %p", this, bytes, addr) stores a time stamp, the address of the format string
+// and up to ARGS raw words, so nothing is formatted when the record is taken. Rings wrap around, keeping the last
+// RECORDS records of each CPU, and dump() prints them as "@log" lines with hexadecimal words. tools/eposlog turns
+// these lines back into text by looking the format strings up in the ELF image.
+// Formats must therefore be string literals and can only use %d, %i, %u, %x, %X, %o, %p and %c, plus %s for strings
+// that are also in the image. Each argument is taken as a machine word, so %d sign-extends a long.
+class Log
+{
+public:
+    static const bool enabled = Traits<Log>::enabled;
+    static const unsigned int RECORDS = enabled ? Traits<Log>::RECORDS : 1;
+    static const unsigned int ARGS = 4;
+
+    struct Record {
+        TSC::Time_Stamp ts;
+        const char * format;
+        unsigned long args[ARGS];
+    };
+
+public:
+    template<typename ... Tn>
+    static void log(const char * format, const Tn & ... an) {
+        static_assert(sizeof...(Tn) <= ARGS, "Log::log() takes at most ARGS arguments");
+
+        if(!enabled)
+            return;
+
+        unsigned long args[ARGS] = { word(an)... };
+
+        // Interrupts are disabled so the record can't be interleaved with another one taken by a handler on this
+        // CPU, nor the thread be moved to another CPU halfway through
+        bool disabled = CPU::int_disabled();
+        if(!disabled)
+            CPU::int_disable();
+
+        unsigned int cpu = CPU::id();
+        Record & r = _ring[cpu][_head[cpu]++ % RECORDS];
+        r.ts = TSC::time_stamp();
+        r.format = format;
+        for(unsigned int i = 0; i < ARGS; i++)
+            r.args[i] = args[i];
+
+        if(!disabled)
+            CPU::int_enable();
+    }
+
+    static void dump();
+    static void reset();
+
+private:
+    template<typename T>
+    static unsigned long word(T * p) { return reinterpret_cast<unsigned long>(p); }
+    template<typename T>
+    static unsigned long word(const T & v) { return static_cast<unsigned long>(v); }
+
+private:
+    static Per_CPU<unsigned int> _head;
+    static Record _ring[Traits<Build>::CPUS][RECORDS];
+};
+
+__END_UTIL
+
+#endif
@@ -0,0 +1,23 @@
+// EPOS LZ4 Utility Declarations
+
+// Decompressor for the LZ4 block format (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md), in which
+// eposmkbi -z stores the loadable segments of the boot image's ELFs (see ELF::load_segment()). Blocks carry no
+// length, so decompression stops once "size" bytes were produced, which must be exactly what was compressed.
+
+#ifndef __lz4_h
+#define __lz4_h
+
+#include <system/config.h>
+
+__BEGIN_UTIL
+
+class LZ4
+{
+public:
+    // Returns the number of bytes consumed from "src", or -1 if the block is corrupted (it never writes past "size")
+    static long decompress(const void * src, void * dst, unsigned long size);
+};
+
+__END_UTIL
+
+#endif
@@ -46,15 +46,21 @@ inline T logf(T num, float base = e(), float epsilon = 1e-12)
     return integer + decimal;
 }
 
+// Integer base 2 logarithm (rounded down, 0 for 0), with a single instruction where the target counts leading zeros
+template <typename T>
+inline unsigned int ilog2(T x)
+{
+    return x ? sizeof(unsigned long long) * 8 - 1 - __builtin_clzll(x) : 0;
+}
+
+// Integer square root (rounded down), bit by bit
 template <typename T>
 inline T sqrt(T x)
 {
     T res = 0;
 
     // "one" starts at the highest power of four <= than the argument.
-    T one = static_cast<T>(1) << (sizeof(T) * 8 - 2);
-    while(one > x)
-        one >>= 2;
+    T one = (x > 0) ? static_cast<T>(1) << (ilog2(x) & ~1U) : 0;
 
     while(one != 0) {
         if(x >= res + one) {
@@ -67,6 +73,40 @@ inline T sqrt(T x)
     return res;
 }
 
+// Integer square roots of n numbers (r may be x), as above. With NEON, a register of them is taken at a time, the
+// same steps applied to all lanes with comparison masks instead of branches.
+template <typename T>
+inline void sqrt(const T * x, T * r, unsigned int n)
+{
+    unsigned int i = 0;
+
+#if defined(__ARM_NEON)
+    typedef T Lanes __attribute__((vector_size(16), aligned(sizeof(T))));
+    static const unsigned int LANES = sizeof(Lanes) / sizeof(T);
+
+    for(; i + LANES <= n; i += LANES) {
+        Lanes v = *reinterpret_cast<const Lanes *>(&x[i]);
+        Lanes res = v - v;
+
+        T all = 0;
+        for(unsigned int j = 0; j < LANES; j++)
+            all |= (x[i + j] > 0) ? x[i + j] : 0;
+
+        for(T one = all ? static_cast<T>(1) << (ilog2(all) & ~1U) : 0; one != 0; one >>= 2) {
+            Lanes t = res + one;
+            Lanes ge = reinterpret_cast<Lanes>(v >= t);
+            v -= t & ge;
+            res = (res >> 1) + (one & ge);
+        }
+
+        *reinterpret_cast<Lanes *>(&r[i]) = res;
+    }
+#endif
+
+    for(; i < n; i++)
+        r[i] = sqrt(x[i]);
+}
+
 template <typename T>
 inline T pow(T x, unsigned int y)
 {
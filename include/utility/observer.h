@@ -11,6 +11,7 @@
 #define	__observer_h
 
 #include <utility/list.h>
+#include <utility/hash.h>
 
 __BEGIN_UTIL
 
@@ -102,7 +103,7 @@ class Conditionally_Observed
 {
     friend class Conditional_Observer<C>;
 
-private:
+protected:
     typedef typename Simple_Ordered_List<Conditional_Observer<C>, C>::Element Element;
 
 public:
@@ -148,6 +149,9 @@ public:
 
     virtual unsigned int observers() const { return _observers.size(); }
 
+protected:
+    static Element * link(Conditional_Observer<C> * o) { return &o->_link; }
+
 private:
     Simple_Ordered_List<Conditional_Observer<C>, C> _observers;
 };
@@ -186,7 +190,7 @@ class Data_Observed
 {
     friend class Data_Observer<D, C>;
 
-private:
+protected:
     typedef Data_Observer<D, C> _Observer;
     typedef typename Simple_Ordered_List<Data_Observer<D, C>, C>::Element Element;
 
@@ -247,6 +251,9 @@ public:
 
     virtual unsigned int observers() const { return _observers.size(); }
 
+protected:
+    static Element * link(_Observer * o) { return &o->_link; }
+
 private:
     Simple_Ordered_List<Data_Observer<D, C>, C> _observers;
 };
@@ -259,6 +266,7 @@ class Data_Observer
 public:
     typedef D Observed_Data;
     typedef C Observing_Condition;
+    typedef Data_Observed<D, C> Observed;   // what update() gets, even from an Indexed_Data_Observed
 
 protected:
     Data_Observer(): _link(this) {
@@ -277,6 +285,115 @@ private:
 };
 
 
+// Indexed Conditionally Observed and Data Observed
+// Observers are kept in a Hash by condition, so notify() only walks the observers whose conditions fall into the
+// same bucket as the one notified, instead of all of them. BUCKETS should be close to the number of conditions in use.
+template<typename C = int, unsigned int BUCKETS = 16>
+class Indexed_Conditionally_Observed: public Conditionally_Observed<C>
+{
+private:
+    typedef Conditionally_Observed<C> Base;
+    typedef typename Base::Element Element;
+
+public:
+    Indexed_Conditionally_Observed() {}
+
+    void attach(Conditional_Observer<C> * o, const C & c) {
+        db<Observers>(TRC) << "Indexed_Conditionally_Observed::attach(o=" << o << ",c=" << c << ")" << endl;
+
+        Element * l = Base::link(o);
+        *l = Element(o, c);
+        _observers.insert(l);
+    }
+
+    void detach(Conditional_Observer<C> * o, const C & c) {
+        db<Observers>(TRC) << "Indexed_Conditionally_Observed::detach(obs=" << o << ",c=" << c << ")" << endl;
+
+        _observers.remove(Base::link(o));
+    }
+
+    bool notify(const C & c) {
+        bool notified = false;
+
+        db<Observers>(TRC) << "Indexed_Conditionally_Observed::notify(cond=" << hex << c << ")" << endl;
+
+        for(Element * e = _observers[c]->head(); e; e = e->next()) {
+            if(e->rank() == c) {
+                db<Observers>(INF) << "Observed::notify(this=" << this << ",obs=" << e->object() << ")" << endl;
+                e->object()->update(this, c);
+                notified = true;
+            }
+        }
+
+        return notified;
+    }
+
+    unsigned int observers() const { return _observers.size(); }
+
+private:
+    Hash<Conditional_Observer<C>, BUCKETS, C> _observers;
+};
+
+template<typename D, typename C, unsigned int BUCKETS = 16>
+class Indexed_Data_Observed: public Data_Observed<D, C>
+{
+private:
+    typedef Data_Observed<D, C> Base;
+    typedef typename Base::_Observer _Observer;
+    typedef typename Base::Element Element;
+
+public:
+    Indexed_Data_Observed() {}
+
+    void attach(_Observer * o, const C & c) {
+        db<Observers>(TRC) << "Indexed_Data_Observed::attach(obs=" << o << ",cond=" << c << ")" << endl;
+
+        Element * l = Base::link(o);
+        *l = Element(o, c);
+        _observers.insert(l);
+    }
+
+    void detach(_Observer * o, const C & c) {
+        db<Observers>(TRC) << "Indexed_Data_Observed::detach(obs=" << o << ",cond=" << c << ")" << endl;
+
+        _observers.remove(Base::link(o));
+    }
+
+    bool notify(const C & c, D * d) {
+        bool notified = false;
+
+        db<Observers>(TRC) << "Indexed_Data_Observed::notify(this=" << this << ",cond=" << c << ")" << endl;
+
+        for(Element * e = _observers[c]->head(); e; e = e->next()) {
+            if(e->rank() == c) {
+                db<Observers>(INF) << "Data_Observed::notify(this=" << this << ",obs=" << e->object() << ")" << endl;
+                e->object()->update(this, c, d);
+                notified = true;
+            }
+        }
+
+        return notified;
+    }
+
+    _Observer * observer(const C & c, unsigned int index = 0) {
+        _Observer * o = 0;
+        for(Element * e = _observers[c]->head(); e; e = e->next()) {
+            if(e->rank() == c) {
+                if(!index)
+                    o = e->object();
+                else
+                    index--;
+            }
+        }
+        return o;
+    }
+
+    unsigned int observers() const { return _observers.size(); }
+
+private:
+    Hash<_Observer, BUCKETS, C> _observers;
+};
+
 // (Unconditional) Observer x (Unconditionally) Observed with Data
 template<typename D>
 class Data_Observed<D, void>
@@ -156,11 +156,18 @@ private:
     int llutoa(unsigned long long int v, char * s, unsigned int i = 0);
     int ptoa(const void * p, char * s);
 
+    // Write the digits of v backwards, ending at s, and return where they start
+    char * digits(unsigned int v, char * s);
+    char * digits(unsigned long long int v, char * s);
+    static char * decimal(unsigned int v, char * s, unsigned int width = 1);
+    static unsigned long long int div1e9(unsigned long long int v);
+
 private:
     int _base;
     volatile bool _error;
 
     static const char _digits[];
+    static const char _pairs[];
 };
 
 constexpr OStream::Begl begl;
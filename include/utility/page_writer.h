@@ -0,0 +1,72 @@
+// EPOS Page Writer Utility Declarations
+
+#ifndef __page_writer_h
+#define __page_writer_h
+
+#include <utility/string.h>
+
+__BEGIN_UTIL
+
+// Collects bytes written at increasing addresses into one PAGE-aligned page at a time and hands each run of them to
+// "sink" (e.g. EEPROM or a flash mediator) with a single "sink->write(address, data, bytes)", once the page is full or
+// the next byte is not right after the last one. Feeding it whole pages in order makes for one write per page.
+template<typename Sink, unsigned int PAGE = 256>
+class Page_Writer
+{
+public:
+    typedef unsigned long Address;
+
+    static_assert(PAGE && !(PAGE & (PAGE - 1)), "Page_Writer PAGE must be a power of two");
+
+public:
+    Page_Writer(Sink * sink): _sink(sink), _page(0), _begin(0), _end(0), _bytes(0), _writes(0) {}
+
+    void write(Address addr, const void * data, unsigned int size) {
+        const unsigned char * d = reinterpret_cast<const unsigned char *>(data);
+        while(size) {
+            Address page = addr & ~Address(PAGE - 1);
+            unsigned int offset = addr - page;
+            if(_end && ((page != _page) || (offset != _end)))
+                flush();
+            if(!_end) {
+                _page = page;
+                _begin = offset;
+            }
+
+            unsigned int n = (size < PAGE - offset) ? size : PAGE - offset;
+            memcpy(&_buffer[offset], d, n);
+            _end = offset + n;
+            addr += n;
+            d += n;
+            size -= n;
+
+            if(_end == PAGE)
+                flush();
+        }
+    }
+
+    void flush() {
+        if(_end > _begin) {
+            _sink->write(_page + _begin, &_buffer[_begin], _end - _begin);
+            _bytes += _end - _begin;
+            _writes++;
+        }
+        _begin = _end = 0;
+    }
+
+    unsigned long bytes() const { return _bytes; }     // handed to the sink so far
+    unsigned int writes() const { return _writes; }
+
+private:
+    Sink * _sink;
+    Address _page;
+    unsigned int _begin;
+    unsigned int _end;      // 0 if nothing is pending
+    unsigned long _bytes;
+    unsigned int _writes;
+    unsigned char _buffer[PAGE];
+};
+
+__END_UTIL
+
+#endif
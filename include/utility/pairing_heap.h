@@ -0,0 +1,217 @@
+// EPOS Pairing Heap Utility Declarations
+
+// Pairing_Heap is an intrusive priority queue with the interface of Ordered_List (insert(), remove(), remove(e),
+// remove(obj), head()), but insert() and head() take O(1) and removals O(log n) amortized, instead of O(n) insertions.
+// Each element keeps its first child, its right sibling (next) and either its left sibling or, for the first child,
+// its parent (prev). Elements of equal rank leave in the order they were inserted, as in Ordered_List, because each
+// one is stamped with a serial number by insert() that breaks ties.
+// Ranks are absolute, so there is no Relative_List counterpart, and the order of a heap can't be iterated.
+
+#ifndef __pairing_heap_h
+#define __pairing_heap_h
+
+#include <utility/list.h>
+
+__BEGIN_UTIL
+
+namespace List_Elements
+{
+    // Pairing Heap Element
+    template<typename T, typename R = Rank>
+    class Pairing_Heap_Ordered
+    {
+    public:
+        typedef T Object_Type;
+        typedef Rank Rank_Type;
+        typedef Pairing_Heap_Ordered Element;
+
+    public:
+        Pairing_Heap_Ordered(const T * o,  const R & r = 0): _object(o), _rank(r), _prev(0), _next(0), _child(0), _serial(0) {}
+
+        T * object() const { return const_cast<T *>(_object); }
+
+        Element * prev() const { return _prev; }
+        Element * next() const { return _next; }
+        Element * child() const { return _child; }
+        void prev(Element * e) { _prev = e; }
+        void next(Element * e) { _next = e; }
+        void child(Element * e) { _child = e; }
+
+        unsigned int serial() const { return _serial; }
+        void serial(unsigned int s) { _serial = s; }
+
+        const R & rank() const { return _rank; }
+        void rank(const R & r) { _rank = r; }
+        int promote(const R & n = 1) { _rank -= n; return _rank; }
+        int demote(const R & n = 1) { _rank += n; return _rank; }
+
+    private:
+        const T * _object;
+        R _rank;
+        Element * _prev;
+        Element * _next;
+        Element * _child;
+        unsigned int _serial;
+    };
+};
+
+
+template<typename T,
+          typename R = List_Element_Rank,
+          typename El = List_Elements::Pairing_Heap_Ordered<T, R> >
+class Pairing_Heap
+{
+public:
+    typedef T Object_Type;
+    typedef R Rank_Type;
+    typedef El Element;
+
+public:
+    Pairing_Heap(): _root(0), _size(0), _serial(0) {}
+
+    bool empty() const { return !_root; }
+    unsigned int size() const { return _size; }
+
+    Element * head() { return _root; }
+
+    void insert(Element * e) {
+        db<Lists>(TRC) << "Pairing_Heap::insert(e=" << e << ",o=" << e->object() << ")" << endl;
+
+        e->prev(0);
+        e->next(0);
+        e->child(0);
+        e->serial(_serial++);
+        _root = _root ? link(_root, e) : e;
+        _size++;
+    }
+
+    Element * remove() {
+        db<Lists>(TRC) << "Pairing_Heap::remove()" << endl;
+
+        Element * e = _root;
+        if(e) {
+            _root = combine(e->child());
+            _size--;
+        }
+        return e;
+    }
+
+    Element * remove(Element * e) {
+        db<Lists>(TRC) << "Pairing_Heap::remove(e=" << e << ",o=" << e->object() << ")" << endl;
+
+        if(e == _root)
+            return remove();
+
+        // Cut e's subtree off and merge it back once it is rid of e
+        if(e->prev()->child() == e)
+            e->prev()->child(e->next());
+        else
+            e->prev()->next(e->next());
+        if(e->next())
+            e->next()->prev(e->prev());
+
+        Element * sub = combine(e->child());
+        if(sub)
+            _root = link(_root, sub);
+        _size--;
+
+        return e;
+    }
+
+    Element * remove(const Object_Type * obj) {
+        db<Lists>(TRC) << "Pairing_Heap::remove(o=" << obj << ")" << endl;
+
+        Element * e = search(obj);
+        return e ? remove(e) : 0;
+    }
+
+    // A depth-first walk, so O(n)
+    Element * search(const Object_Type * obj) {
+        Element * e = _root;
+        while(e) {
+            if(e->object() == obj)
+                return e;
+            if(e->child())
+                e = e->child();
+            else {
+                while(e && !e->next())
+                    e = parent(e);
+                if(e)
+                    e = e->next();
+            }
+        }
+        return 0;
+    }
+
+private:
+    static bool precedes(Element * a, Element * b) {
+        if(a->rank() < b->rank())
+            return true;
+        if(b->rank() < a->rank())
+            return false;
+        return static_cast<int>(a->serial() - b->serial()) < 0; // the older first, even if the serials wrapped around
+    }
+
+    static Element * parent(Element * e) {
+        for(; e->prev() && (e->prev()->child() != e); e = e->prev());
+        return e->prev();
+    }
+
+    // Makes the root that comes last the first child of the other, which is returned as a root
+    static Element * link(Element * a, Element * b) {
+        if(precedes(b, a)) {
+            Element * tmp = a;
+            a = b;
+            b = tmp;
+        }
+        b->next(a->child());
+        if(b->next())
+            b->next()->prev(b);
+        b->prev(a);
+        a->child(b);
+        a->prev(0);
+        a->next(0);
+        return a;
+    }
+
+    // Merges a list of siblings into a single root in two passes: pairs from left to right, then each pair into the
+    // last one from right to left
+    static Element * combine(Element * first) {
+        Element * pairs = 0; // a stack threaded through next
+        while(first) {
+            Element * a = first;
+            Element * b = a->next();
+            if(!b) {
+                a->prev(0);
+                a->next(pairs);
+                pairs = a;
+                break;
+            }
+            first = b->next();
+            Element * w = link(a, b);
+            w->next(pairs);
+            pairs = w;
+        }
+
+        Element * root = pairs;
+        if(root) {
+            pairs = root->next();
+            root->next(0);
+            while(pairs) {
+                Element * n = pairs->next();
+                root = link(root, pairs);
+                pairs = n;
+            }
+        }
+        return root;
+    }
+
+private:
+    Element * _root;
+    unsigned int _size;
+    unsigned int _serial;
+};
+
+__END_UTIL
+
+#endif
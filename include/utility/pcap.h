@@ -3,16 +3,27 @@
 #ifndef __pcap_h_
 #define __pcap_h_
 
-#include <architecture/cpu.h>
+#include <architecture.h>
+#include <utility/string.h>
 
 __BEGIN_UTIL
 
+// PCAP (libpcap's file format) definitions, plus an in-memory capture ring (enabled by Traits<PCAP>::enabled)
+// capture() copies the first SNAPLEN bytes of a frame into the next of FRAMES preallocated slots along with a time
+// stamp, so NIC drivers can call it on every frame they send or receive. When it is disabled, the call compiles away.
+// The ring wraps around, keeping the last FRAMES frames, and is only read after the fact: dump() prints it as "@pcap"
+// lines that tools/epospcap turns into a .pcap file, while write() hands the bytes of that same file to a sink (e.g.
+// a lambda that sends them through a UDP socket), in as many pieces as it takes.
 class PCAP
 {
     typedef CPU::Reg32 Reg32;
     typedef CPU::Reg16 Reg16;
 
 public:
+    static const bool enabled = Traits<PCAP>::enabled;
+    static const unsigned int FRAMES = enabled ? Traits<PCAP>::FRAMES : 1;
+    static const unsigned int SNAPLEN = enabled ? Traits<PCAP>::SNAPLEN : 1;
+
     enum Link_Type
     {
         NULL                       = 0,
@@ -152,6 +163,8 @@ public:
         Packet_Header() {}
         Packet_Header(Microsecond timestamp, unsigned int len)
         : _ts_sec(timestamp / 1000000), _ts_usec(timestamp % 1000000), _incl_len(len), _orig_len(len) {}
+        Packet_Header(unsigned int sec, unsigned int usec, unsigned int incl_len, unsigned int orig_len)
+        : _ts_sec(sec), _ts_usec(usec), _incl_len(incl_len), _orig_len(orig_len) {}
 
         friend OStream & operator<<(OStream & db, const Packet_Header & p) {
             for(unsigned int i = 0; i < sizeof(Packet_Header); i++)
@@ -167,6 +180,64 @@ public:
         Reg32 _incl_len;       // number of octets of packet saved in file
         Reg32 _orig_len;       // actual length of packet
     }__attribute__((packed));
+
+private:
+    struct Record {
+        TSC::Time_Stamp ts;
+        unsigned int size;
+        unsigned char data[SNAPLEN];
+    };
+
+public:
+    // Safe in interrupt context and on any CPU: each call claims a slot of its own, so only a capture that laps the
+    // whole ring while another one is still copying can garble a frame
+    static void capture(const void * frame, unsigned int size) {
+        if(!enabled)
+            return;
+
+        Record & r = _ring[CPU::finc(_head) % FRAMES];
+        r.ts = TSC::time_stamp();
+        r.size = size;
+        memcpy(r.data, frame, (size < SNAPLEN) ? size : SNAPLEN);
+    }
+
+    static void dump();
+    static void reset() { _head = 0; }
+
+    // Calls "sink(const void * data, unsigned int size)" with the Global_Header and then, in order, the Packet_Header
+    // and the bytes of each frame in the ring
+    template<typename Sink>
+    static void write(Sink & sink) {
+        if(!enabled)
+            return;
+
+        Global_Header g(SNAPLEN, static_cast<Link_Type>(Traits<PCAP>::LINK_TYPE), 0);
+        sink(&g, sizeof(Global_Header));
+
+        unsigned int head = _head;
+        for(unsigned int i = first(head); i < head; i++) {
+            const Record & r = _ring[i % FRAMES];
+            unsigned int sec, usec;
+            time(r.ts, &sec, &usec);
+            Packet_Header p(sec, usec, (r.size < SNAPLEN) ? r.size : SNAPLEN, r.size);
+            sink(&p, sizeof(Packet_Header));
+            sink(r.data, p.size());
+        }
+    }
+
+private:
+    static unsigned int first(unsigned int head) { return (head > FRAMES) ? head - FRAMES : 0; }
+
+    // Time stamps are converted only here, to keep capture() short
+    static void time(const TSC::Time_Stamp & ts, unsigned int * sec, unsigned int * usec) {
+        TSC::Time_Stamp f = TSC::frequency();
+        *sec = ts / f;
+        *usec = (ts % f) * 1000000 / f;
+    }
+
+private:
+    static volatile unsigned int _head;
+    static Record _ring[FRAMES];
 };
 
 __END_UTIL
@@ -0,0 +1,60 @@
+// EPOS Per-CPU Variable Utility Declarations
+
+#ifndef __per_cpu_h
+#define __per_cpu_h
+
+#include <architecture/cpu.h>
+
+__BEGIN_UTIL
+
+// Per-CPU Variable
+// Keeps one T for each CPU, each in cache lines of its own, so CPUs updating theirs (e.g. statistics counters) never
+// bounce the others' lines. A CPU reaches its own through local() and reports read any of them with operator[], or
+// all of them at once with sum(), while their CPUs might still be updating them. Only other CPUs are kept away:
+// updates that a handler on the same CPU might interrupt must still be done with interrupts disabled.
+// The alignment is only honored for objects in static storage or inside other objects, not for those made by new.
+template<typename T>
+class Per_CPU
+{
+private:
+    static const unsigned int CPUS = Traits<Build>::CPUS;
+
+    struct Slot {
+        T object;
+    } __attribute__((aligned(Traits<CPU>::CACHE_LINE_SIZE)));
+
+public:
+    typedef T Object_Type;
+
+public:
+    Per_CPU() {}
+    Per_CPU(const T & o) { fill(o); }
+
+    static unsigned int cpu() { return (CPUS > 1) ? CPU::id() : 0; }
+    static unsigned int size() { return CPUS; }
+
+    T & local() { return _slots[cpu()].object; }
+    const T & local() const { return _slots[cpu()].object; }
+
+    T & operator[](unsigned int c) { assert(c < CPUS); return _slots[c].object; }
+    const T & operator[](unsigned int c) const { assert(c < CPUS); return _slots[c].object; }
+
+    T sum() const {
+        T s = T();
+        for(unsigned int c = 0; c < CPUS; c++)
+            s += _slots[c].object;
+        return s;
+    }
+
+    void fill(const T & o) {
+        for(unsigned int c = 0; c < CPUS; c++)
+            _slots[c].object = o;
+    }
+
+private:
+    Slot _slots[CPUS];
+};
+
+__END_UTIL
+
+#endif
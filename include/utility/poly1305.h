@@ -23,14 +23,8 @@ public:
     void stamp(unsigned char out[16], const unsigned char nonce[16], const unsigned char * message, int message_len) {
         // cr = (c_1 * r^q + c_2 * r^(q-1) + ... + c_q * r^1) % (2^130 - 5)
         Bignum cr(0);
-        for(; message_len > 0; message_len -= 16, message += 16) {
-            int len = Math::min(16, message_len);
-            Bignum c(message, len);
-            reinterpret_cast<unsigned char *>(c._data)[len] = 1;
-
-            cr += c;
-            cr *= _r;
-        }
+        for(; message_len > 0; message_len -= 16, message += 16)
+            accumulate(cr, message, Math::min(16, message_len));
 
         unsigned char ciphertext[16];
         Cipher cipher;
@@ -40,6 +34,42 @@ public:
         Bignum::simple_add(reinterpret_cast<Bignum::Digit *>(out), reinterpret_cast<const Bignum::Digit *>(ciphertext), cr._data, 4);
     }
 
+    // Incremental MAC under a one-time key, as in RFC 8439, where k is added to the result as it is, with no Cipher:
+    // begin(), then update() with the message in pieces of any length, pad() to zero-fill a partial block, and finish()
+    void begin() { _acc = 0; _pending = 0; }
+
+    void update(const unsigned char * data, unsigned int len) {
+        if(_pending) {
+            for(; len && (_pending < 16); len--)
+                _buffer[_pending++] = *data++;
+            if(_pending < 16)
+                return;
+            accumulate(_acc, _buffer, 16);
+            _pending = 0;
+        }
+        for(; len >= 16; len -= 16, data += 16)
+            accumulate(_acc, data, 16);
+        for(; len; len--)
+            _buffer[_pending++] = *data++;
+    }
+
+    void pad() {
+        if(_pending) {
+            memset(&_buffer[_pending], 0, 16 - _pending);
+            accumulate(_acc, _buffer, 16);
+            _pending = 0;
+        }
+    }
+
+    void finish(unsigned char out[16]) {
+        if(_pending)
+            accumulate(_acc, _buffer, _pending);
+        _pending = 0;
+
+        // out = (acc + k) % 2^128
+        Bignum::simple_add(reinterpret_cast<Bignum::Digit *>(out), _k._data, _acc._data, 4);
+    }
+
     bool verify(const unsigned char mac[16], const unsigned char nonce[16], const unsigned char * message, unsigned int message_len) {
         unsigned char my_mac[16];
         stamp(my_mac, nonce, message, message_len);
@@ -54,6 +84,15 @@ public:
     void r(const unsigned char r1[16]) { new (&_r) Bignum(r1,16); clamp(); }
 
 private:
+    // acc = ((acc + c) * r) % (2^130 - 5), with c being "len" bytes of message followed by a 1
+    void accumulate(Bignum & acc, const unsigned char * message, unsigned int len) {
+        Bignum c(message, len);
+        reinterpret_cast<unsigned char *>(c._data)[len] = 1;
+
+        acc += c;
+        acc.montgomery_multiply(_rm); // _rm = r * R, so this is (acc * r) % p
+    }
+
     void clamp() {
         reinterpret_cast<unsigned char *>(_r._data)[3] &= 15;
         reinterpret_cast<unsigned char *>(_r._data)[7] &= 15;
@@ -62,10 +101,16 @@ private:
         reinterpret_cast<unsigned char *>(_r._data)[4] &= 252;
         reinterpret_cast<unsigned char *>(_r._data)[8] &= 252;
         reinterpret_cast<unsigned char *>(_r._data)[12] &= 252;
+        _rm = _r;
+        _rm.to_montgomery();
     }
 
     Bignum _k;
     Bignum _r;
+    Bignum _rm; // _r in the Montgomery form
+    Bignum _acc;
+    unsigned char _buffer[16];
+    unsigned int _pending;
 };
 
 __END_UTIL
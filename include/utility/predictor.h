@@ -8,6 +8,61 @@
 
 __BEGIN_UTIL
 
+// Q-format fixed-point number with FRAC fractional bits in a T (e.g. Fixed<16> is a Q15.16 in an int), so models can
+// be kept and evaluated without an FPU. Products and quotients of two Fixed go through a long long. Scaling by a plain
+// number (e.g. a slope times a Time interval) costs a single integer operation.
+template<unsigned int FRAC, typename T = int>
+class Fixed
+{
+    static_assert(FRAC < sizeof(T) * 8 - 1, "Fixed needs at least one integer bit");
+
+public:
+    typedef T Raw;
+    static const T ONE = T(1) << FRAC;
+
+public:
+    Fixed(): _raw(0) {}
+    template<typename U>
+    Fixed(const U & u): _raw(T(u * ONE)) {}
+
+    static Fixed raw(const T & r) { Fixed f; f._raw = r; return f; }
+    T raw() const { return _raw; }
+
+    explicit operator int() const { return _raw / ONE; }
+    explicit operator float() const { return float(_raw) / ONE; }
+
+    Fixed operator-() const { return raw(-_raw); }
+    Fixed operator+(const Fixed & f) const { return raw(_raw + f._raw); }
+    Fixed operator-(const Fixed & f) const { return raw(_raw - f._raw); }
+    Fixed operator*(const Fixed & f) const { return raw(T((static_cast<long long>(_raw) * f._raw) >> FRAC)); }
+    Fixed operator/(const Fixed & f) const { return raw(T((static_cast<long long>(_raw) << FRAC) / f._raw)); }
+    template<typename U>
+    Fixed operator*(const U & u) const { return raw(T(_raw * u)); }
+    template<typename U>
+    Fixed operator/(const U & u) const { return raw(T(_raw / u)); }
+
+    Fixed & operator+=(const Fixed & f) { _raw += f._raw; return *this; }
+    Fixed & operator-=(const Fixed & f) { _raw -= f._raw; return *this; }
+    Fixed & operator*=(const Fixed & f) { return *this = *this * f; }
+    Fixed & operator/=(const Fixed & f) { return *this = *this / f; }
+
+    bool operator==(const Fixed & f) const { return _raw == f._raw; }
+    bool operator!=(const Fixed & f) const { return _raw != f._raw; }
+    bool operator<(const Fixed & f) const { return _raw < f._raw; }
+    bool operator<=(const Fixed & f) const { return _raw <= f._raw; }
+    bool operator>(const Fixed & f) const { return _raw > f._raw; }
+    bool operator>=(const Fixed & f) const { return _raw >= f._raw; }
+
+    friend Debug & operator<<(Debug & db, const Fixed & f) {
+        T r = (f._raw < 0) ? -f._raw : f._raw;
+        db << ((f._raw < 0) ? "-" : "") << r / ONE << "." << int(static_cast<long long>(r % ONE) * 1000 >> FRAC);
+        return db;
+    }
+
+private:
+    T _raw;
+} __attribute__((packed));
+
 class Predictor_Common
 {
 public:
@@ -40,7 +95,13 @@ public:
     public:
         Constant(const Value & v = 0) : _value(v) {}
 
-        Value operator()(const Time & t) { return _value; }
+        Value operator()(const Time & t) const { return _value; }
+
+        // Evaluates the model at n times
+        void operator()(const Time * t, Value * v, unsigned int n) const {
+            for(unsigned int i = 0; i < n; i++)
+                v[i] = _value;
+        }
 
         Value value() const { return _value; }
         void value(const Value & v)  { _value = v; }
@@ -55,7 +116,13 @@ public:
     public:
         Linear(const Value & a = 0, const Value & b = 0, const Time & t0 = 0): _a(a), _b(b), _t0(t0) {}
 
-        Value operator()(const Time & t1) { return (_a * (t1 - _t0) + _b); }
+        Value operator()(const Time & t1) const { return (_a * (t1 - _t0) + _b); }
+
+        // Evaluates the model at n times
+        void operator()(const Time * t, Value * v, unsigned int n) const {
+            for(unsigned int i = 0; i < n; i++)
+                v[i] = _a * (t[i] - _t0) + _b;
+        }
 
         Value a() const { return _a; }
         void a(const Value & a)  { _a = a; }
@@ -87,6 +154,62 @@ public:
         Space _space;
     } __attribute__((packed));
 
+    // Linear models of STREAMS streams, kept as arrays so they are all evaluated at once by a single loop, which works
+    // on four lanes of a NEON (or Helium) register when Value is a float and the target has one
+    template<typename Time, typename Value, unsigned int STREAMS>
+    class Linear_Batch
+    {
+    public:
+        Linear_Batch() {
+            for(unsigned int i = 0; i < STREAMS; i++) {
+                _a[i] = 0;
+                _b[i] = 0;
+                _t0[i] = 0;
+            }
+        }
+
+        void model(unsigned int i, const Linear<Time, Value> & m) { _a[i] = m.a(); _b[i] = m.b(); _t0[i] = m.t0(); }
+        Linear<Time, Value> model(unsigned int i) const { return Linear<Time, Value>(_a[i], _b[i], _t0[i]); }
+
+        // Evaluates the models of all streams at t
+        void operator()(const Time & t, Value * v) const { evaluate(_a, _b, _t0, t, v); }
+
+    private:
+        template<typename V>
+        static void evaluate(const V * a, const V * b, const Time * t0, const Time & t, V * v) {
+            for(unsigned int i = 0; i < STREAMS; i++)
+                v[i] = a[i] * (t - t0[i]) + b[i];
+        }
+
+        static void evaluate(const float * a, const float * b, const Time * t0, const Time & t, float * v) {
+            unsigned int i = 0;
+#if defined(__ARM_NEON) || defined(__ARM_FEATURE_MVE)
+            typedef float Lanes __attribute__((vector_size(16), aligned(sizeof(float))));
+            for(; i + 4 <= STREAMS; i += 4) {
+                Lanes dt = { float(t - t0[i]), float(t - t0[i + 1]), float(t - t0[i + 2]), float(t - t0[i + 3]) };
+                *reinterpret_cast<Lanes *>(&v[i]) = *reinterpret_cast<const Lanes *>(&a[i]) * dt
+                                                  + *reinterpret_cast<const Lanes *>(&b[i]);
+            }
+#endif
+            for(; i < STREAMS; i++)
+                v[i] = a[i] * (t - t0[i]) + b[i];
+        }
+
+    private:
+        Value _a[STREAMS] __attribute__((aligned(16)));
+        Value _b[STREAMS] __attribute__((aligned(16)));
+        Time _t0[STREAMS];
+    };
+
+    // Whether "value" is close enough to "predicted", in Value's own arithmetic, so integer and Fixed Values need no FPU
+    // (for an integer difference, exceeding the truncated bound is the same as exceeding the exact one)
+    template<typename Value>
+    static bool acceptable(const Value & value, const Value & predicted, const Value & relative, const Value & absolute) {
+        Value error = Math::abs(value - predicted);
+        Value max = Math::max(Math::abs(value * relative / 100), absolute);
+        return !(error > max);
+    }
+
     template<unsigned int T, typename _Model>
     class Model: public _Model
     {
@@ -249,12 +372,12 @@ public:
     } __attribute__((packed));
 
 public:
-    LVP(Value r = 0, Value a = 0, Time t = 0): _config(r, a, t), _miss_predicted(0) {
+    LVP(Value r = 0, Value a = 0, Time t = 0): _config(r, a, t), _model(TYPE), _miss_predicted(0) {
         db<Predictors>(TRC) << "LVP(r=" << r << ",a=" << a << ",t=" << t << ")" << endl;
         db<Predictors>(INF) << "LVP:config=" << _config << ",model=" << _model << ")" << endl;
     }
 
-    LVP(const Configuration & c, bool r = false): _config(c), _miss_predicted(0) {
+    LVP(const Configuration & c, bool r = false): _config(c), _model(TYPE), _miss_predicted(0) {
         db<Predictors>(TRC) << "LVP(c=" << c << ",r=" << r << ")" << endl;
         db<Predictors>(INF) << "LVP:config=" << _config << ",model=" << _model << ")" << endl;
     }
@@ -267,15 +390,13 @@ public:
     bool trickle(const Time & time, const Value & value) {
         db<Predictors>(TRC) << "LVP::trickle(t=" << time << ",v=" << value << ",t=" << time << ")" << endl;
 
-        float predicted = predict(time);
-        float max_acceptable_error = Math::max(Math::abs(((float)value * (float)_config.relative_error)/100.0f), (float)_config.absolute_error);
-        float error = Math::abs((float)value - predicted);
+        Value predicted = predict(time);
 
-        db<Predictors>(TRC) << "LVP::trickle:real=" << value << ",pred=" << predicted << ",err=" << error << ",max=" << max_acceptable_error << ",t_err:" << _config.time_error << ",miss:" << _miss_predicted << ")" << endl;
+        db<Predictors>(TRC) << "LVP::trickle:real=" << value << ",pred=" << predicted << ",t_err:" << _config.time_error << ",miss:" << _miss_predicted << ")" << endl;
 
-        if(error > max_acceptable_error) {
-            if(++_miss_predicted > _config.time_error) {
-                _model->value(value);
+        if(!acceptable(value, predicted, _config.relative_error, _config.absolute_error)) {
+            if(++_miss_predicted > static_cast<unsigned int>(_config.time_error)) {
+                _model.value(value);
                 _miss_predicted = 0;
                 return false;
             }
@@ -374,14 +495,11 @@ public:
                 return false;
             }
         } else {
-            float predicted = predict(time);
-            OStream cout;
-            float max_acceptable_error = Math::max(Math::abs(((float)value * (float)_config.relative_error)/100.0f), (float)_config.absolute_error);
-            float error = Math::abs((float)value - predicted);
+            Value predicted = predict(time);
 
-            db<Predictors>(TRC) << "LVP::trickle:real=" << value << ",pred=" << predicted << ",err=" << error << ",max=" << max_acceptable_error << ",t_err:" << _config.time_error << ",miss:" << _miss_predicted << ")" << endl;
+            db<Predictors>(TRC) << "DBP::trickle:real=" << value << ",pred=" << predicted << ",t_err:" << _config.time_error << ",miss:" << _miss_predicted << ")" << endl;
 
-            if(error > max_acceptable_error) {
+            if(!acceptable(value, predicted, _config.relative_error, _config.absolute_error)) {
                 if(++_miss_predicted > _config.time_error) {
                     build_model(time, value);
                     _miss_predicted = 0;
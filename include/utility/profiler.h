@@ -0,0 +1,65 @@
+// EPOS Statistical Profiler Utility Declarations
+
+#ifndef __profiler_h
+#define __profiler_h
+
+#include <architecture.h>
+#include <utility/per_cpu.h>
+
+__BEGIN_UTIL
+
+// Per-CPU histogram of the PCs (and threads) interrupted by the alarm tick (enabled by Traits<Thread>::profiled)
+// Each bin counts the samples taken at the same PC in the same thread. Bins are found by hashing with a few
+// probes, so sampling costs about as much as a Trace record; samples that find no bin are counted as dropped.
+// dump() prints one "@ pc thread count" line per bin, whose PCs can be symbolized against the application's
+// ELF on the host, e.g. grep '^@' log | awk '{print $2}' | addr2line -f -e app
+class Profiler
+{
+public:
+    static const bool enabled = Traits<Thread>::profiled;
+    static const unsigned int BINS = enabled ? Traits<Thread>::PROFILE_BINS : 1;
+    static const unsigned int PROBES = 8;
+
+    struct Bin {
+        const void * pc;
+        const void * thread;
+        unsigned int count;
+    };
+
+public:
+    // Must be called with interrupts disabled (as interrupt handlers are), so the CPU's histogram isn't shared
+    static void sample(const void * pc, const volatile void * thread) {
+        if(!enabled)
+            return;
+
+        unsigned int cpu = CPU::id();
+        const void * t = const_cast<const void *>(thread);
+        unsigned long h = (reinterpret_cast<unsigned long>(pc) >> 1) ^ (reinterpret_cast<unsigned long>(t) >> 4);
+
+        _samples[cpu]++;
+        for(unsigned int i = 0; i < PROBES; i++, h++) {
+            Bin & b = _bins[cpu][h % BINS];
+            if(!b.count) {
+                b.pc = pc;
+                b.thread = t;
+            }
+            if((b.pc == pc) && (b.thread == t)) {
+                b.count++;
+                return;
+            }
+        }
+        _dropped[cpu]++;
+    }
+
+    static void dump();
+    static void reset();
+
+private:
+    static Per_CPU<unsigned int> _samples;
+    static Per_CPU<unsigned int> _dropped;
+    static Bin _bins[Traits<Build>::CPUS][BINS];
+};
+
+__END_UTIL
+
+#endif
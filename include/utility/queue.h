@@ -29,6 +29,9 @@
 // |ord|		| 4 |<--| 3 |<--| 2 |
 // +---+ 		+---+	+---+	+---+
 
+// Heap Queue orders its objects just like Ordered Queue, but keeps them in
+// a pairing heap instead of a list, so insertions don't walk the queue.
+
 // Scheduling Queue is an ordered queue whose ordering criterion is externally
 // definable and for which selecting methods are defined (e.g. choose). This
 // utility is most useful for schedulers, such as CPU or I/O.
@@ -38,6 +41,7 @@
 
 #include <architecture.h>
 #include "list.h"
+#include "pairing_heap.h"
 #include "spin.h"
 
 __BEGIN_UTIL
@@ -94,6 +98,99 @@ template<typename T,
           typename El = List_Elements::Doubly_Linked_Ordered<T, R> >
 class Relative_Queue: public Queue_Wrapper<Relative_List<T, R, El>, false> {};
 
+
+// Heap-Ordered Queue
+// An Ordered_Queue whose insertions take O(1) and removals O(log n) (see Pairing_Heap), but that can't be iterated
+template<typename T,
+          typename R = List_Element_Rank,
+          typename El = List_Elements::Pairing_Heap_Ordered<T, R> >
+class Heap_Queue: public Pairing_Heap<T, R, El> {};
+
+
+// Multiple-Producer, Single-Consumer Queue (D. Vyukov's intrusive algorithm)
+// Any number of threads, ISRs and CPUs can insert() concurrently, without locks, while a single owner (e.g. a thread
+// or the scheduler of a given CPU) remove()s from the head.  Producers swing "_head" to their element with CPU::cas()
+// and only then link the previous head to it, so remove() may find the queue momentarily broken (a producer was
+// preempted between both steps) and return 0 even though it is not empty; the owner must try again later.
+// The queue keeps an internal stub element, so elements are never touched after being removed.
+template<typename T>
+class MPSC_Queue
+{
+public:
+    typedef T Object_Type;
+
+    class Element
+    {
+        friend class MPSC_Queue;
+
+    public:
+        Element(const T * o = 0): _object(o), _next(0) {}
+
+        T * object() const { return const_cast<T *>(_object); }
+
+    private:
+        const T * _object;
+        Element * _next;
+    };
+
+public:
+    MPSC_Queue(): _head(&_stub), _tail(&_stub) {}
+
+    // Consumer only
+    bool empty() const { return (_tail == &_stub) && !acquire(_stub._next); }
+
+    // Any producer
+    void insert(Element * e) {
+        release(e->_next, 0);
+        Element * prev;
+        do
+            prev = _head;
+        while(CPU::cas(_head, prev, e) != prev);
+        release(prev->_next, e); // publishes e, including the object it refers to, to the consumer
+    }
+
+    // Consumer only
+    Element * remove() {
+        Element * tail = _tail;
+        Element * next = acquire(tail->_next);
+
+        if(tail == &_stub) { // skip the stub
+            if(!next)
+                return 0;
+            _tail = next;
+            tail = next;
+            next = acquire(next->_next);
+        }
+
+        if(next) {
+            _tail = next;
+            return tail;
+        }
+
+        if(tail != _head) // a producer is still linking its element
+            return 0;
+
+        // tail is the last element, but removing it would leave nothing for producers to link to
+        insert(&_stub);
+        next = acquire(tail->_next);
+        if(next) {
+            _tail = next;
+            return tail;
+        }
+
+        return 0;
+    }
+
+private:
+    static Element * acquire(Element * const & p) { return __atomic_load_n(&p, __ATOMIC_ACQUIRE); }
+    static void release(Element * & p, Element * e) { __atomic_store_n(&p, e, __ATOMIC_RELEASE); }
+
+private:
+    Element * volatile _head;   // the last element inserted, where producers link
+    Element * _tail;            // the next to be removed, only touched by the consumer
+    Element _stub;
+};
+
 __END_UTIL
 
 #endif
@@ -1,36 +1,56 @@
 // EPOS Pseudo Random Number Generator Utility Declarations
 
-// From http://en.wikipedia.org/wiki/Linear_congruential_generator
-// with A = 2 and variable C on a simplification of:
-// X1 = aX0 + c
-// as X1 = (X0 << 1) xor C
+// xoshiro128** (Blackman and Vigna, "Scrambled Linear Pseudorandom Number Generators", 2018), which keeps 128 bits
+// of state and takes only shifts, rotations, XORs and two multiplications by constants per number, so it is as fast
+// on 32-bit cores as on 64-bit ones. Each CPU has its own state, so numbers are drawn without contention under SMP;
+// threads running on the same CPU share its sequence. The generator is not cryptographically secure.
 
 #ifndef __random_h
 #define __random_h
 
-#include <system/config.h>
+#include <architecture/cpu.h>
 
 __BEGIN_UTIL
 
 class Random
 {
 private:
-    static const unsigned long A = 1103515245;
-    static const unsigned long C = 12345;
-    static const unsigned long M = 4294967295U;
+    static const unsigned int CPUS = Traits<Build>::CPUS;
+
+    struct State
+    {
+        constexpr State(): s{0x9e3779b9, 0x243f6a88, 0x85a308d3, 0x13198a2e} {}
+
+        unsigned int s[4];
+    } __attribute__((aligned(Traits<CPU>::CACHE_LINE_SIZE)));
 
 public:
-    static int random() {
-        _seed = ((_seed * A) + C) % M; //_seed = (_seed << 1) ^ n;
-        return _seed;
-    }
+    static int random() { return next(_state[(CPUS > 1) ? CPU::id() : 0]); }
 
-    static void seed(int value) {
-        _seed = value;
+    // Fills n bytes at buf with random numbers
+    static void fill(void * buf, unsigned int n);
+
+    // Sets the state of all CPUs from a single value (each one gets a different sequence)
+    static void seed(int value);
+
+private:
+    static unsigned int rotl(unsigned int x, unsigned int k) { return (x << k) | (x >> (32 - k)); }
+
+    static unsigned int next(State & state) {
+        unsigned int * s = state.s;
+        unsigned int result = rotl(s[1] * 5, 7) * 9;
+        unsigned int t = s[1] << 9;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 11);
+        return result;
     }
 
 private:
-    static int _seed;
+    static State _state[CPUS];
 };
 
 __END_UTIL
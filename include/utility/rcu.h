@@ -0,0 +1,101 @@
+// EPOS Read-Copy-Update Utility Declarations
+
+#ifndef __rcu_h
+#define __rcu_h
+
+#include <architecture.h>
+#include <utility/spin.h>
+
+__BEGIN_UTIL
+
+// Quiescent-state-based Read-Copy-Update (enabled by Traits<Thread>::rcu)
+// Readers of RCU-protected pointers only mask interrupts on their own CPU, so they can't be preempted, and never write
+// shared memory. Writers publish new versions with assign() and hand old ones to call(), whose callback (e.g. a free)
+// only runs once a grace period has gone by, i.e. after every CPU passed through a quiescent state that it can't be
+// in a read-side section at: Thread::dispatch() (readers never block) and the idle loop report them with quiescent().
+// Grace periods are counted in epochs: an epoch ends once all CPUs reported in it, so something retired during epoch
+// E is no longer referenced once epoch E + 1 is over. Callbacks run in reclaim(), from call(), synchronize() and idle.
+class RCU
+{
+public:
+    static const bool enabled = Traits<Thread>::rcu;
+
+private:
+    static const unsigned int CPUS = Traits<Build>::CPUS;
+    static const unsigned int ALL = (CPUS < 32) ? (1U << CPUS) - 1 : ~0U;
+
+public:
+    class Head;
+    typedef void (* Callback)(Head * head);
+
+    // To be embedded in the objects handed to call()
+    class Head
+    {
+        friend class RCU;
+
+    public:
+        Head(): _callback(0), _epoch(0), _next(0) {}
+
+    private:
+        Callback _callback;
+        unsigned int _epoch;
+        Head * _next;
+    };
+
+public:
+    // read_lock() returns whether interrupts were enabled, for read_unlock(), so sections can nest
+    static bool read_lock() {
+        bool unmasked = CPU::int_enabled();
+        CPU::int_disable();
+        return unmasked;
+    }
+    static void read_unlock(bool unmasked) {
+        if(unmasked)
+            CPU::int_enable();
+    }
+
+    template<typename T>
+    static T * dereference(T * const volatile & p) { return p; } // dependent loads are kept in order by all our CPUs
+
+    template<typename T>
+    static void assign(T * volatile & p, T * v) {
+        CPU::fence(); // the new version must be complete before readers can reach it
+        p = v;
+    }
+
+    // Reports a quiescent state of this CPU, ending the epoch if it is the last one to
+    static void quiescent() {
+        if(!enabled)
+            return;
+
+        unsigned int me = 1U << ((CPUS > 1) ? CPU::id() : 0);
+        if(!(_pending & me))
+            return;
+
+        unsigned int old;
+        do
+            old = _pending;
+        while(CPU::cas(_pending, old, old & ~me) != old);
+
+        if(old == me) { // the last one of this epoch
+            _epoch = _epoch + 1;
+            CPU::fence();
+            _pending = ALL;
+        }
+    }
+
+    static void call(Head * head, Callback callback);
+    static void synchronize(); // waits for a grace period (not from within a read-side section)
+    static void reclaim();     // runs the callbacks whose grace period is over (in thread context)
+
+private:
+    static volatile unsigned int _epoch;
+    static volatile unsigned int _pending;  // CPUs yet to report in the current epoch
+    static Head * _head;                    // callbacks waiting for grace periods, in the order of call()
+    static Head * _tail;
+    static Simple_Spin _lock;
+};
+
+__END_UTIL
+
+#endif
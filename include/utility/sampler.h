@@ -0,0 +1,51 @@
+// EPOS Event-based Sampler Utility Declarations
+
+#ifndef __sampler_h
+#define __sampler_h
+
+#include <architecture.h>
+#include <utility/per_cpu.h>
+
+__BEGIN_UTIL
+
+// Per-CPU ring of the PCs (and threads) interrupted by PMU counter overflows (enabled by Traits<Thread>::sampled)
+// PMU::sample(channel, event, period) makes "channel" overflow every "period" events (e.g. L1_DATA_CACHE_MISSES);
+// each overflow records the interrupted PC, thread and channel here before the counter is rearmed. Rings wrap
+// around, keeping the last SAMPLES of each CPU. dump() prints one "# pc thread channel" line per sample, whose PCs
+// can be symbolized against the application's ELF on the host, e.g. grep '^#' log | awk '{print $2}' | addr2line -e app
+class Sampler
+{
+public:
+    static const bool enabled = Traits<Thread>::sampled;
+    static const unsigned int SAMPLES = enabled ? Traits<Thread>::SAMPLES : 1;
+
+    struct Sample {
+        const void * pc;
+        const void * thread;
+        unsigned int channel;
+    };
+
+public:
+    // Must be called with interrupts disabled (as interrupt handlers are), so the CPU's ring isn't shared
+    static void record(const void * pc, const volatile void * thread, unsigned int channel) {
+        if(!enabled)
+            return;
+
+        unsigned int cpu = CPU::id();
+        Sample & s = _ring[cpu][_head[cpu]++ % SAMPLES];
+        s.pc = pc;
+        s.thread = const_cast<const void *>(thread);
+        s.channel = channel;
+    }
+
+    static void dump();
+    static void reset();
+
+private:
+    static Per_CPU<unsigned int> _head;
+    static Sample _ring[Traits<Build>::CPUS][SAMPLES];
+};
+
+__END_UTIL
+
+#endif
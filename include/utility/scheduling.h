@@ -4,6 +4,7 @@
 #define __scheduling_h
 
 #include <utility/list.h>
+#include <utility/pairing_heap.h>
 
 __BEGIN_UTIL
 
@@ -11,9 +12,22 @@ __BEGIN_UTIL
 // the semantics of returning the desired order of a given object within the
 // scheduling list
 
+// Scheduling_Element
+// Objects being scheduled are linked by the same element while they wait
+// (e.g. Thread::Queue), so it only carries the links of Pairing_Heap if the
+// wait queues are heap-ordered (see Traits<Thread>::heap_queues)
+template<typename T, typename R = typename T::Criterion>
+struct Scheduling_Element
+{
+    typedef typename IF<Traits<Thread>::heap_queues, List_Elements::Pairing_Heap_Ordered<T, R>, List_Elements::Doubly_Linked_Scheduling<T, R>>::Result Result;
+};
+
+
 // Scheduling_Queue
+// Criteria exporting "banded" are served by the constant-time, bitmap-indexed
+// list; all others by the rank-ordered one
 template<typename T, typename R = typename T::Criterion>
-class Scheduling_Queue: public Scheduling_List<T> {};
+class Scheduling_Queue: public IF<R::banded, Bitmap_Scheduling_List<T, R, typename Scheduling_Element<T, R>::Result>, Scheduling_List<T, R, typename Scheduling_Element<T, R>::Result>>::Result {};
 
 
 // Scheduler
@@ -29,7 +43,7 @@ private:
 
 public:
     typedef typename T::Criterion Criterion;
-    typedef Scheduling_List<T, Criterion> Queue;
+    typedef Scheduling_List<T, Criterion, typename Scheduling_Element<T>::Result> Queue;
     typedef typename Queue::Element Element;
 
 public:
@@ -93,6 +107,29 @@ public:
         return obj;
     }
 
+    T * steal() {
+        db<Scheduler>(TRC) << "Scheduler[chosen=" << chosen() << "]::steal() => ";
+
+        Element * e = Base::steal();
+        T * obj = e ? e->object() : 0;
+
+        db<Scheduler>(TRC) << obj << endl;
+
+        return obj;
+    }
+
+    template<typename V>
+    T * balance(unsigned int queues, V (* load)(Element *), V (* cost)(Element *)) {
+        db<Scheduler>(TRC) << "Scheduler[chosen=" << chosen() << "]::balance() => ";
+
+        Element * e = Base::balance(queues, load, cost);
+        T * obj = e ? e->object() : 0;
+
+        db<Scheduler>(TRC) << obj << endl;
+
+        return obj;
+    }
+
     T * choose(T * obj) {
         db<Scheduler>(TRC) << "Scheduler[chosen=" << chosen() << "]::choose(" << obj;
 
@@ -0,0 +1,190 @@
+// EPOS Slab Allocator Utility Declarations
+
+#ifndef __slab_h
+#define __slab_h
+
+#include <utility/spin.h>
+
+__BEGIN_UTIL
+
+// Slabs are carved out of the system heap by this non-template helper (see slab.cc), since heaps come after utilities
+class Slab_Common
+{
+protected:
+    static const bool smp = Traits<System>::multicore;
+
+protected:
+    static void * allocate(unsigned long bytes);
+
+    // Same locking as Heap's
+    static bool enter(Spin & lock) {
+        bool enabled = CPU::int_enabled();
+        CPU::int_disable();
+        if(smp)
+            lock.acquire();
+        return enabled;
+    }
+
+    static void leave(Spin & lock, bool enabled) {
+        if(smp)
+            lock.release();
+        if(enabled)
+            CPU::int_enable();
+    }
+};
+
+// Cache of objects of type T, taken from slabs of OBJECTS contiguous objects that are allocated from the system
+// heap as needed and never given back. Free objects are linked through their first word, so allocation and
+// deallocation are constant time and objects carry no header.
+template<typename T, unsigned int OBJECTS = 16>
+class Slab: private Slab_Common
+{
+private:
+    static const unsigned int ALIGN = (alignof(T) > sizeof(void *)) ? alignof(T) : sizeof(void *);
+    static const unsigned int SIZE = (sizeof(T) + ALIGN - 1) / ALIGN * ALIGN;
+
+public:
+    Slab(): _free(0) {}
+
+    void * alloc() {
+        bool enabled = enter(_lock);
+        if(!_free)
+            grow();
+        void * object = _free;
+        if(object)
+            _free = *reinterpret_cast<void **>(object);
+        leave(_lock, enabled);
+
+        db<Heaps>(TRC) << "Slab::alloc(this=" << this << ",size=" << SIZE << ") => " << object << endl;
+
+        return object;
+    }
+
+    void free(void * object) {
+        db<Heaps>(TRC) << "Slab::free(this=" << this << ",object=" << object << ")" << endl;
+
+        bool enabled = enter(_lock);
+        *reinterpret_cast<void **>(object) = _free;
+        _free = object;
+        leave(_lock, enabled);
+    }
+
+private:
+    void grow() {
+        char * slab = reinterpret_cast<char *>(allocate(SIZE * OBJECTS));
+        if(slab)
+            for(unsigned int i = OBJECTS; i > 0; i--) { // so objects are handed out in address order
+                *reinterpret_cast<void **>(slab + (i - 1) * SIZE) = _free;
+                _free = slab + (i - 1) * SIZE;
+            }
+    }
+
+private:
+    void * _free;
+    Spin _lock;
+};
+
+// The static pool of OBJECTS objects of type T, whose storage is a class attribute (in .bss), so taking and returning
+// them never touches a heap. Objects are handed out in address order until each one has been used once and then
+// recycled through a free list, as the Slab's. alloc() returns 0 when all of them are taken.
+template<typename T, unsigned int OBJECTS>
+class Pool: private Slab_Common
+{
+private:
+    static const unsigned int ALIGN = (alignof(T) > sizeof(void *)) ? alignof(T) : sizeof(void *);
+    static const unsigned int SIZE = (sizeof(T) + ALIGN - 1) / ALIGN * ALIGN;
+
+public:
+    static void * alloc() {
+        bool enabled = enter(_lock);
+        void * object = _free;
+        if(object)
+            _free = *reinterpret_cast<void **>(object);
+        else if(_used < OBJECTS)
+            object = &_objects[_used++ * SIZE];
+        leave(_lock, enabled);
+
+        db<Heaps>(TRC) << "Pool::alloc(size=" << SIZE << ") => " << object << endl;
+
+        return object;
+    }
+
+    static void free(void * object) {
+        db<Heaps>(TRC) << "Pool::free(object=" << object << ")" << endl;
+
+        bool enabled = enter(_lock);
+        *reinterpret_cast<void **>(object) = _free;
+        _free = object;
+        leave(_lock, enabled);
+    }
+
+    static bool contains(const void * object) { return (object >= &_objects[0]) && (object < &_objects[OBJECTS * SIZE]); }
+
+private:
+    static void * _free;
+    static unsigned int _used;
+    static Spin _lock;
+    static char _objects[]; // declared without T's size, so T can name its Pool while still incomplete
+};
+
+template<typename T, unsigned int OBJECTS>
+void * Pool<T, OBJECTS>::_free;
+
+template<typename T, unsigned int OBJECTS>
+unsigned int Pool<T, OBJECTS>::_used;
+
+template<typename T, unsigned int OBJECTS>
+Spin Pool<T, OBJECTS>::_lock;
+
+template<typename T, unsigned int OBJECTS>
+char Pool<T, OBJECTS>::_objects[OBJECTS ? OBJECTS * Pool<T, OBJECTS>::SIZE : 1] __attribute__((aligned(Pool<T, OBJECTS>::ALIGN)));
+
+// Mix-in giving T (declared as "class T: public Slab_Allocated<T>") its own Slab for new and new (SYSTEM) (see
+// Traits<System>::slabs). Objects of derived classes, whose sizes differ, fall through to the heaps. Slabs come
+// from the system heap, so they can only serve application objects as well without multiheap.
+// With Traits<T>::STATIC_OBJECTS, the first objects come from a static Pool of that many, whatever the heaps, so
+// creating up to that many objects at once has a bounded cost and no heap traffic (objects beyond it fall through).
+template<typename T, unsigned int OBJECTS = 16>
+class Slab_Allocated
+{
+public:
+    static const bool enabled = Traits<System>::slabs && !Traits<System>::multiheap;
+    static const unsigned int STATIC = Traits<T>::STATIC_OBJECTS;
+
+public:
+    static void * operator new(size_t bytes) { return (bytes == sizeof(T)) ? alloc(false) : ::operator new(bytes); }
+    static void * operator new(size_t bytes, const System_Allocator & allocator) { return (bytes == sizeof(T)) ? alloc(true) : ::operator new(bytes, SYSTEM); }
+    static void * operator new(size_t bytes, void * place) { return place; }
+    static void operator delete(void * object, size_t bytes) {
+        if(STATIC && (bytes == sizeof(T)) && Pool<T, STATIC>::contains(object))
+            Pool<T, STATIC>::free(object);
+        else if(enabled && (bytes == sizeof(T)))
+            _slab.free(object);
+        else
+            ::operator delete(object);
+    }
+
+private:
+    static void * alloc(bool system) {
+        void * object = STATIC ? Pool<T, STATIC>::alloc() : 0;
+        if(!object) {
+            if(STATIC)
+                db<Heaps>(WRN) << "Slab_Allocated::alloc: all " << STATIC << " static objects of " << sizeof(T) << " bytes taken!" << endl;
+            if(enabled)
+                object = _slab.alloc();
+            else
+                object = system ? ::operator new(sizeof(T), SYSTEM) : ::operator new(sizeof(T));
+        }
+        return object;
+    }
+
+private:
+    static Slab<T, OBJECTS> _slab;
+};
+
+template<typename T, unsigned int OBJECTS>
+Slab<T, OBJECTS> Slab_Allocated<T, OBJECTS>::_slab;
+
+__END_UTIL
+
+#endif
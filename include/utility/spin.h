@@ -4,18 +4,26 @@
 #define __spin_h
 
 #include <architecture.h>
+#include <utility/contention.h>
 
 __BEGIN_UTIL
 
 // Forwarder to the running thread id
+// Each CPU is identified by its number until it leaves the boot (see Thread::init()), since it has no thread before that
 class This_Thread
 {
+private:
+    static const unsigned int CPUS = Traits<Build>::CPUS;
+
 public:
     static volatile CPU::Reg id();
-    static void not_booting() { _not_booting = true; }
+    static void not_booting() { _not_booting[cpu()] = true; }
+
+private:
+    static unsigned int cpu() { return (CPUS > 1) ? CPU::id() : 0; }
 
 private:
-    static bool _not_booting;
+    static bool _not_booting[CPUS];
 };
 
 // Recursive Spin Lock
@@ -27,7 +35,12 @@ public:
     void acquire() {
         unsigned int me = This_Thread::id();
 
+        Contention::Time_Stamp since = 0;
+        if(Contention::enabled && _owner && (_owner != me))
+            since = _statistics.contended(0);
         while(CPU::cas(_owner, 0U, me) != me);
+        if(!_level)
+            _statistics.acquired(this, since);
         _level++;
 
         db<Spin>(TRC) << "Spin::acquire[this=" << this << ",id=" << hex << me << "]() => {owner=" << _owner << dec << ",level=" << _level << "}" << endl;
@@ -44,9 +57,12 @@ public:
 
     volatile bool taken() const { return (_owner != 0); }
 
+    const Contention::Statistics & statistics() const { return _statistics; }
+
 private:
     volatile int _level;
     volatile unsigned int _owner;
+    Contention::Statistics _statistics;
 };
 
 // Flat Spin Lock
@@ -71,6 +87,136 @@ private:
     volatile bool _locked;
 };
 
+// Recursive Ticket Spin Lock
+// Waiters are served in FIFO order: each takes the next ticket and waits for _serving to reach it, so only the holder
+// writes the line all of them read, once per release
+class Ticket_Spin
+{
+public:
+    Ticket_Spin(): _level(0), _owner(0), _next(0), _serving(0) {}
+
+    void acquire() {
+        unsigned int me = This_Thread::id();
+
+        if(_owner != me) {
+            unsigned int ticket = CPU::finc(_next);
+            Contention::Time_Stamp since = 0;
+            if(Contention::enabled && (_serving != ticket))
+                since = _statistics.contended(ticket - _serving);
+            while(_serving != ticket)
+                CPU::pause();
+            CPU::fence(); // nor can the critical section be seen before we get in
+            _owner = me;
+            _statistics.acquired(this, since);
+        }
+        _level++;
+
+        db<Spin>(TRC) << "Ticket_Spin::acquire[this=" << this << ",id=" << hex << me << "]() => {owner=" << _owner << dec << ",level=" << _level << "}" << endl;
+    }
+
+    void release() {
+        db<Spin>(TRC) << "Ticket_Spin::release[this=" << this << "]() => {owner=" << hex << _owner << dec << ",level=" << _level << "}" << endl;
+
+        if(--_level <= 0) {
+            _level = 0;
+            _owner = 0;
+            CPU::fence(); // the critical section must be visible before the next waiter gets in
+            _serving = _serving + 1;
+        }
+    }
+
+    volatile bool taken() const { return (_owner != 0); }
+
+    const Contention::Statistics & statistics() const { return _statistics; }
+
+private:
+    volatile int _level;
+    volatile unsigned int _owner;
+    volatile unsigned int _next;
+    volatile unsigned int _serving;
+    Contention::Statistics _statistics;
+};
+
+// Recursive MCS Queue Spin Lock (Mellor-Crummey and Scott)
+// Waiters are served in FIFO order, each one spinning on a node of its own, which its predecessor flags on release,
+// so a release touches a single remote line. Nodes belong to CPUs, so the lock must be released by the CPU that
+// acquired it, as is the case of kernel locks, which are taken with interrupts disabled (see Thread::lock()).
+class MCS_Spin
+{
+private:
+    static const unsigned int CPUS = Traits<Build>::CPUS;
+
+    struct Node {
+        Node * volatile next;
+        volatile bool waiting;
+    };
+
+public:
+    MCS_Spin(): _level(0), _owner(0), _tail(0) {}
+
+    void acquire() {
+        unsigned int me = This_Thread::id();
+
+        if(_owner != me) {
+            Node * n = &_nodes[cpu()];
+            n->next = 0;
+            n->waiting = true;
+
+            Node * prev;
+            do
+                prev = _tail;
+            while(CPU::cas(_tail, prev, n) != prev);
+
+            Contention::Time_Stamp since = 0;
+            if(prev) {
+                since = _statistics.contended(0);
+                prev->next = n;
+                while(n->waiting)
+                    CPU::pause();
+                CPU::fence(); // nor can the critical section be seen before we get in
+            }
+            _owner = me;
+            _statistics.acquired(this, since);
+        }
+        _level++;
+
+        db<Spin>(TRC) << "MCS_Spin::acquire[this=" << this << ",id=" << hex << me << "]() => {owner=" << _owner << dec << ",level=" << _level << "}" << endl;
+    }
+
+    void release() {
+        db<Spin>(TRC) << "MCS_Spin::release[this=" << this << "]() => {owner=" << hex << _owner << dec << ",level=" << _level << "}" << endl;
+
+        if(--_level <= 0) {
+            _level = 0;
+            _owner = 0;
+
+            Node * n = &_nodes[cpu()];
+            if(!n->next) {
+                if(CPU::cas(_tail, n, static_cast<Node *>(0)) == n)
+                    return;
+                while(!n->next) // a successor swapped itself into _tail, but hasn't linked to us yet
+                    CPU::pause();
+            }
+            CPU::fence(); // the critical section must be visible before the successor gets in
+            n->next->waiting = false;
+        }
+    }
+
+    volatile bool taken() const { return (_owner != 0); }
+
+    const Contention::Statistics & statistics() const { return _statistics; }
+
+private:
+    static unsigned int cpu() { return (CPUS > 1) ? CPU::id() : 0; }
+
+private:
+    volatile int _level;
+    volatile unsigned int _owner;
+    Node * volatile _tail;
+    Node _nodes[CPUS];
+    Contention::Statistics _statistics;
+};
+
 __END_UTIL
 
 #endif
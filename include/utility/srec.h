@@ -4,11 +4,16 @@
 #define	__srec_h 1
 
 #include <system/config.h>
+#include <utility/page_writer.h>
 
 __BEGIN_UTIL
 
 class SREC
 {
+public:
+    template<typename Sink, unsigned int PAGE = 256>
+    class Stream;
+
 public:
     SREC() {}
 
@@ -42,16 +47,84 @@ private:
       unsigned char data[256];
     };
 
-    inline int C1(unsigned char* l, unsigned char p) {
+    static inline int C1(unsigned char* l, unsigned char p) {
       return ctab[l[p]];
     };
 
-    inline int C2(unsigned char* l, unsigned char p) {
+    static inline int C2(unsigned char* l, unsigned char p) {
       return (C1(l,p) << 4) | (C1(l, p+1));
     };
 
-    bool srec_decode(srec_t *srec, char *_line);
+    static bool srec_decode(srec_t *srec, char *_line);
+
+};
+
+
+// Incremental S-record decoder
+// Takes an image in chunks of any size (e.g. as radio packets arrive), so it never has to be whole in memory, and hands
+// the data records to "sink" through a Page_Writer, one write per page when records come in address order.
+template<typename Sink, unsigned int PAGE>
+class SREC::Stream
+{
+private:
+    static const unsigned int LINE = 4 + 255 * 2 + 1; // "Stt" + count + 255 bytes of address, data and checksum
+
+public:
+    Stream(Sink * sink): _writer(sink), _length(0), _entry(0), _done(false), _error(false) {}
+
+    // Returns false once the image turned out to be corrupted
+    bool feed(const void * data, unsigned int size) {
+        const char * d = reinterpret_cast<const char *>(data);
+        for(unsigned int i = 0; (i < size) && !_error && !_done; i++) {
+            if((d[i] == '\n') || (d[i] == '\r')) {
+                if(_length)
+                    record();
+                _length = 0;
+            } else if(_length < LINE)
+                _line[_length++] = d[i];
+            else
+                _error = true;
+        }
+        return !_error;
+    }
+
+    // Flushes what is pending (including a last record without a line break) and returns the number of bytes written
+    // to the sink, or -1 if the image was corrupted
+    long finish() {
+        if(_length && !_error && !_done)
+            record();
+        _length = 0;
+        _writer.flush();
+        return _error ? -1 : static_cast<long>(_writer.bytes());
+    }
+
+    bool done() const { return _done; } // the end record was seen
+    void * entry() const { return _entry; }
 
+private:
+    void record() {
+        _line[_length] = 0;
+        srec_t srec;
+        if((_line[0] != 'S') || !srec_decode(&srec, _line)) {
+            _error = true;
+            return;
+        }
+
+        switch(_line[1]) {
+        case '0': case '5': case '6': break;
+        case '1': case '2': case '3': _writer.write(srec.addr, srec.data, srec.count); break;
+        case '7': case '8': case '9': _entry = reinterpret_cast<void *>(static_cast<unsigned long>(srec.addr)); _done = true; break;
+        default: _error = true;
+        }
+    }
+
+private:
+    Page_Writer<Sink, PAGE> _writer;
+    char _line[LINE + 1];
+    unsigned int _length;
+    void * _entry;
+    bool _done;
+    bool _error;
 };
 
 __END_UTIL
@@ -0,0 +1,282 @@
+// EPOS Two-Level Segregated Fit Allocator Utility Declarations
+
+// TLSF keeps free blocks in size classes: the first level is the power of two below the size and the second one
+// splits each power of two in 2^SL linear steps. Each class has its own free list and two bitmaps tell which ones
+// are not empty, so finding a block at least as large as requested, splitting it, and coalescing a freed block with
+// its physical neighbors are all O(1). Blocks carry a one-word boundary tag (size and two flags) and free blocks
+// also repeat their size in their last word, so the block to the left of any block can be found.
+// Each region given to free_region() ends with a zero-sized used tag, so blocks never merge across regions.
+//
+// Free block:  | size|FREE|prev_free | next | prev | ... | size |
+// Used block:  | size|prev_free | object ... |
+
+#ifndef __tlsf_h
+#define __tlsf_h
+
+#include <utility/debug.h>
+
+__BEGIN_UTIL
+
+template<unsigned int FL = 32, unsigned int SL = 3>
+class TLSF
+{
+private:
+    typedef unsigned long Tag;
+
+    static const unsigned int SLS = 1 << SL;
+    static const Tag FREE       = 1 << 0;
+    static const Tag PREV_FREE  = 1 << 1;
+    static const Tag FLAGS      = FREE | PREV_FREE;
+    static const Tag WORD       = sizeof(Tag);
+
+    struct Block {
+        Tag tag;
+        Block * next;
+        Block * prev;
+
+        Tag size() const { return tag & ~FLAGS; }
+        Block * right() { return reinterpret_cast<Block *>(reinterpret_cast<char *>(this) + size()); }
+        Block * left() { return reinterpret_cast<Block *>(reinterpret_cast<char *>(this) - *(reinterpret_cast<Tag *>(this) - 1)); }
+        void footer() { *reinterpret_cast<Tag *>(reinterpret_cast<char *>(this) + size() - WORD) = size(); }
+    };
+
+    static const Tag MIN = sizeof(Block) + WORD; // the footer
+
+public:
+    TLSF(): _fl_map(0), _size(0), _grouped_size(0) {
+        for(unsigned int i = 0; i < FL; i++) {
+            _sl_map[i] = 0;
+            for(unsigned int j = 0; j < SLS; j++)
+                _free[i][j] = 0;
+        }
+    }
+
+    bool empty() const { return !_size; }
+    unsigned int size() const { return _size; }
+    unsigned int grouped_size() const { return _grouped_size; }
+
+    // Size of the largest free block, which is in the highest non-empty class
+    unsigned long largest() const {
+        if(!_fl_map)
+            return 0;
+        unsigned int fl = msb(_fl_map);
+        unsigned long size = 0;
+        for(Block * b = _free[fl][msb(_sl_map[fl])]; b; b = b->next)
+            if(b->size() > size)
+                size = b->size();
+        return size;
+    }
+
+    // Gives a whole region of memory to the allocator
+    void free_region(void * addr, unsigned long bytes) {
+        Tag a = (reinterpret_cast<Tag>(addr) + WORD - 1) & ~(WORD - 1);
+        bytes = (bytes - (a - reinterpret_cast<Tag>(addr))) & ~(WORD - 1);
+        if(bytes < MIN + WORD)
+            return;
+
+        Block * b = reinterpret_cast<Block *>(a);
+        b->tag = bytes - WORD;
+        Block * sentinel = b->right();
+        sentinel->tag = 0;
+        release(b);
+    }
+
+    // Extends the region that ends at "end" with "bytes" right after it, which merge with its last free block
+    void grow(void * end, unsigned long bytes) {
+        Block * b = reinterpret_cast<Block *>(reinterpret_cast<char *>(end) - WORD); // the region's sentinel
+        b->tag = (bytes & ~(WORD - 1)) | (b->tag & PREV_FREE);
+        b->right()->tag = 0;
+        release(b);
+    }
+
+    // Takes multiples of "unit" bytes off the region that ends at "end", from its last block if it is free, leaving
+    // at least "keep" bytes of the block. Returns how many bytes were taken.
+    unsigned long trim(void * end, unsigned long unit, unsigned long keep) {
+        Block * s = reinterpret_cast<Block *>(reinterpret_cast<char *>(end) - WORD);
+        if(!(s->tag & PREV_FREE))
+            return 0;
+
+        Block * b = s->left();
+        if(keep < MIN)
+            keep = MIN;
+        if(b->size() < keep + unit)
+            return 0;
+
+        Tag bytes = (b->size() - keep) / unit * unit;
+        remove(b);
+        b->tag = (b->size() - bytes) | (b->tag & PREV_FREE);
+        b->right()->tag = 0;
+        insert(b);
+
+        return bytes;
+    }
+
+    // Returns a block whose address plus offset (a multiple of the word size) is a multiple of align (a power of two)
+    void * alloc(unsigned long bytes, unsigned long align = WORD, unsigned long offset = 0) {
+        Tag s = round(bytes);
+        Tag slack = (align > WORD) ? align + MIN : 0; // room to split an unaligned front off as a free block
+
+        // Round up to the next class boundary, so any block in the chosen class fits
+        unsigned int fl, sl;
+        Tag r = s + slack;
+        mapping(r + (Tag(1) << (msb(r) - SL)) - 1, fl, sl);
+        Block * b = find(fl, sl);
+        if(!b)
+            return 0;
+        remove(b, fl, sl);
+
+        if(slack) {
+            Tag start = reinterpret_cast<Tag>(b) + WORD;
+            Tag aligned = ((start + offset + align - 1) & ~(align - 1)) - offset;
+            if(aligned != start) {
+                while(aligned - start < MIN)
+                    aligned += align;
+                Block * n = reinterpret_cast<Block *>(reinterpret_cast<char *>(b) + (aligned - start));
+                n->tag = b->size() - (aligned - start);
+                b->tag = (aligned - start) | (b->tag & PREV_FREE);
+                insert(b);
+                b = n;
+            }
+        }
+        split(b, s);
+
+        return reinterpret_cast<char *>(b) + WORD;
+    }
+
+    // Grows (taking from the right neighbor, if it is free) or shrinks a block allocated by alloc() in place
+    bool resize(void * ptr, unsigned long bytes) {
+        Block * b = reinterpret_cast<Block *>(reinterpret_cast<char *>(ptr) - WORD);
+        Tag s = round(bytes);
+        if(s > b->size()) {
+            Block * r = b->right();
+            if(!(r->tag & FREE) || (b->size() + r->size() < s))
+                return false;
+            remove(r);
+            b->tag += r->size();
+        }
+        split(b, s);
+
+        return true;
+    }
+
+    // Returns a block allocated by alloc()
+    void free(void * ptr) {
+        Block * b = reinterpret_cast<Block *>(reinterpret_cast<char *>(ptr) - WORD);
+        release(b);
+    }
+
+private:
+    static unsigned int msb(Tag v) { return sizeof(Tag) * 8 - 1 - __builtin_clzl(v); }
+    static unsigned int lsb(Tag v) { return __builtin_ctzl(v); }
+
+    static Tag round(unsigned long bytes) {
+        Tag s = (bytes + WORD + WORD - 1) & ~(WORD - 1);
+        return (s < MIN) ? MIN : s;
+    }
+
+    static void mapping(Tag s, unsigned int & fl, unsigned int & sl) {
+        fl = msb(s);
+        sl = (s >> (fl - SL)) & (SLS - 1);
+    }
+
+    // Finds the first non-empty class from (fl, sl) on, which is updated to it
+    Block * find(unsigned int & fl, unsigned int & sl) {
+        if(fl >= FL)
+            return 0;
+        Tag sl_map = _sl_map[fl] & (~Tag(0) << sl);
+        if(!sl_map) {
+            Tag fl_map = (fl + 1 < sizeof(Tag) * 8) ? (_fl_map & (~Tag(0) << (fl + 1))) : 0;
+            if(!fl_map)
+                return 0;
+            fl = lsb(fl_map);
+            sl_map = _sl_map[fl];
+        }
+        sl = lsb(sl_map);
+        return _free[fl][sl];
+    }
+
+    void insert(Block * b) {
+        unsigned int fl, sl;
+        mapping(b->size(), fl, sl);
+
+        b->tag |= FREE;
+        b->footer();
+        b->right()->tag |= PREV_FREE;
+
+        b->prev = 0;
+        b->next = _free[fl][sl];
+        if(b->next)
+            b->next->prev = b;
+        _free[fl][sl] = b;
+        _sl_map[fl] |= Tag(1) << sl;
+        _fl_map |= Tag(1) << fl;
+        _size++;
+        _grouped_size += b->size();
+    }
+
+    void remove(Block * b, unsigned int fl, unsigned int sl) {
+        if(b->prev)
+            b->prev->next = b->next;
+        else {
+            _free[fl][sl] = b->next;
+            if(!b->next) {
+                _sl_map[fl] &= ~(Tag(1) << sl);
+                if(!_sl_map[fl])
+                    _fl_map &= ~(Tag(1) << fl);
+            }
+        }
+        if(b->next)
+            b->next->prev = b->prev;
+        _size--;
+        _grouped_size -= b->size();
+    }
+
+    void remove(Block * b) {
+        unsigned int fl, sl;
+        mapping(b->size(), fl, sl);
+        remove(b, fl, sl);
+    }
+
+    // Marks a block that is out of the lists as used, giving back what is left beyond s bytes
+    void split(Block * b, Tag s) {
+        Tag rest = b->size() - s;
+        if(rest >= MIN) {
+            b->tag = s | (b->tag & PREV_FREE);
+            Block * r = b->right();
+            r->tag = rest;
+            release(r);
+        } else {
+            b->tag &= ~FREE;
+            b->right()->tag &= ~PREV_FREE;
+        }
+    }
+
+    // Coalesces with free neighbors and inserts in the corresponding class
+    void release(Block * b) {
+        b->tag &= ~FREE;
+
+        Block * r = b->right();
+        if(r->tag & FREE) {
+            remove(r);
+            b->tag += r->size();
+        }
+        if(b->tag & PREV_FREE) {
+            Block * l = b->left();
+            remove(l);
+            l->tag += b->size();
+            b = l;
+        }
+        insert(b);
+    }
+
+private:
+    Tag _fl_map;
+    Tag _sl_map[FL];
+    Block * _free[FL][SLS];
+    unsigned int _size;
+    unsigned int _grouped_size;
+};
+
+__END_UTIL
+
+#endif
@@ -0,0 +1,101 @@
+// EPOS Binary Event Trace Utility Declarations
+
+#ifndef __trace_h
+#define __trace_h
+
+#include <architecture.h>
+#include <utility/per_cpu.h>
+
+__BEGIN_UTIL
+
+// Per-CPU rings of fixed-size binary events on a common timeline (enabled by Traits<Thread>::traced)
+// The scheduler, the alarms, the interrupt controllers and the lock profiler (with Traits<Synchronizer>::profiled,
+// which measures the waits) all record here, so recording is a handful of stores with no formatting and can be left
+// on while chasing timing problems that db<Thread>(TRC) would mask. Rings wrap around, keeping the last EVENTS records
+// of each CPU, and are only decoded by dump(), which should be called after the fact (e.g. at the end of main()).
+// Time stamps come from the TSC, which is a single clock for all CPUs (e.g. MTIME in the CLINT, or the Cortex-A global
+// timer), except on IA32, whose per-core TSCs are aligned to CPU 0's by sync() when they all leave the Init_End
+// barrier. dump() merges the rings in time stamp order, so chains across CPUs (e.g. an interrupt on CPU 0 waking up a
+// thread that then runs on CPU 2) can be followed from one "@trace ts cpu event a b s" line to the next.
+class Trace
+{
+public:
+    static const bool enabled = Traits<Thread>::traced;
+    static const unsigned int EVENTS = enabled ? Traits<Thread>::TRACE_EVENTS : 1;
+
+    typedef TSC::Time_Stamp Time_Stamp;
+
+    enum Event {
+        DISPATCH,       // a = prev, b = next, state = prev's state
+        SLEEP,          // a = running thread, b = queue, state = running's state
+        WAKEUP,         // a = running thread, b = woken thread, state = woken's state
+        ALARM,          // a = alarm, b = handler, state = remaining times
+        INTERRUPT,      // a = interrupt id, b = 0, state = how late it was served (timer interrupts only, else 0)
+        LOCK            // a = lock, b = caller, state = how long it was waited for
+    };
+
+    struct Record {
+        Time_Stamp ts;
+        unsigned int event;
+        const void * a;
+        const void * b;
+        int state;
+    };
+
+public:
+    static void record(const Event & e, const volatile void * a, const volatile void * b, int state) {
+        if(!enabled)
+            return;
+
+        // Handlers on this CPU can't interleave their records with this one, nor the thread move to another CPU
+        bool disabled = CPU::int_disabled();
+        if(!disabled)
+            CPU::int_disable();
+
+        unsigned int cpu = CPU::id();
+        Record & r = _ring[cpu][_head[cpu]++ % EVENTS];
+        r.ts = TSC::time_stamp();
+        r.event = e;
+        r.a = const_cast<const void *>(a);
+        r.b = const_cast<const void *>(b);
+        r.state = state;
+
+        if(!disabled)
+            CPU::int_enable();
+    }
+
+    static void interrupt(unsigned long id, const Time_Stamp & late = 0) {
+        record(INTERRUPT, reinterpret_cast<const void *>(id), 0, clamp(late));
+    }
+
+    static void lock(const volatile void * lock, const void * caller, const Time_Stamp & wait) {
+        record(LOCK, lock, caller, clamp(wait));
+    }
+
+    // Called by every CPU as it leaves the same barrier
+    static void sync() {
+        if(enabled && !GLOBAL_CLOCK)
+            _skew[CPU::id()] = TSC::time_stamp();
+    }
+
+    static void dump();
+    static void reset();
+
+private:
+#ifdef __ia32__
+    static const bool GLOBAL_CLOCK = (Traits<Build>::CPUS == 1);
+#else
+    static const bool GLOBAL_CLOCK = true;
+#endif
+
+    static int clamp(const Time_Stamp & t) { return (t > 0x7fffffff) ? 0x7fffffff : t; }
+
+private:
+    static Per_CPU<unsigned int> _head;
+    static Record _ring[Traits<Build>::CPUS][EVENTS];
+    static Time_Stamp _skew[Traits<Build>::CPUS];
+};
+
+__END_UTIL
+
+#endif
@@ -0,0 +1,112 @@
+// EPOS Timing Wheel Utility Declarations
+
+// Timing_Wheel is a hashed timing wheel: elements are tagged with an absolute
+// deadline (their "rank") and kept in one of S unordered slots, selected by
+// deadline % S. Insertion and removal are O(1), no matter how many elements
+// are armed, while expiration only scans the slots of the ticks that went by
+// (and, in each, skips the elements due in later turns of the wheel).
+// Deadlines are compared as differences, so they may wrap around.
+// Example (S = 4): insert(A,5);insert(B,6);insert(C,9)
+// slot:   0     1       2     3
+//             A(5)    B(6)
+//             C(9)
+
+#ifndef __wheel_h
+#define __wheel_h
+
+#include "list.h"
+
+__BEGIN_UTIL
+
+template<typename T,
+          typename R = List_Element_Rank,
+          typename El = List_Elements::Doubly_Linked_Ordered<T, R>,
+          unsigned int S = 64>
+class Timing_Wheel
+{
+private:
+    typedef List<T, El> Slot;
+
+public:
+    typedef T Object_Type;
+    typedef R Rank_Type;
+    typedef El Element;
+
+public:
+    Timing_Wheel(): _size(0), _now(0) {}
+
+    bool empty() const { return (_size == 0); }
+    unsigned int size() const { return _size; }
+
+    // "deadline" must not be earlier than the last "now" given to expire()
+    void insert(Element * e, R deadline) {
+        db<Lists>(TRC) << "Timing_Wheel::insert(e=" << e << ",d=" << deadline << ")" << endl;
+
+        e->rank(deadline);
+        _slot[slot(deadline)].insert(e);
+        _size++;
+    }
+
+    // Elements that are not in the wheel (never inserted, already expired or removed) are ignored
+    Element * remove(Element * e) {
+        db<Lists>(TRC) << "Timing_Wheel::remove(e=" << e << ")" << endl;
+
+        Slot & s = _slot[slot(e->rank())];
+        if(!e->prev() && !e->next() && (s.head() != e))
+            return 0;
+
+        s.remove(e);
+        e->prev(0);
+        e->next(0);
+        _size--;
+
+        return e;
+    }
+
+    // The earliest deadline in [deadline, deadline + slack] some element already has, or "deadline" if none (O(slack))
+    R coalesce(R deadline, R slack) {
+        for(R d = deadline; (R(d - deadline) <= slack) && (R(d - deadline) < R(S)); d++)
+            for(Element * e = _slot[slot(d)].head(); e; e = e->next())
+                if(R(e->rank()) == d)
+                    return d;
+        return deadline;
+    }
+
+    // Removes and returns one element due by "now" (0 if none), advancing the wheel up to it
+    // Several elements due at once are returned by successive calls with the same "now"
+    Element * expire(R now) {
+        if(R(now - _now) >= R(S)) // one full turn covers all slots
+            _now = now - S + 1;
+
+        for(;;) {
+            for(Element * e = _slot[slot(_now)].head(); e; e = e->next())
+                if(R(e->rank() - now) <= 0)
+                    return remove(e);
+            if(_now == now)
+                return 0;
+            _now++;
+        }
+    }
+
+    // The earliest deadline (linear in the number of elements, meant for programming one-shot timers)
+    Element * head() {
+        Element * h = 0;
+        for(unsigned int i = 0; i < S; i++)
+            for(Element * e = _slot[i].head(); e; e = e->next())
+                if(!h || (R(e->rank() - h->rank()) < 0))
+                    h = e;
+        return h;
+    }
+
+private:
+    static unsigned int slot(const R & r) { return static_cast<unsigned long>(r) % S; }
+
+private:
+    unsigned int _size;
+    R _now;
+    Slot _slot[S];
+};
+
+__END_UTIL
+
+#endif
@@ -3,15 +3,23 @@
 #include <memory.h>
 __BEGIN_SYS
 
+// Class attributes
+unsigned int Address_Space::_next_color;
+
 // Methods
-Address_Space::Address_Space(MMU::Page_Directory * pd) : MMU::Directory(pd)
+Address_Space::Address_Space(MMU::Page_Directory * pd) : MMU::Directory(pd), _color(WHITE)
 {
     db<Address_Space> (TRC) << "Address_Space(pd=" << pd << ") [Directory::pd=" << Directory::pd() << "] => " << this << endl;
 }
 
-Address_Space::Address_Space()
+Address_Space::Address_Space() : _color(next_color())
+{
+    db<Address_Space> (TRC) << "Address_Space() [Directory::pd=" << Directory::pd() << ",color=" << _color << "] => " << this << endl;
+}
+
+Address_Space::Address_Space(Color color) : _color(color)
 {
-    db<Address_Space> (TRC) << "Address_Space() [Directory::pd=" << Directory::pd() << "] => " << this << endl;
+    db<Address_Space> (TRC) << "Address_Space(color=" << color << ") [Directory::pd=" << Directory::pd() << "] => " << this << endl;
 }
 
 Address_Space::~Address_Space()
@@ -19,6 +27,13 @@ Address_Space::~Address_Space()
     db<Address_Space>(TRC) << "~Address_Space(this=" << this << ") [Directory::pd=" << Directory::pd() << "]" << endl;
 }
 
+void Address_Space::activate()
+{
+    db<Address_Space>(TRC) << "Address_Space::activate(this=" << this << ") [Directory::pd=" << Directory::pd() << "]" << endl;
+
+    Directory::activate();
+}
+
 Address_Space::Log_Addr Address_Space::attach(Segment * seg)
 {
     Log_Addr tmp = Directory::attach(*seg);
@@ -56,4 +71,12 @@ Address_Space::Phy_Addr Address_Space::physical(Log_Addr address)
     return Directory::physical(address);
 }
 
+Color Address_Space::next_color()
+{
+    if(!COLORS)
+        return WHITE;
+
+    return static_cast<Color>(COLOR_1 + CPU::finc(_next_color) % (COLORS ? COLORS : 1));
+}
+
 __END_SYS
@@ -0,0 +1,193 @@
+// EPOS Asynchronous I/O Implementation
+
+#include <aio.h>
+
+__BEGIN_SYS
+
+// Methods
+unsigned int AIO_Queue::wait(AIO_Request ** requests, unsigned int max, unsigned int min, const Microsecond & timeout)
+{
+    db<AIO>(TRC) << "AIO_Queue::wait(this=" << this << ",max=" << max << ",min=" << min << ",tmt=" << timeout << ")"
+                 << endl;
+
+    // Each unit of the semaphore is a completion on the list, so each one taken is one to reap
+    unsigned int n = 0;
+    for(; (n < min) && (n < max); n++) {
+        if(timeout) {
+            if(!_completions.p(timeout))
+                break;
+        } else
+            _completions.p();
+        requests[n] = reap();
+    }
+
+    return n + poll(&requests[n], max - n);
+}
+
+
+unsigned int AIO_Queue::poll(AIO_Request ** requests, unsigned int max)
+{
+    unsigned int n = 0;
+    for(; (n < max) && _completions.try_p(); n++)
+        requests[n] = reap();
+
+    return n;
+}
+
+
+// Called with interrupts disabled
+void AIO_Queue::post(AIO_Request * r)
+{
+    _completed.insert(&r->_link);
+    _in_flight--;
+    _completions.v();
+    notify();
+}
+
+
+AIO_Request * AIO_Queue::reap()
+{
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+
+    AIO_Request * r = _completed.remove()->object();
+
+    if(!disabled)
+        CPU::int_enable();
+
+    return r;
+}
+
+
+void AIO_Device::submit(AIO_Request * r, AIO_Queue * q)
+{
+    db<AIO>(TRC) << "AIO_Device::submit(this=" << this << ",r=" << r << ",op=" << r->_operation << ",size=" << r->_size
+                 << ",q=" << q << ")" << endl;
+
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+
+    r->_device = this;
+    r->_queue = q;
+    r->_result = 0;
+    r->_status = AIO_Request::QUEUED;
+    q->submitted();
+
+    _queued.insert(&r->_link);
+    if(!_current)
+        next();
+
+    if(!disabled)
+        CPU::int_enable();
+}
+
+
+bool AIO_Device::cancel(AIO_Request * r)
+{
+    db<AIO>(TRC) << "AIO_Device::cancel(this=" << this << ",r=" << r << ")" << endl;
+
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+
+    bool canceled = false;
+    if(r->_device == this) {
+        if(r->_status == AIO_Request::QUEUED) {
+            _queued.remove(&r->_link);
+            finish(r, AIO_Request::CANCELED, 0);
+            canceled = true;
+        } else if((r == _current) && abort(r)) {
+            _current = 0;
+            finish(r, AIO_Request::CANCELED, 0);
+            next();
+            canceled = true;
+        }
+    }
+
+    if(!disabled)
+        CPU::int_enable();
+
+    return canceled;
+}
+
+
+void AIO_Device::complete(AIO_Request * r, int result)
+{
+    db<AIO>(TRC) << "AIO_Device::complete(this=" << this << ",r=" << r << ",res=" << result << ")" << endl;
+
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+
+    // A request canceled meanwhile has already been posted
+    if(r == _current) {
+        _current = 0;
+        finish(r, (result < 0) ? AIO_Request::FAILED : AIO_Request::DONE, result);
+        next();
+    }
+
+    if(!disabled)
+        CPU::int_enable();
+}
+
+
+// The methods below are called with interrupts disabled
+void AIO_Device::finish(AIO_Request * r, const AIO_Request::Status & status, int result)
+{
+    r->_result = result;
+    r->_status = status;
+    r->_device = 0;
+    r->_queue->post(r);
+}
+
+
+void AIO_Device::next()
+{
+    if(_queued.empty())
+        return;
+
+    _current = _queued.remove()->object();
+    _current->_status = AIO_Request::RUNNING;
+    start(_current);
+}
+
+
+AIO_Worker::AIO_Worker(int priority, unsigned int stack_size): _finish(false), _pending(0)
+{
+    db<AIO>(TRC) << "AIO_Worker(p=" << priority << ") => " << this << endl;
+
+    _thread = new (SYSTEM) Thread(Thread::Configuration(Thread::READY, Thread::Criterion(priority), stack_size), &loop,
+                                  this);
+}
+
+
+AIO_Worker::~AIO_Worker()
+{
+    db<AIO>(TRC) << "~AIO_Worker(this=" << this << ")" << endl;
+
+    // Requests still queued are not serviced anymore
+    _finish = true;
+    _pending.v();
+    _thread->join();
+    delete _thread;
+}
+
+
+int AIO_Worker::loop(AIO_Worker * w)
+{
+    for(;;) {
+        w->_pending.p();
+        if(w->_finish)
+            break;
+
+        AIO_Request * r = w->current();
+        if(r)
+            w->complete(r, w->service(r));
+    }
+
+    return 0;
+}
+
+__END_SYS
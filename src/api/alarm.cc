@@ -4,93 +4,217 @@
 #include <synchronizer.h>
 #include <time.h>
 #include <process.h>
+#include <utility/trace.h>
+#include <utility/log.h>
+#include <utility/profiler.h>
 
 __BEGIN_SYS
 
 Alarm_Timer * Alarm::_timer;
 volatile Alarm::Tick Alarm::_elapsed;
-Alarm::Queue Alarm::_request;
+Alarm::Time_Stamp Alarm::_now;
+volatile Alarm::Time_Stamp Alarm::_latency;
+Alarm::Queue Alarm::_request[QUEUES];
+Alarm::Wheel Alarm::_wheel[QUEUES];
+Alarm::Fired Alarm::_fired[QUEUES];
+Thread::Kernel_Lock Alarm::_lock[QUEUES];
 
-Alarm::Alarm(const Microsecond & time, Handler * handler, unsigned int times)
-: _time(time), _handler(handler), _times(times), _ticks(ticks(time)), _link(this, _ticks)
+Alarm::Alarm(const Microsecond & time, const Delegate & handler, unsigned int times, const Microsecond & slack)
+: _time(time), _handler(handler), _times(times), _ticks(units(time)), _slack(units(slack)), _late(0), _link(this, _ticks), _fired_link(this),
+  _queue(queue())
 {
-    lock();
+    // Timed waits create alarms from within critical sections (see Thread::sleep(q, timeout))
+    bool masked = CPU::int_disabled();
+    if(masked) {
+        if(Thread::smp)
+            _lock[_queue].acquire();
+    } else
+        lock(_queue);
 
-    db<Alarm>(TRC) << "Alarm(t=" << time << ",tk=" << _ticks << ",h=" << reinterpret_cast<void *>(handler) << ",x=" << times << ") => " << this << endl;
+    db<Alarm>(TRC) << "Alarm(t=" << time << ",tk=" << _ticks << ",h=" << handler.context() << ",x=" << times << ") => " << this << endl;
 
-    if(_ticks) {
-        _request.insert(&_link);
-        unlock();
-    } else {
+    if(_ticks)
+        arm();
+    else
         assert(times == 1);
-        unlock();
-        (*handler)();
-    }
+
+    if(masked) {
+        if(Thread::smp)
+            _lock[_queue].release();
+    } else
+        unlock(_queue);
+
+    if(!_ticks)
+        handler();
 }
 
 Alarm::~Alarm()
 {
-    lock();
+    bool masked = CPU::int_disabled();
+    if(masked) {
+        if(Thread::smp)
+            _lock[_queue].acquire();
+    } else
+        lock(_queue);
 
     db<Alarm>(TRC) << "~Alarm(this=" << this << ")" << endl;
 
-    _request.remove(this);
+    disarm();
+    _fired[_queue].remove(this); // expired, but its handler hasn't been called yet
 
-    unlock();
+    if(masked) {
+        if(Thread::smp)
+            _lock[_queue].release();
+    } else
+        unlock(_queue);
 }
 
 void Alarm::reset()
 {
-    bool locked = Thread::locked();
-    if(!locked)
-        lock();
+    // reset() and period() might be called from within critical sections (e.g. with the scheduler locked),
+    // in which case interrupts must stay masked on return
+    bool masked = CPU::int_disabled();
+    if(masked) {
+        if(Thread::smp)
+            _lock[_queue].acquire();
+    } else
+        lock(_queue);
 
     db<Alarm>(TRC) << "Alarm::reset(this=" << this << ")" << endl;
 
-    _request.remove(this);
-    _link.rank(_ticks);
-    _request.insert(&_link);
+    disarm();
+    arm();
 
-    if(!locked)
-        unlock();
+    if(masked) {
+        if(Thread::smp)
+            _lock[_queue].release();
+    } else
+        unlock(_queue);
 }
 
 void Alarm::period(const Microsecond & p)
 {
-    bool locked = Thread::locked();
-    if(!locked)
-        lock();
+    bool masked = CPU::int_disabled();
+    if(masked) {
+        if(Thread::smp)
+            _lock[_queue].acquire();
+    } else
+        lock(_queue);
 
     db<Alarm>(TRC) << "Alarm::period(this=" << this << ",p=" << p << ")" << endl;
 
-    _request.remove(this);
+    disarm();
     _time = p;
-    _ticks = ticks(p);
-    _request.insert(&_link);
+    _ticks = units(p);
+    arm();
+
+    if(masked) {
+        if(Thread::smp)
+            _lock[_queue].release();
+    } else
+        unlock(_queue);
+}
+
+// arm() and disarm() must be called with the lock held
+// The alarm is set to expire "ticks" units after "base" (only used in one-shot mode, the current tick otherwise), or
+// at the first expiration already queued for up to _slack units later, so both get served by the same interrupt
+void Alarm::arm(const Units & ticks, const Time_Stamp & base)
+{
+    _late = 0;
+
+    if(wheel) {
+        Tick deadline = _elapsed + ticks;
+        if(_slack)
+            _late = _wheel[_queue].coalesce(deadline, _slack) - deadline;
+        _wheel[_queue].insert(&_link, deadline + _late);
+    } else if(one_shot) {
+        Time_Stamp deadline = base + ticks;
+        for(Queue::Element * e = _request[_queue].head(); _slack && e; e = e->next())
+            if(Time_Stamp(e->rank()) >= deadline) {
+                if(Time_Stamp(e->rank()) - deadline <= Time_Stamp(_slack))
+                    _late = e->rank() - deadline;
+                break;
+            }
+        _link.rank(deadline + _late);
+        _request[_queue].insert(&_link);
+        if(_request[_queue].head() == &_link)
+            Alarm_Timer::one_shot(_link.rank(), &expire);
+    } else {
+        Units deadline = 0;
+        for(Queue::Element * e = _request[_queue].head(); _slack && e; e = e->next()) {
+            deadline += e->rank();
+            if(deadline >= ticks) {
+                if(deadline - ticks <= _slack)
+                    _late = deadline - ticks;
+                break;
+            }
+        }
+        _link.rank(ticks + _late);
+        _request[_queue].insert(&_link);
+    }
+}
 
-    if(!locked)
-        unlock();
+void Alarm::disarm()
+{
+    // A one-shot programmed for this alarm is left alone and will find nothing (else) due
+    if(wheel)
+        _wheel[_queue].remove(&_link);
+    else
+        _request[_queue].remove(this);
 }
 
 
+// Sleeps until "margin" before the end and spins the rest, so short delays (e.g. of drivers) need no context switch and
+// long ones are neither cut by the rounding to ticks nor stretched by the wake-up latency. The margin is a tick
+// period or, in one-shot mode, the average latency of the previous wake-ups.
 void Alarm::delay(const Microsecond & time)
 {
     db<Alarm>(TRC) << "Alarm::delay(time=" << time << ")" << endl;
 
-    Semaphore semaphore(0);
-    Semaphore_Handler handler(&semaphore);
-    Alarm alarm(time, &handler, 1); // if time < tick trigger v()
-    semaphore.p();
+    if(!Traits<TSC>::enabled) {
+        Semaphore semaphore(0);
+        Alarm alarm(time, Delegate::bind<Semaphore, &Semaphore::v>(&semaphore), 1); // if time < tick trigger v()
+        semaphore.p();
+        return;
+    }
+
+    Time_Stamp start = now();
+    Time_Stamp length = Time_Stamp(time) * TSC::frequency() / 1000000;
+    Time_Stamp margin = one_shot ? _latency : Time_Stamp(timer_period()) * TSC::frequency() / 1000000;
+
+    if(length > margin) {
+        Time_Stamp wakeup = start + length - margin;
+        Semaphore semaphore(0);
+        Alarm alarm((length - margin) * 1000000 / TSC::frequency(), Delegate::bind<Semaphore, &Semaphore::v>(&semaphore), 1);
+        semaphore.p();
+
+        Time_Stamp late = now() - wakeup;
+        if(one_shot && (late < length))
+            _latency = (_latency * 7 + late) / 8;
+    }
+
+    while(now() - start < length);
 }
 
 
 void Alarm::handler(IC::Interrupt_Id i)
 {
-    lock();
+    unsigned int q = queue();
+    Queue & request = _request[q];
+    Fired & fired = _fired[q];
+
+    lock(q);
+
+    Profiler::sample(CPU::int_pc(), Thread::self());
+
+    // After a tickless sleep, a single interrupt stands for all the periods that went by
+    Tick ticks = tickless ? 1 + Alarm_Timer::skipped() : 1;
 
-    _elapsed++;
+    // With local alarms, the other CPUs only serve their own queues
+    if(q == 0)
+        _elapsed += ticks;
 
-    if(Traits<Alarm>::visible) {
+    if(Traits<Alarm>::visible && (q == 0)) {
         Display display;
         int lin, col;
         display.position(&lin, &col);
@@ -99,29 +223,118 @@ void Alarm::handler(IC::Interrupt_Id i)
         display.position(lin, col);
     }
 
-    Alarm * alarm = 0;
-
-    if(!_request.empty()) {
-        // Replacing the following "if" by a "while" loop is tempting, but recovering the lock and dispatching the handler is
-        // troublesome if the Alarm gets destroyed in between, like is the case for the idle thread returning to shutdown the machine
-        if(_request.head()->promote() <= 0) { // rank can be negative whenever multiple handlers get created for the same time tick
-            Queue::Element * e = _request.remove();
-            alarm = e->object();
+    // Every alarm due by now is moved to _fired, and periodic ones are rearmed, all under the lock
+    if(one_shot)
+        now(); // alarms are handled by expire(), but TSC readings must still be extended
+    else if(wheel) {
+        // Only the slots of the ticks that went by are scanned
+        for(Queue::Element * e; (e = _wheel[q].expire(_elapsed)); ) {
+            Alarm * alarm = e->object();
             if(alarm->_times != INFINITE)
                 alarm->_times--;
-            if(alarm->_times > 0) {
-                e->rank(alarm->_ticks);
-                _request.insert(e);
-            }
+            if(alarm->_times > 0)
+                alarm->rearm();
+            if(!fired.search(alarm)) // a handler running late might have let its alarm expire again
+                fired.insert(&alarm->_fired_link);
+        }
+    } else if(!request.empty()) {
+        request.head()->promote(ticks);
+        // rank can be negative whenever multiple handlers get created for the same time tick or ticks were skipped,
+        // and removing the head adds its rank to the next one's, so each of them gets its share of the elapsed time
+        while(!request.empty() && (request.head()->rank() <= 0)) {
+            Queue::Element * e = request.remove();
+            Alarm * alarm = e->object();
+            if(alarm->_times != INFINITE)
+                alarm->_times--;
+            if(alarm->_times > 0)
+                alarm->rearm();
+            if(!fired.search(alarm))
+                fired.insert(&alarm->_fired_link);
         }
     }
 
-    unlock();
+    dispatch(q);
+}
+
+void Alarm::expire(IC::Interrupt_Id i)
+{
+    // Called by the Alarm_Timer in one-shot mode, when the head alarm's deadline is reached (one-shots are never local)
+    Queue & request = _request[0];
+    Fired & fired = _fired[0];
+
+    lock(0);
+
+    Time_Stamp ts = now();
 
-    if(alarm) {
-        db<Alarm>(TRC) << "Alarm::handler(this=" << alarm << ",e=" << _elapsed << ",h=" << reinterpret_cast<void*>(alarm->handler) << ")" << endl;
-        (*alarm->_handler)();
+    while(!request.empty() && (Time_Stamp(request.head()->rank()) <= ts)) {
+        Queue::Element * e = request.remove();
+        Alarm * alarm = e->object();
+        if(alarm->_times != INFINITE)
+            alarm->_times--;
+        if(alarm->_times > 0) {
+            // The next deadline is taken from the previous (nominal) one, so releases don't drift, unless it has already gone by
+            Time_Stamp base = e->rank() - alarm->_late;
+            alarm->arm(alarm->_ticks, (base + alarm->_ticks > ts) ? base : ts);
+        }
+        if(!fired.search(alarm))
+            fired.insert(&alarm->_fired_link);
     }
+
+    if(!request.empty())
+        Alarm_Timer::one_shot(request.head()->rank(), &expire);
+
+    dispatch(0);
+}
+
+void Alarm::dispatch(unsigned int q)
+{
+    // Called with the lock of queue "q" held, which is released on return. Handlers are called one at a time with the lock released.
+    // Each alarm is taken out of _fired under the lock, so one destroyed meanwhile (by a previous handler or by the thread
+    // it woke up, like is the case for the idle thread returning to shutdown the machine) has already left the list and
+    // is never touched
+    for(;;) {
+        Fired::Element * e = _fired[q].remove();
+        if(!e)
+            break;
+
+        Alarm * alarm = e->object();
+        Delegate handler = alarm->_handler;
+        Trace::record(Trace::ALARM, alarm, handler.context(), alarm->_times);
+        Log::log("Alarm::handler(a=%p,h=%p,times=%d)", alarm, handler.context(), alarm->_times);
+
+        unlock(q);
+
+        db<Alarm>(TRC) << "Alarm::handler(this=" << alarm << ",e=" << _elapsed << ",h=" << handler.context() << ")" << endl;
+        handler();
+
+        lock(q);
+    }
+
+    unlock(q);
+}
+
+void Alarm::sleep()
+{
+    // Called by the idle thread with interrupts disabled: program the timer to the head alarm's deadline
+    assert(CPU::int_disabled());
+
+    // Tickless idle is never multicore, so there is a single queue
+    if(Thread::smp)
+        _lock[0].acquire();
+
+    Tick ticks;
+    if(wheel) {
+        Queue::Element * e = _wheel[0].head();
+        ticks = e ? e->rank() - _elapsed : Tick(~0UL >> 1);
+    } else
+        ticks = _request[0].empty() ? Tick(~0UL >> 1) : _request[0].head()->rank(); // with no alarms, sleep as long as the timer allows
+
+    db<Alarm>(TRC) << "Alarm::sleep(tk=" << ticks << ")" << endl;
+
+    Alarm_Timer::sleep(ticks);
+
+    if(Thread::smp)
+        _lock[0].release();
 }
 
 __END_SYS
@@ -9,7 +9,10 @@ void Alarm::init()
 {
     db<Init, Alarm>(TRC) << "Alarm::init()" << endl;
 
-    _timer = new (SYSTEM) Alarm_Timer(handler);
+    // now() extends TSC readings from here on, so one-shot deadlines are in the timer's own TSC counts
+    _now = TSC::time_stamp();
+
+    _timer = new (SYSTEM) Alarm_Timer(handler, local);
 }
 
 __END_SYS
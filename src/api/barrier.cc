@@ -0,0 +1,38 @@
+// EPOS Barrier Implementation
+
+#include <synchronizer.h>
+
+__BEGIN_SYS
+
+Barrier::Barrier(unsigned int parties): _parties(parties), _arrived(0)
+{
+    db<Synchronizer>(TRC) << "Barrier(parties=" << parties << ") => " << this << endl;
+}
+
+
+Barrier::~Barrier()
+{
+    db<Synchronizer>(TRC) << "~Barrier(this=" << this << ")" << endl;
+}
+
+
+bool Barrier::wait()
+{
+    db<Synchronizer>(TRC) << "Barrier::wait(this=" << this << ",arrived=" << _arrived << ")" << endl;
+
+    bool last = false;
+
+    begin_atomic();
+    if(++_arrived < _parties)
+        sleep();
+    else {
+        _arrived = 0;
+        last = true;
+        wakeup_all();
+    }
+    end_atomic();
+
+    return last;
+}
+
+__END_SYS
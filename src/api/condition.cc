@@ -9,8 +9,8 @@ __BEGIN_SYS
 
 // Methods
 
-Condition::Condition() {
-    db<Synchronizer>(TRC) << "Condition() => " << this << endl;
+Condition::Condition(Mutex * mutex): _mutex(mutex) {
+    db<Synchronizer>(TRC) << "Condition(mutex=" << mutex << ") => " << this << endl;
 }
 
 
@@ -23,16 +23,41 @@ void Condition::wait() {
     db<Synchronizer>(TRC) << "Condition::wait(this=" << this << ")" << endl;
 
     begin_atomic();
-    sleep();
+    if(_mutex)
+        release();
+    sleep(); // with a Mutex, we return owning it (see morph())
+    if(_mutex)
+        _mutex->own();
     end_atomic();
 }
 
 
+bool Condition::wait(const Microsecond & timeout) {
+    db<Synchronizer>(TRC) << "Condition::wait(this=" << this << ",t=" << timeout << ")" << endl;
+
+    begin_atomic();
+    if(_mutex)
+        release();
+    bool signaled = sleep(timeout);
+    if(signaled && _mutex)
+        _mutex->own();
+    end_atomic();
+
+    if(!signaled && _mutex) // timed out on our own queue, so we still need to get the Mutex back
+        _mutex->lock();
+
+    return signaled;
+}
+
+
 void Condition::signal() {
     db<Synchronizer>(TRC) << "Condition::signal(this=" << this << ")" << endl;
 
     begin_atomic();
-    wakeup();
+    if(_mutex)
+        morph(false);
+    else
+        wakeup();
     end_atomic();
 }
 
@@ -41,10 +66,53 @@ void Condition::broadcast() {
     db<Synchronizer>(TRC) << "Condition::broadcast(this=" << this << ")" << endl;
 
     begin_atomic();
-    wakeup_all();
+    if(_mutex)
+        morph(true);
+    else
+        wakeup_all();
     end_atomic();
 }
 
+
+// Atomic with the subsequent sleep(): as Mutex::unlock(), but the next owner only becomes READY when we actually sleep
+void Condition::release()
+{
+    if(Mutex::adaptive)
+        _mutex->_owner = 0;
+
+    if(_mutex->_queue.empty())
+        _mutex->_state = Mutex::FREE;
+    else
+        requeue(&_mutex->_queue, 0);
+}
+
+
+void Condition::morph(bool all)
+{
+    bool handed = false;
+
+    while(!_queue.empty()) {
+        // The signaling thread usually owns the Mutex, in which case waiters just queue on it and unlock() takes the slow path.
+        // If nobody does (e.g. when signaled from an ISR through Condition_Handler), the first waiter gets it right away
+        int state;
+        do
+            state = _mutex->_state;
+        while(cas(_mutex->_state, state, (state == Mutex::FREE) ? int(Mutex::LOCKED) : int(Mutex::CONTENDED)) != state);
+
+        if(state == Mutex::FREE) {
+            requeue(&_queue, 0);
+            handed = true;
+        } else
+            requeue(&_queue, &_mutex->_queue);
+
+        if(!all)
+            break;
+    }
+
+    if(handed)
+        reschedule(); // a waiter got the Mutex and might outrank us
+}
+
 // This is an alternative implementation, which does impose ordering
 // on threads waiting at "wait". Nontheless, it's still susceptible to counter
 // overflow
@@ -0,0 +1,86 @@
+// EPOS Energy Meter Implementation
+
+#include <energy.h>
+
+__BEGIN_SYS
+
+// Class attributes
+Energy_Meter::State Energy_Meter::_state[Energy_Meter::CPUS];
+Energy_Meter::Time_Stamp Energy_Meter::_since[Energy_Meter::CPUS];
+volatile Energy_Meter::Energy Energy_Meter::_slept[Energy_Meter::CPUS][Energy_Meter::STATES];
+volatile Energy_Meter::Energy Energy_Meter::_total[Energy_Meter::CPUS];
+volatile unsigned long Energy_Meter::_peripherals;
+bool Energy_Meter::_on[Energy_Meter::PERIPHERALS ? Energy_Meter::PERIPHERALS : 1];
+
+// Class methods
+unsigned long Energy_Meter::power(const State & state)
+{
+    if(state != RUNNING)
+        return Traits<Energy_Meter>::sleep(state);
+
+    return Traits<Energy_Meter>::STATIC
+        + static_cast<unsigned long long>(Traits<Energy_Meter>::DYNAMIC) * CPU::clock() / CPU::max_clock();
+}
+
+Energy_Meter::Energy Energy_Meter::slept(const State & s)
+{
+    Energy e = 0;
+    if((s > RUNNING) && (s < STATES))
+        for(unsigned int cpu = 0; cpu < CPUS; cpu++)
+            e += _slept[cpu][s];
+    return e;
+}
+
+Energy_Meter::Energy Energy_Meter::total()
+{
+    Energy e = 0;
+    for(unsigned int cpu = 0; cpu < CPUS; cpu++)
+        e += _total[cpu];
+    return e;
+}
+
+void Energy_Meter::charge(Energy * account, const State & next)
+{
+    unsigned int cpu = (CPUS > 1) ? CPU::id() : 0;
+    Time_Stamp ts = TSC::time_stamp();
+    State state = _state[cpu];
+
+    // uW times ms is nJ, and long sleeps at 1 GHz still fit in 64 bits
+    unsigned long p = power(state) + ((cpu == 0) ? _peripherals : 0);
+    Energy e = static_cast<Energy>(p) * (ts - _since[cpu]) / (TSC::frequency() / 1000);
+
+    if(state != RUNNING)
+        _slept[cpu][state] += e;
+    else if(account)
+        *account += e;
+    _total[cpu] += e;
+
+    _since[cpu] = ts;
+    _state[cpu] = next;
+}
+
+void Energy_Meter::turn(unsigned int peripheral, bool on)
+{
+    db<Energy_Meter>(TRC) << "Energy_Meter::" << (on ? "on" : "off") << "(p=" << peripheral << ")" << endl;
+
+    if(!enabled || (peripheral >= PERIPHERALS))
+        return;
+
+    // CPU 0 charges its current period, started before the change, at the new power: a model's error, not a leak
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+
+    if(_on[peripheral] != on) {
+        _on[peripheral] = on;
+        if(on)
+            _peripherals += Traits<Energy_Meter>::peripheral(peripheral);
+        else
+            _peripherals -= Traits<Energy_Meter>::peripheral(peripheral);
+    }
+
+    if(!disabled)
+        CPU::int_enable();
+}
+
+__END_SYS
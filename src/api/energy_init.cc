@@ -0,0 +1,19 @@
+// EPOS Energy Meter Initialization
+
+#include <energy.h>
+
+__BEGIN_SYS
+
+void Energy_Meter::init()
+{
+    db<Init, Energy_Meter>(TRC) << "Energy_Meter::init(s=" << Traits<Energy_Meter>::STATIC << ",d="
+                                << Traits<Energy_Meter>::DYNAMIC << ")" << endl;
+
+    Time_Stamp ts = TSC::time_stamp();
+    for(unsigned int cpu = 0; cpu < CPUS; cpu++) {
+        _state[cpu] = RUNNING;
+        _since[cpu] = ts;
+    }
+}
+
+__END_SYS
@@ -0,0 +1,114 @@
+// EPOS Event Flags Implementation
+
+#include <synchronizer.h>
+
+__BEGIN_SYS
+
+Event_Flags::Event_Flags(Mask flags): _flags(flags)
+{
+    db<Synchronizer>(TRC) << "Event_Flags(flags=" << hex << flags << dec << ") => " << this << endl;
+}
+
+
+Event_Flags::~Event_Flags()
+{
+    db<Synchronizer>(TRC) << "~Event_Flags(this=" << this << ")" << endl;
+
+    begin_atomic();
+    while(!_waiters.empty())
+        requeue(&_waiters.remove()->object()->queue, 0); // they return 0
+    reschedule();
+    end_atomic();
+}
+
+
+Event_Flags::Mask Event_Flags::wait(Mask mask, Mode mode, bool consume)
+{
+    db<Synchronizer>(TRC) << "Event_Flags::wait(this=" << this << ",mask=" << hex << mask << ",flags=" << _flags << dec << ",mode=" << mode << ")" << endl;
+
+    Waiter w(mask, mode, consume);
+
+    begin_atomic();
+    if(!take(&w)) {
+        _waiters.insert(&w.link);
+        sleep(&w.queue); // set() fills in w.got
+    }
+    end_atomic();
+
+    return w.got;
+}
+
+
+Event_Flags::Mask Event_Flags::wait(Mask mask, const Microsecond & timeout, Mode mode, bool consume)
+{
+    db<Synchronizer>(TRC) << "Event_Flags::wait(this=" << this << ",mask=" << hex << mask << ",flags=" << _flags << dec << ",mode=" << mode << ",t=" << timeout << ")" << endl;
+
+    Waiter w(mask, mode, consume);
+
+    begin_atomic();
+    if(!take(&w)) {
+        _waiters.insert(&w.link);
+        if(!sleep(&w.queue, timeout) && !w.got) // unless set() took us after the timeout made us READY
+            _waiters.remove(&w.link);
+    }
+    end_atomic();
+
+    return w.got;
+}
+
+
+void Event_Flags::set(Mask mask)
+{
+    db<Synchronizer>(TRC) << "Event_Flags::set(this=" << this << ",mask=" << hex << mask << ",flags=" << _flags << dec << ")" << endl;
+
+    begin_atomic();
+    _flags |= mask;
+
+    // All waiters see the same flags, which are only consumed once every one of them was checked
+    Mask flags = _flags;
+    Mask consumed = 0;
+    bool woken = false;
+    for(List::Element * e = _waiters.head(), * next; e; e = next) {
+        next = e->next();
+        Waiter * w = e->object();
+        if(w->satisfied(flags)) {
+            w->got = flags & w->mask;
+            if(w->consume)
+                consumed |= w->got;
+            _waiters.remove(e);
+            requeue(&w->queue, 0); // READY, but without rescheduling yet
+            woken = true;
+        }
+    }
+    _flags &= ~consumed;
+
+    if(woken)
+        reschedule();
+    end_atomic();
+}
+
+
+void Event_Flags::clear(Mask mask)
+{
+    db<Synchronizer>(TRC) << "Event_Flags::clear(this=" << this << ",mask=" << hex << mask << ",flags=" << _flags << dec << ")" << endl;
+
+    begin_atomic();
+    _flags &= ~mask;
+    end_atomic();
+}
+
+
+// Satisfies "w" right away if the flags allow it (locking handled by caller)
+bool Event_Flags::take(Waiter * w)
+{
+    if(!w->satisfied(_flags))
+        return false;
+
+    w->got = _flags & w->mask;
+    if(w->consume)
+        _flags &= ~w->got;
+
+    return true;
+}
+
+__END_SYS
@@ -0,0 +1,69 @@
+// EPOS DVFS Governor Implementation
+
+#include <governor.h>
+
+__BEGIN_SYS
+
+// Class attributes
+volatile bool Governor::_idling[Governor::CPUS];
+volatile Governor::Time_Stamp Governor::_since[Governor::CPUS];
+volatile Governor::Time_Stamp Governor::_idle_time[Governor::CPUS];
+Governor::Time_Stamp Governor::_last_idle_time[Governor::CPUS];
+Governor::Time_Stamp Governor::_last;
+unsigned int Governor::_utilization[Governor::CPUS];
+Energy_Meter::Energy Governor::_last_energy;
+unsigned long Governor::_power;
+Alarm * Governor::_alarm;
+
+// Class methods
+// Called by the alarm on CPU 0, reading the other CPUs' accounting on the fly, which is good enough for a heuristic
+void Governor::govern()
+{
+    Time_Stamp now = TSC::time_stamp();
+    Time_Stamp elapsed = now - _last;
+    _last = now;
+    if(!elapsed)
+        return;
+
+    unsigned int busiest = 0;
+    for(unsigned int cpu = 0; cpu < CPU::cores(); cpu++) {
+        // The idle thread may still be running, so charge it up to now
+        Time_Stamp since = _since[cpu];
+        Time_Stamp idle = _idle_time[cpu] + ((_idling[cpu] && (now > since)) ? now - since : 0);
+        Time_Stamp idled = idle - _last_idle_time[cpu];
+        _last_idle_time[cpu] = idle;
+
+        _utilization[cpu] = (idled < elapsed) ? 100 - idled * 100 / elapsed : 0;
+        if(_utilization[cpu] > busiest)
+            busiest = _utilization[cpu];
+    }
+
+    // nJ per tick times ticks per second is nW, thus uW once divided by 1000
+    if(Energy_Meter::enabled) {
+        Energy_Meter::Energy energy = Energy_Meter::total();
+        _power = (energy - _last_energy) * TSC::frequency() / elapsed / 1000;
+        _last_energy = energy;
+    }
+
+    Hertz clock = CPU::clock();
+    Hertz max = CPU::max_clock();
+    Hertz min = CPU::min_clock();
+    Hertz target;
+    if(busiest >= UP)
+        target = max;
+    else {
+        target = static_cast<unsigned long long>(clock) * busiest / TARGET;
+        if(target > max)
+            target = max;
+        if(target < min)
+            target = min;
+    }
+
+    db<Governor>(TRC) << "Governor::govern(load=" << busiest << "%,power=" << _power << "uW,clock=" << clock
+                      << ",target=" << target << ")" << endl;
+
+    if(target != clock)
+        CPU::clock(target);
+}
+
+__END_SYS
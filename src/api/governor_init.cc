@@ -0,0 +1,20 @@
+// EPOS DVFS Governor Initialization
+
+#include <governor.h>
+#include <system.h>
+
+__BEGIN_SYS
+
+void Governor::init()
+{
+    db<Init, Governor>(TRC) << "Governor::init(p=" << PERIOD << ",up=" << UP << ",target=" << TARGET << ")" << endl;
+
+    _last = TSC::time_stamp();
+    for(unsigned int cpu = 0; cpu < CPUS; cpu++)
+        _last_idle_time[cpu] = _idle_time[cpu];
+    _last_energy = Energy_Meter::total();
+
+    _alarm = new (SYSTEM) Alarm(PERIOD, &govern, INFINITE);
+}
+
+__END_SYS
@@ -0,0 +1,62 @@
+// EPOS Interrupt Thread Implementation
+
+#include <interrupt_thread.h>
+
+__BEGIN_SYS
+
+// Class attributes
+Interrupt_Thread * Interrupt_Thread::_threads[IC::INTS];
+
+// Methods
+Interrupt_Thread::Interrupt_Thread(const Interrupt_Id & id, Handler * bottom_half, Interrupt_Handler ack, int priority, unsigned int stack_size)
+: Thread(Thread::Configuration(SUSPENDED, Criterion(priority), stack_size), &loop, this),
+  _id(id), _bottom_half(bottom_half), _ack(ack), _previous(IC::int_vector(id)), _finish(false), _pending(0)
+{
+    db<Thread>(TRC) << "Interrupt_Thread(int=" << id << ",h=" << bottom_half << ",ack=" << reinterpret_cast<void *>(ack) << ") => " << this << endl;
+
+    _threads[id] = this;
+    IC::int_vector(id, &top_half);
+
+    resume();
+}
+
+
+Interrupt_Thread::~Interrupt_Thread()
+{
+    db<Thread>(TRC) << "~Interrupt_Thread(this=" << this << ",int=" << _id << ")" << endl;
+
+    IC::int_vector(_id, _previous);
+    _threads[_id] = 0;
+
+    // Wake the bottom half up to leave its loop (with the vector restored, interrupts still pending are dropped)
+    _finish = true;
+    _pending.v();
+    join();
+}
+
+
+int Interrupt_Thread::loop(Interrupt_Thread * t)
+{
+    for(;;) {
+        t->_pending.p();
+        if(t->_finish)
+            break;
+        (*t->_bottom_half)();
+    }
+
+    return 0;
+}
+
+
+// Runs in interrupt context
+void Interrupt_Thread::top_half(Interrupt_Id id)
+{
+    Interrupt_Thread * t = _threads[id];
+
+    if(t->_ack)
+        t->_ack(id);
+
+    t->_pending.v();
+}
+
+__END_SYS
@@ -0,0 +1,232 @@
+// EPOS System Monitor Implementation
+
+#include <monitor.h>
+#include <machine/ipi.h>
+
+__BEGIN_SYS
+
+// Class attributes
+volatile unsigned int Monitor::_deadline_misses[Monitor::CPUS];
+unsigned int Monitor::_head[Monitor::CPUS];
+Monitor::Capture Monitor::_ring[Monitor::CPUS][Monitor::SAMPLES];
+Alarm * Monitor::_alarm;
+
+// Class methods
+Clerk<System>::Data Clerk<System>::read()
+{
+    unsigned int cpu = (Traits<Build>::CPUS > 1) ? CPU::id() : 0;
+
+    switch(_event) {
+    case ELAPSED_TIME:
+        return TSC::time_stamp();
+    case DEADLINE_MISSES:
+        return Monitor::_deadline_misses[cpu];
+    case CPU_EXECUTION_TIME:
+        return Statistics::_cpu_time[cpu];
+    case THREAD_EXECUTION_TIME: {
+        // Charged at each dispatch, so the running thread is yet to be charged for the time since its last one
+        const volatile Statistics & s = Thread::self()->statistics();
+        return Thread::Criterion::collecting ? s.thread_execution_time + TSC::time_stamp() - s.last_thread_dispatch : 0;
+    }
+    case RUNNING_THREAD:
+        return reinterpret_cast<unsigned long>(Thread::self());
+    default:
+        return 0;
+    }
+}
+
+// Called with interrupts disabled, by the alarm on CPU 0 and by the IPI on the others, so each ring has a single writer
+void Monitor::capture()
+{
+    if(!enabled)
+        return;
+
+    unsigned int cpu = (CPUS > 1) ? CPU::id() : 0;
+    Capture & c = _ring[cpu][_head[cpu]++ % SAMPLES];
+
+    c.time = Clerk<System>(ELAPSED_TIME).read();
+    c.cpu_time = Clerk<System>(CPU_EXECUTION_TIME).read();
+    c.thread_time = Clerk<System>(THREAD_EXECUTION_TIME).read();
+    c.thread = reinterpret_cast<const void *>(Clerk<System>(RUNNING_THREAD).read());
+    c.deadline_misses = Clerk<System>(DEADLINE_MISSES).read();
+    c.temperature = thermal ? Clerk<Machine>(CPU_TEMPERATURE).read() : 0;
+    for(unsigned int i = 0; i < PMU_CHANNELS; i++)
+        c.pmu[i] = clerk(i).read();
+}
+
+void Monitor::alarm()
+{
+    capture();
+
+    if(Traits<System>::multicore)
+        IPI::broadcast(IPI::MONITOR);
+}
+
+void Monitor::dump()
+{
+    if(!enabled)
+        return;
+
+    OStream cout;
+
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+
+    cout << "# cpu time cpu_time thread thread_time deadline_misses temperature";
+    for(unsigned int i = 0; i < PMU_CHANNELS; i++)
+        cout << " pmu(" << event(i) << ")";
+    cout << endl;
+
+    for(unsigned int cpu = 0; cpu < CPU::cores(); cpu++) {
+        unsigned int head = _head[cpu];
+        unsigned int first = (head > SAMPLES) ? head - SAMPLES : 0;
+
+        for(unsigned int i = first; i < head; i++) {
+            const Capture & c = _ring[cpu][i % SAMPLES];
+            cout << "$ " << cpu << " " << c.time << " " << c.cpu_time << " " << c.thread << " " << c.thread_time
+                 << " " << c.deadline_misses << " " << c.temperature;
+            for(unsigned int j = 0; j < PMU_CHANNELS; j++)
+                cout << " " << c.pmu[j];
+            cout << endl;
+        }
+    }
+
+    if(!disabled)
+        CPU::int_enable();
+}
+
+void Monitor::reset()
+{
+    for(unsigned int cpu = 0; cpu < CPUS; cpu++)
+        _head[cpu] = 0;
+}
+
+PMU_Multiplexer::PMU_Multiplexer(const Event * events, unsigned int n, const Microsecond & slice)
+: _events((n < EVENTS) ? n : EVENTS), _slice(slice), _alarm(0), _running(false), _group(0), _since(0), _total(0),
+  _rotations(0)
+{
+    db<Monitor>(TRC) << "PMU_Multiplexer(n=" << n << ",s=" << slice << ") => " << this << endl;
+
+    if(n > EVENTS)
+        db<Monitor>(WRN) << "PMU_Multiplexer: only the first " << EVENTS << " events will be counted!" << endl;
+
+    for(unsigned int i = 0; i < _events; i++) {
+        _event[i] = events[i];
+        _count[i] = 0;
+        _enabled[i] = 0;
+    }
+}
+
+void PMU_Multiplexer::start()
+{
+    db<Monitor>(TRC) << "PMU_Multiplexer::start(groups=" << groups() << ")" << endl;
+
+    if(_running || !_events)
+        return;
+
+    for(unsigned int i = 0; i < _events; i++) {
+        _count[i] = 0;
+        _enabled[i] = 0;
+    }
+    _total = 0;
+    _rotations = 0;
+
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+    _running = true;
+    program(0, TSC::time_stamp());
+    if(!disabled)
+        CPU::int_enable();
+
+    // A single group needs no rotation
+    if(groups() > 1)
+        _alarm = new (SYSTEM) Alarm(_slice, Delegate::bind<PMU_Multiplexer, &PMU_Multiplexer::rotate>(this), INFINITE);
+}
+
+void PMU_Multiplexer::stop()
+{
+    if(!_running)
+        return;
+
+    db<Monitor>(TRC) << "PMU_Multiplexer::stop(rotations=" << _rotations << ")" << endl;
+
+    if(_alarm) {
+        delete _alarm;
+        _alarm = 0;
+    }
+
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+    collect(TSC::time_stamp());
+    _running = false;
+    if(!disabled)
+        CPU::int_enable();
+}
+
+PMU_Multiplexer::Count PMU_Multiplexer::read(unsigned int i)
+{
+    assert(i < _events);
+
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+
+    Count count = _count[i];
+    Time_Stamp enabled = _enabled[i];
+    Time_Stamp total = _total;
+    if(_running) {
+        Time_Stamp slice = TSC::time_stamp() - _since;
+        total += slice;
+        if((i >= first(_group)) && (i < last(_group))) {
+            count += Clerk<PMU>(PMU::FIXED + i - first(_group), _event[i]).read();
+            enabled += slice;
+        }
+    }
+
+    if(!disabled)
+        CPU::int_enable();
+
+    // Events that were never on have no estimate
+    return enabled ? (count * ((total << 10) / enabled)) >> 10 : 0;
+}
+
+// Must be called with interrupts disabled
+void PMU_Multiplexer::program(unsigned int group, const Time_Stamp & now)
+{
+    for(unsigned int i = first(group); i < last(group); i++)
+        Clerk<PMU>(PMU::FIXED + i - first(group), _event[i]).start();
+
+    _group = group;
+    _since = now;
+}
+
+// Adds what the group on the channels has counted since it went on. Must be called with interrupts disabled.
+void PMU_Multiplexer::collect(const Time_Stamp & now)
+{
+    Time_Stamp slice = now - _since;
+
+    for(unsigned int i = first(_group); i < last(_group); i++) {
+        Clerk<PMU> clerk(PMU::FIXED + i - first(_group), _event[i]);
+        clerk.stop();
+        _count[i] += clerk.read();
+        _enabled[i] += slice;
+    }
+    _total += slice;
+}
+
+// Alarm handler (interrupt context)
+void PMU_Multiplexer::rotate()
+{
+    if(!_running)
+        return;
+
+    Time_Stamp now = TSC::time_stamp();
+    collect(now);
+    program((_group + 1) % groups(), now);
+    _rotations++;
+}
+
+__END_SYS
@@ -0,0 +1,25 @@
+// EPOS System Monitor Initialization
+
+#include <monitor.h>
+#include <machine/ipi.h>
+#include <system.h>
+
+__BEGIN_SYS
+
+void Monitor::init()
+{
+    db<Init, Monitor>(TRC) << "Monitor::init(f=" << FREQUENCY << ",pmu=" << PMU_CHANNELS << ")" << endl;
+
+    // PMUs are per CPU, so each one programs its own channels
+    for(unsigned int i = 0; i < PMU_CHANNELS; i++)
+        clerk(i).start();
+
+    if(CPU::id() == 0) {
+        if(Traits<System>::multicore)
+            IPI::handler(IPI::MONITOR, interrupt);
+
+        _alarm = new (SYSTEM) Alarm(1000000 / FREQUENCY, &alarm, INFINITE);
+    }
+}
+
+__END_SYS
@@ -4,7 +4,7 @@
 
 __BEGIN_SYS
 
-Mutex::Mutex(): _locked(false)
+Mutex::Mutex(): _state(FREE), _owner(0)
 {
     db<Synchronizer>(TRC) << "Mutex() => " << this << endl;
 }
@@ -20,22 +20,179 @@ void Mutex::lock()
 {
     db<Synchronizer>(TRC) << "Mutex::lock(this=" << this << ")" << endl;
 
+    if(cas(_state, FREE, LOCKED) == FREE) {
+        own();
+        acquired();
+        return;
+    }
+
+    Contention::Time_Stamp since = contended();
+    if(adaptive && spin()) {
+        own();
+        acquired(since);
+        return;
+    }
+
+    // Flag contention, so unlock() takes the slow path, and sleep unless the lock got released in between
     begin_atomic();
-    if(tsl(_locked))
-        sleep();
+    int state;
+    do
+        state = _state;
+    while(cas(_state, state, CONTENDED) != state);
+    if(state != FREE)
+        sleep(); // ownership is handed over by unlock()
+    own();
+    acquired(since);
     end_atomic();
 }
 
 
+bool Mutex::try_lock()
+{
+    db<Synchronizer>(TRC) << "Mutex::try_lock(this=" << this << ")" << endl;
+
+    if(cas(_state, FREE, LOCKED) != FREE)
+        return false;
+
+    own();
+    acquired();
+    return true;
+}
+
+
 void Mutex::unlock()
 {
     db<Synchronizer>(TRC) << "Mutex::unlock(this=" << this << ")" << endl;
 
+    if(adaptive)
+        _owner = 0;
+
+    if(cas(_state, LOCKED, FREE) == LOCKED)
+        return;
+
+    begin_atomic();
+    if(_queue.empty())
+        _state = FREE;
+    else
+        wakeup(); // _state stays CONTENDED: ownership goes straight to the woken thread
+    end_atomic();
+}
+
+
+// Spins while the owner is RUNNING (on another CPU, since we are running on this one), for at most SPINS rounds.
+// Gives up as soon as the owner is preempted or blocks, since it could then hold the lock for a whole quantum.
+bool Mutex::spin()
+{
+    for(unsigned int i = 0; i < SPINS; i++) {
+        if((_state == FREE) && (cas(_state, FREE, LOCKED) == FREE))
+            return true;
+
+        Thread * owner = _owner;
+        if(owner && (owner->state() != Thread::RUNNING))
+            return false;
+
+        CPU::pause();
+    }
+
+    return false;
+}
+
+
+
+Inheritance_Mutex::Inheritance_Mutex(): _locked(false), _owner(0), _priority(0)
+{
+    db<Synchronizer>(TRC) << "Inheritance_Mutex() => " << this << endl;
+}
+
+
+Inheritance_Mutex::~Inheritance_Mutex()
+{
+    db<Synchronizer>(TRC) << "~Inheritance_Mutex(this=" << this << ")" << endl;
+}
+
+
+void Inheritance_Mutex::lock()
+{
+    db<Synchronizer>(TRC) << "Inheritance_Mutex::lock(this=" << this << ")" << endl;
+
+    begin_atomic();
+    Thread * me = running();
+    if(tsl(_locked)) {
+        if(int(me->priority()) < int(_owner->priority())) // lend our priority to the owner
+            rank(_owner, me->priority());
+        sleep(); // ownership (along with our own priority) is handed over by unlock()
+    } else {
+        _owner = me;
+        _priority = me->priority();
+    }
+    end_atomic();
+}
+
+
+void Inheritance_Mutex::unlock()
+{
+    db<Synchronizer>(TRC) << "Inheritance_Mutex::unlock(this=" << this << ")" << endl;
+
+    begin_atomic();
+    bool inherited = (int(_owner->priority()) != _priority);
+    if(inherited)
+        rank(_owner, _priority);
+    if(_queue.empty()) {
+        _owner = 0;
+        _locked = false;
+    } else {
+        _owner = _queue.head()->object(); // so contenders can lend it their priority before it even runs
+        _priority = _owner->priority(); // taken before they do, so it's the one unlock() gives back
+        wakeup(); // _locked stays true: ownership goes straight to the woken thread
+    }
+    if(inherited) // threads we were holding back might outrank us now
+        reschedule();
+    end_atomic();
+}
+
+
+Ceiling_Mutex::Ceiling_Mutex(int ceiling): _locked(false), _ceiling(ceiling), _priority(0)
+{
+    db<Synchronizer>(TRC) << "Ceiling_Mutex(ceiling=" << ceiling << ") => " << this << endl;
+}
+
+
+Ceiling_Mutex::~Ceiling_Mutex()
+{
+    db<Synchronizer>(TRC) << "~Ceiling_Mutex(this=" << this << ")" << endl;
+}
+
+
+void Ceiling_Mutex::lock()
+{
+    db<Synchronizer>(TRC) << "Ceiling_Mutex::lock(this=" << this << ")" << endl;
+
+    begin_atomic();
+    if(tsl(_locked))
+        sleep(); // ownership is handed over by unlock()
+    Thread * me = running();
+    _priority = me->priority();
+    if(_ceiling < _priority)
+        rank(me, _ceiling);
+    end_atomic();
+}
+
+
+void Ceiling_Mutex::unlock()
+{
+    db<Synchronizer>(TRC) << "Ceiling_Mutex::unlock(this=" << this << ")" << endl;
+
     begin_atomic();
+    Thread * me = running();
+    bool raised = (int(me->priority()) != _priority);
+    if(raised)
+        rank(me, _priority);
     if(_queue.empty())
         _locked = false;
     else
-        wakeup();
+        wakeup(); // _locked stays true: ownership goes straight to the woken thread
+    if(raised)
+        reschedule();
     end_atomic();
 }
 
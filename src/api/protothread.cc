@@ -0,0 +1,86 @@
+// EPOS Protothread Implementation
+
+#include <protothread.h>
+
+__BEGIN_SYS
+
+void Protothread_Scheduler::insert(Protothread * pt)
+{
+    db<Thread>(TRC) << "Protothread_Scheduler::insert(this=" << this << ",pt=" << pt << ")" << endl;
+
+    _mutex.lock();
+    _ready.insert(&pt->_link);
+    _mutex.unlock();
+
+    notify();
+}
+
+
+int Protothread_Scheduler::run()
+{
+    typedef Protothread::Tick Tick;
+
+    for(;;) {
+        bool ready = false;
+        bool sleeping = false;
+        Tick deadline = 0;
+
+        _mutex.lock();
+
+        if(_ready.empty()) {
+            _mutex.unlock();
+            return 0;
+        }
+
+        Protothread::List::Element * next;
+        for(Protothread::List::Element * e = _ready.head(); e; e = next) {
+            next = e->next();
+            Protothread * pt = e->object();
+
+            if(pt->_deadline && (Tick(pt->_deadline - Alarm::elapsed()) > 0)) { // still sleeping
+                if(!sleeping || (Tick(pt->_deadline - deadline) < 0))
+                    deadline = pt->_deadline;
+                sleeping = true;
+                continue;
+            }
+            pt->_deadline = 0;
+
+            // Protothreads run with the list unlocked, so they can insert() others
+            _mutex.unlock();
+            Protothread::State state = pt->run();
+            _mutex.lock();
+
+            switch(state) {
+            case Protothread::READY:
+                ready = true;
+                break;
+            case Protothread::WAITING:
+                break;
+            case Protothread::SLEEPING:
+                if(!sleeping || (Tick(pt->_deadline - deadline) < 0))
+                    deadline = pt->_deadline;
+                sleeping = true;
+                break;
+            case Protothread::FINISHED:
+                _ready.remove(e);
+                break;
+            }
+        }
+
+        _mutex.unlock();
+
+        if(ready)
+            continue;
+
+        if(sleeping) {
+            Tick ticks = deadline - Alarm::elapsed();
+            if(ticks > 0)
+                _wakeup.p(ticks * Alarm::timer_period());
+        } else
+            _wakeup.p();
+    }
+
+    return 0;
+}
+
+__END_SYS
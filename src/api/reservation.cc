@@ -0,0 +1,49 @@
+// EPOS CPU Bandwidth Reservation Implementation
+
+#include <real-time.h>
+
+__BEGIN_SYS
+
+Reservation::Reservation(const Microsecond & budget, const Microsecond & period)
+: _budget(budget), _counts(TSC::Time_Stamp(budget) * TSC::frequency() / 1000000), _consumed(0), _running(0), _since(0),
+  _replenished(TSC::time_stamp()),
+  _alarm(period, Delegate::bind<Reservation, &Reservation::replenish>(this), INFINITE)
+{
+    db<Thread>(TRC) << "Reservation(b=" << budget << ",p=" << period << ") => " << this << endl;
+}
+
+Reservation::~Reservation()
+{
+    db<Thread>(TRC) << "~Reservation(this=" << this << ")" << endl;
+
+    // Reservations must outlive their threads. Any still throttled are let go, since nothing would replenish them
+    Thread::lock();
+    Thread::wakeup_all(&_throttled);
+    Thread::unlock();
+}
+
+Microsecond Reservation::left() const
+{
+    TSC::Time_Stamp c = consumed(TSC::time_stamp());
+    return (c >= _counts) ? 0 : (_counts - c) * 1000000 / TSC::frequency();
+}
+
+void Reservation::replenish()
+{
+    // Called by the Alarm at the end of each period. Unused budget is not carried over
+    Thread::lock();
+
+    db<Thread>(TRC) << "Reservation::replenish(this=" << this << ",consumed=" << _consumed << ")" << endl;
+
+    // Threads running across the end of the period have what they ran before it left behind
+    TSC::Time_Stamp ts = TSC::time_stamp();
+    _consumed = 0;
+    _since = _running * ts;
+    _replenished = ts;
+
+    Thread::wakeup_all(&_throttled);
+
+    Thread::unlock();
+}
+
+__END_SYS
@@ -0,0 +1,115 @@
+// EPOS Reader-Writer Lock Implementation
+
+#include <synchronizer.h>
+
+__BEGIN_SYS
+
+RW_Lock::RW_Lock(): _state(0), _writers(0), _readers(0)
+{
+    db<Synchronizer>(TRC) << "RW_Lock() => " << this << endl;
+}
+
+
+RW_Lock::~RW_Lock()
+{
+    db<Synchronizer>(TRC) << "~RW_Lock(this=" << this << ")" << endl;
+
+    begin_atomic();
+    wakeup_all(&_read_queue);
+    end_atomic();
+}
+
+
+void RW_Lock::read_lock()
+{
+    db<Synchronizer>(TRC) << "RW_Lock::read_lock(this=" << this << ",state=" << _state << ")" << endl;
+
+    if(try_read_lock())
+        return;
+
+    begin_atomic();
+    if(!try_read_lock()) {
+        _readers++;
+        sleep(&_read_queue); // write_unlock() counts us in _state before waking us up
+    }
+    end_atomic();
+}
+
+
+bool RW_Lock::try_read_lock()
+{
+    db<Synchronizer>(TRC) << "RW_Lock::try_read_lock(this=" << this << ",state=" << _state << ")" << endl;
+
+    for(int state = _state; (state >= 0) && !_writers; state = _state)
+        if(cas(_state, state, state + 1) == state)
+            return true;
+
+    return false;
+}
+
+
+void RW_Lock::read_unlock()
+{
+    db<Synchronizer>(TRC) << "RW_Lock::read_unlock(this=" << this << ",state=" << _state << ")" << endl;
+
+    for(int state = _state; state > 1; state = _state)
+        if(cas(_state, state, state - 1) == state)
+            return;
+
+    // We might be the last reader, which hands the lock over to a waiting writer
+    begin_atomic();
+    int state;
+    do
+        state = _state;
+    while(cas(_state, state, state - 1) != state);
+    if((state == 1) && _writers && (cas(_state, 0, int(WRITER)) == 0)) {
+        _writers--;
+        wakeup();
+    }
+    end_atomic();
+}
+
+
+void RW_Lock::write_lock()
+{
+    db<Synchronizer>(TRC) << "RW_Lock::write_lock(this=" << this << ",state=" << _state << ")" << endl;
+
+    if(try_write_lock())
+        return;
+
+    // The last holder always releases the lock in an atomic section, which will see us in _writers
+    begin_atomic();
+    if(!try_write_lock()) {
+        _writers++;
+        sleep(); // ownership is handed over by write_unlock() or by the last read_unlock()
+    }
+    end_atomic();
+}
+
+
+bool RW_Lock::try_write_lock()
+{
+    db<Synchronizer>(TRC) << "RW_Lock::try_write_lock(this=" << this << ",state=" << _state << ")" << endl;
+
+    return (cas(_state, 0, int(WRITER)) == 0);
+}
+
+
+void RW_Lock::write_unlock()
+{
+    db<Synchronizer>(TRC) << "RW_Lock::write_unlock(this=" << this << ",writers=" << _writers << ",readers=" << _readers << ")" << endl;
+
+    begin_atomic();
+    if(_writers) {
+        _writers--;
+        wakeup(); // _state stays WRITER: ownership goes straight to the woken writer
+    } else if(_readers) {
+        _state = _readers;
+        _readers = 0;
+        wakeup_all(&_read_queue);
+    } else
+        _state = 0;
+    end_atomic();
+}
+
+__END_SYS
@@ -2,9 +2,17 @@
 
 #include <process.h>
 #include <time.h>
+#include <real-time.h>
 
 __BEGIN_SYS
 
+volatile unsigned int Variable_Queue_Scheduler::_next_queue;
+
+TSC::Time_Stamp Scheduling_Criterion_Common::Statistics::_cpu_time[Traits<Build>::CPUS];
+TSC::Time_Stamp Scheduling_Criterion_Common::Statistics::_last_dispatch_time[Traits<Build>::CPUS];
+TSC::Time_Stamp Scheduling_Criterion_Common::Statistics::_last_activation_time;
+PMU::Count Scheduling_Criterion_Common::Statistics::_last_pmu_count[Traits<Build>::CPUS][PMU_CHANNELS];
+
 // The following Scheduling Criteria depend on Alarm, which is not available at scheduler.h
 template <typename ... Tn>
 FCFS::FCFS(int p, Tn & ... an): Priority((p == IDLE) ? IDLE : Alarm::elapsed()) {}
@@ -12,4 +20,24 @@ FCFS::FCFS(int p, Tn & ... an): Priority((p == IDLE) ? IDLE : Alarm::elapsed())
 // Since the definition above is only known to this unit, forcing its instantiation here so it gets emitted in scheduler.o for subsequent linking with other units is necessary.
 template FCFS::FCFS<>(int p);
 
+EDF::EDF(const Microsecond & p, const Microsecond & d, const Microsecond & c, unsigned int cpu)
+: RT_Common(Alarm::elapsed() + Alarm::ticks(d ? d : p), p, d, c) {}
+
+const Microsecond Reserved::quantum() const
+{
+    Microsecond q = RR::quantum();
+    if(_reservation && (_reservation->left() < q))
+        q = _reservation->left();
+    return q;
+}
+
+bool EDF::update()
+{
+    if(!periodic())
+        return false;
+
+    _priority = Alarm::elapsed() + Alarm::ticks(_deadline);
+    return true;
+}
+
 __END_SYS
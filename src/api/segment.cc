@@ -5,9 +5,9 @@
 __BEGIN_SYS
 
 // Methods
-Segment::Segment(unsigned int bytes, Flags flags): Chunk(bytes, flags, WHITE)
+Segment::Segment(unsigned int bytes, Flags flags, Color color): Chunk(bytes, flags, color)
 {
-    db<Segment>(TRC) << "Segment(bytes=" << bytes << ",flags=" << flags << ") [Chunk::pt=" << Chunk::pt() << ",sz=" << Chunk::size() << "] => " << this << endl;
+    db<Segment>(TRC) << "Segment(bytes=" << bytes << ",flags=" << flags << ",color=" << color << ") [Chunk::pt=" << Chunk::pt() << ",sz=" << Chunk::size() << "] => " << this << endl;
 }
 
 
@@ -19,6 +19,12 @@ Segment::Segment(Phy_Addr phy_addr, unsigned int bytes, Flags flags): Chunk(phy_
 }
 
 
+Segment::Segment(const Segment & segment): Chunk(segment)
+{
+    db<Segment>(TRC) << "Segment(segment=" << &segment << ") [Chunk::pt=" << Chunk::pt() << ",sz=" << Chunk::size() << "] => " << this << endl;
+}
+
+
 Segment::~Segment()
 {
     db<Segment>(TRC) << "~Segment() [Chunk::pt=" << Chunk::pt() << "]" << endl;
@@ -44,4 +50,77 @@ int Segment::resize(int amount)
     return Chunk::resize(amount);
 }
 
+
+Segment_Heap::Segment_Heap(unsigned int bytes, unsigned int max)
+: _segment(new (SYSTEM) Segment(bytes)), _pd(MMU::current()), _base(Address_Space(_pd).attach(_segment)),
+  _step(_segment->size()), _max((max > _step) ? max : _step)
+{
+    db<Segment>(TRC) << "Segment_Heap(bytes=" << bytes << ",max=" << max << ") [seg=" << _segment << ",base=" << _base << "] => " << this << endl;
+
+    _bounded = true;
+    if(_base) {
+        free(_base, _segment->size());
+        if(_max > _step)
+            _resizer = &resize;
+    } else
+        db<Segment>(WRN) << "Segment_Heap: segment could not be attached!" << endl;
+}
+
+
+Segment_Heap::~Segment_Heap()
+{
+    db<Segment>(TRC) << "~Segment_Heap(this=" << this << ")" << endl;
+
+    if(_base)
+        Address_Space(_pd).detach(_segment, _base);
+    delete _segment;
+}
+
+
+bool Segment_Heap::resize(Heap * heap, unsigned long bytes)
+{
+    Segment_Heap * h = static_cast<Segment_Heap *>(heap);
+    return bytes ? h->grow(bytes) : h->trim();
+}
+
+
+bool Segment_Heap::grow(unsigned long bytes)
+{
+    unsigned long size = _segment->size();
+    unsigned long amount = (bytes > _step) ? bytes : _step;
+    if(size + amount > _max)
+        amount = _max - size;
+    if((amount < bytes) || (MMU::page_tables(MMU::pages(size + amount)) > _segment->pts()))
+        amount = bytes; // at least what is needed
+    if((size + amount > _max) || (MMU::page_tables(MMU::pages(size + amount)) > _segment->pts()))
+        return false;
+
+    int grown = _segment->resize(amount);
+    if(grown <= 0)
+        return false;
+
+    db<Segment>(TRC) << "Segment_Heap::grow(this=" << this << ",bytes=" << bytes << ") => " << grown << endl;
+
+    extend(_base + size, grown);
+
+    return true;
+}
+
+
+bool Segment_Heap::trim()
+{
+    if(grouped_size() < 2 * _step)
+        return false;
+
+    unsigned long bytes = Heap::trim(_base + _segment->size(), _step, _step);
+    if(!bytes)
+        return false;
+
+    db<Segment>(TRC) << "Segment_Heap::trim(this=" << this << ") => " << bytes << endl;
+
+    _segment->resize(-static_cast<int>(bytes));
+
+    return true;
+}
+
 __END_SYS
@@ -20,10 +20,65 @@ void Semaphore::p()
 {
     db<Synchronizer>(TRC) << "Semaphore::p(this=" << this << ",value=" << _value << ")" << endl;
 
+    if(take()) {
+        acquired();
+        return;
+    }
+
     begin_atomic();
+    Contention::Time_Stamp since = contended();
     if(fdec(_value) < 1)
         sleep();
+    acquired(since);
+    end_atomic();
+}
+
+
+bool Semaphore::p(const Microsecond & timeout)
+{
+    db<Synchronizer>(TRC) << "Semaphore::p(this=" << this << ",value=" << _value << ",t=" << timeout << ")" << endl;
+
+    if(take()) {
+        acquired();
+        return true;
+    }
+
+    bool got = true;
+
+    begin_atomic();
+    Contention::Time_Stamp since = contended();
+    if(fdec(_value) < 1) {
+        got = sleep(timeout);
+        if(!got) // undo our fdec(), since no v() will hand us a unit anymore
+            finc(_value);
+    }
+    if(got)
+        acquired(since);
     end_atomic();
+
+    return got;
+}
+
+
+bool Semaphore::try_p()
+{
+    db<Synchronizer>(TRC) << "Semaphore::try_p(this=" << this << ",value=" << _value << ")" << endl;
+
+    if(!take())
+        return false;
+
+    acquired();
+    return true;
+}
+
+
+bool Semaphore::take()
+{
+    for(int value = _value; value > 0; value = _value)
+        if(cas(_value, value, value - 1) == value)
+            return true;
+
+    return false;
 }
 
 
@@ -31,9 +86,13 @@ void Semaphore::v()
 {
     db<Synchronizer>(TRC) << "Semaphore::v(this=" << this << ",value=" << _value << ")" << endl;
 
+    for(int value = _value; value >= 0; value = _value)
+        if(cas(_value, value, value + 1) == value)
+            return;
+
     begin_atomic();
     if(finc(_value) < 0)
-        wakeup();
+        wakeup(); // the unit goes straight to the woken thread, which doesn't decrement _value again
     end_atomic();
 }
 
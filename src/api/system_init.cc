@@ -3,16 +3,31 @@
 #include <system.h>
 #include <time.h>
 #include <process.h>
+#include <monitor.h>
+#include <governor.h>
+#include <energy.h>
 
 __BEGIN_SYS
 
 void System::init()
 {
+    Time::init();
+
     if(Traits<Alarm>::enabled)
         Alarm::init();
 
+    // Before the first dispatch, which is the first charge
+    if(Traits<Energy_Meter>::enabled)
+        Energy_Meter::init();
+
     if(Traits<Thread>::enabled)
         Thread::init();
+
+    if(Traits<Monitor>::enabled)
+        Monitor::init();
+
+    if(Traits<Governor>::enabled)
+        Governor::init();
 }
 
 __END_SYS
@@ -0,0 +1,155 @@
+// EPOS Task Implementation
+
+#include <process.h>
+#include <utility/elf.h>
+
+__BEGIN_SYS
+
+// Class attributes
+Task * Task::_master;
+Task * Task::_active[Task::CPUS];
+
+// Methods
+Task::Task(Address_Space * as)
+: _as(as), _cs(0), _ds(0), _code(0), _data(0), _main(0), _heap(0), _loaded(false)
+{
+    db<Task>(TRC) << "Task(as=" << _as << ") => " << this << endl;
+}
+
+Task::Task(Segment * cs, Segment * ds, const Log_Addr & code, const Log_Addr & data)
+: _as(new (SYSTEM) Address_Space), _cs(cs), _ds(ds), _code(code ? _as->attach(_cs, code) : _as->attach(_cs)),
+  _data(data ? _as->attach(_ds, data) : _as->attach(_ds)), _main(0), _heap(0), _loaded(true)
+{
+    constructor_prologue();
+}
+
+Task::~Task()
+{
+    db<Task>(TRC) << "~Task(this=" << this << ")" << endl;
+
+    // Threads of the task other than main() must be gone by now
+    delete _main;
+
+    // The Address_Space can't go away while a CPU still has it active, which is only the case for the running one here
+    Thread::lock();
+    if(active() == this)
+        _master->activate();
+    Thread::unlock();
+
+    if(_code)
+        _as->detach(_cs, _code);
+    if(_data)
+        _as->detach(_ds, _data);
+    if(_loaded) {
+        delete _cs;
+        delete _ds;
+    }
+    delete _heap; // whatever its threads left in it
+    delete _as;
+}
+
+Heap * Task::heap(unsigned int bytes, unsigned int max)
+{
+    db<Task>(TRC) << "Task::heap(this=" << this << ",bytes=" << bytes << ",max=" << max << ")" << endl;
+
+    if(_heap || (multitask && (self() != this))) {
+        db<Task>(WRN) << "Task::heap: the heap must be given once and by one of the task's threads!" << endl;
+        return 0;
+    }
+
+    _heap = new (SYSTEM) Segment_Heap(bytes, max);
+
+    return _heap;
+}
+
+Task * Task::load(const void * image)
+{
+    db<Task>(TRC) << "Task::load(image=" << image << ")" << endl;
+
+    ELF * elf = reinterpret_cast<ELF *>(const_cast<void *>(image));
+    if(!elf->valid()) {
+        db<Task>(WRN) << "Task::load: not an ELF image!" << endl;
+        return 0;
+    }
+
+    // Executable segments go to the code Segment and all others to the data one, keeping the distances between them
+    static const Elf_Addr PAGE = sizeof(MMU::Page);
+    Elf_Addr code = ~0UL, code_end = 0, data = ~0UL, data_end = 0;
+    for(int i = 0; i < elf->segments(); i++) {
+        if(elf->segment_type(i) != PT_LOAD)
+            continue;
+        Elf_Addr & begin = (elf->segment_flags(i) & PF_X) ? code : data;
+        Elf_Addr & end = (elf->segment_flags(i) & PF_X) ? code_end : data_end;
+        if(elf->segment_address(i) < begin)
+            begin = elf->segment_address(i) & ~(PAGE - 1);
+        if(elf->segment_address(i) + elf->segment_size(i) > end)
+            end = elf->segment_address(i) + elf->segment_size(i);
+    }
+    if(!code_end)
+        return 0;
+    if(!data_end) // a data Segment is always there, if only for the Task to have one
+        data = data_end = code_end;
+
+    bool pie = elf->relocatable();
+    Segment * cs = new (SYSTEM) Segment(code_end - code);
+    Segment * ds = new (SYSTEM) Segment((data_end - data) ? data_end - data : PAGE);
+    Task * task = new (SYSTEM) Task(cs, ds, pie ? Log_Addr(0) : Log_Addr(code), pie ? Log_Addr(0) : Log_Addr(data));
+    if(!task->_code || !task->_data) {
+        delete task;
+        return 0;
+    }
+
+    // Segments are written through the system's mapping of them, but are relocated to where the Task sees them
+    ELF::Placement map[2] = {{code, code_end - code, task->_code}, {data, data_end - data, task->_data}};
+    Address_Space as(MMU::current());
+    Log_Addr c = as.attach(cs);
+    Log_Addr d = as.attach(ds);
+
+    int bytes = 0;
+    for(int i = 0; (bytes >= 0) && (i < elf->segments()); i++) {
+        if(elf->segment_type(i) != PT_LOAD)
+            continue;
+        Log_Addr dst = (elf->segment_flags(i) & PF_X) ? c + (elf->segment_address(i) - code) : d + (elf->segment_address(i) - data);
+        bytes = elf->load_segment(i, dst, map, pie ? 2 : 0);
+    }
+
+    // Code was written through the data cache
+    CPU::cache_clean(c, cs->size());
+
+    as.detach(cs);
+    as.detach(ds);
+
+    if(bytes < 0) {
+        db<Task>(WRN) << "Task::load: corrupted ELF image!" << endl;
+        delete task;
+        return 0;
+    }
+
+    typedef int (Main)();
+    task->constructor_epilogue(reinterpret_cast<Main *>(pie ? ELF::relocate(elf->entry(), map, 2) : elf->entry()));
+
+    return task;
+}
+
+void Task::constructor_prologue()
+{
+    if(!_code || !_data)
+        db<Task>(WRN) << "Task: segments could not be attached (cs=" << _cs << "@" << _code << ",ds=" << _ds << "@" << _data << ")!" << endl;
+}
+
+void Task::activate()
+{
+    db<Task>(TRC) << "Task::activate(this=" << this << ")" << endl;
+
+    _as->activate();
+    _active[CPU::id()] = this;
+}
+
+// The running Task's own heap, which Application::heap() prefers with Traits<System>::task_heaps
+Heap * Application::task_heap()
+{
+    Task * task = Thread::self() ? Task::self() : 0;
+    return task ? task->heap() : 0;
+}
+
+__END_SYS
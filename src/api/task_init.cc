@@ -0,0 +1,17 @@
+// EPOS Task Initialization
+
+#include <process.h>
+
+__BEGIN_SYS
+
+void Task::init()
+{
+    db<Init, Task>(TRC) << "Task::init()" << endl;
+
+    // The system runs in the Address_Space SETUP left active on all CPUs, which is taken over without being freed
+    _master = new (SYSTEM) Task(new (SYSTEM) Address_Space(MMU::current()));
+    for(unsigned int i = 0; i < CPUS; i++)
+        _active[i] = _master;
+}
+
+__END_SYS
@@ -3,10 +3,20 @@
 #include <machine.h>
 #include <system.h>
 #include <process.h>
+#include <time.h>
+#include <real-time.h>
+#include <utility/trace.h>
+#include <utility/rcu.h>
+#include <utility/log.h>
+#include <utility/string.h>
+#include <governor.h>
+
+// Bounds of the TLS segment (.tdata followed by .tbss), defined at link time by eposcc
+extern "C" { extern char __tls_image[], __tdata_end[], __tbss_end[]; }
 
 // This_Thread class attributes
 __BEGIN_UTIL
-bool This_Thread::_not_booting;
+bool This_Thread::_not_booting[This_Thread::CPUS];
 __END_UTIL
 
 __BEGIN_SYS
@@ -14,20 +24,47 @@ __BEGIN_SYS
 volatile unsigned int Thread::_thread_count;
 Scheduler_Timer * Thread::_timer;
 Scheduler<Thread> Thread::_scheduler;
-
-
-void Thread::constructor_prologue(unsigned int stack_size)
+Thread::Kernel_Lock Thread::_lock;
+volatile bool Thread::_switching[Thread::CPUS];
+Thread::Stack_Class Thread::_stack_pool[STACK_CLASSES];
+void * Thread::_object_pool;
+Slab<Thread> Thread::_slab;
+unsigned int Thread::_batching[Thread::CPUS];
+bool Thread::_batched[Thread::CPUS];
+TSC::Time_Stamp Thread::_balanced;
+volatile bool Thread::_busy[Thread::CPUS];
+
+
+void Thread::constructor_prologue(unsigned int stack_size, bool scratchpad, Task * task, bool batched)
 {
-    lock();
+    if(!batched)
+        lock();
+
+    // Taken before insert(), since the first thread is chosen as soon as it gets into the scheduler
+    _task = (multitask && !task && running()) ? running()->_task : task;
 
     _thread_count++;
     _scheduler.insert(this);
 
-    _stack = new (SYSTEM) char[stack_size];
+    // Scratchpad stacks are not pooled, since the pools don't tell where each stack came from
+    _stack = scratchpad ? new (SCRATCHPAD) char[stack_size] : stack_alloc(stack_size);
+    _stack_size = stack_size;
+    _stack_peak = 0;
+    _scratchpad_stack = scratchpad;
+
+    // Painted before the initial context is pushed, so stack_peak() counts it too
+    if(watermark)
+        memset(_stack, STACK_PAINT, stack_size);
+
+    if(tls)
+        _tls = tls_alloc();
+
+    _ic_level = 0;
+    _energy = 0;
 }
 
 
-void Thread::constructor_epilogue(Log_Addr entry, unsigned int stack_size)
+void Thread::constructor_epilogue(Log_Addr entry, unsigned int stack_size, bool batched)
 {
     db<Thread>(TRC) << "Thread(entry=" << entry
                     << ",state=" << _state
@@ -42,6 +79,9 @@ void Thread::constructor_epilogue(Log_Addr entry, unsigned int stack_size)
     if((_state != READY) && (_state != RUNNING))
         _scheduler.suspend(this);
 
+    if(batched)
+        return;
+
     if(preemptive && (_state == READY) && (_link.rank() != IDLE))
         reschedule();
 
@@ -63,6 +103,12 @@ Thread::~Thread()
     // The running thread cannot delete itself!
     assert(_state != RUNNING);
 
+    // Threads that went through exit() have had theirs taken already
+    if(watermark && (_state != FINISHING)) {
+        _stack_peak = stack_peak();
+        db<Thread>(INF) << "~Thread(this=" << this << "): stack peak=" << _stack_peak << " of " << _stack_size << " bytes" << endl;
+    }
+
     switch(_state) {
     case RUNNING:  // For switch completion only: the running thread would have deleted itself! Stack wouldn't have been released!
         exit(-1);
@@ -89,9 +135,32 @@ Thread::~Thread()
     if(_joining)
         _joining->resume();
 
+    if(_scratchpad_stack)
+        delete _stack;
+    else
+        stack_free(_stack, _stack_size);
+
+    if(tls)
+        delete _tls;
+
     unlock();
+}
+
+
+unsigned int Thread::stack_peak() const
+{
+    if(!watermark)
+        return 0;
 
-    delete _stack;
+    if(_state == FINISHING)
+        return _stack_peak;
+
+    // Stacks grow down, from _stack + _stack_size
+    unsigned int untouched = 0;
+    while((untouched < _stack_size) && (reinterpret_cast<const unsigned char *>(_stack)[untouched] == STACK_PAINT))
+        untouched++;
+
+    return _stack_size - untouched;
 }
 
 
@@ -115,6 +184,237 @@ void Thread::priority(const Criterion & c)
 }
 
 
+void Thread::migrate(unsigned int cpu)
+{
+    assert(cpu < Criterion::QUEUES);
+
+    lock();
+
+    db<Thread>(TRC) << "Thread::migrate(this=" << this << ",from=" << criterion().queue() << ",to=" << cpu << ")" << endl;
+
+    relocate(cpu);
+
+    unlock();
+}
+
+
+void Thread::affinity(unsigned long mask)
+{
+    lock();
+
+    db<Thread>(TRC) << "Thread::affinity(this=" << this << ",mask=" << reinterpret_cast<void *>(mask) << ")" << endl;
+
+    unsigned int cpu = 0;
+    for(; (cpu < CPU::cores()) && !(mask & (1UL << cpu)); cpu++);
+    if(cpu == CPU::cores())
+        db<Thread>(WRN) << "Thread::affinity: no CPU in mask " << reinterpret_cast<void *>(mask) << "!" << endl;
+    else {
+        criterion().affinity(mask);
+        if(!criterion().affine(criterion().queue())) // leave a CPU that is no longer allowed for the first one that is
+            relocate(cpu);
+    }
+
+    unlock();
+}
+
+
+void Thread::relocate(unsigned int cpu)
+{
+    assert(locked()); // locking handled by caller
+
+    // Only partitioned criteria have per-CPU queues to move between
+    if((Criterion::QUEUES > 1) && (cpu != criterion().queue())) {
+        if(_state == READY) {
+            _scheduler.remove(this);
+            criterion().queue(cpu);
+            _scheduler.insert(this);
+        } else
+            criterion().queue(cpu); // waiting and suspended threads move when resumed, running ones when their CPU next chooses or they leave it (see Scheduling_Multilist::remove())
+
+        if(this == running())
+            reschedule();
+        else if(_state == READY)
+            reschedule(cpu);
+    }
+}
+
+
+TSC::Time_Stamp Thread::load(const TSC::Time_Stamp & ts)
+{
+    Criterion::Statistics & s = criterion()._statistics;
+    TSC::Time_Stamp half_life = TSC::Time_Stamp(Traits<Thread>::BALANCE_PERIOD) * TSC::frequency() / 1000000;
+
+    if(ts - s.load_decay >= half_life) {
+        TSC::Time_Stamp periods = (ts - s.load_decay) / half_life;
+        s.load = (periods < sizeof(TSC::Time_Stamp) * 8) ? s.load >> periods : 0;
+        s.load_decay += periods * half_life;
+    }
+
+    return s.load;
+}
+
+
+void Thread::rank(int p)
+{
+    db<Thread>(TRC) << "Thread::rank(this=" << this << ",state=" << _state << ",prio=" << p << ")" << endl;
+
+    assert(locked()); // locking handled by caller
+
+    // Only the scalar priority changes (e.g. the queue of partitioned criteria doesn't). The thread is
+    // removed from whatever queue it is in before that, since bitmap-indexed queues file it by band
+    switch(_state) {
+    case READY:
+        _scheduler.remove(this);
+        criterion()._priority = p;
+        _scheduler.insert(this);
+        break;
+    case WAITING:
+        _waiting->remove(this);
+        criterion()._priority = p;
+        _waiting->insert(&_link);
+        break;
+    default:
+        criterion()._priority = p;
+    }
+}
+
+
+char * Thread::stack_alloc(unsigned int bytes)
+{
+    assert(locked());
+
+    if(pooled)
+        for(unsigned int i = 0; i < STACK_CLASSES; i++)
+            if((_stack_pool[i].size == bytes) && _stack_pool[i].free) {
+                char * stack = _stack_pool[i].free;
+                _stack_pool[i].free = *reinterpret_cast<char **>(stack);
+                return stack;
+            }
+
+    return new (SYSTEM) char[bytes];
+}
+
+
+void Thread::stack_free(char * stack, unsigned int bytes)
+{
+    assert(locked());
+
+    if(pooled) {
+        unsigned int i;
+        for(i = 0; (i < STACK_CLASSES) && (_stack_pool[i].size != bytes); i++);
+        if(i == STACK_CLASSES) // first stack of this size: claim a free class, if any is left
+            for(i = 0; (i < STACK_CLASSES) && _stack_pool[i].size; i++);
+
+        if(i < STACK_CLASSES) {
+            _stack_pool[i].size = bytes;
+            *reinterpret_cast<char **>(stack) = _stack_pool[i].free;
+            _stack_pool[i].free = stack;
+            return;
+        }
+    }
+
+    delete stack;
+}
+
+
+// Each thread gets its own copy of the TLS segment: the .tdata image followed by a zeroed .tbss, after CPU::TLS_TCB bytes
+// Only trivially constructible thread_local variables are supported, since nothing runs their constructors per thread
+char * Thread::tls_alloc()
+{
+    unsigned int data = __tdata_end - __tls_image;
+    unsigned int size = __tbss_end - __tls_image;
+
+    char * block = new (SYSTEM) char[CPU::TLS_TCB + size];
+    memset(block, 0, CPU::TLS_TCB);
+    memcpy(block + CPU::TLS_TCB, __tls_image, data);
+    memset(block + CPU::TLS_TCB + data, 0, size - data);
+
+    return block;
+}
+
+
+void * Thread::object_alloc(bool system)
+{
+    void * object = STATIC_OBJECTS ? Pool<Thread, STATIC_OBJECTS>::alloc() : 0;
+    if(object)
+        return object;
+
+    if(!cached)
+        return system ? ::operator new(sizeof(Thread), SYSTEM) : ::operator new(sizeof(Thread));
+
+    if(pooled) {
+        lock();
+
+        object = _object_pool;
+        if(object)
+            _object_pool = *reinterpret_cast<void **>(object);
+
+        unlock();
+    }
+
+    // Without multiheap, SYSTEM and the application share the same heap
+    if(!object)
+        object = slabbed ? _slab.alloc() : ::operator new(sizeof(Thread), SYSTEM);
+
+    return object;
+}
+
+
+// As object_alloc(false) n times, but with the pool taken once
+void Thread::object_alloc(void * objects[], unsigned int n)
+{
+    unsigned int i = 0;
+    if(STATIC_OBJECTS)
+        for(; (i < n) && (objects[i] = Pool<Thread, STATIC_OBJECTS>::alloc()); i++);
+
+    if(!cached) {
+        for(; i < n; i++)
+            objects[i] = ::operator new(sizeof(Thread));
+        return;
+    }
+
+    if(pooled) {
+        lock();
+
+        for(; (i < n) && _object_pool; i++) {
+            objects[i] = _object_pool;
+            _object_pool = *reinterpret_cast<void **>(_object_pool);
+        }
+
+        unlock();
+    }
+
+    for(; i < n; i++)
+        objects[i] = slabbed ? _slab.alloc() : ::operator new(sizeof(Thread), SYSTEM);
+}
+
+
+void Thread::object_free(void * object)
+{
+    if(STATIC_OBJECTS && Pool<Thread, STATIC_OBJECTS>::contains(object)) {
+        Pool<Thread, STATIC_OBJECTS>::free(object);
+        return;
+    }
+
+    if(!cached) {
+        ::operator delete(object);
+        return;
+    }
+
+    if(!pooled) {
+        _slab.free(object);
+        return;
+    }
+
+    lock();
+
+    *reinterpret_cast<void **>(object) = _object_pool;
+    _object_pool = object;
+
+    unlock();
+}
+
+
 int Thread::join()
 {
     lock();
@@ -190,6 +490,7 @@ void Thread::resume()
 
     if(_state == SUSPENDED) {
         _state = READY;
+        _wakeup.ready();
         _scheduler.resume(this);
 
         if(preemptive)
@@ -202,6 +503,31 @@ void Thread::resume()
 
 
 // Class methods
+void Thread::resume_all(Thread * const threads[], unsigned int n)
+{
+    lock();
+
+    db<Thread>(TRC) << "Thread::resume_all(n=" << n << ")" << endl;
+
+    bool resumed = false;
+    for(unsigned int i = 0; i < n; i++) {
+        Thread * t = threads[i];
+        if(t->_state == SUSPENDED) {
+            t->_state = READY;
+            t->_wakeup.ready();
+            _scheduler.resume(t);
+            resumed = true;
+        } else
+            db<Thread>(WRN) << "Resume called for unsuspended object!" << endl;
+    }
+
+    if(preemptive && resumed)
+        reschedule();
+
+    unlock();
+}
+
+
 void Thread::yield()
 {
     lock();
@@ -225,6 +551,11 @@ void Thread::exit(int status)
 
     Thread * prev = running();
     _scheduler.remove(prev);
+    if(watermark) {
+        prev->_stack_peak = prev->stack_peak();
+        db<Thread>(INF) << "Thread::exit(this=" << prev << "): stack peak=" << prev->_stack_peak << " of " << prev->_stack_size << " bytes" << endl;
+    }
+
     prev->_state = FINISHING;
     *reinterpret_cast<int *>(prev->_stack) = status;
 
@@ -232,6 +563,7 @@ void Thread::exit(int status)
 
     if(prev->_joining) {
         prev->_joining->_state = READY;
+        prev->_joining->_wakeup.ready();
         _scheduler.resume(prev->_joining);
         prev->_joining = 0;
     }
@@ -256,12 +588,73 @@ void Thread::sleep(Queue * q)
     prev->_waiting = q;
     q->insert(&prev->_link);
 
+    Trace::record(Trace::SLEEP, prev, q, prev->_state);
+
     Thread * next = _scheduler.chosen();
 
     dispatch(prev, next);
 }
 
 
+bool Thread::sleep(Queue * q, const Microsecond & timeout)
+{
+    db<Thread>(TRC) << "Thread::sleep(running=" << running() << ",q=" << q << ",t=" << timeout << ")" << endl;
+
+    assert(locked()); // locking handled by caller
+
+    // Wakes the sleeper up if it is still waiting on "q" when the alarm goes off. If it goes off before the
+    // thread gets to sleep (i.e. timeout is shorter than a tick), the wait just expires.
+    // Otherwise, a thread woken by someone else before the alarm went off didn't time out.
+    class Timeout: public Handler
+    {
+    public:
+        Timeout(Thread * t, Queue * q): _thread(t), _queue(q), _asleep(false), _expired(false) {}
+
+        void operator()() {
+            bool masked = CPU::int_disabled(); // when called right away by Alarm(), the sleeper's lock is still held
+            if(!masked)
+                lock();
+
+            if(!_asleep)
+                _expired = true;
+            else if((_thread->_state == WAITING) && (_thread->_waiting == _queue)) {
+                _queue->remove(_thread);
+                _thread->_state = READY;
+                _thread->_waiting = 0;
+                _thread->_wakeup.ready();
+                _scheduler.resume(_thread);
+                _expired = true;
+
+                if(preemptive)
+                    reschedule();
+            }
+
+            if(!masked)
+                unlock();
+        }
+
+        void asleep() { _asleep = true; }
+        bool expired() const { return _expired; }
+
+    private:
+        Thread * _thread;
+        Queue * _queue;
+        volatile bool _asleep;
+        volatile bool _expired;
+    };
+
+    Timeout handler(running(), q);
+    Alarm alarm(timeout, &handler, 1);
+
+    if(!handler.expired()) {
+        handler.asleep();
+        sleep(q);
+    }
+
+    return !handler.expired();
+}
+
+
 void Thread::wakeup(Queue * q)
 {
     db<Thread>(TRC) << "Thread::wakeup(running=" << running() << ",q=" << q << ")" << endl;
@@ -272,14 +665,80 @@ void Thread::wakeup(Queue * q)
         Thread * t = q->remove()->object();
         t->_state = READY;
         t->_waiting = 0;
+        t->_wakeup.ready();
+        if(wake_affine)
+            place(t);
         _scheduler.resume(t);
 
+        Trace::record(Trace::WAKEUP, running(), t, t->_state);
+
+        // Under partitioned criteria, "t" might have been queued on another CPU, which is the one to reschedule
         if(preemptive)
+            reschedule((Criterion::QUEUES > 1) ? t->criterion().queue() : CPU::id());
+    }
+}
+
+
+void Thread::handoff(Queue * q)
+{
+    db<Thread>(TRC) << "Thread::handoff(running=" << running() << ",q=" << q << ")" << endl;
+
+    assert(locked()); // locking handled by caller
+
+    // The caller has already passed the resource to the head waiter, so there is no point in
+    // switching to it unless it outranks the running thread (reschedule() would rotate among equals)
+    if(!q->empty()) {
+        Thread * t = q->remove()->object();
+        t->_state = READY;
+        t->_waiting = 0;
+        t->_wakeup.ready();
+        _scheduler.resume(t);
+
+        Trace::record(Trace::WAKEUP, running(), t, t->_state);
+
+        if(preemptive && (t->_link.rank() < running()->_link.rank()))
             reschedule();
     }
 }
 
 
+void Thread::requeue(Queue * from, Queue * to)
+{
+    db<Thread>(TRC) << "Thread::requeue(running=" << running() << ",from=" << from << ",to=" << to << ")" << endl;
+
+    assert(locked()); // locking handled by caller
+
+    // Moves the head waiter of "from" to "to", or makes it READY if "to" is null, without rescheduling
+    if(!from->empty()) {
+        Thread * t = from->remove()->object();
+        if(to) {
+            t->_waiting = to;
+            to->insert(&t->_link);
+        } else {
+            t->_state = READY;
+            t->_waiting = 0;
+            t->_wakeup.ready();
+            _scheduler.resume(t);
+        }
+    }
+}
+
+
+void Thread::place(Thread * t)
+{
+    // Wake-affine placement: "t" stays on the CPU it last ran on, where its cache footprint is, unless that one is busy
+    // and the waker's shares a cache with it, so a consumer woken up by its producer finds the data still warm
+    unsigned int last = t->criterion().queue();
+    unsigned int here = CPU::id();
+
+    if((last != here) && _busy[last] && (last / CACHE_SHARING == here / CACHE_SHARING) && t->criterion().affine(here)) {
+        db<Thread>(TRC) << "Thread::place(t=" << t << ",from=" << last << ",to=" << here << ")" << endl;
+
+        t->criterion().queue(here);
+    }
+}
+
+
 void Thread::wakeup_all(Queue * q)
 {
     db<Thread>(TRC) << "Thread::wakeup_all(running=" << running() << ",q=" << q << ")" << endl;
@@ -287,15 +746,23 @@ void Thread::wakeup_all(Queue * q)
     assert(locked()); // locking handled by caller
 
     if(!q->empty()) {
+        // Under partitioned criteria, the CPUs of the threads woken up get a single IPI each, instead of one per thread
+        IPI::CPU_Set cpus = 0;
         while(!q->empty()) {
             Thread * t = q->remove()->object();
             t->_state = READY;
             t->_waiting = 0;
+            t->_wakeup.ready();
             _scheduler.resume(t);
+            cpus |= 1U << ((Criterion::QUEUES > 1) ? t->criterion().queue() : CPU::id());
         }
 
-        if(preemptive)
-            reschedule();
+        if(preemptive) {
+            if(smp)
+                IPI::multicast(cpus & ~(1U << CPU::id()), IPI::RESCHEDULE);
+            if(!smp || (cpus & (1U << CPU::id())))
+                reschedule();
+        }
     }
 }
 
@@ -307,6 +774,19 @@ void Thread::reschedule()
 
     assert(locked()); // locking handled by caller
 
+    // Handlers on an interrupt stack get the switch once they are back on the interrupted thread's (see Traits<IC>::STACK_SIZE
+    // and Traits<IC>::deferred)
+    if(IC::defer_reschedule())
+        return;
+
+    if(batching && _batching[CPU::id()]) {
+        _batched[CPU::id()] = true;
+        return;
+    }
+
+    if(Criterion::reserving && throttle())
+        return;
+
     Thread * prev = running();
     Thread * next = _scheduler.choose();
 
@@ -314,27 +794,138 @@ void Thread::reschedule()
 }
 
 
+void Thread::batch_begin()
+{
+    lock();
+    _batching[CPU::id()]++;
+    unlock();
+}
+
+
+void Thread::batch_end()
+{
+    lock();
+
+    unsigned int cpu = CPU::id();
+    if(!--_batching[cpu] && _batched[cpu]) {
+        _batched[cpu] = false;
+        reschedule();
+    }
+
+    unlock();
+}
+
+
+// Reschedules "cpu", which gets an IPI if it isn't the current one (see rescheduler())
+void Thread::reschedule(unsigned int cpu)
+{
+    assert(locked()); // locking handled by caller
+
+    if(!smp || (cpu == CPU::id()))
+        reschedule();
+    else {
+        db<Thread>(TRC) << "Thread::reschedule(cpu=" << cpu << ")" << endl;
+        IPI::send(cpu, IPI::RESCHEDULE);
+    }
+}
+
+
+bool Thread::throttle()
+{
+    // A thread that has used up the budget of its Reservation waits for it to be replenished
+    Thread * prev = running();
+    Reservation * r = prev->criterion().reservation();
+    if(!r || (prev->_state != RUNNING) || !r->exhausted(TSC::time_stamp()))
+        return false;
+
+    db<Thread>(TRC) << "Thread::throttle(this=" << prev << ",r=" << r << ")" << endl;
+
+    sleep(&r->_throttled);
+    return true;
+}
+
+
+void Thread::rescheduler(IC::Interrupt_Id i)
+{
+    lock();
+    reschedule();
+    unlock();
+}
+
+
 void Thread::time_slicer(IC::Interrupt_Id i)
 {
     lock();
+    if(Criterion::adaptive)
+        running()->criterion().adapt(true);
+    if(balanced) {
+        TSC::Time_Stamp ts = TSC::time_stamp();
+        if(ts - _balanced >= TSC::Time_Stamp(Traits<Thread>::BALANCE_PERIOD) * TSC::frequency() / 1000000) {
+            _balanced = ts;
+            balance();
+        }
+    }
     reschedule();
     unlock();
 }
 
 
+void Thread::balance()
+{
+    // Called by time_slicer() with the lock held, at _balanced. At most one thread is moved each time
+    Thread * t = _scheduler.balance(CPU::cores(), &weight, &migration_cost);
+    if(t) {
+        db<Thread>(TRC) << "Thread::balance(t=" << t << ",to=" << t->criterion().queue() << ")" << endl;
+
+        reschedule(t->criterion().queue());
+    }
+}
+
+
+TSC::Time_Stamp Thread::weight(Queue::Element * e)
+{
+    // Running threads also weigh what they have run since their dispatch
+    Thread * t = e->object();
+    TSC::Time_Stamp l = t->load(_balanced);
+    return (t->_state == RUNNING) ? l + (_balanced - t->criterion()._statistics.last_thread_dispatch) : l;
+}
+
+
+TSC::Time_Stamp Thread::migration_cost(Queue::Element * e)
+{
+    // Threads dispatched up to MIGRATION_COST ago are taken as cache-hot, so moving them also costs that much
+    TSC::Time_Stamp cost = TSC::Time_Stamp(Traits<Thread>::MIGRATION_COST) * TSC::frequency() / 1000000;
+    return (_balanced - e->object()->criterion()._statistics.last_thread_dispatch < cost) ? cost : 0;
+}
+
+
 void Thread::dispatch(Thread * prev, Thread * next, bool charge)
 {
     // "next" is not in the scheduler's queue anymore. It's already "chosen"
 
+    // RCU readers can't be preempted, so no one on this CPU is in a read-side section
+    RCU::quiescent();
+
     if(charge) {
         if(Criterion::timed)
-            _timer->restart();
+            _timer->restart(next->criterion().quantum());
     }
 
     if(prev != next) {
+        if(Criterion::adaptive && (prev->_state == WAITING)) // blocked before its slice ended
+            prev->criterion().adapt(false);
+
         if(prev->_state == RUNNING)
             prev->_state = READY;
         next->_state = RUNNING;
+        next->_wakeup.run();
+        if(wake_affine)
+            _busy[CPU::id()] = (next->criterion() != IDLE);
+        Governor::dispatch(next->criterion() == IDLE);
+        Energy_Meter::dispatch(&prev->_energy);
+
+        Trace::record(Trace::DISPATCH, prev, next, prev->_state);
+        Log::log("Thread::dispatch(prev=%p,next=%p,state=%d)", prev, next, prev->_state);
 
         db<Thread>(TRC) << "Thread::dispatch(prev=" << prev << ",next=" << next << ")" << endl;
         if(Traits<Thread>::debugged && Traits<Debug>::info) {
@@ -344,12 +935,70 @@ void Thread::dispatch(Thread * prev, Thread * next, bool charge)
         }
         db<Thread>(INF) << "Thread::dispatch:next={" << next << ",ctx=" << *next->_context << "}" << endl;
 
+        if(Criterion::collecting) {
+            // Charge the CPU time since the last dispatch to "prev" (and to this CPU, unless it was idle) and stamp "next"
+            TSC::Time_Stamp ts = TSC::time_stamp();
+            unsigned int cpu = CPU::id();
+            prev->criterion()._statistics.thread_execution_time += ts - prev->criterion()._statistics.last_thread_dispatch;
+            if(Criterion::reserving && prev->criterion().reservation())
+                prev->criterion().reservation()->stop(ts, prev->criterion()._statistics.last_thread_dispatch);
+            if(Criterion::reserving && next->criterion().reservation())
+                next->criterion().reservation()->start(ts);
+            if(balanced) // what it has just run is decayed along with its load from now on
+                prev->criterion()._statistics.load = prev->load(ts) + (ts - prev->criterion()._statistics.last_thread_dispatch);
+            if(prev->criterion() != IDLE)
+                Criterion::Statistics::_cpu_time[cpu] += ts - Criterion::Statistics::_last_dispatch_time[cpu];
+            Criterion::Statistics::_last_dispatch_time[cpu] = ts;
+            next->criterion()._statistics.last_thread_dispatch = ts;
+        }
+
+        if(Criterion::Statistics::virtual_pmu) {
+            // Charge the events counted since the last dispatch on this CPU to "prev", so each thread sees only its own
+            unsigned int cpu = CPU::id();
+            for(unsigned int c = 0; c < Criterion::Statistics::PMU_CHANNELS; c++) {
+                PMU::Count count = PMU::read(c);
+                prev->criterion()._statistics.pmu_count[c] += count - Criterion::Statistics::_last_pmu_count[cpu][c];
+                Criterion::Statistics::_last_pmu_count[cpu][c] = count;
+            }
+        }
+
+        // Architectures that switch the FPU lazily only save it here if "prev" has used it since it was last restored
+        CPU::fpu_switch(&prev->_fpu, &next->_fpu);
+
+        if(tls)
+            CPU::tls(next->_tls);
+
+        // Threads without a Task (e.g. IDLE) run in whatever Address_Space is active, since the system is in all of them
+        if(multitask && next->_task && (next->_task != Task::active()))
+            next->_task->activate();
+
+        // A nested handler may switch to another thread, which must not inherit the IC level raised for it
+        if(Traits<IC>::nested) {
+            prev->_ic_level = IC::level();
+            if(next->_ic_level != prev->_ic_level)
+                IC::level(next->_ic_level);
+        }
+
         // The non-volatile pointer to volatile pointer to a non-volatile context is correct
         // and necessary because of context switches, but here, we are locked() and
         // passing the volatile to switch_context forces it to push prev onto the stack,
         // disrupting the context (it doesn't make a difference for Intel, which already saves
         // parameters on the stack anyway).
+
+        // On SMP, the scheduler lock is held across the switch, since "prev" is already back in
+        // a queue and another CPU could otherwise pick it before its context is saved. Whoever
+        // comes out on the other side releases it: a thread resuming here, right below, or a
+        // brand new one in first_run() (see switched()).
+        if(smp)
+            _switching[CPU::id()] = true;
+
         CPU::switch_context(const_cast<Context **>(&prev->_context), next->_context);
+
+        // Back in the thread that called dispatch(), which takes the lock again for its caller to unlock
+        if(smp) {
+            switched();
+            _lock.acquire();
+        }
     }
 }
 
@@ -358,23 +1007,50 @@ int Thread::idle()
 {
     db<Thread>(TRC) << "Thread::idle(this=" << running() << ")" << endl;
 
-    while(_thread_count > 1) { // someone else besides idle
+    while(_thread_count > CPU::cores()) { // someone else besides idles
         if(Traits<Thread>::trace_idle)
             db<Thread>(TRC) << "Thread::idle(this=" << running() << ")" << endl;
 
+        if(Criterion::migrating) {
+            lock();
+            if(_scheduler.steal()) // idle has the lowest priority, so the stolen thread is dispatched right away
+                reschedule();
+            unlock();
+        }
+
+        // Idle is never in an RCU read-side section, and it is a good place to run the callbacks whose grace is over
+        if(RCU::enabled) {
+            RCU::quiescent();
+            RCU::reclaim();
+        }
+
+        // The MMU has no lock of its own, so only CPU 0 zeroes frames ahead of MMU::calloc()
+        if(CPU::id() == 0)
+            while(MMU::prezero());
+
+        // Tickless idle: stop the periodic tick until the next alarm is due (any other interrupt also ends the sleep)
+        // Alarms are served by CPU 0, so the other CPUs keep ticking
+        if(Alarm::tickless && (CPU::id() == 0)) {
+            CPU::int_disable();
+            Alarm::sleep();
+        }
+
+        Energy_Meter::sleep(&running()->_energy, Timer::sleeping() ? Energy_Meter::TICKLESS : Energy_Meter::HALT);
         CPU::int_enable();
         CPU::halt();
+        Energy_Meter::wake();
     }
 
     CPU::int_disable();
-    db<Thread>(WRN) << "The last thread has exited!" << endl;
-    if(reboot) {
-        db<Thread>(WRN) << "Rebooting the machine ..." << endl;
-        Machine::reboot();
-    } else {
-        db<Thread>(WRN) << "Halting the machine ..." << endl;
-        CPU::halt();
+    if(CPU::id() == 0) {
+        db<Thread>(WRN) << "The last thread has exited!" << endl;
+        if(reboot) {
+            db<Thread>(WRN) << "Rebooting the machine ..." << endl;
+            Machine::reboot();
+        } else
+            db<Thread>(WRN) << "Halting the machine ..." << endl;
     }
+    CPU::halt();
 
     // Some machines will need a little time to actually reboot
     for(;;);
@@ -389,7 +1065,7 @@ __BEGIN_UTIL
 
 volatile CPU::Reg This_Thread::id()
 {
-    return _not_booting ? CPU::Reg(Thread::self()) : CPU::Reg(CPU::id() + 1);
+    return _not_booting[cpu()] ? CPU::Reg(Thread::self()) : CPU::Reg(CPU::id() + 1);
 }
 
 __END_UTIL
@@ -13,16 +13,32 @@ void Thread::init()
 {
     db<Init, Thread>(TRC) << "Thread::init()" << endl;
 
-    Criterion::init();
-
     typedef int (Main)();
 
-    // If EPOS is a library, then adjust the application entry point to __epos_app_entry, which will directly call main().
-    // In this case, _init will have already been called, before Init_Application to construct MAIN's global objects.
-    Main * main = reinterpret_cast<Main *>(__epos_app_entry);
+    if(CPU::id() == 0) {
+        Criterion::init();
+
+        // Pre-populate the stack pool, so the first threads the application creates don't go to the heap
+        if(pooled) {
+            lock();
+            for(unsigned int i = 0; i < Traits<Application>::STACK_POOL; i++)
+                stack_free(new (SYSTEM) char[STACK_SIZE], STACK_SIZE);
+            unlock();
+        }
 
-    new (SYSTEM) Thread(Thread::Configuration(Thread::RUNNING, Thread::MAIN), main);
+        // If EPOS is a library, then adjust the application entry point to __epos_app_entry, which will directly call main().
+        // In this case, _init will have already been called, before Init_Application to construct MAIN's global objects.
+        Main * main = reinterpret_cast<Main *>(__epos_app_entry);
 
+        // In the KERNEL mode, MAIN is the master Task's main()
+        if(multitask) {
+            Task::init();
+            Task::_master->_main = new (SYSTEM) Thread(Thread::Configuration(Thread::RUNNING, Thread::MAIN, STACK_SIZE, Criterion::ANY, false, Task::_master), main);
+        } else
+            new (SYSTEM) Thread(Thread::Configuration(Thread::RUNNING, Thread::MAIN), main);
+    }
+
+    // Each CPU gets its own idle thread, which lands on its own queue under partitioned criteria
     // Idle thread creation does not cause rescheduling (see Thread::constructor_epilogue)
     new (SYSTEM) Thread(Thread::Configuration(Thread::READY, Thread::IDLE), &Thread::idle);
 
@@ -32,9 +48,16 @@ void Thread::init()
     // Letting reschedule() happen during thread creation is also harmless, since MAIN is
     // created first and dispatch won't replace it nor by itself neither by IDLE (which
     // has a lower priority)
-    if(Criterion::timed)
+    if(Criterion::timed && (CPU::id() == 0))
         _timer = new (SYSTEM) Scheduler_Timer(QUANTUM, time_slicer);
 
+    // The other CPUs can make this one reschedule through an IPI (see reschedule(cpu))
+    if(smp) {
+        if(CPU::id() == 0)
+            IPI::handler(IPI::RESCHEDULE, rescheduler);
+        IPI::init();
+    }
+
     // No more interrupts until we reach init_end
     CPU::int_disable();
 
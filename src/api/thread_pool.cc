@@ -0,0 +1,91 @@
+// EPOS Thread Pool Implementation
+
+#include <thread_pool.h>
+
+__BEGIN_SYS
+
+Thread_Pool::Thread_Pool(): _head(0), _tail(0), _slots(JOBS), _pending(0)
+{
+    db<Thread>(TRC) << "Thread_Pool(workers=" << WORKERS << ",jobs=" << JOBS << ") => " << this << endl;
+
+    for(unsigned int i = 0; i < WORKERS; i++) {
+        _workers[i] = new Worker(this);
+        _workers[i]->start();
+    }
+}
+
+
+Thread_Pool::~Thread_Pool()
+{
+    db<Thread>(TRC) << "~Thread_Pool(this=" << this << ")" << endl;
+
+    // A null job tells a worker to finish, after the jobs queued before it
+    for(unsigned int i = 0; i < WORKERS; i++)
+        submit(0);
+
+    for(unsigned int i = 0; i < WORKERS; i++) {
+        _workers[i]->join();
+        delete _workers[i];
+    }
+}
+
+
+void Thread_Pool::submit(Handler * job)
+{
+    db<Thread>(TRC) << "Thread_Pool::submit(this=" << this << ",job=" << job << ")" << endl;
+
+    _slots.p();
+    push(job);
+    _pending.v();
+}
+
+
+bool Thread_Pool::try_submit(Handler * job)
+{
+    db<Thread>(TRC) << "Thread_Pool::try_submit(this=" << this << ",job=" << job << ")" << endl;
+
+    if(!_slots.try_p())
+        return false;
+
+    push(job);
+    _pending.v();
+
+    return true;
+}
+
+
+void Thread_Pool::push(Handler * job)
+{
+    _mutex.lock();
+    _jobs[_tail] = job;
+    _tail = (_tail + 1) % JOBS;
+    _mutex.unlock();
+}
+
+
+Handler * Thread_Pool::pop()
+{
+    _mutex.lock();
+    Handler * job = _jobs[_head];
+    _head = (_head + 1) % JOBS;
+    _mutex.unlock();
+
+    return job;
+}
+
+
+int Thread_Pool::work()
+{
+    for(;;) {
+        _pending.p();
+        Handler * job = pop();
+        _slots.v();
+
+        if(!job)
+            return 0;
+
+        (*job)();
+    }
+}
+
+__END_SYS
@@ -0,0 +1,10 @@
+// EPOS Time Implementation
+
+#include <time.h>
+
+__BEGIN_SYS
+
+Time::Scale Time::_ns;
+Time::Scale Time::_us;
+
+__END_SYS
@@ -0,0 +1,15 @@
+// EPOS Time Initialization
+
+#include <time.h>
+
+__BEGIN_SYS
+
+void Time::init()
+{
+    db<Init>(TRC) << "Time::init(f=" << TSC::frequency() << ")" << endl;
+
+    _ns.calibrate(TSC::frequency(), 1000000000);
+    _us.calibrate(TSC::frequency(), 1000000);
+}
+
+__END_SYS
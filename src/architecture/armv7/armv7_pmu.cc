@@ -1,6 +1,9 @@
 // EPOS ARMv7 PMU Events Declarations
 
 #include <architecture/pmu.h>
+#include <machine/ic.h>
+#include <process.h>
+#include <utility/sampler.h>
 
 #ifdef __cortex_a__
 
@@ -180,6 +183,38 @@ const ARMv7_A_PMU::Event ARMv7_A_PMU::_events[EVENTS] = {
 #endif
 };
 
+ARMv7_A_PMU::Count ARMv7_A_PMU::_periods[CHANNELS];
+
+void ARMv7_A_PMU::sample(Channel channel, Event event, Count period)
+{
+    db<PMU>(TRC) << "PMU::sample(c=" << channel << ",e=" << event << ",p=" << period << ")" << endl;
+
+    if(IC::INT_PMU == IC_Common::UNSUPPORTED_INTERRUPT) {
+        db<PMU>(WRN) << "PMU::sample: the PMU overflow interrupt is not wired on this machine!" << endl;
+        return;
+    }
+
+    // Counters are 32 bits wide and interrupt when they wrap, so each one starts "period" events short of it
+    _periods[channel] = period;
+    config(channel, event, INT);
+    write(channel, -period);
+    clear_overflow(channel);
+
+    IC::int_vector(IC::INT_PMU, int_handler);
+    IC::enable(IC::INT_PMU);
+}
+
+void ARMv7_A_PMU::int_handler(unsigned int i)
+{
+    Reg32 overflows = pmovsr() & pmintenset();
+    for(Channel c = 0; c < CHANNELS; c++)
+        if(overflows & (1 << c)) {
+            Sampler::record(CPU::int_pc(), Thread::self(), c);
+            write(c, -_periods[c]);
+        }
+    pmovsr(overflows);
+}
+
 __END_SYS
 
 #endif
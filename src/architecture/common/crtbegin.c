@@ -5,6 +5,10 @@ typedef void (*fptr) (void);
 static fptr __CTOR_LIST__[1] __attribute__ ((used, section(".init_array"), aligned(sizeof(fptr)))) = { (fptr)(-1) };
 static fptr __DTOR_LIST__[1] __attribute__ ((section(".fini_array"), aligned(sizeof(fptr)))) = { (fptr)(-1) };
 
+/* Make sure .tdata and .tbss exist, so the TLS bounds eposcc defines from them always resolve (see Thread::tls_alloc()) */
+static __thread long __TDATA_ANCHOR__ __attribute__ ((used)) = -1;
+static __thread long __TBSS_ANCHOR__ __attribute__ ((used));
+
 static void __do_global_dtors_aux()
 {
     fptr * p;
@@ -14,6 +14,12 @@ void CPU::init()
     _cpu_current_clock = System::info()->tm.cpu_clock;
     _bus_clock = System::info()->tm.bus_clock;
 
+    // Every CPU must have the same PAT, since they share the page tables
+    if(pat()) {
+        wrmsr(IA32_PAT, PAT_TYPES);
+        flush_tlb();
+    }
+
     // Initialize the MMU
     if(Traits<MMU>::enabled)
         MMU::init();
@@ -1,11 +1,56 @@
 // EPOS IA32 MMU Mediator Implementation
 
 #include <architecture/ia32/ia32_mmu.h>
+#include <machine/ipi.h>
 
 __BEGIN_SYS
 
 // Class attributes
 MMU::List MMU::_free[colorful * COLORS + 1];
+MMU::Frame_Allocator MMU::_frames;
+unsigned char MMU::_shares[cow ? FRAMES : 1];
+MMU::Phy_Addr MMU::_zeroed[ZEROED ? ZEROED : 1];
+volatile unsigned int MMU::_zeroed_count;
 MMU::Page_Directory * MMU::_master;
 
+// Class methods
+void MMU::shootdown()
+{
+    if(multicore)
+        IPI::shootdown();
+    else
+        flush_tlb();
+}
+
+// Frames are zeroed with interrupts enabled, once out of the allocator and before they are in the pool, so the idle
+// thread can be preempted at any time
+bool MMU::prezero()
+{
+    if(!ZEROED || (_zeroed_count >= ZEROED))
+        return false;
+
+    bool ie = CPU::int_enabled();
+    CPU::int_disable();
+    Phy_Addr phy(false);
+    if(allocable(WHITE))
+        phy = alloc(1, WHITE);
+    if(ie)
+        CPU::int_enable();
+    if(!phy)
+        return false;
+
+    memset(phy2log(phy), 0, sizeof(Frame));
+
+    CPU::int_disable();
+    bool room = (_zeroed_count < ZEROED);
+    if(room)
+        _zeroed[_zeroed_count++] = phy;
+    else
+        free(phy);
+    if(ie)
+        CPU::int_enable();
+
+    return room;
+}
+
 __END_SYS
@@ -24,6 +24,9 @@ void MMU::init()
     // storage after the following is executed, but it will remain alive
     // This only works because the _free.insert_merging() only
     // touches the first page of each chunk and INIT is not there
+    // (the buddy allocator only carves chunks given through white_free() as they are allocated, from their top)
+    if(buddy)
+        _frames.base(phy2log(RAM_BASE));
 
     if(colorful) {
         int f1b = si->pmm.free1_base;
@@ -66,7 +69,7 @@ void MMU::init()
                 f3b = f3t = 0;
             }
         }
-        if((size > 0) || (_free[WHITE].grouped_size() * MMU::PAGE_SIZE < Traits<System>::HEAP_SIZE))
+        if((size > 0) || (grouped_size(WHITE) * MMU::PAGE_SIZE < Traits<System>::HEAP_SIZE))
             db<Init, MMU>(ERR) << "MMU::int: System's heap size (Traits<System>::HEAP_SIZE=" << Traits<System>::HEAP_SIZE << ") is larger than memory!" << endl;
 
         // Insert the remaining free memory into the _free[color] lists
@@ -89,11 +92,23 @@ void MMU::init()
         }
     } else {
         // Insert all free memory into the _free[WHITE] list
-        free(si->pmm.free1_base, pages(si->pmm.free1_top - si->pmm.free1_base));
-        free(si->pmm.free2_base, pages(si->pmm.free2_top - si->pmm.free2_base));
-        free(si->pmm.free3_base, pages(si->pmm.free3_top - si->pmm.free3_base));
+        white_free(si->pmm.free1_base, pages(si->pmm.free1_top - si->pmm.free1_base));
+        white_free(si->pmm.free2_base, pages(si->pmm.free2_top - si->pmm.free2_base));
+        white_free(si->pmm.free3_base, pages(si->pmm.free3_top - si->pmm.free3_base));
     }
 
+    // Large pages (see Chunk) need Page Size Extensions
+    if(large_pages)
+        CPU::cr4(CPU::cr4() | CPU::CR4_PSE);
+
+    // Copy-on-write pages are read-only, so writes to them must fault in ring 0 as well
+    if(cow)
+        CPU::cr0(CPU::cr0() | CPU::CR0_WP);
+
+    // SETUP marks the SYSTEM mappings, which are shared by all address spaces, as global (see Setup::setup_sys_pt())
+    if(global_pages)
+        CPU::cr4(CPU::cr4() | CPU::CR4_PGE);
+
     // Remember the master page directory (created during SETUP)
     _master = current();
     db<Init, MMU>(INF) << "MMU::master page directory=" << _master << endl;
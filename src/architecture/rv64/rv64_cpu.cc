@@ -7,6 +7,7 @@ __BEGIN_SYS
 
 unsigned int CPU::_cpu_clock;
 unsigned int CPU::_bus_clock;
+CPU::FPU_Context * CPU::_fpu_current[Traits<Build>::CPUS];
 
 void CPU::Context::save() volatile
 {
@@ -44,6 +45,100 @@ void CPU::Context::save() volatile
         "       ret                             \n");
 }
 
+void CPU::fpu_save(FPU_Context * fpu)
+{
+    ASM(
+        "       fsd     f0,     0(%0)           \n"
+        "       fsd     f1,     8(%0)           \n"
+        "       fsd     f2,    16(%0)           \n"
+        "       fsd     f3,    24(%0)           \n"
+        "       fsd     f4,    32(%0)           \n"
+        "       fsd     f5,    40(%0)           \n"
+        "       fsd     f6,    48(%0)           \n"
+        "       fsd     f7,    56(%0)           \n"
+        "       fsd     f8,    64(%0)           \n"
+        "       fsd     f9,    72(%0)           \n"
+        "       fsd     f10,   80(%0)           \n"
+        "       fsd     f11,   88(%0)           \n"
+        "       fsd     f12,   96(%0)           \n"
+        "       fsd     f13,  104(%0)           \n"
+        "       fsd     f14,  112(%0)           \n"
+        "       fsd     f15,  120(%0)           \n"
+        "       fsd     f16,  128(%0)           \n"
+        "       fsd     f17,  136(%0)           \n"
+        "       fsd     f18,  144(%0)           \n"
+        "       fsd     f19,  152(%0)           \n"
+        "       fsd     f20,  160(%0)           \n"
+        "       fsd     f21,  168(%0)           \n"
+        "       fsd     f22,  176(%0)           \n"
+        "       fsd     f23,  184(%0)           \n"
+        "       fsd     f24,  192(%0)           \n"
+        "       fsd     f25,  200(%0)           \n"
+        "       fsd     f26,  208(%0)           \n"
+        "       fsd     f27,  216(%0)           \n"
+        "       fsd     f28,  224(%0)           \n"
+        "       fsd     f29,  232(%0)           \n"
+        "       fsd     f30,  240(%0)           \n"
+        "       fsd     f31,  248(%0)           \n"
+        "       frcsr   t0                      \n"
+        "       sd      t0,  256(%0)            \n" : : "r"(fpu) : "t0", "memory");
+}
+
+void CPU::fpu_restore(const FPU_Context * fpu)
+{
+    ASM(
+        "       fld     f0,     0(%0)           \n"
+        "       fld     f1,     8(%0)           \n"
+        "       fld     f2,    16(%0)           \n"
+        "       fld     f3,    24(%0)           \n"
+        "       fld     f4,    32(%0)           \n"
+        "       fld     f5,    40(%0)           \n"
+        "       fld     f6,    48(%0)           \n"
+        "       fld     f7,    56(%0)           \n"
+        "       fld     f8,    64(%0)           \n"
+        "       fld     f9,    72(%0)           \n"
+        "       fld     f10,   80(%0)           \n"
+        "       fld     f11,   88(%0)           \n"
+        "       fld     f12,   96(%0)           \n"
+        "       fld     f13,  104(%0)           \n"
+        "       fld     f14,  112(%0)           \n"
+        "       fld     f15,  120(%0)           \n"
+        "       fld     f16,  128(%0)           \n"
+        "       fld     f17,  136(%0)           \n"
+        "       fld     f18,  144(%0)           \n"
+        "       fld     f19,  152(%0)           \n"
+        "       fld     f20,  160(%0)           \n"
+        "       fld     f21,  168(%0)           \n"
+        "       fld     f22,  176(%0)           \n"
+        "       fld     f23,  184(%0)           \n"
+        "       fld     f24,  192(%0)           \n"
+        "       fld     f25,  200(%0)           \n"
+        "       fld     f26,  208(%0)           \n"
+        "       fld     f27,  216(%0)           \n"
+        "       fld     f28,  224(%0)           \n"
+        "       fld     f29,  232(%0)           \n"
+        "       fld     f30,  240(%0)           \n"
+        "       fld     f31,  248(%0)           \n"
+        "       ld      t0,  256(%0)            \n"
+        "       fscsr   t0                      \n" : : "r"(fpu) : "t0", "memory");
+}
+
+// Called on illegal instruction exceptions, returns true if the exception was caused by the FPU being
+// off, in which case the running thread's FPU registers are restored and the instruction must be retried
+bool CPU::fpu_trap()
+{
+    if(!lazy_fpu || ((mstatus() & FS) != FS_OFF))
+        return false;
+
+    mstatuss(FS_INIT);
+    if(_fpu_current[id()])
+        fpu_restore(_fpu_current[id()]);
+    mstatusc(FS);
+    mstatuss(FS_CLEAN);
+
+    return true;
+}
+
 // Context load does not verify if interrupts were previously enabled by the Context's constructor
 // We are setting mstatus to MPP | MPIE, therefore, interrupts will be enabled only after mret
 void CPU::Context::load() const volatile
@@ -0,0 +1,23 @@
+// EPOS RISC-V 64 MMU Mediator Implementation
+
+#include <architecture/rv64/rv64_mmu.h>
+#include <machine/ipi.h>
+
+__BEGIN_SYS
+
+// Class attributes
+Sv39_MMU::List Sv39_MMU::_free;
+Sv39_MMU::Page_Directory * Sv39_MMU::_master;
+Bitmap<Sv39_MMU::ASIDS> Sv39_MMU::_asids;
+unsigned int Sv39_MMU::_asid_max;
+
+// Class methods
+void Sv39_MMU::shootdown()
+{
+    if(multicore)
+        IPI::shootdown();
+    else
+        flush_tlb();
+}
+
+__END_SYS
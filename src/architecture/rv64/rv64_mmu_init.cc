@@ -0,0 +1,39 @@
+// EPOS RISC-V 64 MMU Mediator Initialization
+
+#include <architecture/mmu.h>
+#include <system/memory_map.h>
+
+extern "C" char _end;
+
+__BEGIN_SYS
+
+void Sv39_MMU::init()
+{
+    db<Init, MMU>(TRC) << "MMU::init()" << endl;
+
+    db<Init, MMU>(INF) << "MMU::init::bss.e=" << reinterpret_cast<void *>(&_end) << ",free.t=" << reinterpret_cast<void *>(Memory_Map::FREE_TOP) << endl;
+
+    // Insert all free memory into the _free list (allocations start from the end, far from INIT)
+    unsigned long base = align_page(reinterpret_cast<unsigned long>(&_end));
+    free(base, pages(indexes(Memory_Map::FREE_TOP) - base));
+
+    // Create the master page directory, which maps RAM and I/O onto themselves with global 1 GB pages
+    _master = calloc(1);
+    for(unsigned long addr = MIO_BASE & ~((1UL << ROOT_SHIFT) - 1); addr < MIO_TOP; addr += 1UL << ROOT_SHIFT)
+        (*_master)[addr >> ROOT_SHIFT] = phy2pte(addr, Page_Flags::SYS | Page_Flags::G | Page_Flags::IO);
+    for(unsigned long addr = RAM_BASE & ~((1UL << ROOT_SHIFT) - 1); addr < RAM_TOP; addr += 1UL << ROOT_SHIFT)
+        (*_master)[addr >> ROOT_SHIFT] = phy2pte(addr, Page_Flags::SYS | Page_Flags::G);
+    db<Init, MMU>(INF) << "MMU::master page directory=" << _master << endl;
+
+    // Find out how many ASID bits are implemented by writing ones to all of them and reading them back
+    if(asids) {
+        CPU::satp(SATP_SV39 | (ASID_MASK << ASID_SHIFT) | (CPU::Reg(_master) >> PAGE_SHIFT));
+        unsigned int max = (CPU::satp() >> ASID_SHIFT) & ASID_MASK;
+        _asid_max = (max < ASIDS - 1) ? max : ASIDS - 1;
+        db<Init, MMU>(INF) << "MMU::asids=" << _asid_max << endl;
+    }
+
+    pd(_master);
+}
+
+__END_SYS
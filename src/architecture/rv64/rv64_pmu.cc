@@ -1,6 +1,9 @@
 // EPOS RISC-V 64 PMU Mediator
 
 #include <architecture/rv64/rv64_pmu.h>
+#include <machine/ic.h>
+#include <process.h>
+#include <utility/sampler.h>
 
 __BEGIN_SYS
 
@@ -70,4 +73,35 @@ const RV32_PMU::Event RV32_PMU::_events[EVENTS] = {
     INTEGER_MULTIPLICATION_INTERLOCK            // ARCHITECTURE_DEPENDENT_EVENT55
 };
 
+RV64_PMU::Count RV64_PMU::_periods[CHANNELS];
+
+void RV64_PMU::sample(Channel channel, Event event, Count period)
+{
+    db<PMU>(TRC) << "PMU::sample(c=" << channel << ",e=" << event << ",p=" << period << ")" << endl;
+
+    if(channel < FIXED) {
+        db<PMU>(WRN) << "PMU::sample: fixed channels cannot interrupt on overflows!" << endl;
+        return;
+    }
+
+    // Counters interrupt when they wrap, so each one starts "period" events short of it
+    _periods[channel] = period;
+    write(channel, -period);
+    config(channel, event, INT);
+
+    IC::int_vector(IC::INT_PMU, int_handler);
+    IC::enable(IC::INT_PMU);
+}
+
+void RV64_PMU::int_handler(unsigned int i)
+{
+    for(Channel c = FIXED; c < CHANNELS; c++)
+        if(_periods[c] && overflow(c)) {
+            Sampler::record(CPU::int_pc(), Thread::self(), c);
+            write(c, -_periods[c]);
+            clear_overflow(c);
+        }
+    CPU::mipc(CPU::LCOFI); // LCOFIP is only cleared by software
+}
+
 __END_SYS
@@ -17,6 +17,10 @@ private:
 
 public:
     Init_Application() {
+        // In the KERNEL mode, applications run after Init_End and can't write to System_Info
+        if(Traits<System>::mode != Traits<Build>::KERNEL)
+            System::profile(System_Info::Boot_Profile::INIT_APPLICATION);
+
         db<Init>(TRC) << "Init_Application()" << endl;
 
         // Initialize Application's heap
@@ -3,6 +3,7 @@
 #include <architecture.h>
 #include <system.h>
 #include <process.h>
+#include <utility/trace.h>
 
 __BEGIN_SYS
 
@@ -14,13 +15,25 @@ class Init_End
 {
 public:
     Init_End() {
+        System::profile(System_Info::Boot_Profile::INIT_END);
+
         db<Init>(TRC) << "Init_End()" << endl;
 
+        if(Traits<Init>::profiled)
+            profile();
+
         if(!Traits<System>::multithread) {
             CPU::int_enable();
             return;
         }
 
+        // Let the other CPUs dispatch their first threads too (see Init_System::secondary())
+        if(Traits<System>::multicore) {
+            CPU::smp_barrier();
+            Trace::sync();
+        }
+
+        // Only CPU 0's boot stack (the first one) is freed, since the others might still be using theirs
         if(Memory_Map::BOOT_STACK != Memory_Map::NOT_USED)
             MMU::free(Memory_Map::BOOT_STACK, MMU::pages(Traits<Machine>::STACK_SIZE));
 
@@ -38,8 +51,33 @@ public:
         if(Traits<Timer>::enabled)
             Timer::reset();
 
+        if(Traits<Thread>::tls)
+            CPU::tls(first->_tls);
+
         first->_context->load();
     }
+
+private:
+    // Prints the time stamp of each boot phase reached and how long it took, up to the next one
+    static void profile() {
+        static const char * const names[] = { "SETUP", "INIT_SYSTEM", "HEAP", "MACHINE", "SYSTEM", "INIT_APPLICATION", "INIT_END" };
+        const unsigned long long * stamp = System::info()->bp.stamp;
+        const unsigned long long hz = TSC::frequency();
+
+        OStream cout;
+        cout << "Boot profile (TSC at " << hz << " Hz):" << endl;
+        for(unsigned int i = 0; i < System_Info::Boot_Profile::PHASES; i++) {
+            if(!stamp[i]) // not reached or taken before the TSC started
+                continue;
+            cout << "  " << names[i] << ": ts=" << stamp[i];
+            unsigned int j = i + 1;
+            while((j < System_Info::Boot_Profile::PHASES) && !stamp[j])
+                j++;
+            if((j < System_Info::Boot_Profile::PHASES) && (stamp[j] >= stamp[i]))
+                cout << ", " << (stamp[j] - stamp[i]) * 1000000 / hz << " us";
+            cout << endl;
+        }
+    }
 };
 
 Init_End init_end;
@@ -5,6 +5,8 @@
 #include <memory.h>
 #include <system.h>
 #include <process.h>
+#include <monitor.h>
+#include <utility/trace.h>
 
 __BEGIN_SYS
 
@@ -15,6 +17,13 @@ private:
 
 public:
     Init_System() {
+        if(CPU::id() != 0) {
+            secondary();
+            return;
+        }
+
+        System::profile(System_Info::Boot_Profile::INIT_SYSTEM);
+
         db<Init>(TRC) << "Init_System()" << endl;
 
         db<Init>(INF) << "Init:si=" << *System::info() << endl;
@@ -22,6 +31,7 @@ public:
         db<Init>(INF) << "Initializing the architecture: " << endl;
         CPU::init();
 
+        System::profile(System_Info::Boot_Profile::HEAP);
         db<Init>(INF) << "Initializing system's heap: " << endl;
         if(Traits<System>::multiheap) {
             System::_heap_segment = new (&System::_preheap[0]) Segment(HEAP_SIZE, Segment::Flags::SYS);
@@ -36,27 +46,79 @@ public:
         } else
             System::_heap = new (&System::_preheap[0]) Heap(MMU::alloc(MMU::pages(HEAP_SIZE)), HEAP_SIZE);
 
+        System::profile(System_Info::Boot_Profile::MACHINE);
         db<Init>(INF) << "Initializing the machine: " << endl;
         Machine::init();
 
+        System::profile(System_Info::Boot_Profile::SYSTEM);
         db<Init>(INF) << "Initializing system abstractions: " << endl;
         System::init();
 
         // Randomize the Random Numbers Generator's seed
         if(Traits<Random>::enabled) {
             db<Init>(INF) << "Randomizing the Random Numbers Generator's seed." << endl;
-            if(Traits<TSC>::enabled)
+            bool seeded = false;
+#ifdef __TRNG_H
+            if(Traits<TRNG>::enabled) {
+                Random::seed(TRNG::random());
+                seeded = true;
+            }
+#endif
+            if(!seeded && Traits<TSC>::enabled) {
                 Random::seed(TSC::time_stamp());
+                seeded = true;
+            }
 
-            if(!Traits<TSC>::enabled)
+            if(!seeded)
                 db<Init>(WRN) << "Due to lack of entropy, Random is a pseudo random numbers generator!" << endl;
         }
 
+        // Release the other CPUs (see secondary()) and wait for them to bring up their own units
+        if(Traits<System>::multicore) {
+            CPU::smp_barrier();
+            CPU::smp_barrier();
+        }
+
         // Initialization continues at init_end
     }
+
+    // The other CPUs wait for CPU 0 to initialize the system and then bring up their local units (e.g. their interrupt
+    // controller contexts and their timers) and their idle threads. Then they wait for CPU 0 to reach Init_End and
+    // dispatch their first threads just like it does there.
+    static void secondary() {
+        CPU::smp_barrier();
+
+        db<Init>(TRC) << "Init_System(cpu=" << CPU::id() << ")" << endl;
+
+        CPU::init();
+        Machine::init();
+        if(Traits<Thread>::enabled)
+            Thread::init();
+        if(Traits<Monitor>::enabled)
+            Monitor::init();
+
+        CPU::smp_barrier();
+        CPU::smp_barrier(); // Init_End
+        Trace::sync();
+
+        Thread * first = Thread::self();
+
+        db<Init, Thread>(INF) << "Dispatching the first thread on CPU " << CPU::id() << ": " << first << endl;
+
+        if(Traits<Timer>::enabled)
+            Timer::reset();
+
+        if(Traits<Thread>::tls)
+            CPU::tls(first->_tls);
+
+        first->_context->load();
+    }
 };
 
 // Global object "init_system" must be constructed first.
 Init_System init_system;
 
 __END_SYS
+
+// Machines that keep the other CPUs out of the global constructors (e.g. SiFive-U) send them here from SETUP
+extern "C" { void _init_secondary() { EPOS::S::Init_System::secondary(); } }
@@ -0,0 +1,93 @@
+// EPOS Inter-processor Messages Implementation
+
+#include <machine/ipi.h>
+
+__BEGIN_SYS
+
+// Class attributes
+IPI::Handler IPI::_handlers[IPI::MESSAGES];
+Atomic<unsigned int> IPI::_pending[IPI::CPUS];
+Atomic<IPI::CPU_Set> IPI::_online;
+Atomic<unsigned int> IPI::_shooting;
+Atomic<int> IPI::_acks;
+
+// Class methods
+void IPI::send(unsigned int cpu, const Message & m)
+{
+    db<IC>(TRC) << "IPI::send(cpu=" << cpu << ",m=" << m << ")" << endl;
+
+    // Only the first message pending raises the interrupt, the others are served along with it
+    if(!_pending[cpu].fetch_or(1U << m, ACQ_REL))
+        IC::ipi(cpu, IC::INT_RESCHEDULER);
+}
+
+void IPI::multicast(CPU_Set cpus, const Message & m)
+{
+    for(unsigned int cpu = 0; cpus; cpu++, cpus >>= 1)
+        if(cpus & 1)
+            send(cpu, m);
+}
+
+void IPI::shootdown()
+{
+    CPU::flush_tlb();
+
+    if(!multicore || !others())
+        return;
+
+    db<IC>(TRC) << "IPI::shootdown(others=" << others() << ")" << endl;
+
+    // One shootdown at a time, since they share _acks, meanwhile serving those of other CPUs that might wait on us
+    while(_shooting.exchange(1, ACQUIRE))
+        flush();
+
+    CPU_Set cpus = others();
+    int n = 0;
+    for(CPU_Set s = cpus; s; s >>= 1)
+        n += s & 1;
+    _acks.store(n, RELAXED);
+    multicast(cpus, TLB_SHOOTDOWN);
+
+    while(_acks.load(ACQUIRE))
+        flush();
+
+    _shooting.store(0, RELEASE);
+}
+
+// Serves a TLB_SHOOTDOWN pending for this CPU, if any, even if its interrupt wasn't taken yet
+void IPI::flush()
+{
+    unsigned int bit = 1U << TLB_SHOOTDOWN;
+    if(_pending[CPU::id()].fetch_and(~bit, ACQUIRE) & bit) {
+        CPU::flush_tlb();
+        _acks.fetch_sub(1, RELEASE);
+    }
+}
+
+void IPI::dispatch(IC::Interrupt_Id i)
+{
+    unsigned int messages = _pending[CPU::id()].exchange(0, ACQUIRE);
+
+    if(messages & (1U << TLB_SHOOTDOWN)) {
+        CPU::flush_tlb();
+        _acks.fetch_sub(1, RELEASE);
+        messages &= ~(1U << TLB_SHOOTDOWN);
+    }
+
+    for(unsigned int m = 0; messages; m++, messages >>= 1)
+        if((messages & 1) && _handlers[m])
+            _handlers[m](i);
+}
+
+void IPI::init()
+{
+    db<Init, IC>(TRC) << "IPI::init()" << endl;
+
+    if(CPU::id() == 0)
+        IC::int_vector(IC::INT_RESCHEDULER, dispatch);
+    IC::enable(IC::INT_RESCHEDULER);
+
+    _online.fetch_or(1U << CPU::id(), RELEASE);
+}
+
+__END_SYS
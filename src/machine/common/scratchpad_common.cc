@@ -3,10 +3,38 @@
 #include <utility/heap.h>
 #include <memory.h>
 #include <machine/scratchpad.h>
+#include <system.h>
 
 __BEGIN_SYS
 
 Segment * Scratchpad_Base::_segment;
 Heap * Scratchpad_Base::_heap;
 
+void * Scratchpad_Base::alloc(unsigned int bytes)
+{
+    void * ptr = _heap ? _heap->try_alloc(bytes) : 0;
+    if(!ptr) {
+        if(_heap)
+            db<Scratchpad>(WRN) << "Scratchpad::alloc(bytes=" << bytes << "): no room left, using the system heap" << endl;
+        ptr = System::heap()->alloc(bytes);
+    }
+
+    return ptr;
+}
+
 __END_SYS
+
+// Allocation tag, as in "new (SCRATCHPAD)"
+#ifdef __SCRATCHPAD_H
+typedef _SYS::Scratchpad Scratchpad_Allocation;
+#else
+typedef _SYS::Scratchpad_Base Scratchpad_Allocation;
+#endif
+
+void * operator new(size_t bytes, const EPOS::Scratchpad_Allocator & allocator) {
+    return Scratchpad_Allocation::alloc(bytes);
+}
+
+void * operator new[](size_t bytes, const EPOS::Scratchpad_Allocator & allocator) {
+    return Scratchpad_Allocation::alloc(bytes);
+}
@@ -8,5 +8,9 @@ __BEGIN_SYS
 Serial_Display::Engine Serial_Display::_engine(UNIT);
 int Serial_Display::_line;
 int Serial_Display::_column;
+char Serial_Display::_buffer[];
+unsigned int Serial_Display::_head;
+unsigned int Serial_Display::_tail;
+volatile int Serial_Display::_lock;
 
 __END_SYS
@@ -0,0 +1,171 @@
+// EPOS ARM Cortex FPGA Mediator Implementation
+
+#include <system/config.h>
+
+#ifdef __FPGA_H
+
+#include <machine/machine.h>
+#include <machine/fpga.h>
+#include <synchronizer.h>
+
+__BEGIN_SYS
+
+// Class attributes
+AXI_DMA * FPGA::_dma;
+IC::Interrupt_Id FPGA::_interrupt;
+FPGA::DMA_Buffer * FPGA::_dma_buf;
+FPGA::SG_Desc * FPGA::_ring;
+FPGA::Block FPGA::_blocks[BLOCKS];
+unsigned char FPGA::_state[BLOCKS];
+unsigned int FPGA::_head;
+unsigned int FPGA::_next;
+unsigned int FPGA::_tail;
+Semaphore * FPGA::_ready;
+FPGA::Statistics FPGA::_statistics;
+volatile int FPGA::_lock;
+
+// Methods
+void FPGA::reset()
+{
+    db<FPGA>(TRC) << "FPGA::reset()" << endl;
+
+    if(_ready)
+        delete _ready;
+    _ready = new (SYSTEM) Semaphore(0);
+
+    bool ie = lock();
+
+    _dma->reset();
+
+    for(unsigned int i = 0; i < BLOCKS; i++) {
+        _ring[i].next = phy(&_ring[(i + 1) % BLOCKS]);
+        _ring[i].next_msb = 0;
+        _ring[i].addr = phy(_blocks[i]._data);
+        _ring[i].addr_msb = 0;
+        _ring[i].control = BLOCK_SIZE;
+        _ring[i].status = 0;
+        _state[i] = CHIP;
+    }
+
+    // Nothing cached for the ring or the blocks may be written back over what the DMA writes
+    _dma_buf->flush();
+
+    _head = 0;
+    _next = 0;
+    _tail = BLOCKS - 1;
+
+    _dma->start(phy(&_ring[_head]), phy(&_ring[_tail]), IRQ_THRESHOLD, IRQ_DELAY);
+
+    unlock(ie);
+}
+
+FPGA::Block * FPGA::receive()
+{
+    _ready->p();
+
+    bool ie = lock();
+    Block * b = &_blocks[_next];
+    _state[_next] = HOST;
+    _next = (_next + 1) % BLOCKS;
+    unlock(ie);
+
+    // Lines the core may have prefetched while the DMA was writing the block are dropped
+    _dma_buf->invalidate(b->_data, b->_size);
+
+    db<FPGA>(TRC) << "FPGA::receive() => " << *b << endl;
+
+    return b;
+}
+
+void FPGA::free(Block * b)
+{
+    db<FPGA>(TRC) << "FPGA::free(b=" << *b << ")" << endl;
+
+    // Whatever the consumer left in the cache is dropped, so it won't be written back over the next data
+    _dma_buf->invalidate(b->_data, BLOCK_SIZE);
+
+    bool ie = lock();
+
+    _state[b - _blocks] = DONE;
+
+    unsigned int tail = _tail;
+    for(unsigned int i = (_tail + 1) % BLOCKS; _state[i] == DONE; i = (i + 1) % BLOCKS) {
+        _ring[i].control = BLOCK_SIZE;
+        _ring[i].status = 0;
+        _dma_buf->clean(&_ring[i], sizeof(SG_Desc));
+        _state[i] = CHIP;
+        _tail = i;
+    }
+
+    if(_tail != tail) {
+        if(_dma->status() & AXI_DMA::IDLE)
+            _statistics.stalls++;
+        _dma->tail(phy(&_ring[_tail]));
+    }
+
+    unlock(ie);
+}
+
+void FPGA::handle_int()
+{
+    Reg32 status = _dma->acknowledge();
+
+    if(status & AXI_DMA::ERRORS) {
+        db<FPGA>(WRN) << "FPGA::handle_int: DMA halted on error (status=" << hex << status << dec << ")!" << endl;
+        _statistics.errors++;
+    }
+
+    unsigned int ready = 0;
+
+    bool ie = lock();
+    while(_state[_head] == CHIP) {
+        SG_Desc * desc = &_ring[_head];
+        _dma_buf->invalidate(desc, sizeof(SG_Desc));
+        if(!(desc->status & SG_Desc::CMPLT))
+            break;
+
+        Block * b = &_blocks[_head];
+        b->_size = desc->status & SG_Desc::TRANSFERRED;
+        b->_last = desc->status & SG_Desc::RXEOF;
+        _state[_head] = FULL;
+        _head = (_head + 1) % BLOCKS;
+
+        _statistics.blocks++;
+        _statistics.bytes += b->_size;
+        ready++;
+    }
+    unlock(ie);
+
+    // One wake-up per block, so consumers can't miss blocks completed by the same interrupt
+    while(ready--)
+        _ready->v();
+}
+
+void FPGA::int_handler(IC::Interrupt_Id interrupt)
+{
+    if(interrupt == _interrupt)
+        handle_int();
+}
+
+bool FPGA::lock()
+{
+    bool ie = CPU::int_enabled();
+    CPU::int_disable();
+    if(Traits<Build>::CPUS > 1)
+        while(CPU::tsl(_lock));
+    return ie;
+}
+
+void FPGA::unlock(bool ie)
+{
+    if(Traits<Build>::CPUS > 1) {
+        CPU::fence();
+        _lock = 0;
+    }
+    if(ie)
+        CPU::int_enable();
+}
+
+__END_SYS
+
+#endif
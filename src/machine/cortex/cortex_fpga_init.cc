@@ -0,0 +1,49 @@
+// EPOS ARM Cortex FPGA Mediator Initialization
+
+#include <system/config.h>
+
+#ifdef __FPGA_H
+
+#include <machine/machine.h>
+#include <machine/fpga.h>
+#include <system.h>
+
+__BEGIN_SYS
+
+void FPGA::init()
+{
+    db<Init, FPGA>(TRC) << "FPGA::init()" << endl;
+
+    _dma = reinterpret_cast<AXI_DMA *>(Memory_Map::AXI_DMA_BASE);
+    _interrupt = IC::irq2int((PL_IRQ < 8) ? GIC::IRQ_PL0 + PL_IRQ : GIC::IRQ_PL8 + PL_IRQ - 8);
+
+    if(!(_dma->status() & AXI_DMA::SG_INCLD)) {
+        db<Init, FPGA>(WRN) << "FPGA::init: no scatter-gather AXI DMA at " << reinterpret_cast<void *>(_dma) << "!" << endl;
+        return;
+    }
+
+    // Ring and blocks, in this order (descriptors take whole lines and pages are aligned to them)
+    _dma_buf = new (SYSTEM) DMA_Buffer(DMA_BUFFER_SIZE);
+    Log_Addr log = _dma_buf->log_address();
+
+    _ring = log;
+    log += RING_SIZE;
+
+    for(unsigned int i = 0; i < BLOCKS; i++) {
+        _blocks[i]._data = log;
+        _blocks[i]._size = 0;
+        _blocks[i]._last = false;
+        log += BLOCK_SIZE;
+    }
+
+    db<Init, FPGA>(INF) << "FPGA::init: dma=" << reinterpret_cast<void *>(_dma) << ",irq=" << _interrupt << ",buf=" << *_dma_buf << endl;
+
+    IC::int_vector(_interrupt, &int_handler);
+    IC::enable(_interrupt);
+
+    reset();
+}
+
+__END_SYS
+
+#endif
@@ -2,12 +2,61 @@
 
 #include <machine/ic.h>
 #include <machine/gpio.h>
+#include <process.h>
+#include <synchronizer.h>
 
 #ifdef __GPIO_H
 
 __BEGIN_SYS
 
 GPIO * GPIO::_gpios[PORTS][8];
+Thread * GPIO::_deliverer;
+Semaphore * GPIO::_pending;
+volatile unsigned int GPIO::_batch;
+
+void GPIO::start()
+{
+    if(!_deliverer) {
+        _pending = new (SYSTEM) Semaphore(0);
+        _deliverer = new (SYSTEM) Thread(Thread::Configuration(Thread::READY, Thread::Criterion(Thread::HIGH)), &deliver);
+    }
+}
+
+// Runs in interrupt context. The first edge of a batch and the one that fills it each wake the deliverer up.
+void GPIO::record()
+{
+    Event e;
+    e.time = TSC::time_stamp();
+    e.level = get();
+    if(!_events.insert(e))
+        _lost++;
+
+    unsigned int batch = ++_batch;
+    if((batch == 1) || (batch == BATCH))
+        _pending->v();
+}
+
+int GPIO::deliver()
+{
+    for(;;) {
+        _pending->p();
+        if(LATENCY)
+            _pending->p(Microsecond(LATENCY));
+
+        CPU::int_disable();
+        _batch = 0;
+        CPU::int_enable();
+
+        for(unsigned int port = 0; port < PORTS; port++)
+            for(unsigned int pin = 0; pin < 8; pin++) {
+                GPIO * gpio = _gpios[port][pin];
+                if(gpio && !gpio->_events.empty())
+                    gpio->notify();
+            }
+    }
+
+    return 0;
+}
 
 void GPIO::int_handler(IC::Interrupt_Id i)
 {
@@ -24,8 +73,12 @@ void GPIO::eoi(IC::Interrupt_Id i)
     for(unsigned int i = 0; i < 8; ++i) {
         bool regular_interrupt = mis & (1 << i);
         bool power_up_interrupt = irq_detect_ack & ((1 << i) << (8 * port));
-        if(regular_interrupt || power_up_interrupt)
-            _gpios[port][i]->notify();
+        if(regular_interrupt || power_up_interrupt) {
+            if(queued)
+                _gpios[port][i]->record();
+            else
+                _gpios[port][i]->notify();
+        }
     }
 
     // Clear regular interrupts even if no handler is available
@@ -4,6 +4,7 @@
 #include <machine/ic.h>
 #include <machine/timer.h>
 #include <process.h>
+#include <utility/trace.h>
 
 extern "C" { void _int_entry() __attribute__ ((naked, nothrow, alias("_ZN4EPOS1S2IC5entryEv"))); }
 extern "C" { void _int_bad() __attribute__ ((alias("_ZN4EPOS1S2IC7int_badEv"))); }
@@ -22,8 +23,80 @@ extern "C" { void _dispatch() __attribute__ ((alias("_ZN4EPOS1S2IC8dispatchEj"))
 
 __BEGIN_SYS
 
-IC::Interrupt_Handler IC::_int_vector[INTS];
-IC::Interrupt_Handler IC::_eoi_vector[INTS];
+IC::Interrupt_Handler IC::_int_vector[static_vectors ? 1 : INTS];
+IC::Interrupt_Handler IC::_eoi_vector[static_vectors ? 1 : INTS];
+unsigned int IC::_nesting[CPUS];
+bool IC::_rescheduling[CPUS];
+char IC::_stack[CPUS][STACK_SIZE] __attribute__((aligned(16)));
+
+// Handlers bound with Traits<IC>::static_vectors (those of the drivers in use must be added here)
+constexpr IC::Interrupt_Handler IC::bound(Interrupt_Id i)
+{
+#ifdef __cortex_m__
+    switch(i) {
+    case INT_HARD_FAULT: return &int_bad;
+    case INT_SYS_TIMER: return &Timer::int_handler;
+    case INT_TSC_TIMER: return Traits<TSC>::enabled ? &TSC::int_handler : &int_not;
+#ifdef __emote3__
+    case EXCS + NVIC::IRQ_SMT: return &Timer::int_wakeup;
+#endif
+    default: return &int_not;
+    }
+#else
+    return &int_not;
+#endif
+}
+
+constexpr IC::Interrupt_Handler IC::bound_eoi(Interrupt_Id i)
+{
+#ifdef __cortex_m__
+    switch(i) {
+    case INT_SYS_TIMER: return &Timer::eoi;
+    case INT_TSC_TIMER: return Traits<TSC>::enabled ? &User_Timer::eoi : 0;
+    default: return 0;
+    }
+#else
+    return 0;
+#endif
+}
+
+constexpr IC::Vectors IC::bind()
+{
+    Vectors v{};
+    for(Interrupt_Id i = 0; static_vectors && (i < INTS); i++) {
+        v.handler[i] = bound(i);
+        v.eoi[i] = bound_eoi(i);
+    }
+    return v;
+}
+
+const IC::Vectors IC::_bound = IC::bind(); // a constant expression, so it goes to .rodata
+
+void IC::check(Interrupt_Id i, const Interrupt_Handler & ih, const Interrupt_Handler & eh)
+{
+    if((ih != _bound.handler[i]) || (eh != _bound.eoi[i]))
+        db<IC, Machine>(WRN) << "IC::int_vector(int=" << i << "): not bound to this handler at compile time!" << endl;
+}
+
+// With Traits<IC>::STACK_SIZE, the outermost handler runs on its CPU's interrupt stack, where nested ones stay
+void IC::stacked(Interrupt_Id i)
+{
+    unsigned int cpu = CPU::id();
+
+    _nesting[cpu]++;
+    if(STACK_SIZE)
+        CPU::stack_call(reinterpret_cast<CPU::Reg>(&_stack[cpu][STACK_SIZE]), &serve, i);
+    else
+        serve(i);
+    CPU::int_disable(); // handlers run with interrupts enabled
+    _nesting[cpu]--;
+
+    if(_rescheduling[cpu]) {
+        _rescheduling[cpu] = false;
+        Thread::rescheduler(i);
+    } else
+        CPU::int_enable(); // dispatch() returns with interrupts enabled (on Cortex-M, the SVC at _int_exit needs them)
+}
 
 #ifdef __cortex_m__
 
@@ -144,18 +217,32 @@ void IC::entry()
 }
 
 void IC::dispatch(Interrupt_Id i)
+{
+    if(deferring && !_nesting[CPU::id()])
+        stacked(i);
+    else
+        serve(i);
+}
+
+void IC::serve(Interrupt_Id i)
 {
     if((i != INT_SYS_TIMER) || Traits<IC>::hysterically_debugged)
         db<IC>(TRC) << "IC::dispatch(i=" << i << ")" << endl;
 
-    assert((i < INTS) && _int_vector[i]);
+    Trace::interrupt(i);
+
+    assert((i < INTS) && handler(i));
 
-    if(_eoi_vector[i])
-        _eoi_vector[i](i);
+    if(eoi(i))
+        eoi(i)(i);
+
+    // Tickless idle: whatever ended the sleep, the periods slept through are accounted for before any handler looks at time
+    if(Timer::sleeping())
+        Timer::int_handler(INT_SYS_TIMER);
 
     CPU::int_enable();  // ARM disables interrupts at each interrupt handling
 
-    _int_vector[i](i);
+    handler(i)(i);
 }
 
 #else
@@ -173,17 +260,42 @@ void IC::dispatch()
 {
     Interrupt_Id i = int_id();
 
+    if(deferring && !_nesting[CPU::id()])
+        stacked(i);
+    else
+        serve(i);
+}
+
+void IC::serve(Interrupt_Id i)
+{
     if((i != INT_SYS_TIMER) || Traits<IC>::hysterically_debugged)
         db<IC>(TRC) << "IC::dispatch(i=" << i << ")" << endl;
 
+    Trace::interrupt(i);
+
     assert(i < INTS);
 
-    if(_eoi_vector[i])
-        _eoi_vector[i](i);
+    if(eoi(i))
+        eoi(i)(i);
 
-    CPU::int_enable();  // ARM disables interrupts at each interrupt handling
+    if(Traits<IC>::nested) {
+        // Only interrupts of higher priority can preempt the handler (int_id() has already sent the EOI to the GIC)
+        unsigned int l = level();
+        unsigned int p = priority(i);
+        if(p > l)
+            level(p);
+
+        CPU::int_enable();
+        handler(i)(i);
+        CPU::int_disable();
+
+        if(p > l)
+            level(l);
+    } else {
+        CPU::int_enable();  // ARM disables interrupts at each interrupt handling
 
-    _int_vector[i](i);
+        handler(i)(i);
+    }
 }
 
 #endif
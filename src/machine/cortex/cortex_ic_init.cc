@@ -47,16 +47,19 @@ void IC::init()
 #endif
 #endif
 
-    // Set all interrupt handlers to int_not()
-    for(Interrupt_Id i = 0; i < INTS; i++)
-        _int_vector[i] = int_not;
+    if(!static_vectors) {
+        // Set all interrupt handlers to int_not()
+        for(Interrupt_Id i = 0; i < INTS; i++)
+            _int_vector[i] = int_not;
 
-    // Set all EOI handlers to 0 (must be done manually, even if the variable is static, because of .hex image format used by Cortex-M)
-    for(Interrupt_Id i = 0; i < INTS; i++)
-        _eoi_vector[i] = 0;
+        // Set all EOI handlers to 0 (must be done manually, even if the variable is static, because of .hex image format used by Cortex-M)
+        for(Interrupt_Id i = 0; i < INTS; i++)
+            _eoi_vector[i] = 0;
+    }
 
 #ifdef __cortex_m__
-    _int_vector[IC::INT_HARD_FAULT] = int_bad;
+    if(!static_vectors)
+        _int_vector[IC::INT_HARD_FAULT] = int_bad;
 
     // There is no TSC in Cortex-M, so we use a software counter instead. It is initialized before IC, so no interrupt handler was registered at TSC::init().
     if(Traits<TSC>::enabled) {
@@ -3,6 +3,30 @@
 #include <machine/machine.h>
 #include <machine/display.h>
 
+#ifdef __cortex_m__
+
+extern "C" unsigned int _edata;         // defined by GCC
+
+// Called by _start() before _init(): there is no SETUP on Cortex-M, so the image in flash is all there is. With XIP,
+// .data was linked for APP_DATA but stored at DATA_IMAGE (see eposcc), so its initial values are copied to RAM first.
+extern "C" void _ram_init()
+{
+#ifdef __emote3__
+    EPOS::S::eMote3::warm_boot(); // won't return if resuming from Machine::hibernate()
+#endif
+
+    if(EPOS::S::Memory_Map::DATA_IMAGE != EPOS::S::Memory_Map::NOT_USED) {
+        const unsigned int * src = reinterpret_cast<const unsigned int *>(EPOS::S::Memory_Map::DATA_IMAGE);
+        unsigned int * dst = reinterpret_cast<unsigned int *>(EPOS::S::Memory_Map::APP_DATA);
+        while(dst < &_edata)
+            *dst++ = *src++;
+    }
+
+    EPOS::S::Machine::clear_bss();
+}
+
+#endif
+
 __BEGIN_SYS
 
 void Machine::panic()
@@ -10,6 +34,7 @@ void Machine::panic()
     CPU::int_disable();
     if(Traits<Display>::enabled)
         Display::puts("\nPANIC!\n");
+    Serial_Display::flush();
     if(Traits<System>::reboot)
         reboot();
     else
@@ -31,6 +31,11 @@ void Machine::init()
         USB::init();
 #endif
 
+#ifdef __FPGA_H
+    if(Traits<FPGA>::enabled)
+        FPGA::init();
+#endif
+
 #ifdef __NIC_H
 #ifdef __ethernet__
     if(Traits<Ethernet>::enabled)
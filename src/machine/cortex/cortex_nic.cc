@@ -0,0 +1,461 @@
+// EPOS ARM Cortex NIC Mediators Implementation
+
+#include <system/config.h>
+
+#ifdef __NIC_H
+
+#include <machine/machine.h>
+#include <machine/nic.h>
+#include <process.h>
+#include <interrupt_thread.h>
+#include <utility/pcap.h>
+
+__BEGIN_SYS
+
+// Class attributes
+Ethernet_NIC::Device Ethernet_NIC::_devices[UNITS];
+
+// Methods
+Ethernet_NIC::~Ethernet_NIC()
+{
+    db<Ethernet_NIC>(TRC) << "~Ethernet_NIC(unit=" << _unit << ")" << endl;
+
+    if(_poller)
+        delete _poller;
+
+    _gem->halt();
+    IC::disable(_interrupt);
+    _devices[_unit].device = 0;
+}
+
+int Ethernet_NIC::send(const Address & dst, const Protocol & prot, const void * data, unsigned int size)
+{
+    Buffer * buf = alloc(dst, prot, size);
+    if(!buf)
+        return 0;
+
+    memcpy(buf->frame()->data<void>(), data, size);
+
+    return send(buf);
+}
+
+int Ethernet_NIC::receive(Address * src, Protocol * prot, void * data, unsigned int size)
+{
+    db<Ethernet_NIC>(TRC) << "Ethernet_NIC::receive(d=" << data << ",s=" << size << ")" << endl;
+
+    Buffer * buf;
+    for(;;) {
+        bool ie = lock();
+        buf = take();
+        unlock(ie);
+        if(buf)
+            break;
+        Thread::yield();
+    }
+
+    Frame * frame = buf->frame();
+    *src = frame->src();
+    *prot = frame->prot();
+    if(size > buf->size())
+        size = buf->size();
+    memcpy(data, frame->data<void>(), size);
+
+    free(buf);
+
+    return size;
+}
+
+Ethernet_NIC::Buffer * Ethernet_NIC::alloc(const Address & dst, const Protocol & prot, unsigned int payload)
+{
+    db<Ethernet_NIC>(TRC) << "Ethernet_NIC::alloc(d=" << dst << ",p=" << hex << prot << dec << ",pl=" << payload << ")" << endl;
+
+    if(payload > MTU) {
+        db<Ethernet_NIC>(WRN) << "Ethernet_NIC::alloc: payload larger than the MTU!" << endl;
+        return 0;
+    }
+
+    Buffer * buf = 0;
+    bool ie = lock();
+    reclaim();
+    for(unsigned int i = 0; (i < TX_BUFS) && !buf; i++)
+        if(_tx_buffer[i]->lock())
+            buf = _tx_buffer[i];
+    unlock(ie);
+
+    if(!buf) {
+        db<Ethernet_NIC>(WRN) << "Ethernet_NIC::alloc: no TX buffers available!" << endl;
+        return 0;
+    }
+
+    *buf->frame()->header() = Header(_address, dst, prot);
+    buf->size(payload);
+
+    db<Ethernet_NIC>(INF) << "Ethernet_NIC::alloc:buf=" << buf << " => " << *buf << endl;
+
+    return buf;
+}
+
+int Ethernet_NIC::send(Buffer * buf)
+{
+    unsigned int size = buf->size();
+
+    // The chip pads short frames and appends the FCS
+    _dma_buf->clean(buf->frame(), HEADER_SIZE + size);
+
+    bool ie = lock();
+
+    // There is one TX descriptor more than TX buffers and at least this one isn't being sent, so the next two
+    // descriptors are free once the ones the chip is done with are reclaimed
+    reclaim();
+    unsigned int i = _tx_cur;
+    unsigned int next = (i + 1) % TX_RING;
+    assert(!_tx_sent[i] && !_tx_sent[next]);
+
+    _tx_sent[i] = buf;
+    _tx_cur = next;
+    _tx_pending++;
+
+    // The chip must find the next descriptor USED before this one stops being so
+    _tx_ring[next].addr = 0;
+    _tx_ring[next].ctrl = Tx_Desc::USED | ((next == TX_RING - 1) ? Tx_Desc::WRAP : 0);
+    _dma_buf->clean(&_tx_ring[next], sizeof(Tx_Desc));
+
+    _tx_ring[i].addr = phy(buf->frame());
+    CPU::fence();
+    _tx_ring[i].ctrl = ((HEADER_SIZE + size) & Tx_Desc::LENGTH) | Tx_Desc::LAST | ((i == TX_RING - 1) ? Tx_Desc::WRAP : 0);
+    _dma_buf->clean(&_tx_ring[i], sizeof(Tx_Desc));
+
+    // Don't wait for the chip to poll the ring (it doesn't once it has stopped on a USED descriptor)
+    _gem->gem(GEM::NET_CTRL) = _gem->gem(GEM::NET_CTRL) | GEM::START_TX;
+
+    _statistics.tx_packets++;
+    _statistics.tx_bytes += size;
+
+    PCAP::capture(buf->frame(), HEADER_SIZE + size);
+
+    unlock(ie);
+
+    db<Ethernet_NIC>(INF) << "Ethernet_NIC::send(buf=" << buf << ",desc=" << i << ")" << endl;
+
+    return size;
+}
+
+void Ethernet_NIC::free(Buffer * buf)
+{
+    db<Ethernet_NIC>(TRC) << "Ethernet_NIC::free(buf=" << buf << ")" << endl;
+
+    bool ie = lock();
+    if(buf->back()) // RX buffers are bound to their descriptors, TX ones aren't until they are sent
+        recycle(buf);
+    else
+        buf->unlock();
+    unlock(ie);
+}
+
+void Ethernet_NIC::reset()
+{
+    db<Ethernet_NIC>(TRC) << "Ethernet_NIC::reset(unit=" << _unit << ")" << endl;
+
+    bool ie = lock();
+
+    // Stop the chip and bring up the management port, to negotiate the link with the PHY
+    _gem->halt();
+    _gem->gem(GEM::NET_CFG) = GEM::MDC_CLK_DIV_224;
+    _gem->gem(GEM::NET_CTRL) = GEM::MGMT_PORT_EN;
+    Reg32 speed = link();
+
+    // Keep the address the boot loader set, if any, otherwise take U-Boot's default for Xilinx boards (00:0a:35:00:01:22)
+    unsigned long long mac = _gem->mac();
+    if(!mac)
+        mac = 0x220100350a00ULL + (static_cast<unsigned long long>(_unit) << 40);
+    for(unsigned int i = 0; i < sizeof(Address); i++)
+        _address[i] = mac >> (8 * i);
+    _gem->mac(mac);
+
+    // Give all RX descriptors to the chip and take all TX descriptors back (frames being sent are lost)
+    for(unsigned int i = 0; i < RX_BUFS; i++) {
+        _rx_ring[i].status = 0;
+        _rx_ring[i].addr = (phy(_rx_buffer[i]->frame()) & Rx_Desc::ADDR) | ((i == RX_BUFS - 1) ? Rx_Desc::WRAP : 0);
+        _rx_buffer[i]->size(sizeof(Frame));
+        _rx_buffer[i]->unlock();
+        _rx_state[i] = CHIP;
+    }
+    for(unsigned int i = 0; i < TX_RING; i++) {
+        _tx_ring[i].addr = 0;
+        _tx_ring[i].ctrl = Tx_Desc::USED | ((i == TX_RING - 1) ? Tx_Desc::WRAP : 0);
+        if(_tx_sent[i]) {
+            _tx_sent[i]->unlock();
+            _tx_sent[i] = 0;
+        }
+    }
+    _rx_cur = 0;
+    _tx_cur = 0;
+    _tx_clean = 0;
+    _tx_pending = 0;
+    _dma_buf->flush();
+
+    _gem->gem(GEM::RX_QBAR) = phy(_rx_ring);
+    _gem->gem(GEM::TX_QBAR) = phy(_tx_ring);
+    _gem->gem(GEM::HASH_BOT) = 0;
+    _gem->gem(GEM::HASH_TOP) = 0;
+    _gem->gem(GEM::DMA_CFG) = GEM::AHB_BURST_INCR16 | GEM::RX_PKTBUF_8KB | GEM::TX_PKTBUF_4KB | GEM::DISC_WHEN_NO_AHB
+                            | ((RX_BUFFER_SIZE / 64) << GEM::RX_BUF_SIZE_SHIFT) | (offloaded ? GEM::TX_CHKSUM_OFFLOAD : 0);
+    _gem->gem(GEM::NET_CFG) = GEM::MDC_CLK_DIV_224 | GEM::FCS_REMOVE | speed | (promiscuous ? GEM::COPY_ALL : 0)
+                            | (offloaded ? GEM::RX_CHKSUM_OFFLOAD : 0);
+
+    _gem->gem(GEM::INTR_EN) = GEM::INT_RX_COMPLETE | GEM::INT_RX_OVERRUN | GEM::INT_HRESP_NOT_OK;
+    _gem->gem(GEM::NET_CTRL) = GEM::MGMT_PORT_EN | GEM::RX_EN | GEM::TX_EN;
+
+    unlock(ie);
+
+    db<Ethernet_NIC>(INF) << "Ethernet_NIC::reset: mac=" << _address << ",cfg=" << hex << _gem->gem(GEM::NET_CFG) << dec << endl;
+}
+
+void Ethernet_NIC::attach(Observer * o, const Protocol & p)
+{
+    Observed::attach(o, p);
+
+    // Frames are only polled for observers, and threads can't be created before the system is up
+    if(polled && !_poller)
+        _poller = new (SYSTEM) Interrupt_Thread(_interrupt, &_bottom_half, &int_ack);
+}
+
+// Configures the TX clock for the link the PHY negotiated (the boot loader has usually started the negotiation) and
+// returns the corresponding speed and duplex bits of NET_CFG. Without a PHY (e.g. QEMU), the link is 1 Gbps full duplex.
+Ethernet_NIC::Reg32 Ethernet_NIC::link()
+{
+    if(_phy < 0)
+        for(int a = 0; a < 32; a++) {
+            int id = _gem->phy(a, GEM::MII_PHYID1);
+            if((id != 0xffff) && (id != 0)) {
+                _phy = a;
+                break;
+            }
+        }
+
+    unsigned int mbps = 1000;
+    bool full = true;
+    if(_phy >= 0) {
+        _gem->phy(_phy, GEM::MII_BMSR); // the link status is latched low
+        int bmsr = _gem->phy(_phy, GEM::MII_BMSR);
+        if((bmsr & GEM::BMSR_LINK) && (bmsr & GEM::BMSR_ANEG_COMPLETE)) {
+            int stat1000 = _gem->phy(_phy, GEM::MII_STAT1000);
+            int lpa = _gem->phy(_phy, GEM::MII_LPA);
+            if(stat1000 & (GEM::STAT1000_FULL | GEM::STAT1000_HALF)) {
+                mbps = 1000;
+                full = stat1000 & GEM::STAT1000_FULL;
+            } else if(lpa & (GEM::LPA_100FULL | GEM::LPA_100HALF)) {
+                mbps = 100;
+                full = lpa & GEM::LPA_100FULL;
+            } else {
+                mbps = 10;
+                full = lpa & GEM::LPA_10FULL;
+            }
+        } else
+            db<Ethernet_NIC>(WRN) << "Ethernet_NIC::link: no link on PHY " << _phy << "!" << endl;
+    }
+
+    db<Ethernet_NIC>(INF) << "Ethernet_NIC::link: phy=" << _phy << ",speed=" << mbps << (full ? "FD" : "HD") << endl;
+
+    Machine_Model::gem_clock(_unit, mbps);
+
+    return ((mbps == 1000) ? GEM::GIGABIT : (mbps == 100) ? GEM::SPEED_100 : 0) | (full ? GEM::FULL_DUPLEX : 0);
+}
+
+// Returns the next frame received, or 0 if there is none (or the ring has wrapped around onto frames still in use).
+// Must be called with the lock taken.
+Ethernet_NIC::Buffer * Ethernet_NIC::take()
+{
+    for(;;) {
+        unsigned int i = _rx_cur;
+        Rx_Desc * desc = &_rx_ring[i];
+        Buffer * buf = _rx_buffer[i];
+
+        // Lines holding RX descriptors are never dirty, since recycle() cleans them
+        _dma_buf->invalidate(desc, sizeof(Rx_Desc));
+        if((_rx_state[i] != CHIP) || !(desc->addr & Rx_Desc::OWN))
+            return 0;
+
+        // Nobody wrote the Buffer since recycle() flushed it, but the core may have speculatively read stale lines
+        _dma_buf->invalidate(buf, BUFFER_SIZE);
+        buf->lock();
+        _rx_state[i] = HOST;
+        _rx_cur = (i + 1) % RX_BUFS;
+
+        Reg32 status = desc->status;
+        unsigned int size = status & Rx_Desc::LENGTH;
+        if(((status & (Rx_Desc::SOF | Rx_Desc::EOF)) != (Rx_Desc::SOF | Rx_Desc::EOF)) || (size < HEADER_SIZE)) {
+            db<Ethernet_NIC>(WRN) << "Ethernet_NIC::take: bad frame (status=" << hex << status << dec << ")!" << endl;
+            _statistics.rx_errors++;
+            recycle(buf);
+            continue;
+        }
+
+        buf->size(size - HEADER_SIZE);
+
+        _statistics.rx_packets++;
+        _statistics.rx_bytes += buf->size();
+
+        PCAP::capture(buf->frame(), HEADER_SIZE + buf->size());
+
+        db<Ethernet_NIC>(INF) << "Ethernet_NIC::take:desc=" << i << ",buf=" << buf << " => " << *buf->frame()->header() << endl;
+
+        return buf;
+    }
+}
+
+// Gives the TX buffers of the frames the chip is done with back to the pool. These are the ones before the descriptor
+// the chip is at (the first one not sent yet, or the USED one after the last frame). Must be called with the lock taken.
+void Ethernet_NIC::reclaim()
+{
+    unsigned int chip = (_gem->gem(GEM::TX_QBAR) - phy(_tx_ring)) / sizeof(Tx_Desc);
+    if(chip >= TX_RING)
+        return;
+
+    for(; _tx_pending && (_tx_clean != chip); _tx_pending--) {
+        _tx_sent[_tx_clean]->unlock();
+        _tx_sent[_tx_clean] = 0;
+        _tx_clean = (_tx_clean + 1) % TX_RING;
+    }
+}
+
+// Takes the RX descriptor of buf back from the host and gives its cache line back to the chip once all of the line's
+// descriptors are DONE. Must be called with the lock taken, so take() never sees a descriptor half given back.
+void Ethernet_NIC::recycle(Buffer * buf)
+{
+    unsigned int i = reinterpret_cast<Rx_Desc *>(buf->back()) - _rx_ring;
+
+    buf->size(sizeof(Frame));
+    buf->unlock();
+    _dma_buf->flush(buf, BUFFER_SIZE); // nothing the host wrote may be evicted over what the chip writes
+    _rx_state[i] = DONE;
+
+    unsigned int first = i & ~(RX_PER_LINE - 1);
+    for(unsigned int j = first; j < first + RX_PER_LINE; j++)
+        if(_rx_state[j] != DONE)
+            return;
+
+    for(unsigned int j = first; j < first + RX_PER_LINE; j++) {
+        _rx_ring[j].status = 0;
+        _rx_ring[j].addr = (phy(_rx_buffer[j]->frame()) & Rx_Desc::ADDR) | ((j == RX_BUFS - 1) ? Rx_Desc::WRAP : 0);
+        _rx_state[j] = CHIP;
+    }
+    _dma_buf->clean(&_rx_ring[first], LINE);
+}
+
+// Acknowledges all interrupt causes and returns them
+Ethernet_NIC::Reg32 Ethernet_NIC::acknowledge()
+{
+    bool ie = lock();
+
+    Reg32 status = _gem->gem(GEM::INTR_STATUS);
+    _gem->gem(GEM::INTR_STATUS) = status;
+    Reg32 tx = _gem->gem(GEM::TX_STATUS);
+    _gem->gem(GEM::TX_STATUS) = tx & GEM::TX_STATUS_ALL;
+    Reg32 rx = _gem->gem(GEM::RX_STATUS);
+    _gem->gem(GEM::RX_STATUS) = rx;
+
+    if(rx & (GEM::RX_OVERRUN | GEM::RX_BUFFER_NOT_AVAIL))
+        _statistics.rx_overruns++;
+    if(rx & GEM::RX_HRESP_NOT_OK)
+        _statistics.rx_errors++;
+    if(tx & GEM::TX_COLLISION)
+        _statistics.collisions++;
+    if(tx & (GEM::TX_RETRY_EXCEEDED | GEM::TX_CORRUPTED | GEM::TX_UNDERRUN | GEM::TX_LATE_COLLISION | GEM::TX_HRESP_NOT_OK)) {
+        db<Ethernet_NIC>(WRN) << "Ethernet_NIC::acknowledge: TX error (status=" << hex << tx << dec << ")!" << endl;
+        _statistics.tx_errors++;
+    }
+
+    unlock(ie);
+
+    return status;
+}
+
+// Hands up to "budget" frames up by reference while anybody is listening, otherwise leaves them in the ring for
+// receive(). The batch is taken from the ring at once, but the lock is not held while observers run, since they will
+// free() the Buffers or send() replies. Returns how many frames were handed up.
+unsigned int Ethernet_NIC::deliver(unsigned int budget)
+{
+    Buffer * batch[POLL_BUDGET];
+    if(budget > POLL_BUDGET)
+        budget = POLL_BUDGET;
+
+    unsigned int n = 0;
+    if(observers()) {
+        bool ie = lock();
+        for(Buffer * buf; (n < budget) && (buf = take()); n++)
+            batch[n] = buf;
+        unlock(ie);
+    }
+
+    for(unsigned int i = 0; i < n; i++)
+        if(!notify(batch[i]->frame()->prot(), batch[i]))
+            free(batch[i]);
+
+    return n;
+}
+
+// Bottom half of the polled mode. RX interrupts stay masked while the ring yields full batches. A frame that arrives
+// after the last batch leaves RX_COMPLETE set in INTR_STATUS, so the interrupt comes as soon as it is unmasked.
+void Ethernet_NIC::poll()
+{
+    while(deliver(POLL_BUDGET) == POLL_BUDGET)
+        Thread::yield();
+
+    _gem->gem(GEM::INTR_EN) = GEM::INT_RX_COMPLETE;
+}
+
+void Ethernet_NIC::handle_int()
+{
+    Reg32 status = acknowledge();
+
+    if(status & GEM::INT_RX_COMPLETE)
+        while(deliver(POLL_BUDGET) == POLL_BUDGET);
+}
+
+void Ethernet_NIC::int_handler(IC::Interrupt_Id interrupt)
+{
+    for(unsigned int i = 0; i < UNITS; i++)
+        if(_devices[i].device && (_devices[i].interrupt == interrupt))
+            _devices[i].device->handle_int();
+}
+
+// Top half of the polled mode (runs in interrupt context)
+void Ethernet_NIC::int_ack(IC::Interrupt_Id interrupt)
+{
+    for(unsigned int i = 0; i < UNITS; i++) {
+        Ethernet_NIC * dev = _devices[i].device;
+        if(dev && (dev->_interrupt == interrupt)) {
+            dev->_gem->gem(GEM::INTR_DIS) = GEM::INT_RX_COMPLETE;
+            dev->acknowledge();
+        }
+    }
+}
+
+void Ethernet_NIC::bottom_half(Ethernet_NIC * dev)
+{
+    dev->poll();
+}
+
+bool Ethernet_NIC::lock()
+{
+    bool ie = CPU::int_enabled();
+    CPU::int_disable();
+    if(Traits<Build>::CPUS > 1)
+        while(CPU::tsl(_lock));
+    return ie;
+}
+
+void Ethernet_NIC::unlock(bool ie)
+{
+    if(Traits<Build>::CPUS > 1) {
+        CPU::fence();
+        _lock = 0;
+    }
+    if(ie)
+        CPU::int_enable();
+}
+
+__END_SYS
+
+#endif
@@ -0,0 +1,70 @@
+// EPOS ARM Cortex NIC Mediators Initialization
+
+#include <system/config.h>
+
+#ifdef __NIC_H
+
+#include <machine/machine.h>
+#include <machine/nic.h>
+#include <system.h>
+
+__BEGIN_SYS
+
+Ethernet_NIC::Ethernet_NIC(unsigned int unit, GEM * gem, const IC::Interrupt_Id & irq, DMA_Buffer * dma)
+: _bottom_half(&bottom_half, this), _poller(0)
+{
+    db<Ethernet_NIC>(TRC) << "Ethernet_NIC(unit=" << unit << ",gem=" << gem << ",irq=" << irq << ",dma=" << *dma << ")" << endl;
+
+    _unit = unit;
+    _gem = gem;
+    _interrupt = irq;
+    _lock = 0;
+    _phy = -1;
+    _dma_buf = dma;
+
+    // Rings and buffers, in this order, all in whole cache lines (pages are aligned to them)
+    Log_Addr log = _dma_buf->log_address();
+
+    _rx_ring = log;
+    log += RX_RING_SIZE;
+
+    _tx_ring = log;
+    log += TX_RING_SIZE;
+
+    for(unsigned int i = 0; i < RX_BUFS; i++) {
+        _rx_buffer[i] = new (log) Buffer(this, &_rx_ring[i]);
+        log += BUFFER_SIZE;
+    }
+
+    for(unsigned int i = 0; i < TX_BUFS; i++) {
+        _tx_buffer[i] = new (log) Buffer(this, 0);
+        log += BUFFER_SIZE;
+    }
+
+    for(unsigned int i = 0; i < TX_RING; i++)
+        _tx_sent[i] = 0;
+
+    reset();
+}
+
+void Ethernet_NIC::init(unsigned int unit)
+{
+    db<Init, Ethernet_NIC>(TRC) << "Ethernet_NIC::init(unit=" << unit << ")" << endl;
+
+    GEM * gem = reinterpret_cast<GEM *>(unit ? Memory_Map::ETH1_BASE : Memory_Map::ETH0_BASE);
+    IC::Interrupt_Id irq = IC::irq2int(unit ? GIC::IRQ_ETHERNET1 : GIC::IRQ_ETHERNET0);
+    db<Init, Ethernet_NIC>(INF) << "Ethernet_NIC::init: gem=" << gem << ",id=" << hex << gem->gem(GEM::MODULE_ID) << dec << ",irq=" << irq << endl;
+
+    DMA_Buffer * dma = new (SYSTEM) DMA_Buffer(DMA_BUFFER_SIZE);
+    Ethernet_NIC * dev = new (SYSTEM) Ethernet_NIC(unit, gem, irq, dma);
+
+    _devices[unit].device = dev;
+    _devices[unit].interrupt = irq;
+
+    IC::int_vector(irq, &int_handler);
+    IC::enable(irq);
+}
+
+__END_SYS
+
+#endif
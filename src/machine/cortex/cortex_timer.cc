@@ -13,15 +13,57 @@ bool User_Timer_Engine::_periodic;
 User_Timer_Engine::Count User_Timer_Engine::_count;
 #endif
 
+#ifdef __emote3__
+volatile bool Timer::_sleeping;
+Timer::Tick Timer::_skipped;
+
+void Timer::sleep(const Tick & ticks)
+{
+    assert(CPU::int_disabled());
+
+    if(ticks <= 1)
+        return;
+
+    db<Timer>(TRC) << "Timer::sleep(tk=" << ticks << ")" << endl;
+
+    Tick max = Engine::MAX_SLEEP / (1000000 / FREQUENCY);
+    _sleeping = Engine::sleep(((ticks > max) ? max : ticks) * (1000000 / FREQUENCY));
+}
+
+Timer::Tick Timer::wakeup()
+{
+    _sleeping = false;
+    Tick ticks = Engine::wakeup() / (1000000 / FREQUENCY);
+
+    db<Timer>(TRC) << "Timer::wakeup() => " << ticks << endl;
+
+    return ticks;
+}
+#endif
+
 void Timer::int_handler(Interrupt_Id i)
 {
-    if(_channels[ALARM] && (--_channels[ALARM]->_current <= 0)) {
+    // After a tickless sleep, a single call stands for all the periods slept through, which might be none
+    Tick ticks = sleeping() ? wakeup() : 1;
+    if(!ticks)
+        return;
+#ifdef __emote3__
+    _skipped = ticks - 1;
+#endif
+
+    if(_channels[ALARM] && ((_channels[ALARM]->_current -= ticks) <= 0)) {
         _channels[ALARM]->_current = _channels[ALARM]->_initial;
         _channels[ALARM]->_handler(i);
     }
 
-    if(_channels[SCHEDULER] && (--_channels[SCHEDULER]->_current <= 0)) {
+    if(_channels[SCHEDULER] && ((_channels[SCHEDULER]->_current -= ticks) <= 0)) {
         _channels[SCHEDULER]->_current = _channels[SCHEDULER]->_initial;
+#ifdef __raspberry_pi3__
+        // Only core 0 gets the tick, so it ends the time slices of the other cores through IPIs
+        if(Traits<System>::multicore)
+            for(unsigned int cpu = 1; cpu < CPU::cores(); cpu++)
+                IC::ipi(cpu, IC::INT_RESCHEDULER);
+#endif
         _channels[SCHEDULER]->_handler(i);
     }
 }
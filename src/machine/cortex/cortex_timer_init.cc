@@ -12,6 +12,11 @@ void Timer::init()
     Engine::init();
     IC::int_vector(IC::INT_SYS_TIMER, int_handler, eoi);
     IC::enable(IC::INT_SYS_TIMER);
+
+#ifdef __emote3__
+    // Only enabled while sleeping (see System_Timer_Engine::sleep())
+    IC::int_vector(IC::irq2int(NVIC::IRQ_SMT), int_wakeup);
+#endif
 }
 
 __END_SYS
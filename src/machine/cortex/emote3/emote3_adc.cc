@@ -0,0 +1,99 @@
+// EPOS EPOSMoteIII (ARM Cortex-M3) ADC Mediator Implementation
+
+#include <machine/ic.h>
+#include <machine/adc.h>
+
+#ifdef __ADC_H
+
+__BEGIN_SYS
+
+// Class attributes
+ADC_Engine * ADC_Engine::_engine;
+
+// Methods
+void ADC_Engine::start(const Hertz & frequency, unsigned char * buffer, unsigned int samples, Handler * handler)
+{
+    db<ADC>(TRC) << "ADC::start(f=" << frequency << ",b=" << reinterpret_cast<void *>(buffer) << ",s=" << samples << ")" << endl;
+
+    if(!continuous || _engine || !samples || (samples > PL230::MAX_TRANSFER) || (_channel > SINGLE_ENDED_ADC7)) {
+        db<ADC>(WRN) << "ADC::start: continuous sampling unavailable or busy!" << endl;
+        return;
+    }
+
+    _engine = this;
+    _buffer = buffer;
+    _samples = samples;
+    _handler = handler;
+    _filled = 0;
+    _halves = 0;
+
+    PL230 * u = uDMA::controller();
+    unsigned int ch = dma_channel();
+    uDMA::init();
+    u->disable(ch);
+    u->map(ch, 0);
+    u->attributes(ch, false, true); // the ADC keeps a single sample, so it can't wait for other channels
+    arm(false);
+    arm(true);
+    u->ack(1 << ch);
+
+    IC::int_vector(IC_Engine::INT_ADC, int_handler);
+    IC::enable(IC_Engine::INT_ADC);
+    u->enable(ch);
+
+    _adc->sequence(_channel, _reference, _resolution, true);
+
+    scr()->clock_timer(TIMER_UNIT);
+    _timer = new (gptm(TIMER_UNIT)) GPTM;
+    _timer->config(_timer->clock() / frequency, false, true);
+    _timer->adc_trigger(true);
+}
+
+void ADC_Engine::stop()
+{
+    if(_engine != this)
+        return;
+
+    db<ADC>(TRC) << "ADC::stop(halves=" << _halves << ")" << endl;
+
+    _timer->adc_trigger(false);
+    _timer->disable();
+    scr()->unclock_timer(TIMER_UNIT);
+
+    _adc->sequence(_channel, _reference, _resolution, false);
+
+    uDMA::controller()->disable(dma_channel());
+    IC::disable(IC_Engine::INT_ADC);
+
+    _engine = 0;
+}
+
+// Sets the primary (first half) or the alternate (second half) structure up for another turn
+void ADC_Engine::arm(bool alternate)
+{
+    uDMA::controller()->setup(dma_channel(), _adc->msb(), false, _buffer + (alternate ? _samples : 0), true, _samples,
+                              PL230::SIZE_8, 0, alternate, PL230::MODE_PINGPONG);
+}
+
+void ADC_Engine::int_handler(IC::Interrupt_Id i)
+{
+    ADC_Engine * adc = _engine;
+    PL230 * u = uDMA::controller();
+
+    if(!adc || !(u->done() & (1 << adc->dma_channel())))
+        return;
+    u->ack(1 << adc->dma_channel());
+
+    // The controller has already switched to the other structure, so the one not in use is the one just filled
+    bool alternate = !u->alternate(adc->dma_channel());
+    adc->arm(alternate);
+    adc->_filled = adc->_buffer + (alternate ? adc->_samples : 0);
+    adc->_halves++;
+
+    if(adc->_handler)
+        (*adc->_handler)();
+}
+
+__END_SYS
+
+#endif
@@ -0,0 +1,165 @@
+// EPOS EPOSMoteIII (ARM Cortex-M3) I2C Mediator Implementation
+
+#include <machine/ic.h>
+#include <machine/i2c.h>
+#include <synchronizer.h>
+
+#ifdef __I2C_H
+
+__BEGIN_SYS
+
+// Class attributes
+I2C_Engine * I2C_Engine::_engine;
+
+// Methods
+void I2C_Engine::submit(Transaction * t, unsigned int n)
+{
+    db<I2C>(TRC) << "I2C::submit(t=" << t << ",n=" << n << ")" << endl;
+
+    if(!asynchronous || (_engine != this)) {
+        for(unsigned int i = 0; i < n; i++) {
+            for(bool finished = start(&t[i]); !finished; finished = step(&t[i])) {
+                while(!_i2c->finished());
+                _i2c->clear_int();
+            }
+            finish(&t[i]);
+        }
+        return;
+    }
+
+    bool ie = CPU::int_enabled();
+    CPU::int_disable();
+
+    for(unsigned int i = 0; i < n; i++)
+        _queue.insert(&t[i]._link);
+    if(!_current)
+        next();
+
+    if(ie)
+        CPU::int_enable();
+}
+
+bool I2C_Engine::transfer(unsigned char slave_address, const char * tx, unsigned int tx_size, char * rx, unsigned int rx_size)
+{
+    Semaphore done(0);
+    Semaphore_Handler handler(&done);
+    Transaction t(slave_address, tx, tx_size, rx, rx_size, &handler);
+
+    submit(&t);
+    done.p();
+
+    return t.ok();
+}
+
+// Issues the first operation of "t" and returns whether it was already finished (i.e. it is empty)
+bool I2C_Engine::start(Transaction * t)
+{
+    t->_index = 0;
+    t->_reading = !t->_tx_size;
+    t->_done = false;
+    t->_ok = !t->_tx_size && !t->_rx_size;
+
+    if(t->_ok)
+        return true;
+
+    issue(t, true);
+    return false;
+}
+
+// Handles the end of an operation of "t" and issues the next one, returning whether "t" is finished
+bool I2C_Engine::step(Transaction * t)
+{
+    CPU::Reg32 status = _i2c->status();
+    if(status & (I2C_STAT_ERROR | I2C_STAT_ARBLST)) {
+        db<I2C>(INF) << "I2C::step: slave " << hex << t->_address << " failed (status=" << status << ")!" << endl;
+
+        // Release the bus unless another master took it
+        if(!(status & I2C_STAT_ARBLST))
+            _i2c->command(I2C_CTRL_STOP);
+        t->_ok = false;
+        return true;
+    }
+
+    if(t->_reading)
+        t->_rx[t->_index] = _i2c->data();
+    t->_index++;
+
+    if(!t->_reading) {
+        if(t->_index < t->_tx_size) {
+            issue(t, false);
+            return false;
+        }
+        if(t->_rx_size) {
+            t->_reading = true;
+            t->_index = 0;
+            issue(t, true); // repeated start
+            return false;
+        }
+    } else if(t->_index < t->_rx_size) {
+        issue(t, false);
+        return false;
+    }
+
+    t->_ok = true;
+    return true;
+}
+
+// Moves byte _index of the current part of "t". The last byte of the transaction carries a STOP, and all bytes read
+// but the last one are acknowledged.
+void I2C_Engine::issue(Transaction * t, bool first)
+{
+    CPU::Reg32 command = I2C_CTRL_RUN | (first ? I2C_CTRL_START : 0);
+
+    if(first)
+        _i2c->address(t->_address, t->_reading);
+
+    if(t->_reading)
+        command |= (t->_index + 1 < t->_rx_size) ? I2C_CTRL_ACK : I2C_CTRL_STOP;
+    else {
+        _i2c->data(t->_tx[t->_index]);
+        if((t->_index + 1 == t->_tx_size) && !t->_rx_size)
+            command |= I2C_CTRL_STOP;
+    }
+
+    _i2c->command(command);
+}
+
+// Starts the first queued Transaction that has anything to move. Must be called with interrupts disabled.
+void I2C_Engine::next()
+{
+    _current = 0;
+    while(!_current && !_queue.empty()) {
+        Transaction * t = _queue.remove()->object();
+        if(start(t))
+            finish(t);
+        else
+            _current = t;
+    }
+}
+
+void I2C_Engine::finish(Transaction * t)
+{
+    db<I2C>(TRC) << "I2C::finish(t=" << t << ",ok=" << t->_ok << ")" << endl;
+
+    t->_done = true;
+    if(t->_handler)
+        (*t->_handler)();
+}
+
+void I2C_Engine::int_handler(IC::Interrupt_Id i)
+{
+    I2C_Engine * i2c = _engine;
+    if(!i2c || !i2c->_i2c->finished())
+        return;
+    i2c->_i2c->clear_int();
+
+    Transaction * t = i2c->_current;
+    if(t && i2c->step(t)) {
+        i2c->finish(t);
+        i2c->next();
+    }
+}
+
+__END_SYS
+
+#endif
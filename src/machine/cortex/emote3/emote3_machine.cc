@@ -0,0 +1,103 @@
+// EPOS eMote3 (ARM Cortex-M3) Mediator Implementation
+
+#include <machine/machine.h>
+#include <machine/timer.h>
+#include <utility/crc.h>
+
+__BEGIN_SYS
+
+// Class attributes
+eMote3::Snapshot eMote3::_snapshot;
+
+// Saves r4-r11, sp and lr in "context" and returns 0, then 1 again when restore() resumes from it (as setjmp())
+__attribute__((naked, noinline, returns_twice)) static int save(CPU::Reg32 * context)
+{
+    ASM("   stmia   r0!, {r4-r11}       \n"
+        "   mov     r1, sp              \n"
+        "   stmia   r0!, {r1, lr}       \n"
+        "   movs    r0, #0              \n"
+        "   bx      lr                  \n");
+}
+
+__attribute__((naked, noinline)) static void restore(const CPU::Reg32 * context)
+{
+    ASM("   ldmia   r0!, {r4-r11}       \n"
+        "   ldmia   r0!, {r1, lr}       \n"
+        "   mov     sp, r1              \n"
+        "   movs    r0, #1              \n"
+        "   bx      lr                  \n");
+}
+
+
+// Class methods
+bool eMote3::hibernate(const Power_Mode & mode)
+{
+    db<Machine>(TRC) << "Machine::hibernate(m=" << mode << ")" << endl;
+
+    bool enabled = CPU::int_enabled();
+    CPU::int_disable();
+
+    // The snapshot is taken in this very frame, which is still there at the reset, since this call never returned
+    if(Traits<Machine>::warm_boot) {
+        for(unsigned int i = 0; i < IRQ_WORDS; i++)
+            _snapshot.irqs[i] = irq_enables()[i];
+
+        if(save(_snapshot.context)) { // warm boot
+            if(enabled)
+                CPU::int_enable();
+            return true;
+        }
+
+        _snapshot.magic = MAGIC;
+        _snapshot.crc = crc();
+    }
+
+    Timer::disable();
+    power(mode);
+    ASM("wfi");
+
+    // Woken up by an interrupt instead (e.g. the sleep timer's in PM2), which is taken once they are enabled again
+    _snapshot.magic = 0;
+    power(FULL);
+    scr()->power_mode(SysCtrl::PM0);
+    scr()->wait_clock();
+    Timer::reset();
+    Timer::enable();
+
+    if(enabled)
+        CPU::int_enable();
+
+    return false;
+}
+
+void eMote3::warm_boot()
+{
+    if(!Traits<Machine>::warm_boot || (_snapshot.magic != MAGIC) || (_snapshot.crc != crc()))
+        return;
+
+    _snapshot.magic = 0; // a reset while resuming boots cold
+
+    pre_init();
+    init();
+
+    for(unsigned int i = 0; i < IRQ_WORDS; i++)
+        irq_enables()[i] = _snapshot.irqs[i];
+
+    // The TSC restarts from 0, so a wrap around is accounted for to keep time stamps from going back
+    TSC::init();
+    TSC::_overflow++;
+
+    if(Traits<Timer>::enabled) {
+        Timer::reset();
+        Timer::enable();
+    }
+
+    restore(_snapshot.context);
+}
+
+eMote3::Reg32 eMote3::crc()
+{
+    return CRC::crc32(&_snapshot, sizeof(Snapshot) - sizeof(_snapshot.crc));
+}
+
+__END_SYS
@@ -0,0 +1,92 @@
+// EPOS EPOSMoteIII (ARM Cortex-M3) PWM Mediator Implementation
+
+#include <machine/ic.h>
+#include <machine/pwm.h>
+
+#ifdef __PWM_H
+
+__BEGIN_SYS
+
+// Class attributes
+PWM_Engine * PWM_Engine::_engine;
+
+// Methods
+bool PWM_Engine::play(DMA_Buffer * buffer, unsigned int steps, Handler * handler)
+{
+    db<PWM>(TRC) << "PWM::play(b=" << *buffer << ",s=" << steps << ")" << endl;
+
+    if(!waveform || _engine || !steps || (steps > PL230::MAX_TRANSFER) || (buffer->size() < 2 * steps * sizeof(Count))
+       || (_gptm->pwm_period() > 0xffff)) {
+        db<PWM>(WRN) << "PWM::play: waveform unavailable or busy!" << endl;
+        return false;
+    }
+
+    _engine = this;
+    _table = buffer->log_address();
+    _steps = steps;
+    _handler = handler;
+    _refill = 0;
+    _halves = 0;
+    buffer->clean();
+
+    PL230 * u = uDMA::controller();
+    uDMA::init();
+    u->disable(DMA_CHANNEL);
+    u->map(DMA_CHANNEL, DMA_ENCODING);
+    u->attributes(DMA_CHANNEL, false, true); // a step per period, which can't wait for other channels
+    arm(false);
+    arm(true);
+    u->ack(1 << DMA_CHANNEL);
+
+    IC::int_vector(interrupt(), int_handler);
+    IC::enable(interrupt());
+    u->enable(DMA_CHANNEL);
+
+    _gptm->pwm_event(true);
+
+    return true;
+}
+
+void PWM_Engine::stop()
+{
+    if(_engine != this)
+        return;
+
+    db<PWM>(TRC) << "PWM::stop(halves=" << _halves << ")" << endl;
+
+    _gptm->pwm_event(false);
+    uDMA::controller()->disable(DMA_CHANNEL);
+    IC::disable(interrupt());
+
+    _engine = 0;
+}
+
+// Sets the primary (first half) or the alternate (second half) structure up for another turn
+void PWM_Engine::arm(bool alternate)
+{
+    uDMA::controller()->setup(DMA_CHANNEL, _table + (alternate ? _steps : 0), true, _gptm->pwm_match(), false, _steps,
+                              PL230::SIZE_32, 0, alternate, PL230::MODE_PINGPONG);
+}
+
+void PWM_Engine::int_handler(IC::Interrupt_Id i)
+{
+    PWM_Engine * pwm = _engine;
+    PL230 * u = uDMA::controller();
+
+    if(!pwm || !(u->done() & (1 << DMA_CHANNEL)))
+        return;
+    u->ack(1 << DMA_CHANNEL);
+
+    // The controller has already switched to the other structure, so the one not in use is the one just played
+    bool alternate = !u->alternate(DMA_CHANNEL);
+    pwm->arm(alternate);
+    pwm->_refill = pwm->_table + (alternate ? pwm->_steps : 0);
+    pwm->_halves++;
+
+    if(pwm->_handler)
+        (*pwm->_handler)();
+}
+
+__END_SYS
+
+#endif
@@ -0,0 +1,208 @@
+// EPOS EPOSMote III (ARM Cortex-M3) MCU RS-485 Mediator Implementation
+
+#include <machine/ic.h>
+#include <machine/rs485.h>
+#include <synchronizer.h>
+
+#ifdef __RS485_H
+
+__BEGIN_SYS
+
+// Class attributes
+RS485_Engine * RS485_Engine::_engines[UNITS];
+
+// Methods
+int RS485_Engine::send(const void * data, unsigned int size)
+{
+    db<RS485>(TRC) << "RS485::send(d=" << data << ",s=" << size << ")" << endl;
+
+    if(!dma || !size)
+        return 0;
+    if(size > MAX_FRAME) {
+        db<RS485>(WRN) << "RS485::send: frame too long!" << endl;
+        return 0;
+    }
+
+    // The frame goes out of the caller's buffer, which is only read while this thread sleeps
+    bool ie = CPU::int_enabled();
+    CPU::int_disable();
+    _sending = true;
+    out();
+    _pl011->int_clear(PL011::UIMTX);
+    udma()->setup(tx_channel(), data, true, _pl011->data(), false, size, PL230::SIZE_8, DMA_ARB);
+    udma()->enable(tx_channel());
+    if(ie)
+        CPU::int_enable();
+
+    _sent->p();
+
+    return size;
+}
+
+RS485_Engine::Frame * RS485_Engine::receive()
+{
+    return dma ? _frames->receive() : 0;
+}
+
+RS485_Engine::Frame * RS485_Engine::try_receive()
+{
+    return dma ? _frames->try_receive() : 0;
+}
+
+void RS485_Engine::free(Frame * frame)
+{
+    if(!dma)
+        return;
+
+    _frames->free(frame);
+
+    // Frames that came while every buffer was taken were dropped, but the next one can be received now
+    bool ie = CPU::int_enabled();
+    CPU::int_disable();
+    if(!_rx)
+        receive_next();
+    if(ie)
+        CPU::int_enable();
+}
+
+void RS485_Engine::framing()
+{
+    if(!dma)
+        return;
+
+    _pl011->fifo_levels(PL011::LEVEL_1_2, PL011::LEVEL_1_2);
+    _pl011->end_of_transmission(true);
+    _pl011->int_clear(~0);
+    _pl011->int_sources(PL011::UIMTX | PL011::UIMRT | PL011::UIMOE);
+}
+
+void RS485_Engine::dma_init()
+{
+    PL230 * u = udma();
+
+    db<RS485>(TRC) << "RS485::dma_init(unit=" << _unit << ")" << endl;
+
+    _frames = new (SYSTEM) Frames;
+    _sent = new (SYSTEM) Semaphore(0);
+    _rx = 0;
+    _error = false;
+    _sending = false;
+    _dropped = 0;
+
+    uDMA::init();
+    u->map(rx_channel(), 0);
+    u->map(tx_channel(), 0);
+    u->attributes(rx_channel(), true, true); // bursts only, so the tail of each frame is left for the time-out
+    u->attributes(tx_channel(), false, false);
+
+    framing();
+    _pl011->dma_enable(PL011::RXDMAE | PL011::TXDMAE);
+
+    _engines[_unit] = this;
+    in();
+    receive_next();
+
+    IC::int_vector(interrupt(), int_handler);
+    IC::enable(interrupt());
+}
+
+void RS485_Engine::dma_finish()
+{
+    IC::disable(interrupt());
+    udma()->disable(rx_channel());
+    udma()->disable(tx_channel());
+    _pl011->dma_disable(PL011::RXDMAE | PL011::TXDMAE);
+    _pl011->int_sources(PL011::UIMALL);
+    _engines[_unit] = 0;
+
+    delete _sent;
+    delete _frames;
+}
+
+// Points the RX channel at a free Frame, if there is one. Must be called with interrupts disabled.
+void RS485_Engine::receive_next()
+{
+    if(!_rx)
+        _rx = _frames->try_alloc();
+    if(_rx) {
+        udma()->setup(rx_channel(), _pl011->data(), false, _rx->data, true, MAX_FRAME, PL230::SIZE_8, DMA_ARB);
+        udma()->enable(rx_channel());
+    }
+}
+
+// The line has been idle for 32 bit periods, so whatever came since the last frame is a frame
+void RS485_Engine::received(bool error)
+{
+    PL230 * u = udma();
+    unsigned int n = 0;
+
+    if(_rx) {
+        u->disable(rx_channel());
+        n = MAX_FRAME - u->left(rx_channel());
+    }
+
+    // The last bytes, below the burst level, are still in the FIFO
+    while(_pl011->rxd_ok()) {
+        unsigned char c = _pl011->rxd();
+        if(_rx && (n < MAX_FRAME))
+            _rx->data[n++] = c;
+        else
+            error = true;
+    }
+    if(_pl011->errors()) {
+        error = true;
+        _pl011->clear_errors();
+    }
+
+    if(_rx && n && !error) {
+        db<RS485>(TRC) << "RS485::received(n=" << n << ")" << endl;
+        _rx->length = n;
+        _frames->send(_rx);
+        _rx = 0;
+    } else {
+        db<RS485>(WRN) << "RS485::received: frame dropped (n=" << n << ",e=" << error << ")!" << endl;
+        _dropped++;
+    }
+
+    receive_next();
+}
+
+// The last stop bit is out (EOT), so the bus can be released for the answer
+void RS485_Engine::sent()
+{
+    if(!_sending)
+        return;
+
+    in();
+    _sending = false;
+    _sent->v();
+}
+
+// The uDMA signals the completion of peripheral channels on the interrupt of the peripheral itself
+void RS485_Engine::int_handler(IC::Interrupt_Id i)
+{
+    unsigned int unit = (i == IC_Engine::INT_UART0) ? 0 : 1;
+    RS485_Engine * rs485 = (unit < UNITS) ? _engines[unit] : 0;
+    if(!rs485)
+        return;
+
+    PL230 * u = udma();
+    u->ack(u->done() & ((1 << rs485->rx_channel()) | (1 << rs485->tx_channel())));
+
+    Reg32 status = rs485->_pl011->int_status();
+    rs485->_pl011->int_clear(status);
+
+    if(status & PL011::UIMOE)
+        rs485->_error = true;
+    if(status & PL011::UIMTX)
+        rs485->sent();
+    if(status & PL011::UIMRT) {
+        bool error = rs485->_error;
+        rs485->_error = false;
+        rs485->received(error);
+    }
+}
+
+__END_SYS
+
+#endif
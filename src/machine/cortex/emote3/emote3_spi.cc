@@ -0,0 +1,152 @@
+// EPOS EPOSMoteIII (ARM Cortex-M3) SPI Mediator Implementation
+
+#include <machine/ic.h>
+#include <machine/spi.h>
+#include <synchronizer.h>
+
+#ifdef __SPI_H
+
+__BEGIN_SYS
+
+// Class attributes
+SPI_Engine * SPI_Engine::_engines[UNITS];
+const CPU::Reg32 SPI_Engine::_dma_zero = 0;
+CPU::Reg32 SPI_Engine::_dma_sink;
+
+// Methods
+void SPI_Engine::submit(Transaction * t, unsigned int n)
+{
+    db<SPI>(TRC) << "SPI::submit(t=" << t << ",n=" << n << ")" << endl;
+
+    if(!dma) {
+        for(unsigned int i = 0; i < n; i++)
+            run(&t[i]);
+        return;
+    }
+
+    bool ie = CPU::int_enabled();
+    CPU::int_disable();
+
+    for(unsigned int i = 0; i < n; i++) {
+        t[i]._offset = 0;
+        t[i]._done = false;
+        _queue.insert(&t[i]._link);
+    }
+    if(!_current)
+        next();
+
+    if(ie)
+        CPU::int_enable();
+}
+
+void SPI_Engine::transfer(const void * tx, void * rx, unsigned int size)
+{
+    Semaphore done(0);
+    Semaphore_Handler handler(&done);
+    Transaction t(tx, rx, size, &handler);
+
+    submit(&t);
+    done.p();
+}
+
+// Programs the uDMA for the next cycle of "t". RX drives completion: its last item arrives after the last one was sent.
+void SPI_Engine::start(Transaction * t)
+{
+    PL230 * u = udma();
+    unsigned int width = 1 << _size;
+    unsigned int left = t->_size - t->_offset;
+    const unsigned char * tx = reinterpret_cast<const unsigned char *>(t->_tx);
+    unsigned char * rx = reinterpret_cast<unsigned char *>(t->_rx);
+
+    _current = t;
+    _chunk = (left > PL230::MAX_TRANSFER) ? PL230::MAX_TRANSFER : left;
+
+    u->setup(rx_channel(), _pl022->data(), false, rx ? rx + t->_offset * width : reinterpret_cast<unsigned char *>(&_dma_sink), rx, _chunk, _size, DMA_ARB);
+    u->setup(tx_channel(), tx ? tx + t->_offset * width : reinterpret_cast<const unsigned char *>(&_dma_zero), tx, _pl022->data(), false, _chunk, _size, DMA_ARB);
+    u->enable(rx_channel());
+    u->enable(tx_channel());
+}
+
+// Starts the first queued Transaction that has anything to move. Must be called with interrupts disabled.
+void SPI_Engine::next()
+{
+    _current = 0;
+    while(!_current && !_queue.empty()) {
+        Transaction * t = _queue.remove()->object();
+        if(t->_size)
+            start(t);
+        else
+            finish(t);
+    }
+}
+
+void SPI_Engine::finish(Transaction * t)
+{
+    db<SPI>(TRC) << "SPI::finish(t=" << t << ")" << endl;
+
+    t->_done = true;
+    if(t->_handler)
+        (*t->_handler)();
+}
+
+// Moves "t" through the FIFOs, when the uDMA is not used
+void SPI_Engine::run(Transaction * t)
+{
+    const unsigned char * tx = reinterpret_cast<const unsigned char *>(t->_tx);
+    unsigned char * rx = reinterpret_cast<unsigned char *>(t->_rx);
+
+    for(unsigned int i = 0; i < t->_size; i++) {
+        if(_size == PL230::SIZE_16) {
+            _pl022->put(tx ? reinterpret_cast<const unsigned short *>(tx)[i] : 0);
+            Reg32 data = _pl022->get();
+            if(rx)
+                reinterpret_cast<unsigned short *>(rx)[i] = data;
+        } else {
+            _pl022->put(tx ? tx[i] : 0);
+            Reg32 data = _pl022->get();
+            if(rx)
+                rx[i] = data;
+        }
+    }
+
+    finish(t);
+}
+
+void SPI_Engine::dma_init()
+{
+    PL230 * u = udma();
+
+    uDMA::init();
+
+    u->map(rx_channel(), 0);
+    u->map(tx_channel(), 0);
+    u->attributes(rx_channel(), false, false);
+    u->attributes(tx_channel(), false, false);
+
+    _pl022->dma_enable(PL022::RXDMAE | PL022::TXDMAE);
+}
+
+// The uDMA signals the completion of peripheral channels on the interrupt of the peripheral itself
+void SPI_Engine::int_handler(IC::Interrupt_Id i)
+{
+    unsigned int unit = (i == IC_Engine::INT_SSI0) ? 0 : 1;
+    SPI_Engine * spi = (unit < UNITS) ? _engines[unit] : 0;
+    PL230 * u = udma();
+
+    if(!spi || !(u->done() & (1 << spi->rx_channel())))
+        return;
+    u->ack((1 << spi->rx_channel()) | (1 << spi->tx_channel()));
+
+    Transaction * t = spi->_current;
+    t->_offset += spi->_chunk;
+    if(t->_offset < t->_size)
+        spi->start(t);
+    else {
+        spi->finish(t);
+        spi->next();
+    }
+}
+
+__END_SYS
+
+#endif
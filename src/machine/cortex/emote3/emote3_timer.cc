@@ -0,0 +1,52 @@
+// EPOS EPOSMoteIII (ARM Cortex-M3) Timer Mediator Implementation
+
+#include <machine/ic.h>
+#include <machine/timer.h>
+
+__BEGIN_SYS
+
+// Class attributes
+Sleep_Timer::Count System_Timer_Engine::_sleep;
+
+// Class methods
+bool System_Timer_Engine::sleep(const Microsecond & time)
+{
+    // Deeper modes are only worth it if the CPU sleeps at least twice as long as it takes to wake up
+    unsigned int mode = DEEPEST_SLEEP;
+    while(mode && (time < 2 * latency(mode)))
+        mode--;
+    if(!mode)
+        return false;
+
+    Microsecond t = ((time > MAX_SLEEP) ? Microsecond(MAX_SLEEP) : time) - latency(mode);
+    Sleep_Timer::Count counts = static_cast<unsigned long long>(t) * Sleep_Timer::FREQUENCY / 1000000;
+
+    _sleep = smt()->read();
+    smt()->compare(_sleep + ((counts > Sleep_Timer::MIN_COMPARE) ? counts : Sleep_Timer::MIN_COMPARE));
+    IC::enable(IC::irq2int(NVIC::IRQ_SMT));
+
+    disable();
+    scb()->sleepdeep();
+    scr()->power_mode((mode == 1) ? SysCtrl::PM1 : SysCtrl::PM2);
+
+    return true;
+}
+
+Microsecond System_Timer_Engine::wakeup()
+{
+    // Whatever woke the CPU up, it is no longer in deep sleep, but it must be running on the 32-MHz XOSC again to tick
+    scb()->unsleepdeep();
+    scr()->power_mode(SysCtrl::PM0);
+    scr()->wait_clock();
+    IC::disable(IC::irq2int(NVIC::IRQ_SMT));
+
+    smt()->sync();
+    Sleep_Timer::Count slept = smt()->read() - _sleep;
+
+    reset();
+    enable();
+
+    return static_cast<unsigned long long>(slept) * 1000000 / Sleep_Timer::FREQUENCY;
+}
+
+__END_SYS
@@ -0,0 +1,11 @@
+// EPOS EPOSMoteIII (ARM Cortex-M3) uDMA Mediator Implementation
+
+#include <system/config.h>
+#include <machine/cortex/emote3/emote3_udma.h>
+
+__BEGIN_SYS
+
+// Class attributes
+PL230::Control uDMA::_table[uDMA::enabled ? PL230::TABLE_SIZE : 1];
+
+__END_SYS
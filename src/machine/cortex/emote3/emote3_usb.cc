@@ -2,6 +2,8 @@
 
 #include <machine/ic.h>
 #include <machine/usb.h>
+#include <machine/cortex/emote3/emote3_udma.h>
+#include <synchronizer.h>
 
 #ifdef __USB_H
 
@@ -16,6 +18,10 @@ volatile USB_2_0::STATE USB_Engine::_state;
 volatile bool USB_Engine::_ready_to_put = false;
 volatile bool USB_Engine::_ready_to_put_next = false;
 volatile bool USB_Engine::_locked = false;
+Semaphore * USB_Engine::_in_ready;
+Semaphore * USB_Engine::_out_ready;
+volatile bool USB_Engine::_in_waiting;
+volatile bool USB_Engine::_out_waiting;
 
 char USB_Engine::get()
 {
@@ -32,18 +38,23 @@ char USB_Engine::get()
     return ret;
 }
 
+// Takes the packets in the OUT FIFO (two, with double buffering) while they fit, a partially read one being left for
+// the next call
 int USB_Engine::read(char * out, unsigned int max_size)
 {
-    lock();
-    input();
-    int cont = 15;
-    while(!(usb(CSOL) & CSOL_OUTPKTRDY) && cont) cont--;
-    unsigned int i;
-    unsigned int sz = (usb(CNTH) << 8) | usb(CNT0_CNTL);
-    for(i = 0; (i<sz) && (i<max_size); i++)
-        out[i] = usb(F4);
-    if(i>=sz)
+    if(!wait_to_get())
+        return 0;
+
+    unsigned int i = 0;
+    do {
+        unsigned int sz = count();
+        unsigned int n = (sz < max_size - i) ? sz : max_size - i;
+        fifo_read(usb(F4), out + i, n);
+        i += n;
+        if(n < sz)
+            break;
         usb(CSOL) &= ~CSOL_OUTPKTRDY;
+    } while((i < max_size) && (usb(CSOL) & CSOL_OUTPKTRDY));
 
     unlock();
     return i;
@@ -67,24 +78,96 @@ void USB_Engine::put(char c)
     unlock();
 }
 
-int USB_Engine::write(const char * c, unsigned int size)
+// Sends "data" in full packets, as the IN FIFO (two packets, with double buffering) gets room for them. Unless blocking,
+// returns the bytes taken before the FIFO filled up.
+int USB_Engine::write(const char * data, unsigned int size)
 {
-    if(Traits<USB>::blocking) {
-        while(!ready_to_put());
-    } else {
-        if(!ready_to_put())
-            return 0;
+    unsigned int sent = 0;
+
+    while((sent < size) && wait_to_put()) {
+        unsigned int n = (size - sent < _max_packet_bulk) ? size - sent : _max_packet_bulk;
+        fifo_write(usb(F3), data + sent, n);
+        flush();
+        unlock();
+        sent += n;
     }
 
+    return sent;
+}
+
+// Both wait_to_*() return with the lock held and with the endpoint selected, if they return true
+bool USB_Engine::wait_to_get()
+{
+    lock();
+    input();
+    while(!configured() || !(usb(CSOL) & CSOL_OUTPKTRDY)) {
+        if(!blocking) {
+            unlock();
+            return false;
+        }
+        _out_waiting = true;
+        unlock();
+        _out_ready->p();
+        lock();
+        input();
+    }
+    return true;
+}
+
+bool USB_Engine::wait_to_put()
+{
     lock();
     output();
-    while(usb(CS0_CSIL) & CSIL_INPKTRDY);
-    for(unsigned int i = 0; (i < _max_packet_ep3) and (i < size); i++)
-        usb(F3) = c[i];
-    flush();
-    unlock();
+    while(!ready_to_put() || (usb(CS0_CSIL) & CSIL_INPKTRDY)) {
+        if(!blocking) {
+            unlock();
+            return false;
+        }
+        _in_waiting = true;
+        unlock();
+        _in_ready->p();
+        lock();
+        output();
+    }
+    return true;
+}
 
-    return size;
+// Called by handle_int(), so waiters that are about to sleep (i.e. that have just unlocked) don't miss the wake-up
+void USB_Engine::wake(Semaphore * s, volatile bool & waiting)
+{
+    if(waiting) {
+        waiting = false;
+        s->v();
+    }
+}
+
+// The uDMA runs a whole packet per software request, while the CPU waits (for a few microseconds at most)
+void USB_Engine::fifo_read(volatile Reg32 & fifo, char * data, unsigned int size)
+{
+    if(dma && size) {
+        PL230 * u = uDMA::controller();
+        u->setup(DMA_OUT_CHANNEL, &fifo, false, data, true, size, PL230::SIZE_8, 6, false, PL230::MODE_AUTO);
+        u->enable(DMA_OUT_CHANNEL);
+        u->request(DMA_OUT_CHANNEL);
+        while(u->enabled(DMA_OUT_CHANNEL));
+        u->ack(1 << DMA_OUT_CHANNEL);
+    } else
+        for(unsigned int i = 0; i < size; i++)
+            data[i] = fifo;
+}
+
+void USB_Engine::fifo_write(volatile Reg32 & fifo, const char * data, unsigned int size)
+{
+    if(dma && size) {
+        PL230 * u = uDMA::controller();
+        u->setup(DMA_IN_CHANNEL, data, true, &fifo, false, size, PL230::SIZE_8, 6, false, PL230::MODE_AUTO);
+        u->enable(DMA_IN_CHANNEL);
+        u->request(DMA_IN_CHANNEL);
+        while(u->enabled(DMA_IN_CHANNEL));
+        u->ack(1 << DMA_IN_CHANNEL);
+    } else
+        for(unsigned int i = 0; i < size; i++)
+            fifo = data[i];
 }
 
 bool USB_Engine::handle_ep0(const USB_2_0::Request::Device_Request & data)
@@ -236,11 +319,17 @@ void USB_Engine::handle_int(IC::Interrupt_Id interrupt)
             }
         }
 
+        // Endpoint 3 has room for another packet, or the host has just opened the port
+        if((flags & (1 << 3)) || _ready_to_put)
+            wake(_in_ready, _in_waiting);
+
         db<USB>(TRC) << "IIF = " << flags << endl;
     }
 
     if((flags = _oif)) {
         _oif = 0;
+        if(flags & (1 << 4)) // Endpoint 4 got a packet
+            wake(_out_ready, _out_waiting);
         db<USB>(TRC) << "OIF = " << flags << endl;
     }
 
@@ -4,6 +4,9 @@
 #include <machine/ic.h>
 #include <machine/usb.h>
 #include <machine/cortex/emote3/emote3_sysctrl.h>
+#include <machine/cortex/emote3/emote3_udma.h>
+#include <synchronizer.h>
+#include <system.h>
 
 __USING_SYS
 
@@ -109,7 +112,7 @@ const USB_Engine::Full_Config USB_Engine::_config =
         DESC_ENDPOINT,               // Descriptor type (DESC_ENDPOINT)
         3 | (1 << 7),                // Encoded Address: Endpoint 3, IN
         EP_ATTR_BULK,                // Endpoint attributes (Bulk endpoint)
-        32,                          // Maximum packet size this endpoint is capable of sending or receiving at once
+        _max_packet_bulk,            // Maximum packet size this endpoint is capable of sending or receiving at once
         0x00                         // Interval (ignored for Bulk operation)
     },
     //_endpoint2_descriptor =
@@ -118,7 +121,7 @@ const USB_Engine::Full_Config USB_Engine::_config =
         DESC_ENDPOINT,               // Descriptor type (DESC_ENDPOINT)
         4,                           // Encoded address: Endpoint 4, OUT
         EP_ATTR_BULK,                // Endpoint attributes (Bulk endpoint)
-        _max_packet_ep4,             // Maximum packet size this endpoint is capable of sending or receiving at once
+        _max_packet_bulk,            // Maximum packet size this endpoint is capable of sending or receiving at once
         0x00                         // Interval (ignored for Bulk operation)
     }
 };
@@ -132,11 +135,11 @@ void USB_Engine::reset()
     _send_buffer = reinterpret_cast<const char *>(0);
     _send_buffer_size = 0;
 
-    // Set up endpoints
+    // Set up endpoints, both bulk ones double-buffered
     output();
-    // The two lines below make the USB automatically signal that a packet is ready every 32 characters.
-    usb(MAXI) = 32 / 8; // Endpoint 3, IN.
+    usb(MAXI) = _max_packet_bulk / 8; // Endpoint 3, IN.
     usb(MAXO) = 0;
+    usb(CSIH) |= INDBLBUF;
     usb(CS0_CSIL) |= CSIL_CLRDATATOG; // From cc2538 User Guide: When a Bulk IN endpoint is first configured, USB_CSIL.CLRDATATOG should be set.
     // if there are any data packets in the FIFO, they should be flushed. It may be necessary to set this bit twice in succession if double buffering is enabled.
     usb(CS0_CSIL) |= CSIL_FLUSHPACKET;
@@ -144,15 +147,17 @@ void USB_Engine::reset()
 
     input();
     usb(MAXI) = 0;
-    usb(MAXO) = _max_packet_ep4 / 8; // Endpoint 4, OUT
+    usb(MAXO) = _max_packet_bulk / 8; // Endpoint 4, OUT
+    usb(CSOH) |= OUTDBLBUF;
     usb(CSOL) |= CSOL_CLRDATATOG; // From cc2538 User Guide: When a Bulk OUT endpoint is first configured, USB_CSOL.CLRDATATOG should be set.
-    // if there are any data packets in the FIFO, they should be flushed
+    // if there are any data packets in the FIFO, they should be flushed (twice, since it is double-buffered)
+    usb(CSOL) |= CSOL_FLUSHPACKET;
     usb(CSOL) |= CSOL_FLUSHPACKET;
 
-    // Only enable IN interrupts for endpoints 0 and 2
-    usb(IIE) = (1 << 0);// | (1 << 2);
-    // Only enable OUT interrupts for endpoint 0
-    usb(OIE) = (1 << 0);
+    // Only enable IN interrupts for endpoint 0 (and 3, to wake blocked writers)
+    usb(IIE) = (1 << 0) | (blocking ? (1 << 3) : 0);
+    // Only enable OUT interrupts for endpoint 0 (and 4, to wake blocked readers)
+    usb(OIE) = (1 << 0) | (blocking ? (1 << 4) : 0);
     // Only enable RESET common interrupt (disable start-of-frame, resume and suspend)
     usb(CIE) = INT_RESET;
 }
@@ -176,6 +181,20 @@ void USB_Engine::init()
     // Do not suspend the device when USB is idle
     usb(POW) &= ~SUSPENDEN;
 
+    if(blocking && !_in_ready) {
+        _in_ready = new (SYSTEM) Semaphore(0);
+        _out_ready = new (SYSTEM) Semaphore(0);
+    }
+
+    if(dma) {
+        uDMA::init();
+        PL230 * u = uDMA::controller();
+        u->attributes(DMA_OUT_CHANNEL, false, false);
+        u->attributes(DMA_IN_CHANNEL, false, false);
+        u->mask(DMA_OUT_CHANNEL);
+        u->mask(DMA_IN_CHANNEL);
+    }
+
     reset();
 
     _state = USB_2_0::STATE::POWERED;
@@ -7,6 +7,11 @@ __BEGIN_SYS
 void Zynq::init()
 {
     unlock_slcr();
+
+    if(Traits<FPGA>::enabled && Traits<FPGA>::CLOCK)
+        if(fpga0_clk_freq(Traits<FPGA>::CLOCK) < 0)
+            db<Init, Machine>(WRN) << "Zynq::init: can't clock the PL at " << Traits<FPGA>::CLOCK << " Hz!" << endl;
+
     fpga_reset();
 }
 
@@ -10,6 +10,12 @@ __BEGIN_SYS
 
 // Class attributes
 VGA::Frame_Buffer VGA::_frame_buffer;
+VGA::Cell VGA::_shadow[];
+unsigned int VGA::_top;
+volatile unsigned int VGA::_dirty;
+volatile unsigned int VGA::_position;
+unsigned int VGA::_cursor;
+int VGA::_countdown;
 
 __END_SYS
 
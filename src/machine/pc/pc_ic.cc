@@ -2,8 +2,11 @@
 
 #include <architecture.h>
 #include <machine/ic.h>
+#include <machine/pci.h>
 #include <machine/timer.h>
 #include <process.h>
+#include <utility/latency.h>
+#include <utility/trace.h>
 
 extern "C" { void _exit(int s); }
 extern "C" { void __exit(); }
@@ -12,6 +15,12 @@ __BEGIN_SYS
 
 APIC::Log_Addr APIC::_base;
 IC::Interrupt_Handler IC::_int_vector[IC::INTS];
+CPU::Reg16 IC::_enabled;
+unsigned int IC::_level;
+unsigned int IC::_priority[IC::IRQS];
+unsigned int IC::_nesting[IC::CPUS];
+bool IC::_rescheduling[IC::CPUS];
+char IC::_stack[IC::CPUS][IC::STACK_SIZE] __attribute__((aligned(16)));
 
 
 void APIC::ipi_init(volatile int * status)
@@ -66,17 +75,80 @@ void APIC::ipi(unsigned int cpu, unsigned int interrupt)
 }
 
 
+bool IC::affinity(Interrupt_Id i, unsigned long cpus)
+{
+    db<IC>(TRC) << "IC::affinity(int=" << i << ",cpus=" << cpus << ")" << endl;
+    assert(i < INTS);
+
+    unsigned int cpu = 0;
+    for(; (cpu < CPUS) && !(cpus & (1UL << cpu)); cpu++);
+    if(cpu == CPUS)
+        return false;
+
+    if((i < INT_FIRST_MSI) || !PCI::msi_affinity(i, cpu)) {
+        db<IC>(WRN) << "IC::affinity: interrupt " << i << " can't be steered!" << endl;
+        return false;
+    }
+
+    return true;
+}
+
+
 void IC::dispatch(unsigned int i)
 {
+    unsigned int cpu = CPU::id();
+
+    if(!deferring || _nesting[cpu]) {
+        serve(i);
+        return;
+    }
+
+    _nesting[cpu]++;
+    if(STACK_SIZE)
+        CPU::stack_call(reinterpret_cast<Reg>(&_stack[cpu][STACK_SIZE]), &serve, i);
+    else
+        serve(i);
+    CPU::int_disable(); // handlers might have enabled interrupts
+    _nesting[cpu]--;
+
+    if(_rescheduling[cpu]) {
+        _rescheduling[cpu] = false;
+        Thread::rescheduler(i);
+    }
+}
+
+void IC::serve(unsigned int i)
+{
+    if((Latency::enabled || Trace::enabled) && (i == INT_SYS_TIMER)) {
+        TSC::Time_Stamp late = Timer::late();
+        Latency::timer_interrupt(late);
+        Trace::interrupt(i, late);
+    } else
+        Trace::interrupt(i);
+
     bool not_spurious = true;
     if((i >= INT_FIRST_HARD) && (i <= INT_LAST_HARD))
         not_spurious = eoi(i);
+    else if(((i >= INT_FIRST_MSI) && (i <= INT_LAST_MSI)) || (i == INT_ONE_SHOT))
+        APIC::eoi(i);
     if(not_spurious) {
 
         if((i != INT_SYS_TIMER) || Traits<IC>::hysterically_debugged)
             db<IC>(TRC) << "IC::dispatch(i=" << i << ")" << endl;
 
-        _int_vector[i](i);
+        if(Traits<IC>::nested && (i >= INT_FIRST_HARD) && (i < INT_FIRST_HARD + IRQS)) {
+            // The EOI has already been sent, so only IRQs of higher priority can preempt the handler
+            unsigned int l = _level;
+            unsigned int p = _priority[Engine::int2irq(i)];
+            if(p > l)
+                level(p);
+            CPU::int_enable();
+            _int_vector[i](i);
+            CPU::int_disable();
+            if(p > l)
+                level(l);
+        } else
+            _int_vector[i](i);
     } else {
         if(i != INT_LAST_HARD)
             db<IC>(TRC) << "IC::spurious interrupt (" << i << ")" << endl;
@@ -247,57 +319,58 @@ void IC::entry()
 
         // On a regular PC, only the first 32 exceptions and the subsequent 16 interrupts are useful
         // We also left two spare entries for multicore IPIs and an interrupt-based system call mechanism
-//      "       jmp     1f                                              \n"
-//      "       .align 16                                               \n"
-//      "       movl    $50, %0                                         \n"
-//      "       jmp     1f                                              \n"
-//      "       .align 16                                               \n"
-//      "       movl    $51, %0                                         \n"
-//      "       jmp     1f                                              \n"
-//      "       .align 16                                               \n"
-//      "       movl    $52, %0                                         \n"
-//      "       jmp     1f                                              \n"
-//      "       .align 16                                               \n"
-//      "       movl    $53, %0                                         \n"
-//      "       jmp     1f                                              \n"
-//      "       .align 16                                               \n"
-//      "       movl    $54, %0                                         \n"
-//      "       jmp     1f                                              \n"
-//      "       .align 16                                               \n"
-//      "       movl    $55, %0                                         \n"
-//      "       jmp     1f                                              \n"
-//      "       .align 16                                               \n"
-//      "       movl    $56, %0                                         \n"
-//      "       jmp     1f                                              \n"
-//      "       .align 16                                               \n"
-//      "       movl    $57, %0                                         \n"
-//      "       jmp     1f                                              \n"
-//      "       .align 16                                               \n"
-//      "       movl    $58, %0                                         \n"
-//      "       jmp     1f                                              \n"
-//      "       .align 16                                               \n"
-//      "       movl    $59, %0                                         \n"
-//      "       jmp     1f                                              \n"
-//      "       .align 16                                               \n"
-//      "       movl    $60, %0                                         \n"
-//      "       jmp     1f                                              \n"
-//      "       .align 16                                               \n"
-//      "       movl    $61, %0                                         \n"
-//      "       jmp     1f                                              \n"
-//      "       .align 16                                               \n"
-//      "       movl    $62, %0                                         \n"
-//      "       jmp     1f                                              \n"
-//      "       .align 16                                               \n"
-//      "       movl    $63, %0                                         \n"
-//      "       jmp     1f                                              \n"
-//      "       .align 16                                               \n"
-//      "       movl    $64, %0                                         \n"
-//      "       jmp     1f                                              \n"
-//      "       .align 16                                               \n"
-//      "       movl    $65, %0                                         \n"
-//      "       jmp     1f                                              \n"
-//      "       .align 16                                               \n"
-//      "       movl    $66, %0                                         \n"
+        // The next 16 are for PCI MSI/MSI-X (see Traits<IC>::MSI_VECTORS)
+        "       jmp     1f                                              \n"
+        "       .align 16                                               \n"
+        "       movl    $50, %0                                         \n"
+        "       jmp     1f                                              \n"
+        "       .align 16                                               \n"
+        "       movl    $51, %0                                         \n"
+        "       jmp     1f                                              \n"
+        "       .align 16                                               \n"
+        "       movl    $52, %0                                         \n"
+        "       jmp     1f                                              \n"
+        "       .align 16                                               \n"
+        "       movl    $53, %0                                         \n"
+        "       jmp     1f                                              \n"
+        "       .align 16                                               \n"
+        "       movl    $54, %0                                         \n"
+        "       jmp     1f                                              \n"
+        "       .align 16                                               \n"
+        "       movl    $55, %0                                         \n"
+        "       jmp     1f                                              \n"
+        "       .align 16                                               \n"
+        "       movl    $56, %0                                         \n"
+        "       jmp     1f                                              \n"
+        "       .align 16                                               \n"
+        "       movl    $57, %0                                         \n"
+        "       jmp     1f                                              \n"
+        "       .align 16                                               \n"
+        "       movl    $58, %0                                         \n"
+        "       jmp     1f                                              \n"
+        "       .align 16                                               \n"
+        "       movl    $59, %0                                         \n"
+        "       jmp     1f                                              \n"
+        "       .align 16                                               \n"
+        "       movl    $60, %0                                         \n"
+        "       jmp     1f                                              \n"
+        "       .align 16                                               \n"
+        "       movl    $61, %0                                         \n"
+        "       jmp     1f                                              \n"
+        "       .align 16                                               \n"
+        "       movl    $62, %0                                         \n"
+        "       jmp     1f                                              \n"
+        "       .align 16                                               \n"
+        "       movl    $63, %0                                         \n"
+        "       jmp     1f                                              \n"
+        "       .align 16                                               \n"
+        "       movl    $64, %0                                         \n"
+        "       jmp     1f                                              \n"
+        "       .align 16                                               \n"
+        "       movl    $65, %0                                         \n"
+        "       jmp     1f                                              \n"
+        "       .align 16                                               \n"
+        "       movl    $66, %0                                         \n"
 //      "       jmp     1f                                              \n"
 //      "       .align 16                                               \n"
 //      "       movl    $67, %0                                         \n"
@@ -878,6 +951,11 @@ void IC::int_not(Interrupt_Id i)
     db<IC,Machine>(WRN) << "IC::int_not(i=" << i << ")" << endl;
 }
 
+bool IC::lazy_pf()
+{
+    return MMU::fault(CPU::cr2());
+}
+
 // Exception and fault handlers
 void IC::exc_not(Reg eip, Reg cs, Reg eflags, Reg error)
 {
@@ -886,6 +964,21 @@ void IC::exc_not(Reg eip, Reg cs, Reg eflags, Reg error)
     _exit(-1);
 }
 
+// Faults on lazy pages (see MMU::Chunk) are served and the faulting instruction restarted, while the others go to exc_pf()
+// Nothing but assembly here, so the compiler has no chance to touch registers before they are saved
+void IC::exc_lpf(Reg eip, Reg cs, Reg eflags, Reg error)
+{
+    ASM("       pusha                           # save the interrupted context          \n"
+        "       call    %P0                     # lazy_pf()                             \n"
+        "       test    %%al, %%al                                                      \n"
+        "       jz      1f                                                              \n"
+        "       popa                                                                    \n"
+        "       add     $4, %%esp               # drop the error code                   \n"
+        "       iret                                                                    \n"
+        "1:     popa                                                                    \n"
+        "       jmp     %P1                     # exc_pf(), with the stack as it was    \n" : : "i"(&lazy_pf), "i"(&exc_pf));
+}
+
 void IC::exc_pf(Reg eip, Reg cs, Reg eflags, Reg error)
 {
     db<IC,Machine>(WRN) << "IC::exc_pf[address=" << reinterpret_cast<void *>(CPU::cr2()) << "](cs=" << hex << cs << ",ip=" << reinterpret_cast<void *>(eip) << ",sp=" << CPU::sp() << ",fl=" << hex << eflags << dec << ",err=";
@@ -20,7 +20,7 @@ void IC::init()
             idt[i] = CPU::IDT_Entry(CPU::SEL_SYS_CODE, Log_Addr(entry) + CPU::EXC_LAST * 16, CPU::SEG_IDT_ENTRY);
 
     // Install some important exception handlers
-    idt[CPU::EXC_PF]     = CPU::IDT_Entry(CPU::SEL_SYS_CODE, Log_Addr(&exc_pf),  CPU::SEG_IDT_ENTRY);
+    idt[CPU::EXC_PF]     = CPU::IDT_Entry(CPU::SEL_SYS_CODE, Log_Addr(&exc_lpf), CPU::SEG_IDT_ENTRY);
     idt[CPU::EXC_DOUBLE] = CPU::IDT_Entry(CPU::SEL_SYS_CODE, Log_Addr(&exc_pf),  CPU::SEG_IDT_ENTRY);
     idt[CPU::EXC_GPF]    = CPU::IDT_Entry(CPU::SEL_SYS_CODE, Log_Addr(&exc_gpf), CPU::SEG_IDT_ENTRY);
     idt[CPU::EXC_NODEV]  = CPU::IDT_Entry(CPU::SEL_SYS_CODE, Log_Addr(&exc_fpu), CPU::SEG_IDT_ENTRY);
@@ -29,9 +29,18 @@ void IC::init()
     for(unsigned int i = 0; i < INTS; i++)
  	_int_vector[i] = int_not;
 
+    for(unsigned int i = 0; i < IRQS; i++)
+        _priority[i] = Traits<IC>::priority(i);
+
     remap();
     disable();
 
+    // MSIs are written to the local APIC, which SETUP left disabled. The 8259A keeps coming through LINT0 (virtual wire).
+    if(Traits<IC>::MSI_VECTORS) {
+        APIC::remap();
+        APIC::enable();
+    }
+
     CPU::int_enable();
 }
 
@@ -78,6 +78,8 @@ Observed PS2_Keyboard::_observed;
 // Methods
 char PS2_Keyboard::get()
 {
+    ready();
+
     char c = map(scancode());
     while(c == -1)
         c = map(scancode());
@@ -22,16 +22,16 @@ void Machine::init()
     if(Traits<Timer>::enabled)
         Timer::init();
 
-    if(Traits<PCI>::enabled)
+    if(Traits<PCI>::enabled && !Traits<PCI>::lazy)
         PCI::init();
 
 #ifdef __SCRATCHPAD_H
-    if(Traits<Scratchpad>::enabled)
+    if(Traits<Scratchpad>::enabled && !Traits<Scratchpad>::lazy)
         Scratchpad::init();
 #endif
 
 #ifdef __KEYBOARD_H
-    if(Traits<Keyboard>::enabled)
+    if(Traits<Keyboard>::enabled && !Traits<Keyboard>::lazy)
         Keyboard::init();
 #endif
 
@@ -39,6 +39,11 @@ void Machine::init()
     if(Traits<FPGA>::enabled)
         FPGA::init();
 #endif
+
+#ifdef __NIC_H
+    if(Traits<PCNet32>::enabled)
+        PCNet32::init();
+#endif
 }
 
 __END_SYS
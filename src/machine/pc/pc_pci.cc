@@ -1,20 +1,28 @@
 // EPOS PC PCI Mediator
 
 #include <machine/pci.h>
+#include <system.h>
 
 __BEGIN_SYS
 
 // Class attributes
 PCI::Phy_Addr PCI::_phy_io_mem;
+volatile PCI::Reg8 * PCI::_ecam;
+unsigned int PCI::_ecam_first_bus;
+unsigned int PCI::_ecam_last_bus;
 PCI::Reg32 PCI::_base_address[Region::N] = {
     BASE_ADDRESS_0, BASE_ADDRESS_1,
     BASE_ADDRESS_2, BASE_ADDRESS_3,
     BASE_ADDRESS_4, BASE_ADDRESS_5
 };
+unsigned int PCI::_msi_next = IC::INT_FIRST_MSI;
+PCI::Route PCI::_msi_routes[Traits<IC>::MSI_VECTORS ? Traits<IC>::MSI_VECTORS : 1];
 
 // Methods
 void PCI::header(const PCI::Locator & l, PCI::Header * h)
 {
+    ready();
+
     h->vendor_id = cfg16(l.bus, l.dev_fn, VENDOR_ID);
     if((h->vendor_id != 0) && (h->vendor_id != 0xffff)) {
         h->locator = l;
@@ -73,6 +81,8 @@ PCI::Locator PCI::scan(const PCI::Class_Id & c, int order)
 {
     db<PCI>(TRC) << "PCI::scan(class=" << c << ",order=" << order << ")" << endl;
 
+    ready();
+
     for(int bus = 0 ; bus <= MAX_BUS; bus++)
         for(int dfn = 0; dfn <= MAX_DEV_FN; dfn++)
             if(class_id(bus, dfn) == c)
@@ -86,6 +96,8 @@ PCI::Locator PCI::scan(const PCI::Vendor_Id & v, const PCI::Device_Id & d, int o
 {
     db<PCI>(TRC) << "PCI::scan(vend=" << v << ",dev=" << d << ",order=" << order << ")" << endl;
 
+    ready();
+
     for(int bus = 0 ; bus <= MAX_BUS; bus++)
         for(int dfn = 0; dfn <= MAX_DEV_FN; dfn++)
             if((vendor_id(bus, dfn) == v) && (device_id(bus, dfn) == d))
@@ -95,4 +107,206 @@ PCI::Locator PCI::scan(const PCI::Vendor_Id & v, const PCI::Device_Id & d, int o
     return Locator(Locator::INVALID, Locator::INVALID);
 }
 
+PCI::Reg8 PCI::capability(const Locator & l, Reg8 id)
+{
+    if(!(cfg16(l.bus, l.dev_fn, STATUS) & STATUS_CAP_LIST))
+        return 0;
+
+    // Capabilities live between 0x40 and 0xff, so there can't be more than 48 of them (this also stops on broken lists)
+    Reg8 cap = cfg8(l.bus, l.dev_fn, CAPABILITIES) & ~3;
+    for(unsigned int i = 0; cap && (i < 48); i++) {
+        if(cfg8(l.bus, l.dev_fn, cap + CAP_ID) == id)
+            return cap;
+        cap = cfg8(l.bus, l.dev_fn, cap + CAP_NEXT) & ~3;
+    }
+
+    return 0;
+}
+
+PCI::Reg16 PCI::extended_capability(const Locator & l, Reg16 id)
+{
+    if(!ecam(l.bus, l.dev_fn, 0))
+        return 0;
+
+    // Each header takes at least 4 bytes of the extended space, which also bounds broken lists
+    Reg16 cap = EXT_CAPABILITIES;
+    for(unsigned int i = 0; cap && (i < (EXT_CONFIG_SIZE - EXT_CAPABILITIES) / 4); i++) {
+        Reg32 header = cfg32(l.bus, l.dev_fn, cap);
+        if((header == 0) || (header == 0xffffffff)) // no extended capabilities at all
+            return 0;
+        if((header & EXT_CAP_ID_MASK) == id)
+            return cap;
+        cap = (header >> EXT_CAP_NEXT_SHIFT) & ~3;
+        if(cap && (cap < EXT_CAPABILITIES))
+            return 0;
+    }
+
+    return 0;
+}
+
+IC_Common::Interrupt_Id PCI::msi(const Locator & l, unsigned int n, unsigned int cpu)
+{
+    db<PCI>(TRC) << "PCI::msi(l=" << l << ",n=" << n << ",cpu=" << cpu << ")" << endl;
+
+    Reg8 cap = capability(l, CAP_ID_MSI);
+    if(!cap) {
+        db<PCI>(WRN) << "PCI::msi: device " << l << " has no MSI capability!" << endl;
+        return IC_Common::INT_UNKNOWN;
+    }
+
+    // The device sets the lower log2(n) bits of the data to tell the interrupts apart, so n vectors aligned to n are needed
+    Reg16 control = cfg16(l.bus, l.dev_fn, cap + MSI_CONTROL);
+    unsigned int log2n = 0;
+    while((1U << log2n) < n)
+        log2n++;
+    if(!n || (n != (1U << log2n)) || (log2n > ((control & MSI_CONTROL_MMC_MASK) >> MSI_CONTROL_MMC_SHIFT))) {
+        db<PCI>(WRN) << "PCI::msi: device " << l << " can't take " << n << " interrupts!" << endl;
+        return IC_Common::INT_UNKNOWN;
+    }
+
+    IC_Common::Interrupt_Id first = msi_alloc(n, n);
+    if(first == IC_Common::INT_UNKNOWN)
+        return first;
+
+    cfg32(l.bus, l.dev_fn, cap + MSI_ADDRESS, msi_address(cpu));
+    if(control & MSI_CONTROL_64) {
+        cfg32(l.bus, l.dev_fn, cap + MSI_ADDRESS_HI, 0);
+        cfg16(l.bus, l.dev_fn, cap + MSI_DATA_64, first); // fixed delivery, edge triggered
+    } else
+        cfg16(l.bus, l.dev_fn, cap + MSI_DATA_32, first);
+    control = (control & ~MSI_CONTROL_MME_MASK) | (log2n << MSI_CONTROL_MME_SHIFT) | MSI_CONTROL_ENABLE;
+    cfg16(l.bus, l.dev_fn, cap + MSI_CONTROL, control);
+    msi_route(first, n, l, cap, false);
+
+    command(l, command(l) | COMMAND_INTX_DISABLE);
+
+    db<PCI>(INF) << "PCI::msi: device " << l << " => [" << first << "," << first + n - 1 << "]" << endl;
+
+    return first;
+}
+
+IC_Common::Interrupt_Id PCI::msix(const Locator & l, unsigned int n, unsigned int cpu)
+{
+    db<PCI>(TRC) << "PCI::msix(l=" << l << ",n=" << n << ",cpu=" << cpu << ")" << endl;
+
+    Reg8 cap = capability(l, CAP_ID_MSIX);
+    if(!cap) {
+        db<PCI>(WRN) << "PCI::msix: device " << l << " has no MSI-X capability!" << endl;
+        return IC_Common::INT_UNKNOWN;
+    }
+
+    Reg16 control = cfg16(l.bus, l.dev_fn, cap + MSIX_CONTROL);
+    unsigned int size = (control & MSIX_CONTROL_SIZE_MASK) + 1;
+    if(!n || (n > size)) {
+        db<PCI>(WRN) << "PCI::msix: device " << l << " can't take " << n << " interrupts!" << endl;
+        return IC_Common::INT_UNKNOWN;
+    }
+
+    volatile Reg32 * table = msix_table(l, cap);
+    if(!table) {
+        db<PCI>(WRN) << "PCI::msix: device " << l << " has its MSI-X table out of the I/O memory!" << endl;
+        return IC_Common::INT_UNKNOWN;
+    }
+
+    IC_Common::Interrupt_Id first = msi_alloc(n, 1);
+    if(first == IC_Common::INT_UNKNOWN)
+        return first;
+
+    // The whole function is masked while the table is written
+    cfg16(l.bus, l.dev_fn, cap + MSIX_CONTROL, control | MSIX_CONTROL_ENABLE | MSIX_CONTROL_MASK);
+    for(unsigned int i = 0; i < size; i++) {
+        volatile Reg32 * entry = table + i * MSIX_ENTRY_SIZE / sizeof(Reg32);
+        if(i < n) {
+            entry[MSIX_ENTRY_ADDRESS / sizeof(Reg32)] = msi_address(cpu);
+            entry[MSIX_ENTRY_ADDRESS_HI / sizeof(Reg32)] = 0;
+            entry[MSIX_ENTRY_DATA / sizeof(Reg32)] = first + i;
+            entry[MSIX_ENTRY_CONTROL / sizeof(Reg32)] = 0;
+        } else
+            entry[MSIX_ENTRY_CONTROL / sizeof(Reg32)] = MSIX_ENTRY_MASKED;
+    }
+    cfg16(l.bus, l.dev_fn, cap + MSIX_CONTROL, (control | MSIX_CONTROL_ENABLE) & ~MSIX_CONTROL_MASK);
+    msi_route(first, n, l, cap, true);
+
+    command(l, command(l) | COMMAND_INTX_DISABLE);
+
+    db<PCI>(INF) << "PCI::msix: device " << l << " => [" << first << "," << first + n - 1 << "]" << endl;
+
+    return first;
+}
+
+void PCI::msix_mask(const Locator & l, unsigned int entry, bool masked)
+{
+    Reg8 cap = capability(l, CAP_ID_MSIX);
+    volatile Reg32 * table = cap ? msix_table(l, cap) : 0;
+    if(!table)
+        return;
+
+    table[(entry * MSIX_ENTRY_SIZE + MSIX_ENTRY_CONTROL) / sizeof(Reg32)] = masked ? MSIX_ENTRY_MASKED : 0;
+}
+
+bool PCI::msi_affinity(IC_Common::Interrupt_Id i, unsigned int cpu)
+{
+    db<PCI>(TRC) << "PCI::msi_affinity(int=" << i << ",cpu=" << cpu << ")" << endl;
+
+    if((i < IC::INT_FIRST_MSI) || (i > IC::INT_LAST_MSI) || !_msi_routes[i - IC::INT_FIRST_MSI].cap)
+        return false;
+
+    const Route & r = _msi_routes[i - IC::INT_FIRST_MSI];
+    if(r.msix) {
+        volatile Reg32 * table = msix_table(r.locator, r.cap);
+        if(!table)
+            return false;
+
+        // The entry is masked while its address changes, so the device never sees half of it
+        volatile Reg32 * entry = table + r.entry * MSIX_ENTRY_SIZE / sizeof(Reg32);
+        Reg32 control = entry[MSIX_ENTRY_CONTROL / sizeof(Reg32)];
+        entry[MSIX_ENTRY_CONTROL / sizeof(Reg32)] = control | MSIX_ENTRY_MASKED;
+        entry[MSIX_ENTRY_ADDRESS / sizeof(Reg32)] = msi_address(cpu);
+        entry[MSIX_ENTRY_CONTROL / sizeof(Reg32)] = control;
+    } else
+        cfg32(r.locator.bus, r.locator.dev_fn, r.cap + MSI_ADDRESS, msi_address(cpu));
+
+    return true;
+}
+
+void PCI::msi_route(IC_Common::Interrupt_Id first, unsigned int n, const Locator & l, Reg8 cap, bool msix)
+{
+    for(unsigned int i = 0; i < n; i++) {
+        Route & r = _msi_routes[first + i - IC::INT_FIRST_MSI];
+        r.locator = l;
+        r.cap = cap;
+        r.msix = msix;
+        r.entry = i;
+    }
+}
+
+// Vectors are taken by drivers at initialization and never returned, so a bump allocator will do
+IC_Common::Interrupt_Id PCI::msi_alloc(unsigned int n, unsigned int align)
+{
+    unsigned int first = (_msi_next + align - 1) & ~(align - 1);
+    if(first + n > IC::INT_LAST_MSI + 1) {
+        db<PCI>(WRN) << "PCI::msi: out of MSI vectors (see Traits<IC>::MSI_VECTORS)!" << endl;
+        return IC_Common::INT_UNKNOWN;
+    }
+    _msi_next = first + n;
+
+    return first;
+}
+
+volatile PCI::Reg32 * PCI::msix_table(const Locator & l, Reg8 cap)
+{
+    Reg32 table = cfg32(l.bus, l.dev_fn, cap + MSIX_TABLE);
+    if((table & MSIX_BIR_MASK) >= Region::N)
+        return 0;
+    Reg32 bar = cfg32(l.bus, l.dev_fn, _base_address[table & MSIX_BIR_MASK]);
+    if(bar & BASE_ADDRESS_SPACE_IO)
+        return 0;
+
+    Phy_Addr phy = (bar & BASE_ADDRESS_MEM_MASK) + (table & ~MSIX_BIR_MASK);
+    if((phy < _phy_io_mem) || (phy >= System::info()->bm.mio_top))
+        return 0;
+
+    return phy2log(phy);
+}
+
 __END_SYS
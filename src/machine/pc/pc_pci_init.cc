@@ -22,6 +22,15 @@ void PCI::init()
     CPU::out32(CONFADDR, tmp);
 
     CPU::int_enable();
+
+    if(Traits<PCI>::ecam && System::info()->ecam.phy) {
+        _ecam = reinterpret_cast<volatile Reg8 *>(System::info()->ecam.log);
+        _ecam_first_bus = System::info()->ecam.first_bus;
+        _ecam_last_bus = System::info()->ecam.last_bus;
+
+        db<Init, PCI>(INF) << "PCI::init: ECAM for buses [" << _ecam_first_bus << "," << _ecam_last_bus << "] at "
+                           << reinterpret_cast<void *>(System::info()->ecam.phy) << endl;
+    }
 }
 
 __END_SYS
@@ -0,0 +1,406 @@
+// EPOS PC AMD PCNet II (Am79C970A) Ethernet NIC Mediator Implementation
+
+#include <system/config.h>
+
+#ifdef __NIC_H
+
+#include <machine/machine.h>
+#include <machine/nic.h>
+#include <process.h>
+#include <interrupt_thread.h>
+#include <utility/pcap.h>
+
+__BEGIN_SYS
+
+// Class attributes
+PCNet32::Device PCNet32::_devices[UNITS];
+
+// Methods
+PCNet32::~PCNet32()
+{
+    db<PCNet32>(TRC) << "~PCNet32(unit=" << _unit << ")" << endl;
+
+    if(_poller)
+        delete _poller;
+
+    csr(CSR0, STOP);
+    IC::disable(_interrupt);
+    _devices[_unit].device = 0;
+}
+
+int PCNet32::send(const Address & dst, const Protocol & prot, const void * data, unsigned int size)
+{
+    Buffer * buf = alloc(dst, prot, size);
+    if(!buf)
+        return 0;
+
+    memcpy(buf->frame()->data<void>(), data, size);
+
+    return send(buf);
+}
+
+int PCNet32::receive(Address * src, Protocol * prot, void * data, unsigned int size)
+{
+    db<PCNet32>(TRC) << "PCNet32::receive(d=" << data << ",s=" << size << ")" << endl;
+
+    Buffer * buf;
+    for(;;) {
+        bool ie = lock();
+        buf = take();
+        unlock(ie);
+        if(buf)
+            break;
+        Thread::yield();
+    }
+
+    Frame * frame = buf->frame();
+    *src = frame->src();
+    *prot = frame->prot();
+    if(size > buf->size())
+        size = buf->size();
+    memcpy(data, frame->data<void>(), size);
+
+    free(buf);
+
+    return size;
+}
+
+PCNet32::Buffer * PCNet32::alloc(const Address & dst, const Protocol & prot, unsigned int payload)
+{
+    db<PCNet32>(TRC) << "PCNet32::alloc(d=" << dst << ",p=" << hex << prot << dec << ",pl=" << payload << ")" << endl;
+
+    if(payload > MTU) {
+        db<PCNet32>(WRN) << "PCNet32::alloc: payload larger than the MTU!" << endl;
+        return 0;
+    }
+
+    Buffer * buf = 0;
+    bool ie = lock();
+    reclaim();
+    for(unsigned int i = 0; (i < TX_BUFS) && !buf; i++)
+        if(_tx_buffer[i]->lock())
+            buf = _tx_buffer[i];
+    unlock(ie);
+
+    if(!buf) {
+        db<PCNet32>(WRN) << "PCNet32::alloc: no TX buffers available!" << endl;
+        return 0;
+    }
+
+    *buf->frame()->header() = Header(_address, dst, prot);
+    buf->size(payload);
+
+    db<PCNet32>(INF) << "PCNet32::alloc:buf=" << buf << " => " << *buf << endl;
+
+    return buf;
+}
+
+int PCNet32::send(Buffer * buf)
+{
+    unsigned int size = buf->size();
+
+    bool ie = lock();
+
+    // There are as many TX descriptors as TX buffers and at least this one isn't being sent, so the next descriptor
+    // is always free once the ones the chip is done with are reclaimed
+    reclaim();
+    unsigned int i = _tx_cur;
+    Tx_Desc * desc = &_tx_ring[i];
+    assert(!(desc->status & Desc::OWN) && !_tx_sent[i]);
+
+    _tx_sent[i] = buf;
+    _tx_cur = (i + 1) % TX_BUFS;
+    _tx_pending++;
+
+    desc->phy_addr = phy(buf->frame());
+    desc->size = byte_count(HEADER_SIZE + size);
+    desc->misc = 0;
+    CPU::fence();
+    desc->status = Desc::OWN | Desc::STP | Desc::ENP;
+
+    // Don't wait for the chip to poll the ring
+    csr(CSR0, IENA | TDMD);
+
+    _statistics.tx_packets++;
+    _statistics.tx_bytes += size;
+
+    PCAP::capture(buf->frame(), HEADER_SIZE + size);
+
+    unlock(ie);
+
+    db<PCNet32>(INF) << "PCNet32::send(buf=" << buf << ",desc=" << i << ")" << endl;
+
+    return size;
+}
+
+void PCNet32::free(Buffer * buf)
+{
+    db<PCNet32>(TRC) << "PCNet32::free(buf=" << buf << ")" << endl;
+
+    bool ie = lock();
+    if(buf->back()) // RX buffers are bound to their descriptors, TX ones aren't until they are sent
+        recycle(buf);
+    else
+        buf->unlock();
+    unlock(ie);
+}
+
+void PCNet32::reset()
+{
+    db<PCNet32>(TRC) << "PCNet32::reset(unit=" << _unit << ")" << endl;
+
+    bool ie = lock();
+
+    // Reset the chip and switch to 32-bit structures
+    s_reset();
+    bcr(BCR20, SWSTYLE_PCNET_PCI);
+
+    for(unsigned int i = 0; i < sizeof(Address); i++)
+        _address[i] = prom(i);
+
+    // Give all RX descriptors to the chip and take all TX descriptors back (frames being sent are lost)
+    for(unsigned int i = 0; i < RX_BUFS; i++) {
+        _rx_ring[i].phy_addr = phy(_rx_buffer[i]->frame());
+        _rx_ring[i].size = byte_count(sizeof(Frame));
+        _rx_ring[i].misc = 0;
+        _rx_ring[i].status = Desc::OWN;
+        _rx_buffer[i]->unlock();
+    }
+    for(unsigned int i = 0; i < TX_BUFS; i++) {
+        _tx_ring[i].status = 0;
+        if(_tx_sent[i]) {
+            _tx_sent[i]->unlock();
+            _tx_sent[i] = 0;
+        }
+    }
+    _rx_cur = 0;
+    _tx_cur = 0;
+    _tx_clean = 0;
+    _tx_pending = 0;
+
+    _iblock->mode = promiscuous ? Init_Block::PROM : 0;
+    _iblock->rlen = (sizeof(unsigned int) * 8 - 1 - __builtin_clz(RX_BUFS)) << 4;
+    _iblock->tlen = (sizeof(unsigned int) * 8 - 1 - __builtin_clz(TX_BUFS)) << 4;
+    _iblock->mac_addr = _address;
+    _iblock->filter1 = 0;
+    _iblock->filter2 = 0;
+    _iblock->rx_ring = phy(_rx_ring);
+    _iblock->tx_ring = phy(_tx_ring);
+
+    Reg32 iblock = phy(_iblock);
+    csr(CSR1, iblock & 0xffff);
+    csr(CSR2, iblock >> 16);
+    csr(CSR3, 0);
+    csr(CSR4, csr(CSR4) | APAD_XMT);
+
+    csr(CSR0, INIT);
+    for(unsigned int i = 0; (i < 100000) && !(csr(CSR0) & IDON); i++);
+    if(!(csr(CSR0) & IDON))
+        db<PCNet32>(WRN) << "PCNet32::reset: initialization timed out!" << endl;
+
+    // Clear IDON and start
+    csr(CSR0, IDON | IENA | STRT);
+
+    unlock(ie);
+
+    db<PCNet32>(INF) << "PCNet32::reset: mac=" << _address << endl;
+}
+
+void PCNet32::attach(Observer * o, const Protocol & p)
+{
+    Observed::attach(o, p);
+
+    // Frames are only polled for observers, and threads can't be created before the system is up
+    if(polled && !_poller) {
+        for(unsigned int i = 0; i < UNITS; i++)
+            if(_devices[i].device && (_devices[i].interrupt == _interrupt) && _devices[i].device->_poller)
+                return; // the thread of another unit sharing the interrupt polls this one too
+        _poller = new (SYSTEM) Interrupt_Thread(_interrupt, &_bottom_half, &int_ack);
+    }
+}
+
+// Returns the next frame received, or 0 if there is none (or the ring has wrapped around onto frames still in use).
+// Must be called with the lock taken.
+PCNet32::Buffer * PCNet32::take()
+{
+    for(;;) {
+        unsigned int i = _rx_cur;
+        Rx_Desc * desc = &_rx_ring[i];
+        Buffer * buf = _rx_buffer[i];
+
+        if((desc->status & Desc::OWN) || !buf->lock())
+            return 0;
+        _rx_cur = (i + 1) % RX_BUFS;
+
+        unsigned int size = desc->misc & 0x0fff;
+        if(((desc->status & (Desc::ERR | Desc::STP | Desc::ENP)) != (Desc::STP | Desc::ENP)) || (size < HEADER_SIZE + sizeof(CRC))) {
+            db<PCNet32>(WRN) << "PCNet32::take: bad frame (status=" << hex << desc->status << dec << ")!" << endl;
+            _statistics.rx_errors++;
+            recycle(buf);
+            continue;
+        }
+
+        buf->size(size - HEADER_SIZE - sizeof(CRC));
+
+        _statistics.rx_packets++;
+        _statistics.rx_bytes += buf->size();
+
+        PCAP::capture(buf->frame(), HEADER_SIZE + buf->size());
+
+        db<PCNet32>(INF) << "PCNet32::take:desc=" << i << ",buf=" << buf << " => " << *buf->frame()->header() << endl;
+
+        return buf;
+    }
+}
+
+// Gives the TX buffers of the frames the chip is done with back to the pool. Must be called with the lock taken.
+void PCNet32::reclaim()
+{
+    for(; _tx_pending && !(_tx_ring[_tx_clean].status & Desc::OWN); _tx_pending--) {
+        Tx_Desc * desc = &_tx_ring[_tx_clean];
+        if(desc->status & Desc::ERR)
+            _statistics.tx_errors++;
+        if(desc->status & (Tx_Desc::MORE | Tx_Desc::ONE))
+            _statistics.collisions++;
+        _tx_sent[_tx_clean]->unlock();
+        _tx_sent[_tx_clean] = 0;
+        _tx_clean = (_tx_clean + 1) % TX_BUFS;
+    }
+}
+
+// Gives the RX descriptor of buf back to the chip. Must be called with the lock taken, so take() never sees the
+// descriptor free but not yet owned by the chip.
+void PCNet32::recycle(Buffer * buf)
+{
+    Rx_Desc * desc = reinterpret_cast<Rx_Desc *>(buf->back());
+    desc->size = byte_count(sizeof(Frame));
+    desc->misc = 0;
+    buf->size(sizeof(Frame));
+    buf->unlock();
+    CPU::fence();
+    desc->status = Desc::OWN;
+}
+
+// Acknowledges all interrupt causes, without starting, stopping or disabling anything, and returns them
+Am79C970A::Reg16 PCNet32::acknowledge()
+{
+    bool ie = lock();
+
+    Reg16 status = csr(CSR0);
+    csr(CSR0, status & ~(INIT | STRT | STOP | TDMD | IENA));
+
+    if(status & MISS)
+        _statistics.rx_overruns++;
+    if(status & (BABL | CERR | MERR)) {
+        db<PCNet32>(WRN) << "PCNet32::acknowledge: error (csr0=" << hex << status << dec << ")!" << endl;
+        if(status & (BABL | CERR))
+            _statistics.tx_errors++;
+    }
+    if(status & TINT)
+        reclaim();
+
+    unlock(ie);
+
+    return status;
+}
+
+// Hands up to "budget" frames up by reference while anybody is listening, otherwise leaves them in the ring for
+// receive(). The batch is taken from the ring at once, but the lock is not held while observers run, since they will
+// free() the Buffers or send() replies. Returns how many frames were handed up.
+unsigned int PCNet32::deliver(unsigned int budget)
+{
+    Buffer * batch[POLL_BUDGET];
+    if(budget > POLL_BUDGET)
+        budget = POLL_BUDGET;
+
+    unsigned int n = 0;
+    if(observers()) {
+        bool ie = lock();
+        for(Buffer * buf; (n < budget) && (buf = take()); n++)
+            batch[n] = buf;
+        unlock(ie);
+    }
+
+    for(unsigned int i = 0; i < n; i++)
+        if(!notify(batch[i]->frame()->prot(), batch[i]))
+            free(batch[i]);
+
+    return n;
+}
+
+// Bottom half of the polled mode. RX interrupts stay masked while the ring yields full batches. A frame that arrives
+// after the last batch leaves RINT set in CSR0, so the interrupt comes as soon as it is unmasked and nothing is lost.
+void PCNet32::poll()
+{
+    while(deliver(POLL_BUDGET) == POLL_BUDGET)
+        Thread::yield();
+
+    bool ie = lock();
+    csr(CSR3, 0);
+    unlock(ie);
+}
+
+void PCNet32::handle_int()
+{
+    Reg16 status = acknowledge();
+
+    if(status & RINT)
+        while(deliver(POLL_BUDGET) == POLL_BUDGET);
+
+    bool ie = lock();
+    csr(CSR0, IENA);
+    unlock(ie);
+}
+
+void PCNet32::int_handler(IC::Interrupt_Id interrupt)
+{
+    // PCI interrupts can be shared
+    for(unsigned int i = 0; i < UNITS; i++)
+        if(_devices[i].device && (_devices[i].interrupt == interrupt))
+            _devices[i].device->handle_int();
+}
+
+// Top half of the polled mode (runs in interrupt context)
+void PCNet32::int_ack(IC::Interrupt_Id interrupt)
+{
+    for(unsigned int i = 0; i < UNITS; i++) {
+        PCNet32 * dev = _devices[i].device;
+        if(dev && (dev->_interrupt == interrupt)) {
+            dev->acknowledge();
+            bool ie = dev->lock();
+            dev->csr(CSR3, RINTM);
+            dev->csr(CSR0, IENA);
+            dev->unlock(ie);
+        }
+    }
+}
+
+void PCNet32::bottom_half(PCNet32 * dev)
+{
+    for(unsigned int i = 0; i < UNITS; i++)
+        if(_devices[i].device && (_devices[i].interrupt == dev->_interrupt))
+            _devices[i].device->poll();
+}
+
+bool PCNet32::lock()
+{
+    bool ie = CPU::int_enabled();
+    CPU::int_disable();
+    if(Traits<Build>::CPUS > 1)
+        while(CPU::tsl(_lock));
+    return ie;
+}
+
+void PCNet32::unlock(bool ie)
+{
+    if(Traits<Build>::CPUS > 1) {
+        CPU::fence();
+        _lock = 0;
+    }
+    if(ie)
+        CPU::int_enable();
+}
+
+__END_SYS
+
+#endif
@@ -0,0 +1,91 @@
+// EPOS PC AMD PCNet II (Am79C970A) Ethernet NIC Mediator Initialization
+
+#include <system/config.h>
+
+#ifdef __NIC_H
+
+#include <machine/machine.h>
+#include <machine/nic.h>
+#include <system.h>
+
+__BEGIN_SYS
+
+PCNet32::PCNet32(unsigned int unit, IO_Port io, const IC::Interrupt_Id & irq, DMA_Buffer * dma)
+: Am79C970A(io), _bottom_half(&bottom_half, this), _poller(0)
+{
+    db<PCNet32>(TRC) << "PCNet32(unit=" << unit << ",io=" << io << ",irq=" << irq << ",dma=" << *dma << ")" << endl;
+
+    _unit = unit;
+    _interrupt = irq;
+    _lock = 0;
+    _dma_buf = dma;
+
+    // Init block, rings and buffers, in this order, all 16-byte aligned (pages are)
+    Log_Addr log = _dma_buf->log_address();
+
+    _iblock = log;
+    log += INIT_BLOCK_SIZE;
+
+    _rx_ring = log;
+    log += RX_RING_SIZE;
+
+    _tx_ring = log;
+    log += TX_RING_SIZE;
+
+    for(unsigned int i = 0; i < RX_BUFS; i++) {
+        _rx_buffer[i] = new (log) Buffer(this, &_rx_ring[i]);
+        log += BUFFER_SIZE;
+    }
+
+    for(unsigned int i = 0; i < TX_BUFS; i++) {
+        _tx_buffer[i] = new (log) Buffer(this, 0);
+        _tx_sent[i] = 0;
+        log += BUFFER_SIZE;
+    }
+
+    reset();
+}
+
+void PCNet32::init(unsigned int unit)
+{
+    db<Init, PCNet32>(TRC) << "PCNet32::init(unit=" << unit << ")" << endl;
+
+    PCI::Locator loc = PCI::scan(PCI_VENDOR_ID, PCI_DEVICE_ID, unit);
+    if(!loc) {
+        db<Init, PCNet32>(WRN) << "PCNet32::init: PCI scan failed!" << endl;
+        return;
+    }
+
+    PCI::Header hdr;
+    PCI::header(loc, &hdr);
+    if(!hdr || hdr.region[PCI_REG_IO].memory || !hdr.region[PCI_REG_IO]) {
+        db<Init, PCNet32>(WRN) << "PCNet32::init: device has no I/O region!" << endl;
+        return;
+    }
+
+    // Let the chip answer I/O and be a bus master, so it can reach the rings
+    PCI::command(loc, PCI::command(loc) | PCI::COMMAND_IO | PCI::COMMAND_MASTER);
+
+    IO_Port io = hdr.region[PCI_REG_IO].phy_addr;
+    IC::Interrupt_Id irq = IC::irq2int(hdr.interrupt_line);
+    db<Init, PCNet32>(INF) << "PCNet32::init: PCI=" << loc << ",io=" << io << ",irq=" << hdr.interrupt_line << endl;
+
+    DMA_Buffer * dma = new (SYSTEM) DMA_Buffer(DMA_BUFFER_SIZE);
+    PCNet32 * dev = new (SYSTEM) PCNet32(unit, io, irq, dma);
+
+    _devices[unit].device = dev;
+    _devices[unit].interrupt = irq;
+
+    IC::int_vector(irq, &int_handler);
+    IC::enable(irq);
+}
+
+void PCNet32::init()
+{
+    for(unsigned int i = 0; i < UNITS; i++)
+        init(i);
+}
+
+__END_SYS
+
+#endif
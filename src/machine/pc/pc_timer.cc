@@ -2,13 +2,20 @@
 
 #include <machine/ic.h>
 #include <machine/timer.h>
+#include <machine/display.h>
 
 __BEGIN_SYS
 
 Timer * Timer::_channels[CHANNELS];
+bool Timer::_tsc_deadline;
+Timer::Handler Timer::_one_shot;
 
 void Timer::int_handler(Interrupt_Id i)
 {
+    // A shadowed VGA is flushed from the tick, so output doesn't depend on the Alarm's event queue
+    if(Traits<Display>::enabled && VGA::REFRESH && (CPU::id() == 0))
+        VGA::refresh();
+
     if(_channels[USER] && (--_channels[USER]->_current <= 0)) {
         if(_channels[USER]->_retrigger)
             _channels[USER]->_current = _channels[USER]->_initial;
@@ -26,4 +33,30 @@ void Timer::int_handler(Interrupt_Id i)
     }
 }
 
+void Timer::one_shot(const TSC_Common::Time_Stamp & deadline, const Handler & handler)
+{
+    assert(CPU::int_disabled());
+
+    db<Timer>(TRC) << "Timer::one_shot(d=" << deadline << ",h=" << reinterpret_cast<void *>(handler) << ")" << endl;
+
+    _one_shot = handler;
+
+    if(_tsc_deadline)
+        APIC::timer_deadline(deadline ? deadline : 1); // a deadline already gone by triggers the interrupt right away, but 0 disarms
+    else {
+        TSC::Time_Stamp now = TSC::time_stamp();
+        TSC::Time_Stamp delta = (deadline > now) ? deadline - now : 0;
+        if(delta > TSC::frequency())
+            delta = TSC::frequency();
+        CPU::Reg32 count = delta * CPU::bus_clock() / TSC::frequency();
+        APIC::timer_count(count ? count : 1);
+    }
+}
+
+void Timer::one_shot_handler(Interrupt_Id i)
+{
+    if(_one_shot)
+        _one_shot(i);
+}
+
 __END_SYS
@@ -19,6 +19,20 @@ void Timer::init()
 
     IC::enable(IC::INT_SYS_TIMER);
 
+    // One-shots go through the local APIC, which is left on for the 8259A's virtual wire (see IC::init())
+    if(ONE_SHOT) {
+        _tsc_deadline = APIC::tsc_deadline();
+        db<Init, Timer>(INF) << "Timer::init: one-shots in " << (_tsc_deadline ? "TSC-deadline" : "bus clock") << " mode" << endl;
+
+        APIC::remap();
+        APIC::enable();
+        IC::int_vector(IC::INT_ONE_SHOT, one_shot_handler);
+        if(_tsc_deadline)
+            APIC::config_timer_deadline(IC::INT_ONE_SHOT);
+        else
+            APIC::config_timer_one_shot(IC::INT_ONE_SHOT);
+    }
+
     CPU::int_enable();
 }
 
@@ -4,6 +4,8 @@
 #include <machine/ic.h>
 #include <machine/timer.h>
 #include <process.h>
+#include <utility/latency.h>
+#include <utility/trace.h>
 
 extern "C" { void _int_entry() __attribute__ ((nothrow, alias("_ZN4EPOS1S2IC5entryEv"))); }
 extern "C" { void __exit(); }
@@ -12,6 +14,9 @@ extern "C" { static void print_context(); }
 __BEGIN_SYS
 
 IC::Interrupt_Handler IC::_int_vector[IC::INTS];
+unsigned int IC::_nesting[IC::CPUS];
+bool IC::_rescheduling[IC::CPUS];
+char IC::_stack[IC::CPUS][IC::STACK_SIZE] __attribute__((aligned(16)));
 
 void IC::entry()
 {
@@ -34,18 +39,149 @@ if(Traits<IC>::hysterically_debugged) {
     CPU::iret();
 }
 
+// Like entry(), but for the machine timer only, so there is no cause to decode on the tick
+void IC::timer_entry()
+{
+    CPU::Context::push(true);
+    ASM("       la     ra, 1f                   \n"
+        "       j      %0                       \n" : : "i"(&timer_dispatch));
+
+    ASM("1:                                     \n");
+    CPU::Context::pop(true);
+    CPU::iret();
+}
+
+// One uncompressed jump per cause: exceptions (and USR_SOFT) at the base, each interrupt at base + 4 * cause
+void IC::vector()
+{
+    ASM("       .option push                    \n"
+        "       .option norvc                   \n"
+        "       j      %0                       \n"    // exceptions and IRQ_USR_SOFT
+        "       j      %0                       \n"    // IRQ_SUP_SOFT
+        "       j      %0                       \n"
+        "       j      %0                       \n"    // IRQ_MAC_SOFT
+        "       j      %0                       \n"    // IRQ_USR_TIMER
+        "       j      %0                       \n"    // IRQ_SUP_TIMER
+        "       j      %0                       \n"
+        "       j      %1                       \n"    // IRQ_MAC_TIMER
+        "       j      %0                       \n"    // IRQ_USR_EXT
+        "       j      %0                       \n"    // IRQ_SUP_EXT
+        "       j      %0                       \n"
+        "       j      %0                       \n"    // IRQ_MAC_EXT
+        "       j      %0                       \n"
+        "       j      %0                       \n"
+        "       j      %0                       \n"
+        "       j      %0                       \n"
+        "       .option pop                     \n" : : "i"(&entry), "i"(&timer_entry));
+}
+
+void IC::timer_dispatch()
+{
+    if(deferring && !_nesting[CPU::id()])
+        stacked(&timer_serve, INT_SYS_TIMER);
+    else
+        timer_serve(INT_SYS_TIMER);
+
+    CPU::fr(0); // tell CPU::Context::pop(true) not to increment PC since it is automatically incremented for hardware interrupts
+}
+
+void IC::timer_serve(Interrupt_Id i)
+{
+    if(Traits<IC>::hysterically_debugged)
+        db<IC>(TRC) << "IC::dispatch(i=" << INT_SYS_TIMER << ")" << endl;
+
+    if(Latency::enabled || Trace::enabled) {
+        TSC::Time_Stamp late = Timer::late();
+        Latency::timer_interrupt(late);
+        Trace::interrupt(INT_SYS_TIMER, late);
+    }
+
+    Timer::reset();
+    _int_vector[INT_SYS_TIMER](INT_SYS_TIMER);
+}
+
 void IC::dispatch()
 {
     Interrupt_Id id = int_id();
 
+    // With Traits<IC>::STACK_SIZE, the outermost interrupt handler runs on its CPU's interrupt stack, where nested ones
+    // stay. Exceptions are served on the thread's stack, since their handlers may terminate it.
+    if(deferring && (id >= EXCS) && !_nesting[CPU::id()]) {
+        stacked(&serve, id);
+        CPU::fr(0); // as serve() would have
+    } else
+        serve(id);
+}
+
+void IC::stacked(Interrupt_Handler handler, Interrupt_Id id)
+{
+    unsigned int cpu = CPU::id();
+
+    _nesting[cpu]++;
+    if(STACK_SIZE)
+        CPU::stack_call(reinterpret_cast<Reg>(&_stack[cpu][STACK_SIZE]), handler, id);
+    else
+        handler(id);
+    CPU::int_disable(); // handlers might have enabled interrupts
+    _nesting[cpu]--;
+
+    if(_rescheduling[cpu]) {
+        _rescheduling[cpu] = false;
+        Thread::rescheduler(id);
+    }
+}
+
+void IC::serve(Interrupt_Id id)
+{
+
     if((id != INT_SYS_TIMER) || Traits<IC>::hysterically_debugged)
         db<IC>(TRC) << "IC::dispatch(i=" << id << ")" << endl;
 
+    // PLIC sources are recorded as they are claimed below
+    if((id != INT_SYS_TIMER) && (id != INT_EXTERNAL))
+        Trace::interrupt(id);
+
+    // MIP.MSIP stays up until the hart's MSIP register is cleared
+    if(id == INT_IPI)
+        ipi_eoi();
+
     // MIP.MTI is a direct logic on (MTIME == MTIMECMP) and reseting the Timer seems to be the only way to clear it
-    if(id == INT_SYS_TIMER)
+    if(id == INT_SYS_TIMER) {
+        if(Latency::enabled || Trace::enabled) {
+            TSC::Time_Stamp late = Timer::late();
+            Latency::timer_interrupt(late);
+            Trace::interrupt(id, late);
+        }
         Timer::reset();
+    } else if(Timer::sleeping()) // tickless idle: account for the elapsed periods before the handler looks at time
+        Timer::int_handler(INT_SYS_TIMER);
 
-    _int_vector[id](id);
+    if(id == INT_EXTERNAL) {
+        // Serve whatever the PLIC has pending for this hart, from the highest priority on, before returning
+        for(unsigned int irq = PLIC::claim(); irq; irq = PLIC::claim()) {
+            Interrupt_Id i = INT_PLIC + irq;
+            Trace::interrupt(i);
+            if(Traits<IC>::hysterically_debugged)
+                db<IC>(TRC) << "IC::dispatch(irq=" << irq << ")" << endl;
+            if(irq < PLIC_IRQS) {
+                if(Traits<IC>::nested) {
+                    // The claimed source is held until complete(), while sources of higher priority and the timer get in
+                    unsigned int l = PLIC::threshold();
+                    unsigned int p = PLIC::priority(irq);
+                    if(p > l)
+                        PLIC::threshold(p);
+                    CPU::int_enable();
+                    _int_vector[i](i);
+                    CPU::int_disable();
+                    if(p > l)
+                        PLIC::threshold(l);
+                } else
+                    _int_vector[i](i);
+            }
+            PLIC::complete(irq);
+        }
+    } else
+        _int_vector[id](id);
 
     if(id >= EXCS)
         CPU::fr(0); // tell CPU::Context::pop(true) not to increment PC since it is automatically incremented for hardware interrupts
@@ -60,6 +196,12 @@ void IC::int_not(Interrupt_Id id)
 
 void IC::exception(Interrupt_Id id)
 {
+    // FPU registers are restored lazily on the first FP instruction after a context switch (see CPU::fpu_switch())
+    if((id == CPU::EXC_IILLEGAL) && CPU::fpu_trap()) {
+        CPU::fr(0); // tell CPU::Context::pop(true) to retry the instruction
+        return;
+    }
+
     CPU::Reg epc = CPU::mepc();
     CPU::Reg sp = CPU::sp();
     CPU::Reg status = CPU::mstatus();
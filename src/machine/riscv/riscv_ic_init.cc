@@ -14,13 +14,28 @@ void IC::init()
 
     disable(); // will be enabled on demand as handlers are registered
 
-    // Set all exception handlers to exception()
-    for(Interrupt_Id i = 0; i < EXCS; i++)
-        _int_vector[i] = &exception;
-
-    // Set all interrupt handlers to int_not()
-    for(Interrupt_Id i = EXCS; i < INTS; i++)
-        _int_vector[i] = &int_not;
+    // The vectors and the priorities of the external sources are shared by all CPUs, so CPU 0 sets them up
+    if(CPU::id() == 0) {
+        // Set all exception handlers to exception()
+        for(Interrupt_Id i = 0; i < EXCS; i++)
+            _int_vector[i] = &exception;
+
+        // Set all interrupt handlers to int_not()
+        for(Interrupt_Id i = EXCS; i < INTS; i++)
+            _int_vector[i] = &int_not;
+
+        for(unsigned int irq = 1; irq < PLIC_IRQS; irq++)
+            PLIC::priority(irq, Traits<IC>::priority(irq));
+    }
+
+    // External sources start disabled for this hart, and none is masked by the threshold
+    for(unsigned int irq = 1; irq < PLIC_IRQS; irq++)
+        PLIC::disable(irq);
+    PLIC::threshold(0);
+
+    // SETUP left mtvec pointing to entry() in direct mode
+    if(Traits<IC>::vectored)
+        mtvec(INDEXED, reinterpret_cast<CPU::Reg>(&vector));
 }
 
 __END_SYS
@@ -11,6 +11,7 @@ void Machine::panic()
 
     if(Traits<Display>::enabled)
         Display::puts("PANIC!\n");
+    Serial_Display::flush();
 
     if(Traits<System>::reboot)
         reboot();
@@ -22,6 +23,7 @@ void Machine::reboot()
 {
     if(Traits<System>::reboot) {
         db<Machine>(WRN) << "Machine::reboot()" << endl;
+        Serial_Display::flush();
 
 #ifdef __sifive_e__
         CPU::Reg * reset = reinterpret_cast<CPU::Reg *>(Memory_Map::AON_BASE);
@@ -42,6 +44,7 @@ void Machine::reboot()
 void Machine::poweroff()
 {
     db<Machine>(WRN) << "Machine::poweroff()" << endl;
+    Serial_Display::flush();
 
 #ifdef __sifive_e__
         CPU::Reg * reset = reinterpret_cast<CPU::Reg *>(Memory_Map::AON_BASE);
@@ -13,6 +13,9 @@ void Machine::init()
 
     if(Traits<Timer>::enabled)
         Timer::init();
+
+    if(Traits<UART>::BUFFER_SIZE && (CPU::id() == 0))
+        UART::init();
 }
 
 __END_SYS
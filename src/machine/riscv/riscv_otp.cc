@@ -0,0 +1,17 @@
+// EPOS RISC-V OTP Mediator Implementation
+
+#include <system/config.h>
+
+#ifdef __OTP_H
+
+#include <machine/otp.h>
+
+__BEGIN_SYS
+
+// Class attributes
+SiFive_OTP::Reg32 SiFive_OTP::_cache[SiFive_OTP::CACHED_FUSES];
+Bitmap<SiFive_OTP::CACHED_FUSES> SiFive_OTP::_valid;
+
+__END_SYS
+
+#endif
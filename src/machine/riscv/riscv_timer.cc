@@ -2,22 +2,135 @@
 
 #include <machine/ic.h>
 #include <machine/timer.h>
+#include <machine/display.h>
 
 __BEGIN_SYS
 
 // Class attributes
 Timer * Timer::_channels[CHANNELS];
+volatile bool Timer::_sleeping;
+CPU::Reg32 Timer::_sleep;
+Timer::Tick Timer::_skipped;
+volatile bool Timer::_armed;
+bool Timer::_expired;
+bool Timer::_off_tick;
+CPU::Reg32 Timer::_deadline;
+CPU::Reg32 Timer::_tick;
+Timer::Handler Timer::_one_shot;
+bool Timer::_local;
 
 // Class methods
+void Timer::sleep(const Tick & ticks)
+{
+    assert(CPU::int_disabled());
+
+    if(ticks <= 1)
+        return;
+
+    db<Timer>(TRC) << "Timer::sleep(tk=" << ticks << ")" << endl;
+
+    _sleep = reg(MTIME);
+    _sleeping = true;
+    mtimecmp() = _sleep + ((ticks > MAX_SLEEP) ? MAX_SLEEP : ticks) * PERIOD;
+}
+
+Timer::Tick Timer::wakeup()
+{
+    CPU::Reg32 now = reg(MTIME);
+    Tick ticks = (now - _sleep) / PERIOD;
+
+    // Resume periodic ticks in phase with the sleep, so the fraction of the current period isn't lost
+    _sleeping = false;
+    mtimecmp() = _sleep + (ticks + 1) * PERIOD;
+
+    db<Timer>(TRC) << "Timer::wakeup() => " << ticks << endl;
+
+    return ticks;
+}
+
+void Timer::one_shot(const Time_Stamp & deadline, const Handler & handler)
+{
+    assert(CPU::int_disabled());
+
+    db<Timer>(TRC) << "Timer::one_shot(d=" << deadline << ",h=" << reinterpret_cast<void *>(handler) << ")" << endl;
+
+    // MTIMECMP holds the next periodic tick unless a one-shot is already armed
+    if(!_armed)
+        _tick = mtimecmp();
+
+    _deadline = deadline;
+    _one_shot = handler;
+    _armed = true;
+
+    // A deadline already gone by triggers the interrupt right away
+    mtimecmp() = (static_cast<int>(_deadline - _tick) < 0) ? _deadline : _tick;
+}
+
+void Timer::rearm()
+{
+    // Called by IC::dispatch() on every timer interrupt while a one-shot is armed: tell the one-shot from the
+    // periodic tick (they can coincide) and program MTIMECMP to whichever of them comes next
+    CPU::Reg32 now = reg(MTIME);
+
+    _off_tick = (static_cast<int>(now - _tick) < 0);
+    if(!_off_tick)
+        _tick = now + PERIOD;
+
+    if(static_cast<int>(now - _deadline) >= 0) {
+        _armed = false;
+        _expired = true;
+    }
+
+    mtimecmp() = (_armed && (static_cast<int>(_deadline - _tick) < 0)) ? _deadline : _tick;
+}
+
 void Timer::int_handler(Interrupt_Id i)
 {
-    if(_channels[ALARM] && (--_channels[ALARM]->_current <= 0)) {
-        _channels[ALARM]->_current = _channels[ALARM]->_initial;
+    unsigned int cpu = Timer::cpu();
+
+    // The other CPUs only get periodic ticks, for their scheduling quanta (see reset()) and local alarms, or just the
+    // end of each quantum
+    if(cpu != 0) {
+        if(_local && _channels[ALARM] && (--_channels[ALARM]->_current[cpu] <= 0)) {
+            _channels[ALARM]->_current[cpu] = _channels[ALARM]->_initial;
+            _channels[ALARM]->_handler(i);
+        }
+        if(dedicated) {
+            if(_channels[SCHEDULER])
+                _channels[SCHEDULER]->_handler(i);
+            return;
+        }
+        if(_channels[SCHEDULER] && (--_channels[SCHEDULER]->_current[cpu] <= 0)) {
+            _channels[SCHEDULER]->_current[cpu] = _channels[SCHEDULER]->_initial;
+            _channels[SCHEDULER]->_handler(i);
+        }
+        return;
+    }
+
+    // The console ring doesn't own the UART TX interrupt (UART's rings do), so it is drained on every tick
+    if(Traits<Serial_Display>::BUFFER_SIZE)
+        Serial_Display::drain();
+
+    if(_expired) {
+        _expired = false;
+        _one_shot(i);
+    }
+
+    if(_off_tick)
+        return;
+
+    Tick ticks = _sleeping ? wakeup() : 1;
+    if(!ticks)
+        return;
+    _skipped = ticks - 1;
+
+    if(_channels[ALARM] && ((_channels[ALARM]->_current[0] -= ticks) <= 0)) {
+        _channels[ALARM]->_current[0] = _channels[ALARM]->_initial;
         _channels[ALARM]->_handler(i);
     }
 
-    if(_channels[SCHEDULER] && (--_channels[SCHEDULER]->_current <= 0)) {
-        _channels[SCHEDULER]->_current = _channels[SCHEDULER]->_initial;
+    if(_channels[SCHEDULER] && ((_channels[SCHEDULER]->_current[0] -= ticks) <= 0)) {
+        _channels[SCHEDULER]->_current[0] = _channels[SCHEDULER]->_initial;
         _channels[SCHEDULER]->_handler(i);
     }
 }
@@ -0,0 +1,152 @@
+// EPOS RISC-V UART Mediator Implementation
+
+#include <machine/uart.h>
+#include <synchronizer.h>
+
+__BEGIN_SYS
+
+// Class attributes
+UART * UART::_device;
+UART::Ring UART::_rx;
+UART::Ring UART::_tx;
+volatile unsigned int UART::_rx_wanted;
+volatile int UART::_rx_waiting;
+volatile int UART::_tx_waiting;
+volatile int UART::_lock;
+Semaphore UART::_rx_semaphore(0);
+Semaphore UART::_tx_semaphore(0);
+
+// Waits for the condition to change, after telling the interrupt handler through the flag (as Channel does).
+// If the flag is taken back before the handler sees it, there is no v() to wait for.
+template<typename Condition>
+static void wait(volatile int & flag, Semaphore & semaphore, Condition condition)
+{
+    while(condition()) {
+        flag = 1;
+        CPU::fence();
+        if(!condition()) {
+            if(CPU::cas(flag, 1, 0) == 1)
+                break;
+        }
+        semaphore.p();
+    }
+}
+
+static void signal(volatile int & flag, Semaphore & semaphore)
+{
+    CPU::fence();
+    if(flag && (CPU::cas(flag, 1, 0) == 1))
+        semaphore.v();
+}
+
+
+// Class methods
+int UART::receive(char * data, unsigned int size)
+{
+    db<UART>(TRC) << "UART::read(data=" << reinterpret_cast<void *>(data) << ",size=" << size << ")" << endl;
+
+    unsigned int i = 0;
+    while(i < size) {
+        if(_rx.remove(&data[i])) {
+            i++;
+            continue;
+        }
+
+        // Pick up what is still in the FIFO below the watermark before going to sleep
+        bool ie = lock();
+        serve();
+        unlock(ie);
+
+        unsigned int wanted = size - i;
+        if(wanted > BUFFER_SIZE / 2)
+            wanted = (BUFFER_SIZE > 1) ? BUFFER_SIZE / 2 : 1;
+        _rx_wanted = wanted;
+        wait(_rx_waiting, _rx_semaphore, []() { return _rx.size() < _rx_wanted; });
+    }
+
+    return size;
+}
+
+int UART::send(const char * data, unsigned int size)
+{
+    db<UART>(TRC) << "UART::write(data=" << reinterpret_cast<const void *>(data) << ",size=" << size << ")" << endl;
+
+    unsigned int i = 0;
+    while(i < size) {
+        if(_tx.insert(data[i])) {
+            i++;
+            continue;
+        }
+
+        // Full: make sure the TX interrupt is on and wait for the ring to drain to half
+        bool ie = lock();
+        serve();
+        unlock(ie);
+
+        wait(_tx_waiting, _tx_semaphore, []() { return _tx.full(); });
+    }
+
+    bool ie = lock();
+    serve();
+    unlock(ie);
+
+    return size;
+}
+
+// Moves bytes from the RX FIFO to the RX ring and from the TX ring to the TX FIFO, keeping the TX interrupt on
+// only while there is something left to send. Must be called with the lock taken, so the rings have a single producer
+// (RX) and consumer (TX) and IE isn't changed behind anybody's back.
+void UART::serve()
+{
+    UART * uart = _device;
+
+    while(uart->rxd_ok()) {
+        char c = uart->rxd();
+        if(!_rx.insert(c))
+            db<UART>(WRN) << "UART::serve: RX ring overrun, byte dropped!" << endl;
+    }
+    if(_rx.size() >= _rx_wanted)
+        signal(_rx_waiting, _rx_semaphore);
+
+    char c;
+    for(unsigned int n = uart->txd_burst(); n && !_tx.empty(); n = uart->txd_burst())
+        for(; n && _tx.remove(&c); n--)
+            uart->txd(c);
+    if(_tx.empty())
+        uart->int_disable(false, true, false, false);
+    else
+        uart->int_enable(false, true, false, false);
+    if(_tx.size() <= BUFFER_SIZE / 2)
+        signal(_tx_waiting, _tx_semaphore);
+}
+
+void UART::int_handler(IC::Interrupt_Id i)
+{
+    if(!buffered || !_device)
+        return;
+
+    bool ie = lock();
+    serve();
+    unlock(ie);
+}
+
+bool UART::lock()
+{
+    bool ie = CPU::int_enabled();
+    CPU::int_disable();
+    if(Traits<Build>::CPUS > 1)
+        while(CPU::tsl(_lock));
+    return ie;
+}
+
+void UART::unlock(bool ie)
+{
+    if(Traits<Build>::CPUS > 1) {
+        CPU::fence();
+        _lock = 0;
+    }
+    if(ie)
+        CPU::int_enable();
+}
+
+__END_SYS
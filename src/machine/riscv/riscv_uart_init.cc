@@ -0,0 +1,16 @@
+// EPOS RISC-V UART Mediator Initialization
+
+#include <machine/uart.h>
+#include <machine/ic.h>
+
+__BEGIN_SYS
+
+void UART::init()
+{
+    db<Init, UART>(TRC) << "UART::init()" << endl;
+
+    IC::int_vector(IC::INT_UART0, int_handler);
+    IC::enable(IC::INT_UART0);
+}
+
+__END_SYS
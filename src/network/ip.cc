@@ -0,0 +1,142 @@
+// EPOS IP Protocol Implementation
+
+#include <system/config.h>
+
+#ifdef __NIC_H
+
+#include <machine.h>
+#include <network/ip.h>
+#include <system.h>
+
+__BEGIN_SYS
+
+// Class attributes
+IP * IP::_ip;
+static Mutex _lock;
+
+// Methods
+IP::IP(Interface * nic)
+: _nic(nic), _address(Traits<IP>::ADDRESS), _netmask(Traits<IP>::NETMASK), _gateway(Traits<IP>::GATEWAY),
+  _offloads(nic->offloads()), _id(0)
+{
+    _broadcast = _address | ~_netmask;
+
+    db<IP>(TRC) << "IP(nic=" << nic << ",a=" << _address << ",m=" << _netmask << ",g=" << _gateway << ") => " << this << endl;
+
+    _arp = new (SYSTEM) ARP(_nic, this);
+    _nic->attach(this, PROTOCOL);
+}
+
+IP::~IP()
+{
+    db<IP>(TRC) << "~IP(this=" << this << ")" << endl;
+
+    _nic->detach(this, PROTOCOL);
+    delete _arp;
+}
+
+IP * IP::get()
+{
+    if(!_ip) {
+        _lock.lock();
+        if(!_ip) {
+            Interface * nic = Traits<Ethernet>::DEVICES::Get<0>::Result::get(0);
+            if(nic)
+                _ip = new (SYSTEM) IP(nic);
+            else
+                db<IP>(WRN) << "IP::get: no NIC!" << endl;
+        }
+        _lock.unlock();
+    }
+
+    return _ip;
+}
+
+IP::Buffer * IP::alloc(const Address & to, const Protocol & prot, unsigned int payload)
+{
+    db<IP>(TRC) << "IP::alloc(to=" << to << ",p=" << prot << ",pl=" << payload << ")" << endl;
+
+    if(payload > MTU) {
+        db<IP>(WRN) << "IP::alloc: payload larger than the MTU!" << endl;
+        return 0;
+    }
+
+    Ethernet::Address mac;
+    if((to == _broadcast) || (to == Address::broadcast()))
+        mac = Ethernet::Address::broadcast();
+    else {
+        // Blocks while the next hop is resolved, unless it is already known
+        mac = _arp->resolve(((to & _netmask) == (_address & _netmask)) ? to : _gateway);
+        if(!mac)
+            return 0;
+    }
+
+    Buffer * buf = _nic->alloc(mac, PROTOCOL, sizeof(Header) + payload);
+    if(!buf)
+        return 0;
+
+    Header * h = new (header(buf)) Header(_address, to, prot, payload, CPU::finc(_id));
+    if(!(_offloads & NIC_Common::TX_IP_CHECKSUM))
+        h->sum();
+
+    return buf;
+}
+
+int IP::send(Buffer * buf)
+{
+    db<IP>(TRC) << "IP::send(buf=" << buf << ",h=" << *header(buf) << ")" << endl;
+
+    int size = _nic->send(buf);
+
+    return (size > int(sizeof(Header))) ? size - sizeof(Header) : 0;
+}
+
+unsigned int IP::sum(const void * data, unsigned int size, unsigned int partial)
+{
+    // Headers are 16-bit aligned in the frames
+    const unsigned short * w = reinterpret_cast<const unsigned short *>(data);
+    unsigned int s = partial;
+
+    for(; size > 1; size -= 2) {
+        s += *w++;
+        if(s & 0x80000000)
+            s = (s & 0xffff) + (s >> 16);
+    }
+    if(size) {
+        unsigned short last = 0;
+        *reinterpret_cast<unsigned char *>(&last) = *reinterpret_cast<const unsigned char *>(w);
+        s += last;
+    }
+
+    return s;
+}
+
+// Runs in interrupt context, or in the NIC's polling thread
+void IP::update(Ethernet::Observer::Observed * o, const Ethernet::Protocol & p, Buffer * buf)
+{
+    Header * h = header(buf);
+
+    if((buf->size() < sizeof(Header)) || (h->version() != 4) || (h->hlength() < sizeof(Header))
+       || (h->length() < h->hlength()) || (h->length() > buf->size()))
+        db<IP>(WRN) << "IP::update: malformed datagram dropped!" << endl;
+    else if(!(_offloads & NIC_Common::RX_IP_CHECKSUM) && !h->check())
+        db<IP>(WRN) << "IP::update: bad checksum, datagram dropped!" << endl;
+    else if(h->fragmented())
+        db<IP>(INF) << "IP::update: fragment dropped!" << endl;
+    else if(!(h->to() == _address) && !(h->to() == _broadcast) && !(h->to() == Address::broadcast()))
+        db<IP>(INF) << "IP::update: datagram to " << h->to() << " dropped!" << endl;
+    else {
+        db<IP>(TRC) << "IP::update(h=" << *h << ")" << endl;
+
+        // From here up, the size of the Buffer is that of the datagram, without the Ethernet padding
+        buf->size(h->length());
+        if(notify(h->protocol(), buf))
+            return;
+    }
+
+    free(buf);
+}
+
+__END_SYS
+
+#endif
@@ -0,0 +1,208 @@
+// EPOS UDP Protocol Implementation
+
+#include <system/config.h>
+
+#ifdef __NIC_H
+
+#include <network/udp.h>
+#include <system.h>
+
+__BEGIN_SYS
+
+// Class attributes
+UDP * UDP::_udp;
+static Mutex _lock;
+
+// Methods
+unsigned int UDP::Header::pseudo(const IP::Header * ip) const
+{
+    // Addresses, zero, protocol and UDP length, all in network byte order
+    unsigned short tail[2] = { htons(IP::PROTO_UDP), _length };
+    unsigned int s = IP::sum(&ip->from(), sizeof(IP::Address));
+    s = IP::sum(&ip->to(), sizeof(IP::Address), s);
+    return IP::sum(tail, sizeof(tail), s);
+}
+
+void UDP::Header::sum(const IP::Header * ip)
+{
+    _checksum = 0;
+    unsigned short c = IP::checksum(this, length(), pseudo(ip));
+    _checksum = c ? c : 0xffff; // zero means there is no checksum
+}
+
+bool UDP::Header::check(const IP::Header * ip) const
+{
+    return !_checksum || (IP::checksum(this, length(), pseudo(ip)) == 0);
+}
+
+
+UDP::UDP(IP * ip): _ip(ip)
+{
+    db<UDP>(TRC) << "UDP(ip=" << ip << ") => " << this << endl;
+
+    _ip->attach(this, IP::PROTO_UDP);
+}
+
+UDP::~UDP()
+{
+    db<UDP>(TRC) << "~UDP(this=" << this << ")" << endl;
+
+    _ip->detach(this, IP::PROTO_UDP);
+}
+
+UDP * UDP::get()
+{
+    if(!_udp) {
+        _lock.lock();
+        if(!_udp) {
+            IP * ip = IP::get();
+            if(ip)
+                _udp = new (SYSTEM) UDP(ip);
+        }
+        _lock.unlock();
+    }
+
+    return _udp;
+}
+
+// Runs in interrupt context, or in the NIC's polling thread
+void UDP::update(IP::Observed * o, const IP::Protocol & p, Buffer * buf)
+{
+    IP::Header * ip = IP::header(buf);
+    Header * h = ip->data<Header>();
+    unsigned int size = ip->length() - ip->hlength();
+
+    if((size < sizeof(Header)) || (h->length() < sizeof(Header)) || (h->length() > size))
+        db<UDP>(WRN) << "UDP::update: malformed datagram dropped!" << endl;
+    else if(checksummed && !(_ip->offloads() & NIC_Common::RX_L4_CHECKSUM) && !h->check(ip))
+        db<UDP>(WRN) << "UDP::update: bad checksum, datagram dropped!" << endl;
+    else {
+        db<UDP>(TRC) << "UDP::update(h=" << *h << ")" << endl;
+
+        if(notify(h->to(), buf))
+            return;
+        db<UDP>(INF) << "UDP::update: no socket at port " << h->to() << ", datagram dropped!" << endl;
+    }
+
+    _ip->free(buf);
+}
+
+
+UDP::Socket::Socket(const Port & port): _udp(UDP::get()), _port(port), _ready(0)
+{
+    db<UDP>(TRC) << "UDP::Socket(port=" << port << ") => " << this << endl;
+
+    // A Buffer can only be queued in one socket
+    if(_udp->observer(_port))
+        db<UDP>(WRN) << "UDP::Socket: port " << port << " already bound, the socket won't receive anything!" << endl;
+    else
+        _udp->attach(this, _port);
+}
+
+UDP::Socket::~Socket()
+{
+    db<UDP>(TRC) << "~UDP::Socket(this=" << this << ")" << endl;
+
+    if(_udp->observer(_port) == this)
+        _udp->detach(this, _port);
+
+    Buffer * buf;
+    while(_queue.remove(&buf))
+        _udp->_ip->free(buf);
+}
+
+int UDP::Socket::send(const Address & to, const void * data, unsigned int size)
+{
+    db<UDP>(TRC) << "UDP::Socket::send(to=" << to << ",d=" << data << ",s=" << size << ")" << endl;
+
+    if(size > MTU) {
+        db<UDP>(WRN) << "UDP::Socket::send: datagram larger than the MTU!" << endl;
+        return 0;
+    }
+
+    IP * ip = _udp->_ip;
+    Buffer * buf = ip->alloc(to.ip(), IP::PROTO_UDP, sizeof(Header) + size);
+    if(!buf)
+        return 0;
+
+    IP::Header * iph = IP::header(buf);
+    Header * h = new (iph->data<Header>()) Header(_port, to.port(), size);
+    memcpy(h->data<void>(), data, size);
+    if(checksummed && !(ip->offloads() & NIC_Common::TX_L4_CHECKSUM))
+        h->sum(iph);
+
+    ip->send(buf);
+
+    return size;
+}
+
+int UDP::Socket::receive(Address * from, void * data, unsigned int size)
+{
+    db<UDP>(TRC) << "UDP::Socket::receive(d=" << data << ",s=" << size << ")" << endl;
+
+    Datagram d;
+    _ready.p();
+    if(!take(&d))
+        return 0;
+
+    *from = d.from;
+    if(size > d.size)
+        size = d.size;
+    memcpy(data, d.data, size);
+
+    free(d);
+
+    return size;
+}
+
+unsigned int UDP::Socket::receive(Datagram * batch, unsigned int n)
+{
+    db<UDP>(TRC) << "UDP::Socket::receive(b=" << batch << ",n=" << n << ")" << endl;
+
+    if(!n)
+        return 0;
+
+    _ready.p();
+    if(!take(&batch[0]))
+        return 0;
+
+    unsigned int i = 1;
+    for(; (i < n) && _ready.try_p() && take(&batch[i]); i++);
+
+    return i;
+}
+
+// Takes the first datagram of the queue, which _ready says it has, returning false if it turns out empty
+bool UDP::Socket::take(Datagram * d)
+{
+    Buffer * buf = 0;
+    if(!_queue.remove(&buf)) {
+        db<UDP>(WRN) << "UDP::Socket::take: queue empty!" << endl;
+        return false;
+    }
+
+    IP::Header * ip = IP::header(buf);
+    Header * h = ip->data<Header>();
+
+    d->buffer = buf;
+    d->from = Address(ip->from(), h->from());
+    d->data = h->data<void>();
+    d->size = h->length() - sizeof(Header);
+
+    return true;
+}
+
+// Runs in interrupt context, or in the NIC's polling thread (the only producer of the queue)
+void UDP::Socket::update(UDP::Observed * o, const Port & p, Buffer * buf)
+{
+    if(_queue.insert(buf))
+        _ready.v();
+    else {
+        db<UDP>(WRN) << "UDP::Socket::update: queue full, datagram dropped!" << endl;
+        _udp->_ip->free(buf);
+    }
+}
+
+__END_SYS
+
+#endif
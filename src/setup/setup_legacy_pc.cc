@@ -97,10 +97,16 @@ private:
 
     void detect_memory(unsigned long * base, unsigned long * top);
     void detect_pci(unsigned long * base, unsigned long * top);
+    void detect_ecam(System_Info::ECAM_Map * ecam);
     void calibrate_timers();
 
     static void panic() { Machine::panic(); }
 
+    // Pages of the ECAM window, mapped at IO after the PCI memory
+    unsigned int ecam_pages() {
+        return si->ecam.phy ? ((si->ecam.last_bus - si->ecam.first_bus + 1) << 20) / sizeof(Page) : 0;
+    }
+
 private:
     char * bi;
     System_Info * si;
@@ -120,6 +126,8 @@ Setup::Setup(char * boot_image)
     // Get the previously loaded and relocated boot imaged
     bi = reinterpret_cast<char *>(boot_image);
     si = reinterpret_cast<System_Info *>(&__boot_time_system_info);
+    if(Traits<Init>::profiled)
+        si->bp.stamp[System_Info::Boot_Profile::SETUP] = TSC::time_stamp();
     if(si->bm.n_cpus > Traits<Machine>::CPUS)
         si->bm.n_cpus = Traits<Machine>::CPUS;
 
@@ -135,6 +143,7 @@ Setup::Setup(char * boot_image)
 
     // Detect PCI devices and calculate PCI apperture
     detect_pci(&si->bm.mio_base, &si->bm.mio_top);
+    detect_ecam(&si->ecam);
 
     // Calibrate timers
     calibrate_timers();
@@ -405,6 +414,7 @@ void Setup::build_pmm()
     io_size += APIC_SIZE / sizeof(Page); // Add room for APIC (4 kB, 1 page)
     io_size += IO_APIC_SIZE / sizeof(Page); // Add room for IO_APIC (4 kB, 1 page)
     io_size += VGA_SIZE / sizeof(Page); // Add room for VGA (32 kB, 8 pages)
+    io_size += ecam_pages(); // Add room for the PCIe ECAM (1 MB per bus)
     top_page -= MMU::page_tables(io_size);
     si->pmm.io_pts = top_page * sizeof(Page);
 
@@ -572,42 +582,45 @@ void Setup::setup_sys_pt()
     PT_Entry * sys_pt = reinterpret_cast<PT_Entry *>(si->pmm.sys_pt);
     unsigned int n_pts = MMU::page_tables(MMU::pages(SYS_HIGH - SYS));
 
+    // SYSTEM mappings are the same in all address spaces, so they can be global (see MMU::init())
+    unsigned long sys = Flags::SYS | (Traits<MMU>::global_pages ? Flags::GLB : 0);
+
     // Clear the System Page Table
     memset(sys_pt, 0, n_pts * sizeof(Page_Table));
 
     // IDT
-    sys_pt[MMU::index(SYS, IDT)] = si->pmm.idt | Flags::SYS;
+    sys_pt[MMU::index(SYS, IDT)] = si->pmm.idt | sys;
 
     // GDT
-    sys_pt[MMU::index(SYS, GDT)] = si->pmm.gdt | Flags::SYS;
+    sys_pt[MMU::index(SYS, GDT)] = si->pmm.gdt | sys;
 
     // TSSs
     for(unsigned int i = 0; i < Traits<Machine>::CPUS; i++)
-        sys_pt[MMU::index(SYS, TSS0) + i] = (si->pmm.tss + i * sizeof(Page)) | Flags::SYS;
+        sys_pt[MMU::index(SYS, TSS0) + i] = (si->pmm.tss + i * sizeof(Page)) | sys;
 
     // System Info
-    sys_pt[MMU::index(SYS, SYS_INFO)] = MMU::phy2pte(si->pmm.sys_info, Flags::SYS);
+    sys_pt[MMU::index(SYS, SYS_INFO)] = MMU::phy2pte(si->pmm.sys_info, sys);
 
     // Set an entry to this page table, so the system can access it later
-    sys_pt[MMU::index(SYS, SYS_PT)] = MMU::phy2pte(si->pmm.sys_pt, Flags::SYS);
+    sys_pt[MMU::index(SYS, SYS_PT)] = MMU::phy2pte(si->pmm.sys_pt, sys);
 
     // System Page Directory
-    sys_pt[MMU::index(SYS, SYS_PD)] = MMU::phy2pte(si->pmm.sys_pd, Flags::SYS);
+    sys_pt[MMU::index(SYS, SYS_PD)] = MMU::phy2pte(si->pmm.sys_pd, sys);
 
     unsigned int i;
     PT_Entry aux;
 
     // SYSTEM code
     for(i = 0, aux = si->pmm.sys_code; i < MMU::pages(si->lm.sys_code_size); i++, aux = aux + sizeof(Page))
-        sys_pt[MMU::index(SYS, SYS_CODE) + i] = MMU::phy2pte(aux, Flags::SYS);
+        sys_pt[MMU::index(SYS, SYS_CODE) + i] = MMU::phy2pte(aux, sys);
 
     // SYSTEM data
     for(i = 0, aux = si->pmm.sys_data; i < MMU::pages(si->lm.sys_data_size); i++, aux = aux + sizeof(Page))
-        sys_pt[MMU::index(SYS, SYS_DATA) + i] = MMU::phy2pte(aux, Flags::SYS);
+        sys_pt[MMU::index(SYS, SYS_DATA) + i] = MMU::phy2pte(aux, sys);
 
     // SYSTEM stack (used only during init and for the ukernel model)
     for(i = 0, aux = si->pmm.sys_stack; i < MMU::pages(si->lm.sys_stack_size); i++, aux = aux + sizeof(Page))
-        sys_pt[MMU::index(SYS, SYS_STACK) + i] = MMU::phy2pte(aux, Flags::SYS);
+        sys_pt[MMU::index(SYS, SYS_STACK) + i] = MMU::phy2pte(aux, sys);
 
     // SYSTEM heap is handled by Init_System, so we don't map it here!
 
@@ -705,9 +718,12 @@ void Setup::setup_sys_pd()
             sys_pd[i] = MMU::phy2pde(si->pmm.phy_mem_pts + j * sizeof(Page_Table), Flags::APP);
 
     // Calculate the number of page tables needed to map the IO address space
-    unsigned int io_size = MMU::pages(si->bm.mio_top - si->bm.mio_base);
-    io_size += APIC_SIZE / sizeof(Page); // add room for APIC (4 kB, 1 page)
+    unsigned int pci_size = MMU::pages(si->bm.mio_top - si->bm.mio_base);
+    unsigned int io_size = APIC_SIZE / sizeof(Page); // add room for APIC (4 kB, 1 page)
+    io_size += IO_APIC_SIZE / sizeof(Page); // add room for IO_APIC (4 kB, 1 page), as build_pmm() does
     io_size += VGA_SIZE / sizeof(Page); // add room for VGA (64 kB, 16 pages)
+    io_size += pci_size;
+    io_size += ecam_pages(); // add room for the PCIe ECAM (1 MB per bus)
     n_pts = MMU::page_tables(io_size);
 
     // Map I/O address space into the page tables pointed by io_pts
@@ -719,8 +735,12 @@ void Setup::setup_sys_pd()
         pts[i] = MMU::phy2pte(IO_APIC_PHY + j * sizeof(Page), Flags::APIC);
     for(unsigned int j = 0; i < ((APIC_SIZE / sizeof(Page)) + (IO_APIC_SIZE / sizeof(Page)) + (VGA_SIZE / sizeof(Page))); i++, j++)
         pts[i] = MMU::phy2pte(VGA_PHY + j * sizeof(Page), Flags::VGA);
-    for(unsigned int j = 0; i < io_size; i++, j++)
+    for(unsigned int j = 0; j < pci_size; i++, j++)
         pts[i] = MMU::phy2pte(si->bm.mio_base + j * sizeof(Page), Flags::PCI);
+    if(si->ecam.phy)
+        si->ecam.log = IO + i * sizeof(Page);
+    for(unsigned int j = 0; i < io_size; i++, j++)
+        pts[i] = MMU::phy2pte(si->ecam.phy + j * sizeof(Page), Flags::PCI);
 
     // Attach devices' memory at Memory_Map::IO
     assert((MMU::directory(MMU::align_directory(IO)) + n_pts) < (MMU::PD_ENTRIES - 1)); // check if it would overwrite the OS
@@ -980,6 +1000,84 @@ void Setup::detect_pci(unsigned long * base, unsigned long * top)
 }
 
 
+void Setup::detect_ecam(System_Info::ECAM_Map * ecam)
+{
+    db<Setup>(TRC) << "Setup::detect_ecam()" << endl;
+
+    ecam->phy = 0;
+    ecam->log = 0;
+    ecam->first_bus = 0;
+    ecam->last_bus = 0;
+    if(!Traits<PCI>::ecam)
+        return;
+
+    // Look for the ACPI RSDP ("RSD PTR ", with a zero checksum over its first 20 bytes) in the first KB of the EBDA
+    // and then in the BIOS area, on 16-byte boundaries
+    unsigned char * rsdp = 0;
+    for(unsigned int area = 0; !rsdp && (area < 2); area++) {
+        unsigned long ebda = *reinterpret_cast<unsigned short *>(0x40e) << 4;
+        unsigned char * p = reinterpret_cast<unsigned char *>(area ? 0xe0000 : ebda);
+        unsigned char * end = area ? reinterpret_cast<unsigned char *>(0x100000) : p + 1024;
+        for(; p && (p < end); p += 16) {
+            if(memcmp(p, "RSD PTR ", 8))
+                continue;
+            unsigned char sum = 0;
+            for(unsigned int i = 0; i < 20; i++)
+                sum += p[i];
+            if(!sum) {
+                rsdp = p;
+                break;
+            }
+        }
+    }
+    if(!rsdp) {
+        db<Setup>(INF) << "PCIe ECAM: no ACPI!" << endl;
+        return;
+    }
+
+    // The RSDT is a 36-byte header followed by the 32-bit addresses of the other tables (MCFG among them)
+    unsigned char * rsdt = reinterpret_cast<unsigned char *>(*reinterpret_cast<unsigned int *>(&rsdp[16]));
+    unsigned int entries = (*reinterpret_cast<unsigned int *>(&rsdt[4]) - 36) / 4;
+    unsigned char * mcfg = 0;
+    for(unsigned int i = 0; !mcfg && (i < entries); i++) {
+        unsigned char * table = reinterpret_cast<unsigned char *>(reinterpret_cast<unsigned int *>(&rsdt[36])[i]);
+        if(!memcmp(table, "MCFG", 4))
+            mcfg = table;
+    }
+    if(!mcfg) {
+        db<Setup>(INF) << "PCIe ECAM: no MCFG!" << endl;
+        return;
+    }
+
+    // MCFG entries (from byte 44 on) are {u64 base, u16 segment, u8 start bus, u8 end bus, u32 reserved}
+    unsigned int length = *reinterpret_cast<unsigned int *>(&mcfg[4]);
+    for(unsigned int offset = 44; offset + 16 <= length; offset += 16) {
+        unsigned long long base = *reinterpret_cast<unsigned long long *>(&mcfg[offset]);
+        unsigned short segment = *reinterpret_cast<unsigned short *>(&mcfg[offset + 8]);
+        unsigned int first = mcfg[offset + 10];
+        unsigned int last = mcfg[offset + 11];
+        if((segment != 0) || (first > Traits<PCI>::MAX_BUS) || ((base >> 32) != 0))
+            continue;
+
+        ecam->first_bus = first;
+        ecam->last_bus = (last > Traits<PCI>::MAX_BUS) ? Traits<PCI>::MAX_BUS : last;
+        ecam->phy = base + (first << 20);
+        break;
+    }
+
+    // The ECAM window goes at IO after the devices' memory, so it must fit in what is left below APP_LOW
+    unsigned long io = APIC_SIZE + IO_APIC_SIZE + VGA_SIZE;
+    io += MMU::pages(si->bm.mio_top - si->bm.mio_base) * sizeof(Page);
+    if(ecam->phy && ((io + ecam_pages() * sizeof(Page)) > (APP_LOW - IO))) {
+        db<Setup>(WRN) << "PCIe ECAM doesn't fit in the I/O window, using CONFADDR!" << endl;
+        ecam->phy = 0;
+    }
+
+    db<Setup>(INF) << "PCIe ECAM={phy=" << reinterpret_cast<void *>(ecam->phy) << ",buses=[" << ecam->first_bus << ","
+                   << ecam->last_bus << "]}" << endl;
+}
+
+
 void Setup::calibrate_timers()
 {
     db<Setup>(TRC) << "Setup::calibrate_timers()" << endl;
@@ -15,6 +15,9 @@ extern "C" {
     void _reset() __attribute__ ((naked)); // so it can be safely reached from the vector table
     void _setup(); // just to create a Setup object
 
+    // The other cores skip the global constructors, which belong to the boot one, and join INIT here (see init_system.cc)
+    void _init_secondary();
+
     // LD eliminates this variable while performing garbage collection, that's why the used attribute.
     char __boot_time_system_info[sizeof(EPOS::S::System_Info)] __attribute__ ((used)) = "<System_Info placeholder>"; // actual System_Info will be added by mkbi!
 }
@@ -45,6 +48,10 @@ private:
 public:
     Setup();
 
+    // Multicore boot hand-shake (see _reset())
+    static void wake_up();
+    static void park();
+
 private:
     void say_hi();
     void setup_flat_paging();
@@ -54,10 +61,24 @@ private:
 private:
     char * bi;
     System_Info * si;
+
+    // Used before the BSS is cleared, hence in .data
+    static volatile bool _arrived[Traits<Machine>::CPUS];
+    static volatile bool _released;
 };
 
+volatile bool Setup::_arrived[Traits<Machine>::CPUS] __attribute__ ((section(".data"))) = { false };
+volatile bool Setup::_released __attribute__ ((section(".data"))) = false;
+
 Setup::Setup()
 {
+    // The other cores only enable paging, with the page table built by CPU 0, on their way to INIT
+    if(CPU::id() != 0) {
+        enable_paging();
+        call_next();
+        return;
+    }
+
     // Initialize the display so we can print
     Display::init();
     kerr << endl;
@@ -65,6 +86,8 @@ Setup::Setup()
 
     // Recover pointers to the boot image and to the System Info
     si = reinterpret_cast<System_Info *>(&__boot_time_system_info);
+    if(Traits<Init>::profiled)
+        si->bp.stamp[System_Info::Boot_Profile::SETUP] = TSC::time_stamp();
     if(si->bm.n_cpus > Traits<Machine>::CPUS)
         si->bm.n_cpus = Traits<Machine>::CPUS;
 
@@ -77,6 +100,11 @@ Setup::Setup()
     // Configure a flat memory model for the single task in the system
     setup_flat_paging();
 
+    // Release the other cores (see park()), which can now share the page table. Caches are still off here, so they
+    // will see both.
+    if(Traits<System>::multicore)
+        _released = true;
+
     // Enable paging
     enable_paging();
 
@@ -180,8 +208,13 @@ void Setup::setup_flat_paging()
     CPU::Reg mem = RAM_BASE;
     CPU::Reg * pd = reinterpret_cast<CPU::Reg *>(FLAT_PAGE_TABLE);
 
+    // The exclusive accesses behind CPU::cas() and friends need normal memory, so multicores map RAM as such, except
+    // for the block that also holds MBOX_COM_BASE
     for(unsigned int i = 0; i < PD_ENTRIES; i++, mem += BLOCK_SIZE)
-        pd[i] = reinterpret_cast<CPU::Reg>(mem) | Page_Flags::FLAT_MEM_BLOCK;
+        if(Traits<System>::multicore && (mem + BLOCK_SIZE <= MIO_BASE))
+            pd[i] = reinterpret_cast<CPU::Reg>(mem) | Page_Flags::FLAT_MEM_BLOCK | Page_Flags::CWB;
+        else
+            pd[i] = reinterpret_cast<CPU::Reg>(mem) | Page_Flags::FLAT_MEM_BLOCK;
 
 //    // Two-level mapping, 16KB granule
 //    // To used this code, remember to adjust FLAT_PAGE_TABLE to account for all the associated page tables (e.g. (RAM_TOP - (PD_ETRIES + 1) * 16 * 1024) & ~(0x3fff)
@@ -205,11 +238,6 @@ void Setup::setup_flat_paging()
 //            pt[j] = reinterpret_cast<CPU::Reg>(mem) | Page_Flags::PAGE_DESCRIPTOR | Page_Flags::INNER_SHAREABLE | Page_Flags::SEL_MAIR_ATTR0 | Page_Flags::ACCESS;
 //    }
 
-    CPU::mair_el1((CPU::ATTR_DEVICE_nGnRnE) << 0 * CPU::ATTR_OFFSET | // first attribute_index
-        (CPU::ATTR_NORMAL_WT) << 1 * CPU::ATTR_OFFSET | // second attribute index
-        (CPU::ATTR_NORMAL_WB) << 2 * CPU::ATTR_OFFSET | // second attribute index
-        (CPU::ATTR_NORMAL_NON_CACHE) << 3 * CPU::ATTR_OFFSET); // second attribute index
-
 #endif
 }
 
@@ -288,7 +316,8 @@ void Setup::enable_paging()
     MMU::flush_tlb();
 
     // Adjust pointers that will still be used to their logical addresses
-    Display::init(); // adjust the pointers in Display by calling init
+    if(CPU::id() == 0)
+        Display::init(); // adjust the pointers in Display by calling init
 
     if(Traits<Setup>::hysterically_debugged) {
         db<Setup>(INF) << "pc=" << CPU::pc() << endl;
@@ -297,6 +326,12 @@ void Setup::enable_paging()
 
 #else 
 
+    // Memory attributes selected by the page table entries (MAIR is per core, so it is set here instead of at setup_flat_paging())
+    CPU::mair_el1((CPU::ATTR_DEVICE_nGnRnE) << 0 * CPU::ATTR_OFFSET | // first attribute_index
+        (CPU::ATTR_NORMAL_WT) << 1 * CPU::ATTR_OFFSET | // second attribute index
+        (CPU::ATTR_NORMAL_WB) << 2 * CPU::ATTR_OFFSET | // second attribute index
+        (CPU::ATTR_NORMAL_NON_CACHE) << 3 * CPU::ATTR_OFFSET); // second attribute index
+
     // Configure paging with two levels and 16KB pages via TTBRC
     CPU::ttbcr(CPU::TTBR1_DISABLE | CPU::TTBR0_WALK_INNER_SHAREABLE | CPU::TTBR0_WALK_OUTER_WB_WA | CPU::TTBR0_WALK_INNER_WB_WA | CPU::TTBR0_TG0_16KB | CPU::TTBR0_SIZE_4GB);
     CPU::isb();
@@ -311,7 +346,8 @@ void Setup::enable_paging()
     CPU::sctlr(CPU::sctlr() | CPU::MMU_ENABLE | CPU::DCACHE | CPU::ICACHE);
     CPU::isb();
 
-    Display::init();
+    if(CPU::id() == 0)
+        Display::init();
 
 #endif
 }
@@ -322,12 +358,44 @@ void Setup::call_next()
     db<Setup>(INF) << "SETUP ends here!" << endl;
 
     // Call the next stage
-    static_cast<void (*)()>(_start)();
+    if(CPU::id() == 0)
+        static_cast<void (*)()>(_start)();
+    else
+        static_cast<void (*)()>(_init_secondary)();
 
     // SETUP is now part of the free memory and this point should never be reached, but, just in case ... :-)
     db<Setup>(ERR) << "OS failed to init!" << endl;
 }
 
+
+// CPU 0 fetches the other cores from the firmware's stub, which the vector table is about to overwrite, and waits for
+// all of them to leave it. Cores started by the boot loader itself (e.g. QEMU with an ELF image) are already on their way.
+void Setup::wake_up()
+{
+    for(unsigned int i = 1; i < Traits<Machine>::CPUS; i++)
+#ifdef __armv7__
+        reinterpret_cast<BCM_Mailbox *>(Memory_Map::MBOX_CTRL_BASE)->start(i, reinterpret_cast<CPU::Reg>(&_entry));
+#else
+        reinterpret_cast<volatile CPU::Reg *>(Memory_Map::SPIN_TABLE)[i] = reinterpret_cast<CPU::Reg>(&_entry);
+#endif
+    CPU::dsb();
+    CPU::sev();
+
+    for(unsigned int i = 1; i < Traits<Machine>::CPUS; i++)
+        while(!_arrived[i]);
+}
+
+// The other cores wait here for CPU 0 to build the page table (see Setup()), or for ever if they are not to be used
+void Setup::park()
+{
+    if(!Traits<System>::multicore || (CPU::id() >= Traits<Machine>::CPUS))
+        for(;;)
+            CPU::halt();
+
+    _arrived[CPU::id()] = true;
+    while(!_released);
+}
+
 __END_SYS
 
 using namespace EPOS::S;
@@ -362,11 +430,6 @@ void _reset()
 {
     CPU::int_disable(); // interrupts will be re-enabled at init_end
 
-    if(CPU::id() != 0) {
-        // We want secondary cores to be held here
-        CPU::halt();
-    }
-
     // QEMU get us here in SVC mode with interrupt disabled, but the real Raspberry Pi3 starts in hypervisor mode, so we must switch to SVC mode
     if(!Traits<Machine>::emulated) {
         CPU::Reg cpsr = CPU::psr();
@@ -383,21 +446,29 @@ void _reset()
     CPU::sp(Memory_Map::BOOT_STACK + Traits<Machine>::STACK_SIZE * (CPU::id() + 1) - sizeof(long));
     CPU::int_disable(); // interrupts will be re-enabled at init_end
 
-    // After a reset, we copy the vector table to 0x0000 to get a cleaner memory map (it is originally at 0x8000)
-    // An alternative would be to set vbar address via mrc p15, 0, r1, c12, c0, 0
-    CPU::r0(reinterpret_cast<CPU::Reg>(&_entry)); // load r0 with the source pointer
-    CPU::r1(Memory_Map::VECTOR_TABLE); // load r1 with the destination pointer
+    // The other cores either come straight from the boot loader or are fetched by CPU 0 (see Setup::wake_up())
+    if(CPU::id() != 0)
+        Setup::park();
+    else if(Traits<System>::multicore)
+        Setup::wake_up();
 
-    // Copy the first 32 bytes
-    CPU::ldmia(); // load multiple registers from the memory pointed by r0 and auto-increment it accordingly
-    CPU::stmia(); // store multiple registers to the memory pointed by r1 and auto-increment it accordingly
+    if(CPU::id() == 0) {
+        // After a reset, we copy the vector table to 0x0000 to get a cleaner memory map (it is originally at 0x8000)
+        // An alternative would be to set vbar address via mrc p15, 0, r1, c12, c0, 0
+        CPU::r0(reinterpret_cast<CPU::Reg>(&_entry)); // load r0 with the source pointer
+        CPU::r1(Memory_Map::VECTOR_TABLE); // load r1 with the destination pointer
 
-    // Repeat to copy the subsequent 32 bytes
-    CPU::ldmia();
-    CPU::stmia();
+        // Copy the first 32 bytes
+        CPU::ldmia(); // load multiple registers from the memory pointed by r0 and auto-increment it accordingly
+        CPU::stmia(); // store multiple registers to the memory pointed by r1 and auto-increment it accordingly
 
-    // Clear the BSS (SETUP was linked to CRT0, but entry point didn't go through BSS clear)
-    Machine::clear_bss();
+        // Repeat to copy the subsequent 32 bytes
+        CPU::ldmia();
+        CPU::stmia();
+
+        // Clear the BSS (SETUP was linked to CRT0, but entry point didn't go through BSS clear)
+        Machine::clear_bss();
+    }
 
     // Set VBAR to point to the relocated the vector table
     CPU::vbar(Memory_Map::VECTOR_TABLE);
@@ -591,20 +662,23 @@ void _reset()
 {
     CPU::int_disable(); // interrupts will be re-enabled at init_end
 
-    if(CPU::id() != 0) {
-        // We want secondary cores to be held here
-        CPU::halt();
+    // The other cores either come straight from the boot loader or are fetched by CPU 0 (see Setup::wake_up())
+    if(CPU::id() != 0)
+        Setup::park();
+    else if(Traits<System>::multicore)
+        Setup::wake_up();
+
+    if(CPU::id() == 0) {
+        // Relocated the vector table, which has 4 entries for each of the 4 scenarios, all 128 bytes aligned, plus an 8 bytes pointer, totaling 2056 bytes
+        CPU::Reg * src = reinterpret_cast<CPU::Reg *>(&_vector_table);
+        CPU::Reg * dst = reinterpret_cast<CPU::Reg *>(Memory_Map::VECTOR_TABLE);
+        for(int i = 0; i < (2056 / 8); i++)
+            dst[i] = src[i];
+
+        // Clear the BSS (SETUP was linked to CRT0, but entry point didn't go through BSS clear)
+        Machine::clear_bss();
     }
 
-    // Relocated the vector table, which has 4 entries for each of the 4 scenarios, all 128 bytes aligned, plus an 8 bytes pointer, totaling 2056 bytes
-    CPU::Reg * src = reinterpret_cast<CPU::Reg *>(&_vector_table);
-    CPU::Reg * dst = reinterpret_cast<CPU::Reg *>(Memory_Map::VECTOR_TABLE);
-    for(int i = 0; i < (2056 / 8); i++)
-        dst[i] = src[i];
-
-    // Clear the BSS (SETUP was linked to CRT0, but entry point didn't go through BSS clear)
-    Machine::clear_bss();
-
     // Set EL1 VBAR to the relocated vector table
     CPU::vbar_el1(static_cast<CPU::Phy_Addr>(Memory_Map::VECTOR_TABLE));
 
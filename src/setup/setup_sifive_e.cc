@@ -59,6 +59,8 @@ Setup::Setup()
     Display::init();
 
     si = reinterpret_cast<System_Info *>(&__boot_time_system_info);
+    if(Traits<Init>::profiled)
+        si->bp.stamp[System_Info::Boot_Profile::SETUP] = TSC::time_stamp();
     if(si->bm.n_cpus > Traits<Machine>::CPUS)
         si->bm.n_cpus = Traits<Machine>::CPUS;
 
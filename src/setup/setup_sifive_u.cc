@@ -14,6 +14,9 @@ extern "C" {
     void _entry() __attribute__ ((used, naked, section(".init")));
     void _setup();
 
+    // The other harts skip the global constructors, which belong to the boot one, and join INIT here (see init_system.cc)
+    void _init_secondary();
+
     // LD eliminates this variable while performing garbage collection, that's why the used attribute.
     char __boot_time_system_info[sizeof(EPOS::S::System_Info)] __attribute__ ((used)) = "<System_Info placeholder>"; // actual System_Info will be added by mkbi!
 }
@@ -54,11 +57,19 @@ private:
 
 Setup::Setup()
 {
+    // The other harts only go through SETUP on their way to INIT
+    if(CPU::id() != 0) {
+        call_next();
+        return;
+    }
+
     Display::init();
     kout << endl;
     kerr << endl;
     
     si = reinterpret_cast<System_Info *>(&__boot_time_system_info);
+    if(Traits<Init>::profiled)
+        si->bp.stamp[System_Info::Boot_Profile::SETUP] = TSC::time_stamp();
     if(si->bm.n_cpus > Traits<Machine>::CPUS)
         si->bm.n_cpus = Traits<Machine>::CPUS;
 
@@ -68,6 +79,11 @@ Setup::Setup()
     // Print basic facts about this EPOS instance
     say_hi();
 
+    // Release the other harts, which have been waiting at _entry() for the BSS to be cleared
+    if(Traits<System>::multicore)
+        for(unsigned int i = 1; i < Traits<Machine>::CPUS; i++)
+            IC::ipi(i);
+
     // SETUP ends here, so let's transfer control to the next stage (INIT or APP)
     call_next();
 }
@@ -111,7 +127,10 @@ void Setup::call_next()
     db<Setup>(INF) << "SETUP ends here!" << endl;
 
     // Call the next stage
-    static_cast<void (*)()>(_start)();
+    if(CPU::id() == 0)
+        static_cast<void (*)()>(_start)();
+    else
+        static_cast<void (*)()>(_init_secondary)();
 
     // SETUP is now part of the free memory and this point should never be reached, but, just in case ... :-)
     db<Setup>(ERR) << "OS failed to init!" << endl;
@@ -123,16 +142,22 @@ using namespace EPOS::S;
 
 void _entry() // machine mode
 {
-    if(CPU::mhartid() != 0)                             // SiFive-U requires 2 cores, so we disable core 1 here
+    if(CPU::mhartid() >= (Traits<System>::multicore ? Traits<Machine>::CPUS : 1)) // SiFive-U requires at least 2 cores, so we disable the extra ones here
         CPU::halt();
 
     CPU::mstatusc(CPU::MIE);                            // disable interrupts (they will be reenabled at Init_End)
     CPU::mies(CPU::MSI);                                // enable interrupts generation by CLINT
     CLINT::mtvec(CLINT::DIRECT, _int_entry);            // setup a preliminary machine mode interrupt handler pointing it to _int_entry
 
-    CPU::sp(Memory_Map::BOOT_STACK + Traits<Machine>::STACK_SIZE - sizeof(long)); // set the stack pointer, thus creating a stack for SETUP
+    CPU::sp(Memory_Map::BOOT_STACK + Traits<Machine>::STACK_SIZE * (CPU::id() + 1) - sizeof(long)); // set the stack pointer, thus creating a stack for SETUP (one per hart)
 
-    Machine::clear_bss();
+    if(CPU::id() == 0)
+        Machine::clear_bss();
+    else {
+        while(!(CPU::mip() & CPU::MSI))                 // wait for the boot hart to release us at the end of SETUP (MSI wakes WFI even with MIE off)
+            CPU::halt();
+        IC::ipi_eoi();
+    }
 
     CPU::mstatus(CPU::MPP_M);                           // stay in machine mode at mret
 
@@ -142,8 +167,10 @@ void _entry() // machine mode
 
 void _setup() // supervisor mode
 {
-    kerr  << endl;
-    kout  << endl;
+    if(CPU::id() == 0) {
+        kerr  << endl;
+        kout  << endl;
+    }
 
     Setup setup;
 }
@@ -52,6 +52,7 @@ private:
     void panic() { Machine::panic(); }
 
     static SCU * scu() { return reinterpret_cast<SCU *>(Memory_Map::SCU_BASE); }
+    static PL310 * l2_cache() { return reinterpret_cast<PL310 *>(Memory_Map::L2_CACHE_BASE); }
     static GIC_CPU * gic_cpu() { return reinterpret_cast<GIC_CPU *>(Memory_Map::GIC_CPU_BASE); }
     static GIC_Distributor * gic_distributor() { return reinterpret_cast<GIC_Distributor *>(Memory_Map::GIC_DIST_BASE); }
 
@@ -69,6 +70,8 @@ Setup::Setup()
     Display::init();
 
     si = reinterpret_cast<System_Info *>(&__boot_time_system_info);
+    if(Traits<Init>::profiled)
+        si->bp.stamp[System_Info::Boot_Profile::SETUP] = TSC::time_stamp();
 
     db<Setup>(TRC) << "Setup(si=" << reinterpret_cast<void *>(si) << ",sp=" << CPU::sp() << ")" << endl;
     db<Setup>(INF) << "Setup:si=" << *si << endl;
@@ -122,6 +125,12 @@ void Setup::setup_flat_paging()
         pt[(i & 0x3ff)] = (i << 20) | Section_Flags::FLAT_MEMORY_MEM; // the mask prevents GCC warning about integer overflow and aggressive loop optimization
     for(CPU::Reg i = MMU_Common<10,10,12>::directory(MIO_BASE); i < MMU_Common<10,10,12>::directory(MIO_BASE) + MMU_Common<10,10,12>::pages(MIO_TOP - MIO_BASE) - 1; i++)
         pt[i] = (i << 20) | Section_Flags::FLAT_MEMORY_DEV;
+
+    // The AXI DMA's section of the PL (M_AXI_GP0), as device memory
+    if(Traits<FPGA>::enabled) {
+        CPU::Reg i = MMU_Common<10,10,12>::directory(Memory_Map::AXI_DMA_BASE);
+        pt[i] = (i << 20) | Section_Flags::FLAT_MEMORY_PER;
+    }
 }
 
 void Setup::enable_paging()
@@ -143,6 +152,24 @@ void Setup::enable_paging()
     // Set ttbr0 with base address
     CPU::ttbr0(FLAT_PAGE_TABLE);
 
+    // Join the SCU coherency domain (the BSP enables the SCU before releasing the APs)
+    if(Traits<Build>::CPUS > 1)
+        scu()->enable_cache_coherence();
+
+    // Enable the L2 (once, with the caches still off, so nothing is lost) and have the cores send it prefetch hints
+    if(Traits<Machine>::L2_CACHE) {
+        if(CPU::id() == 0) {
+            l2_cache()->disable();
+            l2_cache()->latencies(Traits<Machine>::L2_TAG_LATENCY, Traits<Machine>::L2_DATA_LATENCY);
+            l2_cache()->prefetch(Traits<Machine>::L2_PREFETCH, Traits<Machine>::L2_PREFETCH_OFFSET);
+            l2_cache()->power(false, true);
+            scu()->speculative_linefills(Traits<Machine>::L2_PREFETCH);
+            l2_cache()->enable();
+        }
+        if(Traits<Machine>::L2_PREFETCH)
+            CPU::actlr(CPU::actlr() | CPU::L2_PREFETCH);
+    }
+
     // Enable MMU through SCTLR and ACTLR
     CPU::actlr(CPU::actlr() | CPU::SMP); // Set SMP bit
     CPU::sctlr((CPU::sctlr() | CPU::DCACHE | CPU::ICACHE | CPU::MMU_ENABLE) & ~(CPU::AFE));
@@ -68,344 +68,291 @@ const unsigned char SWAES<16>::rcon[255] = {
 	   0xc6, 0x97, 0x35, 0x6a, 0xd4, 0xb3, 0x7d, 0xfa, 0xef, 0xc5, 0x91, 0x39, 0x72, 0xe4, 0xd3, 0xbd,
 	   0x61, 0xc2, 0x9f, 0x25, 0x4a, 0x94, 0x33, 0x66, 0xcc, 0x83, 0x1d, 0x3a, 0x74, 0xe8, 0xcb  };
 
-void SWAES<16>::ebc_encrypt(const unsigned char * input, const unsigned char * key, unsigned char * output)
+bool SWAES<16>::_tables;
+unsigned int SWAES<16>::_te[256];
+unsigned int SWAES<16>::_td[256];
+
+// Words hold a column with its first byte in the most significant position
+static inline unsigned int load(const unsigned char * p) { return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]; }
+static inline void store(unsigned char * p, unsigned int w) { p[0] = w >> 24; p[1] = w >> 16; p[2] = w >> 8; p[3] = w; }
+static inline unsigned int ror(unsigned int w, unsigned int n) { return (w >> n) | (w << (32 - n)); }
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRYPTO)
+#define __aes_ce__
+// The Crypto Extensions load round keys with ld1, so they are kept in memory order
+static inline unsigned int round_key(unsigned int w) { return __builtin_bswap32(w); }
+#else
+static inline unsigned int round_key(unsigned int w) { return w; }
+#endif
+
+// Te[x] is the column of MixColumns times sbox[x] in the first row ({02,01,01,03}) and Td[x] that of InvMixColumns
+// times rsbox[x] ({0e,09,0d,0b}); the other rows are rotations of them
+void SWAES<16>::build_tables()
 {
-    // Copy input to output, and work in-memory on output
-    block_copy(output, input);
-    _state = reinterpret_cast<State *>(output);
-
-    _key = key;
-    expand_key();
-
-    // The next function call encrypts the PlainText with the _key using AES algorithm.
-    cipher();
-}
-
-void SWAES<16>::ebc_decrypt(const unsigned char * input, const unsigned char * key, unsigned char *output)
-{
-    // Copy input to output, and work in-memory on output
-    block_copy(output, input);
-    _state = reinterpret_cast<State *>(output);
-
-    // The expand_key routine must be called before encryption.
-    _key = key;
-    expand_key();
-
-    inv_cipher();
+    for(unsigned int x = 0; x < 256; x++) {
+        unsigned char s = sbox[x];
+        _te[x] = (xtime(s) << 24) | (s << 16) | (s << 8) | (xtime(s) ^ s);
+        unsigned char r = rsbox[x];
+        _td[x] = (multiply(r, 0x0e) << 24) | (multiply(r, 0x09) << 16) | (multiply(r, 0x0d) << 8) | multiply(r, 0x0b);
+    }
+    _tables = true;
 }
 
-void SWAES<16>::cbc_encrypt_buffer(unsigned char * output, const unsigned char * _input, int length, const unsigned char * key, unsigned char * iv)
+// This function produces Nb(Nr+1) round keys, which are used in each round to encrypt and decrypt the states.
+// The decryption schedule is that of the equivalent inverse cipher (FIPS-197, 5.3.5).
+void SWAES<16>::expand_key()
 {
-    unsigned char remainders = length % KEY_SIZE; /* Remaining bytes in the last non-full block */
-
-    block_copy(output, _input);
-    _state = reinterpret_cast<State *>(output);
-
-    // Skip the key expansion if key is passed as 0
-    if(0 != key) {
-        _key = key;
-        expand_key();
-    }
-
-    if(iv != 0)
-        _iv = iv;
-
-    int i;
-    for(i = 0; i < length; i += KEY_SIZE) {
-        unsigned char input[KEY_SIZE];
-        for(int j=0; (j<(int)KEY_SIZE) && (j+i < length); j++)
-            input[j] = _input[j+i];
-        xor_with_iv(input);
-        block_copy(output, input);
-        _state = reinterpret_cast<State *>(output);
-        cipher();
-        _iv = output;
-        output += KEY_SIZE;
+    if(!_tables)
+        build_tables();
+
+    unsigned int w[Nb * (Nr + 1)];
+    for(unsigned int i = 0; i < Nk; i++)
+        w[i] = load(&_key[i * 4]);
+    for(unsigned int i = Nk; i < Nb * (Nr + 1); i++) {
+        unsigned int t = w[i - 1];
+        if(i % Nk == 0)
+            t = ((sbox[(t >> 16) & 0xff] << 24) | (sbox[(t >> 8) & 0xff] << 16) | (sbox[t & 0xff] << 8) | sbox[t >> 24]) ^ (rcon[i / Nk] << 24);
+        w[i] = w[i - Nk] ^ t;
     }
 
-    if(remainders) {
-        block_copy(output, _input+i);
-        memset(output + remainders, 0, KEY_SIZE - remainders); /* add 0-padding */
-        _state = reinterpret_cast<State *>(output);
-        cipher();
+    for(unsigned int i = 0; i < Nb * (Nr + 1); i++) {
+        unsigned int d = w[i];
+        if((i >= Nb) && (i < Nb * Nr)) // InvMixColumns, through Td, which undoes the substitution with sbox
+            d = _td[sbox[d >> 24]] ^ ror(_td[sbox[(d >> 16) & 0xff]], 8) ^ ror(_td[sbox[(d >> 8) & 0xff]], 16) ^ ror(_td[sbox[d & 0xff]], 24);
+        _ek[i] = round_key(w[i]);
+        _dk[i] = round_key(d);
     }
 }
 
-void SWAES<16>::cbc_decrypt_buffer(unsigned char * output, const unsigned char * input, int length, const unsigned char * key, unsigned char * iv)
-{
-    int i;
-    unsigned char remainders = length % KEY_SIZE; /* Remaining bytes in the last non-full block */
-
-    block_copy(output, input);
-    _state = reinterpret_cast<State *>(output);
-
-    // Skip the key expansion if key is passed as 0
-    if(0 != key) {
-        _key = key;
-        expand_key();
-    }
-
-    // If iv is passed as 0, we continue to encrypt without re-setting the _iv
-    if(iv != 0)
-        _iv = iv;
-
-    for(i = 0; i < length; i += KEY_SIZE) {
-        block_copy(output, input);
-        _state = reinterpret_cast<State *>(output);
-        inv_cipher();
-        xor_with_iv(output);
-        _iv = const_cast<unsigned char *>(input);
-        input += KEY_SIZE;
-        output += KEY_SIZE;
-    }
+#ifdef __aes_ce__
 
-    if(remainders) {
-        block_copy(output, input);
-        memset(output+remainders, 0, KEY_SIZE - remainders); /* add 0-padding */
-        _state = reinterpret_cast<State *>(output);
-        inv_cipher();
-    }
+// cipher encrypts one block, which can be done in place
+void SWAES<16>::cipher(unsigned char * output, const unsigned char * input)
+{
+    const unsigned int * rk = _ek;
+    ASM("       ld1     {v0.16b}, [%[in]]               \n"
+        "       mov     w9, #9                          \n"
+        "1:     ld1     {v1.16b}, [%[rk]], #16          \n"
+        "       aese    v0.16b, v1.16b                  \n"
+        "       aesmc   v0.16b, v0.16b                  \n"
+        "       subs    w9, w9, #1                      \n"
+        "       b.ne    1b                              \n"
+        "       ld1     {v1.16b, v2.16b}, [%[rk]]       \n"
+        "       aese    v0.16b, v1.16b                  \n"
+        "       eor     v0.16b, v0.16b, v2.16b          \n"
+        "       st1     {v0.16b}, [%[out]]              \n"
+        : [rk]"+r"(rk) : [in]"r"(input), [out]"r"(output) : "x9", "v0", "v1", "v2", "cc", "memory");
 }
 
-// This function produces Nb(Nr+1) round keys. The round keys are used in each round to decrypt the states.
-void SWAES<16>::expand_key(void)
+// PARALLEL blocks at a time, each round key applied to all of them, so the AESE/AESMC latencies overlap
+void SWAES<16>::cipher(unsigned char * output, const unsigned char * input, unsigned int blocks)
 {
-    unsigned int i, j, k;
-    unsigned char tempa[4]; // Used for the column/row operations
-
-    // The first round key is the key itself.
-    for(i = 0; i < Nk; ++i) {
-        _round_key[(i * 4) + 0] = _key[(i * 4) + 0];
-        _round_key[(i * 4) + 1] = _key[(i * 4) + 1];
-        _round_key[(i * 4) + 2] = _key[(i * 4) + 2];
-        _round_key[(i * 4) + 3] = _key[(i * 4) + 3];
-    }
-
-    // All other round keys are found from the previous round keys.
-    for(; (i < (Nb * (Nr + 1))); ++i) {
-        for(j = 0; j < 4; ++j)
-            tempa[j]=_round_key[(i-1) * 4 + j];
-        if (i % Nk == 0) {
-            // This function rotates the 4 bytes in a word to the left once.
-            // [a0,a1,a2,a3] becomes [a1,a2,a3,a0]
-
-            // Function RotWord()
-            {
-                k = tempa[0];
-                tempa[0] = tempa[1];
-                tempa[1] = tempa[2];
-                tempa[2] = tempa[3];
-                tempa[3] = k;
-            }
-
-            // SubWord() is a function that takes a four-byte input word and
-            // applies the S-box to each of the four bytes to produce an output word.
-
-            // Function Subword()
-            {
-                tempa[0] = sbox[static_cast<int>(tempa[0])];
-                tempa[1] = sbox[static_cast<int>(tempa[1])];
-                tempa[2] = sbox[static_cast<int>(tempa[2])];
-                tempa[3] = sbox[static_cast<int>(tempa[3])];
-            }
-
-            tempa[0] =  tempa[0] ^ rcon[i/Nk];
-        }
-        else if (Nk > 6 && i % Nk == 4) {
-            // Function Subword()
-            {
-                tempa[0] = sbox[static_cast<int>(tempa[0])];
-                tempa[1] = sbox[static_cast<int>(tempa[1])];
-                tempa[2] = sbox[static_cast<int>(tempa[2])];
-                tempa[3] = sbox[static_cast<int>(tempa[3])];
-            }
-        }
-        _round_key[i * 4 + 0] = _round_key[(i - Nk) * 4 + 0] ^ tempa[0];
-        _round_key[i * 4 + 1] = _round_key[(i - Nk) * 4 + 1] ^ tempa[1];
-        _round_key[i * 4 + 2] = _round_key[(i - Nk) * 4 + 2] ^ tempa[2];
-        _round_key[i * 4 + 3] = _round_key[(i - Nk) * 4 + 3] ^ tempa[3];
+    for(; blocks >= PARALLEL; blocks -= PARALLEL, input += PARALLEL * BLOCK_SIZE, output += PARALLEL * BLOCK_SIZE) {
+        const unsigned int * rk = _ek;
+        ASM("       ld1     {v0.16b, v1.16b, v2.16b, v3.16b}, [%[in]]       \n"
+            "       mov     w9, #9                                          \n"
+            "1:     ld1     {v4.16b}, [%[rk]], #16                          \n"
+            "       aese    v0.16b, v4.16b                                  \n"
+            "       aesmc   v0.16b, v0.16b                                  \n"
+            "       aese    v1.16b, v4.16b                                  \n"
+            "       aesmc   v1.16b, v1.16b                                  \n"
+            "       aese    v2.16b, v4.16b                                  \n"
+            "       aesmc   v2.16b, v2.16b                                  \n"
+            "       aese    v3.16b, v4.16b                                  \n"
+            "       aesmc   v3.16b, v3.16b                                  \n"
+            "       subs    w9, w9, #1                                      \n"
+            "       b.ne    1b                                              \n"
+            "       ld1     {v4.16b, v5.16b}, [%[rk]]                       \n"
+            "       aese    v0.16b, v4.16b                                  \n"
+            "       aese    v1.16b, v4.16b                                  \n"
+            "       aese    v2.16b, v4.16b                                  \n"
+            "       aese    v3.16b, v4.16b                                  \n"
+            "       eor     v0.16b, v0.16b, v5.16b                          \n"
+            "       eor     v1.16b, v1.16b, v5.16b                          \n"
+            "       eor     v2.16b, v2.16b, v5.16b                          \n"
+            "       eor     v3.16b, v3.16b, v5.16b                          \n"
+            "       st1     {v0.16b, v1.16b, v2.16b, v3.16b}, [%[out]]      \n"
+            : [rk]"+r"(rk) : [in]"r"(input), [out]"r"(output) : "x9", "v0", "v1", "v2", "v3", "v4", "v5", "cc", "memory");
     }
+    for(; blocks; blocks--, input += BLOCK_SIZE, output += BLOCK_SIZE)
+        cipher(output, input);
 }
 
-// This function adds the round key to _state.
-// The round key is added to the _state by an XOR function.
-void SWAES<16>::add_round_key(int round)
+// inv_cipher decrypts one block with the round keys from last to first
+void SWAES<16>::inv_cipher(unsigned char * output, const unsigned char * input)
 {
-    int i,j;
-    for(i=0;i<4;++i) {
-        for(j = 0; j < 4; ++j) {
-            (*_state)[i][j] ^= _round_key[round * Nb * 4 + i * Nb + j];
-        }
-    }
+    const unsigned int * rk = &_dk[Nb * Nr];
+    ASM("       ld1     {v0.16b}, [%[in]]               \n"
+        "       mov     w9, #9                          \n"
+        "1:     ld1     {v1.16b}, [%[rk]]               \n"
+        "       sub     %[rk], %[rk], #16               \n"
+        "       aesd    v0.16b, v1.16b                  \n"
+        "       aesimc  v0.16b, v0.16b                  \n"
+        "       subs    w9, w9, #1                      \n"
+        "       b.ne    1b                              \n"
+        "       ld1     {v1.16b}, [%[rk]]               \n"
+        "       sub     %[rk], %[rk], #16               \n"
+        "       ld1     {v2.16b}, [%[rk]]               \n"
+        "       aesd    v0.16b, v1.16b                  \n"
+        "       eor     v0.16b, v0.16b, v2.16b          \n"
+        "       st1     {v0.16b}, [%[out]]              \n"
+        : [rk]"+r"(rk) : [in]"r"(input), [out]"r"(output) : "x9", "v0", "v1", "v2", "cc", "memory");
 }
 
-// The sub_bytes Function Substitutes the values in the
-// _state matrix with values in an S-box.
-void SWAES<16>::sub_bytes(void)
+#else
+
+// One inner round of the cipher: each column of the next state comes from a diagonal of the current one (ShiftRows)
+static inline void encipher_round(const unsigned int * te, unsigned int t[4], const unsigned int s[4], const unsigned int * rk)
 {
-    int i, j;
-    for(i = 0; i < 4; ++i) {
-        for(j = 0; j < 4; ++j) {
-            (*_state)[j][i] = sbox[static_cast<int>((*_state)[j][i])];
-        }
-    }
+    t[0] = te[s[0] >> 24] ^ ror(te[(s[1] >> 16) & 0xff], 8) ^ ror(te[(s[2] >> 8) & 0xff], 16) ^ ror(te[s[3] & 0xff], 24) ^ rk[0];
+    t[1] = te[s[1] >> 24] ^ ror(te[(s[2] >> 16) & 0xff], 8) ^ ror(te[(s[3] >> 8) & 0xff], 16) ^ ror(te[s[0] & 0xff], 24) ^ rk[1];
+    t[2] = te[s[2] >> 24] ^ ror(te[(s[3] >> 16) & 0xff], 8) ^ ror(te[(s[0] >> 8) & 0xff], 16) ^ ror(te[s[1] & 0xff], 24) ^ rk[2];
+    t[3] = te[s[3] >> 24] ^ ror(te[(s[0] >> 16) & 0xff], 8) ^ ror(te[(s[1] >> 8) & 0xff], 16) ^ ror(te[s[2] & 0xff], 24) ^ rk[3];
 }
 
-// The shift_rows() function shifts the rows in the _state to the left.
-// Each row is shifted with different offset.
-// Offset = Row number. So the first row is not shifted.
-void SWAES<16>::shift_rows(void)
+// The last round has no MixColumns
+static inline void encipher_last(const unsigned char * sbox, unsigned char * output, const unsigned int s[4], const unsigned int * rk)
 {
-    unsigned char temp;
-
-    // Rotate first row 1 columns to left
-    temp            = (*_state)[0][1];
-    (*_state)[0][1] = (*_state)[1][1];
-    (*_state)[1][1] = (*_state)[2][1];
-    (*_state)[2][1] = (*_state)[3][1];
-    (*_state)[3][1] = temp;
-
-    // Rotate second row 2 columns to left
-    temp            = (*_state)[0][2];
-    (*_state)[0][2] = (*_state)[2][2];
-    (*_state)[2][2] = temp;
-
-    temp            = (*_state)[1][2];
-    (*_state)[1][2] = (*_state)[3][2];
-    (*_state)[3][2] = temp;
-
-    // Rotate third row 3 columns to left
-    temp            = (*_state)[0][3];
-    (*_state)[0][3] = (*_state)[3][3];
-    (*_state)[3][3] = (*_state)[2][3];
-    (*_state)[2][3] = (*_state)[1][3];
-    (*_state)[1][3] = temp;
+    store(&output[0], ((sbox[s[0] >> 24] << 24) | (sbox[(s[1] >> 16) & 0xff] << 16) | (sbox[(s[2] >> 8) & 0xff] << 8) | sbox[s[3] & 0xff]) ^ rk[0]);
+    store(&output[4], ((sbox[s[1] >> 24] << 24) | (sbox[(s[2] >> 16) & 0xff] << 16) | (sbox[(s[3] >> 8) & 0xff] << 8) | sbox[s[0] & 0xff]) ^ rk[1]);
+    store(&output[8], ((sbox[s[2] >> 24] << 24) | (sbox[(s[3] >> 16) & 0xff] << 16) | (sbox[(s[0] >> 8) & 0xff] << 8) | sbox[s[1] & 0xff]) ^ rk[2]);
+    store(&output[12], ((sbox[s[3] >> 24] << 24) | (sbox[(s[0] >> 16) & 0xff] << 16) | (sbox[(s[1] >> 8) & 0xff] << 8) | sbox[s[2] & 0xff]) ^ rk[3]);
 }
 
-// mix_columns function mixes the columns of the _state matrix
-void SWAES<16>::mix_columns(void)
+// N blocks through the given round keys, round by round, so the lookups of each block are independent of the others'
+template<unsigned int N>
+static inline void encipher(const unsigned int * te, const unsigned char * sbox, const unsigned int * rk, int rounds,
+                            unsigned char * output, const unsigned char * input)
 {
-    int i;
-    unsigned char Tmp,Tm,t;
-    for(i = 0; i < 4; ++i) {
-        t   = (*_state)[i][0];
-        Tmp = (*_state)[i][0] ^ (*_state)[i][1] ^ (*_state)[i][2] ^ (*_state)[i][3] ;
-        Tm  = (*_state)[i][0] ^ (*_state)[i][1] ; Tm = xtime(Tm);  (*_state)[i][0] ^= Tm ^ Tmp ;
-        Tm  = (*_state)[i][1] ^ (*_state)[i][2] ; Tm = xtime(Tm);  (*_state)[i][1] ^= Tm ^ Tmp ;
-        Tm  = (*_state)[i][2] ^ (*_state)[i][3] ; Tm = xtime(Tm);  (*_state)[i][2] ^= Tm ^ Tmp ;
-        Tm  = (*_state)[i][3] ^ t ;        Tm = xtime(Tm);  (*_state)[i][3] ^= Tm ^ Tmp ;
+    unsigned int s[N][4], t[N][4];
+    for(unsigned int b = 0; b < N; b++)
+        for(unsigned int i = 0; i < 4; i++)
+            s[b][i] = load(&input[b * 16 + i * 4]) ^ rk[i];
+
+    for(int round = 1; round < rounds; round++) {
+        rk += 4;
+        for(unsigned int b = 0; b < N; b++)
+            encipher_round(te, t[b], s[b], rk);
+        for(unsigned int b = 0; b < N; b++)
+            for(unsigned int i = 0; i < 4; i++)
+                s[b][i] = t[b][i];
     }
+
+    rk += 4;
+    for(unsigned int b = 0; b < N; b++)
+        encipher_last(sbox, &output[b * 16], s[b], rk);
 }
 
-// mix_columns function mixes the columns of the _state matrix.
-// The method used to multiply may be difficult to understand for the inexperienced.
-// Please use the references to gain more information.
-void SWAES<16>::inv_mix_columns(void)
+// cipher encrypts one block, which can be done in place
+void SWAES<16>::cipher(unsigned char * output, const unsigned char * input)
 {
-    int i;
-    unsigned char a,b,c,d;
-    for(i = 0; i < 4; ++i) {
-        a = (*_state)[i][0];
-        b = (*_state)[i][1];
-        c = (*_state)[i][2];
-        d = (*_state)[i][3];
-
-        (*_state)[i][0] = multiply(a, 0x0e) ^ multiply(b, 0x0b) ^ multiply(c, 0x0d) ^ multiply(d, 0x09);
-        (*_state)[i][1] = multiply(a, 0x09) ^ multiply(b, 0x0e) ^ multiply(c, 0x0b) ^ multiply(d, 0x0d);
-        (*_state)[i][2] = multiply(a, 0x0d) ^ multiply(b, 0x09) ^ multiply(c, 0x0e) ^ multiply(d, 0x0b);
-        (*_state)[i][3] = multiply(a, 0x0b) ^ multiply(b, 0x0d) ^ multiply(c, 0x09) ^ multiply(d, 0x0e);
-    }
+    encipher<1>(_te, sbox, _ek, Nr, output, input);
 }
 
-
-// The sub_bytes Function Substitutes the values in the
-// _state matrix with values in an S-box.
-void SWAES<16>::inv_sub_bytes(void)
+// The blocks can be encrypted in place too
+void SWAES<16>::cipher(unsigned char * output, const unsigned char * input, unsigned int blocks)
 {
-    int i,j;
-    for(i=0;i<4;++i) {
-        for(j=0;j<4;++j) {
-            (*_state)[j][i] = rsbox[static_cast<int>((*_state)[j][i])];
-        }
-    }
+    for(; blocks >= PARALLEL; blocks -= PARALLEL, input += PARALLEL * BLOCK_SIZE, output += PARALLEL * BLOCK_SIZE)
+        encipher<PARALLEL>(_te, sbox, _ek, Nr, output, input);
+    for(; blocks; blocks--, input += BLOCK_SIZE, output += BLOCK_SIZE)
+        encipher<1>(_te, sbox, _ek, Nr, output, input);
 }
 
-void SWAES<16>::inv_shift_rows(void)
+// inv_cipher decrypts one block with the round keys from last to first
+void SWAES<16>::inv_cipher(unsigned char * output, const unsigned char * input)
 {
-    unsigned char temp;
-
-    // Rotate first row 1 columns to right
-    temp            = (*_state)[3][1];
-    (*_state)[3][1] = (*_state)[2][1];
-    (*_state)[2][1] = (*_state)[1][1];
-    (*_state)[1][1] = (*_state)[0][1];
-    (*_state)[0][1] = temp;
-
-    // Rotate second row 2 columns to right
-    temp            = (*_state)[0][2];
-    (*_state)[0][2] = (*_state)[2][2];
-    (*_state)[2][2] = temp;
-
-    temp            = (*_state)[1][2];
-    (*_state)[1][2] = (*_state)[3][2];
-    (*_state)[3][2] = temp;
-
-    // Rotate third row 3 columns to right
-    temp            = (*_state)[0][3];
-    (*_state)[0][3] = (*_state)[1][3];
-    (*_state)[1][3] = (*_state)[2][3];
-    (*_state)[2][3] = (*_state)[3][3];
-    (*_state)[3][3] = temp;
+    const unsigned int * rk = &_dk[Nb * Nr];
+    unsigned int s0 = load(&input[0]) ^ rk[0];
+    unsigned int s1 = load(&input[4]) ^ rk[1];
+    unsigned int s2 = load(&input[8]) ^ rk[2];
+    unsigned int s3 = load(&input[12]) ^ rk[3];
+
+    // InvShiftRows takes the diagonals the other way around
+    for(int round = Nr - 1; round > 0; round--) {
+        rk -= Nb;
+        unsigned int t0 = _td[s0 >> 24] ^ ror(_td[(s3 >> 16) & 0xff], 8) ^ ror(_td[(s2 >> 8) & 0xff], 16) ^ ror(_td[s1 & 0xff], 24) ^ rk[0];
+        unsigned int t1 = _td[s1 >> 24] ^ ror(_td[(s0 >> 16) & 0xff], 8) ^ ror(_td[(s3 >> 8) & 0xff], 16) ^ ror(_td[s2 & 0xff], 24) ^ rk[1];
+        unsigned int t2 = _td[s2 >> 24] ^ ror(_td[(s1 >> 16) & 0xff], 8) ^ ror(_td[(s0 >> 8) & 0xff], 16) ^ ror(_td[s3 & 0xff], 24) ^ rk[2];
+        unsigned int t3 = _td[s3 >> 24] ^ ror(_td[(s2 >> 16) & 0xff], 8) ^ ror(_td[(s1 >> 8) & 0xff], 16) ^ ror(_td[s0 & 0xff], 24) ^ rk[3];
+        s0 = t0; s1 = t1; s2 = t2; s3 = t3;
+    }
+
+    rk -= Nb;
+    store(&output[0], ((rsbox[s0 >> 24] << 24) | (rsbox[(s3 >> 16) & 0xff] << 16) | (rsbox[(s2 >> 8) & 0xff] << 8) | rsbox[s1 & 0xff]) ^ rk[0]);
+    store(&output[4], ((rsbox[s1 >> 24] << 24) | (rsbox[(s0 >> 16) & 0xff] << 16) | (rsbox[(s3 >> 8) & 0xff] << 8) | rsbox[s2 & 0xff]) ^ rk[1]);
+    store(&output[8], ((rsbox[s2 >> 24] << 24) | (rsbox[(s1 >> 16) & 0xff] << 16) | (rsbox[(s0 >> 8) & 0xff] << 8) | rsbox[s3 & 0xff]) ^ rk[2]);
+    store(&output[12], ((rsbox[s3 >> 24] << 24) | (rsbox[(s2 >> 16) & 0xff] << 16) | (rsbox[(s1 >> 8) & 0xff] << 8) | rsbox[s0 & 0xff]) ^ rk[3]);
 }
 
+#endif
 
-// cipher is the main function that encrypts the PlainText.
-void SWAES<16>::cipher(void)
+void SWAES<16>::encrypt_buffer(unsigned char * output, const unsigned char * input, unsigned int length)
 {
-    unsigned char round = 0;
-
-    // Add the First round key to the _state before starting the rounds.
-    add_round_key(0);
-
-    // There will be Nr rounds.
-    // The first Nr-1 rounds are identical.
-    // These Nr-1 rounds are executed in the loop below.
-    for(round = 1; round < Nr; ++round) {
-        sub_bytes();
-        shift_rows();
-        mix_columns();
-        add_round_key(round);
+    if(_mode == CTR) {
+        unsigned char counter[BLOCK_SIZE];
+        memcpy(counter, _iv, BLOCK_SIZE);
+        ctr(output, input, length, counter, BLOCK_SIZE);
+        return;
+    }
+
+    // Whole ECB blocks are independent of each other; only the padded one is copied
+    unsigned int i = 0;
+    if(_mode == ECB) {
+        i = length - length % BLOCK_SIZE;
+        cipher(output, input, i / BLOCK_SIZE);
     }
 
-    // The last round is given below.
-    // The mix_columns function is not here in the last round.
-    sub_bytes();
-    shift_rows();
-    add_round_key(Nr);
+    const unsigned char * chain = _iv;
+    for(; i < length; i += BLOCK_SIZE) {
+        unsigned char block[BLOCK_SIZE];
+        unsigned int n = (length - i < BLOCK_SIZE) ? length - i : BLOCK_SIZE;
+        memcpy(block, input + i, n);
+        memset(block + n, 0, BLOCK_SIZE - n); // add 0-padding
+        if(_mode == CBC)
+            for(unsigned int j = 0; j < BLOCK_SIZE; j++)
+                block[j] ^= chain[j];
+        cipher(output + i, block);
+        chain = output + i;
+    }
 }
 
-void SWAES<16>::inv_cipher(void)
+void SWAES<16>::decrypt_buffer(unsigned char * output, const unsigned char * input, unsigned int length)
 {
-    unsigned char round=0;
-
-    // Add the First round key to the _state before starting the rounds.
-    add_round_key(Nr);
-
-    // There will be Nr rounds.
-    // The first Nr-1 rounds are identical.
-    // These Nr-1 rounds are executed in the loop below.
-    for(round = Nr - 1; round > 0; round--) {
-        inv_shift_rows();
-        inv_sub_bytes();
-        add_round_key(round);
-        inv_mix_columns();
+    unsigned char chain[BLOCK_SIZE];
+    memcpy(chain, _iv, BLOCK_SIZE);
+    for(unsigned int i = 0; i < length; i += BLOCK_SIZE) {
+        unsigned char block[BLOCK_SIZE]; // a copy, since output can be input
+        unsigned int n = (length - i < BLOCK_SIZE) ? length - i : BLOCK_SIZE;
+        memcpy(block, input + i, n);
+        memset(block + n, 0, BLOCK_SIZE - n);
+        inv_cipher(output + i, block);
+        if(_mode == CBC) {
+            for(unsigned int j = 0; j < BLOCK_SIZE; j++)
+                output[i + j] ^= chain[j];
+            memcpy(chain, block, BLOCK_SIZE);
+        }
     }
+}
 
-    // The last round is given below.
-    // The mix_columns function is not here in the last round.
-    inv_shift_rows();
-    inv_sub_bytes();
-    add_round_key(0);
+void SWAES<16>::ctr(unsigned char * output, const unsigned char * input, unsigned int length,
+                    unsigned char counter[BLOCK_SIZE], unsigned int width)
+{
+    unsigned char stream[PARALLEL * BLOCK_SIZE];
+    while(length) {
+        unsigned int n = (length < sizeof(stream)) ? length : sizeof(stream);
+        unsigned int blocks = (n + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        for(unsigned int b = 0; b < blocks; b++) {
+            memcpy(&stream[b * BLOCK_SIZE], counter, BLOCK_SIZE);
+            increment(counter, width);
+        }
+        cipher(stream, stream, blocks);
+
+        for(unsigned int i = 0; i < n; i++)
+            output[i] = input[i] ^ stream[i];
+        input += n;
+        output += n;
+        length -= n;
+    }
 }
 
 __END_UTIL
@@ -0,0 +1,22 @@
+// EPOS Arena Allocator Utility Implementation
+
+#include <utility/arena.h>
+#include <system.h>
+
+__BEGIN_UTIL
+
+// Methods
+Arena::Arena(unsigned long bytes): _base(new (SYSTEM) char[bytes]), _top(_base), _end(_base ? _base + bytes : 0), _owned(true)
+{
+    db<Heaps>(TRC) << "Arena(bytes=" << bytes << ") => " << this << endl;
+}
+
+Arena::~Arena()
+{
+    db<Heaps>(TRC) << "~Arena(this=" << this << ")" << endl;
+
+    if(_owned)
+        delete [] _base;
+}
+
+__END_UTIL
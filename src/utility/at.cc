@@ -0,0 +1,164 @@
+// EPOS AT Command Engine Utility Implementation
+
+#include <utility/at.h>
+
+__BEGIN_UTIL
+
+// Methods
+void AT_Engine::submit(Command * c)
+{
+    db<AT_Engine>(TRC) << "AT_Engine::submit(c=" << c->_command << ")" << endl;
+
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+
+    c->_status = QUEUED;
+    if(_current)
+        _queue.insert(&c->_link);
+    else
+        start(c);
+
+    if(!disabled)
+        CPU::int_enable();
+}
+
+unsigned int AT_Engine::transmit(char * data, unsigned int max)
+{
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+
+    unsigned int n = 0;
+    for(; (n < max) && _tx_left; n++, _tx_left--)
+        data[n] = *_tx++;
+    if((n < max) && _cr) {
+        data[n++] = '\r';
+        _cr = false;
+    }
+
+    if(!disabled)
+        CPU::int_enable();
+
+    return n;
+}
+
+void AT_Engine::received(const char * data, unsigned int size)
+{
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+
+    for(unsigned int i = 0; i < size; i++) {
+        char c = data[i];
+        if((c == '\r') || (c == '\n')) {
+            if(_length) {
+                _line[_length] = 0;
+                parse();
+                _length = 0;
+            }
+        } else if(!_length && (c == '>') && _current && _current->_payload) {
+            // The prompt ("> ") has no line end, so it is taken as it comes
+            send(_current->_payload, _current->_payload_size, false);
+            _current->_payload = 0;
+        } else if(_length || (c != ' ')) {
+            if(_length < LINE - 1)
+                _line[_length++] = c;
+        }
+    }
+
+    if(!disabled)
+        CPU::int_enable();
+}
+
+void AT_Engine::timeout()
+{
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+
+    if(_current && _current->_deadline && (TSC::time_stamp() > _current->_deadline)) {
+        db<AT_Engine>(WRN) << "AT_Engine::timeout(c=" << _current->_command << ")" << endl;
+        _timeouts++;
+        finish(TIMEOUT);
+    }
+
+    if(!disabled)
+        CPU::int_enable();
+}
+
+// The methods below are called with interrupts disabled
+void AT_Engine::start(Command * c)
+{
+    _current = c;
+    _commands++;
+    c->_status = RUNNING;
+    c->_response_length = 0;
+    if(c->_response_size)
+        c->_response[0] = 0;
+    c->_deadline = c->_timeout ? TSC::time_stamp() + TSC::Time_Stamp(c->_timeout) * TSC::frequency() / 1000000 : 0;
+
+    send(c->_command, strlen(c->_command), true);
+}
+
+// The next command is started before the handler of this one is called, so it goes out as soon as possible
+void AT_Engine::finish(const Status & status)
+{
+    Command * c = _current;
+
+    db<AT_Engine>(TRC) << "AT_Engine::finish(c=" << c->_command << ",s=" << status << ")" << endl;
+
+    _current = 0;
+    _tx_left = 0;
+    _cr = false;
+    c->_status = status;
+
+    if(!_queue.empty())
+        start(_queue.remove()->object());
+
+    if(c->_handler)
+        (*c->_handler)();
+}
+
+void AT_Engine::parse()
+{
+    Command * c = _current;
+
+    if(prefix(_line, "AT") && c)
+        return; // echo
+
+    bool error = c && (!strcmp(_line, "ERROR") || prefix(_line, "+CME ERROR") || prefix(_line, "+CMS ERROR"));
+
+    if(c && (error || c->_response_size) && strcmp(_line, c->_final)) {
+        for(unsigned int i = 0; _line[i] && (c->_response_length + 1 < c->_response_size); i++)
+            c->_response[c->_response_length++] = _line[i];
+        if(c->_response_length + 1 < c->_response_size)
+            c->_response[c->_response_length++] = '\n';
+        if(c->_response_size)
+            c->_response[c->_response_length] = 0;
+    }
+
+    if(c && !strcmp(_line, c->_final))
+        finish(OK);
+    else if(error)
+        finish(ERROR);
+    else if(!c || !c->_response_size) {
+        db<AT_Engine>(INF) << "AT_Engine::unsolicited(" << _line << ")" << endl;
+        if(_unsolicited)
+            (*_unsolicited)();
+    }
+}
+
+void AT_Engine::send(const char * data, unsigned int size, bool cr)
+{
+    bool idle = !_tx_left && !_cr;
+
+    _tx = data;
+    _tx_left = size;
+    _cr = cr;
+
+    if(idle && _kick)
+        (*_kick)();
+}
+
+__END_UTIL
@@ -18,6 +18,15 @@ const Bignum<16>::_Barrett Bignum<16>::_barrett_u = {{ 17, 0, 0, 0,
                                                         2, 0, 0, 0,
                                                         1, 0, 0, 0}};
 
+template<>
+const Bignum<16>::_Word Bignum<16>::_montgomery_r2 = {{ 0x11, 0x00, 0x00, 0x00,
+                                                        0x08, 0x00, 0x00, 0x00,
+                                                        0x04, 0x00, 0x00, 0x00,
+                                                        0x24, 0x00, 0x00, 0x00 }};
+
+template<>
+const Bignum<16>::Digit Bignum<16>::_montgomery_n0 = 0x00000001;
+
 
 // 2^(130) - 5: used by Poly1305
 template<>
@@ -35,4 +44,14 @@ const Bignum<17>::_Barrett Bignum<17>::_barrett_u = {{ 0x00, 0x00, 0x00, 0x00,
                                                        0x00, 0x00, 0x00, 0x00,
                                                        0x00, 0x00, 0x00, 0x00,
                                                        0x00, 0x00, 0x00, 0x40 }};
+
+template<>
+const Bignum<17>::_Word Bignum<17>::_montgomery_r2 = {{ 0x00, 0x00, 0x00, 0x00,
+                                                        0x00, 0x00, 0x00, 0x90,
+                                                        0x01, 0x00, 0x00, 0x00,
+                                                        0x00, 0x00, 0x00, 0x00,
+                                                        0x00, 0x00, 0x00, 0x00 }};
+
+template<>
+const Bignum<17>::Digit Bignum<17>::_montgomery_n0 = 0xcccccccd;
 __END_UTIL
@@ -0,0 +1,125 @@
+// EPOS Function Call Tracer Utility Implementation
+
+#include <utility/call_tracer.h>
+#include <utility/ostream.h>
+
+// Hooks called by the functions of instrumented components
+extern "C" {
+    __attribute__((no_instrument_function)) void __cyg_profile_func_enter(void * function, void * call_site) {
+        _UTIL::Call_Tracer::record(function, true);
+    }
+
+    __attribute__((no_instrument_function)) void __cyg_profile_func_exit(void * function, void * call_site) {
+        _UTIL::Call_Tracer::record(function, false);
+    }
+}
+
+__BEGIN_UTIL
+
+// Class attributes
+Per_CPU<unsigned int> Call_Tracer::_head;
+Call_Tracer::Record Call_Tracer::_ring[Traits<Build>::CPUS][Call_Tracer::RECORDS];
+Call_Tracer::Function Call_Tracer::_functions[Call_Tracer::FUNCTIONS];
+
+// Class methods
+void Call_Tracer::dump()
+{
+    if(!enabled)
+        return;
+
+    struct Frame {
+        const void * function;
+        Time_Stamp entry;
+        Time_Stamp children;
+    };
+
+    static Frame stack[DEPTH];
+
+    OStream cout;
+
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+
+    for(unsigned int cpu = 0; cpu < CPU::cores(); cpu++) {
+        for(unsigned int i = 0; i < FUNCTIONS; i++)
+            _functions[i].calls = 0;
+
+        unsigned int head = _head[cpu];
+        unsigned int first = (head > RECORDS) ? head - RECORDS : 0;
+        unsigned int depth = 0;
+        unsigned int dropped = 0;
+
+        for(unsigned int i = first; i < head; i++) {
+            const Record & r = _ring[cpu][i % RECORDS];
+
+            if(r.entry) {
+                if(depth < DEPTH) {
+                    stack[depth].function = r.function;
+                    stack[depth].entry = r.ts;
+                    stack[depth].children = 0;
+                    depth++;
+                } else
+                    dropped++;
+                continue;
+            }
+
+            // Frames above the one exited never exited themselves (e.g. their thread was switched out)
+            unsigned int d = depth;
+            while(d && (stack[d - 1].function != r.function))
+                d--;
+            if(!d)
+                continue;
+            depth = d - 1;
+
+            const Frame & f = stack[depth];
+            Time_Stamp inclusive = r.ts - f.entry;
+            if(depth)
+                stack[depth - 1].children += inclusive;
+
+            Function * fn = function(r.function);
+            if(!fn) {
+                dropped++;
+                continue;
+            }
+            fn->calls++;
+            fn->inclusive += inclusive;
+            fn->exclusive += (inclusive > f.children) ? inclusive - f.children : 0;
+        }
+
+        cout << "Calls[" << cpu << "]: " << head - first << " records, " << dropped << " dropped" << endl;
+        for(unsigned int i = 0; i < FUNCTIONS; i++) {
+            const Function & f = _functions[i];
+            if(f.calls)
+                cout << "@call " << cpu << " " << f.function << " " << f.calls << " " << f.inclusive << " " << f.exclusive
+                     << endl;
+        }
+    }
+
+    if(!disabled)
+        CPU::int_enable();
+}
+
+void Call_Tracer::reset()
+{
+    for(unsigned int cpu = 0; cpu < Traits<Build>::CPUS; cpu++)
+        _head[cpu] = 0;
+}
+
+Call_Tracer::Function * Call_Tracer::function(const void * f)
+{
+    unsigned long h = reinterpret_cast<unsigned long>(f) >> 2;
+    for(unsigned int i = 0; i < PROBES; i++, h++) {
+        Function & fn = _functions[h % FUNCTIONS];
+        if(!fn.calls) {
+            fn.function = f;
+            fn.inclusive = 0;
+            fn.exclusive = 0;
+        }
+        if(fn.function == f)
+            return &fn;
+    }
+    return 0;
+}
+
+__END_UTIL
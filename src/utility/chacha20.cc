@@ -0,0 +1,201 @@
+// EPOS ChaCha20 and ChaCha20-Poly1305 Utility Implementation
+
+#include <utility/chacha20.h>
+
+__BEGIN_UTIL
+
+// Words are little-endian in keys, nonces and the keystream
+static inline unsigned int load(const unsigned char * p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24); }
+static inline void store(unsigned char * p, unsigned int w) { p[0] = w; p[1] = w >> 8; p[2] = w >> 16; p[3] = w >> 24; }
+
+static inline void store64(unsigned char * p, unsigned long long w) {
+    store(p, w);
+    store(p + 4, w >> 32);
+}
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+
+typedef unsigned int Row __attribute__((vector_size(16)));
+
+static inline Row rotl(const Row & v, unsigned int n) { return (v << n) | (v >> (32 - n)); }
+
+// Quarter rounds on the four columns at once
+static inline void quarter_rounds(Row & a, Row & b, Row & c, Row & d)
+{
+    a += b; d ^= a; d = rotl(d, 16);
+    c += d; b ^= c; b = rotl(b, 12);
+    a += b; d ^= a; d = rotl(d, 8);
+    c += d; b ^= c; b = rotl(b, 7);
+}
+
+// x = state + 10 double rounds of it; diagonals are brought into columns by rotating rows b, c and d by 1, 2 and 3 lanes
+void ChaCha20::keystream(unsigned int x[16])
+{
+    const Row * s = reinterpret_cast<const Row *>(_state);
+    Row a = s[0], b = s[1], c = s[2], d = s[3];
+
+    for(unsigned int i = 0; i < 10; i++) {
+        quarter_rounds(a, b, c, d);
+        b = __builtin_shuffle(b, Row{1, 2, 3, 0});
+        c = __builtin_shuffle(c, Row{2, 3, 0, 1});
+        d = __builtin_shuffle(d, Row{3, 0, 1, 2});
+        quarter_rounds(a, b, c, d);
+        b = __builtin_shuffle(b, Row{3, 0, 1, 2});
+        c = __builtin_shuffle(c, Row{2, 3, 0, 1});
+        d = __builtin_shuffle(d, Row{1, 2, 3, 0});
+    }
+
+    Row * r = reinterpret_cast<Row *>(x);
+    r[0] = a + s[0];
+    r[1] = b + s[1];
+    r[2] = c + s[2];
+    r[3] = d + s[3];
+}
+
+#else
+
+static inline unsigned int rotl(unsigned int w, unsigned int n) { return (w << n) | (w >> (32 - n)); }
+
+static inline void quarter_round(unsigned int x[16], unsigned int a, unsigned int b, unsigned int c, unsigned int d)
+{
+    x[a] += x[b]; x[d] ^= x[a]; x[d] = rotl(x[d], 16);
+    x[c] += x[d]; x[b] ^= x[c]; x[b] = rotl(x[b], 12);
+    x[a] += x[b]; x[d] ^= x[a]; x[d] = rotl(x[d], 8);
+    x[c] += x[d]; x[b] ^= x[c]; x[b] = rotl(x[b], 7);
+}
+
+// x = state + 10 double rounds (columns, then diagonals) of it
+void ChaCha20::keystream(unsigned int x[16])
+{
+    for(unsigned int i = 0; i < 16; i++)
+        x[i] = _state[i];
+
+    for(unsigned int i = 0; i < 10; i++) {
+        quarter_round(x, 0, 4, 8, 12);
+        quarter_round(x, 1, 5, 9, 13);
+        quarter_round(x, 2, 6, 10, 14);
+        quarter_round(x, 3, 7, 11, 15);
+        quarter_round(x, 0, 5, 10, 15);
+        quarter_round(x, 1, 6, 11, 12);
+        quarter_round(x, 2, 7, 8, 13);
+        quarter_round(x, 3, 4, 9, 14);
+    }
+
+    for(unsigned int i = 0; i < 16; i++)
+        x[i] += _state[i];
+}
+
+#endif
+
+// Class methods
+void ChaCha20::reset(const unsigned char key[KEY_SIZE], const unsigned char nonce[NONCE_SIZE], unsigned int counter)
+{
+    // "expand 32-byte k"
+    _state[0] = 0x61707865;
+    _state[1] = 0x3320646e;
+    _state[2] = 0x79622d32;
+    _state[3] = 0x6b206574;
+    for(unsigned int i = 0; i < 8; i++)
+        _state[4 + i] = load(&key[i * 4]);
+    _state[12] = counter;
+    for(unsigned int i = 0; i < 3; i++)
+        _state[13 + i] = load(&nonce[i * 4]);
+}
+
+void ChaCha20::block(unsigned char out[BLOCK_SIZE])
+{
+    unsigned int x[16] __attribute__((aligned(16)));
+    keystream(x);
+    _state[12]++;
+
+    for(unsigned int i = 0; i < 16; i++)
+        store(&out[i * 4], x[i]);
+}
+
+void ChaCha20::crypt(unsigned char * out, const unsigned char * in, unsigned int length)
+{
+    db<Ciphers>(TRC) << "ChaCha20::crypt(out=" << out << ",in=" << in << ",length=" << length << ",counter="
+                     << _state[12] << ")" << endl;
+
+    unsigned int x[16] __attribute__((aligned(16)));
+
+    for(; length >= BLOCK_SIZE; length -= BLOCK_SIZE, in += BLOCK_SIZE, out += BLOCK_SIZE) {
+        keystream(x);
+        _state[12]++;
+        for(unsigned int i = 0; i < 16; i++)
+            store(&out[i * 4], load(&in[i * 4]) ^ x[i]);
+    }
+
+    if(length) {
+        unsigned char last[BLOCK_SIZE];
+        block(last);
+        for(unsigned int i = 0; i < length; i++)
+            out[i] = in[i] ^ last[i];
+    }
+}
+
+
+void ChaCha20_Poly1305::encrypt(unsigned char * out, unsigned char tag[TAG_SIZE], const unsigned char nonce[NONCE_SIZE],
+                                const unsigned char * in, unsigned int length, const unsigned char * aad,
+                                unsigned int aad_length)
+{
+    crypt(out, tag, nonce, in, length, aad, aad_length, true);
+}
+
+bool ChaCha20_Poly1305::decrypt(unsigned char * out, const unsigned char tag[TAG_SIZE],
+                                const unsigned char nonce[NONCE_SIZE], const unsigned char * in, unsigned int length,
+                                const unsigned char * aad, unsigned int aad_length)
+{
+    unsigned char mine[TAG_SIZE];
+    crypt(out, mine, nonce, in, length, aad, aad_length, false);
+
+    // Every byte is compared, so the time taken tells nothing about where they first differ
+    unsigned char diff = 0;
+    for(unsigned int i = 0; i < TAG_SIZE; i++)
+        diff |= mine[i] ^ tag[i];
+
+    if(diff) {
+        db<Ciphers>(WRN) << "ChaCha20_Poly1305::decrypt: tag mismatch!" << endl;
+        memset(out, 0, length);
+    }
+
+    return !diff;
+}
+
+void ChaCha20_Poly1305::crypt(unsigned char * out, unsigned char tag[TAG_SIZE], const unsigned char nonce[NONCE_SIZE],
+                              const unsigned char * in, unsigned int length, const unsigned char * aad,
+                              unsigned int aad_length, bool encrypt)
+{
+    ChaCha20 cipher(_key, nonce, 0);
+
+    // The one-time key (r, s) is the first 32 bytes of block 0; the message starts at block 1
+    unsigned char otk[BLOCK_SIZE];
+    cipher.block(otk);
+    Poly1305<ChaCha20> mac(&otk[16], &otk[0]);
+    memset(otk, 0, sizeof(otk));
+
+    mac.begin();
+    if(aad_length) {
+        mac.update(aad, aad_length);
+        mac.pad();
+    }
+
+    // Decryption might be in place, so the ciphertext is authenticated before it is overwritten
+    for(unsigned int done = 0; done < length; done += BLOCK_SIZE) {
+        unsigned int n = ((length - done) < BLOCK_SIZE) ? length - done : BLOCK_SIZE;
+        if(!encrypt)
+            mac.update(&in[done], n);
+        cipher.crypt(&out[done], &in[done], n);
+        if(encrypt)
+            mac.update(&out[done], n);
+    }
+    mac.pad();
+
+    unsigned char lengths[16];
+    store64(&lengths[0], aad_length);
+    store64(&lengths[8], length);
+    mac.update(lengths, sizeof(lengths));
+    mac.finish(tag);
+}
+
+__END_UTIL
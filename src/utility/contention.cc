@@ -0,0 +1,131 @@
+// EPOS Lock Contention Profiler Utility Implementation
+
+#include <utility/contention.h>
+#include <utility/ostream.h>
+
+__BEGIN_UTIL
+
+// Class attributes
+Contention::Hot_Spot Contention::_hot_spots[Contention::HOT_SPOTS];
+volatile bool Contention::_lock;
+
+// Class methods
+void Contention::dump()
+{
+    if(!enabled)
+        return;
+
+    struct {
+        const void * lock;
+        const void * caller;
+        unsigned int acquisitions;
+        unsigned int contentions;
+        Time_Stamp wait;
+        Time_Stamp max_wait;
+        unsigned int max_queue;
+    } spots[HOT_SPOTS];
+    unsigned int n = 0;
+
+    // Take a snapshot, so nothing is printed with the registry locked, nor after the locks are gone
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+    while(CPU::tsl(_lock));
+
+    for(unsigned int i = 0; i < HOT_SPOTS; i++) {
+        const Lock_Statistics<true> * s = _hot_spots[i].statistics;
+        if(!s)
+            continue;
+        spots[n].lock = _hot_spots[i].lock;
+        spots[n].caller = s->caller();
+        spots[n].acquisitions = s->acquisitions();
+        spots[n].contentions = s->contentions();
+        spots[n].wait = s->wait_time();
+        spots[n].max_wait = s->max_wait();
+        spots[n].max_queue = s->max_queue();
+        n++;
+    }
+
+    _lock = false;
+    if(!disabled)
+        CPU::int_enable();
+
+    // Selection sort, the hottest first
+    for(unsigned int i = 0; i < n; i++)
+        for(unsigned int j = i + 1; j < n; j++)
+            if(spots[j].contentions > spots[i].contentions) {
+                auto tmp = spots[i];
+                spots[i] = spots[j];
+                spots[j] = tmp;
+            }
+
+    OStream cout;
+    cout << "Contention: " << n << " hot spots" << endl;
+    for(unsigned int i = 0; i < n; i++)
+        cout << "! " << spots[i].lock << " " << spots[i].caller << " " << spots[i].acquisitions << " "
+             << spots[i].contentions << " " << spots[i].wait << " " << spots[i].max_wait << " "
+             << spots[i].max_queue << endl;
+}
+
+void Contention::reset()
+{
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+    while(CPU::tsl(_lock));
+
+    for(unsigned int i = 0; i < HOT_SPOTS; i++)
+        _hot_spots[i].statistics = 0;
+
+    _lock = false;
+    if(!disabled)
+        CPU::int_enable();
+}
+
+// Registers "statistics" (of "lock") unless it already is, in place of the least contended lock if there is no room
+void Contention::hot(const void * lock, const Lock_Statistics<true> * statistics)
+{
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+    while(CPU::tsl(_lock));
+
+    Hot_Spot * coldest = 0;
+    for(unsigned int i = 0; i < HOT_SPOTS; i++) {
+        Hot_Spot * s = &_hot_spots[i];
+        if(s->statistics == statistics) {
+            coldest = 0;
+            break;
+        }
+        if(!coldest || (coldest->statistics
+                        && (!s->statistics || (s->statistics->contentions() < coldest->statistics->contentions()))))
+            coldest = s;
+    }
+
+    if(coldest && (!coldest->statistics || (coldest->statistics->contentions() < statistics->contentions()))) {
+        coldest->lock = lock;
+        coldest->statistics = statistics;
+    }
+
+    _lock = false;
+    if(!disabled)
+        CPU::int_enable();
+}
+
+void Contention::forget(const Lock_Statistics<true> * statistics)
+{
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+    while(CPU::tsl(_lock));
+
+    for(unsigned int i = 0; i < HOT_SPOTS; i++)
+        if(_hot_spots[i].statistics == statistics)
+            _hot_spots[i].statistics = 0;
+
+    _lock = false;
+    if(!disabled)
+        CPU::int_enable();
+}
+
+__END_UTIL
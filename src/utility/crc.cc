@@ -0,0 +1,80 @@
+// EPOS CRC Utility Implementation
+
+#include <utility/crc.h>
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define __crc_hw__
+#endif
+
+__BEGIN_UTIL
+
+// Class attributes, computed by the compiler, so they end up in read-only data
+const CRC::Table<unsigned short, 0x1021, false> CRC::_crc16;
+const CRC::Table<unsigned int, 0xedb88320, true> CRC::_crc32;
+const CRC::Table<unsigned int, 0x82f63b78, true> CRC::_crc32c;
+
+// Class methods
+unsigned short CRC::crc16(const void * data, unsigned int size, unsigned short crc)
+{
+    const unsigned short (* t)[256] = _crc16.t;
+    const unsigned char * p = reinterpret_cast<const unsigned char *>(data);
+
+    // The CRC goes into the first two bytes, which are the most significant ones of the first step
+    for(; size >= SLICES; size -= SLICES, p += SLICES)
+        crc = t[7][p[0] ^ (crc >> 8)] ^ t[6][p[1] ^ (crc & 0xff)] ^ t[5][p[2]] ^ t[4][p[3]]
+            ^ t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+    for(; size; size--, p++)
+        crc = (crc << 8) ^ t[0][(crc >> 8) ^ *p];
+
+    return crc;
+}
+
+unsigned int CRC::crc32(const void * data, unsigned int size, unsigned int crc)
+{
+#ifdef __crc_hw__
+    const unsigned char * p = reinterpret_cast<const unsigned char *>(data);
+    crc = ~crc;
+    for(; size && (reinterpret_cast<unsigned long>(p) & 7); size--, p++)
+        ASM("crc32b %w0, %w0, %w1" : "+r"(crc) : "r"(*p));
+    for(; size >= 8; size -= 8, p += 8)
+        ASM("crc32x %w0, %w0, %x1" : "+r"(crc) : "r"(*reinterpret_cast<const unsigned long *>(p)));
+    for(; size; size--, p++)
+        ASM("crc32b %w0, %w0, %w1" : "+r"(crc) : "r"(*p));
+    return ~crc;
+#else
+    return ~reflected(_crc32.t, reinterpret_cast<const unsigned char *>(data), size, ~crc);
+#endif
+}
+
+unsigned int CRC::crc32c(const void * data, unsigned int size, unsigned int crc)
+{
+#ifdef __crc_hw__
+    const unsigned char * p = reinterpret_cast<const unsigned char *>(data);
+    crc = ~crc;
+    for(; size && (reinterpret_cast<unsigned long>(p) & 7); size--, p++)
+        ASM("crc32cb %w0, %w0, %w1" : "+r"(crc) : "r"(*p));
+    for(; size >= 8; size -= 8, p += 8)
+        ASM("crc32cx %w0, %w0, %x1" : "+r"(crc) : "r"(*reinterpret_cast<const unsigned long *>(p)));
+    for(; size; size--, p++)
+        ASM("crc32cb %w0, %w0, %w1" : "+r"(crc) : "r"(*p));
+    return ~crc;
+#else
+    return ~reflected(_crc32c.t, reinterpret_cast<const unsigned char *>(data), size, ~crc);
+#endif
+}
+
+// Slicing-by-8 for the reflected CRCs: the CRC goes into the first four bytes, which are the least significant ones
+unsigned int CRC::reflected(const unsigned int (* t)[256], const unsigned char * p, unsigned int size, unsigned int crc)
+{
+    for(; size >= SLICES; size -= SLICES, p += SLICES) {
+        unsigned int one = crc ^ (p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24));
+        crc = t[7][one & 0xff] ^ t[6][(one >> 8) & 0xff] ^ t[5][(one >> 16) & 0xff] ^ t[4][one >> 24]
+            ^ t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+    }
+    for(; size; size--, p++)
+        crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xff];
+
+    return crc;
+}
+
+__END_UTIL
@@ -2,22 +2,102 @@
 
 #include <architecture/cpu.h>
 #include <utility/elf.h>
+#include <utility/lz4.h>
 #include <utility/string.h>
 
 __BEGIN_UTIL
 
-int ELF::load_segment(int i, Elf32_Addr addr)
+int ELF::load_segment(int i, Elf_Addr addr, const Placement * map, unsigned int n)
 {
     if((i > segments()) || (segment_type(i) != PT_LOAD))
         return 0;
 
     char * src = reinterpret_cast<char *>(CPU::Reg(this) + seg(i)->p_offset);
     char * dst = reinterpret_cast<char *>((addr) ? addr : segment_address(i));
+    Elf_Addr vaddr = seg(i)->p_vaddr;
+    Elf_Addr filesz = seg(i)->p_filesz;
+    Elf_Addr memsz = seg(i)->p_memsz;
+    bool compressed = seg(i)->p_flags & PF_LZ4;
 
-    memcpy(dst, src, seg(i)->p_filesz);
-    memset(dst + seg(i)->p_filesz, 0, seg(i)->p_memsz - seg(i)->p_filesz);
+    // Relocations come with their addends (RELA, RISC-V and ARMv8) or with them in the words to relocate (REL)
+    Elf_Addr table = 0;
+    Elf_Addr size = 0;
+    Elf_Addr entry_size = sizeof(Elf_Rel);
+    bool rela = false;
+    if(n) {
+        if(dynamic(DT_RELA, &table)) {
+            rela = true;
+            entry_size = sizeof(Elf_Rela);
+            dynamic(DT_RELASZ, &size);
+            dynamic(DT_RELAENT, &entry_size);
+        } else if(dynamic(DT_REL, &table)) {
+            dynamic(DT_RELSZ, &size);
+            dynamic(DT_RELENT, &entry_size);
+        }
+    }
+    char * rel = size ? reinterpret_cast<char *>(image(table)) : 0;
+    if(size && !rel)
+        return -1;
 
-    return seg(i)->p_memsz;
+    memset(dst + filesz, 0, memsz - filesz);
+
+    // Compressed segments are decompressed right into their place and then relocated there
+    if(compressed && (LZ4::decompress(src, dst, filesz) < 0))
+        return -1;
+
+    // Otherwise, the segment is copied up to each word to relocate, which is written already relocated
+    static const Elf_Addr WORD = sizeof(Elf_Addr);
+    Elf_Addr done = 0;
+    for(Elf_Addr r = 0; r < size; r += entry_size) {
+        Elf_Rel * e = reinterpret_cast<Elf_Rel *>(rel + r);
+        Elf_Addr offset = e->r_offset - vaddr;
+        Elf_Word type = (Traits<CPU>::WORD_SIZE == 32) ? ELF32_R_TYPE(e->r_info) : ELF64_R_TYPE(e->r_info);
+        if((offset + WORD > memsz) || (type != R_RELATIVE))
+            continue;
+
+        bool streamed = !compressed && (offset >= done) && (offset + WORD <= filesz);
+        if(streamed) {
+            memcpy(dst + done, src + done, offset - done);
+            done = offset + WORD;
+        }
+
+        Elf_Addr value;
+        if(rela)
+            value = reinterpret_cast<Elf_Rela *>(e)->r_addend;
+        else
+            memcpy(&value, (streamed ? src : dst) + offset, WORD); // relocations are not always in order
+        value = relocate(value, map, n);
+        memcpy(dst + offset, &value, WORD);
+    }
+    if(!compressed && (done < filesz))
+        memcpy(dst + done, src + done, filesz - done);
+
+    return memsz;
+}
+
+void * ELF::image(Elf_Addr addr)
+{
+    for(int i = 0; i < segments(); i++)
+        if((seg(i)->p_type == PT_LOAD) && !(seg(i)->p_flags & PF_LZ4) && (addr - seg(i)->p_vaddr < seg(i)->p_filesz))
+            return reinterpret_cast<void *>(CPU::Reg(this) + seg(i)->p_offset + (addr - seg(i)->p_vaddr));
+    return 0;
+}
+
+bool ELF::dynamic(Elf_Sword tag, Elf_Addr * value)
+{
+    for(int i = 0; i < segments(); i++) {
+        if(seg(i)->p_type != PT_DYNAMIC)
+            continue;
+
+        // The dynamic section is also in a loadable segment, which might be compressed
+        Elf_Dyn * dyn = reinterpret_cast<Elf_Dyn *>(image(seg(i)->p_vaddr));
+        for(; dyn && (dyn->d_tag != DT_NULL); dyn++)
+            if(dyn->d_tag == tag) {
+                *value = dyn->d_ptr;
+                return true;
+            }
+    }
+    return false;
 }
 
 __END_UTIL
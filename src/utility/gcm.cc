@@ -0,0 +1,254 @@
+// EPOS GHASH and AES-GCM Utility Implementation
+
+#include <utility/gcm.h>
+
+__BEGIN_UTIL
+
+typedef unsigned long long Word;
+
+// Blocks are two big-endian 64-bit words, the first one holding the coefficients of x^0..x^63 (bit-reflected)
+static inline Word load64(const unsigned char * p) {
+    Word w = 0;
+    for(unsigned int i = 0; i < 8; i++)
+        w = (w << 8) | p[i];
+    return w;
+}
+
+static inline void store64(unsigned char * p, Word w) {
+    for(unsigned int i = 8; i--; w >>= 8)
+        p[i] = w;
+}
+
+// clmul: the 128-bit carry-less product of a and b
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__PCLMUL__)
+
+typedef long long V2 __attribute__((vector_size(16)));
+
+static inline void clmul(Word a, Word b, Word & hi, Word & lo)
+{
+    V2 x = { static_cast<long long>(a), 0 };
+    V2 y = { static_cast<long long>(b), 0 };
+    ASM("pclmulqdq $0x00, %1, %0" : "+x"(x) : "x"(y));
+    lo = x[0];
+    hi = x[1];
+}
+
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRYPTO)
+
+typedef unsigned long long V2 __attribute__((vector_size(16)));
+
+static inline void clmul(Word a, Word b, Word & hi, Word & lo)
+{
+    V2 x = { a, 0 };
+    V2 y = { b, 0 };
+    V2 z;
+    ASM("pmull %0.1q, %1.1d, %2.1d" : "=w"(z) : "w"(x), "w"(y));
+    lo = z[0];
+    hi = z[1];
+}
+
+#elif defined(__riscv_zbc) && (__riscv_xlen == 64)
+
+static inline void clmul(Word a, Word b, Word & hi, Word & lo)
+{
+    ASM("clmul %0, %1, %2" : "=r"(lo) : "r"(a), "r"(b));
+    ASM("clmulh %0, %1, %2" : "=r"(hi) : "r"(a), "r"(b));
+}
+
+#else
+
+// The low half of the product, with integer multiplies of operands that have only every fourth bit set, so carries
+// fall into the three bits in between, which are masked out (constant time, unlike table lookups)
+static inline Word bmul64(Word x, Word y)
+{
+    const Word m0 = 0x1111111111111111ULL, m1 = 0x2222222222222222ULL;
+    const Word m2 = 0x4444444444444444ULL, m3 = 0x8888888888888888ULL;
+
+    Word x0 = x & m0, x1 = x & m1, x2 = x & m2, x3 = x & m3;
+    Word y0 = y & m0, y1 = y & m1, y2 = y & m2, y3 = y & m3;
+    Word z0 = (x0 * y0) ^ (x1 * y3) ^ (x2 * y2) ^ (x3 * y1);
+    Word z1 = (x0 * y1) ^ (x1 * y0) ^ (x2 * y3) ^ (x3 * y2);
+    Word z2 = (x0 * y2) ^ (x1 * y1) ^ (x2 * y0) ^ (x3 * y3);
+    Word z3 = (x0 * y3) ^ (x1 * y2) ^ (x2 * y1) ^ (x3 * y0);
+    return (z0 & m0) | (z1 & m1) | (z2 & m2) | (z3 & m3);
+}
+
+static inline Word rev64(Word x)
+{
+    x = ((x & 0x5555555555555555ULL) << 1) | ((x >> 1) & 0x5555555555555555ULL);
+    x = ((x & 0x3333333333333333ULL) << 2) | ((x >> 2) & 0x3333333333333333ULL);
+    x = ((x & 0x0f0f0f0f0f0f0f0fULL) << 4) | ((x >> 4) & 0x0f0f0f0f0f0f0f0fULL);
+    return __builtin_bswap64(x);
+}
+
+// The high half is the low one of the product of the bit-reversed operands, reversed back
+static inline void clmul(Word a, Word b, Word & hi, Word & lo)
+{
+    lo = bmul64(a, b);
+    hi = rev64(bmul64(rev64(a), rev64(b))) >> 1;
+}
+
+#endif
+
+// v ^= y * h, unreduced (256 bits, v[0] the lowest word), h as in GHASH::_h
+static inline void multiply(Word v[4], Word y_hi, Word y_lo, const Word h[3])
+{
+    Word z0h, z0l, z1h, z1l, z2h, z2l;
+    clmul(y_lo, h[1], z0h, z0l);
+    clmul(y_hi, h[0], z1h, z1l);
+    clmul(y_hi ^ y_lo, h[2], z2h, z2l);
+    z2h ^= z0h ^ z1h;
+    z2l ^= z0l ^ z1l;
+
+    v[0] ^= z0l;
+    v[1] ^= z0h ^ z2l;
+    v[2] ^= z1l ^ z2h;
+    v[3] ^= z1h;
+}
+
+// y = v mod x^128 + x^7 + x^2 + x + 1, after the shift that bit reflection calls for
+static inline void reduce(Word v[4], Word & y_hi, Word & y_lo)
+{
+    v[3] = (v[3] << 1) | (v[2] >> 63);
+    v[2] = (v[2] << 1) | (v[1] >> 63);
+    v[1] = (v[1] << 1) | (v[0] >> 63);
+    v[0] = v[0] << 1;
+
+    v[2] ^= v[0] ^ (v[0] >> 1) ^ (v[0] >> 2) ^ (v[0] >> 7);
+    v[1] ^= (v[0] << 63) ^ (v[0] << 62) ^ (v[0] << 57);
+    v[3] ^= v[1] ^ (v[1] >> 1) ^ (v[1] >> 2) ^ (v[1] >> 7);
+    v[2] ^= (v[1] << 63) ^ (v[1] << 62) ^ (v[1] << 57);
+
+    y_hi = v[3];
+    y_lo = v[2];
+}
+
+// Class methods
+void GHASH::key(const unsigned char h[BLOCK_SIZE])
+{
+    _h[0][0] = load64(&h[0]);
+    _h[0][1] = load64(&h[8]);
+    _h[0][2] = _h[0][0] ^ _h[0][1];
+
+    for(unsigned int i = 1; i < PARALLEL; i++) {
+        Word v[4] = { 0, 0, 0, 0 };
+        multiply(v, _h[i - 1][0], _h[i - 1][1], _h[0]);
+        reduce(v, _h[i][0], _h[i][1]);
+        _h[i][2] = _h[i][0] ^ _h[i][1];
+    }
+
+    reset();
+}
+
+void GHASH::update(const unsigned char * data, unsigned int length)
+{
+    for(; length >= PARALLEL * BLOCK_SIZE; length -= PARALLEL * BLOCK_SIZE, data += PARALLEL * BLOCK_SIZE) {
+        Word v[4] = { 0, 0, 0, 0 };
+        multiply(v, load64(&data[0]) ^ _y[0], load64(&data[8]) ^ _y[1], _h[PARALLEL - 1]);
+        for(unsigned int i = 1; i < PARALLEL; i++)
+            multiply(v, load64(&data[i * BLOCK_SIZE]), load64(&data[i * BLOCK_SIZE + 8]), _h[PARALLEL - 1 - i]);
+        reduce(v, _y[0], _y[1]);
+    }
+
+    for(; length; ) {
+        unsigned char block[BLOCK_SIZE];
+        unsigned int n = (length < BLOCK_SIZE) ? length : BLOCK_SIZE;
+        memcpy(block, data, n);
+        memset(block + n, 0, BLOCK_SIZE - n);
+
+        Word v[4] = { 0, 0, 0, 0 };
+        multiply(v, load64(&block[0]) ^ _y[0], load64(&block[8]) ^ _y[1], _h[0]);
+        reduce(v, _y[0], _y[1]);
+        data += n;
+        length -= n;
+    }
+}
+
+void GHASH::digest(unsigned char out[BLOCK_SIZE]) const
+{
+    store64(&out[0], _y[0]);
+    store64(&out[8], _y[1]);
+}
+
+
+// H is the encryption of the zero block
+AES_GCM::AES_GCM(const unsigned char key[KEY_SIZE])
+{
+    _aes.set_key(key);
+
+    unsigned char h[BLOCK_SIZE];
+    memset(h, 0, BLOCK_SIZE);
+    _aes.cipher(h, h);
+    _ghash.key(h);
+    memset(h, 0, BLOCK_SIZE);
+}
+
+void AES_GCM::encrypt(unsigned char * out, unsigned char tag[TAG_SIZE], const unsigned char iv[IV_SIZE],
+                      const unsigned char * in, unsigned int length, const unsigned char * aad, unsigned int aad_length)
+{
+    crypt(out, tag, iv, in, length, aad, aad_length, true);
+}
+
+bool AES_GCM::decrypt(unsigned char * out, const unsigned char tag[TAG_SIZE], const unsigned char iv[IV_SIZE],
+                      const unsigned char * in, unsigned int length, const unsigned char * aad, unsigned int aad_length)
+{
+    unsigned char mine[TAG_SIZE];
+    crypt(out, mine, iv, in, length, aad, aad_length, false);
+
+    // Every byte is compared, so the time taken tells nothing about where they first differ
+    unsigned char diff = 0;
+    for(unsigned int i = 0; i < TAG_SIZE; i++)
+        diff |= mine[i] ^ tag[i];
+
+    if(diff) {
+        db<Ciphers>(WRN) << "AES_GCM::decrypt: tag mismatch!" << endl;
+        memset(out, 0, length);
+    }
+
+    return !diff;
+}
+
+void AES_GCM::crypt(unsigned char * out, unsigned char tag[TAG_SIZE], const unsigned char iv[IV_SIZE],
+                    const unsigned char * in, unsigned int length, const unsigned char * aad, unsigned int aad_length,
+                    bool encrypt)
+{
+    db<Ciphers>(TRC) << "AES_GCM::" << (encrypt ? "en" : "de") << "crypt(out=" << out << ",in=" << in << ",length="
+                     << length << ",aad_length=" << aad_length << ")" << endl;
+
+    // J0 = IV || 1 masks the tag; the message is encrypted from inc32(J0) on
+    unsigned char j0[BLOCK_SIZE];
+    memcpy(j0, iv, IV_SIZE);
+    memset(&j0[IV_SIZE], 0, BLOCK_SIZE - IV_SIZE - 1);
+    j0[BLOCK_SIZE - 1] = 1;
+
+    unsigned char counter[BLOCK_SIZE];
+    memcpy(counter, j0, BLOCK_SIZE);
+    AES::increment(counter, 4);
+
+    _ghash.reset();
+    if(aad_length)
+        _ghash.update(aad, aad_length);
+
+    // Decryption might be in place, so the ciphertext is authenticated before it is overwritten
+    for(unsigned int done = 0; done < length; done += CHUNK) {
+        unsigned int n = ((length - done) < CHUNK) ? length - done : CHUNK;
+        if(!encrypt)
+            _ghash.update(&in[done], n);
+        _aes.ctr(&out[done], &in[done], n, counter, 4);
+        if(encrypt)
+            _ghash.update(&out[done], n);
+    }
+
+    unsigned char lengths[BLOCK_SIZE];
+    store64(&lengths[0], static_cast<Word>(aad_length) * 8);
+    store64(&lengths[8], static_cast<Word>(length) * 8);
+    _ghash.update(lengths, BLOCK_SIZE);
+
+    unsigned char mask[BLOCK_SIZE];
+    _aes.cipher(mask, j0);
+    _ghash.digest(tag);
+    for(unsigned int i = 0; i < TAG_SIZE; i++)
+        tag[i] ^= mask[i];
+}
+
+__END_UTIL
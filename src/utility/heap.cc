@@ -6,10 +6,124 @@ extern "C" { void _panic(); }
 
 __BEGIN_UTIL
 
+// Class attributes
+Per_CPU<unsigned int> Heap_Trace::_head;
+Heap_Trace::Record Heap_Trace::_ring[Traits<Build>::CPUS][Heap_Trace::EVENTS];
+Spin Heap_Profiler::_lock;
+unsigned int Heap_Profiler::_dropped;
+Heap_Profiler::Site Heap_Profiler::_sites[Heap_Profiler::SITES];
+Heap::Shrinker * Heap::_shrinkers[SHRINKERS ? SHRINKERS : 1];
+unsigned int Heap::_shrinker_count;
+volatile bool Heap::_shrinking;
+
+// Class methods
+// Lines are "@heap <ts> <heap> + <bytes> <addr>" for allocations and "@heap <ts> <heap> - <addr>" for frees, taken in
+// time stamp order from all rings, as tools/eposbench/eposreplay reads them
+void Heap_Trace::dump()
+{
+    if(!enabled)
+        return;
+
+    OStream cout;
+
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+
+    unsigned int next[Traits<Build>::CPUS];
+    unsigned int records = 0;
+    for(unsigned int cpu = 0; cpu < CPU::cores(); cpu++) {
+        next[cpu] = (_head[cpu] > EVENTS) ? _head[cpu] - EVENTS : 0;
+        records += _head[cpu] - next[cpu];
+    }
+
+    cout << "Heap_Trace: " << records << " records" << endl;
+    for(; records; records--) {
+        unsigned int first = Traits<Build>::CPUS;
+        for(unsigned int cpu = 0; cpu < CPU::cores(); cpu++)
+            if((next[cpu] < _head[cpu])
+               && ((first == Traits<Build>::CPUS) || (_ring[cpu][next[cpu] % EVENTS].ts < _ring[first][next[first] % EVENTS].ts)))
+                first = cpu;
+
+        const Record & r = _ring[first][next[first]++ % EVENTS];
+        cout << "@heap " << r.ts << " " << r.heap;
+        if(r.bytes)
+            cout << " + " << r.bytes << " " << r.addr << endl;
+        else
+            cout << " - " << r.addr << endl;
+    }
+
+    if(!disabled)
+        CPU::int_enable();
+}
+
+void Heap_Trace::reset()
+{
+    for(unsigned int cpu = 0; cpu < Traits<Build>::CPUS; cpu++)
+        _head[cpu] = 0;
+}
+
+// Sites' PCs can be symbolized as the Profiler's, e.g. grep '^@site' log | awk '{print $2}' | addr2line -f -e app
+void Heap_Profiler::dump()
+{
+    if(!enabled)
+        return;
+
+    OStream cout;
+
+    bool ie = enter();
+    cout << "Heap_Profiler: " << _dropped << " dropped" << endl;
+    for(unsigned int i = 0; i < SITES; i++) {
+        const Site & s = _sites[i];
+        if(s.pc)
+            cout << "@site " << s.pc << " " << s.live << " " << s.blocks << " " << s.allocations << endl;
+    }
+    leave(ie);
+}
+
+bool Heap::shrinker(Shrinker * s)
+{
+    db<Heaps>(TRC) << "Heap::shrinker(s=" << reinterpret_cast<void *>(s) << ")" << endl;
+
+    if(_shrinker_count >= SHRINKERS) {
+        db<Heaps>(WRN) << "Heap::shrinker: no room for another shrinker (see Traits<System>::HEAP_SHRINKERS)!" << endl;
+        return false;
+    }
+    _shrinkers[_shrinker_count++] = s;
+
+    return true;
+}
+
+// Shrinkers free to the heaps, and might even allocate while they are at it, so none of them is locked meanwhile
+unsigned long Heap::shrink(unsigned long bytes)
+{
+    if(!SHRINKERS || !_shrinker_count || CPU::tsl(_shrinking))
+        return 0;
+
+    db<Heaps>(TRC) << "Heap::shrink(bytes=" << bytes << ")" << endl;
+
+    unsigned long freed = 0;
+    for(unsigned int i = 0; (i < _shrinker_count) && (freed < bytes); i++)
+        freed += _shrinkers[i](bytes - freed);
+    _shrinking = false;
+
+    db<Heaps>(INF) << "Heap::shrink(bytes=" << bytes << ") => " << freed << endl;
+
+    return freed;
+}
+
 // Methods
 void Heap::out_of_memory(unsigned long bytes)
 {
+    if(_bounded) {
+        db<Heaps>(WRN) << "Heap::alloc(this=" << this << "): bounded heap exhausted while allocating " << bytes << " bytes!" << endl;
+        return;
+    }
+
     db<Heaps, System>(ERR) << "Heap::alloc(this=" << this << "): out of memory while allocating " << bytes << " bytes!" << endl;
+    if(monitored)
+        db<Heaps, System>(ERR) << "Heap::statistics=" << statistics() << endl;
+    Heap_Profiler::dump();
 
     _panic();
 }
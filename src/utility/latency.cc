@@ -0,0 +1,35 @@
+// EPOS Latency Measurement Utility Implementation
+
+#include <utility/latency.h>
+
+__BEGIN_UTIL
+
+// Class attributes
+Latency::Histogram Latency::_timer[Traits<Build>::CPUS];
+
+// Class methods
+void Latency::dump()
+{
+    if(!enabled)
+        return;
+
+    OStream cout;
+
+    for(unsigned int cpu = 0; cpu < CPU::cores(); cpu++)
+        cout << "Latency::timer[" << cpu << "]=" << _timer[cpu] << endl;
+}
+
+void Latency::reset()
+{
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+
+    for(unsigned int cpu = 0; cpu < Traits<Build>::CPUS; cpu++)
+        _timer[cpu].reset();
+
+    if(!disabled)
+        CPU::int_enable();
+}
+
+__END_UTIL
@@ -0,0 +1,48 @@
+// EPOS Binary Log Utility Implementation
+
+#include <utility/log.h>
+#include <utility/ostream.h>
+
+__BEGIN_UTIL
+
+// Class attributes
+Per_CPU<unsigned int> Log::_head;
+Log::Record Log::_ring[Traits<Build>::CPUS][Log::RECORDS];
+
+// Class methods
+void Log::dump()
+{
+    if(!enabled)
+        return;
+
+    OStream cout;
+
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+
+    // One "@log cpu ts format args..." line per record, in hexadecimal, for tools/eposlog
+    for(unsigned int cpu = 0; cpu < CPU::cores(); cpu++) {
+        unsigned int head = _head[cpu];
+        unsigned int first = (head > RECORDS) ? head - RECORDS : 0;
+
+        for(unsigned int i = first; i < head; i++) {
+            const Record & r = _ring[cpu][i % RECORDS];
+            cout << "@log " << cpu << " " << hex << r.ts << " " << reinterpret_cast<unsigned long long>(r.format);
+            for(unsigned int j = 0; j < ARGS; j++)
+                cout << " " << static_cast<unsigned long long>(r.args[j]);
+            cout << endl;
+        }
+    }
+
+    if(!disabled)
+        CPU::int_enable();
+}
+
+void Log::reset()
+{
+    for(unsigned int cpu = 0; cpu < Traits<Build>::CPUS; cpu++)
+        _head[cpu] = 0;
+}
+
+__END_UTIL
@@ -0,0 +1,64 @@
+// EPOS LZ4 Utility Implementation
+
+#include <utility/lz4.h>
+#include <utility/string.h>
+
+__BEGIN_UTIL
+
+// Class methods
+long LZ4::decompress(const void * src, void * dst, unsigned long size)
+{
+    const unsigned char * ip = reinterpret_cast<const unsigned char *>(src);
+    unsigned char * op = reinterpret_cast<unsigned char *>(dst);
+    unsigned char * const end = op + size;
+
+    // Each sequence is a token (literal and match lengths, 4 bits each), the literals and a match (a 2-byte offset
+    // back into the output and the length beyond the minimum of 4), except for the last one, which only has literals
+    for(;;) {
+        unsigned int token = *ip++;
+
+        unsigned long n = token >> 4;
+        if(n == 15) {
+            unsigned char b;
+            do
+                n += (b = *ip++);
+            while(b == 255);
+        }
+        if(n > static_cast<unsigned long>(end - op))
+            return -1;
+        memcpy(op, ip, n);
+        op += n;
+        ip += n;
+
+        if(op == end)
+            break;
+
+        unsigned int offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if(!offset || (offset > static_cast<unsigned long>(op - reinterpret_cast<unsigned char *>(dst))))
+            return -1;
+        const unsigned char * ref = op - offset;
+
+        n = token & 15;
+        if(n == 15) {
+            unsigned char b;
+            do
+                n += (b = *ip++);
+            while(b == 255);
+        }
+        n += 4;
+        if(n > static_cast<unsigned long>(end - op))
+            return -1;
+
+        if(offset >= n) {
+            memcpy(op, ref, n);
+            op += n;
+        } else // overlapping matches repeat the last "offset" bytes, so they must be copied forward, one at a time
+            while(n--)
+                *op++ = *ref++;
+    }
+
+    return ip - reinterpret_cast<const unsigned char *>(src);
+}
+
+__END_UTIL
@@ -8,6 +8,18 @@ __BEGIN_UTIL
 // Class Attributes
 const char OStream::_digits[] = "0123456789abcdef";
 
+const char OStream::_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
 
 // Class Methods
 int OStream::itoa(int v, char * s)
@@ -15,8 +27,8 @@ int OStream::itoa(int v, char * s)
     unsigned int i = 0;
 
     if(v < 0) {
-        v = -v;
         s[i++] = '-';
+        return utoa(-static_cast<unsigned int>(v), s, i);
     }
 
     return utoa(static_cast<unsigned int>(v), s, i);
@@ -25,8 +37,6 @@ int OStream::itoa(int v, char * s)
 
 int OStream::utoa(unsigned int v, char * s, unsigned int i)
 {
-    unsigned int j;
-
     if(!v) {
         s[i++] = '0';
         return i;
@@ -42,9 +52,10 @@ int OStream::utoa(unsigned int v, char * s, unsigned int i)
             s[i++] = 'x';
     }
 
-    for(j = v; j != 0; i++, j /= _base);
-    for(j = 0; v != 0; j++, v /= _base)
-        s[i - 1 - j] = _digits[v % _base];
+    char buf[sizeof(v) * 8];
+    char * end = buf + sizeof(buf);
+    for(char * d = digits(v, end); d != end; d++)
+        s[i++] = *d;
 
     return i;
 }
@@ -55,8 +66,8 @@ int OStream::llitoa(long long int v, char * s)
     unsigned int i = 0;
 
     if(v < 0) {
-        v = -v;
         s[i++] = '-';
+        return llutoa(-static_cast<unsigned long long int>(v), s, i);
     }
 
     return llutoa(static_cast<unsigned long long int>(v), s, i);
@@ -65,8 +76,6 @@ int OStream::llitoa(long long int v, char * s)
 
 int OStream::llutoa(unsigned long long int v, char * s, unsigned int i)
 {
-    unsigned long long int j;
-
     if(!v) {
         s[i++] = '0';
         return i;
@@ -82,9 +91,10 @@ int OStream::llutoa(unsigned long long int v, char * s, unsigned int i)
             s[i++] = 'x';
     }
 
-    for(j = v; j != 0; i++, j /= _base);
-    for(j = 0; v != 0; j++, v /= _base)
-        s[i - 1 - j] = _digits[v % _base];
+    char buf[sizeof(v) * 8];
+    char * end = buf + sizeof(buf);
+    for(char * d = digits(v, end); d != end; d++)
+        s[i++] = *d;
 
     return i;
 }
@@ -103,4 +113,84 @@ int OStream::ptoa(const void * p, char * s)
     return j + 2;
 }
 
+
+char * OStream::digits(unsigned int v, char * s)
+{
+    switch(_base) {
+    case 10: return decimal(v, s);
+    case 16: do { *--s = _digits[v & 0xf]; v >>= 4; } while(v); return s;
+    case 8:  do { *--s = _digits[v & 0x7]; v >>= 3; } while(v); return s;
+    case 2:  do { *--s = _digits[v & 0x1]; v >>= 1; } while(v); return s;
+    default: do { *--s = _digits[v % _base]; v /= _base; } while(v); return s;
+    }
+}
+
+
+// 64-bit divisions are library calls on 32-bit CPUs, so decimals are split in 9-digit parts (by a reciprocal
+// multiplication) that are converted with 32-bit arithmetic, while other bases only take shifts on the upper half
+char * OStream::digits(unsigned long long int v, char * s)
+{
+    if(v <= 0xffffffff)
+        return digits(static_cast<unsigned int>(v), s);
+
+    switch(_base) {
+    case 10:
+        for(; v > 0xffffffff; s -= 9) {
+            unsigned long long int q = div1e9(v);
+            decimal(static_cast<unsigned int>(v - q * 1000000000), s, 9);
+            v = q;
+        }
+        return digits(static_cast<unsigned int>(v), s);
+    case 16: for(; v > 0xffffffff; v >>= 4) *--s = _digits[v & 0xf]; break;
+    case 8:  for(; v > 0xffffffff; v >>= 3) *--s = _digits[v & 0x7]; break;
+    case 2:  for(; v > 0xffffffff; v >>= 1) *--s = _digits[v & 0x1]; break;
+    default: for(; v > 0xffffffff; v /= _base) *--s = _digits[v % _base]; break;
+    }
+
+    return digits(static_cast<unsigned int>(v), s);
+}
+
+
+// Two digits at a time, from a table, so the division by 100 (by a constant, hence a multiplication) is done for
+// every other digit; the first "width" digits are padded with zeros
+char * OStream::decimal(unsigned int v, char * s, unsigned int width)
+{
+    char * end = s - width;
+
+    for(; v >= 100; v /= 100) {
+        const char * p = &_pairs[(v % 100) * 2];
+        *--s = p[1];
+        *--s = p[0];
+    }
+    if(v >= 10) {
+        *--s = _pairs[v * 2 + 1];
+        *--s = _pairs[v * 2];
+    } else
+        *--s = '0' + v;
+
+    while(s > end)
+        *--s = '0';
+
+    return s;
+}
+
+
+// v / 10^9 = (v / 2^9) / 5^9, the latter taken as the high half of its product with 2^84 / 5^9
+unsigned long long int OStream::div1e9(unsigned long long int v)
+{
+    static const unsigned long long int M = 0x89705f4136b4a598ULL;
+
+    unsigned long long int x = v >> 9;
+
+#ifdef __SIZEOF_INT128__
+    return static_cast<unsigned long long int>((static_cast<unsigned __int128>(x) * M) >> 64) >> 20;
+#else
+    unsigned long long int xl = x & 0xffffffff, xh = x >> 32;
+    unsigned long long int ml = M & 0xffffffff, mh = M >> 32;
+    unsigned long long int ll = xl * ml, lh = xl * mh, hl = xh * ml, hh = xh * mh;
+    unsigned long long int mid = (ll >> 32) + (lh & 0xffffffff) + (hl & 0xffffffff);
+    return (hh + (lh >> 32) + (hl >> 32) + (mid >> 32)) >> 20;
+#endif
+}
+
 __END_UTIL
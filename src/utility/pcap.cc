@@ -0,0 +1,48 @@
+// EPOS Packet Capture Implementation
+
+#include <utility/pcap.h>
+#include <utility/ostream.h>
+
+__BEGIN_UTIL
+
+// Class attributes
+volatile unsigned int PCAP::_head;
+PCAP::Record PCAP::_ring[PCAP::FRAMES];
+
+// Class methods
+void PCAP::dump()
+{
+    static const char digits[] = "0123456789abcdef";
+    static const unsigned int CHUNK = 32;  // bytes per print, so the line doesn't need a SNAPLEN-sized buffer
+
+    if(!enabled)
+        return;
+
+    OStream cout;
+
+    // "@pcap g <link type> <snaplen>", then "@pcap p <sec> <usec> <length> <bytes>" for each frame, for tools/epospcap
+    cout << "@pcap g " << static_cast<unsigned int>(Traits<PCAP>::LINK_TYPE) << " " << SNAPLEN << endl;
+
+    unsigned int head = _head;
+    for(unsigned int i = first(head); i < head; i++) {
+        const Record & r = _ring[i % FRAMES];
+        unsigned int sec, usec;
+        time(r.ts, &sec, &usec);
+        cout << "@pcap p " << sec << " " << usec << " " << r.size << " ";
+
+        unsigned int size = (r.size < SNAPLEN) ? r.size : SNAPLEN;
+        for(unsigned int j = 0; j < size; j += CHUNK) {
+            char buf[CHUNK * 2 + 1];
+            unsigned int k = 0;
+            for(; (k < CHUNK) && (j + k < size); k++) {
+                buf[k * 2] = digits[r.data[j + k] >> 4];
+                buf[k * 2 + 1] = digits[r.data[j + k] & 0x0f];
+            }
+            buf[k * 2] = '\0';
+            cout << buf;
+        }
+        cout << endl;
+    }
+}
+
+__END_UTIL
@@ -0,0 +1,57 @@
+// EPOS Statistical Profiler Utility Implementation
+
+#include <utility/profiler.h>
+#include <utility/ostream.h>
+
+__BEGIN_UTIL
+
+// Class attributes
+Per_CPU<unsigned int> Profiler::_samples;
+Per_CPU<unsigned int> Profiler::_dropped;
+Profiler::Bin Profiler::_bins[Traits<Build>::CPUS][Profiler::BINS];
+
+// Class methods
+void Profiler::dump()
+{
+    if(!enabled)
+        return;
+
+    OStream cout;
+
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+
+    if(CPU::cores() > 1)
+        cout << "Profile: " << _samples.sum() << " samples, " << _dropped.sum() << " dropped" << endl;
+    for(unsigned int cpu = 0; cpu < CPU::cores(); cpu++) {
+        cout << "Profile[" << cpu << "]: " << _samples[cpu] << " samples, " << _dropped[cpu] << " dropped" << endl;
+        for(unsigned int i = 0; i < BINS; i++) {
+            const Bin & b = _bins[cpu][i];
+            if(b.count)
+                cout << "@ " << b.pc << " " << b.thread << " " << b.count << endl;
+        }
+    }
+
+    if(!disabled)
+        CPU::int_enable();
+}
+
+void Profiler::reset()
+{
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+
+    for(unsigned int cpu = 0; cpu < Traits<Build>::CPUS; cpu++) {
+        _samples[cpu] = 0;
+        _dropped[cpu] = 0;
+        for(unsigned int i = 0; i < BINS; i++)
+            _bins[cpu][i].count = 0;
+    }
+
+    if(!disabled)
+        CPU::int_enable();
+}
+
+__END_UTIL
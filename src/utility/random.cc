@@ -1,7 +1,43 @@
+// EPOS Pseudo Random Number Generator Utility Implementation
+
 #include <utility/random.h>
 
 __BEGIN_UTIL
 
-int Random::_seed;
+// Class attributes
+Random::State Random::_state[CPUS];
+
+// Class methods
+void Random::fill(void * buf, unsigned int n)
+{
+    State & state = _state[(CPUS > 1) ? CPU::id() : 0];
+    unsigned char * b = reinterpret_cast<unsigned char *>(buf);
+
+    for(; n && (reinterpret_cast<unsigned long>(b) & (sizeof(unsigned int) - 1)); n--, b++)
+        *b = next(state);
+    for(; n >= sizeof(unsigned int); n -= sizeof(unsigned int), b += sizeof(unsigned int))
+        *reinterpret_cast<unsigned int *>(b) = next(state);
+    if(n) {
+        unsigned int r = next(state);
+        for(; n; n--, b++, r >>= 8)
+            *b = r;
+    }
+}
+
+void Random::seed(int value)
+{
+    // SplitMix32 spreads the seed over the 128-bit states, which must not be all zeros
+    unsigned int x = value;
+    for(unsigned int i = 0; i < CPUS; i++) {
+        for(unsigned int j = 0; j < 4; j++) {
+            unsigned int z = (x += 0x9e3779b9);
+            z = (z ^ (z >> 16)) * 0x85ebca6b;
+            z = (z ^ (z >> 13)) * 0xc2b2ae35;
+            _state[i].s[j] = z ^ (z >> 16);
+        }
+        if(!(_state[i].s[0] | _state[i].s[1] | _state[i].s[2] | _state[i].s[3]))
+            _state[i] = State();
+    }
+}
 
 __END_UTIL
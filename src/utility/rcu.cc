@@ -0,0 +1,80 @@
+// EPOS Read-Copy-Update Utility Implementation
+
+#include <utility/rcu.h>
+
+__BEGIN_UTIL
+
+// Class attributes
+volatile unsigned int RCU::_epoch;
+volatile unsigned int RCU::_pending = RCU::ALL;
+RCU::Head * RCU::_head;
+RCU::Head * RCU::_tail;
+Simple_Spin RCU::_lock;
+
+// Class methods
+void RCU::call(Head * head, Callback callback)
+{
+    // A single CPU can't be in a read-side section of its own while running us
+    if(!enabled || (CPUS == 1)) {
+        callback(head);
+        return;
+    }
+
+    head->_callback = callback;
+    head->_next = 0;
+
+    bool masked = CPU::int_disabled(); // quiescent() and reclaim() might run on this CPU in between
+    CPU::int_disable();
+    _lock.acquire();
+    head->_epoch = _epoch;
+    if(_tail)
+        _tail->_next = head;
+    else
+        _head = head;
+    _tail = head;
+    _lock.release();
+    if(!masked)
+        CPU::int_enable();
+
+    reclaim();
+}
+
+void RCU::synchronize()
+{
+    if(!enabled || (CPUS == 1))
+        return;
+
+    unsigned int target = _epoch + 2;
+    while(static_cast<int>(_epoch - target) < 0) {
+        quiescent();
+        CPU::pause();
+    }
+}
+
+void RCU::reclaim()
+{
+    if(!enabled)
+        return;
+
+    for(;;) {
+        bool masked = CPU::int_disabled();
+        CPU::int_disable();
+        _lock.acquire();
+        Head * head = _head;
+        if(head && (static_cast<int>(_epoch - head->_epoch) >= 2)) {
+            _head = head->_next;
+            if(!_head)
+                _tail = 0;
+        } else
+            head = 0;
+        _lock.release();
+        if(!masked)
+            CPU::int_enable();
+
+        if(!head)
+            break;
+        head->_callback(head);
+    }
+}
+
+__END_UTIL
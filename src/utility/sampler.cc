@@ -0,0 +1,45 @@
+// EPOS Event-based Sampler Utility Implementation
+
+#include <utility/sampler.h>
+#include <utility/ostream.h>
+
+__BEGIN_UTIL
+
+// Class attributes
+Per_CPU<unsigned int> Sampler::_head;
+Sampler::Sample Sampler::_ring[Traits<Build>::CPUS][Sampler::SAMPLES];
+
+// Class methods
+void Sampler::dump()
+{
+    if(!enabled)
+        return;
+
+    OStream cout;
+
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+
+    for(unsigned int cpu = 0; cpu < CPU::cores(); cpu++) {
+        unsigned int head = _head[cpu];
+        unsigned int first = (head > SAMPLES) ? head - SAMPLES : 0;
+
+        cout << "Samples[" << cpu << "]: " << head - first << " of " << head << " overflows" << endl;
+        for(unsigned int i = first; i < head; i++) {
+            const Sample & s = _ring[cpu][i % SAMPLES];
+            cout << "# " << s.pc << " " << s.thread << " " << s.channel << endl;
+        }
+    }
+
+    if(!disabled)
+        CPU::int_enable();
+}
+
+void Sampler::reset()
+{
+    for(unsigned int cpu = 0; cpu < Traits<Build>::CPUS; cpu++)
+        _head[cpu] = 0;
+}
+
+__END_UTIL
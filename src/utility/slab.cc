@@ -0,0 +1,14 @@
+// EPOS Slab Allocator Utility Implementation
+
+#include <utility/slab.h>
+#include <system.h>
+
+__BEGIN_UTIL
+
+// Class methods
+void * Slab_Common::allocate(unsigned long bytes)
+{
+    return new (SYSTEM) char[bytes];
+}
+
+__END_UTIL
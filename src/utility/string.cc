@@ -3,6 +3,18 @@
 #include <system/config.h>
 #include <utility/string.h>
 
+// Word-at-a-time helpers (Newlib's DETECTNULL uses "(x - ONES) & ~x & HIGHS" to find a zero byte in x), sized to long
+static const size_t WORD = sizeof(long);
+static const unsigned long ONES = ~0UL / 0xff;   // 0x01 in every byte
+static const unsigned long HIGHS = ONES << 7;    // 0x80 in every byte
+
+// memcpy() and memset() move Blocks: a NEON Q register on ARMv8, a long otherwise; only word alignment is assumed
+#if defined(__aarch64__) && defined(__ARM_NEON)
+typedef unsigned long Block __attribute__((vector_size(16), aligned(sizeof(long))));
+#else
+typedef unsigned long Block;
+#endif
+
 extern "C"
 {
 
@@ -24,74 +36,82 @@ extern "C"
 
     int memcmp(const void * m1, const void * m2, size_t n)
     {
-        unsigned char *s1 = (unsigned char *) m1;
-        unsigned char *s2 = (unsigned char *) m2;
-        unsigned long *a1;
-        unsigned long *a2;
-
-        if(!((n) < (sizeof(long))) && !(((long) s1 & (sizeof(long) - 1))
-            | ((long) s2 & (sizeof(long) - 1)))) {
-
-            a1 = (unsigned long*) s1;
-            a2 = (unsigned long*) s2;
-            while(n >= (sizeof(long))) {
-                if(*a1 != *a2)
-                    break;
-                a1++;
-                a2++;
-                n -= (sizeof(long));
-            }
-
-            s1 = (unsigned char*) a1;
-            s2 = (unsigned char*) a2;
+        const unsigned char * s1 = reinterpret_cast<const unsigned char *>(m1);
+        const unsigned char * s2 = reinterpret_cast<const unsigned char *>(m2);
+
+        if((n >= 2 * WORD) && !((reinterpret_cast<unsigned long>(s1) ^ reinterpret_cast<unsigned long>(s2)) & (WORD - 1))) {
+            for(; reinterpret_cast<unsigned long>(s1) & (WORD - 1); s1++, s2++, n--)
+                if(*s1 != *s2)
+                    return *s1 - *s2;
+
+            const unsigned long * a1 = reinterpret_cast<const unsigned long *>(s1);
+            const unsigned long * a2 = reinterpret_cast<const unsigned long *>(s2);
+            for(; (n >= 2 * WORD) && (a1[0] == a2[0]) && (a1[1] == a2[1]); a1 += 2, a2 += 2)
+                n -= 2 * WORD;
+            for(; (n >= WORD) && (*a1 == *a2); a1++, a2++)
+                n -= WORD;
+
+            s1 = reinterpret_cast<const unsigned char *>(a1);
+            s2 = reinterpret_cast<const unsigned char *>(a2);
         }
 
-        while(n--) {
+        // What is left, including the word that differs, if any
+        for(; n--; s1++, s2++)
             if(*s1 != *s2)
                 return *s1 - *s2;
-            s1++;
-            s2++;
-        }
 
         return 0;
-
     }
 
-    void * memcpy(void * dst0, const void * src0, size_t len0)
+    void * memcpy(void * dst0, const void * src0, size_t len)
     {
-        char *dst = reinterpret_cast<char *> (dst0);
-        const char *src = reinterpret_cast<const char *> (src0);
-        long *aligned_dst;
-        const long *aligned_src;
-        size_t len = len0;
-
-        if(!((len) < (sizeof(long) << 2)) && !(((long) src & (sizeof(long) - 1))
-            | ((long) dst & (sizeof(long) - 1)))) {
-            aligned_dst = (long*) dst;
-            aligned_src = (long*) src;
-
-            while(len >= (sizeof(long) << 2)) {
-                *aligned_dst++ = *aligned_src++;
-                *aligned_dst++ = *aligned_src++;
-                *aligned_dst++ = *aligned_src++;
-                *aligned_dst++ = *aligned_src++;
-                len -= (sizeof(long) << 2);
-            }
-
-            while(len >= (sizeof(long))) {
-                *aligned_dst++ = *aligned_src++;
-                len -= (sizeof(long));
+        char * dst = reinterpret_cast<char *>(dst0);
+        const char * src = reinterpret_cast<const char *>(src0);
+
+#ifdef __riscv_vector
+        // With RVV, each iteration moves as many bytes as a group of eight vector registers holds, at any alignment
+        while(len) {
+            size_t vl;
+            ASM("vsetvli %0, %1, e8, m8, ta, ma     \n"
+                "vle8.v  v0, (%2)                   \n"
+                "vse8.v  v0, (%3)                   \n" : "=&r"(vl) : "r"(len), "r"(src), "r"(dst) : "v0", "v1", "v2", "v3", "v4", "v5", "v6", "v7", "memory");
+            src += vl;
+            dst += vl;
+            len -= vl;
+        }
+#elif defined(__i386__)
+        // On IA-32, REP MOVS is the bulk copy engine (fast strings move whole cache lines since the P6), at any alignment
+        size_t words = len / WORD;
+        ASM("rep movsl" : "+D"(dst), "+S"(src), "+c"(words) : : "memory");
+        for(len &= WORD - 1; len; len--)
+            *dst++ = *src++;
+#else
+        // Blocks can only be moved if both pointers are equally misaligned, so the first bytes are peeled off to align them
+        if((len >= 4 * sizeof(Block)) && !((reinterpret_cast<unsigned long>(src) ^ reinterpret_cast<unsigned long>(dst)) & (WORD - 1))) {
+            for(; reinterpret_cast<unsigned long>(dst) & (WORD - 1); len--)
+                *dst++ = *src++;
+
+            Block * d = reinterpret_cast<Block *>(dst);
+            const Block * s = reinterpret_cast<const Block *>(src);
+            for(; len >= 4 * sizeof(Block); d += 4, s += 4) {
+                d[0] = s[0];
+                d[1] = s[1];
+                d[2] = s[2];
+                d[3] = s[3];
+                len -= 4 * sizeof(Block);
             }
+            for(; len >= sizeof(Block); len -= sizeof(Block))
+                *d++ = *s++;
 
-            dst = (char*) aligned_dst;
-            src = (char*) aligned_src;
+            dst = reinterpret_cast<char *>(d);
+            src = reinterpret_cast<const char *>(s);
         }
 
         while(len--)
             *dst++ = *src++;
+#endif
 
         return dst0;
-
     }
 
     void * memchr(const void * src_void, int c, size_t length)
@@ -119,7 +139,7 @@ extern "C"
                 mask = (mask << i) | mask;
 
             while(length >= (sizeof(long))) {
-                if(((((*asrc ^ mask) - 0x01010101) & ~(*asrc ^ mask) & 0x80808080)))
+                if(((((*asrc ^ mask) - ONES) & ~(*asrc ^ mask) & HIGHS)))
                     break;
                 length -= (sizeof(long));
                 asrc++;
@@ -139,47 +159,45 @@ extern "C"
 
     void * memset(void * m, int c, size_t n)
     {
-        char *s = (char *) m;
-
-        size_t i;
-        unsigned long buffer;
-        unsigned long *aligned_addr;
-        unsigned int d = c & 0xff;
-
-        while(((long) s & ((sizeof(long)) - 1))) {
-            if(n--)
-                *s++ = (char) c;
-            else
-                return m;
+        char * s = reinterpret_cast<char *>(m);
+
+#ifdef __riscv_vector
+        while(n) {
+            size_t vl;
+            ASM("vsetvli %0, %1, e8, m8, ta, ma     \n"
+                "vmv.v.x v0, %2                     \n"
+                "vse8.v  v0, (%3)                   \n" : "=&r"(vl) : "r"(n), "r"(c), "r"(s) : "v0", "v1", "v2", "v3", "v4", "v5", "v6", "v7", "memory");
+            s += vl;
+            n -= vl;
         }
-
-        if(!((n) < (sizeof(long)))) {
-
-            aligned_addr = (unsigned long *) s;
-
-            buffer = (d << 8) | d;
-            buffer |= (buffer << 16);
-            for(i = 32; i < (sizeof(long)) * 8; i <<= 1)
-                buffer = (buffer << i) | buffer;
-
-            while(n >= (sizeof(long)) * 4) {
-                *aligned_addr++ = buffer;
-                *aligned_addr++ = buffer;
-                *aligned_addr++ = buffer;
-                *aligned_addr++ = buffer;
-                n -= 4 * (sizeof(long));
-            }
-
-            while(n >= (sizeof(long))) {
-                *aligned_addr++ = buffer;
-                n -= (sizeof(long));
+#elif defined(__i386__)
+        size_t words = n / WORD;
+        ASM("rep stosl" : "+D"(s), "+c"(words) : "a"((c & 0xff) * ONES) : "memory");
+        for(n &= WORD - 1; n; n--)
+            *s++ = c;
+#else
+        if(n >= 4 * sizeof(Block)) {
+            for(; reinterpret_cast<unsigned long>(s) & (WORD - 1); n--)
+                *s++ = c;
+
+            Block b = Block{} + (c & 0xff) * ONES; // the byte in every lane
+            Block * d = reinterpret_cast<Block *>(s);
+            for(; n >= 4 * sizeof(Block); d += 4) {
+                d[0] = b;
+                d[1] = b;
+                d[2] = b;
+                d[3] = b;
+                n -= 4 * sizeof(Block);
             }
+            for(; n >= sizeof(Block); n -= sizeof(Block))
+                *d++ = b;
 
-            s = (char*) aligned_addr;
+            s = reinterpret_cast<char *>(d);
         }
 
         while(n--)
-            *s++ = (char) c;
+            *s++ = c;
+#endif
 
         return m;
     }
@@ -195,7 +213,7 @@ extern "C"
             a2 = (unsigned long*) s2;
             while(*a1 == *a2) {
 
-                if((((*a1) - 0x01010101) & ~(*a1) & 0x80808080))
+                if((((*a1) - ONES) & ~(*a1) & HIGHS))
                     return 0;
 
                 a1++;
@@ -228,7 +246,7 @@ extern "C"
             while(n >= sizeof(long) && *a1 == *a2) {
                 n -= sizeof(long);
 
-                if(n == 0 || (((*a1) - 0x01010101) & ~(*a1) & 0x80808080))
+                if(n == 0 || (((*a1) - ONES) & ~(*a1) & HIGHS))
                     return 0;
 
                 a1++;
@@ -260,7 +278,7 @@ extern "C"
             aligned_dst = (long*) dst;
             aligned_src = (long*) src;
 
-            while(!(((*aligned_src) - 0x01010101) & ~(*aligned_src) & 0x80808080)) {
+            while(!(((*aligned_src) - ONES) & ~(*aligned_src) & HIGHS)) {
                 *aligned_dst++ = *aligned_src++;
             }
 
@@ -286,8 +304,8 @@ extern "C"
             aligned_dst = (long*) dst;
             aligned_src = (long*) src;
 
-            while(count >= sizeof(long int) && !(((*aligned_src) - 0x01010101)
-                & ~(*aligned_src) & 0x80808080)) {
+            while(count >= sizeof(long int) && !(((*aligned_src) - ONES)
+                & ~(*aligned_src) & HIGHS)) {
                 count -= sizeof(long int);
                 *aligned_dst++ = *aligned_src++;
             }
@@ -330,7 +348,7 @@ extern "C"
             }
 
             aligned_addr = (unsigned long *) s;
-            while(!(((*aligned_addr) - 0x01010101) & ~(*aligned_addr) & 0x80808080))
+            while(!(((*aligned_addr) - ONES) & ~(*aligned_addr) & HIGHS))
                 aligned_addr++;
 
             s = (const unsigned char *) aligned_addr;
@@ -352,9 +370,9 @@ extern "C"
             mask = (mask << j) | mask;
 
         aligned_addr = (unsigned long *) s;
-        while(!(((*aligned_addr) - 0x01010101) & ~(*aligned_addr) & 0x80808080)
-            && !((((*aligned_addr ^ mask) - 0x01010101) & ~(*aligned_addr
-                ^ mask) & 0x80808080)))
+        while(!(((*aligned_addr) - ONES) & ~(*aligned_addr) & HIGHS)
+            && !((((*aligned_addr ^ mask) - ONES) & ~(*aligned_addr
+                ^ mask) & HIGHS)))
             aligned_addr++;
 
         s = (unsigned char *) aligned_addr;
@@ -379,7 +397,7 @@ extern "C"
         }
 
         aligned_addr = (unsigned long *) str;
-        while(!(((*aligned_addr) - 0x01010101) & ~(*aligned_addr) & 0x80808080))
+        while(!(((*aligned_addr) - ONES) & ~(*aligned_addr) & HIGHS))
             aligned_addr++;
 
         str = (char *) aligned_addr;
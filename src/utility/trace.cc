@@ -0,0 +1,68 @@
+// EPOS Binary Event Trace Utility Implementation
+
+#include <utility/trace.h>
+#include <utility/ostream.h>
+
+__BEGIN_UTIL
+
+// Class attributes
+Per_CPU<unsigned int> Trace::_head;
+Trace::Record Trace::_ring[Traits<Build>::CPUS][Trace::EVENTS];
+Trace::Time_Stamp Trace::_skew[Traits<Build>::CPUS];
+
+// Class methods
+void Trace::dump()
+{
+    static const char * names[] = { "dispatch", "sleep", "wakeup", "alarm", "interrupt", "lock" };
+    static const unsigned int CPUS = Traits<Build>::CPUS;
+
+    if(!enabled)
+        return;
+
+    OStream cout;
+
+    bool disabled = CPU::int_disabled();
+    if(!disabled)
+        CPU::int_disable();
+
+    // Other CPUs might still be recording, so only the records they had taken by now are decoded
+    unsigned int head[CPUS];
+    unsigned int next[CPUS];
+    unsigned int events = 0;
+    for(unsigned int cpu = 0; cpu < CPU::cores(); cpu++) {
+        head[cpu] = _head[cpu];
+        next[cpu] = (head[cpu] > EVENTS) ? head[cpu] - EVENTS : 0;
+        events += head[cpu] - next[cpu];
+        cout << "Trace[" << cpu << "]: " << head[cpu] - next[cpu] << " of " << head[cpu] << " events" << endl;
+    }
+
+    // Merges the rings, taking the earliest of their next records each time, in CPU 0's time
+    for(unsigned int n = 0; n < events; n++) {
+        unsigned int earliest = CPUS;
+        Time_Stamp ts = 0;
+        for(unsigned int cpu = 0; cpu < CPU::cores(); cpu++) {
+            if(next[cpu] == head[cpu])
+                continue;
+            Time_Stamp t = _ring[cpu][next[cpu] % EVENTS].ts - _skew[cpu] + _skew[0];
+            if((earliest == CPUS) || (t < ts)) {
+                earliest = cpu;
+                ts = t;
+            }
+        }
+
+        const Record & r = _ring[earliest][next[earliest]++ % EVENTS];
+        cout << "@trace " << ts << " " << earliest << " " << names[r.event] << " a=" << r.a << " b=" << r.b
+             << " s=" << r.state << endl;
+    }
+
+    if(!disabled)
+        CPU::int_enable();
+}
+
+void Trace::reset()
+{
+    for(unsigned int cpu = 0; cpu < Traits<Build>::CPUS; cpu++)
+        _head[cpu] = 0;
+}
+
+__END_UTIL
@@ -0,0 +1,18 @@
+/*=======================================================================*/
+/* clock.c                                                               */
+/*                                                                       */
+/* Desc: The host's monotonic clock, in ns, for the host TSC (see        */
+/*       include/architecture/host/host_tsc.h). Kept apart and compiled  */
+/*       without EPOS' include path, whose time.h would shadow libc's.   */
+/*=======================================================================*/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <time.h>
+
+unsigned long long host_clock(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
@@ -0,0 +1,448 @@
+/*=======================================================================*/
+/* eposbench.cc                                                          */
+/*                                                                       */
+/* Desc: Micro-benchmarks of the utility templates, compiled for the     */
+/*       host against the mediators in tools/eposbench/include, so       */
+/*       data structure changes can be compared without a target.        */
+/*       Times are in ns per operation, reported as min/avg/p99 over     */
+/*       ROUNDS rounds, in the format of app/benchmark.                  */
+/*                                                                       */
+/* Parm: [<name prefix>] (only benchmarks whose names start with it)     */
+/*=======================================================================*/
+
+#include <utility/list.h>
+#include <utility/hash.h>
+#include <utility/heap.h>
+#include <utility/bitmap.h>
+#include <utility/buffer.h>
+#include <utility/aes.h>
+#include <utility/chacha20.h>
+#include <utility/gcm.h>
+#include <utility/bignum.h>
+
+// Using only bare C from the host, after EPOS, to avoid conflicts (see eposcfg)
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace EPOS;
+
+typedef TSC::Time_Stamp Time_Stamp;
+
+// Constants
+const unsigned int ROUNDS = 32;
+const unsigned int SIZES[] = { 64, 256, 1024, 4096 };
+const unsigned int MAX_N = 4096;
+const unsigned int HEAP_SIZE = 4 * 1024 * 1024;
+const unsigned int TRACE = 4096;        // alloc/free events per round of the random trace
+const unsigned int BLOCKS = 256;        // AES (16-byte) blocks per round, also for ChaCha20
+const unsigned int BITS = 4096;         // Bitmap size
+const unsigned int BUFFERS = 64;
+
+// Globals
+OStream cout;
+const char * prefix = "";
+Time_Stamp samples[ROUNDS];
+unsigned int ranks[MAX_N];
+unsigned int seed = 0x9e3779b9;
+
+struct Object { unsigned int id; } objects[MAX_N];
+Open_Hash<Object, MAX_N * 2, unsigned int> open_hash;
+
+// Bindings
+extern "C" {
+    unsigned long long host_clock(); // clock.c
+
+    void _panic() { fputs("eposbench: panic!\n", stderr); exit(1); }
+    void _print(const char * s) { fputs(s, stdout); }
+    void _print_preamble() {}
+    void _print_trailler(bool error) { if(error) _panic(); }
+}
+
+__BEGIN_SYS
+OStream kerr;
+bool CPU::_int_enabled = true;
+TSC::Time_Stamp TSC::time_stamp() { return host_clock(); }
+__END_SYS
+
+
+// Utilities
+unsigned int random32()
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+// Ranks 0 .. n - 1 in a random order, the same in every run
+void shuffle(unsigned int n)
+{
+    seed = 0x9e3779b9;
+    for(unsigned int i = 0; i < n; i++)
+        ranks[i] = i;
+    for(unsigned int i = n - 1; i > 0; i--) {
+        unsigned int j = random32() % (i + 1);
+        unsigned int t = ranks[i];
+        ranks[i] = ranks[j];
+        ranks[j] = t;
+    }
+}
+
+bool selected(const char * name) { return !strncmp(name, prefix, strlen(prefix)); }
+
+void report(const char * name, unsigned int n = 0)
+{
+    for(unsigned int i = 1; i < ROUNDS; i++) {
+        Time_Stamp s = samples[i];
+        unsigned int j;
+        for(j = i; (j > 0) && (samples[j - 1] > s); j--)
+            samples[j] = samples[j - 1];
+        samples[j] = s;
+    }
+
+    Time_Stamp sum = 0;
+    for(unsigned int i = 0; i < ROUNDS; i++)
+        sum += samples[i];
+
+    cout << name;
+    if(n)
+        cout << " (n=" << n << ")";
+    cout << ": min=" << samples[0] << ", avg=" << sum / ROUNDS << ", p99=" << samples[ROUNDS * 99 / 100] << endl;
+}
+
+
+// Ordered lists: n insertions in a random rank order, then a search for each rank, then n removals from the head
+template<typename L>
+void bench_list(const char * name)
+{
+    typedef typename L::Element Element;
+    static char storage[MAX_N * sizeof(Element)] __attribute__((aligned(16)));
+    Element * elements = reinterpret_cast<Element *>(storage);
+
+    char insert[64], search[64], remove[64];
+    snprintf(insert, sizeof(insert), "%s::insert", name);
+    snprintf(search, sizeof(search), "%s::search_rank", name);
+    snprintf(remove, sizeof(remove), "%s::remove", name);
+    if(!selected(insert) && !selected(search) && !selected(remove))
+        return;
+
+    for(unsigned int s = 0; s < sizeof(SIZES) / sizeof(SIZES[0]); s++) {
+        unsigned int n = SIZES[s];
+        shuffle(n);
+        Time_Stamp inserts[ROUNDS], searches[ROUNDS], removes[ROUNDS];
+
+        for(unsigned int r = 0; r < ROUNDS; r++) {
+            L list;
+            for(unsigned int i = 0; i < n; i++)
+                new (&elements[i]) Element(&objects[i], ranks[i]);
+
+            Time_Stamp t0 = TSC::time_stamp();
+            for(unsigned int i = 0; i < n; i++)
+                list.insert(&elements[i]);
+            Time_Stamp t1 = TSC::time_stamp();
+            for(unsigned int i = 0; i < n; i++)
+                if(!list.search_rank(ranks[i]))
+                    _panic();
+            Time_Stamp t2 = TSC::time_stamp();
+            while(list.remove());
+            Time_Stamp t3 = TSC::time_stamp();
+
+            inserts[r] = (t1 - t0) / n;
+            searches[r] = (t2 - t1) / n;
+            removes[r] = (t3 - t2) / n;
+        }
+
+        memcpy(samples, inserts, sizeof(samples));
+        report(insert, n);
+        memcpy(samples, searches, sizeof(samples));
+        report(search, n);
+        memcpy(samples, removes, sizeof(samples));
+        report(remove, n);
+    }
+}
+
+
+// Chained and open-addressing hashes: n insertions and a search for each key
+void bench_hash()
+{
+    typedef Hash<Object, 64, unsigned int> Chained;
+    static char storage[MAX_N * sizeof(Chained::Element)] __attribute__((aligned(16)));
+    Chained::Element * elements = reinterpret_cast<Chained::Element *>(storage);
+
+    for(unsigned int s = 0; s < sizeof(SIZES) / sizeof(SIZES[0]); s++) {
+        unsigned int n = SIZES[s];
+        shuffle(n);
+
+        if(selected("Hash::search_key")) {
+            for(unsigned int r = 0; r < ROUNDS; r++) {
+                Chained hash;
+                for(unsigned int i = 0; i < n; i++) {
+                    new (&elements[i]) Chained::Element(&objects[i], ranks[i]);
+                    hash.insert(&elements[i]);
+                }
+                Time_Stamp t0 = TSC::time_stamp();
+                for(unsigned int i = 0; i < n; i++)
+                    if(!hash.search_key(i))
+                        _panic();
+                samples[r] = (TSC::time_stamp() - t0) / n;
+            }
+            report("Hash::search_key", n);
+        }
+
+        if(selected("Open_Hash::search_key")) {
+            for(unsigned int r = 0; r < ROUNDS; r++) {
+                for(unsigned int i = 0; i < n; i++)
+                    open_hash.insert(ranks[i], &objects[i]);
+                Time_Stamp t0 = TSC::time_stamp();
+                for(unsigned int i = 0; i < n; i++)
+                    if(!open_hash.search_key(i))
+                        _panic();
+                samples[r] = (TSC::time_stamp() - t0) / n;
+                for(unsigned int i = 0; i < n; i++)
+                    open_hash.remove_key(i);
+            }
+            report("Open_Hash::search_key", n);
+        }
+    }
+}
+
+
+// Heap: alloc/free pairs of a fixed size, then a random trace of allocations (16 to 1040 bytes) and frees
+void bench_heap()
+{
+    static char memory[HEAP_SIZE] __attribute__((aligned(16)));
+    static void * live[TRACE];
+
+    if(selected("Heap::alloc/free")) {
+        for(unsigned int r = 0; r < ROUNDS; r++) {
+            Heap heap(memory, HEAP_SIZE);
+            Time_Stamp t0 = TSC::time_stamp();
+            for(unsigned int i = 0; i < MAX_N; i++)
+                Heap::untyped_free(&heap, heap.alloc(64));
+            samples[r] = (TSC::time_stamp() - t0) / MAX_N;
+        }
+        report("Heap::alloc/free");
+    }
+
+    if(selected("Heap::trace")) {
+        for(unsigned int r = 0; r < ROUNDS; r++) {
+            Heap heap(memory, HEAP_SIZE);
+            unsigned int n = 0;
+            seed = 0x9e3779b9 + r;
+            Time_Stamp t0 = TSC::time_stamp();
+            for(unsigned int i = 0; i < TRACE; i++) {
+                unsigned int x = random32();
+                if(n && ((x & 3) == 0 || n == TRACE)) {
+                    unsigned int j = (x >> 2) % n;
+                    Heap::untyped_free(&heap, live[j]);
+                    live[j] = live[--n];
+                } else
+                    live[n++] = heap.alloc(16 + ((x >> 2) & 1023));
+            }
+            while(n)
+                Heap::untyped_free(&heap, live[--n]);
+            samples[r] = (TSC::time_stamp() - t0) / TRACE;
+        }
+        report("Heap::trace");
+    }
+}
+
+
+// Bitmap: finding every set bit of a sparse map (1 in 64), then every clear bit of a dense one
+void bench_bitmap()
+{
+    Bitmap<BITS> sparse, dense;
+    for(unsigned int i = 0; i < BITS; i++) {
+        if(!(i % 64))
+            sparse.set(i);
+        else
+            dense.set(i);
+    }
+
+    if(selected("Bitmap::find_first_set")) {
+        for(unsigned int r = 0; r < ROUNDS; r++) {
+            unsigned int n = 0;
+            Time_Stamp t0 = TSC::time_stamp();
+            for(int i = sparse.find_first_set(); i >= 0; i = sparse.find_first_set(i + 1))
+                n++;
+            samples[r] = (TSC::time_stamp() - t0) / n;
+        }
+        report("Bitmap::find_first_set", BITS);
+    }
+
+    if(selected("Bitmap::find_first_clear")) {
+        for(unsigned int r = 0; r < ROUNDS; r++) {
+            unsigned int n = 0;
+            Time_Stamp t0 = TSC::time_stamp();
+            for(int i = dense.find_first_clear(); i >= 0; i = dense.find_first_clear(i + 1))
+                n++;
+            samples[r] = (TSC::time_stamp() - t0) / n;
+        }
+        report("Bitmap::find_first_clear", BITS);
+    }
+}
+
+
+// Buffer: locking a frame and passing it through a list, as a NIC driver does with its rings
+void bench_buffer()
+{
+    struct Frame { unsigned char data[1514]; };
+    typedef _UTIL::Buffer<Object, Frame> Buffer;
+    static char storage[BUFFERS * sizeof(Buffer)] __attribute__((aligned(16)));
+    Buffer * buffers = reinterpret_cast<Buffer *>(storage);
+
+    if(!selected("Buffer::lock/list"))
+        return;
+
+    Buffer::List free;
+    for(unsigned int i = 0; i < BUFFERS; i++) {
+        new (&buffers[i]) Buffer(&objects[i], 0);
+        free.insert(buffers[i].link());
+    }
+
+    for(unsigned int r = 0; r < ROUNDS; r++) {
+        Time_Stamp t0 = TSC::time_stamp();
+        for(unsigned int i = 0; i < MAX_N; i++) {
+            Buffer * b = free.remove()->object();
+            if(!b->lock())
+                _panic();
+            b->size(64);
+            b->unlock();
+            free.insert(b->link());
+        }
+        samples[r] = (TSC::time_stamp() - t0) / MAX_N;
+    }
+    report("Buffer::lock/list");
+}
+
+
+// AES-128: ECB and CBC encryption and decryption, CTR and GCM encryption of BLOCKS blocks, per block
+void bench_aes()
+{
+    static unsigned char data[BLOCKS * 16], result[BLOCKS * 16];
+    unsigned char key[16];
+    for(unsigned int i = 0; i < sizeof(data); i++)
+        data[i] = random32();
+    for(unsigned int i = 0; i < sizeof(key); i++)
+        key[i] = random32();
+
+    const char * names[] = { "AES::encrypt (ECB)", "AES::decrypt (ECB)", "AES::encrypt (CBC)", "AES::decrypt (CBC)",
+                             "AES::encrypt (CTR)" };
+    const SWAES<16>::Mode modes[] = { SWAES<16>::ECB, SWAES<16>::ECB, SWAES<16>::CBC, SWAES<16>::CBC, SWAES<16>::CTR };
+    for(unsigned int t = 0; t < 5; t++) {
+        if(!selected(names[t]))
+            continue;
+        SWAES<16> aes(modes[t]);
+        for(unsigned int r = 0; r < ROUNDS; r++) {
+            Time_Stamp t0 = TSC::time_stamp();
+            if(t % 2)
+                aes.decrypt(data, sizeof(data), key, result);
+            else
+                aes.encrypt(data, sizeof(data), key, result);
+            samples[r] = (TSC::time_stamp() - t0) / BLOCKS;
+        }
+        report(names[t], BLOCKS);
+    }
+
+    if(selected("AES_GCM::encrypt")) {
+        unsigned char iv[AES_GCM::IV_SIZE], tag[AES_GCM::TAG_SIZE];
+        for(unsigned int i = 0; i < sizeof(iv); i++)
+            iv[i] = random32();
+        AES_GCM aead(key);
+        for(unsigned int r = 0; r < ROUNDS; r++) {
+            Time_Stamp t0 = TSC::time_stamp();
+            aead.encrypt(result, tag, iv, data, sizeof(data));
+            samples[r] = (TSC::time_stamp() - t0) / BLOCKS;
+        }
+        report("AES_GCM::encrypt", BLOCKS);
+    }
+}
+
+
+// ChaCha20 and ChaCha20-Poly1305: encryption of the same BLOCKS 16-byte blocks, per block, to compare with AES
+void bench_chacha20()
+{
+    static unsigned char data[BLOCKS * 16], result[BLOCKS * 16];
+    unsigned char key[ChaCha20::KEY_SIZE], nonce[ChaCha20::NONCE_SIZE], tag[ChaCha20_Poly1305::TAG_SIZE];
+    for(unsigned int i = 0; i < sizeof(data); i++)
+        data[i] = random32();
+    for(unsigned int i = 0; i < sizeof(key); i++)
+        key[i] = random32();
+    for(unsigned int i = 0; i < sizeof(nonce); i++)
+        nonce[i] = random32();
+
+    if(selected("ChaCha20::crypt")) {
+        ChaCha20 chacha;
+        for(unsigned int r = 0; r < ROUNDS; r++) {
+            chacha.reset(key, nonce);
+            Time_Stamp t0 = TSC::time_stamp();
+            chacha.crypt(result, data, sizeof(data));
+            samples[r] = (TSC::time_stamp() - t0) / BLOCKS;
+        }
+        report("ChaCha20::crypt", BLOCKS);
+    }
+
+    if(selected("ChaCha20_Poly1305::encrypt")) {
+        ChaCha20_Poly1305 aead(key);
+        for(unsigned int r = 0; r < ROUNDS; r++) {
+            Time_Stamp t0 = TSC::time_stamp();
+            aead.encrypt(result, tag, nonce, data, sizeof(data));
+            samples[r] = (TSC::time_stamp() - t0) / BLOCKS;
+        }
+        report("ChaCha20_Poly1305::encrypt", BLOCKS);
+    }
+}
+
+
+// Bignum: modular multiplications and exponentiations of random 128-bit numbers
+void bench_bignum()
+{
+    typedef Bignum<16> Number;
+    unsigned char bytes[2][16];
+    for(unsigned int i = 0; i < sizeof(bytes); i++)
+        bytes[i / 16][i % 16] = random32();
+    bytes[0][15] = bytes[1][15] = 0x7f; // below the modulo
+
+    if(selected("Bignum::operator*=")) {
+        for(unsigned int r = 0; r < ROUNDS; r++) {
+            Number a(bytes[0], 16), b(bytes[1], 16);
+            Time_Stamp t0 = TSC::time_stamp();
+            for(unsigned int i = 0; i < MAX_N; i++)
+                a *= b;
+            samples[r] = (TSC::time_stamp() - t0) / MAX_N;
+        }
+        report("Bignum::operator*=");
+    }
+
+    if(selected("Bignum::pow")) {
+        for(unsigned int r = 0; r < ROUNDS; r++) {
+            Number a(bytes[0], 16), e(bytes[1], 16);
+            Time_Stamp t0 = TSC::time_stamp();
+            a.pow(e);
+            samples[r] = TSC::time_stamp() - t0;
+        }
+        report("Bignum::pow");
+    }
+}
+
+
+int main(int argc, char * argv[])
+{
+    if(argc > 1)
+        prefix = argv[1];
+
+    cout << "EPOS Utility Templates Host Benchmark" << endl;
+    cout << "Times in ns per operation, " << ROUNDS << " rounds per test" << endl;
+
+    bench_list<Ordered_List<Object>>("Ordered_List");
+    bench_list<Skip_List<Object>>("Skip_List");
+    bench_hash();
+    bench_heap();
+    bench_bitmap();
+    bench_buffer();
+    bench_aes();
+    bench_chacha20();
+    bench_bignum();
+
+    return 0;
+}
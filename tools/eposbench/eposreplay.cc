@@ -0,0 +1,239 @@
+/*=======================================================================*/
+/* eposreplay.cc                                                         */
+/*                                                                       */
+/* Desc: Replays the allocations and frees of a Heap_Trace::dump() on a  */
+/*       host Heap and reports the latency of each operation, in ns, as  */
+/*       min/avg/p99, and the fragmentation of the free memory (the part */
+/*       of it outside the largest free block). It is built once for     */
+/*       each Heap configuration (see EPOSBENCH_HEAP in the makefile).   */
+/*       Frees of blocks allocated before the trace starts are skipped.  */
+/*                                                                       */
+/* Parm: <trace file> [<heap size in bytes>]                             */
+/*=======================================================================*/
+
+#include <utility/heap.h>
+
+// Using only bare C from the host, after EPOS, to avoid conflicts (see eposcfg)
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace EPOS;
+
+typedef TSC::Time_Stamp Time_Stamp;
+
+// Constants
+const char * BACKENDS[] = { "first-fit", "tlsf", "magazines" };
+const unsigned long HEAP_SIZE = 16 * 1024 * 1024;
+const unsigned int LINE_SIZE = 256;
+const unsigned int PERIOD = 64;         // events between fragmentation samples
+
+// Types
+struct Event
+{
+    unsigned long heap;
+    unsigned long addr;                 // in the trace
+    unsigned long bytes;                // 0 for a free
+};
+
+struct Slot
+{
+    unsigned long heap;
+    unsigned long addr;                 // 0 for an empty slot
+    void * block;                       // in the replay
+    unsigned long bytes;
+};
+
+// Globals
+OStream cout;
+Event * events;
+unsigned int n_events = 0;
+Slot * slots;
+unsigned int n_slots;
+
+// Bindings
+extern "C" {
+    unsigned long long host_clock(); // clock.c
+    char * strstr(const char * s, const char * t); // libc, not in EPOS' string.h
+
+    void _panic() { fputs("eposreplay: panic!\n", stderr); exit(1); }
+    void _print(const char * s) { fputs(s, stdout); }
+    void _print_preamble() {}
+    void _print_trailler(bool error) { if(error) _panic(); }
+}
+
+__BEGIN_SYS
+OStream kerr;
+bool CPU::_int_enabled = true;
+TSC::Time_Stamp TSC::time_stamp() { return host_clock(); }
+__END_SYS
+
+
+// Blocks allocated and not yet freed, by heap and address in the trace (open addressing, linear probing)
+Slot * slot(unsigned long heap, unsigned long addr)
+{
+    unsigned int i = ((addr >> 4) ^ heap) & (n_slots - 1);
+    for(; slots[i].addr && ((slots[i].addr != addr) || (slots[i].heap != heap)); i = (i + 1) & (n_slots - 1));
+    return &slots[i];
+}
+
+void forget(Slot * s)
+{
+    s->addr = 0;
+
+    // Entries after it that would no longer be found are moved back
+    unsigned int i = s - slots;
+    for(unsigned int j = (i + 1) & (n_slots - 1); slots[j].addr; j = (j + 1) & (n_slots - 1)) {
+        Slot e = slots[j];
+        slots[j].addr = 0;
+        *slot(e.heap, e.addr) = e;
+    }
+}
+
+bool load(const char * file)
+{
+    FILE * f = fopen(file, "r");
+    if(!f) {
+        fprintf(stderr, "eposreplay: can't open %s!\n", file);
+        return false;
+    }
+
+    char line[LINE_SIZE];
+    unsigned int size = 0;
+    while(fgets(line, sizeof(line), f))
+        if(strstr(line, "@heap "))
+            size++;
+    events = reinterpret_cast<Event *>(malloc((size ? size : 1) * sizeof(Event)));
+
+    rewind(f);
+    while(fgets(line, sizeof(line), f) && (n_events < size)) {
+        const char * l = strstr(line, "@heap ");
+        if(!l)
+            continue;
+
+        unsigned long long ts;
+        char op;
+        Event & e = events[n_events];
+        if((sscanf(l, "@heap %llu %lx %c", &ts, &e.heap, &op) != 3)
+           || ((op == '+') && (sscanf(l, "@heap %*u %*x + %lu %lx", &e.bytes, &e.addr) != 2))
+           || ((op == '-') && (sscanf(l, "@heap %*u %*x - %lx", &e.addr) != 1))
+           || ((op != '+') && (op != '-'))) {
+            fprintf(stderr, "eposreplay: skipping malformed line \"%s\"!\n", l);
+            continue;
+        }
+        if(op == '-')
+            e.bytes = 0;
+        n_events++;
+    }
+    fclose(f);
+
+    for(n_slots = 16; n_slots < 2 * n_events; n_slots *= 2);
+    slots = reinterpret_cast<Slot *>(calloc(n_slots, sizeof(Slot)));
+
+    return true;
+}
+
+int compare(const void * a, const void * b)
+{
+    Time_Stamp x = *reinterpret_cast<const Time_Stamp *>(a);
+    Time_Stamp y = *reinterpret_cast<const Time_Stamp *>(b);
+    return (x < y) ? -1 : (x > y);
+}
+
+void report(const char * name, Time_Stamp * samples, unsigned int n)
+{
+    if(!n)
+        return;
+
+    qsort(samples, n, sizeof(Time_Stamp), &compare);
+
+    Time_Stamp sum = 0;
+    for(unsigned int i = 0; i < n; i++)
+        sum += samples[i];
+
+    cout << name << ": min=" << samples[0] << ", avg=" << sum / n << ", p99=" << samples[n * 99 / 100] << endl;
+}
+
+unsigned long fragmentation(Heap * heap)
+{
+    Heap::Statistics s = heap->statistics();
+    return s.free ? 100 - s.largest * 100 / s.free : 0;
+}
+
+
+int main(int argc, char * argv[])
+{
+    if(argc < 2) {
+        fprintf(stderr, "Usage: %s <trace file> [<heap size in bytes>]\n", argv[0]);
+        return 1;
+    }
+
+    unsigned long size = (argc > 2) ? strtoul(argv[2], 0, 0) : HEAP_SIZE;
+    if(!load(argv[1]))
+        return 1;
+
+    void * memory = malloc(size);
+    Heap * heap = new (malloc(sizeof(Heap))) Heap(memory, size);
+
+    Time_Stamp * allocs = reinterpret_cast<Time_Stamp *>(malloc((n_events + 1) * sizeof(Time_Stamp)));
+    Time_Stamp * frees = reinterpret_cast<Time_Stamp *>(malloc((n_events + 1) * sizeof(Time_Stamp)));
+    unsigned int n_allocs = 0, n_frees = 0, unmatched = 0, failures = 0;
+    unsigned long live = 0, peak = 0, used = 0, worst = 0;
+
+    for(unsigned int i = 0; i < n_events; i++) {
+        const Event & e = events[i];
+
+        if(e.bytes) {
+            Time_Stamp t0 = TSC::time_stamp();
+            void * block = heap->try_alloc(e.bytes);
+            allocs[n_allocs++] = TSC::time_stamp() - t0;
+
+            if(!block)
+                failures++;
+            else if(e.addr) {
+                Slot * s = slot(e.heap, e.addr);
+                if(s->addr) { // its free was not traced
+                    Heap::untyped_free(heap, s->block);
+                    live -= s->bytes;
+                }
+                s->heap = e.heap;
+                s->addr = e.addr;
+                s->block = block;
+                s->bytes = e.bytes;
+                live += e.bytes;
+                if(live > peak) {
+                    peak = live;
+                    used = size - heap->statistics().free;
+                }
+            } else
+                Heap::untyped_free(heap, block); // failed on the target, but not here
+        } else {
+            Slot * s = slot(e.heap, e.addr);
+            if(!s->addr) {
+                unmatched++;
+                continue;
+            }
+
+            Time_Stamp t0 = TSC::time_stamp();
+            Heap::untyped_free(heap, s->block);
+            frees[n_frees++] = TSC::time_stamp() - t0;
+
+            live -= s->bytes;
+            forget(s);
+        }
+
+        if(!(i % PERIOD)) {
+            unsigned long f = fragmentation(heap);
+            if(f > worst)
+                worst = f;
+        }
+    }
+
+    cout << "eposreplay (" << BACKENDS[EPOSBENCH_HEAP] << "): " << n_events << " events from " << argv[1]
+         << " on a " << size << "-byte heap, " << unmatched << " unmatched frees, " << failures << " failures" << endl;
+    report("Heap::alloc", allocs, n_allocs);
+    report("Heap::free", frees, n_frees);
+    cout << "Heap fragmentation: max=" << worst << "%, end=" << fragmentation(heap) << "%, peak=" << peak
+         << " bytes live in " << used << " bytes used" << endl;
+
+    return 0;
+}
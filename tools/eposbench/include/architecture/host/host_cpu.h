@@ -0,0 +1,92 @@
+// EPOS Host CPU Mediator Declarations (for tools/eposbench)
+
+#ifndef __host_cpu_h
+#define __host_cpu_h
+
+#include <architecture/cpu.h>
+
+__BEGIN_SYS
+
+// A single CPU, with the atomics from the compiler and interrupts as a flag, so utilities run as they do on one core
+class CPU: protected CPU_Common
+{
+public:
+    using CPU_Common::Reg8;
+    using CPU_Common::Reg16;
+    using CPU_Common::Reg32;
+    using CPU_Common::Reg64;
+    using CPU_Common::Reg;
+    using CPU_Common::Log_Addr;
+    using CPU_Common::Phy_Addr;
+
+    class Context {};
+
+public:
+    CPU() {}
+
+    static Reg sp() { return reinterpret_cast<Reg>(__builtin_frame_address(0)); }
+    static Reg fp() { return reinterpret_cast<Reg>(__builtin_frame_address(0)); }
+    static Reg ra() { return reinterpret_cast<Reg>(__builtin_return_address(0)); }
+
+    static unsigned int id() { return 0; }
+    static unsigned int cores() { return 1; }
+
+    using CPU_Common::clock;
+    using CPU_Common::min_clock;
+    using CPU_Common::max_clock;
+    using CPU_Common::bus_clock;
+
+    static void int_enable() { _int_enabled = true; }
+    static void int_disable() { _int_enabled = false; }
+    static bool int_enabled() { return _int_enabled; }
+    static bool int_disabled() { return !_int_enabled; }
+
+    static void halt() {}
+    static void pause() {}
+    static void fence() { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+
+    template<typename T>
+    static T tsl(volatile T & lock) { return __atomic_exchange_n(&lock, 1, __ATOMIC_SEQ_CST); }
+
+    template<typename T>
+    static T finc(volatile T & value) { return __atomic_fetch_add(&value, 1, __ATOMIC_SEQ_CST); }
+
+    template<typename T>
+    static T fdec(volatile T & value) { return __atomic_fetch_sub(&value, 1, __ATOMIC_SEQ_CST); }
+
+    template <typename T>
+    static T cas(volatile T & value, T compare, T replacement) {
+        __atomic_compare_exchange_n(&value, &compare, replacement, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+        return compare;
+    }
+
+    using CPU_Common::cache_clean;
+    using CPU_Common::cache_invalidate;
+    using CPU_Common::cache_flush;
+
+    using CPU_Common::htole64;
+    using CPU_Common::htole32;
+    using CPU_Common::htole16;
+    using CPU_Common::letoh64;
+    using CPU_Common::letoh32;
+    using CPU_Common::letoh16;
+
+    using CPU_Common::htobe64;
+    using CPU_Common::htobe32;
+    using CPU_Common::htobe16;
+    using CPU_Common::betoh64;
+    using CPU_Common::betoh32;
+    using CPU_Common::betoh16;
+
+    using CPU_Common::htonl;
+    using CPU_Common::htons;
+    using CPU_Common::ntohl;
+    using CPU_Common::ntohs;
+
+private:
+    static bool _int_enabled;
+};
+
+__END_SYS
+
+#endif
@@ -0,0 +1,37 @@
+// EPOS Host Architecture Metainfo (for tools/eposbench)
+
+#ifndef __host_traits_h
+#define __host_traits_h
+
+#include <system/config.h>
+
+__BEGIN_SYS
+
+template<> struct Traits<CPU>: public Traits<Build>
+{
+    enum {LITTLE, BIG};
+    static const unsigned int ENDIANESS         = (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__) ? BIG : LITTLE;
+    static const unsigned int WORD_SIZE         = __SIZEOF_POINTER__ * 8;
+    static const unsigned int CLOCK             = 1000000000;
+    static const bool unaligned_memory_access   = true;
+    static const unsigned int CACHE_LINE_SIZE   = 64;
+};
+
+template<> struct Traits<MMU>: public Traits<Build>
+{
+    static const bool colorful = false;
+    static const unsigned int COLORS = 1;
+};
+
+template<> struct Traits<TSC>: public Traits<Build>
+{
+};
+
+template<> struct Traits<PMU>: public Traits<Build>
+{
+    static const bool enabled = false;
+};
+
+__END_SYS
+
+#endif
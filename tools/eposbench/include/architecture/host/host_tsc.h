@@ -0,0 +1,30 @@
+// EPOS Host Time-Stamp Counter Mediator Declarations (for tools/eposbench)
+
+#ifndef __host_tsc_h
+#define __host_tsc_h
+
+#include <architecture/cpu.h>
+#include <architecture/tsc.h>
+
+__BEGIN_SYS
+
+// Nanoseconds of the host's monotonic clock (see eposbench.cc)
+class TSC: private TSC_Common
+{
+public:
+    using TSC_Common::Time_Stamp;
+
+    static const unsigned int FREQUENCY = 1000000000;
+
+public:
+    TSC() {}
+
+    static Hertz frequency() { return FREQUENCY; }
+    static PPB accuracy() { return 0; }
+
+    static Time_Stamp time_stamp();
+};
+
+__END_SYS
+
+#endif
@@ -0,0 +1,34 @@
+// EPOS Host Machine Metainfo (for tools/eposbench)
+
+#ifndef __host_machine_traits_h
+#define __host_machine_traits_h
+
+#include <system/config.h>
+
+__BEGIN_SYS
+
+class Machine_Common;
+template<> struct Traits<Machine_Common>: public Traits<Build> {};
+
+template<> struct Traits<Machine>: public Traits<Machine_Common>
+{
+    // Default Sizes and Quantities
+    static const unsigned int MAX_THREADS       = 1;
+    static const unsigned int STACK_SIZE        = 64 * 1024;
+    static const unsigned int HEAP_SIZE         = 16 * 1024 * 1024;
+};
+
+template<> struct Traits<Timer>: public Traits<Machine_Common>
+{
+    static const unsigned int CLOCK = 1000000000;
+    static const unsigned int FREQUENCY = 1000; // Hz
+};
+
+template<> struct Traits<Scratchpad>: public Traits<Machine_Common>
+{
+    static const bool enabled = false;
+};
+
+__END_SYS
+
+#endif
@@ -0,0 +1,88 @@
+// EPOS Configuration Engine for Host Benchmarks (tools/eposbench)
+
+#ifndef __config_h
+#define __config_h
+
+//============================================================================
+// ARCHITECTURE, MACHINE, AND APPLICATION SELECTION
+// Utilities are compiled for the host, with the mediators replaced by the ones in tools/eposbench/include
+//============================================================================
+#define SMOD library
+#define ARCH host
+#define MACH host
+#define MMOD host
+#define APPL eposbench
+#define __mode_library__
+#define __arch_host__
+#define __mach_host__
+#define __mmod_host__
+
+//============================================================================
+// NAMESPACES AND DEFINITIONS
+//============================================================================
+namespace EPOS {
+    namespace S {
+        namespace U {}
+        using namespace U;
+    }
+}
+
+#define __BEGIN_API             namespace EPOS {
+#define __END_API               }
+#define _API                    ::EPOS
+
+#define __BEGIN_UTIL            namespace EPOS { namespace S { namespace U {
+#define __END_UTIL              }}}
+#define __USING_UTIL            using namespace S::U;
+#define _UTIL                   ::EPOS::S::U
+
+#define __BEGIN_SYS             namespace EPOS { namespace S {
+#define __END_SYS               }}
+#define __IN_SYS(X)             namespace EPOS { namespace S { X }}
+#define __USING_SYS             using namespace EPOS::S;
+#define _SYS                    ::EPOS::S
+
+#ifndef __kernel__
+namespace EPOS {
+    using namespace S;
+    using namespace S::U;
+}
+#endif
+
+#define __HEADER_ARCH(X)        <architecture/host/host_##X.h>
+#define __HEADER_MACH(X)        <machine/host/host_##X.h>
+#define __HEADER_MMOD(X)        <machine/host/host_##X.h>
+#define __HEADER_TRAN(X)        <transducer/X.h>
+#define __APPL_TRAITS_T(X)      <X##_traits.h>
+#define __APPL_TRAITS(X)        __APPL_TRAITS_T(X)
+
+#define __ARCHITECTURE_TRAITS_H __HEADER_ARCH(traits)
+#define __MACHINE_TRAITS_H      __HEADER_MMOD(traits)
+#define __APPLICATION_TRAITS_H  __APPL_TRAITS(APPL)
+
+#define ASM                     __asm__ __volatile__
+
+//============================================================================
+// ASSERT (for pre and post conditions)
+//============================================================================
+#define assert(expr)    ((expr) ? static_cast<void>(0) : Assert::fail (#expr, __FILE__, __LINE__, __PRETTY_FUNCTION__))
+//#define assert(expr)    (static_cast<void>(0))
+
+//============================================================================
+// CONFIGURATION
+//============================================================================
+#define __CPU_H                 __HEADER_ARCH(cpu)
+#define __TSC_H                 __HEADER_ARCH(tsc)
+
+#include <system/meta.h>
+#include <system/traits.h>
+#include __APPLICATION_TRAITS_H
+#include <system/types.h>
+
+//============================================================================
+// THINGS EVERBODY NEEDS
+//============================================================================
+#include <utility/ostream.h>
+#include <utility/debug.h>
+
+#endif
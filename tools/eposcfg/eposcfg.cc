@@ -56,7 +56,9 @@ char tokens[TOKENS][STRING_SIZE] = {
     "SYS_DATA",
     "SYS_STACK",
     "SYS_HEAP",
-    "EXPECTED_SIMULATION_TIME"
+    "DATA_IMAGE",
+    "EXPECTED_SIMULATION_TIME",
+    "TRACED"
 };
 
 // Values for single-string tokens (populated at populate_strings())
@@ -139,6 +141,7 @@ void populate_strings();
 int set_token_value(const char * token, const char * value);
 const char * get_token_value(const char * token);
 int enable_component(const char * component);
+void trace_component(char * list, const char * component);
 
 
 // Main
@@ -292,6 +295,14 @@ void populate_strings()
         string[0] = '\0';
     set_token_value("SYS_HEAP", string);
 
+#ifdef __cortex_m__
+    if(Memory_Map::DATA_IMAGE != Memory_Map::NOT_USED)
+        snprintf(string, STRING_SIZE, iformat, Memory_Map::DATA_IMAGE);
+    else
+#endif
+        string[0] = '\0';
+    set_token_value("DATA_IMAGE", string);
+
     snprintf(string, STRING_SIZE, "%i", Traits<Build>::EXPECTED_SIMULATION_TIME);
     set_token_value("EXPECTED_SIMULATION_TIME", string);
 
@@ -413,6 +424,30 @@ void populate_strings()
     if(Traits<DHCP>::enabled)           enable_component("DHCP");
     if(Traits<IPC>::enabled)            enable_component("IPC");
     if(Traits<SmartData>::enabled)      enable_component("SmartData");
+
+    // Components compiled with -finstrument-functions (see makedefs and utility/call_tracer.h)
+    string[0] = '\0';
+    if(Traits<Call_Tracer>::enabled) {
+        if(Traits<CPU>::call_traced)            trace_component(string, "cpu");
+        if(Traits<MMU>::call_traced)            trace_component(string, "mmu");
+        if(Traits<Machine>::call_traced)        trace_component(string, "machine");
+        if(Traits<PCI>::call_traced)            trace_component(string, "pci");
+        if(Traits<IC>::call_traced)             trace_component(string, "ic");
+        if(Traits<Timer>::call_traced)          trace_component(string, "timer");
+        if(Traits<UART>::call_traced)           trace_component(string, "uart");
+        if(Traits<Ethernet>::call_traced)       trace_component(string, "nic pcnet32");
+        if(Traits<System>::call_traced)         trace_component(string, "system");
+        if(Traits<Thread>::call_traced)         trace_component(string, "thread");
+        if(Traits<Task>::call_traced)           trace_component(string, "task");
+        if(Traits<Scheduler<Thread>>::call_traced)      trace_component(string, "scheduler");
+        if(Traits<Address_Space>::call_traced)  trace_component(string, "address");
+        if(Traits<Segment>::call_traced)        trace_component(string, "segment");
+        if(Traits<Synchronizer>::call_traced)   trace_component(string, "mutex semaphore condition");
+        if(Traits<Alarm>::call_traced)          trace_component(string, "alarm");
+        if(Traits<Heaps>::call_traced)          trace_component(string, "heap");
+        if(Traits<Network>::call_traced)        trace_component(string, "network");
+    }
+    set_token_value("TRACED", string);
 }
 
 // Sets the value of a token if it exists
@@ -450,6 +485,14 @@ const char * get_token_value(const char * token)
 }
 
 // Sets a component as enabled
+// Appends a component to a space-separated list
+void trace_component(char * list, const char * component)
+{
+    if(list[0])
+        strncat(list, " ", STRING_SIZE - strlen(list) - 1);
+    strncat(list, component, STRING_SIZE - strlen(list) - 1);
+}
+
 int enable_component(const char * component)
 {
     unsigned int i;
@@ -0,0 +1,252 @@
+/*=======================================================================*/
+/* eposlog.cc                                                            */
+/*                                                                       */
+/* Desc: Tool to decode the "@log" lines printed by Log::dump(), looking */
+/*       the format strings up in the ELF images that produced them.     */
+/*       Lines that are not "@log" records are copied as they are.       */
+/*                                                                       */
+/* Parm: <elf image> [<elf image> ...] < <console output>                */
+/*=======================================================================*/
+
+// Using only bare C (and the host's elf.h) to avoid conflicts with EPOS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <elf.h>
+
+// Constants
+const unsigned int IMAGES = 8;
+const unsigned int SEGMENTS = 32;
+const unsigned int ARGS = 4;          // Log::ARGS
+const unsigned int LINE_SIZE = 1024;
+
+// Types
+struct Segment
+{
+    unsigned long long addr;
+    unsigned long long size;
+    const char * data;                // the bytes in the file (sizes beyond p_filesz are .bss)
+};
+
+// Globals
+Segment segments[IMAGES * SEGMENTS];
+unsigned int n_segments = 0;
+unsigned int word_size = 0;           // in bits, from the first image
+
+// Prototypes
+bool load(const char * file);
+template<typename Ehdr, typename Phdr> bool add_segments(const char * image, long size);
+const char * string(unsigned long long addr);
+void decode(unsigned int cpu, unsigned long long ts, unsigned long long format, const unsigned long long * args);
+
+//=============================================================================
+// MAIN
+//=============================================================================
+int main(int argc, char ** argv)
+{
+    if(argc < 2) {
+        fprintf(stderr, "Usage: %s <elf image> [<elf image> ...] < <console output>\n", argv[0]);
+        return 1;
+    }
+
+    for(int i = 1; i < argc; i++)
+        if(!load(argv[i]))
+            return 1;
+
+    char line[LINE_SIZE];
+    while(fgets(line, LINE_SIZE, stdin)) {
+        char * p = strstr(line, "@log ");
+        if(!p) {
+            fputs(line, stdout);
+            continue;
+        }
+
+        // @log <cpu> <ts> <format> <arg0> ... <argN>, the last ones in hexadecimal, "0x" only above 256
+        char * end;
+        p += 5;
+        unsigned int cpu = strtoul(p, &end, 10);
+        bool ok = (end != p);
+        p = end;
+        unsigned long long ts = strtoull(p, &end, 16);
+        ok = ok && (end != p);
+        p = end;
+        unsigned long long format = strtoull(p, &end, 16);
+        ok = ok && (end != p);
+        p = end;
+        unsigned long long args[ARGS];
+        for(unsigned int i = 0; i < ARGS; i++) {
+            args[i] = strtoull(p, &end, 16);
+            ok = ok && (end != p);
+            p = end;
+        }
+
+        if(ok)
+            decode(cpu, ts, format, args);
+        else
+            fputs(line, stdout);
+    }
+
+    return 0;
+}
+
+//=============================================================================
+// FUNCTIONS
+//=============================================================================
+bool load(const char * file)
+{
+    FILE * f = fopen(file, "rb");
+    if(!f) {
+        fprintf(stderr, "Error: can't open %s!\n", file);
+        return false;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    // Never freed, since the segments point into it
+    char * image = static_cast<char *>(malloc(size));
+    if(!image || (fread(image, 1, size, f) != static_cast<size_t>(size))) {
+        fprintf(stderr, "Error: can't read %s!\n", file);
+        fclose(f);
+        return false;
+    }
+    fclose(f);
+
+    if((size < EI_NIDENT) || memcmp(image, ELFMAG, SELFMAG)) {
+        fprintf(stderr, "Error: %s is not an ELF image!\n", file);
+        return false;
+    }
+
+    bool ok;
+    unsigned int bits;
+    if(image[EI_CLASS] == ELFCLASS64) {
+        ok = add_segments<Elf64_Ehdr, Elf64_Phdr>(image, size);
+        bits = 64;
+    } else {
+        ok = add_segments<Elf32_Ehdr, Elf32_Phdr>(image, size);
+        bits = 32;
+    }
+    if(!ok) {
+        fprintf(stderr, "Error: %s is truncated or has too many segments!\n", file);
+        return false;
+    }
+    if(!word_size)
+        word_size = bits;
+
+    return true;
+}
+
+template<typename Ehdr, typename Phdr>
+bool add_segments(const char * image, long size)
+{
+    const Ehdr * ehdr = reinterpret_cast<const Ehdr *>(image);
+    if((sizeof(Ehdr) > static_cast<unsigned long>(size))
+       || (ehdr->e_phoff + static_cast<unsigned long long>(ehdr->e_phnum) * sizeof(Phdr) > static_cast<unsigned long long>(size)))
+        return false;
+
+    const Phdr * phdr = reinterpret_cast<const Phdr *>(image + ehdr->e_phoff);
+    for(unsigned int i = 0; i < ehdr->e_phnum; i++) {
+        if((phdr[i].p_type != PT_LOAD) || !phdr[i].p_filesz)
+            continue;
+        if((n_segments == IMAGES * SEGMENTS) || (phdr[i].p_offset + phdr[i].p_filesz > static_cast<unsigned long long>(size)))
+            return false;
+        segments[n_segments].addr = phdr[i].p_vaddr;
+        segments[n_segments].size = phdr[i].p_filesz;
+        segments[n_segments].data = image + phdr[i].p_offset;
+        n_segments++;
+    }
+
+    return true;
+}
+
+// Returns the string at addr in one of the images, or 0 if there is no NUL-terminated string there
+const char * string(unsigned long long addr)
+{
+    for(unsigned int i = 0; i < n_segments; i++) {
+        const Segment & s = segments[i];
+        if((addr >= s.addr) && (addr < s.addr + s.size)) {
+            const char * str = s.data + (addr - s.addr);
+            if(memchr(str, '\0', s.size - (addr - s.addr)))
+                return str;
+            return 0;
+        }
+    }
+    return 0;
+}
+
+void decode(unsigned int cpu, unsigned long long ts, unsigned long long format, const unsigned long long * args)
+{
+    printf("[%u] %llu ", cpu, ts);
+
+    const char * f = string(format);
+    if(!f) {
+        printf("<unknown format %#llx>\n", format);
+        return;
+    }
+
+    unsigned long long mask = (word_size == 32) ? 0xffffffffULL : ~0ULL;
+    unsigned int arg = 0;
+    for(; *f; f++) {
+        if(*f != '%') {
+            putchar(*f);
+            continue;
+        }
+
+        // Keep flags, width and precision, but drop length modifiers, since every argument is a word
+        char spec[32] = "%";
+        unsigned int n = 1;
+        for(f++; *f && strchr("-+ #0123456789.", *f) && (n < sizeof(spec) - 4); f++)
+            spec[n++] = *f;
+        for(; *f && strchr("hlLqjzt", *f); f++);
+        if(!*f)
+            break;
+
+        char conversion = *f;
+        if(conversion == '%') {
+            putchar('%');
+            continue;
+        }
+
+        unsigned long long v = (arg < ARGS) ? (args[arg++] & mask) : 0;
+        switch(conversion) {
+        case 'd':
+        case 'i': {
+            long long s = (word_size == 32) ? static_cast<long long>(static_cast<int>(v)) : static_cast<long long>(v);
+            strcpy(spec + n, "lld");
+            printf(spec, s);
+        } break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            spec[n++] = 'l';
+            spec[n++] = 'l';
+            spec[n++] = conversion;
+            spec[n] = '\0';
+            printf(spec, v);
+            break;
+        case 'p':
+            printf("0x%0*llx", word_size / 4, v);
+            break;
+        case 'c':
+            spec[n++] = 'c';
+            spec[n] = '\0';
+            printf(spec, static_cast<int>(v & 0xff));
+            break;
+        case 's': {
+            const char * s = string(v);
+            spec[n++] = 's';
+            spec[n] = '\0';
+            if(s)
+                printf(spec, s);
+            else
+                printf("<%#llx>", v);
+        } break;
+        default:
+            printf("%%%c", conversion);
+        }
+    }
+
+    putchar('\n');
+}
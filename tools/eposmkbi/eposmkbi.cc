@@ -16,6 +16,7 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <ctype.h>
+#include <stdint.h>
 
 #include <system/info.h>
 
@@ -53,6 +54,70 @@ struct Configuration
 // System_Info
 typedef _SYS::System_Info System_Info;
 
+// ELF headers with fixed-width fields, since the host's word size might not match the target's (-l)
+struct Elf32_Header
+{
+    unsigned char e_ident[16];
+    uint16_t e_type;
+    uint16_t e_machine;
+    uint32_t e_version;
+    uint32_t e_entry;
+    uint32_t e_phoff;
+    uint32_t e_shoff;
+    uint32_t e_flags;
+    uint16_t e_ehsize;
+    uint16_t e_phentsize;
+    uint16_t e_phnum;
+    uint16_t e_shentsize;
+    uint16_t e_shnum;
+    uint16_t e_shstrndx;
+} __attribute__((packed));
+
+struct Elf32_Segment
+{
+    uint32_t p_type;
+    uint32_t p_offset;
+    uint32_t p_vaddr;
+    uint32_t p_paddr;
+    uint32_t p_filesz;
+    uint32_t p_memsz;
+    uint32_t p_flags;
+    uint32_t p_align;
+} __attribute__((packed));
+
+struct Elf64_Header
+{
+    unsigned char e_ident[16];
+    uint16_t e_type;
+    uint16_t e_machine;
+    uint32_t e_version;
+    uint64_t e_entry;
+    uint64_t e_phoff;
+    uint64_t e_shoff;
+    uint32_t e_flags;
+    uint16_t e_ehsize;
+    uint16_t e_phentsize;
+    uint16_t e_phnum;
+    uint16_t e_shentsize;
+    uint16_t e_shnum;
+    uint16_t e_shstrndx;
+} __attribute__((packed));
+
+struct Elf64_Segment
+{
+    uint32_t p_type;
+    uint32_t p_flags;
+    uint64_t p_offset;
+    uint64_t p_vaddr;
+    uint64_t p_paddr;
+    uint64_t p_filesz;
+    uint64_t p_memsz;
+    uint64_t p_align;
+} __attribute__((packed));
+
+static const uint32_t PT_LOAD = 1;
+static const uint32_t PF_LZ4 = 0x00100000; // as in utility/elf.h
+
 // PROTOTYPES
 bool parse_config(FILE * cfg_file, Configuration * cfg);
 void strtolower (char * dst,const char * src);
@@ -62,6 +127,9 @@ bool file_exist(char *file);
 
 int put_buf(int fd_out, void * buf, int size);
 int put_file(int fd_out, char * file);
+int put_elf(int fd_out, char * file);
+template<typename Header, typename Segment> int compress_elf(char * elf, unsigned int size, char ** image);
+unsigned int lz4(const unsigned char * src, unsigned int size, unsigned char * dst);
 int pad(int fd_out, int size);
 bool lil_endian();
 
@@ -73,6 +141,7 @@ template<typename T> bool add_boot_map(int fd_out, System_Info * si);
 FILE * out;
 FILE * err;
 Configuration CONFIG;
+bool compress = false;
 
 //=============================================================================
 // MAIN
@@ -95,11 +164,14 @@ int main(int argc, char **argv)
         error = true;
 
     int opt;
-    while((opt = getopt(argc, argv, "sx:y:z:")) != -1) {
+    while((opt = getopt(argc, argv, "lsx:y:z:")) != -1) {
         switch(opt) {
         case 'c':
             print_si = true;
             break;
+        case 'l':
+            compress = true;
+            break;
         case 's': {
             FILE * nul = fopen("/dev/null", "w");
             if(!nul) {
@@ -126,7 +198,8 @@ int main(int argc, char **argv)
         error = true;
 
     if(error) {
-        fprintf(err, "Usage: %s [-c] [-s] [-x X] [-y Y] [-z Z] <EPOS root> <boot image> <app1> <app2> ...\n", argv[0]);
+        fprintf(err, "Usage: %s [-c] [-l] [-s] [-x X] [-y Y] [-z Z] <EPOS root> <boot image> <app1> <app2> ...\n", argv[0]);
+        fprintf(err, "       -l compresses the segments of INIT, SYSTEM and the application with LZ4\n");
         return 1;
     }
 
@@ -163,6 +236,10 @@ int main(int argc, char **argv)
         fprintf(out, "  Node id: \t%d\n", CONFIG.node_id);
     if(CONFIG.space_x != -1)
         fprintf(out, "  Node location: \t(%d, %d, %d)\n", CONFIG.space_x, CONFIG.space_y, CONFIG.space_z);
+    if(compress && !CONFIG.endianess) {
+        fprintf(err, "Error: -l is only supported for little-endian machines!\n");
+        return 1;
+    }
     fprintf(out, "  UUID: \t");
     for(unsigned int i = 0; i < 8; i++)
         fprintf(out, "%.2x", CONFIG.uuid[i]);
@@ -219,19 +296,19 @@ int main(int argc, char **argv)
         si.bm.init_offset = image_size - boot_size;
         sprintf(file, "%s/img/init_%s", argv[optind], CONFIG.mmod);
         fprintf(out, "    Adding init \"%s\":", file);
-        image_size += put_file(fd_img, file);
+        image_size += put_elf(fd_img, file);
 
         // Add SYSTEM
         si.bm.system_offset = image_size - boot_size;
         sprintf(file, "%s/img/system_%s", argv[optind], CONFIG.mmod);
         fprintf(out, "    Adding system \"%s\":", file);
-        image_size += put_file(fd_img, file);
+        image_size += put_elf(fd_img, file);
     }
 
     // Add application(s) and data
     si.bm.application_offset = image_size - boot_size;
     fprintf(out, "    Adding application \"%s\":", argv[optind + 2]);
-    image_size += put_file(fd_img, argv[optind + 2]);
+    image_size += put_elf(fd_img, argv[optind + 2]);
     if((argc - optind) == 3) // single APP
         si.bm.extras_offset = -1;
     else { // multiple APPs or data
@@ -688,6 +765,189 @@ int put_file(int fd_out, char * file)
     return stat.st_size;
 }
 
+//=============================================================================
+// PUT_ELF
+//=============================================================================
+// With -l, each loadable segment of the ELF is replaced by its LZ4 block, flagged with PF_LZ4, and the section
+// headers are dropped (SETUP doesn't use them), so ELF::load_segment() decompresses it right into its addresses.
+int put_elf(int fd_out, char * file)
+{
+    if(!compress)
+        return put_file(fd_out, file);
+
+    int fd_in = open(file, O_RDONLY);
+    if(fd_in < 0) {
+        fprintf(out, " failed! (open)\n");
+        return 0;
+    }
+
+    struct stat stat;
+    if(fstat(fd_in, &stat) < 0)  {
+        fprintf(out, " failed! (stat)\n");
+        return 0;
+    }
+
+    char * elf = (char *) malloc(stat.st_size);
+    if(!elf) {
+        fprintf(out, " failed! (malloc)\n");
+        return 0;
+    }
+    if(read(fd_in, elf, stat.st_size) != stat.st_size) {
+        fprintf(out, " failed! (read)\n");
+        free(elf);
+        return 0;
+    }
+    close(fd_in);
+
+    char * image = 0;
+    int size = -1;
+    if((stat.st_size >= (int)sizeof(Elf32_Header)) && !memcmp(elf, "\177ELF", 4)) {
+        if(elf[4] == 1)
+            size = compress_elf<Elf32_Header, Elf32_Segment>(elf, stat.st_size, &image);
+        else if(elf[4] == 2)
+            size = compress_elf<Elf64_Header, Elf64_Segment>(elf, stat.st_size, &image);
+    }
+    free(elf);
+    if(size < 0) {
+        fprintf(out, " failed! (not a valid ELF)\n");
+        return 0;
+    }
+
+    if(write(fd_out, image, size) < 0) {
+        fprintf(out, " failed! (write)\n");
+        free(image);
+        return 0;
+    }
+    free(image);
+
+    fprintf(out, " done (LZ4, %ld => %d bytes).\n", (long)stat.st_size, size);
+
+    return size;
+}
+
+//=============================================================================
+// COMPRESS_ELF
+//=============================================================================
+template<typename Header, typename Segment> int compress_elf(char * elf, unsigned int size, char ** image)
+{
+    Header * h = reinterpret_cast<Header *>(elf);
+    unsigned int headers = h->e_phoff + h->e_phnum * sizeof(Segment);
+    if((h->e_phentsize != sizeof(Segment)) || (headers > size))
+        return -1;
+
+    // LZ4 blocks grow by at most one byte per 255 of incompressible input, plus the token
+    unsigned int max = headers;
+    Segment * seg = reinterpret_cast<Segment *>(elf + h->e_phoff);
+    for(unsigned int i = 0; i < h->e_phnum; i++) {
+        if((seg[i].p_type == PT_LOAD) && (seg[i].p_offset + seg[i].p_filesz > size))
+            return -1;
+        max += seg[i].p_filesz + seg[i].p_filesz / 255 + 16;
+    }
+
+    char * img = (char *) malloc(max);
+    if(!img)
+        return -1;
+    memcpy(img, elf, headers);
+
+    h = reinterpret_cast<Header *>(img);
+    h->e_shoff = 0;
+    h->e_shnum = 0;
+    h->e_shstrndx = 0;
+
+    unsigned int offset = headers;
+    seg = reinterpret_cast<Segment *>(img + h->e_phoff);
+    for(unsigned int i = 0; i < h->e_phnum; i++) {
+        if((seg[i].p_type != PT_LOAD) || !seg[i].p_filesz)
+            continue;
+        unsigned int len = lz4(reinterpret_cast<unsigned char *>(elf + seg[i].p_offset), seg[i].p_filesz, reinterpret_cast<unsigned char *>(img + offset));
+        seg[i].p_offset = offset;
+        seg[i].p_flags |= PF_LZ4;
+        offset += len;
+    }
+
+    *image = img;
+    return offset;
+}
+
+//=============================================================================
+// LZ4
+//=============================================================================
+// Greedy LZ4 block compressor with a single-entry hash table, as the reference implementation's fast mode.
+// The format demands the last 5 bytes to be literals and the last match to start at least 12 bytes before the end.
+unsigned int lz4(const unsigned char * src, unsigned int size, unsigned char * dst)
+{
+    const unsigned int MIN_MATCH = 4;
+    const unsigned int LAST_LITERALS = 5;
+    const unsigned int MATCH_LIMIT = 12;
+    const unsigned int MAX_OFFSET = 65535;
+    const unsigned int HASH_LOG = 16;
+
+    static int table[1 << HASH_LOG];
+    for(unsigned int i = 0; i < (1 << HASH_LOG); i++)
+        table[i] = -1;
+
+    unsigned char * op = dst;
+    unsigned int anchor = 0;
+    for(unsigned int ip = 0; ip + MATCH_LIMIT <= size; ) {
+        uint32_t seq;
+        memcpy(&seq, &src[ip], sizeof(seq));
+        unsigned int hash = (seq * 2654435761U) >> (32 - HASH_LOG);
+        int ref = table[hash];
+        table[hash] = ip;
+
+        if((ref < 0) || (ip - ref > MAX_OFFSET) || memcmp(&src[ref], &src[ip], MIN_MATCH)) {
+            ip++;
+            continue;
+        }
+
+        unsigned int len = MIN_MATCH;
+        while((ip + len < size - LAST_LITERALS) && (src[ref + len] == src[ip + len]))
+            len++;
+
+        unsigned int literals = ip - anchor;
+        unsigned char * token = op++;
+        *token = ((literals < 15) ? literals : 15) << 4;
+        if(literals >= 15) {
+            unsigned int n = literals - 15;
+            for(; n >= 255; n -= 255)
+                *op++ = 255;
+            *op++ = n;
+        }
+        memcpy(op, &src[anchor], literals);
+        op += literals;
+
+        unsigned int offset = ip - ref;
+        *op++ = offset & 0xff;
+        *op++ = offset >> 8;
+
+        unsigned int extra = len - MIN_MATCH;
+        *token |= (extra < 15) ? extra : 15;
+        if(extra >= 15) {
+            unsigned int n = extra - 15;
+            for(; n >= 255; n -= 255)
+                *op++ = 255;
+            *op++ = n;
+        }
+
+        ip += len;
+        anchor = ip;
+    }
+
+    // Last sequence, only literals
+    unsigned int literals = size - anchor;
+    *op++ = ((literals < 15) ? literals : 15) << 4;
+    if(literals >= 15) {
+        unsigned int n = literals - 15;
+        for(; n >= 255; n -= 255)
+            *op++ = 255;
+        *op++ = n;
+    }
+    memcpy(op, &src[anchor], literals);
+    op += literals;
+
+    return op - dst;
+}
+
 //=============================================================================
 // PUT_BUF
 //=============================================================================
@@ -0,0 +1,140 @@
+/*=======================================================================*/
+/* epospcap.cc                                                           */
+/*                                                                       */
+/* Desc: Tool to rebuild the .pcap file of the capture ring printed by   */
+/*       PCAP::dump() from the "@pcap" lines in the console output.      */
+/*       Lines that are not "@pcap" records are copied as they are.      */
+/*                                                                       */
+/* Parm: <pcap file> < <console output>                                  */
+/*=======================================================================*/
+
+// Using only bare C to avoid conflicts with EPOS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Constants
+const unsigned int LINE_SIZE = 8192;  // enough for a SNAPLEN of 4 KB in hexadecimal
+
+// Types (as in utility/pcap.h, written in the host's byte order, which the magic number tells)
+struct Global_Header
+{
+    unsigned int magic_number;
+    unsigned short version_major;
+    unsigned short version_minor;
+    int thiszone;
+    unsigned int sigfigs;
+    unsigned int snaplen;
+    unsigned int network;
+} __attribute__((packed));
+
+struct Packet_Header
+{
+    unsigned int ts_sec;
+    unsigned int ts_usec;
+    unsigned int incl_len;
+    unsigned int orig_len;
+} __attribute__((packed));
+
+// Prototypes
+bool frame(FILE * out, char * p, unsigned int snaplen);
+int nibble(char c);
+
+//=============================================================================
+// MAIN
+//=============================================================================
+int main(int argc, char ** argv)
+{
+    if(argc != 2) {
+        fprintf(stderr, "Usage: %s <pcap file> < <console output>\n", argv[0]);
+        return 1;
+    }
+
+    FILE * out = fopen(argv[1], "wb");
+    if(!out) {
+        fprintf(stderr, "Error: can't create %s!\n", argv[1]);
+        return 1;
+    }
+
+    unsigned int snaplen = 0;
+    unsigned int frames = 0;
+    char line[LINE_SIZE];
+    while(fgets(line, LINE_SIZE, stdin)) {
+        char * p = strstr(line, "@pcap ");
+        if(!p) {
+            fputs(line, stdout);
+            continue;
+        }
+        p += 6;
+
+        if(*p == 'g') {
+            // @pcap g <link type> <snaplen>, only the first one counts
+            char * end;
+            unsigned int link = strtoul(p + 1, &end, 10);
+            unsigned int len = strtoul(end, &end, 10);
+            if(!snaplen && len) {
+                Global_Header g = { 0xa1b2c3d4, 2, 4, 0, 0, len, link };
+                fwrite(&g, sizeof(g), 1, out);
+                snaplen = len;
+            }
+        } else if((*p == 'p') && snaplen) {
+            // @pcap p <sec> <usec> <length> <bytes>
+            if(frame(out, p + 1, snaplen))
+                frames++;
+            else
+                fprintf(stderr, "Warning: malformed record skipped!\n");
+        } else
+            fputs(line, stdout);
+    }
+
+    fclose(out);
+
+    if(!snaplen) {
+        fprintf(stderr, "Error: no capture found in the input!\n");
+        return 1;
+    }
+    fprintf(stderr, "%u frames written to %s\n", frames, argv[1]);
+
+    return 0;
+}
+
+//=============================================================================
+// FUNCTIONS
+//=============================================================================
+bool frame(FILE * out, char * p, unsigned int snaplen)
+{
+    static unsigned char data[LINE_SIZE / 2];
+
+    char * end;
+    Packet_Header h;
+    h.ts_sec = strtoul(p, &end, 10);
+    h.ts_usec = strtoul(end, &end, 10);
+    h.orig_len = strtoul(end, &end, 10);
+    h.incl_len = (h.orig_len < snaplen) ? h.orig_len : snaplen;
+    if(h.incl_len > sizeof(data))
+        return false;
+
+    while(*end == ' ')
+        end++;
+    for(unsigned int i = 0; i < h.incl_len; i++) {
+        int hi = nibble(end[i * 2]);
+        int lo = (hi < 0) ? -1 : nibble(end[i * 2 + 1]);
+        if(lo < 0)
+            return false;
+        data[i] = (hi << 4) | lo;
+    }
+
+    fwrite(&h, sizeof(h), 1, out);
+    fwrite(data, 1, h.incl_len, out);
+
+    return true;
+}
+
+int nibble(char c)
+{
+    if((c >= '0') && (c <= '9'))
+        return c - '0';
+    if((c >= 'a') && (c <= 'f'))
+        return c - 'a' + 10;
+    return -1;
+}